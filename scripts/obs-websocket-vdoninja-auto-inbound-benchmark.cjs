@@ -0,0 +1,369 @@
+// Compares the per-guest cost of auto-inbound browser sources against native
+// receiver sources. Creates one input per guest stream with the same settings
+// VDOAutoSceneManager uses for the selected mode, lets them settle, then
+// samples CPU time and resident memory of the OBS process tree. The tree
+// includes the obs-browser-page helpers, which OBS's own GetStats leaves out.
+//
+// Usage:
+//   node scripts/obs-websocket-vdoninja-auto-inbound-benchmark.cjs <browser|native> <id,id,...> \
+//     [password] [roomId]
+//
+// Run once per mode with the same guests publishing and compare the
+// perGuest figures. OBS_PID selects the OBS process when several are running.
+const childProcess = require("child_process");
+
+function sleep(ms) {
+  return new Promise((resolve) => setTimeout(resolve, ms));
+}
+
+class ObsWebSocketClient {
+  constructor(url) {
+    this.url = url;
+    this.socket = null;
+    this.requestId = 0;
+    this.pending = new Map();
+    this.identified = false;
+    this.requestTimeoutMs = Number(process.env.OBS_WEBSOCKET_REQUEST_TIMEOUT_MS || 15000);
+  }
+
+  async connect() {
+    await new Promise((resolve, reject) => {
+      const socket = new WebSocket(this.url, "obswebsocket.json");
+      this.socket = socket;
+
+      socket.addEventListener("open", () => resolve());
+      socket.addEventListener("error", (error) => reject(error));
+      socket.addEventListener("message", (event) => {
+        const message = JSON.parse(event.data.toString());
+        if (message.op === 0) {
+          socket.send(JSON.stringify({ op: 1, d: { rpcVersion: 1, eventSubscriptions: 0 } }));
+          return;
+        }
+        if (message.op === 2) {
+          this.identified = true;
+          return;
+        }
+        if (message.op !== 7) {
+          return;
+        }
+
+        const requestId = message.d && message.d.requestId;
+        const pending = requestId ? this.pending.get(requestId) : null;
+        if (!pending) {
+          return;
+        }
+        this.pending.delete(requestId);
+        if (message.d.requestStatus && message.d.requestStatus.result) {
+          pending.resolve(message.d.responseData || {});
+          return;
+        }
+        const comment =
+          (message.d.requestStatus && message.d.requestStatus.comment) || "OBS request failed";
+        pending.reject(new Error(`${message.d.requestType}: ${comment}`));
+      });
+    });
+
+    for (let i = 0; i < 50 && !this.identified; i += 1) {
+      await sleep(100);
+    }
+    if (!this.identified) {
+      throw new Error("Timed out waiting for obs-websocket identify handshake");
+    }
+  }
+
+  async request(requestType, requestData = {}) {
+    if (!this.socket || this.socket.readyState !== WebSocket.OPEN) {
+      throw new Error("obs-websocket is not connected");
+    }
+
+    const requestId = `req-${++this.requestId}`;
+    const response = new Promise((resolve, reject) => {
+      const timeout = setTimeout(() => {
+        this.pending.delete(requestId);
+        reject(new Error(`${requestType}: Timed out after ${this.requestTimeoutMs}ms`));
+      }, this.requestTimeoutMs);
+      this.pending.set(requestId, {
+        resolve: (value) => {
+          clearTimeout(timeout);
+          resolve(value);
+        },
+        reject: (error) => {
+          clearTimeout(timeout);
+          reject(error);
+        },
+      });
+    });
+
+    this.socket.send(JSON.stringify({ op: 6, d: { requestType, requestId, requestData } }));
+    return response;
+  }
+
+  async close() {
+    if (!this.socket) {
+      return;
+    }
+    for (const pending of this.pending.values()) {
+      pending.reject(new Error("obs-websocket connection closed"));
+    }
+    this.pending.clear();
+    this.socket.close();
+    this.socket = null;
+  }
+}
+
+function logStep(message) {
+  console.error(`[obs-auto-inbound-benchmark] ${message}`);
+}
+
+// [[dd-]hh:]mm:ss as printed by ps -o time.
+function parsePsCpuTime(value) {
+  let days = 0;
+  let rest = value.trim();
+  const dash = rest.indexOf("-");
+  if (dash >= 0) {
+    days = Number(rest.slice(0, dash));
+    rest = rest.slice(dash + 1);
+  }
+  const parts = rest.split(":").map(Number);
+  let seconds = 0;
+  for (const part of parts) {
+    seconds = seconds * 60 + part;
+  }
+  return days * 86400 + seconds;
+}
+
+// Returns [{ pid, ppid, name, rssBytes, cpuSeconds }] for every process.
+function listProcesses() {
+  if (process.platform === "win32") {
+    const script =
+      "Get-CimInstance Win32_Process | Select-Object ProcessId,ParentProcessId,Name,WorkingSetSize," +
+      "KernelModeTime,UserModeTime | ConvertTo-Json -Compress";
+    const output = childProcess.execFileSync("powershell.exe", ["-NoProfile", "-Command", script], {
+      encoding: "utf8",
+      maxBuffer: 64 * 1024 * 1024,
+    });
+    return JSON.parse(output).map((entry) => ({
+      pid: entry.ProcessId,
+      ppid: entry.ParentProcessId,
+      name: String(entry.Name || ""),
+      rssBytes: Number(entry.WorkingSetSize || 0),
+      // 100 ns units.
+      cpuSeconds: (Number(entry.KernelModeTime || 0) + Number(entry.UserModeTime || 0)) / 1e7,
+    }));
+  }
+
+  const output = childProcess.execFileSync("ps", ["-A", "-o", "pid=,ppid=,rss=,time=,comm="], {
+    encoding: "utf8",
+    maxBuffer: 64 * 1024 * 1024,
+  });
+  return output
+    .split("\n")
+    .map((line) => line.trim().split(/\s+/))
+    .filter((fields) => fields.length >= 5)
+    .map((fields) => ({
+      pid: Number(fields[0]),
+      ppid: Number(fields[1]),
+      rssBytes: Number(fields[2]) * 1024,
+      cpuSeconds: parsePsCpuTime(fields[3]),
+      name: fields.slice(4).join(" "),
+    }));
+}
+
+function findObsPid(processes) {
+  if (process.env.OBS_PID) {
+    return Number(process.env.OBS_PID);
+  }
+  const candidates = processes.filter((entry) =>
+    /^(obs|obs64)(\.exe)?$/i.test(entry.name.split("/").pop())
+  );
+  if (candidates.length !== 1) {
+    throw new Error(`Found ${candidates.length} OBS processes; set OBS_PID to choose one`);
+  }
+  return candidates[0].pid;
+}
+
+function sampleProcessTree(rootPid) {
+  const processes = listProcesses();
+  const children = new Map();
+  for (const entry of processes) {
+    if (!children.has(entry.ppid)) {
+      children.set(entry.ppid, []);
+    }
+    children.get(entry.ppid).push(entry);
+  }
+
+  const root = processes.find((entry) => entry.pid === rootPid);
+  if (!root) {
+    throw new Error(`OBS process ${rootPid} is not running`);
+  }
+  const tree = [];
+  const queue = [root];
+  while (queue.length) {
+    const entry = queue.shift();
+    tree.push(entry);
+    queue.push(...(children.get(entry.pid) || []));
+  }
+
+  return {
+    atMs: Date.now(),
+    processCount: tree.length,
+    rssBytes: tree.reduce((sum, entry) => sum + entry.rssBytes, 0),
+    cpuSeconds: tree.reduce((sum, entry) => sum + entry.cpuSeconds, 0),
+  };
+}
+
+async function measureWindow(rootPid, windowMs) {
+  const start = sampleProcessTree(rootPid);
+  const rssSamples = [start.rssBytes];
+  const deadline = start.atMs + windowMs;
+  let last = start;
+  while (Date.now() < deadline) {
+    await sleep(Math.min(1000, Math.max(0, deadline - Date.now())));
+    last = sampleProcessTree(rootPid);
+    rssSamples.push(last.rssBytes);
+  }
+  const elapsedSeconds = Math.max(0.001, (last.atMs - start.atMs) / 1000);
+  return {
+    processCount: last.processCount,
+    cpuPercent: Number(((100 * (last.cpuSeconds - start.cpuSeconds)) / elapsedSeconds).toFixed(2)),
+    rssMiB: Number((rssSamples.reduce((sum, value) => sum + value, 0) / rssSamples.length / 1048576).toFixed(1)),
+  };
+}
+
+function buildViewerUrl(baseUrl, streamId, password, roomId) {
+  const params = [`view=${encodeURIComponent(streamId)}`];
+  if (roomId) {
+    params.push(`room=${encodeURIComponent(roomId)}`, "solo");
+  }
+  if (password) {
+    params.push(`password=${encodeURIComponent(password)}`);
+  }
+  return `${baseUrl}/?${params.join("&")}`;
+}
+
+// Mirrors the settings VDOAutoSceneManager::onStreamAdded applies per mode.
+function buildInputDefinition(mode, streamId, password, roomId, width, height) {
+  if (mode === "native") {
+    return {
+      inputKind: "vdoninja_source",
+      inputSettings: {
+        use_native_receiver: true,
+        stream_id: streamId,
+        room_id: roomId,
+        password,
+        width,
+        height,
+      },
+    };
+  }
+  return {
+    inputKind: "browser_source",
+    inputSettings: {
+      url: buildViewerUrl(process.env.VDONINJA_BASE_URL || "https://vdo.ninja", streamId, password, roomId),
+      width,
+      height,
+      fps: 30,
+      reroute_audio: true,
+      restart_when_active: false,
+      shutdown: false,
+    },
+  };
+}
+
+async function main() {
+  const mode = (process.env.VDONINJA_SOURCE_MODE || process.argv[2] || "native").trim().toLowerCase();
+  const streamIds = (process.env.VDONINJA_STREAM_IDS || process.argv[3] || "")
+    .split(",")
+    .map((value) => value.trim())
+    .filter(Boolean);
+  const password = process.env.VDONINJA_PASSWORD || process.argv[4] || "";
+  const roomId = process.env.VDONINJA_ROOM_ID || process.argv[5] || "";
+  const websocketUrl = process.env.OBS_WEBSOCKET_URL || "ws://127.0.0.1:4455";
+  const settleMs = Number(process.env.VDONINJA_BENCH_SETTLE_MS || 20000);
+  const sampleMs = Number(process.env.VDONINJA_BENCH_SAMPLE_MS || 30000);
+  const width = Number(process.env.VDONINJA_BENCH_WIDTH || 1280);
+  const height = Number(process.env.VDONINJA_BENCH_HEIGHT || 720);
+
+  if (!["browser", "native"].includes(mode)) {
+    throw new Error("Mode must be browser or native");
+  }
+  if (!streamIds.length) {
+    throw new Error("Pass at least one guest stream ID (comma separated)");
+  }
+
+  const client = new ObsWebSocketClient(websocketUrl);
+  const stamp = Date.now();
+  const sceneName = `Auto Inbound Benchmark ${stamp}`;
+  const inputNames = [];
+  let previousSceneName = null;
+  let createdScene = false;
+  try {
+    logStep(`connecting to ${websocketUrl}`);
+    await client.connect();
+    const rootPid = findObsPid(listProcesses());
+
+    const currentProgram = await client.request("GetCurrentProgramScene").catch(() => ({}));
+    previousSceneName = currentProgram.currentProgramSceneName || null;
+    await client.request("CreateScene", { sceneName });
+    createdScene = true;
+    await client.request("SetCurrentProgramScene", { sceneName });
+
+    logStep(`measuring idle OBS for ${sampleMs}ms`);
+    const idle = await measureWindow(rootPid, sampleMs);
+
+    for (const streamId of streamIds) {
+      const inputName = `Auto Inbound Benchmark ${mode} ${streamId} ${stamp}`;
+      const { inputKind, inputSettings } = buildInputDefinition(mode, streamId, password, roomId, width, height);
+      logStep(`creating ${inputKind} for ${streamId}`);
+      await client.request("CreateInput", { sceneName, inputName, inputKind, inputSettings, sceneItemEnabled: true });
+      inputNames.push(inputName);
+    }
+
+    logStep(`waiting ${settleMs}ms for ${streamIds.length} guests to connect`);
+    await sleep(settleMs);
+    logStep(`measuring loaded OBS for ${sampleMs}ms`);
+    const loaded = await measureWindow(rootPid, sampleMs);
+    const stats = await client.request("GetStats").catch(() => ({}));
+
+    const guests = streamIds.length;
+    const result = {
+      ok: true,
+      mode,
+      guests,
+      width,
+      height,
+      idle,
+      loaded,
+      perGuest: {
+        cpuPercent: Number(((loaded.cpuPercent - idle.cpuPercent) / guests).toFixed(2)),
+        rssMiB: Number(((loaded.rssMiB - idle.rssMiB) / guests).toFixed(1)),
+        processes: Number(((loaded.processCount - idle.processCount) / guests).toFixed(2)),
+      },
+      obsStats: {
+        activeFps: stats.activeFps,
+        averageFrameRenderTime: stats.averageFrameRenderTime,
+        renderSkippedFrames: stats.renderSkippedFrames,
+      },
+    };
+    process.stdout.write(`${JSON.stringify(result, null, 2)}\n`);
+  } finally {
+    try {
+      if (previousSceneName) {
+        await client.request("SetCurrentProgramScene", { sceneName: previousSceneName }).catch(() => undefined);
+      }
+      for (const inputName of inputNames) {
+        await client.request("RemoveInput", { inputName }).catch(() => undefined);
+      }
+      if (createdScene) {
+        await client.request("RemoveScene", { sceneName }).catch(() => undefined);
+      }
+    } finally {
+      await client.close();
+    }
+  }
+}
+
+main().catch((error) => {
+  console.error(error && error.stack ? error.stack : String(error));
+  process.exitCode = 1;
+});
@@ -1232,6 +1232,49 @@ static obs_properties_t *vdoninja_service_properties(void *)
 	       "restored when streaming stops."));
 	obs_properties_add_int(advanced, "adaptive_bitrate_min",
 	                       tr("AdaptiveBitrate.Minimum", "Minimum Adaptive Bitrate (kbps)"), 100, 10000, 100);
+	obs_property_t *adaptiveLoss = obs_properties_add_bool(
+	    advanced, "adaptive_bitrate_loss", tr("AdaptiveBitrate.Loss", "Adaptive Bitrate Backs Off on Loss and RTT"));
+	obs_property_set_long_description(
+	    adaptiveLoss,
+	    tr("AdaptiveBitrate.Loss.Description",
+	       "Also use each viewer's receiver reports: above about 10% packet loss, or while round-trip time keeps "
+	       "rising, that viewer's target drops below its REMB estimate. The lowest viewer target still controls "
+	       "the encoder."));
+	obs_property_t *qualityLadder = obs_properties_add_text(
+	    advanced, "quality_ladder", tr("QualityLadder", "Adaptive Resolution Ladder (Experimental)"), OBS_TEXT_DEFAULT);
+	obs_property_set_long_description(
+	    qualityLadder,
+	    tr("QualityLadder.Description",
+	       "Lower resolution and frame rate as adaptive bitrate falls, for example \"1500:720p30, 700:540p30\" "
+	       "sends 720p at 30 fps below 1500 kbps and 540p below 700 kbps. Each rung is its own encoder that runs "
+	       "for the whole session, even while unused, so every rung adds a full encode at its resolution on top "
+	       "of the configured one. Viewers switch on that encoder's next keyframe. Leave empty, the default, to "
+	       "run one encoder."));
+	obs_property_t *warmConnections = obs_properties_add_int(
+	    advanced, "warm_viewer_connections", tr("WarmViewerConnections", "Pre-warmed Viewer Connections"), 0, 10, 1);
+	obs_property_set_long_description(
+	    warmConnections,
+	    tr("WarmViewerConnections.Description",
+	       "Keep up to this many viewer connections prepared with ICE candidates already gathered, so guests "
+	       "added in a burst start faster. The pool grows with the recent join rate. 0 disables it."));
+	obs_property_t *gopFastStart =
+	    obs_properties_add_bool(advanced, "gop_fast_start", tr("GopFastStart", "Fast Viewer Start"));
+	obs_property_set_long_description(
+	    gopFastStart,
+	    tr("GopFastStart.Description",
+	       "Keep the current group of pictures and replay it to viewers who join mid-GOP, so their video starts "
+	       "moving right away instead of showing a still image until the next keyframe. The replay briefly runs "
+	       "ahead of the bitrate to catch up with the live stream and is skipped when catching up would take "
+	       "too long."));
+	obs_property_t *intraRefresh =
+	    obs_properties_add_bool(advanced, "intra_refresh", tr("IntraRefresh", "Intra Refresh (Experimental, x264)"));
+	obs_property_set_long_description(
+	    intraRefresh,
+	    tr("IntraRefresh.Description",
+	       "Ask x264 to refresh the picture gradually across each keyframe interval instead of sending a large "
+	       "keyframe every interval, which removes the periodic bitrate spike on tight uplinks. New viewers get "
+	       "the cached keyframe and then join at the next refresh, so their picture fills in over up to two "
+	       "seconds. Other encoders keep periodic keyframes."));
 	obs_properties_add_group(props, "advanced", tr("AdvancedSettings", "Advanced Settings"), OBS_GROUP_NORMAL,
 	                         advanced);
 
@@ -1262,6 +1305,11 @@ static void vdoninja_service_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "audio_red", false);
 	obs_data_set_default_bool(settings, "adaptive_bitrate", false);
 	obs_data_set_default_int(settings, "adaptive_bitrate_min", 500);
+	obs_data_set_default_bool(settings, "adaptive_bitrate_loss", false);
+	obs_data_set_default_string(settings, "quality_ladder", "");
+	obs_data_set_default_int(settings, "warm_viewer_connections", 0);
+	obs_data_set_default_bool(settings, "gop_fast_start", true);
+	obs_data_set_default_bool(settings, "intra_refresh", false);
 }
 
 static const char *vdoninja_service_url(void *data)
@@ -1310,7 +1358,8 @@ static const char *vdoninja_service_connect_info(void *data, uint32_t type)
 // whenever "Keyframe Interval" is 0/auto, which viewers see as a periodic freeze.
 constexpr int64_t kMaxStreamKeyintSec = 2;
 
-static void vdoninja_service_apply_encoder_settings(void *, obs_data_t *video_settings, obs_data_t *audio_settings)
+static void vdoninja_service_apply_encoder_settings(void *data, obs_data_t *video_settings,
+                                                    obs_data_t *audio_settings)
 {
 	UNUSED_PARAMETER(audio_settings);
 
@@ -1329,6 +1378,19 @@ static void vdoninja_service_apply_encoder_settings(void *, obs_data_t *video_se
 		if (keyintSec <= 0 || keyintSec > kMaxStreamKeyintSec) {
 			obs_data_set_int(video_settings, "keyint_sec", kMaxStreamKeyintSec);
 		}
+
+		// With intra refresh, x264 spreads each keyframe over the keyframe
+		// interval as a rolling intra column, so the clamped interval above
+		// becomes the refresh period. obs-x264 passes "x264opts" through to
+		// libx264; the other encoders have no such key and ignore it.
+		obs_data_t *serviceSettings = static_cast<obs_data_t *>(data);
+		if (serviceSettings && obs_data_get_bool(serviceSettings, "intra_refresh")) {
+			std::string options = obs_data_get_string(video_settings, "x264opts");
+			if (options.find("intra-refresh") == std::string::npos) {
+				options += options.empty() ? "intra-refresh=1" : " intra-refresh=1";
+				obs_data_set_string(video_settings, "x264opts", options.c_str());
+			}
+		}
 	}
 }
 
@@ -2034,6 +2096,49 @@ static obs_properties_t *vdoninja_control_center_properties(void *data)
 	obs_property_t *adaptiveMinimum =
 	    obs_properties_add_int(advanced, "adaptive_bitrate_min",
 	                           tr("AdaptiveBitrate.Minimum", "Minimum Adaptive Bitrate (kbps)"), 100, 10000, 100);
+	obs_property_t *adaptiveLoss = obs_properties_add_bool(
+	    advanced, "adaptive_bitrate_loss", tr("AdaptiveBitrate.Loss", "Adaptive Bitrate Backs Off on Loss and RTT"));
+	obs_property_set_long_description(
+	    adaptiveLoss,
+	    tr("AdaptiveBitrate.Loss.Description",
+	       "Also use each viewer's receiver reports: above about 10% packet loss, or while round-trip time keeps "
+	       "rising, that viewer's target drops below its REMB estimate. The lowest viewer target still controls "
+	       "the encoder."));
+	obs_property_t *qualityLadder = obs_properties_add_text(
+	    advanced, "quality_ladder", tr("QualityLadder", "Adaptive Resolution Ladder (Experimental)"), OBS_TEXT_DEFAULT);
+	obs_property_set_long_description(
+	    qualityLadder,
+	    tr("QualityLadder.Description",
+	       "Lower resolution and frame rate as adaptive bitrate falls, for example \"1500:720p30, 700:540p30\" "
+	       "sends 720p at 30 fps below 1500 kbps and 540p below 700 kbps. Each rung is its own encoder that runs "
+	       "for the whole session, even while unused, so every rung adds a full encode at its resolution on top "
+	       "of the configured one. Viewers switch on that encoder's next keyframe. Leave empty, the default, to "
+	       "run one encoder."));
+	obs_property_t *warmConnections = obs_properties_add_int(
+	    advanced, "warm_viewer_connections", tr("WarmViewerConnections", "Pre-warmed Viewer Connections"), 0, 10, 1);
+	obs_property_set_long_description(
+	    warmConnections,
+	    tr("WarmViewerConnections.Description",
+	       "Keep up to this many viewer connections prepared with ICE candidates already gathered, so guests "
+	       "added in a burst start faster. The pool grows with the recent join rate. 0 disables it."));
+	obs_property_t *gopFastStart =
+	    obs_properties_add_bool(advanced, "gop_fast_start", tr("GopFastStart", "Fast Viewer Start"));
+	obs_property_set_long_description(
+	    gopFastStart,
+	    tr("GopFastStart.Description",
+	       "Keep the current group of pictures and replay it to viewers who join mid-GOP, so their video starts "
+	       "moving right away instead of showing a still image until the next keyframe. The replay briefly runs "
+	       "ahead of the bitrate to catch up with the live stream and is skipped when catching up would take "
+	       "too long."));
+	obs_property_t *intraRefresh =
+	    obs_properties_add_bool(advanced, "intra_refresh", tr("IntraRefresh", "Intra Refresh (Experimental, x264)"));
+	obs_property_set_long_description(
+	    intraRefresh,
+	    tr("IntraRefresh.Description",
+	       "Ask x264 to refresh the picture gradually across each keyframe interval instead of sending a large "
+	       "keyframe every interval, which removes the periodic bitrate spike on tight uplinks. New viewers get "
+	       "the cached keyframe and then join at the next refresh, so their picture fills in over up to two "
+	       "seconds. Other encoders keep periodic keyframes."));
 	obs_properties_add_group(props, "advanced", tr("AdvancedSettings", "Advanced Settings"), OBS_GROUP_NORMAL,
 	                         advanced);
 
@@ -2048,6 +2153,11 @@ static obs_properties_t *vdoninja_control_center_properties(void *data)
 	obs_property_set_modified_callback2(audioRed, controlCenterFieldModified, ctx);
 	obs_property_set_modified_callback2(adaptiveBitrate, controlCenterFieldModified, ctx);
 	obs_property_set_modified_callback2(adaptiveMinimum, controlCenterFieldModified, ctx);
+	obs_property_set_modified_callback2(adaptiveLoss, controlCenterFieldModified, ctx);
+	obs_property_set_modified_callback2(qualityLadder, controlCenterFieldModified, ctx);
+	obs_property_set_modified_callback2(warmConnections, controlCenterFieldModified, ctx);
+	obs_property_set_modified_callback2(gopFastStart, controlCenterFieldModified, ctx);
+	obs_property_set_modified_callback2(intraRefresh, controlCenterFieldModified, ctx);
 
 	return props;
 }
@@ -2080,6 +2190,11 @@ static void vdoninja_control_center_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "audio_red", false);
 	obs_data_set_default_bool(settings, "adaptive_bitrate", false);
 	obs_data_set_default_int(settings, "adaptive_bitrate_min", 500);
+	obs_data_set_default_bool(settings, "adaptive_bitrate_loss", false);
+	obs_data_set_default_string(settings, "quality_ladder", "");
+	obs_data_set_default_int(settings, "warm_viewer_connections", 0);
+	obs_data_set_default_bool(settings, "gop_fast_start", true);
+	obs_data_set_default_bool(settings, "intra_refresh", false);
 	obs_data_set_default_string(settings, "cc_push_url", "");
 	obs_data_set_default_string(settings, "cc_view_url", "");
 	obs_data_set_default_string(settings, "cc_status", "Press 'Refresh Runtime Stats' to sample live metrics.");
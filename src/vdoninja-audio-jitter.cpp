@@ -0,0 +1,466 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Native receiver audio jitter buffer with Opus loss recovery decisions
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-audio-jitter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr int kDefaultMinDelayMs = 20;
+constexpr int kDefaultMaxDelayMs = 200;
+// Target delay above one frame, in multiples of the smoothed jitter. RFC 3550
+// jitter is a mean deviation; four of them cover nearly all arrivals.
+constexpr double kJitterDelayMultiplier = 4.0;
+// Shrinking the target only frees buffered audio once packets are released,
+// so it falls slowly to avoid pumping around a jitter spike.
+constexpr int kTargetDecreasePerPacketUs = 1000;
+constexpr int kMaxOpusPacketSamples = 5760;
+// Longer gaps are skipped: minutes of concealment or a sender restart should
+// resynchronize rather than synthesize audio.
+constexpr int64_t kMaxConcealUs = 120000;
+constexpr size_t kMaxBufferedPackets = 256;
+constexpr int64_t kDriftAllowancePpm = 500;
+constexpr int64_t kTimestampJumpUs = 10000000;
+
+int opusFrameSamples(uint8_t toc)
+{
+	const int config = toc >> 3;
+	if (config < 12) {
+		static const int kSilk[] = {480, 960, 1920, 2880};
+		return kSilk[config % 4];
+	}
+	if (config < 16) {
+		return (config % 2) == 0 ? 480 : 960;
+	}
+	static const int kCelt[] = {120, 240, 480, 960};
+	return kCelt[(config - 16) % 4];
+}
+
+bool readFrameLength(const uint8_t *data, size_t size, size_t &offset, size_t &length)
+{
+	if (offset >= size) {
+		return false;
+	}
+	const uint8_t first = data[offset++];
+	if (first < 252) {
+		length = first;
+		return true;
+	}
+	if (offset >= size) {
+		return false;
+	}
+	length = static_cast<size_t>(first) + 4U * data[offset++];
+	return true;
+}
+
+} // namespace
+
+OpusPacketInfo inspectOpusPacket(const uint8_t *data, size_t size)
+{
+	OpusPacketInfo info;
+	if (!data || size == 0) {
+		return info;
+	}
+
+	info.toc = data[0];
+	info.stereo = (info.toc & 0x04) != 0;
+	const int frameSamples = opusFrameSamples(info.toc);
+	const int code = info.toc & 0x03;
+
+	int frameCount = 1;
+	size_t firstOffset = 1;
+	size_t firstLength = 0;
+	switch (code) {
+	case 0:
+		firstLength = size - 1;
+		break;
+	case 1:
+		if ((size - 1) % 2 != 0) {
+			return info;
+		}
+		frameCount = 2;
+		firstLength = (size - 1) / 2;
+		break;
+	case 2:
+		frameCount = 2;
+		if (!readFrameLength(data, size, firstOffset, firstLength) || firstOffset + firstLength > size) {
+			return info;
+		}
+		break;
+	default: {
+		if (size < 2) {
+			return info;
+		}
+		const uint8_t countByte = data[1];
+		frameCount = countByte & 0x3F;
+		if (frameCount == 0) {
+			return info;
+		}
+		size_t offset = 2;
+		size_t padding = 0;
+		if ((countByte & 0x40) != 0) {
+			while (true) {
+				if (offset >= size) {
+					return info;
+				}
+				const uint8_t value = data[offset++];
+				padding += value == 255 ? 254 : value;
+				if (value != 255) {
+					break;
+				}
+			}
+		}
+		if ((countByte & 0x80) != 0) {
+			for (int i = 0; i + 1 < frameCount; ++i) {
+				size_t length = 0;
+				if (!readFrameLength(data, size, offset, length)) {
+					return info;
+				}
+				if (i == 0) {
+					firstLength = length;
+				}
+			}
+			if (frameCount == 1) {
+				if (offset + padding > size) {
+					return info;
+				}
+				firstLength = size - offset - padding;
+			}
+		} else {
+			if (offset + padding > size || (size - offset - padding) % frameCount != 0) {
+				return info;
+			}
+			firstLength = (size - offset - padding) / frameCount;
+		}
+		if (offset + padding > size || offset + firstLength > size) {
+			return info;
+		}
+		firstOffset = offset;
+		break;
+	}
+	}
+
+	info.samples = frameCount * frameSamples;
+	if (info.samples > kMaxOpusPacketSamples) {
+		info.samples = 0;
+		return info;
+	}
+	info.valid = true;
+
+	const bool celtOnly = (info.toc & 0x80) != 0;
+	if (!celtOnly && firstLength > 0) {
+		const int silkFrames = frameSamples > 960 ? frameSamples / 960 : 1;
+		const uint8_t flags = data[firstOffset];
+		info.hasLbrr = ((flags >> (7 - silkFrames)) & 0x01) != 0;
+		if (info.stereo) {
+			info.hasLbrr = info.hasLbrr || ((flags >> (6 - 2 * silkFrames)) & 0x01) != 0;
+		}
+	}
+	return info;
+}
+
+std::vector<uint8_t> makeOpusLostFramePacket(uint8_t toc)
+{
+	return {static_cast<uint8_t>(toc & 0xFC)};
+}
+
+AudioJitterBuffer::AudioJitterBuffer(uint32_t clockRate)
+    : clockRate_(clockRate > 0 ? clockRate : 48000),
+      minDelayUs_(kDefaultMinDelayMs * 1000),
+      maxDelayUs_(kDefaultMaxDelayMs * 1000),
+      targetDelayUs_(kDefaultMinDelayMs * 1000)
+{
+}
+
+void AudioJitterBuffer::setDelayBoundsMs(int minDelayMs, int maxDelayMs)
+{
+	minDelayUs_ = std::max(0, minDelayMs) * 1000;
+	maxDelayUs_ = std::max(minDelayUs_, maxDelayMs * 1000);
+	targetDelayUs_ = std::clamp(targetDelayUs_, minDelayUs_, maxDelayUs_);
+}
+
+int64_t AudioJitterBuffer::extendSequence(uint16_t sequence) const
+{
+	return highestExtendedSequence_ + static_cast<int16_t>(static_cast<uint16_t>(sequence - highestSequence_));
+}
+
+int64_t AudioJitterBuffer::extendTimestamp(uint32_t rtpTimestamp) const
+{
+	return lastMediaTicks_ + static_cast<int32_t>(rtpTimestamp - lastRtpTimestamp_);
+}
+
+int64_t AudioJitterBuffer::ticksToUs(int64_t ticks) const
+{
+	return ticks * 1000000 / static_cast<int64_t>(clockRate_);
+}
+
+int64_t AudioJitterBuffer::deadlineUs(int64_t mediaTicks) const
+{
+	return ticksToUs(mediaTicks) + minTransitUs_ + targetDelayUs_;
+}
+
+void AudioJitterBuffer::updateJitter(int64_t mediaTicks, int64_t arrivalUs)
+{
+	const int64_t transitUs = arrivalUs - ticksToUs(mediaTicks);
+	if (hasJitterSample_) {
+		const double deviation = static_cast<double>(std::llabs(transitUs - lastTransitUs_));
+		jitterUs_ += (deviation - jitterUs_) / 16.0;
+	}
+	hasJitterSample_ = true;
+	lastTransitUs_ = transitUs;
+
+	if (!hasTransit_) {
+		hasTransit_ = true;
+		minTransitUs_ = transitUs;
+		minTransitUpdatedUs_ = arrivalUs;
+		return;
+	}
+	minTransitUs_ += (arrivalUs - minTransitUpdatedUs_) * kDriftAllowancePpm / 1000000;
+	minTransitUpdatedUs_ = arrivalUs;
+	minTransitUs_ = std::min(minTransitUs_, transitUs);
+}
+
+void AudioJitterBuffer::updateTargetDelay()
+{
+	const int64_t frameUs = ticksToUs(lastFrameSamples_);
+	const int desired = static_cast<int>(
+	    std::clamp<int64_t>(frameUs + static_cast<int64_t>(kJitterDelayMultiplier * jitterUs_), minDelayUs_,
+	                        maxDelayUs_));
+	if (desired >= targetDelayUs_) {
+		targetDelayUs_ = desired;
+	} else {
+		targetDelayUs_ = std::max(desired, targetDelayUs_ - kTargetDecreasePerPacketUs);
+	}
+}
+
+bool AudioJitterBuffer::push(uint16_t sequence, uint32_t rtpTimestamp, const uint8_t *payload, size_t size,
+                             int64_t arrivalUs)
+{
+	const OpusPacketInfo info = inspectOpusPacket(payload, size);
+	if (!info.valid) {
+		return false;
+	}
+	++stats_.receivedPackets;
+
+	if (hasReference_) {
+		const int64_t jumpUs = ticksToUs(std::llabs(extendTimestamp(rtpTimestamp) - lastMediaTicks_));
+		const int64_t sequenceJump = std::llabs(extendSequence(sequence) - highestExtendedSequence_);
+		if (jumpUs > kTimestampJumpUs || sequenceJump > 0x4000) {
+			++stats_.resyncs;
+			reset();
+		}
+	}
+
+	const bool firstPacket = !hasReference_;
+	if (firstPacket) {
+		hasReference_ = true;
+		highestSequence_ = sequence;
+		highestExtendedSequence_ = sequence;
+		lastRtpTimestamp_ = rtpTimestamp;
+		lastMediaTicks_ = rtpTimestamp;
+	}
+	const int64_t extendedSequence = extendSequence(sequence);
+	const int64_t mediaTicks = extendTimestamp(rtpTimestamp);
+
+	if (started_ && extendedSequence < nextSequence_) {
+		++stats_.latePackets;
+		return false;
+	}
+	if (packets_.count(extendedSequence) != 0) {
+		++stats_.duplicatePackets;
+		return false;
+	}
+
+	if (firstPacket || extendedSequence > highestExtendedSequence_) {
+		highestSequence_ = sequence;
+		highestExtendedSequence_ = extendedSequence;
+		lastRtpTimestamp_ = rtpTimestamp;
+		lastMediaTicks_ = mediaTicks;
+		updateJitter(mediaTicks, arrivalUs);
+	} else if (extendedSequence < highestExtendedSequence_) {
+		++stats_.reorderedPackets;
+	}
+
+	lastFrameSamples_ = std::max(1, info.samples);
+	updateTargetDelay();
+
+	Packet packet;
+	packet.mediaTicks = mediaTicks;
+	packet.rtpTimestamp = rtpTimestamp;
+	packet.arrivalUs = arrivalUs;
+	packet.info = info;
+	packet.payload.assign(payload, payload + size);
+	packets_.emplace(extendedSequence, std::move(packet));
+
+	while (packets_.size() > kMaxBufferedPackets) {
+		auto oldest = packets_.begin();
+		nextSequence_ = oldest->first + 1;
+		nextMediaTicks_ = oldest->second.mediaTicks + oldest->second.info.samples;
+		started_ = true;
+		packets_.erase(oldest);
+		++stats_.overflowDrops;
+	}
+	return true;
+}
+
+bool AudioJitterBuffer::pushRedundant(uint16_t sequence, uint32_t rtpTimestamp, const uint8_t *payload, size_t size,
+                                      int64_t arrivalUs)
+{
+	if (!hasReference_) {
+		return false;
+	}
+	const OpusPacketInfo info = inspectOpusPacket(payload, size);
+	if (!info.valid) {
+		return false;
+	}
+	// Redundant copies of frames already played or already buffered are the
+	// common case, so they are not counted as late or duplicate.
+	const int64_t extendedSequence = extendSequence(sequence);
+	if (extendedSequence >= highestExtendedSequence_ || (started_ && extendedSequence < nextSequence_) ||
+	    packets_.count(extendedSequence) != 0) {
+		return false;
+	}
+	const int64_t mediaTicks = extendTimestamp(rtpTimestamp);
+	if (mediaTicks >= lastMediaTicks_ || (started_ && mediaTicks < nextMediaTicks_)) {
+		return false;
+	}
+
+	Packet packet;
+	packet.mediaTicks = mediaTicks;
+	packet.rtpTimestamp = rtpTimestamp;
+	packet.arrivalUs = arrivalUs;
+	packet.info = info;
+	packet.redundant = true;
+	packet.payload.assign(payload, payload + size);
+	packets_.emplace(extendedSequence, std::move(packet));
+	return true;
+}
+
+void AudioJitterBuffer::emitDecode(const Packet &packet, int64_t nowUs, std::vector<AudioPlayoutItem> &out)
+{
+	AudioPlayoutItem item;
+	item.action = AudioPlayoutAction::Decode;
+	item.rtpTimestamp = packet.rtpTimestamp;
+	item.samples = packet.info.samples;
+	item.toc = packet.info.toc;
+	item.payload = packet.payload;
+	out.push_back(std::move(item));
+
+	const int64_t waitedMs = std::max<int64_t>(0, nowUs - packet.arrivalUs) / 1000;
+	++stats_.decodedPackets;
+	if (packet.redundant) {
+		++stats_.redRecoveredPackets;
+	}
+	playoutDelaySumMs_ += static_cast<double>(waitedMs);
+	stats_.maxPlayoutDelayMs = std::max(stats_.maxPlayoutDelayMs, waitedMs);
+}
+
+void AudioJitterBuffer::pull(int64_t nowUs, std::vector<AudioPlayoutItem> &out)
+{
+	while (!packets_.empty()) {
+		auto head = packets_.begin();
+		if (!started_) {
+			nextSequence_ = head->first;
+			nextMediaTicks_ = head->second.mediaTicks;
+		}
+
+		if (head->first == nextSequence_) {
+			if (nowUs < deadlineUs(head->second.mediaTicks)) {
+				return;
+			}
+			started_ = true;
+			emitDecode(head->second, nowUs, out);
+			nextSequence_ = head->first + 1;
+			nextMediaTicks_ = head->second.mediaTicks + head->second.info.samples;
+			packets_.erase(head);
+			continue;
+		}
+
+		// nextSequence_ is missing. Wait until its own deadline before giving up
+		// on it; the packet after the gap proves the gap is real.
+		if (nowUs < deadlineUs(nextMediaTicks_)) {
+			return;
+		}
+		const Packet &after = head->second;
+		const int64_t missingPackets = head->first - nextSequence_;
+		const int64_t missingTicks = after.mediaTicks - nextMediaTicks_;
+		if (missingTicks <= 0 || ticksToUs(missingTicks) > kMaxConcealUs) {
+			++stats_.resyncs;
+			nextSequence_ = head->first;
+			nextMediaTicks_ = after.mediaTicks;
+			continue;
+		}
+
+		const int samples = static_cast<int>(missingTicks / missingPackets);
+		AudioPlayoutItem item;
+		item.rtpTimestamp = static_cast<uint32_t>(nextMediaTicks_);
+		item.toc = after.info.toc;
+		if (missingPackets == 1 && after.info.hasLbrr) {
+			item.action = AudioPlayoutAction::DecodeFec;
+			item.samples = static_cast<int>(missingTicks);
+			item.payload = after.payload;
+			++stats_.fecRecoveredPackets;
+		} else {
+			item.action = AudioPlayoutAction::Conceal;
+			item.samples = samples;
+			++stats_.concealedPackets;
+			stats_.concealedSamples += static_cast<uint64_t>(samples);
+		}
+		nextMediaTicks_ += item.samples;
+		++nextSequence_;
+		started_ = true;
+		out.push_back(std::move(item));
+	}
+}
+
+int AudioJitterBuffer::targetDelayMs() const
+{
+	return targetDelayUs_ / 1000;
+}
+
+AudioJitterStats AudioJitterBuffer::getStats(bool resetInterval)
+{
+	AudioJitterStats stats = stats_;
+	stats.jitterMs = jitterUs_ / 1000.0;
+	stats.targetDelayMs = targetDelayMs();
+	stats.meanPlayoutDelayMs =
+	    stats.decodedPackets > 0 ? playoutDelaySumMs_ / static_cast<double>(stats.decodedPackets) : 0.0;
+	if (resetInterval) {
+		stats_ = {};
+		playoutDelaySumMs_ = 0.0;
+	}
+	return stats;
+}
+
+void AudioJitterBuffer::reset()
+{
+	packets_.clear();
+	hasReference_ = false;
+	highestSequence_ = 0;
+	highestExtendedSequence_ = 0;
+	lastRtpTimestamp_ = 0;
+	lastMediaTicks_ = 0;
+	started_ = false;
+	nextSequence_ = 0;
+	nextMediaTicks_ = 0;
+	lastFrameSamples_ = 960;
+	hasTransit_ = false;
+	minTransitUs_ = 0;
+	minTransitUpdatedUs_ = 0;
+	hasJitterSample_ = false;
+	lastTransitUs_ = 0;
+	jitterUs_ = 0.0;
+	targetDelayUs_ = minDelayUs_;
+}
+
+} // namespace vdoninja
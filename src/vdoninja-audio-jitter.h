@@ -0,0 +1,154 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Native receiver audio jitter buffer with Opus loss recovery decisions
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace vdoninja
+{
+
+struct OpusPacketInfo {
+	bool valid = false;
+	uint8_t toc = 0;
+	bool stereo = false;
+	// Duration at 48 kHz across every frame in the packet.
+	int samples = 0;
+	// The first SILK frame carries low bitrate redundancy for the previous
+	// packet, so a lost predecessor can be rebuilt from this one.
+	bool hasLbrr = false;
+};
+
+// Parses the TOC byte and frame count (RFC 6716 section 3.1/3.2) and reads the
+// SILK LBRR flag the same way libopus' opus_packet_has_lbrr() does. CELT-only
+// packets never carry LBRR.
+OpusPacketInfo inspectOpusPacket(const uint8_t *data, size_t size);
+
+// A one-byte code 0 packet with the given configuration. Its zero-length frame
+// tells the decoder the frame was lost (RFC 6716 section 3.2.1), so the
+// decoder runs packet loss concealment for one frame of that configuration.
+std::vector<uint8_t> makeOpusLostFramePacket(uint8_t toc);
+
+enum class AudioPlayoutAction {
+	Decode,
+	// Rebuild the missing frame from the LBRR data in payload, which is the
+	// packet that follows the gap.
+	DecodeFec,
+	// Nothing usable arrived; run PLC for samples.
+	Conceal,
+};
+
+struct AudioPlayoutItem {
+	AudioPlayoutAction action = AudioPlayoutAction::Decode;
+	uint32_t rtpTimestamp = 0;
+	int samples = 0;
+	// For Conceal, the TOC of the packet after the gap so concealment keeps the
+	// stream's mode and channel count.
+	uint8_t toc = 0;
+	std::vector<uint8_t> payload;
+};
+
+struct AudioJitterStats {
+	uint64_t receivedPackets = 0;
+	uint64_t decodedPackets = 0;
+	uint64_t fecRecoveredPackets = 0;
+	// Missing packets filled from an RFC 2198 redundant block instead.
+	uint64_t redRecoveredPackets = 0;
+	uint64_t concealedPackets = 0;
+	uint64_t concealedSamples = 0;
+	uint64_t latePackets = 0;
+	uint64_t duplicatePackets = 0;
+	uint64_t reorderedPackets = 0;
+	uint64_t overflowDrops = 0;
+	uint64_t resyncs = 0;
+	double jitterMs = 0.0;
+	int targetDelayMs = 0;
+	// Time decoded packets spent waiting in the buffer.
+	double meanPlayoutDelayMs = 0.0;
+	int64_t maxPlayoutDelayMs = 0;
+};
+
+// Reorders Opus RTP packets by sequence number and releases each one when its
+// playout deadline passes: media time mapped onto the local clock through the
+// smallest transit time seen, plus a target delay that follows RFC 3550
+// interarrival jitter. When the next packet is still missing at its deadline
+// and a later packet has arrived, the gap is filled with FEC from that later
+// packet (for the frame right before it) or with concealment. Gaps larger
+// than the concealment limit are skipped instead. Not thread-safe; the caller
+// serializes access with its decode lock.
+class AudioJitterBuffer
+{
+public:
+	explicit AudioJitterBuffer(uint32_t clockRate = 48000);
+
+	void setDelayBoundsMs(int minDelayMs, int maxDelayMs);
+
+	// Returns false for packets that are late, duplicated or unparsable.
+	bool push(uint16_t sequence, uint32_t rtpTimestamp, const uint8_t *payload, size_t size, int64_t arrivalUs);
+	// Offers an older frame carried as RED redundancy alongside a packet that
+	// was just pushed. It only fills a slot that is still missing and not yet
+	// due, and does not feed the jitter estimate. Returns true if it was kept.
+	bool pushRedundant(uint16_t sequence, uint32_t rtpTimestamp, const uint8_t *payload, size_t size,
+	                   int64_t arrivalUs);
+	// Appends everything due at nowUs to out, in playout order.
+	void pull(int64_t nowUs, std::vector<AudioPlayoutItem> &out);
+
+	int targetDelayMs() const;
+	size_t bufferedPackets() const { return packets_.size(); }
+	AudioJitterStats getStats(bool resetInterval = false);
+	// Drops buffered packets and timing state; counters are kept.
+	void reset();
+
+private:
+	struct Packet {
+		int64_t mediaTicks = 0;
+		uint32_t rtpTimestamp = 0;
+		int64_t arrivalUs = 0;
+		OpusPacketInfo info;
+		bool redundant = false;
+		std::vector<uint8_t> payload;
+	};
+
+	int64_t extendSequence(uint16_t sequence) const;
+	int64_t extendTimestamp(uint32_t rtpTimestamp) const;
+	int64_t ticksToUs(int64_t ticks) const;
+	int64_t deadlineUs(int64_t mediaTicks) const;
+	void updateJitter(int64_t mediaTicks, int64_t arrivalUs);
+	void updateTargetDelay();
+	void emitDecode(const Packet &packet, int64_t nowUs, std::vector<AudioPlayoutItem> &out);
+
+	uint32_t clockRate_;
+	int minDelayUs_;
+	int maxDelayUs_;
+	int targetDelayUs_;
+
+	std::map<int64_t, Packet> packets_;
+	bool hasReference_ = false;
+	uint16_t highestSequence_ = 0;
+	int64_t highestExtendedSequence_ = 0;
+	uint32_t lastRtpTimestamp_ = 0;
+	int64_t lastMediaTicks_ = 0;
+
+	bool started_ = false;
+	int64_t nextSequence_ = 0;
+	int64_t nextMediaTicks_ = 0;
+	int lastFrameSamples_ = 960;
+
+	bool hasTransit_ = false;
+	int64_t minTransitUs_ = 0;
+	int64_t minTransitUpdatedUs_ = 0;
+	bool hasJitterSample_ = false;
+	int64_t lastTransitUs_ = 0;
+	double jitterUs_ = 0.0;
+
+	double playoutDelaySumMs_ = 0.0;
+	AudioJitterStats stats_;
+};
+
+} // namespace vdoninja
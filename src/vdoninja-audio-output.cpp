@@ -0,0 +1,67 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Decoded audio hand-off to OBS: pass-through policy and reusable conversion planes
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-audio-output.h"
+
+#include <algorithm>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr size_t kPlaneAlignment = 64;
+// 120 ms at 48 kHz, the longest Opus packet, so the first frame rarely grows
+// the buffer a second time.
+constexpr int kMinimumCapacitySamples = 5760;
+constexpr int kMaximumCapacitySamples = 1 << 20;
+
+size_t alignUp(size_t value)
+{
+	return (value + kPlaneAlignment - 1) & ~(kPlaneAlignment - 1);
+}
+
+} // namespace
+
+bool decodedAudioPassesThrough(DecodedAudioFormat format, int channels)
+{
+	if (channels < 1 || channels > 2) {
+		return false;
+	}
+	return format != DecodedAudioFormat::Other;
+}
+
+bool AudioPlaneBuffer::reserve(int channels, int samples, int bytesPerSample)
+{
+	if (channels <= 0 || channels > kMaxPlanes || samples <= 0 || samples > kMaximumCapacitySamples ||
+	    bytesPerSample <= 0 || bytesPerSample > 8) {
+		return false;
+	}
+	if (channels == channels_ && bytesPerSample == bytesPerSample_ && samples <= capacitySamples_) {
+		return true;
+	}
+
+	const int capacity = std::max({samples, capacitySamples_, kMinimumCapacitySamples});
+	const size_t stride = alignUp(static_cast<size_t>(capacity) * static_cast<size_t>(bytesPerSample));
+	const size_t needed = stride * static_cast<size_t>(channels) + kPlaneAlignment;
+	if (storage_.size() < needed) {
+		storage_.assign(needed, 0);
+		++allocations_;
+	}
+
+	const uintptr_t base = reinterpret_cast<uintptr_t>(storage_.data());
+	uint8_t *aligned = storage_.data() + (alignUp(base) - base);
+	for (int i = 0; i < kMaxPlanes; ++i) {
+		planes_[i] = i < channels ? aligned + stride * static_cast<size_t>(i) : nullptr;
+	}
+	channels_ = channels;
+	bytesPerSample_ = bytesPerSample;
+	capacitySamples_ = static_cast<int>(stride / static_cast<size_t>(bytesPerSample));
+	return true;
+}
+
+} // namespace vdoninja
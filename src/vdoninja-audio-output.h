@@ -0,0 +1,55 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Decoded audio hand-off to OBS: pass-through policy and reusable conversion planes
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vdoninja
+{
+
+// Sample layouts a decoder can produce that OBS also accepts as is.
+enum class DecodedAudioFormat {
+	Other,
+	Float,
+	FloatPlanar,
+	Int16,
+	Int16Planar,
+};
+
+// Whether decoded samples can go straight to obs_source_output_audio(). OBS
+// converts mono or stereo float and 16-bit input itself, so only other sample
+// formats or more than two channels (which we fold to stereo) need swresample.
+bool decodedAudioPassesThrough(DecodedAudioFormat format, int channels);
+
+// Planar scratch for the conversion path. It grows to the largest frame seen
+// and is then reused, so steady-state conversion does not allocate. Planes
+// start on 64-byte boundaries for the swresample SIMD paths.
+class AudioPlaneBuffer
+{
+public:
+	static constexpr int kMaxPlanes = 8;
+
+	// Makes room for channels planes of samples values of bytesPerSample each.
+	// Returns false for out-of-range requests.
+	bool reserve(int channels, int samples, int bytesPerSample);
+	uint8_t **planes() { return planes_; }
+	int capacitySamples() const { return capacitySamples_; }
+	// How many times storage had to grow; stays flat once warmed up.
+	uint64_t allocations() const { return allocations_; }
+
+private:
+	std::vector<uint8_t> storage_;
+	uint8_t *planes_[kMaxPlanes] = {};
+	int channels_ = 0;
+	int bytesPerSample_ = 0;
+	int capacitySamples_ = 0;
+	uint64_t allocations_ = 0;
+};
+
+} // namespace vdoninja
@@ -66,6 +66,63 @@ bool validRedFormatParameters(const std::string &formatParameters, uint8_t opusP
 
 } // namespace
 
+int findOfferedAudioRedPayloadType(const SdpOfferedMediaSection &section, int opusPayloadType)
+{
+	if (opusPayloadType < 0 || opusPayloadType > 127) {
+		return -1;
+	}
+	for (const auto &codec : section.codecs) {
+		const SdpOfferedCodec *red = findCodec(section, codec.payloadType, "red");
+		if (red && red->clockRate == 48000 &&
+		    validRedFormatParameters(red->formatParameters, static_cast<uint8_t>(opusPayloadType))) {
+			return red->payloadType;
+		}
+	}
+	return -1;
+}
+
+bool parseAudioRedPayload(const uint8_t *payload, size_t payloadSize, std::vector<AudioRedBlock> &blocks)
+{
+	blocks.clear();
+	if (!payload || payloadSize == 0) {
+		return false;
+	}
+
+	size_t index = 0;
+	while ((payload[index] & 0x80U) != 0) {
+		if (index + 4 > payloadSize) {
+			return false;
+		}
+		AudioRedBlock block;
+		block.payloadType = payload[index] & 0x7FU;
+		block.timestampOffset = (static_cast<uint32_t>(payload[index + 1]) << 6U) |
+		                        (static_cast<uint32_t>(payload[index + 2]) >> 2U);
+		block.size = (static_cast<size_t>(payload[index + 2] & 0x03U) << 8U) | payload[index + 3];
+		blocks.push_back(block);
+		index += 4;
+		if (index >= payloadSize) {
+			return false;
+		}
+	}
+
+	AudioRedBlock primary;
+	primary.payloadType = payload[index] & 0x7FU;
+	++index;
+
+	for (auto &block : blocks) {
+		if (block.size > payloadSize - index) {
+			blocks.clear();
+			return false;
+		}
+		block.data = payload + index;
+		index += block.size;
+	}
+	primary.data = payload + index;
+	primary.size = payloadSize - index;
+	blocks.push_back(primary);
+	return true;
+}
+
 AudioRedPayload buildAudioRedPayload(const uint8_t *currentPayload, size_t currentPayloadSize,
                                      uint32_t currentTimestamp, const uint8_t *previousPayload,
                                      size_t previousPayloadSize, uint32_t previousTimestamp, uint8_t opusPayloadType,
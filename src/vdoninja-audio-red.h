@@ -39,6 +39,25 @@ AudioRedPayload buildAudioRedPayload(const uint8_t *currentPayload, size_t curre
 bool answerSelectsAudioRed(const std::string &sdp, uint8_t redPayloadType = kDefaultAudioRedPayloadType,
                            uint8_t opusPayloadType = kDefaultOpusPayloadType);
 
+struct SdpOfferedMediaSection;
+
+// Returns the RED payload type an offered audio section maps onto the given
+// Opus payload type (every fmtp entry must be that Opus type), or -1.
+int findOfferedAudioRedPayloadType(const SdpOfferedMediaSection &section, int opusPayloadType);
+
+struct AudioRedBlock {
+	uint8_t payloadType = 0;
+	// Primary timestamp minus this block's timestamp; 0 for the primary block.
+	uint32_t timestampOffset = 0;
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+};
+
+// Splits an RFC 2198 payload into its blocks in payload order: redundant
+// blocks oldest first, primary block last. Blocks point into payload. Returns
+// false for truncated headers or lengths that overrun the payload.
+bool parseAudioRedPayload(const uint8_t *payload, size_t payloadSize, std::vector<AudioRedBlock> &blocks);
+
 struct AudioRedStats {
 	uint64_t packets = 0;
 	uint64_t packetsWithRedundancy = 0;
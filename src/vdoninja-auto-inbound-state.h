@@ -10,6 +10,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace vdoninja
@@ -96,6 +97,82 @@ private:
 	std::map<std::string, int64_t> deadlinesByStream_;
 };
 
+// Source changes collected on signaling threads and applied together in one
+// OBS UI task. Changes are keyed by source name and only the latest one per
+// source is kept: creating and removing a source are both "make it so"
+// operations on the UI side, so a guest that joins and leaves inside one
+// window only needs its final state applied. The window starts at the first
+// pending change and does not slide, so steady churn still flushes on time.
+template <typename Change> class AutoInboundUiBatch
+{
+public:
+	struct Flush {
+		std::vector<Change> changes;
+		bool layoutDirty = false;
+	};
+
+	explicit AutoInboundUiBatch(int64_t windowMs = 100) : windowMs_(windowMs > 0 ? windowMs : 0) {}
+
+	void put(const std::string &key, Change change, int64_t nowMs)
+	{
+		const auto it = orderByKey_.find(key);
+		if (it != orderByKey_.end()) {
+			changesByOrder_.erase(it->second);
+		}
+		const uint64_t order = nextOrder_++;
+		orderByKey_[key] = order;
+		changesByOrder_.emplace(order, std::move(change));
+		touch(nowMs);
+	}
+
+	void markLayoutDirty(int64_t nowMs)
+	{
+		layoutDirty_ = true;
+		touch(nowMs);
+	}
+
+	bool empty() const { return changesByOrder_.empty() && !layoutDirty_; }
+
+	// When the pending changes are due on the UI thread, or 0 if none are.
+	int64_t flushDeadlineMs() const { return empty() ? 0 : firstPendingMs_ + windowMs_; }
+
+	// Hands over everything pending, oldest change first, and starts a new window.
+	Flush take()
+	{
+		Flush flush;
+		flush.changes.reserve(changesByOrder_.size());
+		for (auto &entry : changesByOrder_) {
+			flush.changes.push_back(std::move(entry.second));
+		}
+		flush.layoutDirty = layoutDirty_;
+		clear();
+		return flush;
+	}
+
+	void clear()
+	{
+		changesByOrder_.clear();
+		orderByKey_.clear();
+		layoutDirty_ = false;
+		firstPendingMs_ = 0;
+	}
+
+private:
+	void touch(int64_t nowMs)
+	{
+		if (firstPendingMs_ == 0) {
+			firstPendingMs_ = nowMs > 0 ? nowMs : 1;
+		}
+	}
+
+	int64_t windowMs_;
+	int64_t firstPendingMs_ = 0;
+	bool layoutDirty_ = false;
+	uint64_t nextOrder_ = 0;
+	std::map<uint64_t, Change> changesByOrder_;
+	std::map<std::string, uint64_t> orderByKey_;
+};
+
 class AutoInboundSceneAssignmentState
 {
 public:
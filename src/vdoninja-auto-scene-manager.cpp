@@ -9,9 +9,11 @@
 
 #include <cctype>
 #include <chrono>
+#include <cstring>
 
 #include "vdoninja-auto-inbound-state.h"
 #include "vdoninja-layout.h"
+#include "vdoninja-thread-cpu.h"
 #include "vdoninja-utils.h"
 
 namespace vdoninja
@@ -42,7 +44,9 @@ obs_source_t *acquireTargetSceneSource(const std::string &targetScene)
 }
 
 // Runs on the UI thread with value-captured state only; the manager itself may
-// already be destroyed by the time this executes.
+// already be destroyed by the time this executes. Only items whose grid cell
+// actually changed are touched, so a guest joining a partly filled grid does
+// not re-transform everyone else.
 void applyGridLayoutOnUi(const std::string &targetScene, const std::vector<std::string> &sourceNames, int fallbackWidth,
                          int fallbackHeight)
 {
@@ -63,6 +67,7 @@ void applyGridLayoutOnUi(const std::string &targetScene, const std::vector<std::
 	const uint32_t canvasHeight = gotVideoInfo ? ovi.base_height : static_cast<uint32_t>(fallbackHeight);
 
 	std::vector<obs_sceneitem_t *> items;
+	items.reserve(sourceNames.size());
 	for (const auto &sourceName : sourceNames) {
 		obs_sceneitem_t *item = obs_scene_find_source(scene, sourceName.c_str());
 		if (item) {
@@ -78,26 +83,154 @@ void applyGridLayoutOnUi(const std::string &targetScene, const std::vector<std::
 			continue;
 		}
 
-		uint32_t sourceWidth = obs_source_get_width(itemSource);
-		uint32_t sourceHeight = obs_source_get_height(itemSource);
-		if (sourceWidth == 0) {
-			sourceWidth = static_cast<uint32_t>(layout[i].width);
+		const LayoutPlacement target =
+		    placementForRect(layout[i], obs_source_get_width(itemSource), obs_source_get_height(itemSource));
+		struct vec2 currentPos = {};
+		struct vec2 currentScale = {};
+		obs_sceneitem_get_pos(item, &currentPos);
+		obs_sceneitem_get_scale(item, &currentScale);
+		const LayoutPlacement current{currentPos.x, currentPos.y, currentScale.x, currentScale.y};
+		if (layoutPlacementChanged(current, target)) {
+			struct vec2 pos = {target.x, target.y};
+			struct vec2 scale = {target.scaleX, target.scaleY};
+			obs_sceneitem_set_pos(item, &pos);
+			obs_sceneitem_set_scale(item, &scale);
 		}
-		if (sourceHeight == 0) {
-			sourceHeight = static_cast<uint32_t>(layout[i].height);
+		if (!obs_sceneitem_visible(item)) {
+			obs_sceneitem_set_visible(item, true);
 		}
-
-		struct vec2 pos = {layout[i].x, layout[i].y};
-		struct vec2 scale = {layout[i].width / static_cast<float>(sourceWidth),
-		                     layout[i].height / static_cast<float>(sourceHeight)};
-		obs_sceneitem_set_pos(item, &pos);
-		obs_sceneitem_set_scale(item, &scale);
-		obs_sceneitem_set_visible(item, true);
 	}
 
 	obs_source_release(sceneSource);
 }
 
+void applySourceAddOnUi(const AutoInboundSourceChange &change, AutoInboundSceneAssignmentState &sceneAssignments)
+{
+	obs_source_t *sceneSource = acquireTargetSceneSource(change.targetScene);
+	obs_scene_t *scene = sceneSource ? obs_scene_from_source(sceneSource) : nullptr;
+
+	const bool nativeSource = !change.nativeStreamId.empty();
+	const char *sourceId = nativeSource ? "vdoninja_source" : "browser_source";
+	obs_data_t *settings = obs_data_create();
+	obs_data_set_int(settings, "width", change.width);
+	obs_data_set_int(settings, "height", change.height);
+	if (nativeSource) {
+		obs_data_set_bool(settings, "use_native_receiver", true);
+		obs_data_set_string(settings, "stream_id", change.nativeStreamId.c_str());
+		obs_data_set_string(settings, "room_id", change.roomId.c_str());
+		obs_data_set_string(settings, "password", change.password.c_str());
+		obs_data_set_string(settings, "salt", change.salt.c_str());
+		obs_data_set_string(settings, "wss_host", change.wssHost.c_str());
+		// Every guest in the room gets a receiver; share one room connection
+		// between them instead of one WebSocket each.
+		obs_data_set_bool(settings, "shared_room_signaling", true);
+	} else {
+		obs_data_set_string(settings, "url", change.sourceUrl.c_str());
+		obs_data_set_int(settings, "fps", 30);
+		obs_data_set_bool(settings, "reroute_audio", true);
+		obs_data_set_bool(settings, "restart_when_active", false);
+		obs_data_set_bool(settings, "shutdown", false);
+	}
+
+	obs_source_t *source = obs_get_source_by_name(change.sourceName.c_str());
+	if (source && std::strcmp(obs_source_get_id(source), sourceId) != 0) {
+		// The source type setting changed since this guest was last added;
+		// replace the old source rather than feeding it foreign settings.
+		obs_source_remove(source);
+		obs_source_release(source);
+		source = nullptr;
+	}
+	if (source) {
+		obs_source_update(source, settings);
+	} else {
+		source = obs_source_create(sourceId, change.sourceName.c_str(), settings, nullptr);
+	}
+
+	if (source && scene) {
+		obs_sceneitem_t *item = obs_scene_find_source(scene, change.sourceName.c_str());
+		if (!item) {
+			item = obs_scene_add(scene, source);
+		}
+		if (item) {
+			obs_sceneitem_set_visible(item, true);
+			const char *sceneUuid = obs_source_get_uuid(sceneSource);
+			if (sceneUuid && *sceneUuid) {
+				sceneAssignments.remember(change.sourceName, sceneUuid);
+			}
+		}
+	}
+
+	if (source) {
+		obs_source_release(source);
+	}
+	obs_data_release(settings);
+	if (sceneSource) {
+		obs_source_release(sceneSource);
+	}
+}
+
+void applySourceRemovalOnUi(const AutoInboundSourceChange &change, AutoInboundSceneAssignmentState &sceneAssignments)
+{
+	obs_source_t *source = obs_get_source_by_name(change.sourceName.c_str());
+	const std::string assignedSceneUuid = sceneAssignments.take(change.sourceName);
+	obs_source_t *sceneSource = assignedSceneUuid.empty() ? acquireTargetSceneSource(change.targetScene)
+	                                                      : obs_get_source_by_uuid(assignedSceneUuid.c_str());
+	obs_scene_t *scene = sceneSource ? obs_scene_from_source(sceneSource) : nullptr;
+
+	if (source && change.removeSource) {
+		obs_source_remove(source);
+	} else if (scene) {
+		obs_sceneitem_t *item = obs_scene_find_source(scene, change.sourceName.c_str());
+		if (item) {
+			obs_sceneitem_set_visible(item, false);
+		}
+	}
+
+	if (source) {
+		obs_source_release(source);
+	}
+	if (sceneSource) {
+		obs_source_release(sceneSource);
+	}
+}
+
+struct UiBatchLayout {
+	bool apply = false;
+	std::string targetScene;
+	std::vector<std::string> sourceNames;
+	int fallbackWidth = 1920;
+	int fallbackHeight = 1080;
+};
+
+void applyUiBatchOnUi(const std::vector<AutoInboundSourceChange> &changes, const UiBatchLayout &layout,
+                      AutoInboundSceneAssignmentState &sceneAssignments)
+{
+	const AutoInboundSourceChange *switchTo = nullptr;
+	for (const auto &change : changes) {
+		if (change.remove) {
+			applySourceRemovalOnUi(change, sceneAssignments);
+		} else {
+			applySourceAddOnUi(change, sceneAssignments);
+			if (change.switchScene) {
+				switchTo = &change;
+			}
+		}
+	}
+
+	if (layout.apply) {
+		applyGridLayoutOnUi(layout.targetScene, layout.sourceNames, layout.fallbackWidth, layout.fallbackHeight);
+	}
+
+	// One scene switch per batch, after everything is in place.
+	if (switchTo) {
+		obs_source_t *sceneSource = acquireTargetSceneSource(switchTo->targetScene);
+		if (sceneSource) {
+			obs_frontend_set_current_scene(sceneSource);
+			obs_source_release(sceneSource);
+		}
+	}
+}
+
 } // namespace
 
 VDOAutoSceneManager::~VDOAutoSceneManager()
@@ -132,48 +265,36 @@ void VDOAutoSceneManager::start()
 	running_ = true;
 	managedStreamIds_.clear();
 	pendingListingRemovals_.clear();
-	removalThread_ = std::thread(&VDOAutoSceneManager::removalWorkerLoop, this);
+	uiBatch_.clear();
+	workerThread_ = std::thread(&VDOAutoSceneManager::workerLoop, this);
 }
 
 void VDOAutoSceneManager::stop()
 {
-	std::set<std::string> managedStreamsSnapshot;
-	bool removeOnDisconnect = false;
-	std::thread removalThread;
+	std::thread workerThread;
 	{
 		std::lock_guard<std::mutex> lock(stateMutex_);
-		if (!running_ && !removalThread_.joinable()) {
+		if (!running_ && !workerThread_.joinable()) {
 			return;
 		}
 
 		running_ = false;
-		removeOnDisconnect = settings_.removeOnDisconnect;
-		managedStreamsSnapshot = managedStreamIds_;
+		if (settings_.removeOnDisconnect) {
+			const int64_t now = currentTimeMs();
+			const std::set<std::string> managedStreamsSnapshot = managedStreamIds_;
+			for (const auto &streamId : managedStreamsSnapshot) {
+				queueStreamRemovalLocked(streamId, now);
+			}
+		}
 		managedStreamIds_.clear();
 		pendingListingRemovals_.clear();
-		removalThread = std::move(removalThread_);
-	}
-	removalCv_.notify_all();
-	if (removalThread.joinable()) {
-		removalThread.join();
-	}
-
-	if (!removeOnDisconnect) {
-		return;
+		// Whatever is still pending goes out now; there is nothing left to lay out.
+		flushUiBatchLocked(false);
+		workerThread = std::move(workerThread_);
 	}
-
-	const auto sceneAssignments = sceneAssignments_;
-	for (const auto &streamId : managedStreamsSnapshot) {
-		const std::string sourceName = sourceNameForStream(streamId);
-		runOnUiThread([sourceName, sceneAssignments]() {
-			sceneAssignments->take(sourceName);
-			obs_source_t *source = obs_get_source_by_name(sourceName.c_str());
-			if (!source) {
-				return;
-			}
-			obs_source_remove(source);
-			obs_source_release(source);
-		});
+	workerCv_.notify_all();
+	if (workerThread.joinable()) {
+		workerThread.join();
 	}
 }
 
@@ -201,7 +322,7 @@ void VDOAutoSceneManager::onRoomListing(const std::vector<std::string> &streamId
 	}
 
 	if (graceStateChanged) {
-		removalCv_.notify_all();
+		workerCv_.notify_all();
 	}
 	for (const auto &streamId : delta.added) {
 		onStreamAdded(streamId);
@@ -213,26 +334,28 @@ void VDOAutoSceneManager::onStreamAdded(const std::string &streamId)
 	if (streamId.empty()) {
 		return;
 	}
+	AutoInboundSourceType sourceType = AutoInboundSourceType::Browser;
 	{
 		std::lock_guard<std::mutex> lock(stateMutex_);
 		if (!running_ || ownStreamIds_.find(streamId) != ownStreamIds_.end()) {
 			return;
 		}
 		pendingListingRemovals_.cancel(streamId);
+		sourceType = settings_.sourceType;
 	}
-	removalCv_.notify_all();
-
-	const std::string sourceUrl = buildSourceUrl(streamId);
-	if (sourceUrl.empty()) {
+	workerCv_.notify_all();
+
+	// Playback URLs (WHEP and viewer pages) stay on the browser source even in
+	// native mode; the native receiver only speaks VDO.Ninja signaling.
+	AutoInboundSourceChange change;
+	change.nativeStreamId =
+	    sourceType == AutoInboundSourceType::Native ? nativeInboundStreamId(streamId) : std::string();
+	change.sourceUrl = change.nativeStreamId.empty() ? buildSourceUrl(streamId) : std::string();
+	if (change.nativeStreamId.empty() && change.sourceUrl.empty()) {
 		logWarning("Ignoring auto-inbound target without a usable VDO.Ninja viewer URL: %s", streamId.c_str());
 		return;
 	}
 
-	bool switchScene = false;
-	int sourceWidth = 1920;
-	int sourceHeight = 1080;
-	AutoLayoutMode layoutMode = AutoLayoutMode::Grid;
-	std::string targetScene;
 	{
 		std::lock_guard<std::mutex> lock(stateMutex_);
 		if (!running_) {
@@ -245,194 +368,125 @@ void VDOAutoSceneManager::onStreamAdded(const std::string &streamId)
 		if (!managedStreamIds_.insert(streamId).second) {
 			return;
 		}
-		switchScene = settings_.switchToSceneOnNewStream;
-		sourceWidth = settings_.width;
-		sourceHeight = settings_.height;
-		layoutMode = settings_.layoutMode;
-		targetScene = settings_.targetScene;
-	}
+		change.sourceName = makeSourceName(settings_.sourcePrefix, streamId);
+		change.targetScene = settings_.targetScene;
+		change.roomId = settings_.roomId;
+		change.password = settings_.password;
+		change.salt = settings_.salt;
+		change.wssHost = settings_.wssHost;
+		change.width = settings_.width;
+		change.height = settings_.height;
+		change.switchScene = settings_.switchToSceneOnNewStream;
 
-	const std::string sourceName = sourceNameForStream(streamId);
-	const auto sceneAssignments = sceneAssignments_;
-
-	runOnUiThread([sourceName, sourceUrl, switchScene, sourceWidth, sourceHeight, targetScene, sceneAssignments]() {
-		obs_source_t *sceneSource = acquireTargetSceneSource(targetScene);
-		obs_scene_t *scene = sceneSource ? obs_scene_from_source(sceneSource) : nullptr;
-
-		obs_data_t *settings = obs_data_create();
-		obs_data_set_string(settings, "url", sourceUrl.c_str());
-		obs_data_set_int(settings, "width", sourceWidth);
-		obs_data_set_int(settings, "height", sourceHeight);
-		obs_data_set_int(settings, "fps", 30);
-		obs_data_set_bool(settings, "reroute_audio", true);
-		obs_data_set_bool(settings, "restart_when_active", false);
-		obs_data_set_bool(settings, "shutdown", false);
-
-		obs_source_t *source = obs_get_source_by_name(sourceName.c_str());
-		if (source) {
-			obs_source_update(source, settings);
-		} else {
-			source = obs_source_create("browser_source", sourceName.c_str(), settings, nullptr);
-		}
-
-		if (source && scene) {
-			obs_sceneitem_t *item = obs_scene_find_source(scene, sourceName.c_str());
-			if (!item) {
-				item = obs_scene_add(scene, source);
-			}
-			if (item) {
-				obs_sceneitem_set_visible(item, true);
-				const char *sceneUuid = obs_source_get_uuid(sceneSource);
-				if (sceneUuid && *sceneUuid) {
-					sceneAssignments->remember(sourceName, sceneUuid);
-				}
-			}
-		}
-
-		if (switchScene && sceneSource) {
-			obs_frontend_set_current_scene(sceneSource);
-		}
-
-		if (source) {
-			obs_source_release(source);
-		}
-		obs_data_release(settings);
-		if (sceneSource) {
-			obs_source_release(sceneSource);
+		const int64_t now = currentTimeMs();
+		const std::string key = change.sourceName;
+		uiBatch_.put(key, std::move(change), now);
+		if (settings_.layoutMode == AutoLayoutMode::Grid) {
+			uiBatch_.markLayoutDirty(now);
 		}
-	});
-
-	if (layoutMode == AutoLayoutMode::Grid) {
-		queueLayoutRefresh();
 	}
+	workerCv_.notify_all();
 }
 
 void VDOAutoSceneManager::onStreamRemoved(const std::string &streamId)
 {
-	bool refreshLayout = false;
 	{
 		std::lock_guard<std::mutex> lock(stateMutex_);
 		if (streamId.empty()) {
 			return;
 		}
 		pendingListingRemovals_.cancel(streamId);
-		refreshLayout = queueStreamRemovalLocked(streamId);
-	}
-	removalCv_.notify_all();
-
-	if (refreshLayout) {
-		queueLayoutRefresh();
+		queueStreamRemovalLocked(streamId, currentTimeMs());
 	}
+	workerCv_.notify_all();
 }
 
-void VDOAutoSceneManager::removalWorkerLoop()
+void VDOAutoSceneManager::workerLoop()
 {
+	setCurrentThreadName("vdo-autoscene");
 	for (;;) {
 		std::unique_lock<std::mutex> lock(stateMutex_);
 		if (!running_) {
 			return;
 		}
 
-		const int64_t nextDeadline = pendingListingRemovals_.nextDeadlineMs();
-		if (nextDeadline == 0) {
-			removalCv_.wait(lock);
-			continue;
+		const int64_t now = currentTimeMs();
+		for (const auto &streamId : pendingListingRemovals_.takeDue(now)) {
+			if (managedStreamIds_.find(streamId) != managedStreamIds_.end()) {
+				queueStreamRemovalLocked(streamId, now);
+			}
 		}
 
-		const int64_t now = currentTimeMs();
-		if (nextDeadline > now) {
-			removalCv_.wait_for(lock, std::chrono::milliseconds(nextDeadline - now));
+		const int64_t flushDeadline = uiBatch_.flushDeadlineMs();
+		if (flushDeadline != 0 && flushDeadline <= now) {
+			flushUiBatchLocked(true);
 			continue;
 		}
 
-		bool refreshLayout = false;
-		const auto dueStreamIds = pendingListingRemovals_.takeDue(now);
-		for (const auto &streamId : dueStreamIds) {
-			if (managedStreamIds_.find(streamId) != managedStreamIds_.end()) {
-				refreshLayout = queueStreamRemovalLocked(streamId) || refreshLayout;
-			}
+		int64_t nextDeadline = pendingListingRemovals_.nextDeadlineMs();
+		if (flushDeadline != 0 && (nextDeadline == 0 || flushDeadline < nextDeadline)) {
+			nextDeadline = flushDeadline;
 		}
-
-		lock.unlock();
-		if (refreshLayout) {
-			queueLayoutRefresh();
+		if (nextDeadline == 0) {
+			workerCv_.wait(lock);
+		} else {
+			workerCv_.wait_for(lock, std::chrono::milliseconds(nextDeadline - now));
 		}
 	}
 }
 
-bool VDOAutoSceneManager::queueStreamRemovalLocked(const std::string &streamId)
+void VDOAutoSceneManager::queueStreamRemovalLocked(const std::string &streamId, int64_t nowMs)
 {
 	managedStreamIds_.erase(streamId);
-	const bool removeSource = settings_.removeOnDisconnect;
-	const std::string targetScene = settings_.targetScene;
-	const std::string sourceName = makeSourceName(settings_.sourcePrefix, streamId);
-	const bool refreshLayout = settings_.layoutMode == AutoLayoutMode::Grid;
-	const auto sceneAssignments = sceneAssignments_;
-
-	// Queue while holding stateMutex_ so a concurrent re-add is ordered after
-	// this removal on the OBS UI queue.
-	runOnUiThread([sourceName, removeSource, targetScene, sceneAssignments]() {
-		obs_source_t *source = obs_get_source_by_name(sourceName.c_str());
-		const std::string assignedSceneUuid = sceneAssignments->take(sourceName);
-		obs_source_t *sceneSource = assignedSceneUuid.empty() ? acquireTargetSceneSource(targetScene)
-		                                                      : obs_get_source_by_uuid(assignedSceneUuid.c_str());
-		obs_scene_t *scene = sceneSource ? obs_scene_from_source(sceneSource) : nullptr;
-
-		if (source && removeSource) {
-			obs_source_remove(source);
-		} else if (scene) {
-			obs_sceneitem_t *item = obs_scene_find_source(scene, sourceName.c_str());
-			if (item) {
-				obs_sceneitem_set_visible(item, false);
-			}
-		}
-
-		if (source) {
-			obs_source_release(source);
-		}
-		if (sceneSource) {
-			obs_source_release(sceneSource);
-		}
-	});
 
-	return refreshLayout;
+	AutoInboundSourceChange change;
+	change.remove = true;
+	change.sourceName = makeSourceName(settings_.sourcePrefix, streamId);
+	change.targetScene = settings_.targetScene;
+	change.removeSource = settings_.removeOnDisconnect;
+
+	// Keyed by source name under stateMutex_, so a concurrent re-add replaces
+	// this removal in the batch instead of racing it on the UI queue.
+	const std::string key = change.sourceName;
+	uiBatch_.put(key, std::move(change), nowMs);
+	if (settings_.layoutMode == AutoLayoutMode::Grid) {
+		uiBatch_.markLayoutDirty(nowMs);
+	}
 }
 
-void VDOAutoSceneManager::queueLayoutRefresh() const
+void VDOAutoSceneManager::flushUiBatchLocked(bool includeLayout)
 {
-	std::vector<std::string> sourceNames;
-	int fallbackWidth = 1920;
-	int fallbackHeight = 1080;
-	std::string targetScene;
-	std::string prefix;
-	std::set<std::string> managedStreamIds;
-	{
-		std::lock_guard<std::mutex> lock(stateMutex_);
-		fallbackWidth = settings_.width;
-		fallbackHeight = settings_.height;
-		targetScene = settings_.targetScene;
-		prefix = settings_.sourcePrefix;
-		managedStreamIds = managedStreamIds_;
+	if (uiBatch_.empty()) {
+		return;
 	}
 
-	sourceNames.reserve(managedStreamIds.size());
-	for (const auto &streamId : managedStreamIds) {
-		sourceNames.push_back(makeSourceName(prefix, streamId));
+	auto flush = uiBatch_.take();
+	UiBatchLayout layout;
+	layout.apply = includeLayout && flush.layoutDirty;
+	if (layout.apply) {
+		layout.targetScene = settings_.targetScene;
+		layout.fallbackWidth = settings_.width;
+		layout.fallbackHeight = settings_.height;
+		layout.sourceNames.reserve(managedStreamIds_.size());
+		for (const auto &streamId : managedStreamIds_) {
+			layout.sourceNames.push_back(makeSourceName(settings_.sourcePrefix, streamId));
+		}
 	}
 
-	runOnUiThread([targetScene, sourceNames, fallbackWidth, fallbackHeight]() {
-		applyGridLayoutOnUi(targetScene, sourceNames, fallbackWidth, fallbackHeight);
+	const auto sceneAssignments = sceneAssignments_;
+	runOnUiThread([changes = std::move(flush.changes), layout = std::move(layout), sceneAssignments]() {
+		applyUiBatchOnUi(changes, layout, *sceneAssignments);
 	});
 }
 
-void VDOAutoSceneManager::runOnUiThread(const std::function<void()> &fn) const
+void VDOAutoSceneManager::runOnUiThread(std::function<void()> fn) const
 {
 	// Fire-and-forget. These calls originate from signaling/RTC callback
 	// threads; waiting for the UI thread here deadlocks against output stop()
 	// and teardown, which run on the UI thread while waiting for those same
 	// callbacks to return. All queued lambdas capture state by value so they
 	// stay valid even if this manager is destroyed first.
-	auto *heapFn = new std::function<void()>(fn);
+	auto *heapFn = new std::function<void()>(std::move(fn));
 	obs_queue_task(OBS_TASK_UI, runUiTaskThunk, heapFn, false);
 }
 
@@ -450,16 +504,6 @@ std::string VDOAutoSceneManager::makeSourceName(std::string prefix, const std::s
 	return prefix + "_Cam_" + sanitizeNameToken(streamId);
 }
 
-std::string VDOAutoSceneManager::sourceNameForStream(const std::string &streamId) const
-{
-	std::string prefix;
-	{
-		std::lock_guard<std::mutex> lock(stateMutex_);
-		prefix = settings_.sourcePrefix;
-	}
-	return makeSourceName(prefix, streamId);
-}
-
 std::string VDOAutoSceneManager::buildSourceUrl(const std::string &streamId) const
 {
 	std::string baseUrl;
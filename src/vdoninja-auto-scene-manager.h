@@ -22,6 +22,26 @@
 namespace vdoninja
 {
 
+// One source creation/update or removal waiting for the next UI flush. Holds
+// values only; it is applied after the manager may already be gone.
+struct AutoInboundSourceChange {
+	bool remove = false;
+	std::string sourceName;
+	std::string targetScene;
+	// Removal: delete the source instead of just hiding it.
+	bool removeSource = false;
+	// Creation: browser view URL, or the stream ID for a native receiver.
+	std::string sourceUrl;
+	std::string nativeStreamId;
+	std::string roomId;
+	std::string password;
+	std::string salt;
+	std::string wssHost;
+	int width = 1920;
+	int height = 1080;
+	bool switchScene = false;
+};
+
 class VDOAutoSceneManager
 {
 public:
@@ -38,13 +58,12 @@ public:
 	void onStreamRemoved(const std::string &streamId);
 
 private:
-	void runOnUiThread(const std::function<void()> &fn) const;
+	void runOnUiThread(std::function<void()> fn) const;
 	bool isOwnStream(const std::string &streamId) const;
-	std::string sourceNameForStream(const std::string &streamId) const;
 	std::string buildSourceUrl(const std::string &streamId) const;
-	void queueLayoutRefresh() const;
-	void removalWorkerLoop();
-	bool queueStreamRemovalLocked(const std::string &streamId);
+	void workerLoop();
+	void queueStreamRemovalLocked(const std::string &streamId, int64_t nowMs);
+	void flushUiBatchLocked(bool includeLayout);
 	static std::string makeSourceName(std::string prefix, const std::string &streamId);
 	static std::string sanitizeNameToken(const std::string &input);
 
@@ -54,8 +73,10 @@ private:
 	std::set<std::string> ownStreamIds_;
 	std::set<std::string> managedStreamIds_;
 	AutoInboundRemovalGraceState pendingListingRemovals_;
-	std::condition_variable removalCv_;
-	std::thread removalThread_;
+	// Guarded by stateMutex_. Flushed to the UI thread by workerThread_.
+	AutoInboundUiBatch<AutoInboundSourceChange> uiBatch_;
+	std::condition_variable workerCv_;
+	std::thread workerThread_;
 	std::shared_ptr<AutoInboundSceneAssignmentState> sceneAssignments_ =
 	    std::make_shared<AutoInboundSceneAssignmentState>();
 };
@@ -8,12 +8,46 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <limits>
 #include <stdexcept>
 
 namespace vdoninja
 {
 
+namespace
+{
+
+uint64_t scaledPercent(uint64_t value, uint64_t percent)
+{
+	const long double result = static_cast<long double>(value) * static_cast<long double>(percent) / 100.0L;
+	if (result >= static_cast<long double>(std::numeric_limits<uint64_t>::max())) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+	return static_cast<uint64_t>(std::floor(result));
+}
+
+void validateCongestionEstimatorConfig(const CongestionEstimatorConfig &config)
+{
+	if (config.lossIncreaseFraction > config.lossBackoffFraction || config.maximumHeadroomPercent < 100 ||
+	    config.rttBackoffPercent >= 100 || config.rttBaselineReports == 0) {
+		throw std::invalid_argument("Congestion estimator settings are invalid");
+	}
+}
+
+} // namespace
+
+const char *bitrateControlModeName(BitrateControlMode mode)
+{
+	switch (mode) {
+	case BitrateControlMode::Blended:
+		return "blended";
+	case BitrateControlMode::Remb:
+	default:
+		return "remb";
+	}
+}
+
 BitrateController::BitrateController(BitrateControllerConfig config)
     : config_(config), currentBitrateBitsPerSecond_(config.maximumBitrateBitsPerSecond)
 {
@@ -95,11 +129,7 @@ void BitrateController::reset()
 
 uint64_t BitrateController::scaled(uint64_t value, uint16_t percent) const
 {
-	const long double result = static_cast<long double>(value) * static_cast<long double>(percent) / 100.0L;
-	if (result >= static_cast<long double>(std::numeric_limits<uint64_t>::max())) {
-		return std::numeric_limits<uint64_t>::max();
-	}
-	return static_cast<uint64_t>(std::floor(result));
+	return scaledPercent(value, percent);
 }
 
 bool BitrateController::cooldownElapsed(Clock::time_point now, std::chrono::milliseconds cooldown) const
@@ -107,4 +137,110 @@ bool BitrateController::cooldownElapsed(Clock::time_point now, std::chrono::mill
 	return !lastChangeAt_ || now < *lastChangeAt_ || now - *lastChangeAt_ >= cooldown;
 }
 
+ViewerCongestionEstimator::ViewerCongestionEstimator(CongestionEstimatorConfig config) : config_(config)
+{
+	validateCongestionEstimatorConfig(config_);
+}
+
+std::optional<uint64_t> ViewerCongestionEstimator::update(const ViewerCongestionFeedback &feedback,
+                                                          uint64_t sendingBitsPerSecond)
+{
+	if (feedback.reportSequence != 0 && feedback.reportSequence != lastReportSequence_ && sendingBitsPerSecond > 0) {
+		lastReportSequence_ = feedback.reportSequence;
+		if (feedback.rttMs) {
+			observeRtt(*feedback.rttMs);
+		}
+
+		// Decreases start from what is actually being sent; an estimate left
+		// above it by a quiet spell says nothing about the congested path.
+		const uint64_t headroom = scaledPercent(sendingBitsPerSecond, config_.maximumHeadroomPercent);
+		const uint64_t previous = lossBasedBitsPerSecond_.value_or(sendingBitsPerSecond);
+		const uint64_t base = std::min(previous, sendingBitsPerSecond);
+		uint64_t next = std::min(previous, headroom);
+		if (feedback.fractionLost > config_.lossBackoffFraction) {
+			// target * (1 - loss / 2), with loss in 1/256 units.
+			next = base - (base * feedback.fractionLost) / 512U;
+		} else if (rttRising_) {
+			next = scaledPercent(base, 100U - config_.rttBackoffPercent);
+		} else if (feedback.fractionLost < config_.lossIncreaseFraction) {
+			next = std::min(scaledPercent(next, 100U + config_.increasePercent), headroom);
+		}
+		lossBasedBitsPerSecond_ = std::max<uint64_t>(next, 1);
+	}
+
+	std::optional<uint64_t> target = feedback.rembBitsPerSecond;
+	if (target && *target == 0) {
+		target.reset();
+	}
+	if (feedback.reportSequence != 0 && lossBasedBitsPerSecond_) {
+		target = target ? std::min(*target, *lossBasedBitsPerSecond_) : *lossBasedBitsPerSecond_;
+	}
+	return target;
+}
+
+void ViewerCongestionEstimator::observeRtt(uint64_t rttMs)
+{
+	recentRttMs_.push_back(rttMs);
+	while (recentRttMs_.size() > config_.rttBaselineReports) {
+		recentRttMs_.pop_front();
+	}
+	const uint64_t baseline = *std::min_element(recentRttMs_.begin(), recentRttMs_.end());
+	const uint64_t previousSmoothed = smoothedRttMs_.value_or(rttMs);
+	// Quarter-weight smoothing keeps one delayed report from looking like a
+	// trend, while a queue that keeps growing still shows within a few.
+	smoothedRttMs_ = (previousSmoothed * 3U + rttMs) / 4U;
+	const uint64_t rise = std::max(config_.minimumRttRiseMs, scaledPercent(baseline, config_.rttRisePercent));
+	rttRising_ = *smoothedRttMs_ >= baseline + rise && rttMs >= previousSmoothed;
+}
+
+BlendedBitrateEstimator::BlendedBitrateEstimator(CongestionEstimatorConfig config) : config_(config)
+{
+	validateCongestionEstimatorConfig(config_);
+}
+
+std::optional<uint64_t> BlendedBitrateEstimator::estimate(const std::vector<ViewerCongestionFeedback> &feedback,
+                                                          uint64_t sendingBitsPerSecond)
+{
+	for (auto it = viewers_.begin(); it != viewers_.end();) {
+		const bool present =
+		    std::any_of(feedback.begin(), feedback.end(),
+		                [&](const ViewerCongestionFeedback &entry) { return entry.viewerId == it->first; });
+		it = present ? std::next(it) : viewers_.erase(it);
+	}
+
+	if (feedback.empty()) {
+		limitingViewer_.clear();
+		return std::nullopt;
+	}
+	std::optional<uint64_t> minimum;
+	std::string limiting;
+	bool complete = true;
+	for (const auto &entry : feedback) {
+		// Every viewer's estimator sees every report even when another
+		// viewer's silence means no estimate is produced this round.
+		auto it = viewers_.try_emplace(entry.viewerId, config_).first;
+		const std::optional<uint64_t> target = it->second.update(entry, sendingBitsPerSecond);
+		if (!target) {
+			complete = false;
+			continue;
+		}
+		if (!minimum || *target < *minimum) {
+			minimum = target;
+			limiting = entry.viewerId;
+		}
+	}
+	if (!complete) {
+		limitingViewer_.clear();
+		return std::nullopt;
+	}
+	limitingViewer_ = limiting;
+	return minimum;
+}
+
+void BlendedBitrateEstimator::reset()
+{
+	viewers_.clear();
+	limitingViewer_.clear();
+}
+
 } // namespace vdoninja
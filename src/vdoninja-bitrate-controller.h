@@ -7,8 +7,13 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <map>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace vdoninja
 {
@@ -52,4 +57,91 @@ private:
 	std::optional<Clock::time_point> lastChangeAt_;
 };
 
+enum class BitrateControlMode {
+	// Follow the lowest REMB estimate across viewers.
+	Remb,
+	// Additionally back off on receiver-reported loss and a rising RTT trend,
+	// per viewer, before taking the lowest viewer target.
+	Blended,
+};
+
+const char *bitrateControlModeName(BitrateControlMode mode);
+
+// What one viewer most recently told us about its path.
+struct ViewerCongestionFeedback {
+	std::string viewerId;
+	std::optional<uint64_t> rembBitsPerSecond;
+	// RtcpReceiverReport::sequence of the newest fresh report, or zero when
+	// the viewer has not sent one recently.
+	uint64_t reportSequence = 0;
+	uint8_t fractionLost = 0;
+	std::optional<uint64_t> rttMs;
+};
+
+struct CongestionEstimatorConfig {
+	// Receiver report fraction lost, in 1/256 units. Above the backoff
+	// threshold (about 10%) the viewer target drops by half the loss rate;
+	// between the two thresholds it holds; below about 2% it may grow.
+	uint8_t lossBackoffFraction = 26;
+	uint8_t lossIncreaseFraction = 5;
+	uint16_t increasePercent = 8;
+	// A loss-based target never runs further than this ahead of the bitrate
+	// actually being sent, so the first loss after a quiet spell takes effect
+	// at once instead of eating through unused headroom.
+	uint16_t maximumHeadroomPercent = 150;
+	// RTT counts as rising once the smoothed value exceeds the lowest recent
+	// RTT by both margins and the newest sample is not falling.
+	uint64_t minimumRttRiseMs = 30;
+	uint16_t rttRisePercent = 50;
+	uint16_t rttBackoffPercent = 15;
+	size_t rttBaselineReports = 30;
+};
+
+// Loss- and delay-based target for a single viewer. Each new receiver report
+// moves the target once; repeated polls of the same report do not.
+class ViewerCongestionEstimator
+{
+public:
+	explicit ViewerCongestionEstimator(CongestionEstimatorConfig config = {});
+
+	// Returns the viewer's target, the lower of its REMB and loss-based
+	// estimates, or nullopt when it has reported neither.
+	std::optional<uint64_t> update(const ViewerCongestionFeedback &feedback, uint64_t sendingBitsPerSecond);
+	std::optional<uint64_t> lossBasedBitsPerSecond() const noexcept { return lossBasedBitsPerSecond_; }
+	bool rttRising() const noexcept { return rttRising_; }
+
+private:
+	void observeRtt(uint64_t rttMs);
+
+	CongestionEstimatorConfig config_;
+	uint64_t lastReportSequence_ = 0;
+	std::optional<uint64_t> lossBasedBitsPerSecond_;
+	std::deque<uint64_t> recentRttMs_;
+	std::optional<uint64_t> smoothedRttMs_;
+	bool rttRising_ = false;
+};
+
+// Keeps one estimator per viewer and combines their targets with the same
+// minimum-across-all-viewers policy as the REMB-only mode.
+class BlendedBitrateEstimator
+{
+public:
+	explicit BlendedBitrateEstimator(CongestionEstimatorConfig config = {});
+
+	// Viewers missing from feedback are forgotten. Returns nullopt when any
+	// viewer has no usable feedback, rather than adapting to the subset that
+	// happened to report.
+	std::optional<uint64_t> estimate(const std::vector<ViewerCongestionFeedback> &feedback,
+	                                 uint64_t sendingBitsPerSecond);
+	// The viewer whose target set the last estimate.
+	const std::string &limitingViewer() const noexcept { return limitingViewer_; }
+	size_t viewerCount() const noexcept { return viewers_.size(); }
+	void reset();
+
+private:
+	CongestionEstimatorConfig config_;
+	std::map<std::string, ViewerCongestionEstimator> viewers_;
+	std::string limitingViewer_;
+};
+
 } // namespace vdoninja
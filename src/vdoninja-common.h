@@ -18,6 +18,7 @@
 #include <thread>
 #include <vector>
 
+#include "vdoninja-bitrate-controller.h"
 #include "vdoninja-loss-protection.h"
 #include "vdoninja-video-keyframe-gate.h"
 
@@ -45,6 +46,10 @@ constexpr const char *DEFAULT_PASSWORD = "someEncryptionKey123";
 constexpr int DEFAULT_RECONNECT_ATTEMPTS = 5;
 constexpr int MIN_RECONNECT_INTERVAL_MS = 15 * 60 * 1000;
 constexpr int ICE_CANDIDATE_BUNDLE_DELAY_MS = 70;
+// Native receiver decode lag budget; 0 disables frame skipping.
+constexpr int DEFAULT_MAX_DECODE_LATENCY_MS = 1000;
+// Viewers a native receiver's relay republishes to.
+constexpr int DEFAULT_RELAY_MAX_VIEWERS = 50;
 
 // Default STUN servers
 const std::vector<std::string> DEFAULT_STUN_SERVERS = {"stun:stun.l.google.com:19302", "stun:stun.cloudflare.com:3478"};
@@ -90,6 +95,7 @@ struct PeerInfo {
 	std::atomic<bool> localOfferRequested{false};
 	std::atomic<bool> localOfferDispatched{false};
 	std::atomic<bool> remoteDescriptionSet{false};
+	std::atomic<bool> localCandidatesGathered{false};
 	mutable std::mutex negotiationMutex;
 	std::string lastLocalOfferSdp;
 	mutable std::mutex mediaMutex;
@@ -109,6 +115,9 @@ struct PeerInfo {
 	std::shared_ptr<rtc::PeerConnection> pc;
 	std::shared_ptr<rtc::DataChannel> dataChannel;
 	std::shared_ptr<rtc::DataChannel> signalingDataChannel;
+	// Publisher "sendChannel" created for a pre-warmed connection. Its callbacks
+	// are installed once the connection is claimed for a viewer.
+	std::shared_ptr<rtc::DataChannel> pendingPublisherDataChannel;
 	std::string signalingDataChannelTransportUuid;
 	uint64_t signalingDataChannelTransportGeneration = 0;
 	uint64_t signalingDataChannelRevision = 0;
@@ -124,6 +133,11 @@ struct PeerInfo {
 	std::shared_ptr<rtc::RtpPacketizationConfig> videoRtpConfig;
 	std::shared_ptr<RtcpFeedbackTracker> videoFeedbackTracker;
 	std::shared_ptr<RtpPacketPacer> videoPacer;
+	// Weight in the shared viewer budget, kept for pacers created later.
+	// Guarded by mediaMutex.
+	uint32_t videoPacerWeight = 1;
+	// ICE type of the selected pair, captured once connected. Guarded by mediaMutex.
+	std::string selectedCandidateType;
 	bool useAudioPacketizer = false;
 	bool useVideoPacketizer = false;
 	bool useAudioRed = false;
@@ -172,6 +186,7 @@ using OnStreamAddedCallback = std::function<void(const std::string &streamId, co
 using OnStreamRemovedCallback = std::function<void(const std::string &streamId, const std::string &uuid)>;
 using OnPeerCleanupCallback = std::function<void(const std::string &uuid, const std::string &session)>;
 using OnDataCallback = std::function<void(const std::string &uuid, const std::string &data)>;
+using OnRawMessageCallback = std::function<void(const std::string &message)>;
 
 // Video codec preferences
 enum class VideoCodec { H264, VP8, VP9, AV1 };
@@ -182,6 +197,10 @@ enum class AudioCodec { Opus, PCMU, PCMA };
 // Auto layout mode for browser source orchestration.
 enum class AutoLayoutMode { None, Grid };
 
+// OBS source type created for each auto-inbound stream. Native sources use the
+// built-in receiver instead of a Chromium renderer per guest.
+enum class AutoInboundSourceType { Browser, Native };
+
 // OBS scene automation settings for inbound streams.
 struct AutoInboundSettings {
 	bool enabled = false;
@@ -194,6 +213,7 @@ struct AutoInboundSettings {
 	std::string wssHost = DEFAULT_WSS_HOST;
 	bool removeOnDisconnect = true;
 	AutoLayoutMode layoutMode = AutoLayoutMode::Grid;
+	AutoInboundSourceType sourceType = AutoInboundSourceType::Browser;
 	bool switchToSceneOnNewStream = false;
 	int width = 1920;
 	int height = 1080;
@@ -218,6 +238,11 @@ struct OutputSettings {
 	bool enableAudioRed = false;
 	bool enableAdaptiveBitrate = false;
 	int minimumAdaptiveBitrate = 500000;
+	BitrateControlMode adaptiveBitrateMode = BitrateControlMode::Remb;
+	std::string qualityLadder; // "<kbps>:<height>p<fps>, ..." rungs below the configured encoder
+	int warmViewerConnections = 0; // Pre-warmed publisher connections kept ready; 0 disables the pool
+	bool gopFastStart = true;             // Replay the current GOP to joining viewers
+	bool intraRefresh = false;            // Rolling intra refresh instead of periodic IDRs (x264 only)
 	bool enableRemote = false;
 	AutoInboundSettings autoInbound;
 };
@@ -235,6 +260,11 @@ struct SourceSettings {
 	bool autoReconnect = true;
 	std::vector<IceServer> customIceServers;
 	bool forceTurn = false;
+	int maxDecodeLatencyMs = DEFAULT_MAX_DECODE_LATENCY_MS;
+	std::string scaleQuality = "bilinear";
+	std::string relayStreamId; // Republish the received stream under this ID; empty disables the relay
+	int relayMaxViewers = DEFAULT_RELAY_MAX_VIEWERS;
+	bool sharedRoomSignaling = false; // Signal over the room's shared connection instead of a private one
 };
 
 template <typename Owner> struct AsyncCallbackState {
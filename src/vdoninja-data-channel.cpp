@@ -886,6 +886,36 @@ DirectorTransformStateUpdate VDONinjaDataChannel::parseDirectorTransformState(co
 	return update;
 }
 
+ViewerRoleUpdate VDONinjaDataChannel::parseViewerRole(const std::string &rawMessage) const
+{
+	ViewerRoleUpdate update;
+	// Called for every viewer message; only the rare info payload is worth a parse.
+	if (rawMessage.find("\"info\"") == std::string::npos) {
+		return update;
+	}
+
+	try {
+		JsonParser json(rawMessage);
+		if (!json.hasKey("info")) {
+			return update;
+		}
+		JsonParser info(json.getObject("info"));
+		if (info.hasKey("director")) {
+			update.hasDirector = true;
+			update.director = info.getBool("director");
+		}
+		if (info.hasKey("scene")) {
+			const std::string scene = trim(info.getString("scene"));
+			update.hasScene = true;
+			update.scene = !scene.empty() && scene != "false" && scene != "null";
+		}
+	} catch (const std::exception &e) {
+		logError("Failed to parse viewer role: %s", e.what());
+	}
+
+	return update;
+}
+
 RecoveryControlUpdate VDONinjaDataChannel::parseRecoveryControl(const std::string &rawMessage) const
 {
 	RecoveryControlUpdate update;
@@ -163,6 +163,15 @@ struct RecoveryControlUpdate {
 	bool restartWhip = false;
 };
 
+// Viewer kind announced in the official "info" payload. Scene viewers send
+// the scene they render (or false), directors send director:true.
+struct ViewerRoleUpdate {
+	bool hasDirector = false;
+	bool director = false;
+	bool hasScene = false;
+	bool scene = false;
+};
+
 // Official mesh reconnect/map controls preserving which fields were present.
 struct MeshControlUpdate {
 	bool hasReconnectPeer = false;
@@ -207,6 +216,7 @@ public:
 	                                        const std::string &peerUuid) const;
 	DirectorAudioStateUpdate parseDirectorAudioState(const std::string &rawMessage) const;
 	DirectorTransformStateUpdate parseDirectorTransformState(const std::string &rawMessage) const;
+	ViewerRoleUpdate parseViewerRole(const std::string &rawMessage) const;
 	RecoveryControlUpdate parseRecoveryControl(const std::string &rawMessage) const;
 	MeshControlUpdate parseMeshControl(const std::string &rawMessage) const;
 	std::string prepareSignalingMessage(const std::string &rawMessage, const std::string &senderId) const;
@@ -0,0 +1,337 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Latency-bounded native video decode admission
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-decode-budget.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr uint32_t kH264SeiRecoveryPoint = 6;
+constexpr int kVp9FrameMarker = 2;
+constexpr int kVp9Profile3 = 3;
+// Receiver/sender crystal skew is well under 100 ppm in practice; allow five
+// times that before treating a rising offset as decoder backlog.
+constexpr int64_t kClockDriftAllowancePpm = 500;
+constexpr int64_t kTimestampJumpResetSeconds = 10;
+constexpr int64_t kKeyframeRerequestIntervalUs = 1000000;
+
+class BitReader
+{
+public:
+	BitReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+	bool read(int bits, uint32_t &value)
+	{
+		value = 0;
+		for (int i = 0; i < bits; ++i) {
+			if (position_ >= size_ * 8) {
+				return false;
+			}
+			const uint8_t byte = data_[position_ / 8];
+			value = (value << 1) | ((byte >> (7 - position_ % 8)) & 1U);
+			++position_;
+		}
+		return true;
+	}
+
+private:
+	const uint8_t *data_;
+	size_t size_;
+	size_t position_ = 0;
+};
+
+// Walks the sei_message() list of an SEI NAL payload (after the NAL header),
+// removing emulation prevention bytes as it goes because payload sizes count
+// RBSP bytes.
+bool seiHasRecoveryPoint(const uint8_t *data, size_t size)
+{
+	std::vector<uint8_t> rbsp;
+	rbsp.reserve(size);
+	size_t zeros = 0;
+	for (size_t i = 0; i < size; ++i) {
+		if (zeros >= 2 && data[i] == 0x03) {
+			zeros = 0;
+			continue;
+		}
+		zeros = data[i] == 0 ? zeros + 1 : 0;
+		rbsp.push_back(data[i]);
+	}
+
+	size_t offset = 0;
+	const auto readValue = [&](uint32_t &value) {
+		value = 0;
+		while (offset < rbsp.size() && rbsp[offset] == 0xFF) {
+			value += 0xFF;
+			++offset;
+		}
+		if (offset >= rbsp.size()) {
+			return false;
+		}
+		value += rbsp[offset++];
+		return true;
+	};
+	// 0x80 is rbsp_trailing_bits after the last message.
+	while (offset < rbsp.size() && rbsp[offset] != 0x80) {
+		uint32_t payloadType = 0;
+		uint32_t payloadSize = 0;
+		if (!readValue(payloadType) || !readValue(payloadSize)) {
+			return false;
+		}
+		if (payloadType == kH264SeiRecoveryPoint) {
+			return true;
+		}
+		if (payloadSize > rbsp.size() - offset) {
+			return false;
+		}
+		offset += payloadSize;
+	}
+	return false;
+}
+
+} // namespace
+
+EncodedVideoFrameInfo inspectH264AccessUnit(const uint8_t *data, size_t size)
+{
+	H264NalIndex index;
+	index.build(data, size);
+	return inspectH264AccessUnit(data, index);
+}
+
+EncodedVideoFrameInfo inspectH264AccessUnit(const uint8_t *data, const H264NalIndex &index)
+{
+	EncodedVideoFrameInfo info;
+	if (!data || index.format() != H264NalFormat::AnnexB) {
+		return info;
+	}
+
+	bool sawSlice = false;
+	bool referenceSlice = false;
+	for (const H264NalUnit &unit : index.units()) {
+		if (unit.type == kH264NalTypeIdrSlice || unit.type == kH264NalTypeNonIdrSlice) {
+			sawSlice = true;
+			referenceSlice = referenceSlice || unit.refIdc != 0;
+			info.keyframe = info.keyframe || unit.type == kH264NalTypeIdrSlice;
+		} else if (unit.type == kH264NalTypeSei && !info.recoveryPoint) {
+			info.recoveryPoint = seiHasRecoveryPoint(data + unit.offset + 1, unit.size - 1);
+		}
+	}
+	info.reference = !sawSlice || referenceSlice || info.keyframe;
+	return info;
+}
+
+EncodedVideoFrameInfo inspectVP9Frame(const uint8_t *data, size_t size)
+{
+	EncodedVideoFrameInfo info;
+	if (!data || size == 0) {
+		return info;
+	}
+
+	BitReader reader(data, size);
+	uint32_t frameMarker = 0;
+	uint32_t profileLow = 0;
+	uint32_t profileHigh = 0;
+	if (!reader.read(2, frameMarker) || frameMarker != kVp9FrameMarker || !reader.read(1, profileLow) ||
+	    !reader.read(1, profileHigh)) {
+		return info;
+	}
+	const uint32_t profile = (profileHigh << 1) | profileLow;
+	uint32_t unused = 0;
+	if (profile == kVp9Profile3 && !reader.read(1, unused)) {
+		return info;
+	}
+
+	uint32_t showExistingFrame = 0;
+	if (!reader.read(1, showExistingFrame)) {
+		return info;
+	}
+	if (showExistingFrame) {
+		// Re-displays an already decoded buffer; no new prediction state.
+		info.reference = false;
+		return info;
+	}
+
+	uint32_t frameType = 0;
+	uint32_t showFrame = 0;
+	uint32_t errorResilient = 0;
+	if (!reader.read(1, frameType) || !reader.read(1, showFrame) || !reader.read(1, errorResilient)) {
+		return info;
+	}
+	if (frameType == 0) {
+		info.keyframe = true;
+		return info;
+	}
+
+	uint32_t intraOnly = 0;
+	if (!showFrame && !reader.read(1, intraOnly)) {
+		return info;
+	}
+	if (!errorResilient && !reader.read(2, unused)) {
+		return info;
+	}
+	if (intraOnly) {
+		// Intra-only frames carry a sync code and, above profile 0, a
+		// variable-length color config before refresh_frame_flags.
+		if (profile != 0 || !reader.read(24, unused)) {
+			return info;
+		}
+	}
+
+	uint32_t refreshFrameFlags = 0;
+	if (reader.read(8, refreshFrameFlags)) {
+		info.reference = refreshFrameFlags != 0;
+	}
+	return info;
+}
+
+DecodeLatencyBudget::DecodeLatencyBudget(int64_t budgetUs, uint32_t clockRate)
+    : budgetUs_(std::max<int64_t>(0, budgetUs)), clockRate_(std::max<uint32_t>(1, clockRate))
+{
+}
+
+void DecodeLatencyBudget::setBudgetUs(int64_t budgetUs)
+{
+	budgetUs_ = std::max<int64_t>(0, budgetUs);
+}
+
+int64_t DecodeLatencyBudget::mediaTimeUs(uint32_t rtpTimestamp)
+{
+	const int64_t deltaTicks = static_cast<int32_t>(rtpTimestamp - lastRtpTimestamp_);
+	if (!hasBaseline_ || std::llabs(deltaTicks) > kTimestampJumpResetSeconds * static_cast<int64_t>(clockRate_)) {
+		hasBaseline_ = false;
+		unwrappedTicks_ = 0;
+	} else {
+		unwrappedTicks_ += deltaTicks;
+	}
+	lastRtpTimestamp_ = rtpTimestamp;
+	return unwrappedTicks_ * 1000000LL / static_cast<int64_t>(clockRate_);
+}
+
+void DecodeLatencyBudget::endEpisode(int64_t lagUs)
+{
+	if (episodePeakLagUs_ > lagUs) {
+		stats_.recoveredLatencyUs += static_cast<uint64_t>(episodePeakLagUs_ - lagUs);
+	}
+	degraded_ = false;
+	skippingToKeyframe_ = false;
+	episodePeakLagUs_ = 0;
+}
+
+DecodeAdmissionResult DecodeLatencyBudget::admit(uint32_t rtpTimestamp, int64_t nowUs,
+                                                 const EncodedVideoFrameInfo &frame)
+{
+	DecodeAdmissionResult result;
+	const int64_t offsetUs = nowUs - mediaTimeUs(rtpTimestamp);
+	if (!hasBaseline_ || offsetUs < baselineOffsetUs_) {
+		hasBaseline_ = true;
+		baselineOffsetUs_ = offsetUs;
+		baselineUpdatedUs_ = nowUs;
+	} else {
+		const int64_t allowanceUs = (nowUs - baselineUpdatedUs_) * kClockDriftAllowancePpm / 1000000;
+		if (allowanceUs > 0) {
+			baselineOffsetUs_ = std::min(offsetUs, baselineOffsetUs_ + allowanceUs);
+			baselineUpdatedUs_ = nowUs;
+		}
+	}
+
+	const int64_t lagUs = offsetUs - baselineOffsetUs_;
+	result.lagUs = lagUs;
+	stats_.maxLagUs = std::max(stats_.maxLagUs, lagUs);
+
+	if (budgetUs_ <= 0) {
+		if (degraded_) {
+			endEpisode(lagUs);
+		}
+		++stats_.decodedFrames;
+		return result;
+	}
+
+	if (skippingToKeyframe_) {
+		episodePeakLagUs_ = std::max(episodePeakLagUs_, lagUs);
+		if (!frame.keyframe) {
+			++stats_.skippedToKeyframeFrames;
+			result.action = DecodeAdmission::SkipToKeyframe;
+			if (nowUs - lastKeyframeRequestUs_ >= kKeyframeRerequestIntervalUs) {
+				lastKeyframeRequestUs_ = nowUs;
+				result.requestKeyframe = true;
+			}
+			return result;
+		}
+		skippingToKeyframe_ = false;
+	}
+
+	// Keyframes are never dropped: they are the recovery point.
+	if (lagUs > budgetUs_ * 2 && !frame.keyframe) {
+		if (!degraded_) {
+			degraded_ = true;
+			episodePeakLagUs_ = lagUs;
+		}
+		episodePeakLagUs_ = std::max(episodePeakLagUs_, lagUs);
+		skippingToKeyframe_ = true;
+		lastKeyframeRequestUs_ = nowUs;
+		++stats_.keyframeSkips;
+		++stats_.skippedToKeyframeFrames;
+		result.action = DecodeAdmission::SkipToKeyframe;
+		result.requestKeyframe = true;
+		result.flushDecoder = true;
+		return result;
+	}
+
+	if (lagUs > budgetUs_ / 2) {
+		if (!degraded_) {
+			degraded_ = true;
+			episodePeakLagUs_ = lagUs;
+		}
+	} else if (degraded_ && lagUs < budgetUs_ / 4) {
+		endEpisode(lagUs);
+	}
+	if (degraded_) {
+		episodePeakLagUs_ = std::max(episodePeakLagUs_, lagUs);
+	}
+
+	if (lagUs > budgetUs_ && !frame.reference && !frame.keyframe) {
+		++stats_.droppedNonReferenceFrames;
+		result.action = DecodeAdmission::DropNonReference;
+		return result;
+	}
+
+	++stats_.decodedFrames;
+	if (degraded_) {
+		++stats_.degradedFrames;
+		result.action = DecodeAdmission::DecodeDegraded;
+	}
+	return result;
+}
+
+DecodeBudgetStats DecodeLatencyBudget::getStats(bool resetInterval)
+{
+	DecodeBudgetStats stats = stats_;
+	if (resetInterval) {
+		stats_ = {};
+	}
+	return stats;
+}
+
+void DecodeLatencyBudget::reset()
+{
+	hasBaseline_ = false;
+	unwrappedTicks_ = 0;
+	lastRtpTimestamp_ = 0;
+	baselineOffsetUs_ = 0;
+	baselineUpdatedUs_ = 0;
+	degraded_ = false;
+	skippingToKeyframe_ = false;
+	episodePeakLagUs_ = 0;
+	lastKeyframeRequestUs_ = 0;
+}
+
+} // namespace vdoninja
@@ -0,0 +1,105 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Latency-bounded native video decode admission
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vdoninja-h264-nal-index.h"
+
+namespace vdoninja
+{
+
+struct EncodedVideoFrameInfo {
+	bool keyframe = false;
+	// False only when the bitstream proves no later frame predicts from this
+	// one; anything unparsed is treated as a reference.
+	bool reference = true;
+	// Carries an H.264 recovery point SEI: a gradual intra refresh entry that
+	// a decoder already started on an IDR can resume from.
+	bool recoveryPoint = false;
+};
+
+// Scans an Annex B access unit: IDR slices mark a keyframe, the frame is a
+// reference when any slice carries a non-zero nal_ref_idc, and an SEI NAL
+// holding a recovery_point message marks a recovery point.
+EncodedVideoFrameInfo inspectH264AccessUnit(const uint8_t *data, size_t size);
+// The same, reading an index already built over data.
+EncodedVideoFrameInfo inspectH264AccessUnit(const uint8_t *data, const H264NalIndex &index);
+// Reads the VP9 uncompressed header. Inter frames with refresh_frame_flags == 0
+// and show_existing_frame repeats are non-reference.
+EncodedVideoFrameInfo inspectVP9Frame(const uint8_t *data, size_t size);
+
+enum class DecodeAdmission {
+	Decode,
+	// Over the soft limit: decode with loop filter and non-reference skipping
+	// enabled in the codec.
+	DecodeDegraded,
+	// Over budget and the frame is non-reference: drop it before decode.
+	DropNonReference,
+	// Far behind: drop everything until the next keyframe.
+	SkipToKeyframe,
+};
+
+struct DecodeAdmissionResult {
+	DecodeAdmission action = DecodeAdmission::Decode;
+	bool requestKeyframe = false;
+	// True on the frame that started a skip; the decoder should be flushed.
+	bool flushDecoder = false;
+	int64_t lagUs = 0;
+};
+
+struct DecodeBudgetStats {
+	uint64_t decodedFrames = 0;
+	uint64_t degradedFrames = 0;
+	uint64_t droppedNonReferenceFrames = 0;
+	uint64_t skippedToKeyframeFrames = 0;
+	uint64_t keyframeSkips = 0;
+	// Sum over over-budget episodes of peak lag minus lag when the episode ended.
+	uint64_t recoveredLatencyUs = 0;
+	int64_t maxLagUs = 0;
+};
+
+// Measures how far behind real time frames reach the decoder. Lag is the
+// arrival offset (now minus RTP media time) relative to the earliest offset
+// seen, so network jitter and a slow decoder both show up as positive lag.
+// The baseline may creep upward by a small drift allowance so sender/receiver
+// clock skew is not mistaken for backlog. Not thread-safe; the caller
+// serializes access with its decode lock.
+class DecodeLatencyBudget
+{
+public:
+	explicit DecodeLatencyBudget(int64_t budgetUs = 0, uint32_t clockRate = 90000);
+
+	// 0 disables admission control; frames are still counted.
+	void setBudgetUs(int64_t budgetUs);
+	int64_t budgetUs() const { return budgetUs_; }
+
+	DecodeAdmissionResult admit(uint32_t rtpTimestamp, int64_t nowUs, const EncodedVideoFrameInfo &frame);
+	DecodeBudgetStats getStats(bool resetInterval = false);
+	// Forget the timing baseline after a stream transition.
+	void reset();
+
+private:
+	int64_t mediaTimeUs(uint32_t rtpTimestamp);
+	void endEpisode(int64_t lagUs);
+
+	int64_t budgetUs_;
+	uint32_t clockRate_;
+	bool hasBaseline_ = false;
+	uint32_t lastRtpTimestamp_ = 0;
+	int64_t unwrappedTicks_ = 0;
+	int64_t baselineOffsetUs_ = 0;
+	int64_t baselineUpdatedUs_ = 0;
+	bool degraded_ = false;
+	bool skippingToKeyframe_ = false;
+	int64_t episodePeakLagUs_ = 0;
+	int64_t lastKeyframeRequestUs_ = 0;
+	DecodeBudgetStats stats_;
+};
+
+} // namespace vdoninja
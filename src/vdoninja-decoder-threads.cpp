@@ -0,0 +1,255 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Process-wide decoder thread budget for native receivers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-decoder-threads.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+// About what one core decodes of H.264 or VP9 in real time, with headroom:
+// 1080p30 asks for four threads and 720p30 for two.
+constexpr double kPixelRatePerThread = 20000000.0;
+// Each extra frame thread adds a frame of latency; past this it buys little.
+constexpr int kMaxThreadsPerDecoder = 8;
+// Assumed when the platform cannot report a core count.
+constexpr unsigned kFallbackHardwareThreads = 4;
+constexpr double kMinFps = 1.0;
+constexpr double kMaxFps = 240.0;
+// Measured frame rates within this fraction of the last one are ignored.
+constexpr double kFpsChangeTolerance = 0.1;
+
+DecoderLoad sanitizeLoad(const DecoderLoad &load)
+{
+	const DecoderLoad defaults;
+	DecoderLoad sanitized = load;
+	if (sanitized.width <= 0 || sanitized.height <= 0) {
+		sanitized.width = defaults.width;
+		sanitized.height = defaults.height;
+	}
+	if (!std::isfinite(sanitized.fps) || sanitized.fps <= 0.0) {
+		sanitized.fps = defaults.fps;
+	}
+	sanitized.fps = std::clamp(sanitized.fps, kMinFps, kMaxFps);
+	return sanitized;
+}
+
+int wantedThreads(const DecoderLoad &load)
+{
+	const DecoderLoad sanitized = sanitizeLoad(load);
+	const double pixelRate = static_cast<double>(sanitized.width) * sanitized.height * sanitized.fps;
+	const int wanted = static_cast<int>(std::ceil(pixelRate / kPixelRatePerThread));
+	return std::clamp(wanted, 1, kMaxThreadsPerDecoder);
+}
+
+} // namespace
+
+int decoderThreadShare(unsigned hardwareThreads)
+{
+	const int hardware = static_cast<int>(hardwareThreads > 0 ? hardwareThreads : kFallbackHardwareThreads);
+	// A quarter of the machine stays with OBS. A lone decoder still gets two
+	// threads so small machines keep frame threading.
+	const int reserve = std::max(1, hardware / 4);
+	return std::max(2, hardware - reserve);
+}
+
+std::vector<int> allocateDecoderThreads(const std::vector<DecoderLoad> &loads, unsigned hardwareThreads)
+{
+	std::vector<int> wanted;
+	wanted.reserve(loads.size());
+	for (const DecoderLoad &load : loads) {
+		wanted.push_back(wantedThreads(load));
+	}
+
+	std::vector<int> threads(loads.size(), 1);
+	int remaining = decoderThreadShare(hardwareThreads) - static_cast<int>(loads.size());
+	while (remaining > 0) {
+		size_t best = loads.size();
+		for (size_t i = 0; i < loads.size(); ++i) {
+			if (threads[i] >= wanted[i]) {
+				continue;
+			}
+			// Fewest threads per unit of want first; earlier decoders win ties.
+			if (best == loads.size() ||
+			    static_cast<int64_t>(threads[i]) * wanted[best] < static_cast<int64_t>(threads[best]) * wanted[i]) {
+				best = i;
+			}
+		}
+		if (best == loads.size()) {
+			break;
+		}
+		++threads[best];
+		--remaining;
+	}
+	return threads;
+}
+
+bool decoderThreadsNeedReopen(int openedThreads, int allottedThreads)
+{
+	if (openedThreads <= 0 || allottedThreads <= 0 || openedThreads == allottedThreads) {
+		return false;
+	}
+	// Crossing one thread switches frame threading itself on or off.
+	return (openedThreads == 1) != (allottedThreads == 1) || std::abs(openedThreads - allottedThreads) >= 2;
+}
+
+double DecoderFrameRateMeter::noteFrame(uint32_t rtpTimestamp, bool keyframe)
+{
+	if (!keyframe) {
+		if (haveKeyframe_) {
+			++frames_;
+		}
+		return 0.0;
+	}
+
+	double fps = 0.0;
+	const uint32_t elapsed = rtpTimestamp - keyframeTimestamp_;
+	// A stretch longer than a minute is a restart, not a slow stream.
+	if (haveKeyframe_ && elapsed > 0 && elapsed < clockRate_ * 60) {
+		fps = static_cast<double>(frames_ + 1) * clockRate_ / elapsed;
+	}
+	haveKeyframe_ = true;
+	keyframeTimestamp_ = rtpTimestamp;
+	frames_ = 0;
+	return fps;
+}
+
+void DecoderFrameRateMeter::reset()
+{
+	haveKeyframe_ = false;
+	keyframeTimestamp_ = 0;
+	frames_ = 0;
+}
+
+DecoderThreadBudget::DecoderThreadBudget(unsigned hardwareThreads)
+    : hardwareThreads_(hardwareThreads), share_(decoderThreadShare(hardwareThreads))
+{
+}
+
+DecoderThreadBudget &DecoderThreadBudget::shared()
+{
+	static DecoderThreadBudget budget(std::thread::hardware_concurrency());
+	return budget;
+}
+
+uint64_t DecoderThreadBudget::add(const DecoderLoad &load)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const uint64_t id = nextId_++;
+	entries_[id].load = load;
+	rebalanceLocked();
+	return id;
+}
+
+void DecoderThreadBudget::update(uint64_t id, const DecoderLoad &load)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries_.find(id);
+	if (it == entries_.end()) {
+		return;
+	}
+	it->second.load = load;
+	rebalanceLocked();
+}
+
+void DecoderThreadBudget::remove(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (entries_.erase(id) > 0) {
+		rebalanceLocked();
+	}
+}
+
+int DecoderThreadBudget::threads(uint64_t id) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto it = entries_.find(id);
+	return it == entries_.end() ? 0 : it->second.threads;
+}
+
+size_t DecoderThreadBudget::decoders() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+int DecoderThreadBudget::allottedThreads() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	int total = 0;
+	for (const auto &entry : entries_) {
+		total += entry.second.threads;
+	}
+	return total;
+}
+
+void DecoderThreadBudget::rebalanceLocked()
+{
+	std::vector<DecoderLoad> loads;
+	loads.reserve(entries_.size());
+	for (const auto &entry : entries_) {
+		loads.push_back(entry.second.load);
+	}
+	const std::vector<int> threads = allocateDecoderThreads(loads, hardwareThreads_);
+	size_t index = 0;
+	for (auto &entry : entries_) {
+		entry.second.threads = threads[index++];
+	}
+}
+
+DecoderThreadLease::DecoderThreadLease(DecoderThreadBudget &budget) : budget_(budget) {}
+
+DecoderThreadLease::~DecoderThreadLease()
+{
+	release();
+}
+
+int DecoderThreadLease::acquire(const DecoderLoad &load)
+{
+	load_ = load;
+	if (id_ == 0) {
+		id_ = budget_.add(load_);
+	} else {
+		budget_.update(id_, load_);
+	}
+	openedThreads_ = budget_.threads(id_);
+	return openedThreads_;
+}
+
+void DecoderThreadLease::update(const DecoderLoad &load)
+{
+	const bool sameSize = load.width == load_.width && load.height == load_.height;
+	if (sameSize && std::abs(load.fps - load_.fps) <= load_.fps * kFpsChangeTolerance) {
+		return;
+	}
+	load_ = load;
+	if (id_ != 0) {
+		budget_.update(id_, load_);
+	}
+}
+
+bool DecoderThreadLease::needsReopen() const
+{
+	return id_ != 0 && decoderThreadsNeedReopen(openedThreads_, budget_.threads(id_));
+}
+
+void DecoderThreadLease::release()
+{
+	if (id_ != 0) {
+		budget_.remove(id_);
+		id_ = 0;
+	}
+	openedThreads_ = 0;
+}
+
+} // namespace vdoninja
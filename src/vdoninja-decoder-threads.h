@@ -0,0 +1,127 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Process-wide decoder thread budget for native receivers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace vdoninja
+{
+
+// What one software decoder is asked to keep up with.
+struct DecoderLoad {
+	int width = 1920;
+	int height = 1080;
+	double fps = 30.0;
+};
+
+// Splits the decode share of the machine across the open software decoders.
+// Each decoder wants threads in proportion to its pixel rate, capped where
+// FFmpeg frame threading only adds latency; when the wants exceed the share,
+// threads go one at a time to the decoder with the fewest per unit of load.
+// Every decoder gets at least one thread, even past the share. Returned in
+// the order of loads.
+std::vector<int> allocateDecoderThreads(const std::vector<DecoderLoad> &loads, unsigned hardwareThreads);
+
+// Threads left for decoders on a machine, after OBS render, encode and audio.
+int decoderThreadShare(unsigned hardwareThreads);
+
+// Reopening a frame-threaded decoder drops the frames still inside it, so a
+// new allotment only reopens it when it moved far enough to matter.
+bool decoderThreadsNeedReopen(int openedThreads, int allottedThreads);
+
+// Frame rate of a received stream from its RTP timestamps, measured from one
+// keyframe to the next. Not synchronized.
+class DecoderFrameRateMeter
+{
+public:
+	explicit DecoderFrameRateMeter(uint32_t clockRate = 90000) : clockRate_(clockRate) {}
+
+	// Returns the rate over the group of frames a keyframe closes, else 0.
+	double noteFrame(uint32_t rtpTimestamp, bool keyframe);
+	void reset();
+
+private:
+	uint32_t clockRate_ = 90000;
+	bool haveKeyframe_ = false;
+	uint32_t keyframeTimestamp_ = 0;
+	uint32_t frames_ = 0;
+};
+
+// Registry of every open software decoder in the process. Without it each
+// FFmpeg context picks its own thread count from the core count, and ten
+// native sources on one machine start ten full sets of frame threads that
+// contend with each other and with OBS's render thread. Allotments are
+// recomputed whenever a decoder is added, removed or its load changes.
+// Internally synchronized.
+class DecoderThreadBudget
+{
+public:
+	explicit DecoderThreadBudget(unsigned hardwareThreads);
+
+	static DecoderThreadBudget &shared();
+
+	uint64_t add(const DecoderLoad &load);
+	void update(uint64_t id, const DecoderLoad &load);
+	void remove(uint64_t id);
+	// Current allotment; 0 for an unknown id.
+	int threads(uint64_t id) const;
+
+	size_t decoders() const;
+	int allottedThreads() const;
+	int share() const noexcept { return share_; }
+
+private:
+	struct Entry {
+		DecoderLoad load;
+		int threads = 1;
+	};
+
+	void rebalanceLocked();
+
+	const unsigned hardwareThreads_;
+	const int share_;
+	mutable std::mutex mutex_;
+	std::map<uint64_t, Entry> entries_;
+	uint64_t nextId_ = 1;
+};
+
+// One decoder's registration. acquire() when a software decoder is opened,
+// release() when it is freed; needsReopen() at a keyframe tells the owner to
+// reopen it with the rebalanced count. Not synchronized; guard it with the
+// decoder it describes.
+class DecoderThreadLease
+{
+public:
+	explicit DecoderThreadLease(DecoderThreadBudget &budget = DecoderThreadBudget::shared());
+	~DecoderThreadLease();
+
+	DecoderThreadLease(const DecoderThreadLease &) = delete;
+	DecoderThreadLease &operator=(const DecoderThreadLease &) = delete;
+
+	// Registers the decoder, or updates its load, and returns the thread count
+	// to open it with.
+	int acquire(const DecoderLoad &load);
+	// Records a measured load; small changes are ignored.
+	void update(const DecoderLoad &load);
+	bool needsReopen() const;
+	void release();
+
+	bool active() const noexcept { return id_ != 0; }
+	int openedThreads() const noexcept { return openedThreads_; }
+	const DecoderLoad &load() const noexcept { return load_; }
+
+private:
+	DecoderThreadBudget &budget_;
+	uint64_t id_ = 0;
+	int openedThreads_ = 0;
+	DecoderLoad load_;
+};
+
+} // namespace vdoninja
@@ -414,6 +414,14 @@ static QString formatBytes(uint64_t bytes)
 	}
 }
 
+static QString formatBitrate(int64_t bitsPerSecond)
+{
+	if (bitsPerSecond >= 1000000) {
+		return QString::number(static_cast<double>(bitsPerSecond) / 1000000.0, 'f', 2) + " Mbps";
+	}
+	return QString::number(bitsPerSecond / 1000) + " kbps";
+}
+
 static QString formatUptime(int64_t uptimeMs)
 {
 	int64_t totalSec = uptimeMs / 1000;
@@ -470,18 +478,28 @@ void VDONinjaDock::updateStats()
 		                    .arg(formatUptime(uptimeMs));
 
 		if (vdo) {
-			int viewers = vdo->getViewerCount();
-			int maxV = vdo->getMaxViewers();
-			stats += QString("\n%1: %2 / %3").arg(obs_module_text_vdo("VDONinja.Dock.Viewers")).arg(viewers).arg(maxV);
+			// Published by the output's workers; reading it never waits on the
+			// peer registry or data channel locks held by the send path.
+			const VDONinjaOutput::DockStats dockStats = vdo->getDockStats();
+			stats += QString("\n%1: %2 / %3")
+			             .arg(obs_module_text_vdo("VDONinja.Dock.Viewers"))
+			             .arg(dockStats.viewerCount)
+			             .arg(dockStats.maxViewers);
+			if (dockStats.sendBitrateBps >= 0) {
+				stats += QString("\n%1: %2\n%3: %4 ms")
+				             .arg(obs_module_text_vdo("VDONinja.Dock.SendBitrate"))
+				             .arg(formatBitrate(dockStats.sendBitrateBps))
+				             .arg(obs_module_text_vdo("VDONinja.Dock.PacerDelay"))
+				             .arg(static_cast<qulonglong>(dockStats.pacerQueueDelayMs));
+			}
 
 			// Tally indicator
-			TallyState tally = vdo->getAggregatedTally();
-			if (tally.program) {
+			if (dockStats.tallyProgram) {
 				lblTally->setText(obs_module_text_vdo("VDONinja.Dock.OnAir"));
 				lblTally->setStyleSheet("background: #ff0000; color: white; font-weight: bold; "
 				                        "border-radius: 8px; padding: 2px 8px; font-size: 12px;");
 				lblTally->setVisible(true);
-			} else if (tally.preview) {
+			} else if (dockStats.tallyPreview) {
 				lblTally->setText(obs_module_text_vdo("VDONinja.Dock.Preview"));
 				lblTally->setStyleSheet("background: #00cc00; color: white; font-weight: bold; "
 				                        "border-radius: 8px; padding: 2px 8px; font-size: 12px;");
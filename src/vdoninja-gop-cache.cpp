@@ -0,0 +1,85 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Current-GOP cache for fast viewer start
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-gop-cache.h"
+
+#include <utility>
+
+namespace vdoninja
+{
+
+int64_t gopCatchUpMs(size_t replayBytes, uint64_t pacerBitsPerSecond, uint64_t encoderBitsPerSecond) noexcept
+{
+	if (pacerBitsPerSecond <= encoderBitsPerSecond) {
+		return -1;
+	}
+	// The backlog clears once the pacer has sent the replay plus everything
+	// the encoder produced meanwhile: pacer * t = replay + encoder * t.
+	const long double replayBits = static_cast<long double>(replayBytes) * 8.0L;
+	const long double spareBitsPerSecond = static_cast<long double>(pacerBitsPerSecond - encoderBitsPerSecond);
+	return static_cast<int64_t>(replayBits * 1000.0L / spareBitsPerSecond + 0.5L);
+}
+
+GopCache::GopCache(GopCacheConfig config) : config_(config) {}
+
+void GopCache::configure(const GopCacheConfig &config)
+{
+	config_ = config;
+	clear();
+}
+
+void GopCache::append(std::shared_ptr<const std::vector<uint8_t>> payload, uint32_t timestamp, bool keyframe)
+{
+	if (!payload || payload->empty()) {
+		return;
+	}
+	if (keyframe) {
+		frames_.clear();
+		bytes_ = 0;
+		complete_ = true;
+	} else if (!complete_) {
+		return;
+	}
+
+	if (bytes_ + payload->size() > config_.maxBytes) {
+		// Keeping a partial GOP would replay a chain that stops short of the
+		// live stream, so give up on this one entirely.
+		frames_.clear();
+		bytes_ = 0;
+		complete_ = false;
+		overflows_++;
+		return;
+	}
+	bytes_ += payload->size();
+	frames_.push_back(GopCacheFrame{std::move(payload), timestamp, keyframe});
+}
+
+void GopCache::invalidate()
+{
+	frames_.clear();
+	bytes_ = 0;
+	complete_ = false;
+}
+
+void GopCache::clear()
+{
+	invalidate();
+	overflows_ = 0;
+}
+
+std::vector<GopCacheFrame> GopCache::replayFrames(uint64_t pacerBitsPerSecond, uint64_t encoderBitsPerSecond) const
+{
+	if (!complete()) {
+		return {};
+	}
+	const int64_t catchUpMs = gopCatchUpMs(bytes_, pacerBitsPerSecond, encoderBitsPerSecond);
+	if (catchUpMs < 0 || catchUpMs > config_.maxCatchUpMs) {
+		return {};
+	}
+	return frames_;
+}
+
+} // namespace vdoninja
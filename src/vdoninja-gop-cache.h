@@ -0,0 +1,91 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Current-GOP cache for fast viewer start
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vdoninja
+{
+
+// How long a viewer stays behind the live stream after being sent
+// replayBytes of cached frames, when its pacer drains at pacerBitsPerSecond
+// while live video keeps arriving at encoderBitsPerSecond. Returns -1 when the
+// pacer can never catch up.
+int64_t gopCatchUpMs(size_t replayBytes, uint64_t pacerBitsPerSecond, uint64_t encoderBitsPerSecond) noexcept;
+
+struct GopCacheConfig {
+	// A GOP larger than this is not cached; joining viewers then get the
+	// cached keyframe as a still image and wait for the next live keyframe.
+	size_t maxBytes = 8 * 1024 * 1024;
+	// A replay is only offered while the viewer would catch up with the live
+	// stream within this long. Late in a GOP the next live keyframe is close
+	// anyway, so waiting for it costs less than a long catch-up.
+	int64_t maxCatchUpMs = 1000;
+};
+
+struct GopReplayStats {
+	uint64_t replays = 0;
+	uint64_t replayedFrames = 0;
+	uint64_t replayedBytes = 0;
+	// Joining viewers that got only the cached keyframe because the GOP was
+	// incomplete or too far along to catch up.
+	uint64_t stillFallbacks = 0;
+	// GOPs that outgrew maxBytes.
+	uint64_t overflows = 0;
+};
+
+struct GopCacheFrame {
+	std::shared_ptr<const std::vector<uint8_t>> payload;
+	uint32_t timestamp = 0;
+	bool keyframe = false;
+};
+
+// Holds the encoded frames of the current GOP, from the latest keyframe
+// through the newest frame sent to live viewers, so a viewer joining mid-GOP
+// can be replayed the whole prediction chain and start on moving video rather
+// than a still keyframe. Frames are shared, so a replay never copies payloads.
+// Not synchronized: the owner serializes it with the live fan-out, which is
+// what makes a replay end exactly where the next live frame continues.
+class GopCache
+{
+public:
+	explicit GopCache(GopCacheConfig config = {});
+
+	void configure(const GopCacheConfig &config);
+	const GopCacheConfig &config() const noexcept { return config_; }
+
+	// Records a frame that has just been sent to live viewers. A keyframe
+	// starts a new GOP; deltas extend the current one.
+	void append(std::shared_ptr<const std::vector<uint8_t>> payload, uint32_t timestamp, bool keyframe);
+	// A live frame never reached the cache, so the chain is broken until the
+	// next keyframe.
+	void invalidate();
+	void clear();
+
+	// Whether the cache holds an unbroken chain from a keyframe to the newest
+	// live frame.
+	bool complete() const noexcept { return complete_ && !frames_.empty(); }
+	size_t frameCount() const noexcept { return frames_.size(); }
+	size_t byteCount() const noexcept { return bytes_; }
+	uint64_t overflows() const noexcept { return overflows_; }
+
+	// The frames to replay to a viewer joining now, or none when the chain is
+	// incomplete or catching up would exceed maxCatchUpMs.
+	std::vector<GopCacheFrame> replayFrames(uint64_t pacerBitsPerSecond, uint64_t encoderBitsPerSecond) const;
+
+private:
+	GopCacheConfig config_;
+	std::vector<GopCacheFrame> frames_;
+	size_t bytes_ = 0;
+	bool complete_ = false;
+	uint64_t overflows_ = 0;
+};
+
+} // namespace vdoninja
@@ -0,0 +1,142 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Single-pass H.264 access unit NAL index
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-h264-nal-index.h"
+
+#include <cstring>
+
+namespace vdoninja
+{
+
+size_t findH264StartCode(const uint8_t *data, size_t size, size_t from, size_t &length)
+{
+	length = 0;
+	if (!data || from >= size) {
+		return size;
+	}
+
+	// The 0x01 of a start code beginning at from sits at from + 2 or later.
+	size_t search = from + 2;
+	while (search < size) {
+		const void *found = std::memchr(data + search, 0x01, size - search);
+		if (!found) {
+			break;
+		}
+		const size_t one = static_cast<size_t>(static_cast<const uint8_t *>(found) - data);
+		if (data[one - 1] == 0x00 && data[one - 2] == 0x00) {
+			if (one >= from + 3 && data[one - 3] == 0x00) {
+				length = 4;
+				return one - 3;
+			}
+			length = 3;
+			return one - 2;
+		}
+		search = one + 1;
+	}
+	return size;
+}
+
+bool H264NalIndex::build(const uint8_t *data, size_t size)
+{
+	clear();
+	if (!data || size == 0) {
+		return false;
+	}
+	if (buildAnnexB(data, size)) {
+		format_ = H264NalFormat::AnnexB;
+		return true;
+	}
+	units_.clear();
+	if (buildAvcc(data, size)) {
+		format_ = H264NalFormat::Avcc;
+		return true;
+	}
+	units_.clear();
+	add(data, 0, size);
+	format_ = H264NalFormat::SingleNal;
+	return true;
+}
+
+void H264NalIndex::clear()
+{
+	units_.clear();
+	format_ = H264NalFormat::None;
+}
+
+const H264NalUnit *H264NalIndex::find(uint8_t type) const noexcept
+{
+	for (const H264NalUnit &unit : units_) {
+		if (unit.type == type) {
+			return &unit;
+		}
+	}
+	return nullptr;
+}
+
+bool H264NalIndex::buildAnnexB(const uint8_t *data, size_t size)
+{
+	size_t startCodeLength = 0;
+	size_t start = findH264StartCode(data, size, 0, startCodeLength);
+	if (start == size) {
+		return false;
+	}
+
+	while (start < size) {
+		const size_t nalStart = start + startCodeLength;
+		size_t nextStartCodeLength = 0;
+		const size_t nextStart = findH264StartCode(data, size, nalStart, nextStartCodeLength);
+		size_t nalEnd = nextStart;
+		// Trim alignment zeros before the next start code.
+		while (nalEnd > nalStart && data[nalEnd - 1] == 0x00) {
+			--nalEnd;
+		}
+		if (nalEnd > nalStart) {
+			add(data, nalStart, nalEnd - nalStart);
+		}
+		if (nextStart == size) {
+			break;
+		}
+		start = nextStart;
+		startCodeLength = nextStartCodeLength;
+	}
+	return !units_.empty();
+}
+
+bool H264NalIndex::buildAvcc(const uint8_t *data, size_t size)
+{
+	if (size < 4) {
+		return false;
+	}
+
+	size_t offset = 0;
+	while (offset + 4 <= size) {
+		const uint32_t nalSize =
+		    (static_cast<uint32_t>(data[offset]) << 24) | (static_cast<uint32_t>(data[offset + 1]) << 16) |
+		    (static_cast<uint32_t>(data[offset + 2]) << 8) | static_cast<uint32_t>(data[offset + 3]);
+		offset += 4;
+		if (nalSize == 0) {
+			continue;
+		}
+		if (nalSize > size - offset) {
+			return false;
+		}
+		add(data, offset, nalSize);
+		offset += nalSize;
+	}
+	return offset == size && !units_.empty();
+}
+
+void H264NalIndex::add(const uint8_t *data, size_t offset, size_t size)
+{
+	H264NalUnit unit;
+	unit.offset = offset;
+	unit.size = size;
+	unit.type = static_cast<uint8_t>(data[offset] & 0x1FU);
+	unit.refIdc = static_cast<uint8_t>((data[offset] >> 5U) & 0x03U);
+	units_.push_back(unit);
+}
+
+} // namespace vdoninja
@@ -0,0 +1,73 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Single-pass H.264 access unit NAL index
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vdoninja
+{
+
+constexpr uint8_t kH264NalTypeNonIdrSlice = 1;
+constexpr uint8_t kH264NalTypeIdrSlice = 5;
+constexpr uint8_t kH264NalTypeSei = 6;
+constexpr uint8_t kH264NalTypeSps = 7;
+
+struct H264NalUnit {
+	// Offset of the NAL header from the start of the access unit, so the
+	// index stays valid for any copy of the same bytes.
+	size_t offset = 0;
+	size_t size = 0;
+	uint8_t type = 0;
+	uint8_t refIdc = 0;
+};
+
+enum class H264NalFormat {
+	None,
+	AnnexB,
+	// 4-byte length-prefixed NAL units.
+	Avcc,
+	// Neither parsed; the whole buffer is taken as one NAL unit.
+	SingleNal,
+};
+
+// Position of the first 00 00 01 or 00 00 00 01 start code beginning at or
+// after from, with its length; size when there is none. memchr finds each
+// 0x01 byte with the C runtime's vectorized search and only those are checked
+// for the leading zeros, instead of comparing every byte.
+size_t findH264StartCode(const uint8_t *data, size_t size, size_t from, size_t &length);
+
+// Every NAL unit of one access unit, found in one pass over the bytes. The
+// publisher builds it once per encoded frame; recovery point detection,
+// profile-level-id derivation and the packetizer for every viewer read it
+// instead of rescanning the payload.
+class H264NalIndex
+{
+public:
+	// Tries Annex B, then AVCC, then falls back to one NAL unit; the order the
+	// packetizer has always used. Trailing zero bytes before an Annex B start
+	// code are not part of the preceding unit. False only for empty input.
+	bool build(const uint8_t *data, size_t size);
+	void clear();
+
+	const std::vector<H264NalUnit> &units() const noexcept { return units_; }
+	H264NalFormat format() const noexcept { return format_; }
+	bool empty() const noexcept { return units_.empty(); }
+	// The first unit of that type, or nullptr.
+	const H264NalUnit *find(uint8_t type) const noexcept;
+
+private:
+	bool buildAnnexB(const uint8_t *data, size_t size);
+	bool buildAvcc(const uint8_t *data, size_t size);
+	void add(const uint8_t *data, size_t offset, size_t size);
+
+	std::vector<H264NalUnit> units_;
+	H264NalFormat format_ = H264NalFormat::None;
+};
+
+} // namespace vdoninja
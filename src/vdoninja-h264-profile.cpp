@@ -28,75 +28,16 @@ std::optional<std::string> profileLevelIdFromSps(const uint8_t *nal, size_t size
 	return std::string(value);
 }
 
-uint32_t readU32(const uint8_t *data)
-{
-	return (static_cast<uint32_t>(data[0]) << 24U) | (static_cast<uint32_t>(data[1]) << 16U) |
-	       (static_cast<uint32_t>(data[2]) << 8U) | static_cast<uint32_t>(data[3]);
-}
-
-bool startCodeAt(const uint8_t *data, size_t size, size_t offset, size_t &length)
-{
-	length = 0;
-	if (offset + 3 <= size && data[offset] == 0 && data[offset + 1] == 0 && data[offset + 2] == 1) {
-		length = 3;
-		return true;
-	}
-	if (offset + 4 <= size && data[offset] == 0 && data[offset + 1] == 0 && data[offset + 2] == 0 &&
-	    data[offset + 3] == 1) {
-		length = 4;
-		return true;
-	}
-	return false;
-}
-
-std::optional<std::string> fromAnnexB(const uint8_t *data, size_t size)
-{
-	for (size_t offset = 0; offset < size;) {
-		size_t startCodeLength = 0;
-		if (!startCodeAt(data, size, offset, startCodeLength)) {
-			++offset;
-			continue;
-		}
-		const size_t nalStart = offset + startCodeLength;
-		if (nalStart >= size) {
-			return std::nullopt;
-		}
-		size_t nalEnd = nalStart;
-		while (nalEnd < size) {
-			size_t ignoredLength = 0;
-			if (startCodeAt(data, size, nalEnd, ignoredLength)) {
-				break;
-			}
-			++nalEnd;
-		}
-		if (const auto value = profileLevelIdFromSps(data + nalStart, nalEnd - nalStart)) {
-			return value;
-		}
-		offset = nalEnd;
-	}
-	return std::nullopt;
-}
+} // namespace
 
-std::optional<std::string> fromLengthPrefixedAvcc(const uint8_t *data, size_t size)
+std::optional<std::string> deriveH264ProfileLevelId(const uint8_t *data, size_t size)
 {
-	size_t offset = 0;
-	while (offset + 4 <= size) {
-		const uint32_t nalBytes = readU32(data + offset);
-		offset += 4;
-		if (nalBytes == 0 || nalBytes > size - offset) {
-			return std::nullopt;
-		}
-		if (const auto value = profileLevelIdFromSps(data + offset, nalBytes)) {
-			return value;
-		}
-		offset += nalBytes;
-	}
-	return std::nullopt;
+	H264NalIndex index;
+	index.build(data, size);
+	return deriveH264ProfileLevelId(data, size, index);
 }
 
-} // namespace
-
-std::optional<std::string> deriveH264ProfileLevelId(const uint8_t *data, size_t size)
+std::optional<std::string> deriveH264ProfileLevelId(const uint8_t *data, size_t size, const H264NalIndex &index)
 {
 	if (!data || size < 4) {
 		return std::nullopt;
@@ -110,13 +51,15 @@ std::optional<std::string> deriveH264ProfileLevelId(const uint8_t *data, size_t
 		return std::string(value);
 	}
 
-	if (const auto value = fromAnnexB(data, size)) {
-		return value;
-	}
-	if (const auto value = fromLengthPrefixedAvcc(data, size)) {
-		return value;
+	for (const H264NalUnit &unit : index.units()) {
+		if (unit.type != kH264NalTypeSps) {
+			continue;
+		}
+		if (const auto value = profileLevelIdFromSps(data + unit.offset, unit.size)) {
+			return value;
+		}
 	}
-	return profileLevelIdFromSps(data, size);
+	return std::nullopt;
 }
 
 std::string fallbackH264ProfileLevelId(uint32_t width, uint32_t height, uint32_t fpsNumerator, uint32_t fpsDenominator)
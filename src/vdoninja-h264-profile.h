@@ -11,6 +11,8 @@
 #include <optional>
 #include <string>
 
+#include "vdoninja-h264-nal-index.h"
+
 namespace vdoninja
 {
 
@@ -18,6 +20,8 @@ namespace vdoninja
 // Annex-B, 4-byte length-prefixed AVCC, a decoder configuration record, or a
 // single SPS NAL unit.
 std::optional<std::string> deriveH264ProfileLevelId(const uint8_t *data, size_t size);
+// The same, reading the SPS from an index already built over data.
+std::optional<std::string> deriveH264ProfileLevelId(const uint8_t *data, size_t size, const H264NalIndex &index);
 
 // Used only until real SPS bytes are available. The fallback advertises
 // constrained baseline with the first H.264 level whose frame-size and
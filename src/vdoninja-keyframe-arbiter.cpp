@@ -0,0 +1,145 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Coalesces viewer keyframe requests into rate-limited encoder keyframes
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-keyframe-arbiter.h"
+
+#include <algorithm>
+
+namespace vdoninja
+{
+
+KeyframeRequestArbiter::KeyframeRequestArbiter(KeyframeArbiterConfig config) : config_(config) {}
+
+void KeyframeRequestArbiter::configure(const KeyframeArbiterConfig &config)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	config_ = config;
+	resetLocked();
+}
+
+void KeyframeRequestArbiter::noteRequest(const std::string &uuid, bool awaitingLiveKeyframe, int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	stats_.requests++;
+	// Anything already pending, or a forced keyframe still on its way, answers
+	// this request too.
+	if (!pending_.empty() || (forceIssued_ && lastForceMs_ > lastKeyframeMs_)) {
+		stats_.coalescedRequests++;
+	}
+	auto inserted = pending_.emplace(uuid, PendingRequest{nowMs, awaitingLiveKeyframe});
+	if (!inserted.second && awaitingLiveKeyframe) {
+		inserted.first->second.awaitingLiveKeyframe = true;
+	}
+}
+
+KeyframeArbiterDecision KeyframeRequestArbiter::poll(int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	KeyframeArbiterDecision decision;
+	if (pending_.empty() || (lastForceMs_ != 0 && nowMs - lastForceMs_ < config_.minForcedIntervalMs)) {
+		return decision;
+	}
+
+	if (scheduledIntervalMs_ > 0 && lastKeyframeMs_ != 0) {
+		const int64_t untilScheduledMs = lastKeyframeMs_ + scheduledIntervalMs_ - nowMs;
+		if (untilScheduledMs >= 0 && untilScheduledMs <= config_.scheduledKeyframeMarginMs) {
+			return decision;
+		}
+	}
+
+	bool due = false;
+	for (const auto &entry : pending_) {
+		if (entry.second.awaitingLiveKeyframe || nowMs - entry.second.firstRequestMs >= config_.refreshGraceMs) {
+			due = true;
+			break;
+		}
+	}
+	if (!due) {
+		return decision;
+	}
+
+	std::vector<std::pair<std::string, PendingRequest>> ordered(pending_.begin(), pending_.end());
+	std::sort(ordered.begin(), ordered.end(), [](const auto &a, const auto &b) {
+		if (a.second.awaitingLiveKeyframe != b.second.awaitingLiveKeyframe) {
+			return a.second.awaitingLiveKeyframe;
+		}
+		return a.second.firstRequestMs < b.second.firstRequestMs;
+	});
+	decision.force = true;
+	decision.viewers.reserve(ordered.size());
+	for (auto &entry : ordered) {
+		decision.viewers.push_back(std::move(entry.first));
+	}
+	lastForceMs_ = nowMs;
+	forceIssued_ = false;
+	return decision;
+}
+
+void KeyframeRequestArbiter::noteForceResult(bool issued)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	forceIssued_ = issued;
+	if (issued) {
+		stats_.forcedKeyframes++;
+	}
+}
+
+void KeyframeRequestArbiter::noteKeyframe(int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (const auto &entry : pending_) {
+		stats_.requestToKeyframeUs.record(
+		    static_cast<uint64_t>(std::max<int64_t>(0, nowMs - entry.second.firstRequestMs)) * 1000ULL);
+	}
+	pending_.clear();
+
+	// A keyframe following a forced one is not the encoder's schedule, so it
+	// does not update the cadence used to predict the next scheduled keyframe.
+	const bool forced = forceIssued_ && lastForceMs_ > lastKeyframeMs_;
+	if (!forced && lastKeyframeMs_ != 0 && nowMs > lastKeyframeMs_) {
+		scheduledIntervalMs_ = nowMs - lastKeyframeMs_;
+	}
+	forceIssued_ = false;
+	lastKeyframeMs_ = nowMs;
+}
+
+void KeyframeRequestArbiter::removeViewer(const std::string &uuid)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pending_.erase(uuid);
+}
+
+size_t KeyframeRequestArbiter::pendingViewers() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_.size();
+}
+
+KeyframeArbiterStats KeyframeRequestArbiter::takeStats()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	KeyframeArbiterStats stats = stats_;
+	stats_ = KeyframeArbiterStats{};
+	return stats;
+}
+
+void KeyframeRequestArbiter::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	resetLocked();
+}
+
+void KeyframeRequestArbiter::resetLocked()
+{
+	pending_.clear();
+	lastKeyframeMs_ = 0;
+	scheduledIntervalMs_ = 0;
+	lastForceMs_ = 0;
+	forceIssued_ = false;
+	stats_ = KeyframeArbiterStats{};
+}
+
+} // namespace vdoninja
@@ -0,0 +1,94 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Coalesces viewer keyframe requests into rate-limited encoder keyframes
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "vdoninja-latency-histogram.h"
+
+namespace vdoninja
+{
+
+struct KeyframeArbiterConfig {
+	// At most one forced keyframe per interval, however many viewers ask.
+	int64_t minForcedIntervalMs = 1000;
+	// No keyframe is forced when the encoder's next scheduled one is due
+	// within this margin.
+	int64_t scheduledKeyframeMarginMs = 200;
+	// Viewers that are still decoding live video only ask for a refresh; they
+	// wait this long for the scheduled keyframe before one is forced. Viewers
+	// whose keyframe gate is holding back live video do not wait.
+	int64_t refreshGraceMs = 1000;
+};
+
+struct KeyframeArbiterStats {
+	uint64_t requests = 0;
+	// Requests answered by a keyframe that was already pending.
+	uint64_t coalescedRequests = 0;
+	uint64_t forcedKeyframes = 0;
+	// Per viewer, from its first unanswered request to the next keyframe.
+	LatencyHistogramSnapshot requestToKeyframeUs;
+};
+
+struct KeyframeArbiterDecision {
+	bool force = false;
+	// Viewers the keyframe answers: those awaiting a live keyframe first, then
+	// by the age of their request.
+	std::vector<std::string> viewers;
+};
+
+// Viewer PLI/FIR and data-channel keyframe requests arrive on many threads,
+// often as a storm from every viewer behind one lossy link. The arbiter folds
+// them into at most one forced encoder keyframe per interval and lets the
+// encoder's own schedule answer them when its next keyframe is close anyway.
+// Internally synchronized.
+class KeyframeRequestArbiter
+{
+public:
+	explicit KeyframeRequestArbiter(KeyframeArbiterConfig config = {});
+
+	// Replaces the configuration and forgets all state.
+	void configure(const KeyframeArbiterConfig &config);
+
+	void noteRequest(const std::string &uuid, bool awaitingLiveKeyframe, int64_t nowMs);
+	// Whether to force a keyframe now. A forcing decision claims the interval,
+	// so concurrent callers cannot both force; report the outcome through
+	// noteForceResult().
+	KeyframeArbiterDecision poll(int64_t nowMs);
+	void noteForceResult(bool issued);
+	// The encoder produced a keyframe; every pending request is answered.
+	void noteKeyframe(int64_t nowMs);
+	void removeViewer(const std::string &uuid);
+
+	size_t pendingViewers() const;
+	KeyframeArbiterStats takeStats();
+	void reset();
+
+private:
+	struct PendingRequest {
+		int64_t firstRequestMs = 0;
+		bool awaitingLiveKeyframe = false;
+	};
+
+	void resetLocked();
+
+	mutable std::mutex mutex_;
+	KeyframeArbiterConfig config_;
+	std::map<std::string, PendingRequest> pending_;
+	int64_t lastKeyframeMs_ = 0;
+	// Gap between the last two keyframes the encoder scheduled itself.
+	int64_t scheduledIntervalMs_ = 0;
+	int64_t lastForceMs_ = 0;
+	bool forceIssued_ = false;
+	KeyframeArbiterStats stats_;
+};
+
+} // namespace vdoninja
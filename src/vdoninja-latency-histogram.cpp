@@ -0,0 +1,126 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Lock-free log-linear latency histograms for publish pipeline stages
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-latency-histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr uint64_t kSubBucketCount = uint64_t{1} << kLatencyHistogramSubBucketBits;
+
+unsigned highestBitIndex(uint64_t value) noexcept
+{
+	unsigned index = 0;
+	for (unsigned step = 32; step != 0; step >>= 1) {
+		if (value >> step) {
+			value >>= step;
+			index += step;
+		}
+	}
+	return index;
+}
+
+} // namespace
+
+size_t latencyHistogramBucketIndex(uint64_t valueUs) noexcept
+{
+	if (valueUs < kSubBucketCount) {
+		return static_cast<size_t>(valueUs);
+	}
+	const unsigned shift = highestBitIndex(valueUs) - static_cast<unsigned>(kLatencyHistogramSubBucketBits);
+	const uint64_t subBucket = (valueUs >> shift) & (kSubBucketCount - 1U);
+	const uint64_t index = (static_cast<uint64_t>(shift) + 1U) * kSubBucketCount + subBucket;
+	return static_cast<size_t>(std::min<uint64_t>(index, kLatencyHistogramBucketCount - 1U));
+}
+
+uint64_t latencyHistogramBucketUpperBoundUs(size_t index) noexcept
+{
+	if (index < kSubBucketCount) {
+		return static_cast<uint64_t>(index);
+	}
+	const uint64_t shift = static_cast<uint64_t>(index) / kSubBucketCount - 1U;
+	const uint64_t lower = (kSubBucketCount + static_cast<uint64_t>(index) % kSubBucketCount) << shift;
+	return lower + (uint64_t{1} << shift) - 1U;
+}
+
+uint64_t elapsedMicroseconds(std::chrono::steady_clock::time_point end,
+                             std::chrono::steady_clock::time_point start) noexcept
+{
+	if (end <= start) {
+		return 0;
+	}
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+void LatencyHistogramSnapshot::record(uint64_t valueUs) noexcept
+{
+	++buckets[latencyHistogramBucketIndex(valueUs)];
+	++count;
+	totalUs += valueUs;
+	maxUs = std::max(maxUs, valueUs);
+}
+
+void LatencyHistogramSnapshot::merge(const LatencyHistogramSnapshot &other) noexcept
+{
+	for (size_t i = 0; i < buckets.size(); ++i) {
+		buckets[i] += other.buckets[i];
+	}
+	count += other.count;
+	totalUs += other.totalUs;
+	maxUs = std::max(maxUs, other.maxUs);
+}
+
+uint64_t LatencyHistogramSnapshot::percentileUs(double q) const noexcept
+{
+	if (count == 0) {
+		return 0;
+	}
+	q = std::clamp(q, 0.0, 1.0);
+	const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < buckets.size(); ++i) {
+		seen += buckets[i];
+		if (seen >= rank) {
+			// The last bucket is open-ended, so only maxUs bounds it.
+			if (i + 1 == buckets.size()) {
+				return maxUs;
+			}
+			return std::min(latencyHistogramBucketUpperBoundUs(i), maxUs);
+		}
+	}
+	return maxUs;
+}
+
+void LatencyHistogram::record(uint64_t valueUs) noexcept
+{
+	buckets_[latencyHistogramBucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+	totalUs_.fetch_add(valueUs, std::memory_order_relaxed);
+	uint64_t current = maxUs_.load(std::memory_order_relaxed);
+	while (valueUs > current && !maxUs_.compare_exchange_weak(current, valueUs, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogramSnapshot LatencyHistogram::snapshot(bool resetInterval) noexcept
+{
+	LatencyHistogramSnapshot snapshot;
+	for (size_t i = 0; i < buckets_.size(); ++i) {
+		snapshot.buckets[i] = resetInterval ? buckets_[i].exchange(0, std::memory_order_relaxed)
+		                                    : buckets_[i].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.buckets[i];
+	}
+	snapshot.totalUs =
+	    resetInterval ? totalUs_.exchange(0, std::memory_order_relaxed) : totalUs_.load(std::memory_order_relaxed);
+	snapshot.maxUs =
+	    resetInterval ? maxUs_.exchange(0, std::memory_order_relaxed) : maxUs_.load(std::memory_order_relaxed);
+	return snapshot;
+}
+
+} // namespace vdoninja
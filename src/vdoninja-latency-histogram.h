@@ -0,0 +1,65 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Lock-free log-linear latency histograms for publish pipeline stages
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vdoninja
+{
+
+// Values are microseconds. Each power of two is split into eight linear
+// sub-buckets, so any reported percentile is within 12.5% of the recorded
+// value. 192 buckets cover roughly 67 seconds; anything longer lands in the
+// last bucket and is still reflected exactly by maxUs.
+constexpr size_t kLatencyHistogramSubBucketBits = 3;
+constexpr size_t kLatencyHistogramBucketCount = 192;
+
+size_t latencyHistogramBucketIndex(uint64_t valueUs) noexcept;
+uint64_t latencyHistogramBucketUpperBoundUs(size_t index) noexcept;
+// Microseconds from start to end, for recording; 0 if end is not after start.
+uint64_t elapsedMicroseconds(std::chrono::steady_clock::time_point end,
+                             std::chrono::steady_clock::time_point start) noexcept;
+
+struct LatencyHistogramSnapshot {
+	std::array<uint64_t, kLatencyHistogramBucketCount> buckets{};
+	uint64_t count = 0;
+	uint64_t totalUs = 0;
+	uint64_t maxUs = 0;
+
+	void record(uint64_t valueUs) noexcept;
+	void merge(const LatencyHistogramSnapshot &other) noexcept;
+	// q in [0, 1]. Returns the upper edge of the bucket holding the q-th
+	// sample, clamped to the largest recorded value; 0 when empty.
+	uint64_t percentileUs(double q) const noexcept;
+	uint64_t meanUs() const noexcept { return count ? totalUs / count : 0; }
+};
+
+// Multi-writer histogram for hot paths. record() is a handful of relaxed
+// atomic adds with no allocation or locking, so it is cheap enough to stay
+// enabled in production. snapshot(true) drains the interval; a sample racing
+// with a drain may be split across adjacent intervals but is never counted twice.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram() = default;
+	LatencyHistogram(const LatencyHistogram &) = delete;
+	LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+	void record(uint64_t valueUs) noexcept;
+	LatencyHistogramSnapshot snapshot(bool resetInterval = false) noexcept;
+
+private:
+	std::array<std::atomic<uint64_t>, kLatencyHistogramBucketCount> buckets_{};
+	std::atomic<uint64_t> totalUs_{0};
+	std::atomic<uint64_t> maxUs_{0};
+};
+
+} // namespace vdoninja
@@ -43,4 +43,27 @@ std::vector<LayoutRect> buildGridLayout(size_t itemCount, uint32_t canvasWidth,
 	return layout;
 }
 
+LayoutPlacement placementForRect(const LayoutRect &rect, uint32_t sourceWidth, uint32_t sourceHeight)
+{
+	const float width = sourceWidth == 0 ? rect.width : static_cast<float>(sourceWidth);
+	const float height = sourceHeight == 0 ? rect.height : static_cast<float>(sourceHeight);
+
+	LayoutPlacement placement;
+	placement.x = rect.x;
+	placement.y = rect.y;
+	placement.scaleX = width > 0.0f ? rect.width / width : 1.0f;
+	placement.scaleY = height > 0.0f ? rect.height / height : 1.0f;
+	return placement;
+}
+
+bool layoutPlacementChanged(const LayoutPlacement &current, const LayoutPlacement &target)
+{
+	constexpr float kPositionTolerance = 0.5f;
+	constexpr float kScaleTolerance = 0.0005f;
+	return std::fabs(current.x - target.x) > kPositionTolerance ||
+	       std::fabs(current.y - target.y) > kPositionTolerance ||
+	       std::fabs(current.scaleX - target.scaleX) > kScaleTolerance ||
+	       std::fabs(current.scaleY - target.scaleY) > kScaleTolerance;
+}
+
 } // namespace vdoninja
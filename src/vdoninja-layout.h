@@ -19,6 +19,21 @@ struct LayoutRect {
 	float height = 0.0f;
 };
 
+struct LayoutPlacement {
+	float x = 0.0f;
+	float y = 0.0f;
+	float scaleX = 1.0f;
+	float scaleY = 1.0f;
+};
+
 std::vector<LayoutRect> buildGridLayout(size_t itemCount, uint32_t canvasWidth, uint32_t canvasHeight);
 
+// Position and scale that stretch a sourceWidth x sourceHeight source over rect.
+// A zero source dimension is treated as already matching the rect.
+LayoutPlacement placementForRect(const LayoutRect &rect, uint32_t sourceWidth, uint32_t sourceHeight);
+
+// Whether an item sitting at current has to be moved to reach target. Sub-pixel
+// drift is ignored so a relayout leaves untouched items alone.
+bool layoutPlacementChanged(const LayoutPlacement &current, const LayoutPlacement &target);
+
 } // namespace vdoninja
@@ -17,9 +17,11 @@
 
 #include <util/config-file.h>
 #include <util/dstr.h>
+#include <util/platform.h>
 #include <util/threading.h>
 
 #include "plugin-main.h"
+#include "vdoninja-decode-budget.h"
 #include "vdoninja-h264-profile.h"
 #include "vdoninja-utils.h"
 
@@ -31,6 +33,15 @@ namespace
 
 constexpr size_t kMaxQueuedMediaFrames = 240;
 constexpr int kRemoteStatsIntervalMs = 3000;
+// One-shot stats requests arriving within this window reuse the last document.
+constexpr int64_t kRemoteStatsDocumentMaxAgeMs = 1000;
+
+RemoteStatsPublisher::Limits remoteStatsLimits()
+{
+	RemoteStatsPublisher::Limits limits;
+	limits.intervalMs = kRemoteStatsIntervalMs;
+	return limits;
+}
 
 // The service clamps the encoder to a 2s keyframe interval, so a sustained gap
 // well past that means the cap was bypassed (for example via the advanced
@@ -51,6 +62,12 @@ int64_t steadyTimeMs()
 	    .count();
 }
 
+int64_t steadyTimeUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
 void updateAtomicMaximum(std::atomic<uint64_t> &target, uint64_t value)
 {
 	uint64_t current = target.load(std::memory_order_relaxed);
@@ -158,6 +175,22 @@ bool looksLikeJsonContainer(const std::string &value)
 	return normalized.front() == '{' || normalized.front() == '[';
 }
 
+double microsecondsToMs(uint64_t valueUs)
+{
+	return static_cast<double>(valueUs) / 1000.0;
+}
+
+std::string latencyPercentilesJson(const LatencyHistogramSnapshot &histogram)
+{
+	JsonBuilder json;
+	json.add("count", static_cast<int64_t>(histogram.count));
+	json.add("p50", static_cast<int64_t>(histogram.percentileUs(0.50)));
+	json.add("p95", static_cast<int64_t>(histogram.percentileUs(0.95)));
+	json.add("p99", static_cast<int64_t>(histogram.percentileUs(0.99)));
+	json.add("max", static_cast<int64_t>(histogram.maxUs));
+	return json.build();
+}
+
 int hexValue(unsigned char c)
 {
 	if (c >= '0' && c <= '9') {
@@ -612,6 +645,14 @@ static obs_properties_t *vdoninja_output_properties(void *)
 	obs_property_list_add_int(layoutMode, tr("AutoInbound.Layout.Grid", "Grid"),
 	                          static_cast<int>(AutoLayoutMode::Grid));
 
+	obs_property_t *sourceType = obs_properties_add_list(props, "auto_inbound_source_type",
+	                                                     tr("AutoInbound.SourceType", "Inbound Source Type"),
+	                                                     OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(sourceType, tr("AutoInbound.SourceType.Browser", "Browser Source"),
+	                          static_cast<int>(AutoInboundSourceType::Browser));
+	obs_property_list_add_int(sourceType, tr("AutoInbound.SourceType.Native", "Native Receiver (Experimental)"),
+	                          static_cast<int>(AutoInboundSourceType::Native));
+
 	obs_properties_t *advanced = obs_properties_create();
 	obs_property_t *wssHost =
 	    obs_properties_add_text(advanced, "wss_host", tr("SignalingServer", "Signaling Server"), OBS_TEXT_DEFAULT);
@@ -678,6 +719,49 @@ static obs_properties_t *vdoninja_output_properties(void *)
 	       "restored when streaming stops."));
 	obs_properties_add_int(advanced, "adaptive_bitrate_min",
 	                       tr("AdaptiveBitrate.Minimum", "Minimum Adaptive Bitrate (kbps)"), 100, 10000, 100);
+	obs_property_t *adaptiveLoss = obs_properties_add_bool(
+	    advanced, "adaptive_bitrate_loss", tr("AdaptiveBitrate.Loss", "Adaptive Bitrate Backs Off on Loss and RTT"));
+	obs_property_set_long_description(
+	    adaptiveLoss,
+	    tr("AdaptiveBitrate.Loss.Description",
+	       "Also use each viewer's receiver reports: above about 10% packet loss, or while round-trip time keeps "
+	       "rising, that viewer's target drops below its REMB estimate. The lowest viewer target still controls "
+	       "the encoder."));
+	obs_property_t *qualityLadder = obs_properties_add_text(
+	    advanced, "quality_ladder", tr("QualityLadder", "Adaptive Resolution Ladder (Experimental)"), OBS_TEXT_DEFAULT);
+	obs_property_set_long_description(
+	    qualityLadder,
+	    tr("QualityLadder.Description",
+	       "Lower resolution and frame rate as adaptive bitrate falls, for example \"1500:720p30, 700:540p30\" "
+	       "sends 720p at 30 fps below 1500 kbps and 540p below 700 kbps. Each rung is its own encoder that runs "
+	       "for the whole session, even while unused, so every rung adds a full encode at its resolution on top "
+	       "of the configured one. Viewers switch on that encoder's next keyframe. Leave empty, the default, to "
+	       "run one encoder."));
+	obs_property_t *warmConnections = obs_properties_add_int(
+	    advanced, "warm_viewer_connections", tr("WarmViewerConnections", "Pre-warmed Viewer Connections"), 0, 10, 1);
+	obs_property_set_long_description(
+	    warmConnections,
+	    tr("WarmViewerConnections.Description",
+	       "Keep up to this many viewer connections prepared with ICE candidates already gathered, so guests "
+	       "added in a burst start faster. The pool grows with the recent join rate. 0 disables it."));
+	obs_property_t *gopFastStart =
+	    obs_properties_add_bool(advanced, "gop_fast_start", tr("GopFastStart", "Fast Viewer Start"));
+	obs_property_set_long_description(
+	    gopFastStart,
+	    tr("GopFastStart.Description",
+	       "Keep the current group of pictures and replay it to viewers who join mid-GOP, so their video starts "
+	       "moving right away instead of showing a still image until the next keyframe. The replay briefly runs "
+	       "ahead of the bitrate to catch up with the live stream and is skipped when catching up would take "
+	       "too long."));
+	obs_property_t *intraRefresh =
+	    obs_properties_add_bool(advanced, "intra_refresh", tr("IntraRefresh", "Intra Refresh (Experimental, x264)"));
+	obs_property_set_long_description(
+	    intraRefresh,
+	    tr("IntraRefresh.Description",
+	       "Ask x264 to refresh the picture gradually across each keyframe interval instead of sending a large "
+	       "keyframe every interval, which removes the periodic bitrate spike on tight uplinks. New viewers get "
+	       "the cached keyframe and then join at the next refresh, so their picture fills in over up to two "
+	       "seconds. Other encoders keep periodic keyframes."));
 	obs_properties_add_group(props, "advanced", tr("AdvancedSettings", "Advanced Settings"), OBS_GROUP_NORMAL,
 	                         advanced);
 
@@ -708,6 +792,11 @@ static void vdoninja_output_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "audio_red", false);
 	obs_data_set_default_bool(settings, "adaptive_bitrate", false);
 	obs_data_set_default_int(settings, "adaptive_bitrate_min", 500);
+	obs_data_set_default_bool(settings, "adaptive_bitrate_loss", false);
+	obs_data_set_default_string(settings, "quality_ladder", "");
+	obs_data_set_default_int(settings, "warm_viewer_connections", 0);
+	obs_data_set_default_bool(settings, "gop_fast_start", true);
+	obs_data_set_default_bool(settings, "intra_refresh", false);
 	obs_data_set_default_bool(settings, "auto_inbound_enabled", false);
 	obs_data_set_default_string(settings, "auto_inbound_room_id", "");
 	obs_data_set_default_string(settings, "auto_inbound_password", "");
@@ -717,6 +806,7 @@ static void vdoninja_output_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "auto_inbound_remove_on_disconnect", true);
 	obs_data_set_default_bool(settings, "auto_inbound_switch_scene", false);
 	obs_data_set_default_int(settings, "auto_inbound_layout_mode", static_cast<int>(AutoLayoutMode::Grid));
+	obs_data_set_default_int(settings, "auto_inbound_source_type", static_cast<int>(AutoInboundSourceType::Browser));
 	obs_data_set_default_int(settings, "auto_inbound_width", 1920);
 	obs_data_set_default_int(settings, "auto_inbound_height", 1080);
 }
@@ -737,10 +827,15 @@ static int vdoninja_output_connect_time(void *data)
 	});
 }
 
-// Output info structure
+// Output info structure. The flags are registered once with the module, and
+// libobs refuses video encoders on tracks above 0 unless the output declares
+// OBS_OUTPUT_MULTI_TRACK_VIDEO, so the quality ladder needs it set statically.
+// Each start unbinds those tracks first, leaving only track 0 bound when the
+// ladder is empty; libobs then starts, hooks and interleaves that one encoder
+// exactly as it would for a single-track output.
 obs_output_info vdoninja_output_info = {
     .id = "vdoninja_output",
-    .flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_SERVICE,
+    .flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED | OBS_OUTPUT_SERVICE | OBS_OUTPUT_MULTI_TRACK_VIDEO,
     .get_name = vdoninja_output_getname,
     .create = vdoninja_output_create,
     .destroy = vdoninja_output_destroy,
@@ -759,7 +854,8 @@ obs_output_info vdoninja_output_info = {
 
 // Implementation
 
-VDONinjaOutput::VDONinjaOutput(obs_data_t *settings, obs_output_t *output) : output_(output)
+VDONinjaOutput::VDONinjaOutput(obs_data_t *settings, obs_output_t *output)
+    : output_(output), remoteStatsPublisher_(remoteStatsLimits())
 {
 	loadSettings(settings);
 
@@ -913,6 +1009,12 @@ void VDONinjaOutput::loadSettings(obs_data_t *settings)
 	settings_.enableAdaptiveBitrate = getBoolSetting("adaptive_bitrate", false);
 	const int minimumAdaptiveKbps = std::clamp(getIntSetting("adaptive_bitrate_min", 500), 100, 10000);
 	settings_.minimumAdaptiveBitrate = minimumAdaptiveKbps * 1000;
+	settings_.adaptiveBitrateMode =
+	    getBoolSetting("adaptive_bitrate_loss", false) ? BitrateControlMode::Blended : BitrateControlMode::Remb;
+	settings_.qualityLadder = getStringSetting("quality_ladder");
+	settings_.warmViewerConnections = std::clamp(getIntSetting("warm_viewer_connections", 0), 0, 10);
+	settings_.gopFastStart = getBoolSetting("gop_fast_start", true);
+	settings_.intraRefresh = getBoolSetting("intra_refresh", false);
 	settings_.enableRemote = false;
 
 	settings_.autoInbound.enabled = getBoolSetting("auto_inbound_enabled", false);
@@ -925,6 +1027,10 @@ void VDONinjaOutput::loadSettings(obs_data_t *settings)
 	settings_.autoInbound.switchToSceneOnNewStream = getBoolSetting("auto_inbound_switch_scene", false);
 	settings_.autoInbound.layoutMode =
 	    static_cast<AutoLayoutMode>(getIntSetting("auto_inbound_layout_mode", static_cast<int>(AutoLayoutMode::Grid)));
+	settings_.autoInbound.sourceType =
+	    getIntSetting("auto_inbound_source_type", 0) == static_cast<int>(AutoInboundSourceType::Native)
+	        ? AutoInboundSourceType::Native
+	        : AutoInboundSourceType::Browser;
 	settings_.autoInbound.width = getIntSetting("auto_inbound_width", 1920);
 	settings_.autoInbound.height = getIntSetting("auto_inbound_height", 1080);
 
@@ -1070,13 +1176,21 @@ std::string VDONinjaOutput::buildObsStateMessage() const
 	return msg.build();
 }
 
-std::string VDONinjaOutput::buildRemoteStatsMessage(const std::string &requestingUuid) const
+RemoteStatsDocument VDONinjaOutput::buildRemoteStatsDocument(int64_t nowMs) const
 {
-	JsonBuilder remoteStats;
-	const int64_t now = currentTimeMs();
+	RemoteStatsDocument document;
+	document.builtAtMs = nowMs;
+	std::map<std::string, PeerPublishLatencySnapshot> viewerLatency;
+	if (peerManager_) {
+		for (auto &latency : peerManager_->getPeerPublishLatencySnapshots()) {
+			std::string uuid = latency.uuid;
+			viewerLatency.emplace(std::move(uuid), std::move(latency));
+		}
+	}
+	const auto transport = getViewerTransportStats(nowMs);
 
 	for (const ViewerRuntimeSnapshot &snapshot : getViewerSnapshots()) {
-		if (snapshot.uuid.empty() || snapshot.uuid == requestingUuid) {
+		if (snapshot.uuid.empty()) {
 			continue;
 		}
 
@@ -1089,7 +1203,6 @@ std::string VDONinjaOutput::buildRemoteStatsMessage(const std::string &requestin
 		}
 
 		if (snapshot.lastStatsTimestampMs > 0) {
-			peerStats.add("lastStatsAgeMs", now - snapshot.lastStatsTimestampMs);
 			if (looksLikeJsonContainer(snapshot.lastStats)) {
 				peerStats.addRaw("reported", snapshot.lastStats);
 			} else if (!snapshot.lastStats.empty()) {
@@ -1097,12 +1210,61 @@ std::string VDONinjaOutput::buildRemoteStatsMessage(const std::string &requestin
 			}
 		}
 
-		remoteStats.addRaw(snapshot.uuid, peerStats.build());
+		const auto transportIt = transport.find(snapshot.uuid);
+		if (transportIt != transport.end()) {
+			peerStats.addRaw("transport", viewerTransportStatsJson(transportIt->second));
+		}
+
+		const auto latencyIt = viewerLatency.find(snapshot.uuid);
+		if (latencyIt != viewerLatency.end()) {
+			JsonBuilder latency;
+			latency.addRaw("pacerHold", latencyPercentilesJson(latencyIt->second.pacerHoldUs));
+			latency.addRaw("sendCall", latencyPercentilesJson(latencyIt->second.sendCallUs));
+			const RtpSharedBudgetShare &budget = latencyIt->second.sharedBudget;
+			if (budget.grantedPackets != 0) {
+				latency.addRaw("budgetWait", latencyPercentilesJson(budget.waitUs));
+			}
+			peerStats.addRaw("publishLatencyUs", latency.build());
+			if (budget.totalGrantedBytes != 0) {
+				JsonBuilder share;
+				share.add("weight", static_cast<int64_t>(budget.weight));
+				share.add("bytes", static_cast<int64_t>(budget.grantedBytes));
+				share.add("allViewerBytes", static_cast<int64_t>(budget.totalGrantedBytes));
+				peerStats.addRaw("pacerShare", share.build());
+			}
+		}
+
+		const auto &built = peerStats.entries();
+		std::map<std::string, std::string> fields(built.begin(), built.end());
+		const int64_t lastStatsAgeMs = snapshot.lastStatsTimestampMs > 0 ? nowMs - snapshot.lastStatsTimestampMs : -1;
+		document.peers.emplace(snapshot.uuid, makeRemoteStatsEntry(std::move(fields), lastStatsAgeMs));
 	}
 
-	JsonBuilder message;
-	message.addRaw("remoteStats", remoteStats.build());
-	return message.build();
+	const PublishLatencySnapshot pipeline = getPublishLatencySnapshot();
+	JsonBuilder pipelineLatency;
+	pipelineLatency.addRaw("encoderToEnqueue", latencyPercentilesJson(pipeline.encoderToEnqueueUs));
+	pipelineLatency.addRaw("queueWait", latencyPercentilesJson(pipeline.queueWaitUs));
+	pipelineLatency.addRaw("packetize", latencyPercentilesJson(pipeline.packetizeUs));
+	pipelineLatency.addRaw("pacerHold", latencyPercentilesJson(pipeline.pacerHoldUs));
+	pipelineLatency.addRaw("sendCall", latencyPercentilesJson(pipeline.sendCallUs));
+	document.pipelineJson = pipelineLatency.build();
+	return document;
+}
+
+std::shared_ptr<const RemoteStatsDocument> VDONinjaOutput::currentRemoteStatsDocument(int64_t nowMs)
+{
+	{
+		std::lock_guard<std::mutex> lock(remoteStatsMutex_);
+		if (remoteStatsDocument_ && nowMs >= remoteStatsDocument_->builtAtMs &&
+		    nowMs - remoteStatsDocument_->builtAtMs < kRemoteStatsDocumentMaxAgeMs) {
+			return remoteStatsDocument_;
+		}
+	}
+
+	auto document = std::make_shared<const RemoteStatsDocument>(buildRemoteStatsDocument(nowMs));
+	std::lock_guard<std::mutex> lock(remoteStatsMutex_);
+	remoteStatsDocument_ = document;
+	return document;
 }
 
 std::string VDONinjaOutput::buildConnectionMapMessage(const std::string &requestingUuid) const
@@ -1115,6 +1277,7 @@ std::string VDONinjaOutput::buildConnectionMapMessage(const std::string &request
 
 	const std::string localUuid = signaling_ ? signaling_->getLocalUUID() : snap.streamId;
 	const std::string label = snap.streamId.empty() ? "OBS Publisher" : snap.streamId;
+	const auto transport = getViewerTransportStats(currentTimeMs());
 	std::string connections = "[";
 	bool firstConnection = true;
 	for (const ViewerRuntimeSnapshot &viewer : getViewerSnapshots()) {
@@ -1131,12 +1294,17 @@ std::string VDONinjaOutput::buildConnectionMapMessage(const std::string &request
 		connection.add("peerStreamID", viewer.streamId.empty() ? viewer.uuid : viewer.streamId);
 		connection.add("direction", "outgoing");
 		connection.add("state", viewer.state);
-		connection.add("bandwidth", -1);
+		const auto transportIt = transport.find(viewer.uuid);
+		const ViewerTransportStats stats =
+		    transportIt != transport.end() ? transportIt->second : ViewerTransportStats{};
+		// Kbps, as the browser reports it; -1 until a rate is known.
+		connection.add("bandwidth", stats.sendBitrateBps < 0 ? int64_t{-1} : stats.sendBitrateBps / 1000);
 		connection.add("audioEnabled", viewer.audioSendEnabled);
 		connection.add("videoEnabled", viewer.videoSendEnabled);
-		connection.add("nackCount", 0);
-		connection.add("pliCount", 0);
-		connection.add("candidateType", "unknown");
+		connection.add("nackCount", static_cast<int64_t>(stats.nackCount));
+		connection.add("pliCount", static_cast<int64_t>(stats.pliCount));
+		connection.add("candidateType", stats.candidateType);
+		connection.add("rttMs", static_cast<int64_t>(stats.rttMs));
 		connection.add("hasDataChannel", viewer.hasDataChannel);
 		connections += connection.build();
 	}
@@ -1155,12 +1323,29 @@ std::string VDONinjaOutput::buildConnectionMapMessage(const std::string &request
 	return message.build();
 }
 
+std::map<std::string, ViewerTransportStats> VDONinjaOutput::getViewerTransportStats(int64_t nowMs) const
+{
+	if (!peerManager_) {
+		return {};
+	}
+	return viewerTransportStats_.get(nowMs, [this]() { return peerManager_->getViewerTransportSamples(); });
+}
+
 void VDONinjaOutput::sendRemoteStatsSnapshotToPeer(const std::string &uuid)
 {
 	if (!peerManager_ || uuid.empty()) {
 		return;
 	}
-	peerManager_->sendDataToPeer(uuid, buildRemoteStatsMessage(uuid));
+	const int64_t now = currentTimeMs();
+	const auto document = currentRemoteStatsDocument(now);
+	std::string message;
+	{
+		std::lock_guard<std::mutex> lock(remoteStatsMutex_);
+		message = remoteStatsPublisher_.answerRequest(uuid, *document, now);
+	}
+	if (!message.empty()) {
+		peerManager_->sendDataToPeer(uuid, message);
+	}
 }
 
 void VDONinjaOutput::sendRejectedControlToPeer(const std::string &uuid, const std::string &controlName)
@@ -1183,7 +1368,7 @@ void VDONinjaOutput::addRemoteStatsSubscriber(const std::string &uuid)
 	bool shouldStartWorker = false;
 	{
 		std::lock_guard<std::mutex> lock(remoteStatsMutex_);
-		remoteStatsSubscribers_.insert(uuid);
+		remoteStatsPublisher_.addSubscriber(uuid, currentTimeMs());
 		if (!remoteStatsWorkerRunning_) {
 			remoteStatsWorkerRunning_ = true;
 			shouldStartWorker = true;
@@ -1206,7 +1391,7 @@ void VDONinjaOutput::removeRemoteStatsSubscriber(const std::string &uuid)
 	}
 	{
 		std::lock_guard<std::mutex> lock(remoteStatsMutex_);
-		remoteStatsSubscribers_.erase(uuid);
+		remoteStatsPublisher_.removeSubscriber(uuid);
 	}
 	remoteStatsCv_.notify_all();
 }
@@ -1216,7 +1401,8 @@ void VDONinjaOutput::stopRemoteStatsWorker()
 	{
 		std::lock_guard<std::mutex> lock(remoteStatsMutex_);
 		remoteStatsWorkerRunning_ = false;
-		remoteStatsSubscribers_.clear();
+		remoteStatsPublisher_.clear();
+		remoteStatsDocument_.reset();
 	}
 	remoteStatsCv_.notify_all();
 
@@ -1227,25 +1413,44 @@ void VDONinjaOutput::stopRemoteStatsWorker()
 
 void VDONinjaOutput::remoteStatsThread()
 {
+	setCurrentThreadName("vdo-stats");
 	std::unique_lock<std::mutex> lock(remoteStatsMutex_);
 	while (remoteStatsWorkerRunning_) {
-		if (remoteStatsSubscribers_.empty()) {
+		if (remoteStatsPublisher_.empty()) {
 			remoteStatsCv_.wait(lock,
-			                    [this]() { return !remoteStatsWorkerRunning_ || !remoteStatsSubscribers_.empty(); });
+			                    [this]() { return !remoteStatsWorkerRunning_ || !remoteStatsPublisher_.empty(); });
+			continue;
+		}
+
+		const int64_t now = currentTimeMs();
+		const int64_t nextDue = remoteStatsPublisher_.nextDueMs();
+		if (nextDue > now) {
+			// Subscriber changes notify the cv; the loop re-reads the schedule.
+			remoteStatsCv_.wait_for(lock, std::chrono::milliseconds(nextDue - now));
 			continue;
 		}
 
-		const bool wokeForStateChange =
-		    remoteStatsCv_.wait_for(lock, std::chrono::milliseconds(kRemoteStatsIntervalMs),
-		                            [this]() { return !remoteStatsWorkerRunning_ || remoteStatsSubscribers_.empty(); });
-		if (wokeForStateChange) {
+		// One document per interval, shared by every due subscriber.
+		lock.unlock();
+		const auto document = currentRemoteStatsDocument(now);
+		lock.lock();
+
+		std::vector<std::pair<std::string, std::string>> messages;
+		for (const std::string &uuid : remoteStatsPublisher_.dueSubscribers(now)) {
+			std::string message = remoteStatsPublisher_.pushFor(uuid, *document, now);
+			if (!message.empty()) {
+				messages.emplace_back(uuid, std::move(message));
+			}
+		}
+		if (messages.empty()) {
 			continue;
 		}
 
-		std::vector<std::string> subscribers(remoteStatsSubscribers_.begin(), remoteStatsSubscribers_.end());
 		lock.unlock();
-		for (const std::string &uuid : subscribers) {
-			sendRemoteStatsSnapshotToPeer(uuid);
+		for (const auto &message : messages) {
+			if (peerManager_) {
+				peerManager_->sendDataToPeer(message.first, message.second);
+			}
 		}
 		lock.lock();
 	}
@@ -1318,6 +1523,13 @@ void VDONinjaOutput::primeViewerWithCachedKeyframe(const std::string &uuid)
 	if (!peerManager_ || uuid.empty()) {
 		return;
 	}
+	// A viewer that can be replayed the current GOP starts on moving video
+	// and needs no still image.
+	if (peerManager_->primePeerWithCachedGop(uuid)) {
+		keyframeRequestsPrimed_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
 	std::vector<uint8_t> keyframeCopy;
 	uint32_t keyframeTimestamp = 0;
 	{
@@ -1350,6 +1562,12 @@ void VDONinjaOutput::noteKeyframeRequest(const std::string &uuid, const char *tr
 		logInfo("Viewer %s requested a keyframe over %s; further requests are counted in the publish summary",
 		        uuid.c_str(), transport);
 	}
+
+	// libobs has no on-demand keyframe request for a running encoder (see
+	// kMaxStreamKeyintSec in plugin-main.cpp), so nothing is forced or
+	// prioritized here: the next scheduled keyframe answers every viewer, and
+	// the arbiter only folds repeat requests together and times the wait.
+	keyframeArbiter_.noteRequest(uuid, false, steadyTimeMs());
 }
 
 void VDONinjaOutput::startPublishSummaryWorker()
@@ -1382,6 +1600,7 @@ void VDONinjaOutput::stopPublishSummaryWorker(bool flush)
 
 void VDONinjaOutput::publishSummaryThread()
 {
+	setCurrentThreadName("vdo-summary");
 	std::unique_lock<std::mutex> lock(publishSummaryMutex_);
 	while (publishSummaryWorkerRunning_) {
 		if (lastPublishSummaryMs_ == 0) {
@@ -1401,7 +1620,13 @@ void VDONinjaOutput::publishSummaryThread()
 
 		lock.unlock();
 		maybeAdaptBitrate();
+		if (running_ && peerManager_) {
+			// Refill pre-warmed viewer connections here rather than on the
+			// signaling thread that services offer requests.
+			peerManager_->maintainWarmPublisherPool();
+		}
 		maybeLogPublishSummary();
+		publishDockStats();
 		lock.lock();
 	}
 }
@@ -1410,6 +1635,7 @@ void VDONinjaOutput::configureBitrateAdaptation(const OutputSettings &settings,
 {
 	adaptiveBitrateEnabled_ = false;
 	bitrateController_.reset();
+	blendedBitrateEstimator_.reset();
 	originalEncoderBitrate_ = std::max(encoderBitrateBitsPerSecond, 1);
 	currentEncoderBitrate_ = originalEncoderBitrate_;
 	pendingPacerBitrate_ = 0;
@@ -1435,11 +1661,45 @@ void VDONinjaOutput::configureBitrateAdaptation(const OutputSettings &settings,
 	controllerConfig.minimumBitrateBitsPerSecond =
 	    static_cast<uint64_t>(std::min(originalEncoderBitrate_, std::max(settings.minimumAdaptiveBitrate, 100000)));
 	bitrateController_ = std::make_unique<BitrateController>(controllerConfig);
+	if (settings.adaptiveBitrateMode == BitrateControlMode::Blended) {
+		blendedBitrateEstimator_ = std::make_unique<BlendedBitrateEstimator>();
+	}
 	adaptiveBitrateEnabled_ = true;
 	const char *encoderId = obs_encoder_get_id(encoder);
-	logInfo("Adaptive bitrate enabled for encoder '%s': %d-%d kbps, minimum fresh REMB across all viewers",
-	        encoderId ? encoderId : "(unknown)", static_cast<int>(controllerConfig.minimumBitrateBitsPerSecond / 1000U),
-	        originalEncoderBitrate_ / 1000);
+	logInfo("Adaptive bitrate enabled for encoder '%s': %d-%d kbps, %s", encoderId ? encoderId : "(unknown)",
+	        static_cast<int>(controllerConfig.minimumBitrateBitsPerSecond / 1000U), originalEncoderBitrate_ / 1000,
+	        blendedBitrateEstimator_ ? "lowest per-viewer target from fresh REMB, loss and RTT trend"
+	                                 : "minimum fresh REMB across all viewers");
+}
+
+void VDONinjaOutput::configureIntraRefresh(const OutputSettings &settings)
+{
+	obs_encoder_t *encoder = output_ ? obs_output_get_video_encoder(output_) : nullptr;
+	const char *encoderId = encoder ? obs_encoder_get_id(encoder) : nullptr;
+	bool x264IntraRefresh = false;
+	if (encoderId && std::strcmp(encoderId, "obs_x264") == 0) {
+		obs_data_t *encoderSettings = obs_encoder_get_settings(encoder);
+		const char *options = encoderSettings ? obs_data_get_string(encoderSettings, "x264opts") : nullptr;
+		x264IntraRefresh = options && std::strstr(options, "intra-refresh") != nullptr;
+		obs_data_release(encoderSettings);
+	}
+	// Hand-written x264 options count too: the recovery points need the same
+	// handling whoever asked for them.
+	intraRefresh_ = settings.intraRefresh || x264IntraRefresh;
+
+	if (x264IntraRefresh) {
+		logInfo("Intra refresh enabled: x264 refreshes the picture in a rolling column each keyframe interval "
+		        "instead of sending IDRs; joining viewers resume on the next recovery point after the cached "
+		        "keyframe");
+	} else if (settings.intraRefresh && encoderId && std::strcmp(encoderId, "obs_x264") == 0) {
+		logWarning("Intra refresh requested, but the x264 options do not include it. 'Ignore streaming service "
+		           "setting recommendations' skips the service's encoder settings; add intra-refresh=1 to the x264 "
+		           "options instead");
+	} else if (settings.intraRefresh) {
+		logWarning("Intra refresh requested, but encoder '%s' has no intra refresh option; it keeps periodic "
+		           "keyframes",
+		           encoderId ? encoderId : "(unknown)");
+	}
 }
 
 void VDONinjaOutput::configureH264ProfileLevelId()
@@ -1489,12 +1749,21 @@ void VDONinjaOutput::maybeAdaptBitrate()
 	}
 
 	maybeSettleAdaptivePacer();
-	const std::optional<uint64_t> estimate = peerManager_->minimumRecentRembBitrate(kRecentRembMaximumAge);
+	std::optional<uint64_t> estimate;
+	if (blendedBitrateEstimator_) {
+		estimate = blendedBitrateEstimator_->estimate(
+		    peerManager_->recentViewerCongestionFeedback(kRecentRembMaximumAge),
+		    bitrateController_->currentBitrateBitsPerSecond());
+	} else {
+		estimate = peerManager_->minimumRecentRembBitrate(kRecentRembMaximumAge);
+	}
 	const std::optional<uint64_t> target = bitrateController_->observe(estimate);
-	if (!target || *target == 0 || *target > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
-		return;
+	if (target && *target != 0 && *target <= static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+		applyAdaptiveBitrate(*target, estimate.value_or(0));
 	}
-	applyAdaptiveBitrate(*target, estimate.value_or(0));
+	// Every tick, not only on bitrate changes: stepping back up waits for
+	// the dwell even when the bitrate has long since recovered.
+	maybeStepQualityLadder();
 }
 
 void VDONinjaOutput::maybeSettleAdaptivePacer()
@@ -1534,6 +1803,8 @@ void VDONinjaOutput::applyAdaptiveBitrate(uint64_t bitrateBitsPerSecond, uint64_
 	}
 
 	const bool decreasing = targetBitsPerSecond < currentEncoderBitrate_;
+	// The publish smoke script matches the REMB-only wording.
+	const char *estimateLabel = blendedBitrateEstimator_ ? "lowest viewer target" : "minimum REMB";
 	if (!decreasing) {
 		// Give the scheduler enough capacity before the encoder begins
 		// producing at the higher rate.
@@ -1546,6 +1817,23 @@ void VDONinjaOutput::applyAdaptiveBitrate(uint64_t bitrateBitsPerSecond, uint64_
 	obs_data_set_int(update, "bitrate", targetKbps);
 	obs_encoder_update(encoder, update);
 	obs_data_release(update);
+	if (qualityLadderActive_) {
+		// Each standby encoder follows the target up to its rung ceiling, so
+		// a switch never lands on an encoder running above the path.
+		const std::vector<QualityRung> &rungs = qualityLadder_.config().rungs;
+		for (size_t i = 0; i < rungs.size(); ++i) {
+			const int ceiling = static_cast<int>(rungs[i].maximumBitrateBitsPerSecond);
+			const int rungKbps = std::min(targetBitsPerSecond, ceiling) / 1000;
+			obs_encoder_t *rungEncoder = obs_output_get_video_encoder2(output_, i + 1);
+			if (!rungEncoder || rungKbps == std::min(currentEncoderBitrate_, ceiling) / 1000) {
+				continue;
+			}
+			obs_data_t *rungUpdate = obs_data_create();
+			obs_data_set_int(rungUpdate, "bitrate", rungKbps);
+			obs_encoder_update(rungEncoder, rungUpdate);
+			obs_data_release(rungUpdate);
+		}
+	}
 	currentEncoderBitrate_ = targetBitsPerSecond;
 	if (decreasing) {
 		// Dynamic encoders can emit pre-change frames for a short time. Keep
@@ -1553,13 +1841,12 @@ void VDONinjaOutput::applyAdaptiveBitrate(uint64_t bitrateBitsPerSecond, uint64_
 		// converting the encoder transition into seconds of queued latency.
 		pendingPacerBitrate_ = targetBitsPerSecond;
 		pendingPacerBitrateDueMs_ = steadyTimeMs() + kAdaptivePacerSettleDelayMs;
-		logInfo(
-		    "Adaptive bitrate changed OBS encoder to %d kbps (minimum REMB %llu kbps); RTP pacers will settle after "
-		    "the drain interval",
-		    targetKbps, static_cast<unsigned long long>(estimateBitsPerSecond / 1000U));
+		logInfo("Adaptive bitrate changed OBS encoder to %d kbps (%s %llu kbps); RTP pacers will settle after the "
+		        "drain interval",
+		        targetKbps, estimateLabel, static_cast<unsigned long long>(estimateBitsPerSecond / 1000U));
 	} else {
-		logInfo("Adaptive bitrate changed OBS encoder and RTP pacers to %d kbps (minimum REMB %llu kbps)", targetKbps,
-		        static_cast<unsigned long long>(estimateBitsPerSecond / 1000U));
+		logInfo("Adaptive bitrate changed OBS encoder and RTP pacers to %d kbps (%s %llu kbps)", targetKbps,
+		        estimateLabel, static_cast<unsigned long long>(estimateBitsPerSecond / 1000U));
 	}
 }
 
@@ -1569,6 +1856,7 @@ void VDONinjaOutput::restoreEncoderBitrate()
 	    originalEncoderBitrate_ > 0 && currentEncoderBitrate_ > 0 && currentEncoderBitrate_ != originalEncoderBitrate_;
 	adaptiveBitrateEnabled_ = false;
 	bitrateController_.reset();
+	blendedBitrateEstimator_.reset();
 	pendingPacerBitrate_ = 0;
 	pendingPacerBitrateDueMs_ = 0;
 	if (!shouldRestore) {
@@ -1589,8 +1877,144 @@ void VDONinjaOutput::restoreEncoderBitrate()
 	currentEncoderBitrate_ = 0;
 }
 
+void VDONinjaOutput::bindQualityLadderEncoders()
+{
+	qualityLadderActive_ = false;
+	qualityLadder_ = QualityLadder();
+	qualityTrackSelector_.reset();
+	unbindQualityLadderEncoders();
+
+	bool adaptiveBitrate = false;
+	bool intraRefresh = false;
+	std::string spec;
+	{
+		std::lock_guard<std::mutex> lock(settingsMutex_);
+		adaptiveBitrate = settings_.enableAdaptiveBitrate;
+		intraRefresh = settings_.intraRefresh;
+		spec = settings_.qualityLadder;
+	}
+	std::string error;
+	const std::optional<std::vector<QualityRung>> rungs = parseQualityLadder(spec, &error);
+	if (!rungs) {
+		logWarning("Ignoring quality ladder '%s': %s", spec.c_str(), error.c_str());
+		return;
+	}
+	if (rungs->empty()) {
+		return;
+	}
+	if (!adaptiveBitrate) {
+		logWarning("Quality ladder ignored: it follows adaptive bitrate, which is disabled");
+		return;
+	}
+	if (intraRefresh) {
+		// Rung switches wait for an IDR, which intra refresh never sends.
+		logWarning("Quality ladder ignored: it switches rungs on IDRs, which intra refresh replaces");
+		return;
+	}
+
+	// libobs cannot rescale or change the frame rate of a running encoder,
+	// so each rung is its own encoder, started with the output and kept on
+	// standby until the ladder switches to its track.
+	obs_encoder_t *primary = obs_output_get_video_encoder(output_);
+	if (!primary || (obs_encoder_get_caps(primary) & OBS_ENCODER_CAP_DYN_BITRATE) == 0) {
+		logWarning("Quality ladder ignored: the video encoder does not support dynamic bitrate");
+		return;
+	}
+	const int encoderBitrate = resolveVideoEncoderBitrate(output_, 0);
+	obs_video_info videoInfo = {};
+	if (encoderBitrate <= 0 || !obs_get_video_info(&videoInfo)) {
+		logWarning("Quality ladder ignored: the video encoder bitrate or canvas frame rate is unknown");
+		return;
+	}
+
+	const uint32_t width = obs_encoder_get_width(primary);
+	const uint32_t height = obs_encoder_get_height(primary);
+	const uint32_t primaryDivisor = std::max<uint32_t>(1, obs_encoder_get_frame_rate_divisor(primary));
+	const char *encoderId = obs_encoder_get_id(primary);
+	obs_data_t *primarySettings = obs_encoder_get_settings(primary);
+
+	QualityLadderConfig config;
+	for (const QualityRung &rung : *rungs) {
+		const std::string name = qualityRungName(rung);
+		if (rung.maximumBitrateBitsPerSecond >= static_cast<uint64_t>(encoderBitrate)) {
+			logInfo("Skipping quality ladder rung %s: its %llu kbps ceiling is not below the encoder's %d kbps",
+			        name.c_str(), static_cast<unsigned long long>(rung.maximumBitrateBitsPerSecond / 1000U),
+			        encoderBitrate / 1000);
+			continue;
+		}
+
+		const size_t track = config.rungs.size() + 1;
+		const QualityRungGeometry geometry =
+		    qualityRungGeometry(rung, width, height, videoInfo.fps_num, videoInfo.fps_den * primaryDivisor);
+		obs_data_t *rungSettings = obs_data_create();
+		if (primarySettings) {
+			obs_data_apply(rungSettings, primarySettings);
+		}
+		obs_data_set_int(rungSettings, "bitrate", static_cast<int64_t>(rung.maximumBitrateBitsPerSecond / 1000U));
+		const std::string encoderName = "vdoninja_quality_ladder_" + std::to_string(track);
+		obs_encoder_t *rungEncoder = obs_video_encoder_create(encoderId, encoderName.c_str(), rungSettings, nullptr);
+		obs_data_release(rungSettings);
+		if (!rungEncoder) {
+			logWarning("Failed to create a '%s' encoder for quality ladder rung %s; dropping it and the rungs below",
+			           encoderId ? encoderId : "(unknown)", name.c_str());
+			break;
+		}
+
+		obs_encoder_set_scaled_size(rungEncoder, geometry.width, geometry.height);
+		// The divisor sizes the encoder's video output, so it must come
+		// before the video is attached.
+		obs_encoder_set_frame_rate_divisor(rungEncoder, primaryDivisor * geometry.frameRateDivisor);
+		obs_encoder_set_video(rungEncoder, obs_get_video());
+		obs_output_set_video_encoder2(output_, rungEncoder, track);
+		obs_encoder_release(rungEncoder);
+		config.rungs.push_back(rung);
+
+		logInfo("Quality ladder rung %s on video track %zu: %ux%u at %.2f fps below %llu kbps", name.c_str(), track,
+		        geometry.width, geometry.height,
+		        static_cast<double>(videoInfo.fps_num) /
+		            static_cast<double>(videoInfo.fps_den * primaryDivisor * geometry.frameRateDivisor),
+		        static_cast<unsigned long long>(rung.maximumBitrateBitsPerSecond / 1000U));
+	}
+	obs_data_release(primarySettings);
+
+	if (config.rungs.empty()) {
+		return;
+	}
+	qualityLadder_ = QualityLadder(config);
+	qualityLadderActive_ = true;
+}
+
+void VDONinjaOutput::unbindQualityLadderEncoders()
+{
+	qualityLadderActive_ = false;
+	for (size_t track = 1; track <= kMaxQualityLadderRungs; ++track) {
+		if (obs_output_get_video_encoder2(output_, track)) {
+			obs_output_set_video_encoder2(output_, nullptr, track);
+		}
+	}
+}
+
+void VDONinjaOutput::maybeStepQualityLadder()
+{
+	if (!qualityLadderActive_ || currentEncoderBitrate_ <= 0) {
+		return;
+	}
+
+	const int64_t nowMs = steadyTimeMs();
+	const std::optional<size_t> level = qualityLadder_.observe(static_cast<uint64_t>(currentEncoderBitrate_), nowMs);
+	if (!level) {
+		return;
+	}
+	qualityTrackSelector_.requestTrack(*level, nowMs);
+	const std::string name = *level == 0 ? std::string("the configured resolution")
+	                                     : qualityRungName(qualityLadder_.config().rungs[*level - 1]);
+	logInfo("Quality ladder stepping to %s at %d kbps; viewers switch on that encoder's next keyframe", name.c_str(),
+	        currentEncoderBitrate_ / 1000);
+}
+
 void VDONinjaOutput::resetPublishTelemetry()
 {
+	threadCpuSampler_.reset();
 	lastKeyframeWallClockMs_ = 0;
 	longKeyframeGaps_ = 0;
 	loggedKeyframeIntervalWarning_ = false;
@@ -1600,6 +2024,7 @@ void VDONinjaOutput::resetPublishTelemetry()
 		summaryVideoFrames_ = 0;
 		summaryVideoBytes_ = 0;
 		summaryKeyframes_ = 0;
+		summaryRecoveryPoints_ = 0;
 		summaryKeyframeBytes_ = 0;
 		summaryMaxKeyframeBytes_ = 0;
 		summaryAudioBytes_ = 0;
@@ -1607,9 +2032,12 @@ void VDONinjaOutput::resetPublishTelemetry()
 	}
 	maxMediaQueueDepth_.store(0, std::memory_order_relaxed);
 	maxAudioQueueDelayMs_.store(0, std::memory_order_relaxed);
+	encoderToEnqueueUs_.snapshot(true);
+	mediaQueueWaitUs_.snapshot(true);
 	keyframeRequests_.store(0, std::memory_order_relaxed);
 	keyframeRequestsPrimed_.store(0, std::memory_order_relaxed);
 	loggedFirstKeyframeRequest_.store(false, std::memory_order_relaxed);
+	keyframeArbiter_.reset();
 }
 
 void VDONinjaOutput::maybeLogPublishSummary(bool force)
@@ -1619,6 +2047,7 @@ void VDONinjaOutput::maybeLogPublishSummary(bool force)
 	uint64_t videoFrames = 0;
 	uint64_t videoBytes = 0;
 	uint64_t keyframes = 0;
+	uint64_t recoveryPoints = 0;
 	uint64_t keyframeBytes = 0;
 	uint64_t maxKeyframeBytes = 0;
 	uint64_t audioBytes = 0;
@@ -1647,6 +2076,7 @@ void VDONinjaOutput::maybeLogPublishSummary(bool force)
 		videoFrames = summaryVideoFrames_;
 		videoBytes = summaryVideoBytes_;
 		keyframes = summaryKeyframes_;
+		recoveryPoints = summaryRecoveryPoints_;
 		keyframeBytes = summaryKeyframeBytes_;
 		maxKeyframeBytes = summaryMaxKeyframeBytes_;
 		audioBytes = summaryAudioBytes_;
@@ -1655,6 +2085,7 @@ void VDONinjaOutput::maybeLogPublishSummary(bool force)
 		summaryVideoFrames_ = 0;
 		summaryVideoBytes_ = 0;
 		summaryKeyframes_ = 0;
+		summaryRecoveryPoints_ = 0;
 		summaryKeyframeBytes_ = 0;
 		summaryMaxKeyframeBytes_ = 0;
 		summaryAudioBytes_ = 0;
@@ -1757,6 +2188,118 @@ void VDONinjaOutput::maybeLogPublishSummary(bool force)
 	    static_cast<unsigned long long>(audioRedStats.packetsWithRedundancy),
 	    static_cast<unsigned long long>(audioRedStats.primaryOnlyPackets),
 	    static_cast<double>(audioRedStats.redundantBytes) / 1024.0);
+
+	const LatencyHistogramSnapshot encoderToEnqueue = encoderToEnqueueUs_.snapshot(true);
+	const LatencyHistogramSnapshot queueWait = mediaQueueWaitUs_.snapshot(true);
+	const LatencyHistogramSnapshot packetize =
+	    peerManager_ ? peerManager_->getVideoPacketizeLatency(true) : LatencyHistogramSnapshot{};
+	if (queueWait.count != 0) {
+		logInfo("Publish latency p50/p95/p99 (max) ms: encoder->enqueue %.1f/%.1f/%.1f (%.1f), "
+		        "queue wait %.2f/%.2f/%.2f (%.2f), packetize %.2f/%.2f/%.2f (%.2f), "
+		        "pacer hold %.2f/%.2f/%.2f (%.2f), send call %.3f/%.3f/%.3f (%.3f)",
+		        microsecondsToMs(encoderToEnqueue.percentileUs(0.50)),
+		        microsecondsToMs(encoderToEnqueue.percentileUs(0.95)),
+		        microsecondsToMs(encoderToEnqueue.percentileUs(0.99)), microsecondsToMs(encoderToEnqueue.maxUs),
+		        microsecondsToMs(queueWait.percentileUs(0.50)), microsecondsToMs(queueWait.percentileUs(0.95)),
+		        microsecondsToMs(queueWait.percentileUs(0.99)), microsecondsToMs(queueWait.maxUs),
+		        microsecondsToMs(packetize.percentileUs(0.50)), microsecondsToMs(packetize.percentileUs(0.95)),
+		        microsecondsToMs(packetize.percentileUs(0.99)), microsecondsToMs(packetize.maxUs),
+		        microsecondsToMs(pacerStats.frameHoldUs.percentileUs(0.50)),
+		        microsecondsToMs(pacerStats.frameHoldUs.percentileUs(0.95)),
+		        microsecondsToMs(pacerStats.frameHoldUs.percentileUs(0.99)),
+		        microsecondsToMs(pacerStats.frameHoldUs.maxUs),
+		        microsecondsToMs(pacerStats.sendCallUs.percentileUs(0.50)),
+		        microsecondsToMs(pacerStats.sendCallUs.percentileUs(0.95)),
+		        microsecondsToMs(pacerStats.sendCallUs.percentileUs(0.99)),
+		        microsecondsToMs(pacerStats.sendCallUs.maxUs));
+	}
+
+	const JoinLatencyStats joinStats = peerManager_ ? peerManager_->takeJoinLatencyStats() : JoinLatencyStats{};
+	if (joinStats.completedJoins != 0 || joinStats.abandonedJoins != 0) {
+		logInfo("Viewer joins: %llu completed (%llu pre-warmed, %zu pooled now), %llu abandoned; avg/max ms "
+		        "request->offer %llu/%llu, offer->answer %llu/%llu, answer->connected %llu/%llu, "
+		        "connected->first keyframe %llu/%llu, request->first keyframe %llu/%llu",
+		        static_cast<unsigned long long>(joinStats.completedJoins),
+		        static_cast<unsigned long long>(joinStats.warmJoins), peerManager_->getWarmPublisherPoolCount(),
+		        static_cast<unsigned long long>(joinStats.abandonedJoins),
+		        static_cast<unsigned long long>(joinStats.requestToOffer.averageMs()),
+		        static_cast<unsigned long long>(joinStats.requestToOffer.maxMs),
+		        static_cast<unsigned long long>(joinStats.offerToAnswer.averageMs()),
+		        static_cast<unsigned long long>(joinStats.offerToAnswer.maxMs),
+		        static_cast<unsigned long long>(joinStats.answerToConnected.averageMs()),
+		        static_cast<unsigned long long>(joinStats.answerToConnected.maxMs),
+		        static_cast<unsigned long long>(joinStats.connectedToFirstKeyframe.averageMs()),
+		        static_cast<unsigned long long>(joinStats.connectedToFirstKeyframe.maxMs),
+		        static_cast<unsigned long long>(joinStats.requestToFirstKeyframe.averageMs()),
+		        static_cast<unsigned long long>(joinStats.requestToFirstKeyframe.maxMs));
+	}
+
+	const GopReplayStats gopStats = peerManager_ ? peerManager_->takeGopReplayStats() : GopReplayStats{};
+	if (gopStats.replays != 0 || gopStats.stillFallbacks != 0 || gopStats.overflows != 0) {
+		logInfo("GOP fast start: %llu viewers replayed %llu frames (%.1f KB), %llu started on a still keyframe, %llu "
+		        "GOPs too large to cache",
+		        static_cast<unsigned long long>(gopStats.replays),
+		        static_cast<unsigned long long>(gopStats.replayedFrames),
+		        static_cast<double>(gopStats.replayedBytes) / 1024.0,
+		        static_cast<unsigned long long>(gopStats.stillFallbacks),
+		        static_cast<unsigned long long>(gopStats.overflows));
+	}
+
+	if (recoveryPoints != 0) {
+		logInfo("Intra refresh: recovery point every %.1fs, %llu IDRs", seconds / static_cast<double>(recoveryPoints),
+		        static_cast<unsigned long long>(keyframes));
+	}
+
+	const KeyframeArbiterStats arbiterStats = keyframeArbiter_.takeStats();
+	if (arbiterStats.requests != 0 || arbiterStats.requestToKeyframeUs.count != 0) {
+		const LatencyHistogramSnapshot &waits = arbiterStats.requestToKeyframeUs;
+		logInfo("Keyframe requests: %llu (%llu coalesced), request to keyframe p50 %.0f ms, p95 %.0f ms, max %.0f ms "
+		        "over %llu viewer waits",
+		        static_cast<unsigned long long>(arbiterStats.requests),
+		        static_cast<unsigned long long>(arbiterStats.coalescedRequests),
+		        static_cast<double>(waits.percentileUs(0.50)) / 1000.0,
+		        static_cast<double>(waits.percentileUs(0.95)) / 1000.0, static_cast<double>(waits.maxUs) / 1000.0,
+		        static_cast<unsigned long long>(waits.count));
+	}
+
+	if (qualityLadderActive_) {
+		const QualityLadderStats ladderStats = qualityTrackSelector_.takeStats();
+		const std::vector<QualityRung> &rungs = qualityLadder_.config().rungs;
+		const std::string sending = ladderStats.activeTrack == 0 || ladderStats.activeTrack > rungs.size()
+		                                ? std::string("configured resolution")
+		                                : qualityRungName(rungs[ladderStats.activeTrack - 1]);
+		logInfo("Quality ladder: sending %s%s, %llu steps down/%llu up, switch wait max %lld ms, %llu standby "
+		        "frames",
+		        sending.c_str(), ladderStats.targetTrack != ladderStats.activeTrack ? " (switch pending)" : "",
+		        static_cast<unsigned long long>(ladderStats.switchesDown),
+		        static_cast<unsigned long long>(ladderStats.switchesUp),
+		        static_cast<long long>(ladderStats.maxSwitchWaitMs),
+		        static_cast<unsigned long long>(ladderStats.standbyFrames));
+	}
+
+	const RtpSharedBudgetShare &budget = pacerStats.sharedBudget;
+	if (budget.grantedPackets != 0) {
+		logInfo("Shared viewer budget: %llu packets (%.0f KB, %llu priority), wait p50 %.2f ms, p95 %.2f ms, "
+		        "max %.2f ms",
+		        static_cast<unsigned long long>(budget.grantedPackets),
+		        static_cast<double>(budget.grantedBytes) / 1024.0,
+		        static_cast<unsigned long long>(budget.priorityPackets),
+		        microsecondsToMs(budget.waitUs.percentileUs(0.50)), microsecondsToMs(budget.waitUs.percentileUs(0.95)),
+		        microsecondsToMs(budget.waitUs.maxUs));
+	}
+
+	// Per-subsystem share of one core since the previous summary, so capacity
+	// (viewers per core) can be read straight off the log.
+	const std::vector<SubsystemCpuUsage> threadCpu = threadCpuSampler_.query();
+	if (!threadCpu.empty()) {
+		double totalPercent = 0.0;
+		for (const SubsystemCpuUsage &usage : threadCpu) {
+			totalPercent += usage.percent;
+		}
+		logInfo("Plugin thread CPU (%% of one core): %s; total %.1f%% with %d viewers",
+		        formatSubsystemCpuUsage(threadCpu).c_str(), totalPercent,
+		        peerManager_ ? peerManager_->getViewerCount() : 0);
+	}
 }
 
 bool VDONinjaOutput::start()
@@ -1801,7 +2344,9 @@ bool VDONinjaOutput::start()
 		return false;
 	}
 
+	bindQualityLadderEncoders();
 	if (!obs_output_initialize_encoders(output_, 0)) {
+		unbindQualityLadderEncoders();
 		logError("Failed to initialize output encoders");
 		obs_output_set_last_error(output_, "Failed to initialize OBS encoders for VDO.Ninja output.");
 		return false;
@@ -1843,6 +2388,7 @@ bool VDONinjaOutput::start()
 		        settingsSnap.quality.bitrate / 1000, configuredBitrate / 1000);
 	}
 	configureBitrateAdaptation(settingsSnap, settingsSnap.quality.bitrate);
+	configureIntraRefresh(settingsSnap);
 
 	startMediaSendWorker();
 	startPublishSummaryWorker();
@@ -1858,6 +2404,7 @@ bool VDONinjaOutput::start()
 
 void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 {
+	setCurrentThreadName("vdo-start");
 	try {
 		logInfo("Starting VDO.Ninja output...");
 		const auto callbackState = callbackState_;
@@ -1869,9 +2416,11 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 		peerManager_->setBitrate(settingsSnap.quality.bitrate);
 		peerManager_->setVideoProtectionMode(settingsSnap.videoProtectionMode);
 		peerManager_->setAudioRedEnabled(settingsSnap.enableAudioRed);
+		peerManager_->setGopFastStartEnabled(settingsSnap.gopFastStart);
 		peerManager_->setEnableDataChannel(settingsSnap.enableDataChannel);
 		peerManager_->setIceServers(settingsSnap.customIceServers);
 		peerManager_->setForceTurn(settingsSnap.forceTurn);
+		peerManager_->setWarmPublisherPoolSize(settingsSnap.warmViewerConnections);
 		signaling_->setSalt(settingsSnap.salt);
 
 		if (autoSceneManager_) {
@@ -1907,6 +2456,7 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 			// Start publishing
 			self->signaling_->publishStream(settingsSnap.streamId, settingsSnap.password);
 			self->peerManager_->startPublishing(settingsSnap.maxViewers);
+			self->publishDockStats();
 
 			self->connected_ = true;
 			self->connectTimeMs_ = currentTimeMs() - self->startTimeMs_;
@@ -2004,6 +2554,7 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 			}
 			logInfo("Viewer connected: %s (total: %d)", uuid.c_str(), self->peerManager_->getViewerCount());
 			self->primeViewerWithCachedKeyframe(uuid);
+			self->publishDockStats();
 		});
 
 		peerManager_->setOnPeerDisconnected([callbackState](const PeerEventIdentity &identity) {
@@ -2024,7 +2575,9 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 				self->lastPeerStatsTimestampMs_.erase(uuid);
 			}
 			self->removeRemoteStatsSubscriber(uuid);
+			self->keyframeArbiter_.removeViewer(uuid);
 			logInfo("Viewer disconnected: %s (total: %d)", uuid.c_str(), self->peerManager_->getViewerCount());
+			self->publishDockStats();
 		});
 		peerManager_->setOnKeyframeRequest([callbackState](const std::string &uuid) {
 			AsyncCallbackGuard<VDONinjaOutput> guard(callbackState.get());
@@ -2065,6 +2618,17 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 			}
 			self->dataChannel_.handleMessage(uuid, message);
 
+			const ViewerRoleUpdate role = self->dataChannel_.parseViewerRole(message);
+			if ((role.hasDirector || role.hasScene) && self->peerManager_) {
+				const ViewerPacerRole pacerRole = role.scene      ? ViewerPacerRole::Scene
+				                                  : role.director ? ViewerPacerRole::Director
+				                                                  : ViewerPacerRole::Guest;
+				if (self->peerManager_->setViewerPacerRole(uuid, pacerRole)) {
+					logInfo("Viewer %s paced as %s (weight %u)", uuid.c_str(), viewerPacerRoleName(pacerRole),
+					        pacerWeightForViewerRole(pacerRole));
+				}
+			}
+
 			const DataMessage parsed = self->dataChannel_.parseMessage(message);
 			if (parsed.type == DataMessageType::Signaling) {
 				if (self->signaling_) {
@@ -2099,8 +2663,8 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 			}
 
 			if (self->dataChannel_.hasKeyframeRequest(message)) {
-				self->noteKeyframeRequest(uuid, "data channel");
 				self->peerManager_->notePeerKeyframeRequest(uuid);
+				self->noteKeyframeRequest(uuid, "data channel");
 				self->primeViewerWithCachedKeyframe(uuid);
 			}
 
@@ -2141,8 +2705,8 @@ void VDONinjaOutput::startThread(OutputSettings settingsSnap)
 
 				if (refreshVideo) {
 					logInfo("Viewer %s requested publisher video refresh over data channel", uuid.c_str());
-					self->noteKeyframeRequest(uuid, "refreshVideo");
 					self->peerManager_->notePeerKeyframeRequest(uuid);
+					self->noteKeyframeRequest(uuid, "refreshVideo");
 					self->primeViewerWithCachedKeyframe(uuid);
 				}
 				if (refreshConnection) {
@@ -2377,6 +2941,8 @@ void VDONinjaOutput::stop()
 		lastPeerStats_.clear();
 		lastPeerStatsTimestampMs_.clear();
 	}
+	// A later session must not report this session's viewers.
+	viewerTransportStats_.clear();
 
 	// Unpublish stream
 	if (signaling_->isPublishing()) {
@@ -2401,6 +2967,9 @@ void VDONinjaOutput::stop()
 		obs_output_end_data_capture(output_);
 		capturing_ = false;
 	}
+	// The standby encoders stay bound until the next start, which cannot
+	// change tracks while libobs is still tearing the capture down.
+	qualityLadderActive_ = false;
 	restoreEncoderBitrate();
 	{
 		std::lock_guard<std::mutex> lock(keyframeCacheMutex_);
@@ -2412,6 +2981,7 @@ void VDONinjaOutput::stop()
 	hasLastAudioRtpTimestamp_ = false;
 	lastAudioRtpTimestamp_ = 0;
 	resetPublishTelemetry();
+	dockStats_.publish(DockStats{});
 
 	logInfo("VDO.Ninja output stopped");
 }
@@ -2447,7 +3017,7 @@ void VDONinjaOutput::enqueueMediaFrame(QueuedMediaFrame frame)
 	if (frame.payload.empty()) {
 		return;
 	}
-	frame.queuedAtMs = static_cast<uint64_t>(steadyTimeMs());
+	frame.queuedAtUs = static_cast<uint64_t>(steadyTimeUs());
 
 	uint64_t dropped = 0;
 	bool droppedVideo = false;
@@ -2485,6 +3055,7 @@ void VDONinjaOutput::enqueueMediaFrame(QueuedMediaFrame frame)
 
 void VDONinjaOutput::mediaSendThread()
 {
+	setCurrentThreadName("vdo-send");
 	for (;;) {
 		QueuedMediaFrame frame;
 		{
@@ -2501,14 +3072,15 @@ void VDONinjaOutput::mediaSendThread()
 			continue;
 		}
 
+		const uint64_t nowUs = static_cast<uint64_t>(steadyTimeUs());
+		const uint64_t queueDelayUs = nowUs >= frame.queuedAtUs ? nowUs - frame.queuedAtUs : 0;
 		try {
 			if (frame.type == MediaFrameType::Video) {
+				mediaQueueWaitUs_.record(queueDelayUs);
 				peerManager_->sendVideoFrame(frame.payload.data(), frame.payload.size(), frame.timestamp,
-				                             frame.keyframe);
+				                             frame.keyframe, frame.recoveryPoint, &frame.nalIndex);
 			} else {
-				const uint64_t nowMs = static_cast<uint64_t>(steadyTimeMs());
-				const uint64_t queueDelayMs = nowMs >= frame.queuedAtMs ? nowMs - frame.queuedAtMs : 0;
-				updateAtomicMaximum(maxAudioQueueDelayMs_, queueDelayMs);
+				updateAtomicMaximum(maxAudioQueueDelayMs_, queueDelayUs / 1000U);
 				peerManager_->sendAudioFrame(frame.payload.data(), frame.payload.size(), frame.timestamp);
 			}
 		} catch (const std::exception &e) {
@@ -2538,6 +3110,10 @@ void VDONinjaOutput::data(encoder_packet *packet)
 		return;
 
 	if (packet->type == OBS_ENCODER_VIDEO) {
+		if (qualityLadderActive_ &&
+		    !qualityTrackSelector_.accept(packet->track_idx, packet->keyframe, steadyTimeMs())) {
+			return;
+		}
 		processVideoPacket(packet);
 	} else if (packet->type == OBS_ENCODER_AUDIO) {
 		processAudioPacket(packet);
@@ -2603,7 +3179,21 @@ void VDONinjaOutput::processVideoPacket(encoder_packet *packet)
 		return;
 	}
 
+	// One pass over the access unit serves every reader below and the
+	// packetizer for all viewers.
+	H264NalIndex nalIndex;
+	nalIndex.build(packet->data, packet->size);
+
 	bool keyframe = packet->keyframe;
+	bool recoveryPoint = false;
+	if (intraRefresh_) {
+		// x264 flags the first frame of every refresh cycle as a keyframe,
+		// but only an IDR can start a decoder, so the cache, the GOP replay
+		// and viewer gates treat the rest as recovery points.
+		const EncodedVideoFrameInfo info = inspectH264AccessUnit(packet->data, nalIndex);
+		recoveryPoint = info.recoveryPoint && !info.keyframe;
+		keyframe = keyframe && !recoveryPoint;
+	}
 	uint32_t timestamp = timestampFromPacket(packet, 90000.0);
 	timestamp = sanitizeMonotonicTimestamp(timestamp, hasLastVideoRtpTimestamp_, lastVideoRtpTimestamp_, 3000);
 
@@ -2614,7 +3204,7 @@ void VDONinjaOutput::processVideoPacket(encoder_packet *packet)
 	}
 
 	if (keyframe) {
-		if (const auto profileLevelId = deriveH264ProfileLevelId(packet->data, packet->size)) {
+		if (const auto profileLevelId = deriveH264ProfileLevelId(packet->data, packet->size, nalIndex)) {
 			bool changed = false;
 			{
 				std::lock_guard<std::mutex> lock(h264ProfileMutex_);
@@ -2629,7 +3219,9 @@ void VDONinjaOutput::processVideoPacket(encoder_packet *packet)
 				        profileLevelId->c_str());
 			}
 		}
+	}
 
+	if (keyframe || recoveryPoint) {
 		const int64_t nowMs = currentTimeMs();
 		if (lastKeyframeWallClockMs_ != 0) {
 			const int64_t gapMs = nowMs - lastKeyframeWallClockMs_;
@@ -2649,6 +3241,7 @@ void VDONinjaOutput::processVideoPacket(encoder_packet *packet)
 			}
 		}
 		lastKeyframeWallClockMs_ = nowMs;
+		keyframeArbiter_.noteKeyframe(steadyTimeMs());
 	}
 
 	QueuedMediaFrame frame;
@@ -2656,8 +3249,18 @@ void VDONinjaOutput::processVideoPacket(encoder_packet *packet)
 	frame.payload.assign(packet->data, packet->data + packet->size);
 	frame.timestamp = timestamp;
 	frame.keyframe = keyframe;
+	frame.recoveryPoint = recoveryPoint;
+	frame.nalIndex = std::move(nalIndex);
 	enqueueMediaFrame(std::move(frame));
 
+	// sys_dts_usec is on the os_gettime_ns() clock, so this spans capture
+	// timing, encoder delay and libobs interleaving up to our send queue.
+	if (packet->sys_dts_usec > 0) {
+		const int64_t enqueuedUs = static_cast<int64_t>(os_gettime_ns() / 1000U);
+		encoderToEnqueueUs_.record(
+		    enqueuedUs > packet->sys_dts_usec ? static_cast<uint64_t>(enqueuedUs - packet->sys_dts_usec) : 0);
+	}
+
 	bool startSummaryInterval = false;
 	{
 		std::lock_guard<std::mutex> lock(publishSummaryMutex_);
@@ -2674,6 +3277,9 @@ void VDONinjaOutput::processVideoPacket(encoder_packet *packet)
 				summaryMaxKeyframeBytes_ = static_cast<uint64_t>(packet->size);
 			}
 		}
+		if (recoveryPoint) {
+			summaryRecoveryPoints_++;
+		}
 	}
 	if (startSummaryInterval) {
 		publishSummaryCv_.notify_one();
@@ -2749,6 +3355,33 @@ TallyState VDONinjaOutput::getAggregatedTally() const
 	return aggregated;
 }
 
+VDONinjaOutput::DockStats VDONinjaOutput::getDockStats() const
+{
+	return dockStats_.load();
+}
+
+void VDONinjaOutput::publishDockStats()
+{
+	DockStats stats;
+	if (running_ && peerManager_) {
+		stats.viewerCount = peerManager_->getViewerCount();
+		stats.maxViewers = peerManager_->getMaxViewers();
+		const TallyState tally = getAggregatedTally();
+		stats.tallyProgram = tally.program;
+		stats.tallyPreview = tally.preview;
+		const ViewerTransportTotals transport = sumViewerTransportStats(getViewerTransportStats(currentTimeMs()));
+		stats.sendBitrateBps = transport.sendBitrateBps;
+		stats.pacerQueueDelayMs = transport.maxPacerQueueDelayMs;
+	}
+	dockStats_.publish(stats);
+	// stop() clears running_ before it publishes the zeroed snapshot. If that
+	// happened while this one was being built, publish zeros again so the
+	// stale numbers cannot land last.
+	if (!running_) {
+		dockStats_.publish(DockStats{});
+	}
+}
+
 bool VDONinjaOutput::isRemoteControlEnabled() const
 {
 	std::lock_guard<std::mutex> lock(settingsMutex_);
@@ -2781,6 +3414,21 @@ OutputSettings VDONinjaOutput::getSettingsSnapshot() const
 	return settings_;
 }
 
+VDONinjaOutput::PublishLatencySnapshot VDONinjaOutput::getPublishLatencySnapshot() const
+{
+	PublishLatencySnapshot snapshot;
+	snapshot.encoderToEnqueueUs = encoderToEnqueueUs_.snapshot(false);
+	snapshot.queueWaitUs = mediaQueueWaitUs_.snapshot(false);
+	if (peerManager_) {
+		snapshot.packetizeUs = peerManager_->getVideoPacketizeLatency(false);
+		for (const auto &viewer : peerManager_->getPeerPublishLatencySnapshots()) {
+			snapshot.pacerHoldUs.merge(viewer.pacerHoldUs);
+			snapshot.sendCallUs.merge(viewer.sendCallUs);
+		}
+	}
+	return snapshot;
+}
+
 std::vector<VDONinjaOutput::ViewerRuntimeSnapshot> VDONinjaOutput::getViewerSnapshots() const
 {
 	std::vector<ViewerRuntimeSnapshot> snapshots;
@@ -20,9 +20,17 @@
 #include "vdoninja-bitrate-controller.h"
 #include "vdoninja-common.h"
 #include "vdoninja-data-channel.h"
+#include "vdoninja-h264-nal-index.h"
+#include "vdoninja-keyframe-arbiter.h"
+#include "vdoninja-latency-histogram.h"
 #include "vdoninja-peer-manager.h"
+#include "vdoninja-quality-ladder.h"
+#include "vdoninja-remote-stats.h"
 #include "vdoninja-rtp-utils.h"
+#include "vdoninja-seqlock.h"
 #include "vdoninja-signaling.h"
+#include "vdoninja-thread-cpu.h"
+#include "vdoninja-viewer-stats.h"
 
 namespace vdoninja
 {
@@ -42,6 +50,30 @@ public:
 		int64_t lastStatsTimestampMs = 0;
 	};
 
+	// Publish pipeline latency for the current summary interval, in order:
+	// encoder timestamp to media queue, media queue wait, per-viewer H.264
+	// packetization, pacer hold before the first packet, and each
+	// track->send() call. Pacer stages are merged across viewers.
+	struct PublishLatencySnapshot {
+		LatencyHistogramSnapshot encoderToEnqueueUs;
+		LatencyHistogramSnapshot queueWaitUs;
+		LatencyHistogramSnapshot packetizeUs;
+		LatencyHistogramSnapshot pacerHoldUs;
+		LatencyHistogramSnapshot sendCallUs;
+	};
+
+	// Dock-facing summary republished by worker threads so the UI timer can
+	// read it without touching the peer registry or data channel locks.
+	struct DockStats {
+		int32_t viewerCount = 0;
+		int32_t maxViewers = 0;
+		bool tallyProgram = false;
+		bool tallyPreview = false;
+		// Sum across viewers; -1 until a bitrate is known.
+		int64_t sendBitrateBps = -1;
+		uint64_t pacerQueueDelayMs = 0;
+	};
+
 	VDONinjaOutput(obs_data_t *settings, obs_output_t *output);
 	~VDONinjaOutput();
 
@@ -60,10 +92,14 @@ public:
 	int64_t getUptimeMs() const;
 	OutputSettings getSettingsSnapshot() const;
 	std::vector<ViewerRuntimeSnapshot> getViewerSnapshots() const;
+	PublishLatencySnapshot getPublishLatencySnapshot() const;
 
 	// Tally aggregation across all peers
 	TallyState getAggregatedTally() const;
 
+	// Lock-free; safe to call from the UI thread at any rate.
+	DockStats getDockStats() const;
+
 	// Remote control enabled flag (read from settings)
 	bool isRemoteControlEnabled() const;
 
@@ -85,7 +121,10 @@ private:
 		std::vector<uint8_t> payload;
 		uint32_t timestamp = 0;
 		bool keyframe = false;
-		uint64_t queuedAtMs = 0;
+		bool recoveryPoint = false;
+		// Offsets into payload, built once on the encoder thread.
+		H264NalIndex nalIndex;
+		uint64_t queuedAtUs = 0;
 	};
 
 	void startMediaSendWorker();
@@ -101,17 +140,24 @@ private:
 	void stopPublishSummaryWorker(bool flush);
 	void publishSummaryThread();
 	void maybeLogPublishSummary(bool force = false);
+	void publishDockStats();
 	void configureBitrateAdaptation(const OutputSettings &settings, int encoderBitrateBitsPerSecond);
 	void configureH264ProfileLevelId();
 	void maybeAdaptBitrate();
 	void maybeSettleAdaptivePacer();
 	void applyAdaptiveBitrate(uint64_t bitrateBitsPerSecond, uint64_t estimateBitsPerSecond);
 	void restoreEncoderBitrate();
+	void bindQualityLadderEncoders();
+	void unbindQualityLadderEncoders();
+	void maybeStepQualityLadder();
+	void configureIntraRefresh(const OutputSettings &settings);
 	void resetPublishTelemetry();
 	std::string buildInitialInfoMessage() const;
 	std::string buildObsStateMessage() const;
-	std::string buildRemoteStatsMessage(const std::string &requestingUuid) const;
+	RemoteStatsDocument buildRemoteStatsDocument(int64_t nowMs) const;
+	std::shared_ptr<const RemoteStatsDocument> currentRemoteStatsDocument(int64_t nowMs);
 	std::string buildConnectionMapMessage(const std::string &requestingUuid) const;
+	std::map<std::string, ViewerTransportStats> getViewerTransportStats(int64_t nowMs) const;
 	void sendRemoteStatsSnapshotToPeer(const std::string &uuid);
 	void sendRejectedControlToPeer(const std::string &uuid, const std::string &controlName);
 	void addRemoteStatsSubscriber(const std::string &uuid);
@@ -154,6 +200,10 @@ private:
 	std::atomic<uint64_t> droppedAudioMediaFrames_{0};
 	std::atomic<uint64_t> maxMediaQueueDepth_{0};
 	std::atomic<uint64_t> maxAudioQueueDelayMs_{0};
+	// Video only. Written from the OBS data callback and the media sender;
+	// peeked by diagnostics and drained by the publish summary.
+	mutable LatencyHistogram encoderToEnqueueUs_;
+	mutable LatencyHistogram mediaQueueWaitUs_;
 
 	// Statistics
 	std::atomic<uint64_t> totalBytes_{0};
@@ -166,9 +216,16 @@ private:
 	std::map<std::string, int64_t> lastPeerStatsTimestampMs_;
 	std::mutex remoteStatsMutex_;
 	std::condition_variable remoteStatsCv_;
-	std::set<std::string> remoteStatsSubscribers_;
+	// Guarded by remoteStatsMutex_.
+	RemoteStatsPublisher remoteStatsPublisher_;
+	std::shared_ptr<const RemoteStatsDocument> remoteStatsDocument_;
 	std::thread remoteStatsThread_;
 	bool remoteStatsWorkerRunning_ = false;
+	// Shared by connection maps and remote stats; refreshed at most once a second.
+	mutable ViewerTransportStatsCache viewerTransportStats_;
+	// Written by the publish summary worker and peer callbacks.
+	SeqlockValue<DockStats> dockStats_;
+	ThreadCpuSampler threadCpuSampler_;
 
 	// Latest keyframe cache for fast viewer warm-up and keyframe requests.
 	mutable std::mutex keyframeCacheMutex_;
@@ -200,6 +257,7 @@ private:
 	uint64_t summaryVideoFrames_ = 0;
 	uint64_t summaryVideoBytes_ = 0;
 	uint64_t summaryKeyframes_ = 0;
+	uint64_t summaryRecoveryPoints_ = 0;
 	uint64_t summaryKeyframeBytes_ = 0;
 	uint64_t summaryMaxKeyframeBytes_ = 0;
 	uint64_t summaryAudioBytes_ = 0;
@@ -207,7 +265,21 @@ private:
 	std::atomic<uint64_t> keyframeRequests_{0};
 	std::atomic<uint64_t> keyframeRequestsPrimed_{0};
 	std::atomic<bool> loggedFirstKeyframeRequest_{false};
+	// Folds repeat viewer keyframe requests and times each viewer's wait for
+	// the encoder's next scheduled keyframe; nothing is forced from here.
+	KeyframeRequestArbiter keyframeArbiter_;
+	// Set for the session when intra refresh was requested; video packets are
+	// then inspected for recovery point SEI.
+	std::atomic<bool> intraRefresh_{false};
 	std::unique_ptr<BitrateController> bitrateController_;
+	// Present only in the blended mode; used from the publish summary thread.
+	std::unique_ptr<BlendedBitrateEstimator> blendedBitrateEstimator_;
+	// Rung N of the ladder is a standby encoder on output video track N. The
+	// ladder itself is used from the publish summary thread; the selector is
+	// shared with the OBS output thread.
+	QualityLadder qualityLadder_;
+	QualityTrackSelector qualityTrackSelector_;
+	std::atomic<bool> qualityLadderActive_{false};
 	bool adaptiveBitrateEnabled_ = false;
 	int originalEncoderBitrate_ = 0;
 	int currentEncoderBitrate_ = 0;
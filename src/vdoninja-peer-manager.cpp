@@ -19,6 +19,7 @@
 
 #include "vdoninja-audio-red.h"
 #include "vdoninja-h264-profile.h"
+#include "vdoninja-latency-histogram.h"
 #include "vdoninja-rtcp-feedback.h"
 #include "vdoninja-rtp-repair.h"
 #include "vdoninja-rtp-utils.h"
@@ -262,6 +263,10 @@ constexpr uint8_t kAudioRedPayloadType = kDefaultAudioRedPayloadType;
 constexpr uint8_t kH264FuAType = 28;
 constexpr size_t kMaxRtpPayloadSize = 1200;
 constexpr int64_t kRetiredPeerCleanupDelayMs = 1000;
+// Pooled connections have not sent a binding request yet, so NAT mappings
+// behind their server-reflexive candidates may lapse. Rebuild them well before
+// typical 30 second UDP mapping timeouts.
+constexpr int64_t kWarmPublisherMaxAgeMs = 20000;
 constexpr uint32_t kVideoClockRate = 90000;
 constexpr uint32_t kAudioClockRate = 48000;
 constexpr auto kVideoPacerInterval = std::chrono::milliseconds(2);
@@ -608,55 +613,6 @@ const SdpOfferedCodec *findAssociatedRtxCodec(const SdpOfferedMediaSection &sect
 	return nullptr;
 }
 
-std::string constrainViewerOfferToNativeCodecs(const std::string &sdp)
-{
-	std::string filtered = stripUnsupportedTransportCcFeedback(sdp);
-	if (filtered != sdp) {
-		logInfo("Stripped transport-cc feedback/extensions unsupported by the native receiver");
-	}
-	return filtered;
-}
-
-std::string normalizeEscapedSdpLineEndings(const std::string &sdp)
-{
-	const bool hasActualLineBreaks = sdp.find('\n') != std::string::npos || sdp.find('\r') != std::string::npos;
-	const bool hasEscapedLineBreaks = sdp.find("\\r\\n") != std::string::npos || sdp.find("\\n") != std::string::npos ||
-	                                  sdp.find("\\r") != std::string::npos;
-	if (hasActualLineBreaks || !hasEscapedLineBreaks) {
-		return sdp;
-	}
-
-	std::string normalized;
-	normalized.reserve(sdp.size());
-	for (size_t i = 0; i < sdp.size(); ++i) {
-		if (sdp[i] != '\\' || i + 1 >= sdp.size()) {
-			normalized.push_back(sdp[i]);
-			continue;
-		}
-
-		const char next = sdp[i + 1];
-		switch (next) {
-		case 'r':
-			normalized.push_back('\r');
-			++i;
-			break;
-		case 'n':
-			normalized.push_back('\n');
-			++i;
-			break;
-		case '\\':
-			normalized.push_back('\\');
-			++i;
-			break;
-		default:
-			normalized.push_back(sdp[i]);
-			break;
-		}
-	}
-
-	return normalized;
-}
-
 std::string describeOfferedSections(const std::vector<SdpOfferedMediaSection> &sections)
 {
 	std::ostringstream summary;
@@ -679,129 +635,6 @@ std::string describeOfferedSections(const std::vector<SdpOfferedMediaSection> &s
 	return summary.str();
 }
 
-struct NalUnitView {
-	const uint8_t *data = nullptr;
-	size_t size = 0;
-};
-
-bool hasStartCodeAt(const uint8_t *data, size_t size, size_t pos, size_t &length)
-{
-	length = 0;
-	if (!data || pos >= size) {
-		return false;
-	}
-
-	if (pos + 3 <= size && data[pos] == 0x00 && data[pos + 1] == 0x00 && data[pos + 2] == 0x01) {
-		length = 3;
-		return true;
-	}
-
-	if (pos + 4 <= size && data[pos] == 0x00 && data[pos + 1] == 0x00 && data[pos + 2] == 0x00 &&
-	    data[pos + 3] == 0x01) {
-		length = 4;
-		return true;
-	}
-
-	return false;
-}
-
-size_t findStartCode(const uint8_t *data, size_t size, size_t from, size_t &length)
-{
-	length = 0;
-	if (!data || from >= size) {
-		return size;
-	}
-
-	for (size_t pos = from; pos < size; ++pos) {
-		if (hasStartCodeAt(data, size, pos, length)) {
-			return pos;
-		}
-	}
-
-	return size;
-}
-
-bool parseAnnexBNalus(const uint8_t *data, size_t size, std::vector<NalUnitView> &nalUnits)
-{
-	size_t startCodeLen = 0;
-	size_t start = findStartCode(data, size, 0, startCodeLen);
-	if (start == size) {
-		return false;
-	}
-
-	while (start < size) {
-		const size_t nalStart = start + startCodeLen;
-		size_t nextStartCodeLen = 0;
-		const size_t nextStart = findStartCode(data, size, nalStart, nextStartCodeLen);
-		size_t nalEnd = nextStart;
-
-		// Trim alignment zeros before the next start code.
-		while (nalEnd > nalStart && data[nalEnd - 1] == 0x00) {
-			--nalEnd;
-		}
-
-		if (nalEnd > nalStart) {
-			nalUnits.push_back({data + nalStart, nalEnd - nalStart});
-		}
-
-		if (nextStart == size) {
-			break;
-		}
-
-		start = nextStart;
-		startCodeLen = nextStartCodeLen;
-	}
-
-	return !nalUnits.empty();
-}
-
-bool parseAvccNalus(const uint8_t *data, size_t size, std::vector<NalUnitView> &nalUnits)
-{
-	if (!data || size < 4) {
-		return false;
-	}
-
-	size_t offset = 0;
-	while (offset + 4 <= size) {
-		const uint32_t nalSize =
-		    (static_cast<uint32_t>(data[offset]) << 24) | (static_cast<uint32_t>(data[offset + 1]) << 16) |
-		    (static_cast<uint32_t>(data[offset + 2]) << 8) | static_cast<uint32_t>(data[offset + 3]);
-		offset += 4;
-
-		if (nalSize == 0) {
-			continue;
-		}
-		if (offset + nalSize > size) {
-			return false;
-		}
-
-		nalUnits.push_back({data + offset, nalSize});
-		offset += nalSize;
-	}
-
-	return offset == size && !nalUnits.empty();
-}
-
-bool extractH264Nalus(const uint8_t *data, size_t size, std::vector<NalUnitView> &nalUnits)
-{
-	nalUnits.clear();
-	if (!data || size == 0) {
-		return false;
-	}
-
-	if (parseAnnexBNalus(data, size, nalUnits)) {
-		return true;
-	}
-
-	if (parseAvccNalus(data, size, nalUnits)) {
-		return true;
-	}
-
-	// Fallback: treat as a single NAL payload.
-	nalUnits.push_back({data, size});
-	return true;
-}
-
 bool appendRtpPacket(std::vector<rtc::binary> &packets, uint16_t &sequence, uint32_t timestamp, uint32_t ssrc,
                      bool marker, const uint8_t *payload, size_t payloadSize)
 {
@@ -830,51 +663,55 @@ bool appendRtpPacket(std::vector<rtc::binary> &packets, uint16_t &sequence, uint
 	return true;
 }
 
+// The index must describe these bytes; the frame owner builds it once and
+// every viewer's packetization reuses it.
 bool buildH264FrameRtpPackets(std::vector<rtc::binary> &packets, uint16_t &sequence, uint32_t timestamp, uint32_t ssrc,
-                              const uint8_t *data, size_t size)
+                              const uint8_t *data, const H264NalIndex &nalIndex)
 {
-	std::vector<NalUnitView> nalUnits;
-	if (!extractH264Nalus(data, size, nalUnits)) {
+	const std::vector<H264NalUnit> &nalUnits = nalIndex.units();
+	if (!data || nalUnits.empty()) {
 		return false;
 	}
 
 	for (size_t i = 0; i < nalUnits.size(); ++i) {
-		const NalUnitView &nal = nalUnits[i];
-		if (!nal.data || nal.size == 0) {
+		const H264NalUnit &unit = nalUnits[i];
+		if (unit.size == 0) {
 			continue;
 		}
 
+		const uint8_t *nalData = data + unit.offset;
+		const size_t nalSize = unit.size;
 		const bool lastNalInFrame = (i + 1 == nalUnits.size());
-		if (nal.size <= kMaxRtpPayloadSize) {
-			if (!appendRtpPacket(packets, sequence, timestamp, ssrc, lastNalInFrame, nal.data, nal.size)) {
+		if (nalSize <= kMaxRtpPayloadSize) {
+			if (!appendRtpPacket(packets, sequence, timestamp, ssrc, lastNalInFrame, nalData, nalSize)) {
 				return false;
 			}
 			continue;
 		}
 
 		// FU-A fragmentation for oversized NAL units.
-		if (nal.size <= 1) {
+		if (nalSize <= 1) {
 			continue;
 		}
 
-		const uint8_t nalHeader = nal.data[0];
+		const uint8_t nalHeader = nalData[0];
 		const uint8_t fuIndicator = static_cast<uint8_t>((nalHeader & 0xE0) | kH264FuAType);
 		const uint8_t nalType = static_cast<uint8_t>(nalHeader & 0x1F);
 		const size_t maxChunk = kMaxRtpPayloadSize - 2;
 		size_t offset = 1;
 
-		while (offset < nal.size) {
-			const size_t remaining = nal.size - offset;
+		while (offset < nalSize) {
+			const size_t remaining = nalSize - offset;
 			const size_t chunk = std::min(remaining, maxChunk);
 			const bool start = (offset == 1);
-			const bool end = (offset + chunk >= nal.size);
+			const bool end = (offset + chunk >= nalSize);
 			const bool marker = end && lastNalInFrame;
 
 			std::vector<uint8_t> payload;
 			payload.reserve(2 + chunk);
 			payload.push_back(fuIndicator);
 			payload.push_back(static_cast<uint8_t>(nalType | (start ? 0x80 : 0x00) | (end ? 0x40 : 0x00)));
-			payload.insert(payload.end(), nal.data + offset, nal.data + offset + chunk);
+			payload.insert(payload.end(), nalData + offset, nalData + offset + chunk);
 
 			if (!appendRtpPacket(packets, sequence, timestamp, ssrc, marker, payload.data(), payload.size())) {
 				return false;
@@ -916,6 +753,49 @@ void clearTrackLifecycleCallbacks(const std::shared_ptr<rtc::Track> &track)
 	}
 }
 
+const char *candidateTypeName(rtc::Candidate::Type type)
+{
+	switch (type) {
+	case rtc::Candidate::Type::Host:
+		return "host";
+	case rtc::Candidate::Type::ServerReflexive:
+		return "srflx";
+	case rtc::Candidate::Type::PeerReflexive:
+		return "prflx";
+	case rtc::Candidate::Type::Relayed:
+		return "relay";
+	default:
+		return "unknown";
+	}
+}
+
+// Reported as relay when either side relays, since that is what decides the
+// path cost; otherwise the local type.
+void rememberSelectedCandidateType(const std::shared_ptr<PeerInfo> &peer)
+{
+	std::shared_ptr<rtc::PeerConnection> pc;
+	{
+		std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+		pc = peer->pc;
+	}
+	if (!pc) {
+		return;
+	}
+
+	std::string type = "unknown";
+	try {
+		rtc::Candidate local;
+		rtc::Candidate remote;
+		if (pc->getSelectedCandidatePair(&local, &remote)) {
+			type = remote.type() == rtc::Candidate::Type::Relayed ? "relay" : candidateTypeName(local.type());
+		}
+	} catch (const std::exception &) {
+	}
+
+	std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+	peer->selectedCandidateType = type;
+}
+
 void clearPeerConnectionCallbacks(const std::shared_ptr<rtc::PeerConnection> &pc)
 {
 	if (!pc) {
@@ -964,6 +844,7 @@ void clearDataChannelCallbacks(const std::shared_ptr<rtc::DataChannel> &dataChan
 
 VDONinjaPeerManager::VDONinjaPeerManager()
     : videoPacerBudget_(std::make_shared<RtpSharedPacerBudget>(kAggregateVideoPacerBurstBytes)),
+      joinLatency_(std::make_shared<JoinLatencyTracker>()),
       ownerSession_(std::make_shared<PeerManagerOwnerSession>(this))
 {
 	// Generate random SSRCs for audio/video
@@ -1026,6 +907,8 @@ VDONinjaPeerManager::~VDONinjaPeerManager()
 #endif
 	}
 
+	releaseWarmPublisherPool();
+
 	// Close all peer connections outside the map lock so RTC teardown cannot
 	// re-enter peersMutex_ through a synchronous state callback.
 	std::vector<std::shared_ptr<PeerInfo>> toRelease;
@@ -1219,6 +1102,15 @@ bool VDONinjaPeerManager::startPublishing(int maxViewers)
 	maxViewers_ = maxViewers;
 	audioSendTracker_.reset();
 	takeAudioRedStats();
+	warmPoolSizer_.reset();
+	joinLatency_->reset();
+	videoPacketizeUs_.snapshot(true);
+	{
+		std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+		gopCache_.clear();
+		reportedGopOverflows_ = 0;
+	}
+	takeGopReplayStats();
 	publishing_ = true;
 
 	logInfo("Started publishing, max viewers: %d", maxViewers);
@@ -1231,6 +1123,11 @@ void VDONinjaPeerManager::stopPublishing()
 		return;
 
 	publishing_ = false;
+	releaseWarmPublisherPool();
+	{
+		std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+		gopCache_.invalidate();
+	}
 
 	// Collect peers to close outside the lock to avoid deadlock:
 	// pc->close() triggers onStateChange callback which also acquires peersMutex_.
@@ -1627,7 +1524,13 @@ std::shared_ptr<PeerInfo> VDONinjaPeerManager::createPublisherConnection(const s
 		}
 	}
 
-	logInfo("%s publisher connection for viewer: %s", registerPeer ? "Created" : "Prepared replacement", uuid.c_str());
+	if (uuid.empty()) {
+		logDebug("Prepared pre-warmed publisher connection (generation %llu)",
+		         static_cast<unsigned long long>(peer->generation));
+	} else {
+		logInfo("%s publisher connection for viewer: %s", registerPeer ? "Created" : "Prepared replacement",
+		        uuid.c_str());
+	}
 	return peer;
 }
 
@@ -1679,6 +1582,231 @@ std::shared_ptr<PeerInfo> VDONinjaPeerManager::createViewerConnection(const std:
 	return peer;
 }
 
+std::shared_ptr<PeerInfo> VDONinjaPeerManager::createWarmPublisherConnection()
+{
+	auto peer = createPublisherConnection("", "", nullptr, false);
+	// Create the offer now so ICE gathering overlaps the idle time before a
+	// viewer arrives. localOfferRequested stays false, so the offer is only
+	// cached and gathered candidates stay bundled until the peer is claimed.
+	try {
+		peer->pc->setLocalDescription();
+	} catch (...) {
+		releasePeerResources(peer);
+		{
+			std::lock_guard<std::mutex> candidateLock(candidateMutex_);
+			candidateBundles_.erase(peer->generation);
+		}
+		throw;
+	}
+	return peer;
+}
+
+bool VDONinjaPeerManager::claimWarmPublisherConnection(const std::string &uuid, const std::string &session,
+                                                       std::shared_ptr<PeerInfo> &claimed)
+{
+	std::shared_ptr<PeerInfo> peer;
+	int64_t createdAtMs = 0;
+	{
+		std::lock_guard<std::mutex> poolLock(warmPoolMutex_);
+		for (auto it = warmPublisherPeers_.begin(); it != warmPublisherPeers_.end(); ++it) {
+			const auto &candidate = it->peer;
+			if (!candidate || candidate->cleanupRetired.load() || isTerminalPeerState(candidate->state.load())) {
+				continue;
+			}
+			// Only hand out connections whose offer and candidate gathering have
+			// both finished. Their RTC callbacks have then stopped reading the
+			// peer identity, which is rebound below.
+			if (!candidate->localCandidatesGathered.load(std::memory_order_acquire)) {
+				continue;
+			}
+			{
+				std::lock_guard<std::mutex> negotiationLock(candidate->negotiationMutex);
+				if (candidate->lastLocalOfferSdp.empty()) {
+					continue;
+				}
+			}
+			peer = candidate;
+			createdAtMs = it->createdAtMs;
+			warmPublisherPeers_.erase(it);
+			break;
+		}
+	}
+	if (!peer) {
+		claimed.reset();
+		return false;
+	}
+
+	std::shared_ptr<PeerInfo> concurrentPeer;
+	{
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		auto it = peers_.find(uuid);
+		if (it != peers_.end() && it->second) {
+			concurrentPeer = it->second;
+		} else {
+			// Rebound under the locks that peer readers hold.
+			std::lock_guard<std::mutex> candidateLock(candidateMutex_);
+			peer->uuid = uuid;
+			if (!session.empty()) {
+				peer->session = session;
+			}
+			candidateBundles_[peer->generation].session = peer->session;
+			peer->signalingActive.store(true);
+			peers_[uuid] = peer;
+			++peerGenerationRegistrationCounts_[uuid];
+		}
+	}
+	if (concurrentPeer) {
+		// The pooled peer was never bound, so it stays usable for the next viewer.
+		std::lock_guard<std::mutex> poolLock(warmPoolMutex_);
+		warmPublisherPeers_.push_front({peer, createdAtMs});
+		claimed = concurrentPeer;
+		return false;
+	}
+
+	std::shared_ptr<rtc::DataChannel> pendingDataChannel;
+	{
+		std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+		pendingDataChannel = std::move(peer->pendingPublisherDataChannel);
+		peer->pendingPublisherDataChannel.reset();
+	}
+	if (pendingDataChannel) {
+		handleIncomingDataChannel(peer, pendingDataChannel, true);
+	}
+
+	// The pooled pacer was sized from the encoder rate when it was built.
+	std::shared_ptr<RtpPacketPacer> pacer;
+	{
+		std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+		pacer = peer->videoPacer;
+	}
+	if (pacer) {
+		const int currentEncoderBitrate = bitrate_.load(std::memory_order_acquire);
+		const uint64_t duplicateBitrate =
+		    videoProtectionBitrateForEncoderRate(currentEncoderBitrate, videoProtectionMode_);
+		pacer->updateBitrate(videoPacerBitrateForEncoderAndProtectionRate(currentEncoderBitrate, duplicateBitrate),
+		                     duplicateBitrate);
+	}
+
+	logInfo("Claimed pre-warmed publisher connection for viewer: %s", uuid.c_str());
+	claimed = peer;
+	return true;
+}
+
+void VDONinjaPeerManager::releaseWarmPublisherPool()
+{
+	std::deque<WarmPublisherPeer> pool;
+	{
+		std::lock_guard<std::mutex> poolLock(warmPoolMutex_);
+		pool.swap(warmPublisherPeers_);
+	}
+	if (pool.empty()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> candidateLock(candidateMutex_);
+		for (const auto &entry : pool) {
+			candidateBundles_.erase(entry.peer->generation);
+		}
+	}
+	for (const auto &entry : pool) {
+		releasePeerResources(entry.peer);
+	}
+	logDebug("Released %zu pre-warmed publisher connections", pool.size());
+}
+
+void VDONinjaPeerManager::setWarmPublisherPoolSize(int maxPoolSize)
+{
+	warmPoolSizer_.setMaxPoolSize(static_cast<size_t>(std::max(maxPoolSize, 0)));
+	if (maxPoolSize <= 0) {
+		releaseWarmPublisherPool();
+	}
+}
+
+void VDONinjaPeerManager::maintainWarmPublisherPool()
+{
+	if (!publishing_ || shuttingDown_) {
+		releaseWarmPublisherPool();
+		return;
+	}
+
+	const int64_t now = currentTimeMs();
+	// Pooled connections are a head start for future viewers, not extra slots.
+	const int freeSlots = std::max(maxViewers_ - getPublisherSlotCount(), 0);
+	const size_t target = std::min(warmPoolSizer_.targetSize(now), static_cast<size_t>(freeSlots));
+
+	std::vector<std::shared_ptr<PeerInfo>> expired;
+	size_t ready = 0;
+	{
+		std::lock_guard<std::mutex> poolLock(warmPoolMutex_);
+		for (auto it = warmPublisherPeers_.begin(); it != warmPublisherPeers_.end();) {
+			const auto &peer = it->peer;
+			if (!peer || peer->cleanupRetired.load() || isTerminalPeerState(peer->state.load()) ||
+			    now - it->createdAtMs >= kWarmPublisherMaxAgeMs) {
+				expired.push_back(peer);
+				it = warmPublisherPeers_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		while (warmPublisherPeers_.size() > target) {
+			expired.push_back(warmPublisherPeers_.front().peer);
+			warmPublisherPeers_.pop_front();
+		}
+		ready = warmPublisherPeers_.size();
+	}
+
+	if (!expired.empty()) {
+		{
+			std::lock_guard<std::mutex> candidateLock(candidateMutex_);
+			for (const auto &peer : expired) {
+				if (peer) {
+					candidateBundles_.erase(peer->generation);
+				}
+			}
+		}
+		for (const auto &peer : expired) {
+			releasePeerResources(peer);
+		}
+	}
+
+	size_t created = 0;
+	while (ready + created < target && publishing_ && !shuttingDown_) {
+		std::shared_ptr<PeerInfo> peer;
+		try {
+			peer = createWarmPublisherConnection();
+		} catch (const std::exception &e) {
+			logWarning("Failed to pre-warm publisher connection: %s", e.what());
+			break;
+		} catch (...) {
+			logWarning("Failed to pre-warm publisher connection: unknown exception");
+			break;
+		}
+		{
+			std::lock_guard<std::mutex> poolLock(warmPoolMutex_);
+			warmPublisherPeers_.push_back({peer, currentTimeMs()});
+		}
+		++created;
+	}
+	if (!publishing_ || shuttingDown_) {
+		releaseWarmPublisherPool();
+		return;
+	}
+	if (created != 0) {
+		logDebug("Pre-warmed %zu publisher connections (pool target %zu)", created, target);
+	}
+}
+
+size_t VDONinjaPeerManager::getWarmPublisherPoolCount() const
+{
+	std::lock_guard<std::mutex> poolLock(warmPoolMutex_);
+	return warmPublisherPeers_.size();
+}
+
+JoinLatencyStats VDONinjaPeerManager::takeJoinLatencyStats()
+{
+	return joinLatency_->take();
+}
+
 void VDONinjaPeerManager::installLocalDescriptionCallback(const std::shared_ptr<PeerInfo> &peer)
 {
 	if (!peer || !peer->pc || peer->localDescriptionCallbackInstalled) {
@@ -1734,10 +1862,11 @@ void VDONinjaPeerManager::installLocalDescriptionCallback(const std::shared_ptr<
 					if (peer->cleanupRetired.load() || !peer->signalingActive.load()) {
 						break;
 					}
-					manager->signaling_->sendOffer(uuid, sdp, peer->session);
+					manager->signaling_->sendOffer(peer->uuid, sdp, peer->session);
 					peer->localOfferDispatched.store(true);
 				}
-				logInfo("Sent offer to %s (session %s)", uuid.c_str(), peer->session.c_str());
+				manager->joinLatency_->mark(peer->generation, JoinLatencyStage::OfferSent, currentTimeMs());
+				logInfo("Sent offer to %s (session %s)", peer->uuid.c_str(), peer->session.c_str());
 				break;
 			case rtc::Description::Type::Answer:
 				if (peer->type != ConnectionType::Viewer) {
@@ -1785,7 +1914,7 @@ void VDONinjaPeerManager::setupPeerConnectionCallbacks(std::shared_ptr<PeerInfo>
 	const std::weak_ptr<PeerManagerOwnerSession> weakOwnerSession = ownerSession;
 	std::string uuid = peer->uuid;
 
-	peer->pc->onStateChange([weakOwnerSession, weakPeer, uuid, pcHandle](rtc::PeerConnection::State state) {
+	peer->pc->onStateChange([weakOwnerSession, weakPeer, pcHandle](rtc::PeerConnection::State state) {
 		auto permit = PeerManagerOwnerSession::acquire(weakOwnerSession, PeerManagerCompletionKind::PeerConnectionState,
 		                                               pcHandle);
 		if (!permit) {
@@ -1802,6 +1931,9 @@ void VDONinjaPeerManager::setupPeerConnectionCallbacks(std::shared_ptr<PeerInfo>
 			if (peer->cleanupRetired.load() || !manager->isCurrentPeer(peer)) {
 				return;
 			}
+			// Read the identity only once registered: pre-warmed publisher
+			// connections are bound to their viewer after callbacks are installed.
+			const std::string uuid = peer->uuid;
 
 			switch (state) {
 			case rtc::PeerConnection::State::New:
@@ -1814,8 +1946,10 @@ void VDONinjaPeerManager::setupPeerConnectionCallbacks(std::shared_ptr<PeerInfo>
 			case rtc::PeerConnection::State::Connected: {
 				peer->state = ConnectionState::Connected;
 				peer->terminalStateTimeMs.store(0);
+				rememberSelectedCandidateType(peer);
 				peer->disconnectNotified.store(false);
 				peer->cleanupRetired.store(false);
+				manager->joinLatency_->mark(peer->generation, JoinLatencyStage::Connected, currentTimeMs());
 				logInfo("Peer %s connected", uuid.c_str());
 				OnPeerConnectedCallback cb;
 				{
@@ -1915,10 +2049,15 @@ void VDONinjaPeerManager::setupPeerConnectionCallbacks(std::shared_ptr<PeerInfo>
 				    return;
 			    }
 			    if (state == rtc::PeerConnection::GatheringState::Complete) {
-				    logInfo("ICE gathering complete for %s", uuid.c_str());
 				    auto peer = weakPeer.lock();
 				    if (peer) {
+					    if (uuid.empty()) {
+						    logDebug("ICE gathering complete for pre-warmed publisher connection");
+					    } else {
+						    logInfo("ICE gathering complete for %s", uuid.c_str());
+					    }
 					    manager->bundleAndSendCandidates(peer);
+					    peer->localCandidatesGathered.store(true, std::memory_order_release);
 				    }
 			    }
 		    });
@@ -3239,8 +3378,7 @@ void VDONinjaPeerManager::setupPublisherTracks(std::shared_ptr<PeerInfo> peer)
 	const auto ownerSession = ownerSession_;
 	const std::weak_ptr<PeerManagerOwnerSession> weakOwnerSession = ownerSession;
 	const void *videoFeedbackHandle = videoTrack.get();
-	std::function<void()> videoFeedbackCompletion = [weakOwnerSession, weakPeer, uuid = peer->uuid,
-	                                                 videoFeedbackHandle]() {
+	std::function<void()> videoFeedbackCompletion = [weakOwnerSession, weakPeer, videoFeedbackHandle]() {
 		auto permit = PeerManagerOwnerSession::acquire(weakOwnerSession, PeerManagerCompletionKind::VideoFeedback,
 		                                               videoFeedbackHandle);
 		if (!permit) {
@@ -3256,6 +3394,7 @@ void VDONinjaPeerManager::setupPublisherTracks(std::shared_ptr<PeerInfo> peer)
 			    !manager->isCurrentPeer(peer)) {
 				return;
 			}
+			const std::string uuid = peer->uuid;
 			size_t discardedFrames = 0;
 			size_t discardedPackets = 0;
 			{
@@ -3327,6 +3466,10 @@ void VDONinjaPeerManager::setupPublisherTracks(std::shared_ptr<PeerInfo> peer)
 		    return pacerTrack->send(std::move(packet));
 	    },
 	    0, videoPacerBudget_, duplicationConfig);
+	{
+		std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+		peer->videoPacer->setSharedBudgetWeight(peer->videoPacerWeight);
+	}
 	peer->videoSrReporter->addToChain(std::make_shared<RtcpTelemetryHandler>(peer->videoFeedbackTracker));
 	peer->videoSrReporter->addToChain(
 	    std::make_shared<PacedNackResponder>(videoSsrc_, peer->videoPacer, peer->videoFeedbackTracker));
@@ -3394,32 +3537,34 @@ void VDONinjaPeerManager::setupPublisherTracks(std::shared_ptr<PeerInfo> peer)
 	if (enableDataChannel_) {
 		// VDO.Ninja expects publisher data channels to use "sendChannel".
 		auto dc = peer->pc->createDataChannel("sendChannel");
-		handleIncomingDataChannel(peer, dc, true);
+		if (peer->uuid.empty()) {
+			// Pre-warmed connection: the channel must be in the offer, but its
+			// lease is keyed by viewer and is taken when the peer is claimed.
+			std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+			peer->pendingPublisherDataChannel = dc;
+		} else {
+			handleIncomingDataChannel(peer, dc, true);
+		}
 	}
 
 	logDebug("Set up publisher tracks for %s", peer->uuid.c_str());
 }
 
-void VDONinjaPeerManager::prepareViewerTracks(const std::shared_ptr<PeerInfo> &peer, const std::string &offerSdp)
+void VDONinjaPeerManager::prepareViewerTracks(const std::shared_ptr<PeerInfo> &peer, const SdpDocument &offer)
 {
-	if (!peer || !peer->pc || offerSdp.empty()) {
+	if (!peer || !peer->pc || offer.size() == 0) {
 		logWarning("Skipping native recvonly track preparation because peer or SDP was empty");
 		return;
 	}
 
-	const auto offeredSections = parseOfferedMediaSections(offerSdp);
+	const auto offeredSections = offer.offeredMediaSections();
 	logInfo("Native viewer offer for %s parsed into %zu media sections: %s", peer->uuid.c_str(), offeredSections.size(),
 	        describeOfferedSections(offeredSections).c_str());
 	if (offeredSections.empty()) {
-		const bool hasActualLineBreaks =
-		    offerSdp.find('\n') != std::string::npos || offerSdp.find('\r') != std::string::npos;
-		const bool hasEscapedLineBreaks = offerSdp.find("\\r\\n") != std::string::npos ||
-		                                  offerSdp.find("\\n") != std::string::npos ||
-		                                  offerSdp.find("\\r") != std::string::npos;
 		logWarning("Native viewer offer for %s contained no audio/video media sections (bytes=%zu, actual_newlines=%s, "
 		           "escaped_newlines=%s)",
-		           peer->uuid.c_str(), offerSdp.size(), hasActualLineBreaks ? "yes" : "no",
-		           hasEscapedLineBreaks ? "yes" : "no");
+		           peer->uuid.c_str(), offer.size(), offer.hasLineBreaks() ? "yes" : "no",
+		           offer.receivedEscapedLineEndings() ? "yes" : "no");
 	}
 	const bool alphaSectionActive = offerHasActiveVp9AlphaSection(offeredSections);
 	TrackSlotEvent retiredAlphaEvent;
@@ -3563,6 +3708,14 @@ void VDONinjaPeerManager::prepareViewerTracks(const std::shared_ptr<PeerInfo> &p
 
 				rtc::Description::Audio receiveAudio(section.mid.empty() ? "audio" : section.mid,
 				                                     rtc::Description::Direction::RecvOnly);
+				// Listing RED first asks the sender to wrap Opus in RFC 2198 so the
+				// native receiver can fill lost frames from the redundant copies.
+				const int redPayloadType = findOfferedAudioRedPayloadType(section, audioCodec->payloadType);
+				if (redPayloadType >= 0) {
+					const std::string redFormat =
+					    std::to_string(audioCodec->payloadType) + "/" + std::to_string(audioCodec->payloadType);
+					receiveAudio.addAudioCodec(redPayloadType, "red", redFormat);
+				}
 				if (audioCodec->formatParameters.empty()) {
 					receiveAudio.addOpusCodec(audioCodec->payloadType);
 				} else {
@@ -3577,8 +3730,8 @@ void VDONinjaPeerManager::prepareViewerTracks(const std::shared_ptr<PeerInfo> &p
 					rejectedTrack = track;
 				}
 				if (installed) {
-					logInfo("Prepared native recvonly audio track for %s (mid=%s)", peer->uuid.c_str(),
-					        track ? track->mid().c_str() : "");
+					logInfo("Prepared native recvonly audio track for %s (mid=%s, %s)", peer->uuid.c_str(),
+					        track ? track->mid().c_str() : "", redPayloadType >= 0 ? "Opus with RED" : "Opus");
 					dispatchCommittedTrackSlotEvent(peer, installedEvent);
 				}
 				clearTrackCallbacks(rejectedTrack);
@@ -3636,20 +3789,21 @@ void VDONinjaPeerManager::onSignalingOffer(const std::string &uuid, const std::s
 	}
 	consumePendingViewerSignalingDataChannel(peer, session);
 
-	// Set remote description (the offer)
-	const std::string constrainedSdp = normalizeEscapedSdpLineEndings(constrainViewerOfferToNativeCodecs(sdp));
+	// Set remote description (the offer). The offer is parsed once: the
+	// transport-cc strip edits the model, track preparation reads its media
+	// sections, and it is serialized once for libdatachannel.
+	SdpDocument offer(sdp);
+	if (stripUnsupportedTransportCcFeedback(offer)) {
+		logInfo("Stripped transport-cc feedback/extensions unsupported by the native receiver");
+	}
+	const std::string constrainedSdp = offer.serialize();
 	peer->remoteDescriptionSet.store(false);
 	try {
-		const bool hasActualLineBreaks =
-		    constrainedSdp.find('\n') != std::string::npos || constrainedSdp.find('\r') != std::string::npos;
-		const bool hasEscapedLineBreaks = constrainedSdp.find("\\r\\n") != std::string::npos ||
-		                                  constrainedSdp.find("\\n") != std::string::npos ||
-		                                  constrainedSdp.find("\\r") != std::string::npos;
 		logInfo("Applying native viewer offer for %s (session=%s, bytes=%zu, actual_newlines=%s, escaped_newlines=%s, "
 		        "signaling=%d)",
-		        uuid.c_str(), session.c_str(), constrainedSdp.size(), hasActualLineBreaks ? "yes" : "no",
-		        hasEscapedLineBreaks ? "yes" : "no", static_cast<int>(peer->pc->signalingState()));
-		prepareViewerTracks(peer, constrainedSdp);
+		        uuid.c_str(), session.c_str(), constrainedSdp.size(), offer.hasLineBreaks() ? "yes" : "no",
+		        offer.receivedEscapedLineEndings() ? "yes" : "no", static_cast<int>(peer->pc->signalingState()));
+		prepareViewerTracks(peer, offer);
 		bool hasVideoTrack = false;
 		bool hasAlphaVideoTrack = false;
 		bool hasAudioTrack = false;
@@ -3728,6 +3882,7 @@ void VDONinjaPeerManager::onSignalingAnswer(const std::string &uuid, const std::
 		}
 		peer->pc->setRemoteDescription(rtc::Description(sdp, rtc::Description::Type::Answer));
 		peer->remoteDescriptionSet.store(true);
+		joinLatency_->mark(peer->generation, JoinLatencyStage::AnswerReceived, currentTimeMs());
 		drainPendingRemoteIceCandidates(peer);
 		if (audioRedEnabled_.load(std::memory_order_acquire)) {
 			logInfo("Set remote answer for %s; audio transport negotiated %s", uuid.c_str(),
@@ -3754,6 +3909,7 @@ void VDONinjaPeerManager::onSignalingOfferRequest(const std::string &uuid, const
 		return;
 	}
 
+	const int64_t requestedAtMs = currentTimeMs();
 	std::shared_ptr<PeerInfo> peer;
 	std::shared_ptr<PeerInfo> stalePeer;
 	std::string staleReason;
@@ -3792,7 +3948,14 @@ void VDONinjaPeerManager::onSignalingOfferRequest(const std::string &uuid, const
 			logWarning("Rejecting offer request from %s - max viewers reached (%d)", uuid.c_str(), maxViewers_);
 			return;
 		}
-		peer = createPublisherConnection(uuid, session);
+		warmPoolSizer_.noteJoin(requestedAtMs);
+		// A peer registered by a concurrent request is already being timed.
+		if (claimWarmPublisherConnection(uuid, session, peer)) {
+			joinLatency_->begin(peer->generation, requestedAtMs, true);
+		} else if (!peer) {
+			peer = createPublisherConnection(uuid, session);
+			joinLatency_->begin(peer->generation, requestedAtMs, false);
+		}
 	}
 
 	// Ignore duplicate offer requests for a peer/session that is already negotiating
@@ -3861,6 +4024,12 @@ void VDONinjaPeerManager::onSignalingOfferRequest(const std::string &uuid, const
 		} else {
 			peer->pc->setLocalDescription();
 		}
+		if (!cachedOffer.empty()) {
+			joinLatency_->mark(peer->generation, JoinLatencyStage::OfferSent, currentTimeMs());
+			// A pre-warmed connection gathered its candidates before it had a
+			// viewer; they can only follow the offer they belong to.
+			bundleAndSendCandidates(peer);
+		}
 	} catch (const std::exception &e) {
 		peer->localOfferRequested.store(false);
 		{
@@ -4119,13 +4288,32 @@ bool VDONinjaPeerManager::sendAudioFrameToPeer(const std::string &uuid, const st
 	}
 }
 
-void VDONinjaPeerManager::sendVideoFrame(const uint8_t *data, size_t size, uint32_t timestamp, bool keyframe)
+void VDONinjaPeerManager::sendVideoFrame(const uint8_t *data, size_t size, uint32_t timestamp, bool keyframe,
+                                         bool recoveryPoint, const H264NalIndex *nalIndex)
 {
 	if (!publishing_)
 		return;
 
+	H264NalIndex localIndex;
+	if (!nalIndex) {
+		localIndex.build(data, size);
+		nalIndex = &localIndex;
+	}
+
 	pruneRetiredPeers(kRetiredPeerCleanupDelayMs);
 
+	// Taken before the target snapshot: a viewer primed before this frame is
+	// connected and receives it live, one primed after gets it in the replay.
+	std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+	if (recoveryPoint) {
+		// A replay has to start on an IDR; with intra refresh those stop
+		// after the first, and joiners resume from the next recovery point
+		// behind the cached keyframe instead.
+		gopCache_.invalidate();
+	} else if (gopFastStartEnabled_.load(std::memory_order_acquire)) {
+		gopCache_.append(std::make_shared<const std::vector<uint8_t>>(data, data + size), timestamp, keyframe);
+	}
+
 	std::vector<std::pair<std::string, std::shared_ptr<PeerInfo>>> targets;
 	{
 		std::lock_guard<std::mutex> lock(peersMutex_);
@@ -4139,12 +4327,18 @@ void VDONinjaPeerManager::sendVideoFrame(const uint8_t *data, size_t size, uint3
 	}
 
 	for (auto &target : targets) {
-		sendVideoFrameToPeerHandle(target.first, target.second, data, size, timestamp, keyframe);
+		sendVideoFrameToPeerHandle(target.first, target.second, data, size, timestamp, keyframe, false,
+		                           recoveryPoint, nalIndex);
 	}
 }
 
 void VDONinjaPeerManager::requireLiveKeyframeForAll()
 {
+	{
+		std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+		gopCache_.invalidate();
+	}
+
 	std::vector<std::shared_ptr<PeerInfo>> targets;
 	{
 		std::lock_guard<std::mutex> lock(peersMutex_);
@@ -4203,6 +4397,89 @@ bool VDONinjaPeerManager::sendVideoFrameToPeer(const std::string &uuid, const ui
 	return sendVideoFrameToPeerHandle(uuid, peer, data, size, timestamp, keyframe, cachedReplay);
 }
 
+bool VDONinjaPeerManager::primePeerWithCachedGop(const std::string &uuid)
+{
+	if (!publishing_ || uuid.empty() || !gopFastStartEnabled_.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	std::shared_ptr<PeerInfo> peer;
+	{
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		auto it = peers_.find(uuid);
+		if (it == peers_.end()) {
+			return false;
+		}
+		peer = it->second;
+	}
+	if (!peer) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+	std::lock_guard<std::mutex> sendLock(peer->videoSendMutex);
+	std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+	if (peer->cleanupRetired.load() || peer->type != ConnectionType::Publisher ||
+	    peer->state != ConnectionState::Connected || !peer->videoSendEnabled || !peer->videoTrack ||
+	    !peer->videoPacer) {
+		return false;
+	}
+	if (!peer->videoKeyframeGate.canReplayCachedGop()) {
+		return false;
+	}
+
+	// The replay drains through the viewer's own pacer, which runs with
+	// headroom over the encoder rate; that headroom is the catch-up rate.
+	const uint64_t encoderBitrate = static_cast<uint64_t>(std::max(bitrate_.load(std::memory_order_acquire), 1));
+	const std::vector<GopCacheFrame> frames =
+	    gopCache_.replayFrames(peer->videoPacer->bitrateBitsPerSecond(), encoderBitrate);
+	if (frames.empty()) {
+		gopStillFallbacks_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Original timestamps and this peer's next sequence numbers, so the last
+	// replayed frame is followed seamlessly by the next live one.
+	size_t replayedBytes = 0;
+	for (const GopCacheFrame &frame : frames) {
+		if (!queueVideoFrameLocked(uuid, peer, frame.payload->data(), frame.payload->size(), frame.timestamp,
+		                           frame.keyframe, false)) {
+			// A failed enqueue has already closed the gate until the next
+			// live keyframe.
+			return false;
+		}
+		replayedBytes += frame.payload->size();
+	}
+	gopReplays_.fetch_add(1, std::memory_order_relaxed);
+	gopReplayedFrames_.fetch_add(frames.size(), std::memory_order_relaxed);
+	gopReplayedBytes_.fetch_add(replayedBytes, std::memory_order_relaxed);
+	logInfo("Primed viewer %s with the current GOP (%zu frames, %zu KB)", uuid.c_str(), frames.size(),
+	        replayedBytes / 1024);
+	return true;
+}
+
+void VDONinjaPeerManager::setGopFastStartEnabled(bool enable)
+{
+	gopFastStartEnabled_.store(enable, std::memory_order_release);
+	if (!enable) {
+		std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+		gopCache_.invalidate();
+	}
+}
+
+GopReplayStats VDONinjaPeerManager::takeGopReplayStats()
+{
+	GopReplayStats stats;
+	stats.replays = gopReplays_.exchange(0, std::memory_order_relaxed);
+	stats.replayedFrames = gopReplayedFrames_.exchange(0, std::memory_order_relaxed);
+	stats.replayedBytes = gopReplayedBytes_.exchange(0, std::memory_order_relaxed);
+	stats.stillFallbacks = gopStillFallbacks_.exchange(0, std::memory_order_relaxed);
+	std::lock_guard<std::mutex> gopLock(gopCacheMutex_);
+	stats.overflows = gopCache_.overflows() - reportedGopOverflows_;
+	reportedGopOverflows_ = gopCache_.overflows();
+	return stats;
+}
+
 bool VDONinjaPeerManager::notePeerKeyframeRequest(const std::string &uuid)
 {
 	if (!publishing_ || uuid.empty()) {
@@ -4244,112 +4521,179 @@ bool VDONinjaPeerManager::notePeerKeyframeRequest(const std::string &uuid)
 	return true;
 }
 
-bool VDONinjaPeerManager::sendVideoFrameToPeerHandle(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer,
-                                                     const uint8_t *data, size_t size, uint32_t timestamp,
-                                                     bool keyframe, bool cachedReplay)
+bool VDONinjaPeerManager::isPeerAwaitingLiveKeyframe(const std::string &uuid) const
 {
-	if (!peer || !data || size == 0) {
+	std::shared_ptr<PeerInfo> peer;
+	{
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		auto it = peers_.find(uuid);
+		if (it == peers_.end()) {
+			return false;
+		}
+		peer = it->second;
+	}
+	if (!peer || peer->type != ConnectionType::Publisher) {
 		return false;
 	}
-	std::lock_guard<std::mutex> sendLock(peer->videoSendMutex);
+	std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+	return peer->videoKeyframeGate.isAwaitingKeyframe();
+}
 
-	std::vector<RtpPacketPacer::Packet> packets;
+bool VDONinjaPeerManager::setViewerPacerRole(const std::string &uuid, ViewerPacerRole role)
+{
+	std::shared_ptr<PeerInfo> peer;
 	{
-		std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
-		if (peer->cleanupRetired.load() || peer->type != ConnectionType::Publisher ||
-		    peer->state != ConnectionState::Connected) {
-			return false;
-		}
-		if (!peer->videoSendEnabled) {
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		auto it = peers_.find(uuid);
+		if (it == peers_.end()) {
 			return false;
 		}
+		peer = it->second;
+	}
+	if (!peer || peer->type != ConnectionType::Publisher) {
+		return false;
+	}
+	const uint32_t weight = pacerWeightForViewerRole(role);
+	std::shared_ptr<RtpPacketPacer> pacer;
+	{
+		std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+		peer->videoPacerWeight = weight;
+		pacer = peer->videoPacer;
+	}
+	if (pacer) {
+		pacer->setSharedBudgetWeight(weight);
+	}
+	return true;
+}
 
-		if (!peer->videoKeyframeGate.canQueueFrame(keyframe, cachedReplay)) {
-			return false;
-		}
+bool VDONinjaPeerManager::sendVideoFrameToPeerHandle(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer,
+                                                     const uint8_t *data, size_t size, uint32_t timestamp,
+                                                     bool keyframe, bool cachedReplay, bool recoveryPoint,
+                                                     const H264NalIndex *nalIndex)
+{
+	if (!peer || !data || size == 0) {
+		return false;
+	}
+	std::lock_guard<std::mutex> sendLock(peer->videoSendMutex);
+	std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+	if (peer->cleanupRetired.load() || peer->type != ConnectionType::Publisher ||
+	    peer->state != ConnectionState::Connected) {
+		return false;
+	}
+	if (!peer->videoSendEnabled) {
+		return false;
+	}
+	return queueVideoFrameLocked(uuid, peer, data, size, timestamp, keyframe, cachedReplay, recoveryPoint,
+	                             nalIndex);
+}
 
-		const auto pacer = peer->videoPacer;
-		if (!peer->videoTrack || !pacer) {
-			return false;
-		}
+bool VDONinjaPeerManager::queueVideoFrameLocked(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer,
+                                                const uint8_t *data, size_t size, uint32_t timestamp, bool keyframe,
+                                                bool cachedReplay, bool recoveryPoint,
+                                                const H264NalIndex *nalIndex)
+{
+	// From here on a recovery point this peer can resume from is its
+	// keyframe, including in the pacer, which keeps it ahead of stale deltas.
+	keyframe = peer->videoKeyframeGate.isEntryPoint(keyframe, recoveryPoint);
+	if (!peer->videoKeyframeGate.canQueueFrame(keyframe, cachedReplay)) {
+		return false;
+	}
 
-		const uint32_t ts = timestamp ? timestamp : peer->videoTimestamp;
-		uint16_t nextSequence = peer->videoSeq;
-		if (!buildH264FrameRtpPackets(packets, nextSequence, ts, videoSsrc_, data, size)) {
-			peer->videoKeyframeGate.requireLiveKeyframe();
-			size_t discardedPackets = 0;
-			pacer->discardQueuedMediaFramesAfterCurrent(&discardedPackets);
-			reclaimDiscardedVideoSequenceNumbers(*peer, discardedPackets);
-			logWarning("Could not packetize a complete H.264 frame for viewer %s; waiting for a live keyframe",
-			           uuid.c_str());
-			return false;
-		}
+	const auto pacer = peer->videoPacer;
+	if (!peer->videoTrack || !pacer) {
+		return false;
+	}
 
-		const bool wasAwaitingKeyframe = peer->videoKeyframeGate.isAwaitingKeyframe();
-		VideoKeyframeGate::KeyframeTicket keyframeTicket = 0;
-		if (keyframe) {
-			keyframeTicket = peer->videoKeyframeGate.onKeyframeQueued(cachedReplay);
-		}
-
-		const std::weak_ptr<PeerInfo> weakPeer = peer;
-		const std::weak_ptr<RtpPacketPacer> weakPacer = pacer;
-		RtpPacerFrameInfo frameInfo;
-		frameInfo.keyframe = keyframe;
-		frameInfo.timestamp = ts;
-		if (!pacer->enqueueFrame(
-		        std::move(packets), frameInfo,
-		        [weakPeer, weakPacer, uuid, cachedReplay, wasAwaitingKeyframe,
-		         keyframeTicket](const RtpPacerFrameResult &result) {
-			        const auto peer = weakPeer.lock();
-			        if (!peer || peer->cleanupRetired.load()) {
-				        return;
-			        }
+	const uint32_t ts = timestamp ? timestamp : peer->videoTimestamp;
+	uint16_t nextSequence = peer->videoSeq;
+	std::vector<RtpPacketPacer::Packet> packets;
+	const auto packetizeStartedAt = std::chrono::steady_clock::now();
+	H264NalIndex localIndex;
+	if (!nalIndex) {
+		localIndex.build(data, size);
+		nalIndex = &localIndex;
+	}
+	const bool packetized = buildH264FrameRtpPackets(packets, nextSequence, ts, videoSsrc_, data, *nalIndex);
+	videoPacketizeUs_.record(elapsedMicroseconds(std::chrono::steady_clock::now(), packetizeStartedAt));
+	if (!packetized) {
+		peer->videoKeyframeGate.requireLiveKeyframe();
+		size_t discardedPackets = 0;
+		pacer->discardQueuedMediaFramesAfterCurrent(&discardedPackets);
+		reclaimDiscardedVideoSequenceNumbers(*peer, discardedPackets);
+		logWarning("Could not packetize a complete H.264 frame for viewer %s; waiting for a live keyframe",
+		           uuid.c_str());
+		return false;
+	}
+
+	const bool wasAwaitingKeyframe = peer->videoKeyframeGate.isAwaitingKeyframe();
+	VideoKeyframeGate::KeyframeTicket keyframeTicket = 0;
+	if (keyframe) {
+		keyframeTicket = peer->videoKeyframeGate.onKeyframeQueued(cachedReplay);
+	}
 
-			        bool recovered = false;
-			        size_t discardedFrames = 0;
+	const std::weak_ptr<PeerInfo> weakPeer = peer;
+	const std::weak_ptr<RtpPacketPacer> weakPacer = pacer;
+	const std::shared_ptr<JoinLatencyTracker> joinLatency = joinLatency_;
+	const uint64_t generation = peer->generation;
+	RtpPacerFrameInfo frameInfo;
+	frameInfo.keyframe = keyframe;
+	frameInfo.timestamp = ts;
+	if (!pacer->enqueueFrame(
+	        std::move(packets), frameInfo,
+	        [weakPeer, weakPacer, joinLatency, generation, uuid, cachedReplay, wasAwaitingKeyframe,
+	         keyframeTicket](const RtpPacerFrameResult &result) {
+		        const auto peer = weakPeer.lock();
+		        if (!peer || peer->cleanupRetired.load()) {
+			        return;
+		        }
+
+		        bool recovered = false;
+		        size_t discardedFrames = 0;
+		        {
+			        std::lock_guard<std::mutex> sendLock(peer->videoSendMutex);
 			        {
-				        std::lock_guard<std::mutex> sendLock(peer->videoSendMutex);
-				        {
-					        std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
-					        if (result.info.keyframe) {
-						        recovered = peer->videoKeyframeGate.onKeyframeSendCompleted(
-						            keyframeTicket, result.success, cachedReplay);
-					        } else if (!result.success) {
-						        peer->videoKeyframeGate.requireLiveKeyframe(true);
-					        }
-				        }
-				        if (!result.success) {
-					        if (const auto activePacer = weakPacer.lock()) {
-						        discardedFrames = activePacer->discardQueuedDeltaFramesUntilKeyframe();
-					        }
+				        std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+				        if (result.info.keyframe) {
+					        recovered = peer->videoKeyframeGate.onKeyframeSendCompleted(
+					            keyframeTicket, result.success, cachedReplay);
+				        } else if (!result.success) {
+					        peer->videoKeyframeGate.requireLiveKeyframe(true);
 				        }
 			        }
-
 			        if (!result.success) {
-				        logWarning(
-				            "Video RTP transport rejected a frame for viewer %s after %llu packets; discarded %zu "
-				            "stale queued frames and waiting for a live keyframe",
-				            uuid.c_str(), static_cast<unsigned long long>(result.sentPackets), discardedFrames);
-			        } else if (result.info.keyframe && recovered && wasAwaitingKeyframe) {
-				        logInfo("Viewer %s synchronized on fully sent %s keyframe in %llu ms", uuid.c_str(),
-				                cachedReplay ? "cached" : "live",
-				                static_cast<unsigned long long>(result.sendDurationMs));
+				        if (const auto activePacer = weakPacer.lock()) {
+					        discardedFrames = activePacer->discardQueuedDeltaFramesUntilKeyframe();
+				        }
 			        }
-		        })) {
-			// A partially-sent encoded frame would invalidate the remainder of
-			// the GOP, so enqueue is all-or-nothing. Suppress deltas until the
-			// next live encoder keyframe if the bounded queue ever fills.
-			peer->videoKeyframeGate.requireLiveKeyframe();
-			size_t discardedPackets = 0;
-			pacer->discardQueuedMediaFramesAfterCurrent(&discardedPackets);
-			reclaimDiscardedVideoSequenceNumbers(*peer, discardedPackets);
-			logWarning("Dropped complete video frame for viewer %s because its RTP pacer queue is full", uuid.c_str());
-			return false;
-		}
-
-		peer->videoSeq = nextSequence;
-		peer->videoTimestamp = ts + 3000; // 90kHz clock, ~30fps fallback cadence
+		        }
+
+		        if (result.success && result.info.keyframe && recovered) {
+			        joinLatency->mark(generation, JoinLatencyStage::FirstKeyframe, currentTimeMs());
+		        }
+		        if (!result.success) {
+			        logWarning(
+			            "Video RTP transport rejected a frame for viewer %s after %llu packets; discarded %zu "
+			            "stale queued frames and waiting for a live keyframe",
+			            uuid.c_str(), static_cast<unsigned long long>(result.sentPackets), discardedFrames);
+		        } else if (result.info.keyframe && recovered && wasAwaitingKeyframe) {
+			        logInfo("Viewer %s synchronized on fully sent %s keyframe in %llu ms", uuid.c_str(),
+			                cachedReplay ? "cached" : "live",
+			                static_cast<unsigned long long>(result.sendDurationMs));
+		        }
+	        })) {
+		// A partially-sent encoded frame would invalidate the remainder of
+		// the GOP, so enqueue is all-or-nothing. Suppress deltas until the
+		// next live encoder keyframe if the bounded queue ever fills.
+		peer->videoKeyframeGate.requireLiveKeyframe();
+		size_t discardedPackets = 0;
+		pacer->discardQueuedMediaFramesAfterCurrent(&discardedPackets);
+		reclaimDiscardedVideoSequenceNumbers(*peer, discardedPackets);
+		logWarning("Dropped complete video frame for viewer %s because its RTP pacer queue is full", uuid.c_str());
+		return false;
 	}
+
+	peer->videoSeq = nextSequence;
+	peer->videoTimestamp = ts + 3000; // 90kHz clock, ~30fps fallback cadence
 	return true;
 }
 
@@ -4497,6 +4841,7 @@ void VDONinjaPeerManager::releasePeerResources(const std::shared_ptr<PeerInfo> &
 		peer->videoTrack.reset();
 		peer->alphaVideoTrack.reset();
 		peer->signalingDataChannel.reset();
+		peer->pendingPublisherDataChannel.reset();
 		peer->signalingDataChannelTransportUuid.clear();
 		peer->signalingDataChannelTransportGeneration = 0;
 		peer->signalingDataChannelRevision = 0;
@@ -4546,6 +4891,7 @@ void VDONinjaPeerManager::retirePeerForDeferredCleanup(const std::string &uuid,
 	}
 
 	const bool alreadyRetired = peer->cleanupRetired.exchange(true);
+	joinLatency_->abandon(peer->generation);
 	{
 		std::lock_guard<std::mutex> lock(peersMutex_);
 		std::lock_guard<std::mutex> candidateLock(candidateMutex_);
@@ -4865,7 +5211,7 @@ void VDONinjaPeerManager::receiveNativeMediaTestTrack(const std::shared_ptr<Peer
 void VDONinjaPeerManager::prepareNativeMediaTestViewerTracks(const std::shared_ptr<PeerInfo> &peer,
                                                              const std::string &offerSdp)
 {
-	prepareViewerTracks(peer, offerSdp);
+	prepareViewerTracks(peer, SdpDocument(offerSdp));
 }
 
 void VDONinjaPeerManager::retireNativeMediaTestPeer(const std::shared_ptr<PeerInfo> &peer)
@@ -5441,6 +5787,43 @@ std::optional<uint64_t> VDONinjaPeerManager::minimumRecentRembBitrate(std::chron
 	return minimum;
 }
 
+std::vector<ViewerCongestionFeedback>
+VDONinjaPeerManager::recentViewerCongestionFeedback(std::chrono::milliseconds maxAge) const
+{
+	std::vector<std::pair<std::string, std::shared_ptr<RtcpFeedbackTracker>>> trackers;
+	{
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		trackers.reserve(peers_.size());
+		for (const auto &entry : peers_) {
+			const auto &peer = entry.second;
+			if (!peer || peer->type != ConnectionType::Publisher || peer->state != ConnectionState::Connected) {
+				continue;
+			}
+			std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+			if (peer->videoFeedbackTracker) {
+				trackers.emplace_back(peer->uuid, peer->videoFeedbackTracker);
+			}
+		}
+	}
+
+	std::vector<ViewerCongestionFeedback> feedback;
+	feedback.reserve(trackers.size());
+	for (const auto &entry : trackers) {
+		ViewerCongestionFeedback viewer;
+		viewer.viewerId = entry.first;
+		if (const auto remb = entry.second->latestRemb(maxAge)) {
+			viewer.rembBitsPerSecond = remb->bitrateBitsPerSecond;
+		}
+		if (const auto report = entry.second->latestReceiverReport(maxAge)) {
+			viewer.reportSequence = report->sequence;
+			viewer.fractionLost = report->fractionLost;
+			viewer.rttMs = report->rttMs;
+		}
+		feedback.push_back(std::move(viewer));
+	}
+	return feedback;
+}
+
 RtpPacerStats VDONinjaPeerManager::takeVideoPacerStats()
 {
 	std::vector<std::shared_ptr<RtpPacketPacer>> pacers;
@@ -5488,10 +5871,101 @@ RtpPacerStats VDONinjaPeerManager::takeVideoPacerStats()
 		combined.expiredDuplicates += snapshot.expiredDuplicates;
 		combined.failedDuplicates += snapshot.failedDuplicates;
 		combined.sentDuplicateBytes += snapshot.sentDuplicateBytes;
+		combined.frameHoldUs.merge(snapshot.frameHoldUs);
+		combined.sendCallUs.merge(snapshot.sendCallUs);
+		combined.sharedBudget.grantedBytes += snapshot.sharedBudget.grantedBytes;
+		combined.sharedBudget.grantedPackets += snapshot.sharedBudget.grantedPackets;
+		combined.sharedBudget.priorityPackets += snapshot.sharedBudget.priorityPackets;
+		// Every viewer reports the same aggregate over its own interval.
+		combined.sharedBudget.totalGrantedBytes =
+		    std::max(combined.sharedBudget.totalGrantedBytes, snapshot.sharedBudget.totalGrantedBytes);
+		combined.sharedBudget.waitUs.merge(snapshot.sharedBudget.waitUs);
 	}
 	return combined;
 }
 
+LatencyHistogramSnapshot VDONinjaPeerManager::getVideoPacketizeLatency(bool resetInterval)
+{
+	return videoPacketizeUs_.snapshot(resetInterval);
+}
+
+std::vector<PeerPublishLatencySnapshot> VDONinjaPeerManager::getPeerPublishLatencySnapshots() const
+{
+	std::vector<std::pair<std::string, std::shared_ptr<RtpPacketPacer>>> pacers;
+	{
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		pacers.reserve(peers_.size());
+		for (const auto &entry : peers_) {
+			const auto &peer = entry.second;
+			if (!peer || peer->type != ConnectionType::Publisher) {
+				continue;
+			}
+			std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+			if (peer->videoPacer) {
+				pacers.emplace_back(entry.first, peer->videoPacer);
+			}
+		}
+	}
+
+	// Peeks at the current summary interval without draining it, so remote
+	// stats requests never steal samples from the periodic publish log.
+	std::vector<PeerPublishLatencySnapshot> snapshots;
+	snapshots.reserve(pacers.size());
+	for (const auto &entry : pacers) {
+		const RtpPacerStats stats = entry.second->getStats(false);
+		PeerPublishLatencySnapshot snapshot;
+		snapshot.uuid = entry.first;
+		snapshot.pacerHoldUs = stats.frameHoldUs;
+		snapshot.sendCallUs = stats.sendCallUs;
+		snapshot.sharedBudget = stats.sharedBudget;
+		snapshots.emplace_back(std::move(snapshot));
+	}
+	return snapshots;
+}
+
+std::vector<ViewerTransportSample> VDONinjaPeerManager::getViewerTransportSamples() const
+{
+	struct ViewerSources {
+		std::string uuid;
+		std::shared_ptr<RtpPacketPacer> pacer;
+		std::shared_ptr<RtcpFeedbackTracker> tracker;
+		std::string candidateType;
+	};
+	std::vector<ViewerSources> viewers;
+	{
+		std::lock_guard<std::mutex> lock(peersMutex_);
+		viewers.reserve(peers_.size());
+		for (const auto &entry : peers_) {
+			const auto &peer = entry.second;
+			if (!peer || peer->type != ConnectionType::Publisher) {
+				continue;
+			}
+			std::lock_guard<std::mutex> mediaLock(peer->mediaMutex);
+			viewers.push_back({entry.first, peer->videoPacer, peer->videoFeedbackTracker, peer->selectedCandidateType});
+		}
+	}
+
+	// Pacer totals are atomics and the feedback tracker has its own short
+	// lock, so sampling never waits on a send loop.
+	const int64_t now = currentTimeMs();
+	std::vector<ViewerTransportSample> samples;
+	samples.reserve(viewers.size());
+	for (auto &viewer : viewers) {
+		ViewerTransportSample sample;
+		sample.uuid = std::move(viewer.uuid);
+		sample.sampledAtMs = now;
+		sample.candidateType = std::move(viewer.candidateType);
+		if (viewer.pacer) {
+			sample.pacer = viewer.pacer->totals();
+		}
+		if (viewer.tracker) {
+			sample.feedback = viewer.tracker->totals();
+		}
+		samples.emplace_back(std::move(sample));
+	}
+	return samples;
+}
+
 RtpSendStats VDONinjaPeerManager::takeAudioSendStats()
 {
 	return audioSendTracker_.take();
@@ -11,6 +11,7 @@
 #include <rtc/rtc.hpp>
 
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
@@ -18,13 +19,19 @@
 #include <optional>
 
 #include "vdoninja-audio-red.h"
+#include "vdoninja-bitrate-controller.h"
 #include "vdoninja-common.h"
+#include "vdoninja-gop-cache.h"
+#include "vdoninja-h264-nal-index.h"
 #include "vdoninja-ice-candidate-queue.h"
+#include "vdoninja-peer-warmup.h"
 #include "vdoninja-rtcp-feedback.h"
 #include "vdoninja-rtp-pacer.h"
 #include "vdoninja-rtp-send-tracker.h"
+#include "vdoninja-sdp.h"
 #include "vdoninja-signaling.h"
 #include "vdoninja-track-utils.h"
+#include "vdoninja-viewer-stats.h"
 
 namespace vdoninja
 {
@@ -140,6 +147,14 @@ struct PeerSnapshot {
 	bool videoSendEnabled = true;
 };
 
+// Per-viewer publish latency distributions for the current summary interval.
+struct PeerPublishLatencySnapshot {
+	std::string uuid;
+	LatencyHistogramSnapshot pacerHoldUs;
+	LatencyHistogramSnapshot sendCallUs;
+	RtpSharedBudgetShare sharedBudget;
+};
+
 class VDONinjaPeerManager
 {
 public:
@@ -161,15 +176,44 @@ public:
 	int getMaxViewers() const;
 	bool requestIceRestart(const std::string &uuid, const std::string &session = "");
 
+	// Pre-warmed publisher connections. Each one already holds its tracks,
+	// pacer, local offer and gathered ICE candidates, so an offer request only
+	// has to bind it to the viewer. maxPoolSize 0 disables the pool.
+	void setWarmPublisherPoolSize(int maxPoolSize);
+	// Expire stale pooled connections and refill toward the join-rate target.
+	// Call periodically from a non-RTC, non-signaling thread while publishing.
+	void maintainWarmPublisherPool();
+	size_t getWarmPublisherPoolCount() const;
+	JoinLatencyStats takeJoinLatencyStats();
+
 	// Send media to all connected peers (viewers)
 	void sendAudioFrame(const uint8_t *data, size_t size, uint32_t timestamp);
-	void sendVideoFrame(const uint8_t *data, size_t size, uint32_t timestamp, bool keyframe);
+	// recoveryPoint marks a gradual intra refresh entry frame that is not an
+	// IDR; viewers waiting on a live keyframe may resume from it. A caller
+	// that already indexed the frame passes nalIndex; otherwise it is built
+	// here, once for all viewers.
+	void sendVideoFrame(const uint8_t *data, size_t size, uint32_t timestamp, bool keyframe,
+	                    bool recoveryPoint = false, const H264NalIndex *nalIndex = nullptr);
 	void requireLiveKeyframeForAll();
 	// cachedReplay identifies the cached startup keyframe. It is only safe before
 	// a peer first synchronizes, never for recovery after packet loss.
 	bool sendVideoFrameToPeer(const std::string &uuid, const uint8_t *data, size_t size, uint32_t timestamp,
 	                          bool keyframe, bool cachedReplay = false);
+	// Replays the current GOP to a viewer that has not synchronized yet, so it
+	// starts on moving video and continues straight onto the live stream.
+	// Returns false when fast start is off, the viewer is not eligible, or the
+	// cached GOP cannot be replayed; the caller can still send the cached
+	// keyframe as a still image.
+	bool primePeerWithCachedGop(const std::string &uuid);
+	void setGopFastStartEnabled(bool enable);
+	GopReplayStats takeGopReplayStats();
 	bool notePeerKeyframeRequest(const std::string &uuid);
+	// Whether the viewer's keyframe gate is holding back live video until the
+	// next live keyframe.
+	bool isPeerAwaitingLiveKeyframe(const std::string &uuid) const;
+	// Sets the viewer's share of the aggregate video pacing budget. Returns
+	// false for unknown or non-viewer peers.
+	bool setViewerPacerRole(const std::string &uuid, ViewerPacerRole role);
 	bool setPeerMediaSendEnabled(const std::string &uuid, bool hasVideo, bool videoEnabled, bool hasAudio,
 	                             bool audioEnabled, bool *videoBecameEnabled = nullptr);
 
@@ -222,7 +266,14 @@ public:
 	void setEnableDataChannel(bool enable);
 	RtcpFeedbackStats takeVideoFeedbackStats();
 	std::optional<uint64_t> minimumRecentRembBitrate(std::chrono::milliseconds maxAge) const;
+	// Fresh REMB and receiver report values for every connected viewer,
+	// including viewers that have sent neither yet.
+	std::vector<ViewerCongestionFeedback> recentViewerCongestionFeedback(std::chrono::milliseconds maxAge) const;
 	RtpPacerStats takeVideoPacerStats();
+	// H.264 packetization time per frame per viewer.
+	LatencyHistogramSnapshot getVideoPacketizeLatency(bool resetInterval = false);
+	std::vector<PeerPublishLatencySnapshot> getPeerPublishLatencySnapshots() const;
+	std::vector<ViewerTransportSample> getViewerTransportSamples() const;
 	RtpSendStats takeAudioSendStats();
 	AudioRedStats takeAudioRedStats();
 
@@ -300,6 +351,14 @@ private:
 	// Create a new peer connection for viewing (we receive media from them)
 	std::shared_ptr<PeerInfo> createViewerConnection(const std::string &uuid);
 
+	// Pre-warmed publisher connection pool
+	std::shared_ptr<PeerInfo> createWarmPublisherConnection();
+	// Returns true and sets claimed when a pooled connection was bound to uuid.
+	// Otherwise claimed is the peer a concurrent request registered, or null.
+	bool claimWarmPublisherConnection(const std::string &uuid, const std::string &session,
+	                                  std::shared_ptr<PeerInfo> &claimed);
+	void releaseWarmPublisherPool();
+
 	// Handle signaling events
 	void onSignalingOffer(const std::string &uuid, const std::string &sdp, const std::string &session);
 	void onSignalingAnswer(const std::string &uuid, const std::string &sdp, const std::string &session);
@@ -366,7 +425,7 @@ private:
 
 	// Setup tracks for publishing
 	void setupPublisherTracks(std::shared_ptr<PeerInfo> peer);
-	void prepareViewerTracks(const std::shared_ptr<PeerInfo> &peer, const std::string &offerSdp);
+	void prepareViewerTracks(const std::shared_ptr<PeerInfo> &peer, const SdpDocument &offer);
 	void clearPeerCallbacks(const std::shared_ptr<PeerInfo> &peer);
 	void releasePeerResources(const std::shared_ptr<PeerInfo> &peer);
 	void retirePeerForDeferredCleanup(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer);
@@ -378,7 +437,13 @@ private:
 	bool sendAudioFrameToPeer(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer, const uint8_t *data,
 	                          size_t size, uint32_t timestamp);
 	bool sendVideoFrameToPeerHandle(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer, const uint8_t *data,
-	                                size_t size, uint32_t timestamp, bool keyframe, bool cachedReplay = false);
+	                                size_t size, uint32_t timestamp, bool keyframe, bool cachedReplay = false,
+	                                bool recoveryPoint = false, const H264NalIndex *nalIndex = nullptr);
+	// Requires peer->videoSendMutex and peer->mediaMutex. Indexes the frame
+	// itself when nalIndex is null.
+	bool queueVideoFrameLocked(const std::string &uuid, const std::shared_ptr<PeerInfo> &peer, const uint8_t *data,
+	                           size_t size, uint32_t timestamp, bool keyframe, bool cachedReplay,
+	                           bool recoveryPoint = false, const H264NalIndex *nalIndex = nullptr);
 
 	// Get RTC configuration
 	rtc::Configuration getRtcConfig() const;
@@ -421,6 +486,30 @@ private:
 	std::atomic<bool> audioRedEnabled_{false};
 	bool enableDataChannel_ = true;
 	std::shared_ptr<RtpSharedPacerBudget> videoPacerBudget_;
+	LatencyHistogram videoPacketizeUs_;
+
+	// Held across each live video fan-out and each GOP replay, so a replay
+	// always ends exactly where the next live frame continues.
+	std::mutex gopCacheMutex_;
+	GopCache gopCache_; // Guarded by gopCacheMutex_.
+	std::atomic<bool> gopFastStartEnabled_{true};
+	std::atomic<uint64_t> gopReplays_{0};
+	std::atomic<uint64_t> gopReplayedFrames_{0};
+	std::atomic<uint64_t> gopReplayedBytes_{0};
+	std::atomic<uint64_t> gopStillFallbacks_{0};
+	uint64_t reportedGopOverflows_ = 0; // Guarded by gopCacheMutex_.
+
+	// Pre-warmed publisher connections, oldest first. Pooled peers are not in
+	// peers_ and never signal until claimed.
+	struct WarmPublisherPeer {
+		std::shared_ptr<PeerInfo> peer;
+		int64_t createdAtMs = 0;
+	};
+	std::deque<WarmPublisherPeer> warmPublisherPeers_;
+	mutable std::mutex warmPoolMutex_;
+	PublisherWarmPoolSizer warmPoolSizer_;
+	// Shared with pacer completions, which can outlive a peer's registration.
+	std::shared_ptr<JoinLatencyTracker> joinLatency_;
 
 	// Audio/Video SSRC for outgoing media
 	uint32_t audioSsrc_ = 0;
@@ -0,0 +1,217 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Pre-warmed publisher connection pool sizing and viewer join latency tracking
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-peer-warmup.h"
+
+#include <algorithm>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+uint64_t elapsedMs(int64_t fromMs, int64_t toMs)
+{
+	if (fromMs <= 0 || toMs <= fromMs) {
+		return 0;
+	}
+	return static_cast<uint64_t>(toMs - fromMs);
+}
+
+} // namespace
+
+PublisherWarmPoolSizer::PublisherWarmPoolSizer(size_t maxPoolSize, int64_t windowMs)
+    : maxPoolSize_(maxPoolSize), windowMs_(std::max<int64_t>(1, windowMs))
+{
+}
+
+void PublisherWarmPoolSizer::setMaxPoolSize(size_t maxPoolSize)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	maxPoolSize_ = maxPoolSize;
+}
+
+size_t PublisherWarmPoolSizer::maxPoolSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return maxPoolSize_;
+}
+
+void PublisherWarmPoolSizer::noteJoin(int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pruneLocked(nowMs);
+	joinTimesMs_.push_back(nowMs);
+	// The target never exceeds the pool limit, so older history is irrelevant.
+	while (joinTimesMs_.size() > std::max<size_t>(maxPoolSize_, 1)) {
+		joinTimesMs_.pop_front();
+	}
+}
+
+size_t PublisherWarmPoolSizer::recentJoins(int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pruneLocked(nowMs);
+	return joinTimesMs_.size();
+}
+
+size_t PublisherWarmPoolSizer::targetSize(int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (maxPoolSize_ == 0) {
+		return 0;
+	}
+	pruneLocked(nowMs);
+	return std::min(maxPoolSize_, joinTimesMs_.size() + 1);
+}
+
+void PublisherWarmPoolSizer::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	joinTimesMs_.clear();
+}
+
+void PublisherWarmPoolSizer::pruneLocked(int64_t nowMs)
+{
+	while (!joinTimesMs_.empty() && nowMs - joinTimesMs_.front() >= windowMs_) {
+		joinTimesMs_.pop_front();
+	}
+}
+
+void JoinLatencyStageStats::add(uint64_t valueMs) noexcept
+{
+	++count;
+	totalMs += valueMs;
+	maxMs = std::max(maxMs, valueMs);
+}
+
+JoinLatencyTracker::JoinLatencyTracker(size_t maxPendingJoins, int64_t pendingTimeoutMs)
+    : maxPendingJoins_(std::max<size_t>(1, maxPendingJoins)), pendingTimeoutMs_(std::max<int64_t>(1, pendingTimeoutMs))
+{
+}
+
+void JoinLatencyTracker::begin(uint64_t generation, int64_t requestedAtMs, bool warm)
+{
+	if (generation == 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	pruneLocked(requestedAtMs);
+	if (pending_.find(generation) == pending_.end() && pending_.size() >= maxPendingJoins_) {
+		auto oldest = std::min_element(pending_.begin(), pending_.end(), [](const auto &lhs, const auto &rhs) {
+			return lhs.second.requestedAtMs < rhs.second.requestedAtMs;
+		});
+		pending_.erase(oldest);
+		++stats_.abandonedJoins;
+	}
+
+	PendingJoin join;
+	join.requestedAtMs = requestedAtMs;
+	join.warm = warm;
+	pending_[generation] = join;
+}
+
+void JoinLatencyTracker::mark(uint64_t generation, JoinLatencyStage stage, int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = pending_.find(generation);
+	if (it == pending_.end()) {
+		return;
+	}
+
+	// Only the first occurrence of each milestone counts. Resent offers and
+	// repeated state callbacks must not stretch an already measured stage.
+	auto &join = it->second;
+	switch (stage) {
+	case JoinLatencyStage::OfferSent:
+		if (join.offerSentAtMs == 0) {
+			join.offerSentAtMs = nowMs;
+		}
+		break;
+	case JoinLatencyStage::AnswerReceived:
+		if (join.answerReceivedAtMs == 0) {
+			join.answerReceivedAtMs = nowMs;
+		}
+		break;
+	case JoinLatencyStage::Connected:
+		if (join.connectedAtMs == 0) {
+			join.connectedAtMs = nowMs;
+		}
+		break;
+	case JoinLatencyStage::FirstKeyframe: {
+		const PendingJoin completed = join;
+		pending_.erase(it);
+		complete(completed, nowMs);
+		break;
+	}
+	}
+}
+
+void JoinLatencyTracker::abandon(uint64_t generation)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (pending_.erase(generation) != 0) {
+		++stats_.abandonedJoins;
+	}
+}
+
+size_t JoinLatencyTracker::pendingJoins() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_.size();
+}
+
+JoinLatencyStats JoinLatencyTracker::take()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	JoinLatencyStats stats = stats_;
+	stats_ = {};
+	return stats;
+}
+
+void JoinLatencyTracker::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pending_.clear();
+	stats_ = {};
+}
+
+void JoinLatencyTracker::complete(const PendingJoin &join, int64_t firstKeyframeAtMs)
+{
+	++stats_.completedJoins;
+	if (join.warm) {
+		++stats_.warmJoins;
+	}
+	if (join.offerSentAtMs != 0) {
+		stats_.requestToOffer.add(elapsedMs(join.requestedAtMs, join.offerSentAtMs));
+	}
+	if (join.offerSentAtMs != 0 && join.answerReceivedAtMs != 0) {
+		stats_.offerToAnswer.add(elapsedMs(join.offerSentAtMs, join.answerReceivedAtMs));
+	}
+	if (join.answerReceivedAtMs != 0 && join.connectedAtMs != 0) {
+		stats_.answerToConnected.add(elapsedMs(join.answerReceivedAtMs, join.connectedAtMs));
+	}
+	if (join.connectedAtMs != 0) {
+		stats_.connectedToFirstKeyframe.add(elapsedMs(join.connectedAtMs, firstKeyframeAtMs));
+	}
+	stats_.requestToFirstKeyframe.add(elapsedMs(join.requestedAtMs, firstKeyframeAtMs));
+}
+
+void JoinLatencyTracker::pruneLocked(int64_t nowMs)
+{
+	for (auto it = pending_.begin(); it != pending_.end();) {
+		if (nowMs - it->second.requestedAtMs >= pendingTimeoutMs_) {
+			it = pending_.erase(it);
+			++stats_.abandonedJoins;
+		} else {
+			++it;
+		}
+	}
+}
+
+} // namespace vdoninja
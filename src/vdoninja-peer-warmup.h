@@ -0,0 +1,105 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Pre-warmed publisher connection pool sizing and viewer join latency tracking
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace vdoninja
+{
+
+// Sizes the pool of idle publisher connections from the recent viewer join
+// rate. An enabled pool always keeps one connection ready; each join observed
+// inside the window asks for one more, up to the configured limit, so a
+// director adding several guests at once finds them already gathered.
+class PublisherWarmPoolSizer
+{
+public:
+	explicit PublisherWarmPoolSizer(size_t maxPoolSize = 0, int64_t windowMs = 60000);
+
+	void setMaxPoolSize(size_t maxPoolSize);
+	size_t maxPoolSize() const;
+	void noteJoin(int64_t nowMs);
+	size_t recentJoins(int64_t nowMs);
+	size_t targetSize(int64_t nowMs);
+	void reset();
+
+private:
+	void pruneLocked(int64_t nowMs);
+
+	mutable std::mutex mutex_;
+	size_t maxPoolSize_;
+	int64_t windowMs_;
+	std::deque<int64_t> joinTimesMs_;
+};
+
+enum class JoinLatencyStage {
+	OfferSent,
+	AnswerReceived,
+	Connected,
+	FirstKeyframe,
+};
+
+struct JoinLatencyStageStats {
+	uint64_t count = 0;
+	uint64_t totalMs = 0;
+	uint64_t maxMs = 0;
+
+	void add(uint64_t valueMs) noexcept;
+	uint64_t averageMs() const noexcept { return count ? totalMs / count : 0; }
+};
+
+struct JoinLatencyStats {
+	uint64_t completedJoins = 0;
+	uint64_t warmJoins = 0;
+	uint64_t abandonedJoins = 0;
+	JoinLatencyStageStats requestToOffer;
+	JoinLatencyStageStats offerToAnswer;
+	JoinLatencyStageStats answerToConnected;
+	JoinLatencyStageStats connectedToFirstKeyframe;
+	JoinLatencyStageStats requestToFirstKeyframe;
+};
+
+// Tracks request->offer->answer->connected->first-keyframe milestones for each
+// publisher connection generation. A join is folded into the interval totals
+// once its first keyframe has been fully sent; joins that never get there are
+// counted as abandoned when they are retired or time out.
+class JoinLatencyTracker
+{
+public:
+	explicit JoinLatencyTracker(size_t maxPendingJoins = 256, int64_t pendingTimeoutMs = 120000);
+
+	void begin(uint64_t generation, int64_t requestedAtMs, bool warm);
+	void mark(uint64_t generation, JoinLatencyStage stage, int64_t nowMs);
+	void abandon(uint64_t generation);
+	size_t pendingJoins() const;
+	JoinLatencyStats take();
+	void reset();
+
+private:
+	struct PendingJoin {
+		int64_t requestedAtMs = 0;
+		int64_t offerSentAtMs = 0;
+		int64_t answerReceivedAtMs = 0;
+		int64_t connectedAtMs = 0;
+		bool warm = false;
+	};
+
+	void complete(const PendingJoin &join, int64_t firstKeyframeAtMs);
+	void pruneLocked(int64_t nowMs);
+
+	mutable std::mutex mutex_;
+	size_t maxPendingJoins_;
+	int64_t pendingTimeoutMs_;
+	std::unordered_map<uint64_t, PendingJoin> pending_;
+	JoinLatencyStats stats_;
+};
+
+} // namespace vdoninja
@@ -0,0 +1,267 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Resolution and frame-rate ladder for adaptive bitrate
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-quality-ladder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <utility>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr uint64_t kMinimumRungKbps = 100;
+constexpr uint64_t kMaximumRungKbps = 100000;
+constexpr uint32_t kMinimumRungHeight = 90;
+constexpr uint32_t kMaximumRungHeight = 4320;
+constexpr uint32_t kMaximumRungFps = 240;
+
+std::string trim(const std::string &value)
+{
+	size_t begin = 0;
+	size_t end = value.size();
+	while (begin < end && std::isspace(static_cast<unsigned char>(value[begin]))) {
+		++begin;
+	}
+	while (end > begin && std::isspace(static_cast<unsigned char>(value[end - 1]))) {
+		--end;
+	}
+	return value.substr(begin, end - begin);
+}
+
+// Reads a run of digits; false when there is none or it does not fit.
+bool readNumber(const std::string &text, size_t &pos, uint64_t &value)
+{
+	const size_t start = pos;
+	value = 0;
+	while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos]))) {
+		if (value > kMaximumRungKbps * 10U) {
+			return false;
+		}
+		value = value * 10U + static_cast<uint64_t>(text[pos] - '0');
+		++pos;
+	}
+	return pos > start;
+}
+
+bool fail(std::string *error, const std::string &message)
+{
+	if (error) {
+		*error = message;
+	}
+	return false;
+}
+
+bool parseRung(const std::string &entry, QualityRung &rung, std::string *error)
+{
+	size_t pos = 0;
+	uint64_t kbps = 0;
+	if (!readNumber(entry, pos, kbps) || pos >= entry.size() || entry[pos] != ':') {
+		return fail(error, "expected <kbps>:<height>p<fps> in '" + entry + "'");
+	}
+	++pos;
+	uint64_t height = 0;
+	if (!readNumber(entry, pos, height) || pos >= entry.size() || (entry[pos] != 'p' && entry[pos] != 'P')) {
+		return fail(error, "expected <kbps>:<height>p<fps> in '" + entry + "'");
+	}
+	++pos;
+	uint64_t fps = 0;
+	if (pos < entry.size() && !readNumber(entry, pos, fps)) {
+		return fail(error, "unexpected text after the height in '" + entry + "'");
+	}
+	if (pos != entry.size()) {
+		return fail(error, "unexpected text after the frame rate in '" + entry + "'");
+	}
+	if (kbps < kMinimumRungKbps || kbps > kMaximumRungKbps) {
+		return fail(error, "rung bitrate must be 100-100000 kbps in '" + entry + "'");
+	}
+	if (height < kMinimumRungHeight || height > kMaximumRungHeight) {
+		return fail(error, "rung height must be 90-4320 in '" + entry + "'");
+	}
+	if (fps > kMaximumRungFps) {
+		return fail(error, "rung frame rate must be at most 240 in '" + entry + "'");
+	}
+	rung.maximumBitrateBitsPerSecond = kbps * 1000U;
+	rung.height = static_cast<uint32_t>(height);
+	rung.fps = static_cast<uint32_t>(fps);
+	return true;
+}
+
+uint32_t evenAtLeastTwo(uint64_t value)
+{
+	return static_cast<uint32_t>(std::max<uint64_t>(2, value & ~static_cast<uint64_t>(1)));
+}
+
+} // namespace
+
+std::optional<std::vector<QualityRung>> parseQualityLadder(const std::string &spec, std::string *error)
+{
+	std::vector<QualityRung> rungs;
+	if (trim(spec).empty()) {
+		return rungs;
+	}
+
+	size_t start = 0;
+	while (start <= spec.size()) {
+		const size_t comma = spec.find(',', start);
+		const size_t end = comma == std::string::npos ? spec.size() : comma;
+		const std::string entry = trim(spec.substr(start, end - start));
+		QualityRung rung;
+		if (entry.empty()) {
+			fail(error, "empty rung");
+			return std::nullopt;
+		}
+		if (!parseRung(entry, rung, error)) {
+			return std::nullopt;
+		}
+		if (!rungs.empty() && rung.maximumBitrateBitsPerSecond >= rungs.back().maximumBitrateBitsPerSecond) {
+			fail(error, "rung bitrates must decrease from left to right");
+			return std::nullopt;
+		}
+		rungs.push_back(rung);
+		if (rungs.size() > kMaxQualityLadderRungs) {
+			fail(error, "at most 3 rungs are supported");
+			return std::nullopt;
+		}
+		if (comma == std::string::npos) {
+			break;
+		}
+		start = comma + 1;
+	}
+	return rungs;
+}
+
+std::string qualityRungName(const QualityRung &rung)
+{
+	std::string name = rung.height > 0 ? std::to_string(rung.height) + "p" : std::string("native");
+	if (rung.fps > 0) {
+		name += std::to_string(rung.fps);
+	}
+	return name;
+}
+
+QualityRungGeometry qualityRungGeometry(const QualityRung &rung, uint32_t width, uint32_t height, uint32_t fpsNumerator,
+                                        uint32_t fpsDenominator)
+{
+	QualityRungGeometry geometry;
+	geometry.width = width;
+	geometry.height = height;
+	if (rung.height > 0 && height > 0 && rung.height < height) {
+		geometry.height = evenAtLeastTwo(rung.height);
+		const uint64_t scaledWidth =
+		    (static_cast<uint64_t>(width) * geometry.height + height / 2U) / static_cast<uint64_t>(height);
+		geometry.width = evenAtLeastTwo(scaledWidth);
+	}
+	if (rung.fps > 0 && fpsNumerator > 0 && fpsDenominator > 0) {
+		const double canvasFps = static_cast<double>(fpsNumerator) / static_cast<double>(fpsDenominator);
+		const long divisor = std::lround(canvasFps / static_cast<double>(rung.fps));
+		geometry.frameRateDivisor = static_cast<uint32_t>(std::max<long>(1, divisor));
+	}
+	return geometry;
+}
+
+QualityLadder::QualityLadder(QualityLadderConfig config) : config_(std::move(config)) {}
+
+std::optional<size_t> QualityLadder::observe(uint64_t bitrateBitsPerSecond, int64_t nowMs)
+{
+	if (!hasLevelSince_) {
+		hasLevelSince_ = true;
+		levelSinceMs_ = nowMs;
+	}
+
+	size_t desired = 0;
+	for (size_t index = 0; index < config_.rungs.size(); ++index) {
+		if (bitrateBitsPerSecond < config_.rungs[index].maximumBitrateBitsPerSecond) {
+			desired = index + 1;
+		}
+	}
+
+	if (desired > level_) {
+		level_ = desired;
+		levelSinceMs_ = nowMs;
+		return level_;
+	}
+	if (desired < level_) {
+		// Back up one rung at a time, each with its own headroom and dwell.
+		const uint64_t ceiling = config_.rungs[level_ - 1].maximumBitrateBitsPerSecond;
+		const uint64_t required = ceiling + ceiling * config_.upHysteresisPercent / 100U;
+		if (bitrateBitsPerSecond >= required && nowMs - levelSinceMs_ >= config_.minimumUpDwellMs) {
+			--level_;
+			levelSinceMs_ = nowMs;
+			return level_;
+		}
+	}
+	return std::nullopt;
+}
+
+void QualityLadder::reset()
+{
+	level_ = 0;
+	levelSinceMs_ = 0;
+	hasLevelSince_ = false;
+}
+
+void QualityTrackSelector::requestTrack(size_t track, int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (track == targetTrack_) {
+		return;
+	}
+	targetTrack_ = track;
+	requestedAtMs_ = nowMs;
+}
+
+bool QualityTrackSelector::accept(size_t track, bool keyframe, int64_t nowMs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (track != activeTrack_ && track == targetTrack_ && keyframe) {
+		// Higher tracks are the lower rungs.
+		if (track > activeTrack_) {
+			++stats_.switchesDown;
+		} else {
+			++stats_.switchesUp;
+		}
+		stats_.maxSwitchWaitMs = std::max(stats_.maxSwitchWaitMs, nowMs - requestedAtMs_);
+		activeTrack_ = track;
+		return true;
+	}
+	if (track == activeTrack_) {
+		return true;
+	}
+	++stats_.standbyFrames;
+	return false;
+}
+
+size_t QualityTrackSelector::activeTrack() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return activeTrack_;
+}
+
+QualityLadderStats QualityTrackSelector::takeStats()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	QualityLadderStats stats = stats_;
+	stats.activeTrack = activeTrack_;
+	stats.targetTrack = targetTrack_;
+	stats_ = {};
+	return stats;
+}
+
+void QualityTrackSelector::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	activeTrack_ = 0;
+	targetTrack_ = 0;
+	requestedAtMs_ = 0;
+	stats_ = {};
+}
+
+} // namespace vdoninja
@@ -0,0 +1,117 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Resolution and frame-rate ladder for adaptive bitrate
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vdoninja
+{
+
+// libobs allows at most six video encoders per output; the configured encoder
+// keeps the first slot.
+constexpr size_t kMaxQualityLadderRungs = 3;
+
+// Used while the adaptive bitrate is below maximumBitrateBitsPerSecond. A
+// zero height or fps keeps the configured encoder's value.
+struct QualityRung {
+	uint64_t maximumBitrateBitsPerSecond = 0;
+	uint32_t height = 0;
+	uint32_t fps = 0;
+};
+
+// Parses "1500:720p30, 700:540p30": below 1500 kbps send 720p at 30 fps,
+// below 700 kbps 540p at 30 fps. Ceilings must strictly decrease. An empty
+// spec is a valid ladder with no rungs.
+std::optional<std::vector<QualityRung>> parseQualityLadder(const std::string &spec, std::string *error = nullptr);
+std::string qualityRungName(const QualityRung &rung);
+
+struct QualityRungGeometry {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	// OBS encoder frame-rate divisor: the encoder keeps every Nth frame.
+	uint32_t frameRateDivisor = 1;
+};
+
+// Scales the configured encoder size to the rung height, keeping the aspect
+// ratio and even dimensions, and never scales up.
+QualityRungGeometry qualityRungGeometry(const QualityRung &rung, uint32_t width, uint32_t height, uint32_t fpsNumerator,
+                                        uint32_t fpsDenominator);
+
+struct QualityLadderConfig {
+	std::vector<QualityRung> rungs;
+	// Stepping back up needs this much headroom over the ceiling of the rung
+	// being left, so a bitrate hovering at a ceiling does not flap.
+	uint16_t upHysteresisPercent = 20;
+	// And the current rung must have been held this long. Stepping down is
+	// immediate: holding a resolution the path cannot carry is what the
+	// ladder exists to avoid.
+	int64_t minimumUpDwellMs = 10000;
+};
+
+// Picks the rung for each adaptive bitrate target. Level 0 is the configured
+// encoder; level N is rungs[N - 1]. Not synchronized.
+class QualityLadder
+{
+public:
+	explicit QualityLadder(QualityLadderConfig config = {});
+
+	// Returns the new level when the target moves the ladder.
+	std::optional<size_t> observe(uint64_t bitrateBitsPerSecond, int64_t nowMs);
+	size_t level() const noexcept { return level_; }
+	size_t levels() const noexcept { return config_.rungs.size() + 1; }
+	const QualityLadderConfig &config() const noexcept { return config_; }
+	void reset();
+
+private:
+	QualityLadderConfig config_;
+	size_t level_ = 0;
+	int64_t levelSinceMs_ = 0;
+	bool hasLevelSince_ = false;
+};
+
+struct QualityLadderStats {
+	uint64_t switchesDown = 0;
+	uint64_t switchesUp = 0;
+	// Frames from the tracks not being sent.
+	uint64_t standbyFrames = 0;
+	// From the ladder's decision to the new track's first keyframe.
+	int64_t maxSwitchWaitMs = 0;
+	size_t activeTrack = 0;
+	size_t targetTrack = 0;
+};
+
+// Chooses which encoder track reaches viewers. A requested switch takes
+// effect on the target track's next keyframe, so every viewer's first frame at
+// the new resolution is an IDR and no delta frame ever crosses the boundary.
+// Internally synchronized: the ladder requests tracks from the adaptation
+// thread while encoded packets arrive on the OBS output thread.
+class QualityTrackSelector
+{
+public:
+	void requestTrack(size_t track, int64_t nowMs);
+	// Whether a video packet from track should be sent. Switches track when
+	// the packet is the target track's keyframe.
+	bool accept(size_t track, bool keyframe, int64_t nowMs);
+	size_t activeTrack() const;
+	QualityLadderStats takeStats();
+	void reset();
+
+private:
+	mutable std::mutex mutex_;
+	// Guarded by mutex_.
+	size_t activeTrack_ = 0;
+	size_t targetTrack_ = 0;
+	int64_t requestedAtMs_ = 0;
+	QualityLadderStats stats_;
+};
+
+} // namespace vdoninja
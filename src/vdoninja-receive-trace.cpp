@@ -0,0 +1,270 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Native receive pipeline stage tracing, drop accounting and RTCP SR latency
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-receive-trace.h"
+
+#include <algorithm>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr uint8_t kRtcpVersion = 2;
+constexpr uint8_t kSenderReportPayloadType = 200;
+constexpr size_t kRtcpHeaderBytes = 4;
+constexpr size_t kSenderReportMinimumBytes = 28;
+constexpr int64_t kNtpEpochOffsetSeconds = 2208988800LL;
+
+uint16_t readU16(const uint8_t *data)
+{
+	return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8) | static_cast<uint16_t>(data[1]));
+}
+
+uint32_t readU32(const uint8_t *data)
+{
+	return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+	       (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+uint64_t elapsedUs(int64_t fromUs, int64_t toUs)
+{
+	if (fromUs <= 0 || toUs <= fromUs) {
+		return 0;
+	}
+	return static_cast<uint64_t>(toUs - fromUs);
+}
+
+} // namespace
+
+RtcpSenderReportClock::RtcpSenderReportClock(uint32_t clockRate, uint32_t mediaSsrc)
+    : clockRate_(std::max<uint32_t>(1, clockRate)), mediaSsrc_(mediaSsrc)
+{
+}
+
+bool RtcpSenderReportClock::observe(const uint8_t *data, size_t size)
+{
+	if (!data) {
+		return false;
+	}
+
+	bool found = false;
+	size_t offset = 0;
+	while (offset + kRtcpHeaderBytes <= size) {
+		const uint8_t *packet = data + offset;
+		const size_t packetBytes = (static_cast<size_t>(readU16(packet + 2)) + 1U) * 4U;
+		if ((packet[0] >> 6) != kRtcpVersion || packetBytes > size - offset) {
+			break;
+		}
+		if (packet[1] == kSenderReportPayloadType && packetBytes >= kSenderReportMinimumBytes) {
+			const uint32_t ssrc = readU32(packet + 4);
+			if (mediaSsrc_ == 0 || ssrc == mediaSsrc_) {
+				const int64_t ntpSeconds = static_cast<int64_t>(readU32(packet + 8));
+				const uint64_t ntpFraction = readU32(packet + 12);
+				reportWallClockUs_ = (ntpSeconds - kNtpEpochOffsetSeconds) * 1000000LL +
+				                     static_cast<int64_t>((ntpFraction * 1000000ULL) >> 32);
+				reportRtpTimestamp_ = readU32(packet + 16);
+				hasReport_ = true;
+				found = true;
+			}
+		}
+		offset += packetBytes;
+	}
+	return found;
+}
+
+std::optional<int64_t> RtcpSenderReportClock::senderWallClockUs(uint32_t rtpTimestamp) const
+{
+	if (!hasReport_) {
+		return std::nullopt;
+	}
+	// Signed distance handles frames on either side of the report and RTP wrap.
+	const int64_t ticks = static_cast<int32_t>(rtpTimestamp - reportRtpTimestamp_);
+	return reportWallClockUs_ + ticks * 1000000LL / static_cast<int64_t>(clockRate_);
+}
+
+void RtcpSenderReportClock::setMediaSsrc(uint32_t mediaSsrc)
+{
+	if (mediaSsrc != mediaSsrc_) {
+		mediaSsrc_ = mediaSsrc;
+		hasReport_ = false;
+	}
+}
+
+void RtcpSenderReportClock::reset()
+{
+	hasReport_ = false;
+	reportWallClockUs_ = 0;
+	reportRtpTimestamp_ = 0;
+}
+
+ReceivePipelineTracer::ReceivePipelineTracer(size_t maxTrackedFrames, int64_t maxPlausibleSenderLatencyUs)
+    : maxTrackedFrames_(std::max<size_t>(1, maxTrackedFrames)),
+      maxPlausibleSenderLatencyUs_(std::max<int64_t>(1, maxPlausibleSenderLatencyUs))
+{
+}
+
+ReceivePipelineTracer::FrameTrace *ReceivePipelineTracer::findLocked(uint32_t rtpTimestamp)
+{
+	// Newest first: lookups almost always hit the most recent frames.
+	for (auto it = frames_.rbegin(); it != frames_.rend(); ++it) {
+		if (it->rtpTimestamp == rtpTimestamp) {
+			return &*it;
+		}
+	}
+	return nullptr;
+}
+
+ReceivePipelineTracer::FrameTrace &ReceivePipelineTracer::findOrInsertLocked(uint32_t rtpTimestamp)
+{
+	if (FrameTrace *existing = findLocked(rtpTimestamp)) {
+		return *existing;
+	}
+	while (frames_.size() >= maxTrackedFrames_) {
+		frames_.pop_front();
+	}
+	FrameTrace trace;
+	trace.rtpTimestamp = rtpTimestamp;
+	frames_.push_back(trace);
+	return frames_.back();
+}
+
+void ReceivePipelineTracer::noteFirstPacket(uint32_t rtpTimestamp, int64_t nowUs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	FrameTrace &trace = findOrInsertLocked(rtpTimestamp);
+	if (trace.firstPacketUs == 0) {
+		trace.firstPacketUs = nowUs;
+	}
+}
+
+void ReceivePipelineTracer::noteAssembled(uint32_t rtpTimestamp, int64_t nowUs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	FrameTrace &trace = findOrInsertLocked(rtpTimestamp);
+	if (trace.assembledUs != 0) {
+		return;
+	}
+	trace.assembledUs = nowUs;
+	if (trace.firstPacketUs != 0) {
+		stats_.assemblyUs.record(elapsedUs(trace.firstPacketUs, nowUs));
+	}
+}
+
+void ReceivePipelineTracer::noteDecoded(uint32_t rtpTimestamp, int64_t nowUs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	FrameTrace *trace = findLocked(rtpTimestamp);
+	if (!trace || trace->decodedUs != 0) {
+		return;
+	}
+	trace->decodedUs = nowUs;
+	if (trace->assembledUs != 0) {
+		stats_.decodeUs.record(elapsedUs(trace->assembledUs, nowUs));
+	}
+}
+
+void ReceivePipelineTracer::notePaired(uint32_t rtpTimestamp, int64_t nowUs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	FrameTrace *trace = findLocked(rtpTimestamp);
+	if (trace && trace->decodedUs != 0) {
+		stats_.alphaWaitUs.record(elapsedUs(trace->decodedUs, nowUs));
+	}
+}
+
+void ReceivePipelineTracer::noteScaleDuration(uint64_t durationUs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	stats_.scaleUs.record(durationUs);
+}
+
+void ReceivePipelineTracer::noteOutput(uint32_t rtpTimestamp, int64_t nowUs, int64_t wallClockNowUs)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	++stats_.outputFrames;
+	for (auto it = frames_.begin(); it != frames_.end(); ++it) {
+		if (it->rtpTimestamp == rtpTimestamp) {
+			if (it->firstPacketUs != 0) {
+				stats_.receiveToOutputUs.record(elapsedUs(it->firstPacketUs, nowUs));
+			}
+			frames_.erase(it);
+			break;
+		}
+	}
+
+	const auto senderCapturedUs = senderClock_.senderWallClockUs(rtpTimestamp);
+	if (!senderCapturedUs) {
+		return;
+	}
+	const int64_t latencyUs = wallClockNowUs - *senderCapturedUs;
+	if (latencyUs < 0 || latencyUs > maxPlausibleSenderLatencyUs_) {
+		++stats_.unsyncedClockFrames;
+		return;
+	}
+	stats_.senderToOutputUs.record(static_cast<uint64_t>(latencyUs));
+}
+
+void ReceivePipelineTracer::noteDrop(ReceiveDropReason reason, uint64_t frames)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	switch (reason) {
+	case ReceiveDropReason::IncompleteFrame:
+		stats_.incompleteFrames += frames;
+		break;
+	case ReceiveDropReason::DecodeError:
+		stats_.decodeErrors += frames;
+		break;
+	case ReceiveDropReason::AlphaTimeout:
+		stats_.alphaTimeouts += frames;
+		break;
+	case ReceiveDropReason::EpochGate:
+		stats_.epochGateDrops += frames;
+		break;
+	}
+}
+
+void ReceivePipelineTracer::observeRtcp(const uint8_t *data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (senderClock_.observe(data, size)) {
+		++stats_.senderReports;
+	}
+}
+
+void ReceivePipelineTracer::setMediaSsrc(uint32_t mediaSsrc)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	senderClock_.setMediaSsrc(mediaSsrc);
+}
+
+ReceivePipelineSnapshot ReceivePipelineTracer::snapshot(bool resetInterval)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	ReceivePipelineSnapshot snapshot = stats_;
+	if (resetInterval) {
+		stats_ = {};
+	}
+	return snapshot;
+}
+
+void ReceivePipelineTracer::clearInFlight()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	frames_.clear();
+	senderClock_.reset();
+}
+
+void ReceivePipelineTracer::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	frames_.clear();
+	senderClock_.reset();
+	stats_ = {};
+}
+
+} // namespace vdoninja
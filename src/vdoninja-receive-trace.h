@@ -0,0 +1,119 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Native receive pipeline stage tracing, drop accounting and RTCP SR latency
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include "vdoninja-latency-histogram.h"
+
+namespace vdoninja
+{
+
+enum class ReceiveDropReason {
+	// Access unit discarded or flushed before its final packet arrived.
+	IncompleteFrame,
+	// avcodec_send_packet()/avcodec_receive_frame() rejected the frame.
+	DecodeError,
+	// Primary frame aged out of alpha pairing without an exact mate.
+	AlphaTimeout,
+	// Frame belonged to a media epoch retired by a track transition.
+	EpochGate,
+};
+
+struct ReceivePipelineSnapshot {
+	LatencyHistogramSnapshot assemblyUs;        // first RTP packet -> complete access unit
+	LatencyHistogramSnapshot decodeUs;          // complete access unit -> decoded picture
+	LatencyHistogramSnapshot alphaWaitUs;       // decoded primary -> exact alpha mate
+	LatencyHistogramSnapshot scaleUs;           // sws_scale() call
+	LatencyHistogramSnapshot receiveToOutputUs; // first RTP packet -> obs_source_output_video()
+	LatencyHistogramSnapshot senderToOutputUs;  // sender capture (RTCP SR mapped) -> output
+	uint64_t outputFrames = 0;
+	uint64_t incompleteFrames = 0;
+	uint64_t decodeErrors = 0;
+	uint64_t alphaTimeouts = 0;
+	uint64_t epochGateDrops = 0;
+	uint64_t senderReports = 0;
+	// Output frames whose SR-mapped latency was negative or implausibly large,
+	// which means the two hosts' wall clocks disagree.
+	uint64_t unsyncedClockFrames = 0;
+};
+
+// Maps RTP timestamps onto the sender's wall clock from the most recent RTCP
+// sender report. Only meaningful as one-way latency when both hosts keep their
+// clocks NTP-disciplined; the caller must treat outliers as clock skew.
+class RtcpSenderReportClock
+{
+public:
+	explicit RtcpSenderReportClock(uint32_t clockRate = 90000, uint32_t mediaSsrc = 0);
+
+	// Scans a (compound) RTCP packet. Returns true if a sender report for the
+	// tracked SSRC was found. mediaSsrc 0 accepts any sender.
+	bool observe(const uint8_t *data, size_t size);
+	// Unix-epoch microseconds at which the sender captured rtpTimestamp.
+	std::optional<int64_t> senderWallClockUs(uint32_t rtpTimestamp) const;
+	// Changing the SSRC discards the current mapping; a bundled transport can
+	// surface audio reports, whose RTP clock would corrupt the estimate.
+	void setMediaSsrc(uint32_t mediaSsrc);
+	void reset();
+
+private:
+	uint32_t clockRate_;
+	uint32_t mediaSsrc_;
+	bool hasReport_ = false;
+	int64_t reportWallClockUs_ = 0;
+	uint32_t reportRtpTimestamp_ = 0;
+};
+
+// Timestamps each video frame through the native receive pipeline, keyed by
+// RTP timestamp. Called once per frame per stage, so a single mutex is cheap;
+// a bounded history keeps frames that vanish mid-pipeline from accumulating.
+class ReceivePipelineTracer
+{
+public:
+	explicit ReceivePipelineTracer(size_t maxTrackedFrames = 64, int64_t maxPlausibleSenderLatencyUs = 60000000);
+
+	void noteFirstPacket(uint32_t rtpTimestamp, int64_t nowUs);
+	void noteAssembled(uint32_t rtpTimestamp, int64_t nowUs);
+	void noteDecoded(uint32_t rtpTimestamp, int64_t nowUs);
+	void notePaired(uint32_t rtpTimestamp, int64_t nowUs);
+	void noteScaleDuration(uint64_t durationUs);
+	// wallClockNowUs is Unix-epoch time, used against the SR mapping.
+	void noteOutput(uint32_t rtpTimestamp, int64_t nowUs, int64_t wallClockNowUs);
+	void noteDrop(ReceiveDropReason reason, uint64_t frames = 1);
+	void observeRtcp(const uint8_t *data, size_t size);
+	void setMediaSsrc(uint32_t mediaSsrc);
+
+	ReceivePipelineSnapshot snapshot(bool resetInterval = false);
+	// Forget in-flight frames and the SR mapping after a track transition,
+	// keeping interval totals.
+	void clearInFlight();
+	void reset();
+
+private:
+	struct FrameTrace {
+		uint32_t rtpTimestamp = 0;
+		int64_t firstPacketUs = 0;
+		int64_t assembledUs = 0;
+		int64_t decodedUs = 0;
+	};
+
+	FrameTrace *findLocked(uint32_t rtpTimestamp);
+	FrameTrace &findOrInsertLocked(uint32_t rtpTimestamp);
+
+	mutable std::mutex mutex_;
+	size_t maxTrackedFrames_;
+	int64_t maxPlausibleSenderLatencyUs_;
+	std::deque<FrameTrace> frames_;
+	RtcpSenderReportClock senderClock_;
+	ReceivePipelineSnapshot stats_;
+};
+
+} // namespace vdoninja
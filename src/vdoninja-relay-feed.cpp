@@ -0,0 +1,161 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Upstream frame continuity and timeline for the shared-media relay
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-relay-feed.h"
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr uint32_t kVideoClockRate = 90000;
+constexpr uint32_t kVideoRestartStep = 3000;
+// A forward or backward step larger than this is a restart, not a gap.
+constexpr uint32_t kMaxTimestampJumpSeconds = 10;
+
+} // namespace
+
+RelayTimestampRebaser::RelayTimestampRebaser(uint32_t clockRate, uint32_t restartStep)
+    : maxJump_(clockRate * kMaxTimestampJumpSeconds), restartStep_(restartStep)
+{
+}
+
+uint32_t RelayTimestampRebaser::map(uint32_t ssrc, uint32_t timestamp, bool *restarted)
+{
+	bool restart = false;
+	if (!initialized_) {
+		initialized_ = true;
+		offset_ = 0;
+	} else {
+		const uint32_t forward = timestamp - lastUpstream_;
+		const uint32_t backward = lastUpstream_ - timestamp;
+		if (ssrc != ssrc_ || (forward > maxJump_ && backward > maxJump_)) {
+			offset_ = lastMapped_ + restartStep_ - timestamp;
+			restart = true;
+		}
+	}
+
+	ssrc_ = ssrc;
+	lastUpstream_ = timestamp;
+	lastMapped_ = timestamp + offset_;
+	if (restarted) {
+		*restarted = restart;
+	}
+	return lastMapped_;
+}
+
+void RelayTimestampRebaser::reset()
+{
+	initialized_ = false;
+	ssrc_ = 0;
+	lastUpstream_ = 0;
+	lastMapped_ = 0;
+	offset_ = 0;
+}
+
+RelayVideoFeed::RelayVideoFeed() : timeline_(kVideoClockRate, kVideoRestartStep) {}
+
+void RelayVideoFeed::notePacket(uint32_t ssrc, uint16_t sequence, uint32_t rtpTimestamp, bool appended)
+{
+	if (haveSequence_ && ssrc != ssrc_) {
+		// A new upstream stream: nothing it sends predicts from the old one.
+		haveSequence_ = false;
+		chainBroken_ = true;
+	}
+	const bool contiguous = haveSequence_ && sequence == static_cast<uint16_t>(lastSequence_ + 1);
+
+	if (!frameActive_ || rtpTimestamp != frameTimestamp_) {
+		if (frameActive_) {
+			havePreviousFrame_ = true;
+			previousFrameTimestamp_ = frameTimestamp_;
+			// A gap at the boundary may have been its tail and marker. A frame
+			// that ended on its marker was judged already.
+			previousFrameIntact_ = frameIntact_ && contiguous;
+		}
+		frameActive_ = true;
+		frameTimestamp_ = rtpTimestamp;
+		// Or this frame's head.
+		frameIntact_ = contiguous;
+	} else {
+		frameIntact_ = frameIntact_ && contiguous;
+	}
+	frameIntact_ = frameIntact_ && appended;
+
+	ssrc_ = ssrc;
+	lastSequence_ = sequence;
+	haveSequence_ = true;
+}
+
+bool RelayVideoFeed::intact(uint32_t rtpTimestamp) const
+{
+	if (frameActive_ && rtpTimestamp == frameTimestamp_) {
+		return frameIntact_;
+	}
+	if (havePreviousFrame_ && rtpTimestamp == previousFrameTimestamp_) {
+		return previousFrameIntact_;
+	}
+	return false;
+}
+
+bool RelayVideoFeed::claimKeyframeRequest(int64_t nowMs)
+{
+	if (keyframeRequested_ && nowMs - lastKeyframeRequestMs_ < kKeyframeRequestIntervalMs) {
+		return false;
+	}
+	keyframeRequested_ = true;
+	lastKeyframeRequestMs_ = nowMs;
+	++stats_.keyframeRequests;
+	return true;
+}
+
+RelayVideoDecision RelayVideoFeed::onFrame(uint32_t rtpTimestamp, bool keyframe, int64_t nowMs, bool recoveryPoint)
+{
+	RelayVideoDecision decision;
+	if (!intact(rtpTimestamp)) {
+		chainBroken_ = true;
+	} else if (keyframe || (recoveryPoint && forwardedKeyframe_)) {
+		chainBroken_ = false;
+		keyframeRequested_ = false;
+	}
+
+	if (chainBroken_) {
+		++stats_.droppedFrames;
+		decision.requestKeyframe = claimKeyframeRequest(nowMs);
+		return decision;
+	}
+
+	bool restarted = false;
+	forwardedKeyframe_ = forwardedKeyframe_ || keyframe;
+	decision.forward = true;
+	decision.timestamp = timeline_.map(ssrc_, rtpTimestamp, &restarted);
+	if (restarted) {
+		++stats_.upstreamRestarts;
+	}
+	++stats_.forwardedFrames;
+	return decision;
+}
+
+void RelayVideoFeed::reset()
+{
+	haveSequence_ = false;
+	lastSequence_ = 0;
+	ssrc_ = 0;
+	frameActive_ = false;
+	frameTimestamp_ = 0;
+	frameIntact_ = false;
+	havePreviousFrame_ = false;
+	previousFrameTimestamp_ = 0;
+	previousFrameIntact_ = false;
+	chainBroken_ = true;
+	forwardedKeyframe_ = false;
+	keyframeRequested_ = false;
+	lastKeyframeRequestMs_ = 0;
+	timeline_.reset();
+	stats_ = {};
+}
+
+} // namespace vdoninja
@@ -0,0 +1,105 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Upstream frame continuity and timeline for the shared-media relay
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace vdoninja
+{
+
+// Upstream RTP timestamps mapped onto one continuous relay timeline. The
+// relay's viewers keep their own SSRC and sequence space for as long as they
+// are connected, so when the upstream publisher restarts (new SSRC) or its
+// clock jumps, the relay timeline carries on one frame after the last
+// forwarded timestamp instead of following the jump.
+class RelayTimestampRebaser
+{
+public:
+	// restartStep: the gap left on the relay timeline across a restart, in
+	// clock ticks; one nominal frame.
+	RelayTimestampRebaser(uint32_t clockRate, uint32_t restartStep);
+
+	// restarted is set when this timestamp started a new upstream segment.
+	uint32_t map(uint32_t ssrc, uint32_t timestamp, bool *restarted = nullptr);
+	void reset();
+
+private:
+	uint32_t maxJump_ = 0;
+	uint32_t restartStep_ = 0;
+	bool initialized_ = false;
+	uint32_t ssrc_ = 0;
+	uint32_t lastUpstream_ = 0;
+	uint32_t lastMapped_ = 0;
+	uint32_t offset_ = 0;
+};
+
+struct RelayVideoDecision {
+	bool forward = false;
+	// Relay timeline timestamp of a forwarded frame.
+	uint32_t timestamp = 0;
+	// Ask the upstream publisher for a keyframe.
+	bool requestKeyframe = false;
+};
+
+struct RelayVideoFeedStats {
+	uint64_t forwardedFrames = 0;
+	// Incomplete frames and deltas whose prediction chain was broken.
+	uint64_t droppedFrames = 0;
+	uint64_t keyframeRequests = 0;
+	uint64_t upstreamRestarts = 0;
+};
+
+// Decides which reassembled upstream H.264 access units the relay may
+// forward. A lost packet leaves a damaged access unit, and the relay must not
+// forward that to viewers as if it were whole. notePacket() sees every
+// upstream packet in sequence order and onFrame() each access unit as it
+// completes. Once a frame is damaged, deltas are held back until an intact
+// keyframe, or an intact recovery point once a keyframe has been forwarded,
+// and a keyframe is requested upstream at most once per interval. Not
+// synchronized.
+class RelayVideoFeed
+{
+public:
+	static constexpr int64_t kKeyframeRequestIntervalMs = 1000;
+
+	RelayVideoFeed();
+
+	// appended is false when the payload could not be depacketized or its
+	// access unit was found damaged.
+	void notePacket(uint32_t ssrc, uint16_t sequence, uint32_t rtpTimestamp, bool appended = true);
+	RelayVideoDecision onFrame(uint32_t rtpTimestamp, bool keyframe, int64_t nowMs, bool recoveryPoint = false);
+	// A forwarded frame never reached the viewers; hold deltas back until the
+	// next keyframe.
+	void breakChain() noexcept { chainBroken_ = true; }
+	void reset();
+
+	const RelayVideoFeedStats &stats() const noexcept { return stats_; }
+
+private:
+	bool intact(uint32_t rtpTimestamp) const;
+	bool claimKeyframeRequest(int64_t nowMs);
+
+	bool haveSequence_ = false;
+	uint16_t lastSequence_ = 0;
+	uint32_t ssrc_ = 0;
+	// The frame still receiving packets, and the one it displaced: a frame
+	// whose marker was lost completes only when the next one starts.
+	bool frameActive_ = false;
+	uint32_t frameTimestamp_ = 0;
+	bool frameIntact_ = false;
+	bool havePreviousFrame_ = false;
+	uint32_t previousFrameTimestamp_ = 0;
+	bool previousFrameIntact_ = false;
+	bool chainBroken_ = true;
+	bool forwardedKeyframe_ = false;
+	bool keyframeRequested_ = false;
+	int64_t lastKeyframeRequestMs_ = 0;
+	RelayTimestampRebaser timeline_;
+	RelayVideoFeedStats stats_;
+};
+
+} // namespace vdoninja
@@ -0,0 +1,470 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Shared-media relay: republishes one received stream to many viewers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-relay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "vdoninja-decode-budget.h"
+#include "vdoninja-h264-profile.h"
+#include "vdoninja-peer-manager.h"
+#include "vdoninja-signaling.h"
+#include "vdoninja-thread-cpu.h"
+#include "vdoninja-utils.h"
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr uint32_t kAudioClockRate = 48000;
+constexpr uint32_t kAudioRestartStep = 960;
+// About three seconds of video and audio frames.
+constexpr size_t kMaxQueuedFrames = 240;
+// Pacing budget until the ingest rate has been measured.
+constexpr int kInitialPacingBitrate = 6000000;
+constexpr int kMinPacingBitrate = 500000;
+constexpr int64_t kPacingUpdateIntervalMs = 2000;
+constexpr int64_t kServiceIntervalMs = 100;
+
+int64_t steadyTimeMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+} // namespace
+
+VDONinjaRelay::VDONinjaRelay() : audioTimeline_(kAudioClockRate, kAudioRestartStep)
+{
+	callbackState_ = std::make_shared<AsyncCallbackState<VDONinjaRelay>>();
+	callbackState_->owner.store(this, std::memory_order_release);
+}
+
+VDONinjaRelay::~VDONinjaRelay()
+{
+	stop();
+	AsyncCallbackGuard<VDONinjaRelay>::detach(callbackState_.get());
+	if (!AsyncCallbackGuard<VDONinjaRelay>::waitForIdle(callbackState_.get(), 10000)) {
+		logWarning("Timed out waiting for VDO.Ninja relay callbacks to drain during teardown");
+	}
+	callbackState_.reset();
+}
+
+bool VDONinjaRelay::start(const RelaySettings &settings, UpstreamKeyframeRequest requestKeyframe)
+{
+	if (settings.streamId.empty()) {
+		logWarning("Relay stream ID is required");
+		return false;
+	}
+
+	stop();
+
+	signaling_ = std::make_unique<VDONinjaSignaling>();
+	auto peerManager = std::make_shared<VDONinjaPeerManager>();
+	{
+		std::lock_guard<std::mutex> lock(requestMutex_);
+		requestKeyframe_ = std::move(requestKeyframe);
+	}
+	{
+		std::lock_guard<std::mutex> lock(feedMutex_);
+		peerManager_ = std::move(peerManager);
+		accepting_ = true;
+		sendQueue_.clear();
+		videoFeed_.reset();
+		audioTimeline_.reset();
+		forwardedAudioPackets_ = 0;
+		upstreamAudioRestarts_ = 0;
+		overflowedFrames_ = 0;
+	}
+	keyframeArbiter_.reset();
+	profileLevelId_.clear();
+	ingestBytes_.store(0, std::memory_order_relaxed);
+	lastBitrateUpdateMs_ = steadyTimeMs();
+	lastBitrateUpdateBytes_ = 0;
+	pacingBitrate_ = kInitialPacingBitrate;
+	configure(settings);
+
+	running_ = true;
+	sendThread_ = std::thread(&VDONinjaRelay::sendThread, this);
+	serviceThread_ = std::thread(&VDONinjaRelay::serviceThread, this, settings);
+	logInfo("Relaying the received stream as %s for up to %d viewers", settings.streamId.c_str(), settings.maxViewers);
+	return true;
+}
+
+void VDONinjaRelay::stop()
+{
+	const bool wasRunning = running_.exchange(false);
+	{
+		std::lock_guard<std::mutex> lock(feedMutex_);
+		accepting_ = false;
+		sendQueue_.clear();
+	}
+	sendCv_.notify_all();
+	if (sendThread_.joinable()) {
+		sendThread_.join();
+	}
+	{
+		std::lock_guard<std::mutex> lock(requestMutex_);
+		requestKeyframe_ = nullptr;
+	}
+
+	if (signaling_) {
+		signaling_->setOnConnected(nullptr);
+		signaling_->setOnDisconnected(nullptr);
+		signaling_->setOnError(nullptr);
+	}
+	if (peerManager_) {
+		peerManager_->setOnPeerConnected(nullptr);
+		peerManager_->setOnPeerDisconnected(nullptr);
+		peerManager_->setOnKeyframeRequest(nullptr);
+		peerManager_->setOnDataChannelMessage(nullptr);
+		peerManager_->stopPublishing();
+	}
+	// Viewers hear the unpublish while the socket is still open.
+	if (signaling_) {
+		if (signaling_->isPublishing()) {
+			signaling_->unpublishStream();
+		}
+		signaling_->disconnect();
+	}
+	if (serviceThread_.joinable()) {
+		serviceThread_.join();
+	}
+	keyframeArbiter_.reset();
+
+	if (wasRunning) {
+		const RelayStats totals = stats();
+		logInfo("Relay stopped: forwarded %llu video frames and %llu audio frames, dropped %llu damaged or "
+		        "unanchored frames, %llu upstream keyframe requests, %llu overflowed",
+		        static_cast<unsigned long long>(totals.video.forwardedFrames),
+		        static_cast<unsigned long long>(totals.forwardedAudioPackets),
+		        static_cast<unsigned long long>(totals.video.droppedFrames),
+		        static_cast<unsigned long long>(totals.video.keyframeRequests),
+		        static_cast<unsigned long long>(totals.overflowedFrames));
+	}
+}
+
+bool VDONinjaRelay::isRunning() const
+{
+	return running_.load(std::memory_order_acquire);
+}
+
+void VDONinjaRelay::configure(const RelaySettings &settings)
+{
+	const auto callbackState = callbackState_;
+
+	peerManager_->initialize(signaling_.get());
+	peerManager_->setVideoCodec(VideoCodec::H264);
+	peerManager_->setAudioCodec(AudioCodec::Opus);
+	peerManager_->setBitrate(pacingBitrate_);
+	peerManager_->setGopFastStartEnabled(true);
+	peerManager_->setEnableDataChannel(true);
+	peerManager_->setIceServers(settings.customIceServers);
+	peerManager_->setForceTurn(settings.forceTurn);
+	signaling_->setSalt(settings.salt);
+
+	signaling_->setOnConnected([callbackState, settings]() {
+		AsyncCallbackGuard<VDONinjaRelay> guard(callbackState.get());
+		if (!guard) {
+			return;
+		}
+		VDONinjaRelay *self = guard.owner();
+		logInfo("Relay connected to signaling server");
+		self->signaling_->publishStream(settings.streamId, settings.password);
+		self->peerManager_->startPublishing(settings.maxViewers);
+	});
+
+	signaling_->setOnError([callbackState](const std::string &error) {
+		AsyncCallbackGuard<VDONinjaRelay> guard(callbackState.get());
+		if (!guard) {
+			return;
+		}
+		logError("Relay signaling error: %s", error.c_str());
+	});
+
+	peerManager_->setOnPeerConnected([callbackState](const PeerEventIdentity &identity) {
+		AsyncCallbackGuard<VDONinjaRelay> guard(callbackState.get());
+		if (!guard) {
+			return;
+		}
+		VDONinjaRelay *self = guard.owner();
+		logInfo("Relay viewer connected: %s (total: %d)", identity.uuid.c_str(), self->peerManager_->getViewerCount());
+		// Without a cached GOP to replay, the viewer's keyframe gate waits
+		// for a live keyframe; ask upstream for one now.
+		if (!self->peerManager_->primePeerWithCachedGop(identity.uuid)) {
+			self->noteViewerKeyframeRequest(identity.uuid);
+		}
+	});
+
+	peerManager_->setOnPeerDisconnected([callbackState](const PeerEventIdentity &identity) {
+		AsyncCallbackGuard<VDONinjaRelay> guard(callbackState.get());
+		if (!guard) {
+			return;
+		}
+		guard.owner()->keyframeArbiter_.removeViewer(identity.uuid);
+		logInfo("Relay viewer disconnected: %s", identity.uuid.c_str());
+	});
+
+	peerManager_->setOnKeyframeRequest([callbackState](const std::string &uuid) {
+		AsyncCallbackGuard<VDONinjaRelay> guard(callbackState.get());
+		if (!guard) {
+			return;
+		}
+		guard.owner()->noteViewerKeyframeRequest(uuid);
+	});
+
+	peerManager_->setOnDataChannelMessage(
+	    [callbackState](const PeerEventIdentity &identity, const std::string &message) {
+		    AsyncCallbackGuard<VDONinjaRelay> guard(callbackState.get());
+		    if (!guard) {
+			    return;
+		    }
+		    VDONinjaRelay *self = guard.owner();
+		    if (self->dataChannel_.hasKeyframeRequest(message)) {
+			    self->peerManager_->notePeerKeyframeRequest(identity.uuid);
+			    self->noteViewerKeyframeRequest(identity.uuid);
+		    }
+	    });
+
+	signaling_->setAutoReconnect(true, DEFAULT_RECONNECT_ATTEMPTS);
+}
+
+void VDONinjaRelay::serviceThread(RelaySettings settings)
+{
+	setCurrentThreadName("vdo-relay");
+	try {
+		if (!signaling_->connect(settings.wssHost)) {
+			if (running_.load()) {
+				logError("Relay failed to connect to signaling server");
+			}
+			return;
+		}
+
+		while (running_.load()) {
+			const int64_t nowMs = steadyTimeMs();
+			peerManager_->runDeferredCleanup();
+			// Requests from viewers still decoding wait out the refresh grace
+			// here rather than on their own callback.
+			maybeRequestUpstreamKeyframe(nowMs);
+			updatePacingBitrate(nowMs);
+			std::this_thread::sleep_for(std::chrono::milliseconds(kServiceIntervalMs));
+		}
+	} catch (const std::exception &e) {
+		logError("Relay service thread crashed: %s", e.what());
+	} catch (...) {
+		logError("Relay service thread crashed with an unknown exception");
+	}
+}
+
+void VDONinjaRelay::sendThread()
+{
+	setCurrentThreadName("vdo-relay-send");
+	while (true) {
+		QueuedFrame frame;
+		{
+			std::unique_lock<std::mutex> lock(feedMutex_);
+			sendCv_.wait(lock, [this]() { return !accepting_ || !sendQueue_.empty(); });
+			if (!accepting_) {
+				return;
+			}
+			frame = std::move(sendQueue_.front());
+			sendQueue_.pop_front();
+		}
+
+		if (!frame.video) {
+			peerManager_->sendAudioFrame(frame.payload.data(), frame.payload.size(), frame.timestamp);
+			continue;
+		}
+
+		if (frame.keyframe) {
+			// The viewers' SDP advertises the upstream encoder's profile once an
+			// SPS has been seen.
+			const auto profileLevelId =
+			    deriveH264ProfileLevelId(frame.payload.data(), frame.payload.size(), frame.nalIndex);
+			if (profileLevelId && *profileLevelId != profileLevelId_) {
+				profileLevelId_ = *profileLevelId;
+				peerManager_->setH264ProfileLevelId(profileLevelId_);
+				logInfo("Relay H.264 profile-level-id=%s (from upstream SPS)", profileLevelId_.c_str());
+			}
+		}
+		peerManager_->sendVideoFrame(frame.payload.data(), frame.payload.size(), frame.timestamp, frame.keyframe,
+		                             frame.recoveryPoint, &frame.nalIndex);
+	}
+}
+
+bool VDONinjaRelay::enqueueLocked(QueuedFrame frame)
+{
+	if (sendQueue_.size() >= kMaxQueuedFrames) {
+		++overflowedFrames_;
+		return false;
+	}
+	sendQueue_.push_back(std::move(frame));
+	sendCv_.notify_one();
+	return true;
+}
+
+void VDONinjaRelay::noteVideoPacket(uint32_t ssrc, uint16_t sequence, uint32_t rtpTimestamp, bool appended)
+{
+	if (!running_.load(std::memory_order_acquire)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(feedMutex_);
+	if (accepting_) {
+		videoFeed_.notePacket(ssrc, sequence, rtpTimestamp, appended);
+	}
+}
+
+void VDONinjaRelay::forwardVideoFrame(const uint8_t *data, size_t size, uint32_t rtpTimestamp)
+{
+	if (!data || size == 0 || !running_.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	QueuedFrame frame;
+	frame.video = true;
+	frame.payload.assign(data, data + size);
+	frame.nalIndex.build(frame.payload.data(), frame.payload.size());
+	const EncodedVideoFrameInfo info = inspectH264AccessUnit(frame.payload.data(), frame.nalIndex);
+	frame.keyframe = info.keyframe;
+	frame.recoveryPoint = info.recoveryPoint && !info.keyframe;
+	const bool keyframe = frame.keyframe;
+
+	const int64_t nowMs = steadyTimeMs();
+	RelayVideoDecision decision;
+	{
+		std::lock_guard<std::mutex> lock(feedMutex_);
+		if (!accepting_) {
+			return;
+		}
+		decision = videoFeed_.onFrame(rtpTimestamp, frame.keyframe, nowMs, frame.recoveryPoint);
+		if (decision.forward) {
+			frame.timestamp = decision.timestamp;
+			if (!enqueueLocked(std::move(frame))) {
+				videoFeed_.breakChain();
+				decision.forward = false;
+			}
+		}
+	}
+
+	if (decision.forward) {
+		ingestBytes_.fetch_add(size, std::memory_order_relaxed);
+		if (keyframe) {
+			keyframeArbiter_.noteKeyframe(nowMs);
+		}
+	}
+	if (decision.requestKeyframe) {
+		requestUpstreamKeyframe();
+	}
+}
+
+void VDONinjaRelay::forwardAudioFrame(uint32_t ssrc, const uint8_t *data, size_t size, uint32_t rtpTimestamp)
+{
+	if (!data || size == 0 || !running_.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	QueuedFrame frame;
+	frame.payload.assign(data, data + size);
+	std::lock_guard<std::mutex> lock(feedMutex_);
+	if (!accepting_) {
+		return;
+	}
+	bool restarted = false;
+	frame.timestamp = audioTimeline_.map(ssrc, rtpTimestamp, &restarted);
+	if (restarted) {
+		++upstreamAudioRestarts_;
+	}
+	if (enqueueLocked(std::move(frame))) {
+		++forwardedAudioPackets_;
+		ingestBytes_.fetch_add(size, std::memory_order_relaxed);
+	}
+}
+
+RelayStats VDONinjaRelay::stats() const
+{
+	RelayStats stats;
+	stats.running = running_.load(std::memory_order_acquire);
+	std::shared_ptr<VDONinjaPeerManager> peerManager;
+	{
+		std::lock_guard<std::mutex> lock(feedMutex_);
+		stats.video = videoFeed_.stats();
+		stats.forwardedAudioPackets = forwardedAudioPackets_;
+		stats.upstreamAudioRestarts = upstreamAudioRestarts_;
+		stats.overflowedFrames = overflowedFrames_;
+		peerManager = peerManager_;
+	}
+	// The copy outlives a concurrent restart replacing the manager.
+	if (stats.running && peerManager) {
+		stats.viewers = peerManager->getViewerCount();
+	}
+	return stats;
+}
+
+#if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
+VDONinjaPeerManager *VDONinjaRelay::nativeMediaTestPeerManager() const
+{
+	std::lock_guard<std::mutex> lock(feedMutex_);
+	return peerManager_.get();
+}
+#endif
+
+void VDONinjaRelay::noteViewerKeyframeRequest(const std::string &uuid)
+{
+	const bool awaitingLiveKeyframe = peerManager_ && peerManager_->isPeerAwaitingLiveKeyframe(uuid);
+	const int64_t nowMs = steadyTimeMs();
+	keyframeArbiter_.noteRequest(uuid, awaitingLiveKeyframe, nowMs);
+	maybeRequestUpstreamKeyframe(nowMs);
+}
+
+void VDONinjaRelay::maybeRequestUpstreamKeyframe(int64_t nowMs)
+{
+	const KeyframeArbiterDecision decision = keyframeArbiter_.poll(nowMs);
+	if (!decision.force) {
+		return;
+	}
+	keyframeArbiter_.noteForceResult(requestUpstreamKeyframe());
+}
+
+bool VDONinjaRelay::requestUpstreamKeyframe()
+{
+	UpstreamKeyframeRequest requestKeyframe;
+	{
+		std::lock_guard<std::mutex> lock(requestMutex_);
+		requestKeyframe = requestKeyframe_;
+	}
+	return requestKeyframe && requestKeyframe();
+}
+
+void VDONinjaRelay::updatePacingBitrate(int64_t nowMs)
+{
+	const int64_t elapsedMs = nowMs - lastBitrateUpdateMs_;
+	if (elapsedMs < kPacingUpdateIntervalMs) {
+		return;
+	}
+
+	// The relay has no encoder target to pace against; the rate it actually
+	// ingests is the closest equivalent.
+	const uint64_t bytes = ingestBytes_.load(std::memory_order_relaxed);
+	const uint64_t bitsPerSecond =
+	    (bytes - lastBitrateUpdateBytes_) * 8ULL * 1000ULL / static_cast<uint64_t>(elapsedMs);
+	lastBitrateUpdateMs_ = nowMs;
+	lastBitrateUpdateBytes_ = bytes;
+
+	const int measured = static_cast<int>(std::min<uint64_t>(
+	    std::max<uint64_t>(bitsPerSecond, static_cast<uint64_t>(kMinPacingBitrate)), 200000000ULL));
+	if (std::abs(measured - pacingBitrate_) * 10 < pacingBitrate_) {
+		return;
+	}
+	pacingBitrate_ = measured;
+	peerManager_->setBitrate(pacingBitrate_);
+	logDebug("Relay pacing budget now %d kbps", pacingBitrate_ / 1000);
+}
+
+} // namespace vdoninja
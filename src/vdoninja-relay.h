@@ -0,0 +1,148 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Shared-media relay: republishes one received stream to many viewers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vdoninja-common.h"
+#include "vdoninja-data-channel.h"
+#include "vdoninja-h264-nal-index.h"
+#include "vdoninja-keyframe-arbiter.h"
+#include "vdoninja-relay-feed.h"
+
+namespace vdoninja
+{
+
+class VDONinjaPeerManager;
+class VDONinjaSignaling;
+
+struct RelaySettings {
+	std::string streamId;
+	std::string password;
+	std::string wssHost = DEFAULT_WSS_HOST;
+	std::string salt = DEFAULT_SALT;
+	std::vector<IceServer> customIceServers;
+	bool forceTurn = false;
+	int maxViewers = DEFAULT_RELAY_MAX_VIEWERS;
+};
+
+struct RelayStats {
+	bool running = false;
+	int viewers = 0;
+	RelayVideoFeedStats video;
+	uint64_t forwardedAudioPackets = 0;
+	uint64_t upstreamAudioRestarts = 0;
+	// Frames dropped because the send worker fell behind.
+	uint64_t overflowedFrames = 0;
+};
+
+// A native receiver that relays keeps one upstream peer to the publisher and
+// republishes its media under a second stream ID, so the publisher's uplink
+// carries the stream once however many viewers watch. Video is forwarded per
+// access unit, not per packet: the relay's own peer manager packetizes each
+// frame for every viewer with its own SSRC and sequence numbers, and its
+// pacers, NACK history, GOP fast start and keyframe gates work as they do
+// for an OBS publisher. Nothing is decoded or re-encoded. Viewer keyframe
+// requests are coalesced and passed upstream.
+//
+// Ingest methods are called from the receiver's RTP callbacks and do nothing
+// while the relay is stopped. They only queue; a send worker fans the media
+// out, so a slow viewer set never stalls the receiver's own decode path.
+class VDONinjaRelay
+{
+public:
+	// Asks the upstream publisher for a keyframe; true when one was requested.
+	using UpstreamKeyframeRequest = std::function<bool()>;
+
+	VDONinjaRelay();
+	~VDONinjaRelay();
+
+	VDONinjaRelay(const VDONinjaRelay &) = delete;
+	VDONinjaRelay &operator=(const VDONinjaRelay &) = delete;
+
+	// Connects to signaling and publishes in the background.
+	bool start(const RelaySettings &settings, UpstreamKeyframeRequest requestKeyframe);
+	void stop();
+	bool isRunning() const;
+
+	// Every upstream video RTP packet of an access unit, in sequence order, as
+	// the unit completes. appended is false when the receiver found the unit
+	// damaged.
+	void noteVideoPacket(uint32_t ssrc, uint16_t sequence, uint32_t rtpTimestamp, bool appended);
+	// A reassembled H.264 access unit in Annex B.
+	void forwardVideoFrame(const uint8_t *data, size_t size, uint32_t rtpTimestamp);
+	// One Opus frame; a RED packet's primary block.
+	void forwardAudioFrame(uint32_t ssrc, const uint8_t *data, size_t size, uint32_t rtpTimestamp);
+
+	RelayStats stats() const;
+
+#if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
+	// The manager relay viewers connect to; null before the first start.
+	VDONinjaPeerManager *nativeMediaTestPeerManager() const;
+#endif
+
+private:
+	struct QueuedFrame {
+		bool video = false;
+		std::vector<uint8_t> payload;
+		uint32_t timestamp = 0;
+		bool keyframe = false;
+		bool recoveryPoint = false;
+		H264NalIndex nalIndex;
+	};
+
+	void configure(const RelaySettings &settings);
+	void serviceThread(RelaySettings settings);
+	void sendThread();
+	bool enqueueLocked(QueuedFrame frame);
+	void noteViewerKeyframeRequest(const std::string &uuid);
+	void maybeRequestUpstreamKeyframe(int64_t nowMs);
+	void updatePacingBitrate(int64_t nowMs);
+	bool requestUpstreamKeyframe();
+
+	std::unique_ptr<VDONinjaSignaling> signaling_;
+	// Replaced under feedMutex_ by start(); stats() copies it there.
+	std::shared_ptr<VDONinjaPeerManager> peerManager_;
+	std::shared_ptr<AsyncCallbackState<VDONinjaRelay>> callbackState_;
+	VDONinjaDataChannel dataChannel_;
+	KeyframeRequestArbiter keyframeArbiter_;
+	std::thread serviceThread_;
+	std::thread sendThread_;
+	std::atomic<bool> running_{false};
+
+	std::mutex requestMutex_;
+	UpstreamKeyframeRequest requestKeyframe_; // Guarded by requestMutex_.
+
+	mutable std::mutex feedMutex_;
+	std::condition_variable sendCv_;
+	bool accepting_ = false;              // Guarded by feedMutex_.
+	std::deque<QueuedFrame> sendQueue_;   // Guarded by feedMutex_.
+	RelayVideoFeed videoFeed_;            // Guarded by feedMutex_.
+	RelayTimestampRebaser audioTimeline_; // Guarded by feedMutex_.
+	uint64_t forwardedAudioPackets_ = 0;  // Guarded by feedMutex_.
+	uint64_t upstreamAudioRestarts_ = 0;  // Guarded by feedMutex_.
+	uint64_t overflowedFrames_ = 0;       // Guarded by feedMutex_.
+
+	// Send worker only.
+	std::string profileLevelId_;
+	std::atomic<uint64_t> ingestBytes_{0};
+	// Service thread only.
+	int64_t lastBitrateUpdateMs_ = 0;
+	uint64_t lastBitrateUpdateBytes_ = 0;
+	int pacingBitrate_ = 0;
+};
+
+} // namespace vdoninja
@@ -0,0 +1,266 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Shared remote stats documents and per-subscriber delta delivery
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-remote-stats.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "vdoninja-utils.h"
+
+namespace vdoninja
+{
+
+namespace
+{
+
+// Entries are already serialized; joining them avoids a JsonBuilder pass over
+// every viewer for every subscriber.
+void appendEntry(std::string &object, bool &first, const std::string &uuid, const std::string &json)
+{
+	object += first ? "" : ",";
+	first = false;
+	// Keys are peer UUIDs, written unescaped like JsonBuilder keys.
+	object += "\"";
+	object += uuid;
+	object += "\":";
+	object += json;
+}
+
+// Appends the keys of entry that differ from sent, and null for keys it no
+// longer has. Returns false when nothing differs.
+bool appendChangedFields(std::string &object, const RemoteStatsEntry &entry,
+                         const std::map<std::string, std::string> &sent)
+{
+	std::string changed;
+	bool firstField = true;
+	const auto addField = [&](const std::string &key, const std::string &value) {
+		changed += firstField ? "\"" : ",\"";
+		firstField = false;
+		changed += key;
+		changed += "\":";
+		changed += value;
+	};
+	bool reportChanged = false;
+	for (const auto &field : entry.fields) {
+		const auto previous = sent.find(field.first);
+		if (previous == sent.end() || previous->second != field.second) {
+			addField(field.first, field.second);
+			reportChanged = reportChanged || field.first == "reported";
+		}
+	}
+	for (const auto &field : sent) {
+		if (entry.fields.find(field.first) == entry.fields.end()) {
+			addField(field.first, "null");
+		}
+	}
+	if (firstField) {
+		return false;
+	}
+	object += "{";
+	if (reportChanged && entry.lastStatsAgeMs >= 0) {
+		object += "\"lastStatsAgeMs\":" + std::to_string(entry.lastStatsAgeMs) + ",";
+	}
+	object += changed;
+	object += "}";
+	return true;
+}
+
+} // namespace
+
+RemoteStatsEntry makeRemoteStatsEntry(std::map<std::string, std::string> fields, int64_t lastStatsAgeMs)
+{
+	RemoteStatsEntry entry;
+	entry.json = "{";
+	bool first = true;
+	if (lastStatsAgeMs >= 0) {
+		entry.json += "\"lastStatsAgeMs\":" + std::to_string(lastStatsAgeMs);
+		first = false;
+	}
+	for (const auto &field : fields) {
+		appendEntry(entry.json, first, field.first, field.second);
+	}
+	entry.json += "}";
+	entry.fields = std::move(fields);
+	entry.lastStatsAgeMs = lastStatsAgeMs;
+	return entry;
+}
+
+std::string remoteStatsFullMessage(const RemoteStatsDocument &document, const std::string &recipientUuid)
+{
+	std::string peers = "{";
+	bool first = true;
+	for (const auto &entry : document.peers) {
+		if (entry.first != recipientUuid) {
+			appendEntry(peers, first, entry.first, entry.second.json);
+		}
+	}
+	peers += "}";
+
+	JsonBuilder message;
+	message.addRaw("remoteStats", peers);
+	message.addRaw("publishLatencyUs", document.pipelineJson);
+	return message.build();
+}
+
+RemoteStatsPublisher::RemoteStatsPublisher() : RemoteStatsPublisher(Limits{}) {}
+
+RemoteStatsPublisher::RemoteStatsPublisher(const Limits &limits) : limits_(limits)
+{
+	limits_.intervalMs = std::max<int64_t>(limits_.intervalMs, 1);
+	limits_.fullSnapshotIntervalMs = std::max(limits_.fullSnapshotIntervalMs, limits_.intervalMs);
+}
+
+void RemoteStatsPublisher::addSubscriber(const std::string &uuid, int64_t nowMs)
+{
+	if (uuid.empty()) {
+		return;
+	}
+	// Re-subscribing keeps the existing schedule; the request that carried it
+	// is answered with a full snapshot separately.
+	auto inserted = subscribers_.emplace(uuid, Subscriber{});
+	if (inserted.second) {
+		inserted.first->second.nextDueMs = nowMs;
+	}
+}
+
+void RemoteStatsPublisher::removeSubscriber(const std::string &uuid)
+{
+	subscribers_.erase(uuid);
+	lastOneShotMs_.erase(uuid);
+}
+
+void RemoteStatsPublisher::clear()
+{
+	subscribers_.clear();
+	lastOneShotMs_.clear();
+}
+
+int64_t RemoteStatsPublisher::nextDueMs() const
+{
+	int64_t next = 0;
+	for (const auto &entry : subscribers_) {
+		if (next == 0 || entry.second.nextDueMs < next) {
+			next = std::max<int64_t>(entry.second.nextDueMs, 1);
+		}
+	}
+	return next;
+}
+
+std::vector<std::string> RemoteStatsPublisher::dueSubscribers(int64_t nowMs) const
+{
+	std::vector<std::string> due;
+	for (const auto &entry : subscribers_) {
+		if (entry.second.nextDueMs <= nowMs) {
+			due.push_back(entry.first);
+		}
+	}
+	return due;
+}
+
+std::string RemoteStatsPublisher::pushFor(const std::string &uuid, const RemoteStatsDocument &document, int64_t nowMs)
+{
+	const auto it = subscribers_.find(uuid);
+	if (it == subscribers_.end()) {
+		return {};
+	}
+	Subscriber &subscriber = it->second;
+
+	std::string message;
+	if (!subscriber.hasBaseline || nowMs - subscriber.lastFullMs >= limits_.fullSnapshotIntervalMs) {
+		message = remoteStatsFullMessage(document, uuid);
+		rememberFull(subscriber, uuid, document, nowMs);
+	} else {
+		std::string changed = "{";
+		bool firstChanged = true;
+		std::string removed = "[";
+		bool firstRemoved = true;
+		for (const auto &entry : document.peers) {
+			if (entry.first == uuid) {
+				continue;
+			}
+			auto &sent = subscriber.sentFields[entry.first];
+			std::string fields;
+			if (appendChangedFields(fields, entry.second, sent)) {
+				appendEntry(changed, firstChanged, entry.first, fields);
+				sent = entry.second.fields;
+			}
+		}
+		for (auto sent = subscriber.sentFields.begin(); sent != subscriber.sentFields.end();) {
+			if (document.peers.find(sent->first) == document.peers.end()) {
+				removed += firstRemoved ? "\"" : ",\"";
+				firstRemoved = false;
+				removed += sent->first;
+				removed += "\"";
+				sent = subscriber.sentFields.erase(sent);
+			} else {
+				++sent;
+			}
+		}
+		changed += "}";
+		removed += "]";
+
+		const bool pipelineChanged = subscriber.sentPipeline != document.pipelineJson;
+		if (!firstChanged || !firstRemoved || pipelineChanged) {
+			JsonBuilder delta;
+			delta.addRaw("remoteStatsDelta", changed);
+			if (!firstRemoved) {
+				delta.addRaw("remoteStatsRemoved", removed);
+			}
+			if (pipelineChanged) {
+				delta.addRaw("publishLatencyUs", document.pipelineJson);
+				subscriber.sentPipeline = document.pipelineJson;
+			}
+			message = delta.build();
+		}
+	}
+
+	subscriber.nextDueMs = nowMs + nextPushDelayMs(message.size());
+	return message;
+}
+
+std::string RemoteStatsPublisher::answerRequest(const std::string &uuid, const RemoteStatsDocument &document,
+                                                int64_t nowMs)
+{
+	const auto last = lastOneShotMs_.find(uuid);
+	if (last != lastOneShotMs_.end() && nowMs >= last->second && nowMs - last->second < limits_.oneShotIntervalMs) {
+		return {};
+	}
+	lastOneShotMs_[uuid] = nowMs;
+
+	std::string message = remoteStatsFullMessage(document, uuid);
+	const auto subscriber = subscribers_.find(uuid);
+	if (subscriber != subscribers_.end()) {
+		rememberFull(subscriber->second, uuid, document, nowMs);
+		subscriber->second.nextDueMs = std::max(subscriber->second.nextDueMs, nowMs + limits_.intervalMs);
+	}
+	return message;
+}
+
+void RemoteStatsPublisher::rememberFull(Subscriber &subscriber, const std::string &uuid,
+                                        const RemoteStatsDocument &document, int64_t nowMs) const
+{
+	subscriber.sentFields.clear();
+	for (const auto &entry : document.peers) {
+		if (entry.first != uuid) {
+			subscriber.sentFields.emplace(entry.first, entry.second.fields);
+		}
+	}
+	subscriber.sentPipeline = document.pipelineJson;
+	subscriber.hasBaseline = true;
+	subscriber.lastFullMs = nowMs;
+}
+
+int64_t RemoteStatsPublisher::nextPushDelayMs(size_t messageBytes) const
+{
+	if (limits_.bytesPerSecond == 0) {
+		return limits_.intervalMs;
+	}
+	const int64_t byteDelayMs = static_cast<int64_t>(messageBytes * 1000 / limits_.bytesPerSecond);
+	return std::max(limits_.intervalMs, byteDelayMs);
+}
+
+} // namespace vdoninja
@@ -0,0 +1,104 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Shared remote stats documents and per-subscriber delta delivery
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vdoninja
+{
+
+// One viewer's entry in a remoteStats document. fields holds its top-level
+// keys with their raw JSON values, compared one by one so a delta carries only
+// the keys that moved; transport and latency counters change on most builds,
+// while role, state and the viewer's own report rarely do. The report age
+// ticks on every build, so it is never compared and only rides along with a
+// changed report.
+struct RemoteStatsEntry {
+	std::string json;
+	std::map<std::string, std::string> fields;
+	int64_t lastStatsAgeMs = -1;
+};
+
+// Builds an entry from its fields; a negative age is left out.
+RemoteStatsEntry makeRemoteStatsEntry(std::map<std::string, std::string> fields, int64_t lastStatsAgeMs = -1);
+
+// Built once per interval and shared by every subscriber.
+struct RemoteStatsDocument {
+	int64_t builtAtMs = 0;
+	std::map<std::string, RemoteStatsEntry> peers;
+	// Raw publishLatencyUs object.
+	std::string pipelineJson = "{}";
+};
+
+// Full {"remoteStats":{...},"publishLatencyUs":{...}} message, leaving out the
+// recipient's own entry.
+std::string remoteStatsFullMessage(const RemoteStatsDocument &document, const std::string &recipientUuid);
+
+// Tracks what each continuous subscriber has already been sent. The first
+// push is a full snapshot under "remoteStats"; later pushes carry only the
+// changed keys of changed entries under "remoteStatsDelta", with a key that
+// disappeared sent as null, plus "remoteStatsRemoved" for viewers that left.
+// A full snapshot is resent periodically so a subscriber that missed a delta
+// recovers. Each subscriber is also held to a minimum interval and a byte
+// rate, so one large room cannot flood a director's data channel.
+class RemoteStatsPublisher
+{
+public:
+	struct Limits {
+		int64_t intervalMs = 3000;
+		int64_t fullSnapshotIntervalMs = 30000;
+		// Pushes larger than this per second of interval push the next one out.
+		size_t bytesPerSecond = 32768;
+		// Minimum spacing of one-shot answers to the same peer.
+		int64_t oneShotIntervalMs = 1000;
+	};
+
+	RemoteStatsPublisher();
+	explicit RemoteStatsPublisher(const Limits &limits);
+
+	void addSubscriber(const std::string &uuid, int64_t nowMs);
+	void removeSubscriber(const std::string &uuid);
+	void clear();
+	bool empty() const { return subscribers_.empty(); }
+	size_t subscriberCount() const { return subscribers_.size(); }
+
+	// Earliest time a subscriber is due, or 0 when there are none.
+	int64_t nextDueMs() const;
+	std::vector<std::string> dueSubscribers(int64_t nowMs) const;
+
+	// Message for a due subscriber, or "" when nothing changed since its last
+	// push. Either way the subscriber is rescheduled.
+	std::string pushFor(const std::string &uuid, const RemoteStatsDocument &document, int64_t nowMs);
+
+	// Full snapshot answering a one-shot request, or "" when the same peer was
+	// answered within oneShotIntervalMs. A subscriber's delta baseline is reset
+	// to what this snapshot contained.
+	std::string answerRequest(const std::string &uuid, const RemoteStatsDocument &document, int64_t nowMs);
+
+private:
+	struct Subscriber {
+		int64_t nextDueMs = 0;
+		bool hasBaseline = false;
+		int64_t lastFullMs = 0;
+		std::map<std::string, std::map<std::string, std::string>> sentFields;
+		std::string sentPipeline;
+	};
+
+	void rememberFull(Subscriber &subscriber, const std::string &uuid, const RemoteStatsDocument &document,
+	                  int64_t nowMs) const;
+	int64_t nextPushDelayMs(size_t messageBytes) const;
+
+	Limits limits_;
+	std::map<std::string, Subscriber> subscribers_;
+	std::map<std::string, int64_t> lastOneShotMs_;
+};
+
+} // namespace vdoninja
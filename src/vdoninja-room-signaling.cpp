@@ -0,0 +1,345 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Room signaling connection shared by native receivers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-room-signaling.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include "vdoninja-signaling-protocol.h"
+#include "vdoninja-signaling.h"
+#include "vdoninja-utils.h"
+
+namespace vdoninja
+{
+
+namespace
+{
+
+using RoomKey = std::tuple<std::string, std::string, std::string, std::string>;
+
+std::mutex &registryMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+std::map<RoomKey, std::weak_ptr<VDONinjaRoomSignaling>> &registry()
+{
+	static std::map<RoomKey, std::weak_ptr<VDONinjaRoomSignaling>> rooms;
+	return rooms;
+}
+
+bool isRoomEvent(ParsedSignalKind kind)
+{
+	return kind == ParsedSignalKind::Listing || kind == ParsedSignalKind::Alert ||
+	       kind == ParsedSignalKind::VideoAddedToRoom || kind == ParsedSignalKind::VideoRemovedFromRoom;
+}
+
+} // namespace
+
+std::shared_ptr<VDONinjaRoomSignaling> VDONinjaRoomSignaling::acquire(const std::string &wssHost,
+                                                                      const std::string &roomId,
+                                                                      const std::string &password,
+                                                                      const std::string &salt)
+{
+	const RoomKey key(wssHost, roomId, password, salt);
+	std::lock_guard<std::mutex> lock(registryMutex());
+	auto &rooms = registry();
+	for (auto it = rooms.begin(); it != rooms.end();) {
+		it = it->second.expired() ? rooms.erase(it) : std::next(it);
+	}
+	if (auto existing = rooms[key].lock()) {
+		return existing;
+	}
+	auto room = std::make_shared<VDONinjaRoomSignaling>(wssHost, roomId, password, salt);
+	rooms[key] = room;
+	return room;
+}
+
+VDONinjaRoomSignaling::VDONinjaRoomSignaling(const std::string &wssHost, const std::string &roomId,
+                                             const std::string &password, const std::string &salt)
+    : wssHost_(wssHost), roomId_(roomId), password_(password), salt_(salt),
+      upstream_(std::make_unique<VDONinjaSignaling>())
+{
+	upstream_->setSalt(salt_);
+	upstream_->setOnConnected([this]() { handleUpstreamConnected(); });
+	upstream_->setOnDisconnected([this]() { handleUpstreamDisconnected(); });
+	upstream_->setOnRawMessage([this](const std::string &message) { deliver(message); });
+}
+
+VDONinjaRoomSignaling::~VDONinjaRoomSignaling()
+{
+	// Disconnects and waits out callbacks that still reference this object.
+	upstream_.reset();
+}
+
+bool VDONinjaRoomSignaling::attach(VDONinjaSignaling &client)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!findLocked(client)) {
+			subscribers_.push_back(Subscriber{&client, {}});
+		}
+	}
+	if (!openUpstream()) {
+		logError("Failed to open shared signaling for room %s", roomId_.c_str());
+		detach(client);
+		return false;
+	}
+	client.handleRoomConnectionOpened();
+	return true;
+}
+
+void VDONinjaRoomSignaling::detach(VDONinjaSignaling &client)
+{
+	std::lock_guard<std::recursive_mutex> deliveryLock(deliveryMutex_);
+	bool last = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		// The server may still answer this client's plays, and its publishers
+		// keep offering; none of that is another receiver's.
+		if (Subscriber *subscriber = findLocked(client)) {
+			releasedStreams_.insert(subscriber->streams.begin(), subscriber->streams.end());
+		}
+		subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+		                                  [&](const Subscriber &entry) { return entry.client == &client; }),
+		                   subscribers_.end());
+		for (auto it = peers_.begin(); it != peers_.end();) {
+			if (it->second == &client) {
+				releasedPeers_.insert(it->first);
+				it = peers_.erase(it);
+			} else {
+				it = std::next(it);
+			}
+		}
+		pendingPlays_.erase(std::remove(pendingPlays_.begin(), pendingPlays_.end(), &client), pendingPlays_.end());
+		last = subscribers_.empty();
+		if (last) {
+			lastListing_.clear();
+			releasedStreams_.clear();
+			releasedPeers_.clear();
+		}
+#ifdef TESTING_BUILD
+		if (testTransport_) {
+			return;
+		}
+#endif
+	}
+	if (last) {
+		logInfo("Closing shared signaling for room %s", roomId_.c_str());
+		upstream_->disconnect();
+	}
+}
+
+void VDONinjaRoomSignaling::send(VDONinjaSignaling &client, const std::string &message)
+{
+	// Requests built by VDONinjaSignaling are always lower case.
+	ParsedSignalMessage parsed;
+	if (!parseSignalingMessage(message, parsed)) {
+		return;
+	}
+	const std::string &request = parsed.request;
+	const std::string &streamId = parsed.streamId;
+	if (request == "leaveroom") {
+		return;
+	}
+	if (request == "joinroom") {
+		std::string listing;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			listing = lastListing_;
+		}
+		if (!listing.empty()) {
+			std::lock_guard<std::recursive_mutex> deliveryLock(deliveryMutex_);
+			client.processIncomingMessage(listing);
+		}
+		return;
+	}
+
+	std::function<void(const std::string &)> transport;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (request == "play") {
+			Subscriber *subscriber = findLocked(client);
+			if (!subscriber) {
+				return;
+			}
+			if (!streamId.empty() && std::find(subscriber->streams.begin(), subscriber->streams.end(), streamId) ==
+			                             subscriber->streams.end()) {
+				subscriber->streams.push_back(streamId);
+			}
+			releasedStreams_.erase(streamId);
+			if (std::find(pendingPlays_.begin(), pendingPlays_.end(), &client) == pendingPlays_.end()) {
+				pendingPlays_.push_back(&client);
+			}
+		}
+#ifdef TESTING_BUILD
+		transport = testTransport_;
+#endif
+	}
+	if (transport) {
+		transport(message);
+		return;
+	}
+	upstream_->forwardMessage(message);
+}
+
+void VDONinjaRoomSignaling::deliver(const std::string &message)
+{
+	ParsedSignalMessage parsed;
+	if (!parseSignalingMessage(message, parsed)) {
+		return;
+	}
+
+	std::lock_guard<std::recursive_mutex> deliveryLock(deliveryMutex_);
+	std::vector<VDONinjaSignaling *> targets;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (isRoomEvent(parsed.kind) || parsed.uuid.empty()) {
+			if (parsed.kind == ParsedSignalKind::Listing) {
+				lastListing_ = message;
+			}
+			targets = clientsLocked();
+		} else if (auto peer = peers_.find(parsed.uuid); peer != peers_.end()) {
+			targets.push_back(peer->second);
+		} else if (parsed.kind == ParsedSignalKind::Offer || message.find("\"description\"") != std::string::npos) {
+			// Encrypted offers only show their kind once a receiver decrypts them.
+			if (VDONinjaSignaling *target = routeOfferLocked(parsed.uuid, parsed.streamId)) {
+				targets.push_back(target);
+			}
+		}
+	}
+	if (targets.empty()) {
+		logDebug("Shared room signaling dropped a message from %s", parsed.uuid.c_str());
+		return;
+	}
+	for (VDONinjaSignaling *client : targets) {
+		bool subscribed = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			subscribed = findLocked(*client) != nullptr;
+		}
+		// An earlier target's callback may have detached a later one.
+		if (subscribed) {
+			client->processIncomingMessage(message);
+		}
+	}
+}
+
+size_t VDONinjaRoomSignaling::subscribers() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return subscribers_.size();
+}
+
+#ifdef TESTING_BUILD
+void VDONinjaRoomSignaling::useTransportForTesting(std::function<void(const std::string &)> sent)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	testTransport_ = std::move(sent);
+}
+#endif
+
+bool VDONinjaRoomSignaling::openUpstream()
+{
+#ifdef TESTING_BUILD
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (testTransport_) {
+			return true;
+		}
+	}
+#endif
+	std::lock_guard<std::mutex> openLock(openMutex_);
+	if (upstream_->isConnected()) {
+		return true;
+	}
+	logInfo("Opening shared signaling for room %s", roomId_.c_str());
+	return upstream_->connect(wssHost_);
+}
+
+void VDONinjaRoomSignaling::handleUpstreamConnected()
+{
+	upstream_->joinRoom(roomId_, password_);
+	std::lock_guard<std::recursive_mutex> deliveryLock(deliveryMutex_);
+	std::vector<VDONinjaSignaling *> clients;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		clients = clientsLocked();
+	}
+	for (VDONinjaSignaling *client : clients) {
+		client->handleRoomConnectionOpened();
+	}
+}
+
+void VDONinjaRoomSignaling::handleUpstreamDisconnected()
+{
+	std::lock_guard<std::recursive_mutex> deliveryLock(deliveryMutex_);
+	std::vector<VDONinjaSignaling *> clients;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		// A new socket is a new session; publishers offer again after the
+		// receivers replay their play requests.
+		peers_.clear();
+		pendingPlays_.clear();
+		lastListing_.clear();
+		releasedStreams_.clear();
+		releasedPeers_.clear();
+		clients = clientsLocked();
+	}
+	for (VDONinjaSignaling *client : clients) {
+		client->handleRoomConnectionClosed();
+	}
+}
+
+std::vector<VDONinjaSignaling *> VDONinjaRoomSignaling::clientsLocked() const
+{
+	std::vector<VDONinjaSignaling *> clients;
+	clients.reserve(subscribers_.size());
+	for (const auto &entry : subscribers_) {
+		clients.push_back(entry.client);
+	}
+	return clients;
+}
+
+VDONinjaRoomSignaling::Subscriber *VDONinjaRoomSignaling::findLocked(const VDONinjaSignaling &client)
+{
+	for (auto &entry : subscribers_) {
+		if (entry.client == &client) {
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+VDONinjaSignaling *VDONinjaRoomSignaling::routeOfferLocked(const std::string &uuid, const std::string &streamId)
+{
+	VDONinjaSignaling *target = nullptr;
+	if (!streamId.empty()) {
+		for (const auto &entry : subscribers_) {
+			if (std::find(entry.streams.begin(), entry.streams.end(), streamId) != entry.streams.end()) {
+				target = entry.client;
+				break;
+			}
+		}
+	}
+	const bool released =
+	    releasedPeers_.count(uuid) != 0 || (!streamId.empty() && releasedStreams_.count(streamId) != 0);
+	if (!target && !released && !pendingPlays_.empty()) {
+		target = pendingPlays_.front();
+	}
+	if (!target) {
+		return nullptr;
+	}
+	pendingPlays_.erase(std::remove(pendingPlays_.begin(), pendingPlays_.end(), target), pendingPlays_.end());
+	releasedPeers_.erase(uuid);
+	peers_[uuid] = target;
+	return target;
+}
+
+} // namespace vdoninja
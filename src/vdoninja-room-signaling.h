@@ -0,0 +1,116 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Room signaling connection shared by native receivers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace vdoninja
+{
+
+class VDONinjaSignaling;
+
+// One WebSocket joined to a room, carrying every native receiver that watches
+// a stream in that room. Auto-inbound creates a receiver per guest, and with a
+// private connection each one joined the room again and received every room
+// event. Receivers keep their own VDONinjaSignaling for stream state,
+// encryption and callbacks; this routes their messages by stream ID.
+//
+// A receiver's play request binds its hashed stream ID. An offer is delivered
+// to the receiver whose stream it names, or else to the oldest unanswered play,
+// and binds the publisher UUID to that receiver so its answers, candidates and
+// cleanup follow. A receiver that detaches releases its streams and UUIDs; a
+// later offer naming one of them is dropped, as the server cannot retract a
+// play. Room events without a peer are delivered to every receiver.
+// Internally synchronized.
+class VDONinjaRoomSignaling
+{
+public:
+	// Returns the open connection for this room, creating it on first use.
+	static std::shared_ptr<VDONinjaRoomSignaling> acquire(const std::string &wssHost, const std::string &roomId,
+	                                                      const std::string &password, const std::string &salt);
+
+	VDONinjaRoomSignaling(const std::string &wssHost, const std::string &roomId, const std::string &password,
+	                      const std::string &salt);
+	~VDONinjaRoomSignaling();
+
+	VDONinjaRoomSignaling(const VDONinjaRoomSignaling &) = delete;
+	VDONinjaRoomSignaling &operator=(const VDONinjaRoomSignaling &) = delete;
+
+	// Subscribes client and opens the WebSocket if it is the first. Returns
+	// false, unsubscribed, when the room cannot be reached.
+	bool attach(VDONinjaSignaling &client);
+	// Unsubscribes client, waiting out a delivery to it on another thread. The
+	// WebSocket closes with the last subscriber.
+	void detach(VDONinjaSignaling &client);
+	// Sends a message built by client. Room membership belongs to this
+	// connection, so join and leave requests are answered locally.
+	void send(VDONinjaSignaling &client, const std::string &message);
+	// Routes one message received on the room WebSocket.
+	void deliver(const std::string &message);
+
+	size_t subscribers() const;
+
+#ifdef TESTING_BUILD
+	// Replaces the WebSocket: outgoing messages go to sent and the room counts
+	// as connected. Deliver incoming messages with deliver().
+	void useTransportForTesting(std::function<void(const std::string &)> sent);
+#endif
+
+private:
+	struct Subscriber {
+		VDONinjaSignaling *client = nullptr;
+		std::vector<std::string> streams;
+	};
+
+	bool openUpstream();
+	void handleUpstreamConnected();
+	void handleUpstreamDisconnected();
+	std::vector<VDONinjaSignaling *> clientsLocked() const;
+	Subscriber *findLocked(const VDONinjaSignaling &client);
+	VDONinjaSignaling *routeOfferLocked(const std::string &uuid, const std::string &streamId);
+
+	const std::string wssHost_;
+	const std::string roomId_;
+	const std::string password_;
+	const std::string salt_;
+	std::unique_ptr<VDONinjaSignaling> upstream_;
+
+	// Held across delivery to subscribers, so detach() cannot return while its
+	// client is in a callback. Recursive because those callbacks may send,
+	// detach or trigger another delivery on the same thread.
+	std::recursive_mutex deliveryMutex_;
+	// Serializes opening the WebSocket for concurrent first subscribers.
+	std::mutex openMutex_;
+
+	mutable std::mutex mutex_;
+	// Guarded by mutex_.
+	std::vector<Subscriber> subscribers_;
+	// Guarded by mutex_. Publisher UUID to the receiver its offer went to.
+	std::map<std::string, VDONinjaSignaling *> peers_;
+	// Guarded by mutex_. Receivers whose play has not been answered, oldest first.
+	std::deque<VDONinjaSignaling *> pendingPlays_;
+	// Guarded by mutex_. Replayed to receivers that join after it arrived.
+	std::string lastListing_;
+	// Guarded by mutex_. Streams and publisher UUIDs of detached receivers,
+	// whose offers are dropped instead of answering another receiver's play.
+	std::set<std::string> releasedStreams_;
+	std::set<std::string> releasedPeers_;
+
+#ifdef TESTING_BUILD
+	// Guarded by mutex_.
+	std::function<void(const std::string &)> testTransport_;
+#endif
+};
+
+} // namespace vdoninja
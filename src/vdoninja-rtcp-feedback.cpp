@@ -90,6 +90,7 @@ void RtcpFeedbackTracker::observe(const uint8_t *data, size_t size, uint32_t com
 	RtcpFeedbackStats observed;
 	observed.compoundPackets = 1;
 	std::optional<RtcpRembEstimate> observedRemb;
+	bool measuredRtt = false;
 
 	if (!data || size < kRtcpHeaderBytes) {
 		observed.malformedPackets = 1;
@@ -207,6 +208,7 @@ void RtcpFeedbackTracker::observe(const uint8_t *data, size_t size, uint32_t com
 						const uint64_t roundTripMs = (static_cast<uint64_t>(roundTripUnits) * 1000ULL) / 65536ULL;
 						if (roundTripMs <= kMaximumPlausibleRttMs) {
 							observed.maxRttMs = std::max(observed.maxRttMs, roundTripMs);
+							measuredRtt = true;
 						}
 					}
 				}
@@ -249,6 +251,33 @@ void RtcpFeedbackTracker::observe(const uint8_t *data, size_t size, uint32_t com
 	if (observedRemb) {
 		latestRemb_ = observedRemb;
 	}
+	if (observed.receiverReports > 0) {
+		RtcpReceiverReport report;
+		report.sequence = latestReceiverReport_ ? latestReceiverReport_->sequence + 1U : 1U;
+		report.fractionLost = observed.maxFractionLost;
+		report.cumulativeLost = observed.maxCumulativeLost;
+		report.jitterTicks = observed.maxJitterTicks;
+		if (measuredRtt) {
+			report.rttMs = observed.maxRttMs;
+		}
+		report.observedAt = std::chrono::steady_clock::now();
+		latestReceiverReport_ = report;
+	}
+
+	totals_.nackMessages += observed.nackMessages;
+	totals_.nackRequestedPackets += observed.nackRequestedPackets;
+	totals_.pliMessages += observed.pliMessages;
+	totals_.firMessages += observed.firMessages;
+	totals_.reportBlocks += observed.reportBlocks;
+	if (observed.reportBlocks > 0) {
+		totals_.lastFractionLost = observed.maxFractionLost;
+	}
+	if (observed.maxRttMs > 0) {
+		totals_.lastRttMs = observed.maxRttMs;
+	}
+	if (observedRemb) {
+		totals_.lastRembBitrateBps = observedRemb->bitrateBitsPerSecond;
+	}
 }
 
 void RtcpFeedbackTracker::noteNackCacheResult(bool hit)
@@ -301,6 +330,12 @@ RtcpFeedbackStats RtcpFeedbackTracker::take()
 	return snapshot;
 }
 
+RtcpFeedbackTotals RtcpFeedbackTracker::totals() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return totals_;
+}
+
 std::optional<RtcpRembEstimate> RtcpFeedbackTracker::latestRemb(std::chrono::milliseconds maxAge) const
 {
 	std::lock_guard<std::mutex> lock(mutex_);
@@ -314,11 +349,26 @@ std::optional<RtcpRembEstimate> RtcpFeedbackTracker::latestRemb(std::chrono::mil
 	return latestRemb_;
 }
 
+std::optional<RtcpReceiverReport> RtcpFeedbackTracker::latestReceiverReport(std::chrono::milliseconds maxAge) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!latestReceiverReport_ || maxAge.count() <= 0) {
+		return std::nullopt;
+	}
+	const auto now = std::chrono::steady_clock::now();
+	if (now > latestReceiverReport_->observedAt && now - latestReceiverReport_->observedAt > maxAge) {
+		return std::nullopt;
+	}
+	return latestReceiverReport_;
+}
+
 void RtcpFeedbackTracker::reset()
 {
 	std::lock_guard<std::mutex> lock(mutex_);
 	stats_ = {};
+	totals_ = {};
 	latestRemb_.reset();
+	latestReceiverReport_.reset();
 }
 
 uint32_t RtcpFeedbackTracker::currentCompactNtp()
@@ -40,11 +40,40 @@ struct RtcpFeedbackStats {
 	uint64_t maxRembBitrateBps = 0;
 };
 
+// Lifetime counters and the most recent report values. Unlike RtcpFeedbackStats
+// these are never drained by take(), so a stats consumer can diff them on its
+// own schedule without stealing the periodic publish log's interval.
+struct RtcpFeedbackTotals {
+	uint64_t nackMessages = 0;
+	uint64_t nackRequestedPackets = 0;
+	uint64_t pliMessages = 0;
+	uint64_t firMessages = 0;
+	uint64_t reportBlocks = 0;
+	uint8_t lastFractionLost = 0;
+	uint64_t lastRttMs = 0;
+	uint64_t lastRembBitrateBps = 0;
+};
+
 struct RtcpRembEstimate {
 	uint64_t bitrateBitsPerSecond = 0;
 	std::chrono::steady_clock::time_point observedAt;
 };
 
+// The newest receiver report blocks for the tracked SSRC, folded the same way
+// as RtcpFeedbackStats when one compound packet carries several.
+struct RtcpReceiverReport {
+	// Increments with every compound packet that carried a matching block, so
+	// a consumer polling on its own schedule can tell a new report from a
+	// repeat of the one it already acted on.
+	uint64_t sequence = 0;
+	uint8_t fractionLost = 0;
+	int32_t cumulativeLost = 0;
+	uint32_t jitterTicks = 0;
+	// Only present when the viewer echoed one of our sender reports.
+	std::optional<uint64_t> rttMs;
+	std::chrono::steady_clock::time_point observedAt;
+};
+
 // Parses only the RTCP fields needed for diagnostics. It never modifies media,
 // sends feedback, or participates in recovery decisions.
 class RtcpFeedbackTracker
@@ -59,7 +88,9 @@ public:
 	void noteRetransmissionExpired();
 	RtcpFeedbackStats snapshot() const;
 	RtcpFeedbackStats take();
+	RtcpFeedbackTotals totals() const;
 	std::optional<RtcpRembEstimate> latestRemb(std::chrono::milliseconds maxAge) const;
+	std::optional<RtcpReceiverReport> latestReceiverReport(std::chrono::milliseconds maxAge) const;
 	void reset();
 
 	static uint32_t currentCompactNtp();
@@ -70,7 +101,9 @@ private:
 	const uint32_t mediaSsrc_;
 	mutable std::mutex mutex_;
 	RtcpFeedbackStats stats_;
+	RtcpFeedbackTotals totals_;
 	std::optional<RtcpRembEstimate> latestRemb_;
+	std::optional<RtcpReceiverReport> latestReceiverReport_;
 };
 
 } // namespace vdoninja
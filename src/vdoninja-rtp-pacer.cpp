@@ -11,6 +11,8 @@
 #include <stdexcept>
 #include <utility>
 
+#include "vdoninja-thread-cpu.h"
+
 namespace vdoninja
 {
 
@@ -26,6 +28,9 @@ constexpr size_t kMinimumDuplicateQueueBytes = 64U * 1024U;
 constexpr uint64_t kVideoPacerRateMultiplier = 2;
 constexpr uint64_t kMinimumVideoPacerBitrate = 2000000;
 constexpr uint64_t kMaximumVideoPacerBitrate = 100000000;
+constexpr uint32_t kGuestPacerWeight = 1;
+constexpr uint32_t kDirectorPacerWeight = 2;
+constexpr uint32_t kScenePacerWeight = 4;
 
 size_t calculateBurstBudget(uint64_t bitrateBitsPerSecond, std::chrono::milliseconds burstWindow)
 {
@@ -121,6 +126,32 @@ uint16_t rewindRtpSequenceNumber(uint16_t nextSequenceNumber, size_t unsentPacke
 	return static_cast<uint16_t>(nextSequenceNumber - static_cast<uint16_t>(unsentPackets));
 }
 
+uint32_t pacerWeightForViewerRole(ViewerPacerRole role) noexcept
+{
+	switch (role) {
+	case ViewerPacerRole::Scene:
+		return kScenePacerWeight;
+	case ViewerPacerRole::Director:
+		return kDirectorPacerWeight;
+	case ViewerPacerRole::Guest:
+	default:
+		return kGuestPacerWeight;
+	}
+}
+
+const char *viewerPacerRoleName(ViewerPacerRole role) noexcept
+{
+	switch (role) {
+	case ViewerPacerRole::Scene:
+		return "scene";
+	case ViewerPacerRole::Director:
+		return "director";
+	case ViewerPacerRole::Guest:
+	default:
+		return "guest";
+	}
+}
+
 RtpSharedPacerBudget::RtpSharedPacerBudget(size_t burstBudgetBytes)
     : burstBudgetBytes_(burstBudgetBytes), availableTokens_(static_cast<long double>(burstBudgetBytes)),
       lastTokenUpdate_(std::chrono::steady_clock::now())
@@ -130,22 +161,29 @@ RtpSharedPacerBudget::RtpSharedPacerBudget(size_t burstBudgetBytes)
 	}
 }
 
-uint64_t RtpSharedPacerBudget::addParticipant(uint64_t bitrateBitsPerSecond)
+uint64_t RtpSharedPacerBudget::addParticipant(uint64_t bitrateBitsPerSecond, uint32_t weight)
 {
-	if (bitrateBitsPerSecond == 0) {
-		throw std::invalid_argument("Shared RTP pacer participant bitrate must be positive");
+	if (bitrateBitsPerSecond == 0 || weight == 0) {
+		throw std::invalid_argument("Shared RTP pacer participant bitrate and weight must be positive");
 	}
 
 	std::lock_guard<std::mutex> lock(mutex_);
 	updateTokensLocked(std::chrono::steady_clock::now());
 	const uint64_t participantId = nextParticipantId_++;
-	participantRates_.emplace(participantId, bitrateBitsPerSecond);
+	Participant &participant = participants_[participantId];
+	participant.bitrateBitsPerSecond = bitrateBitsPerSecond;
+	participant.weight = weight;
+	// A newcomer starts level with the current round rather than being owed
+	// everything sent before it joined.
+	participant.finishTag = virtualTime_;
+	participant.share.weight = weight;
+	participant.intervalStartTotalBytes = totalGrantedBytes_;
 	if (bitrateBitsPerSecond > std::numeric_limits<uint64_t>::max() - aggregateBitrateBitsPerSecond_) {
 		aggregateBitrateBitsPerSecond_ = std::numeric_limits<uint64_t>::max();
 	} else {
 		aggregateBitrateBitsPerSecond_ += bitrateBitsPerSecond;
 	}
-	cv_.notify_all();
+	notifyNextWaiterLocked();
 	return participantId;
 }
 
@@ -156,19 +194,35 @@ void RtpSharedPacerBudget::updateParticipant(uint64_t participantId, uint64_t bi
 	}
 
 	std::lock_guard<std::mutex> lock(mutex_);
-	const auto found = participantRates_.find(participantId);
-	if (found == participantRates_.end()) {
+	const auto found = participants_.find(participantId);
+	if (found == participants_.end()) {
 		return;
 	}
 	updateTokensLocked(std::chrono::steady_clock::now());
-	aggregateBitrateBitsPerSecond_ -= found->second;
-	found->second = bitrateBitsPerSecond;
+	aggregateBitrateBitsPerSecond_ -= found->second.bitrateBitsPerSecond;
+	found->second.bitrateBitsPerSecond = bitrateBitsPerSecond;
 	if (bitrateBitsPerSecond > std::numeric_limits<uint64_t>::max() - aggregateBitrateBitsPerSecond_) {
 		aggregateBitrateBitsPerSecond_ = std::numeric_limits<uint64_t>::max();
 	} else {
 		aggregateBitrateBitsPerSecond_ += bitrateBitsPerSecond;
 	}
-	cv_.notify_all();
+	// A rate change moves the refill time the next waiter is sleeping toward.
+	notifyNextWaiterLocked();
+}
+
+void RtpSharedPacerBudget::setParticipantWeight(uint64_t participantId, uint32_t weight)
+{
+	if (participantId == 0 || weight == 0) {
+		throw std::invalid_argument("Shared RTP pacer participant weight must be positive");
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto found = participants_.find(participantId);
+	if (found == participants_.end()) {
+		return;
+	}
+	found->second.weight = weight;
+	found->second.share.weight = weight;
 }
 
 void RtpSharedPacerBudget::removeParticipant(uint64_t participantId)
@@ -179,19 +233,21 @@ void RtpSharedPacerBudget::removeParticipant(uint64_t participantId)
 
 	std::lock_guard<std::mutex> lock(mutex_);
 	updateTokensLocked(std::chrono::steady_clock::now());
-	const auto found = participantRates_.find(participantId);
-	if (found == participantRates_.end()) {
+	const auto found = participants_.find(participantId);
+	if (found == participants_.end()) {
 		return;
 	}
-	aggregateBitrateBitsPerSecond_ -= found->second;
-	participantRates_.erase(found);
-	if (participantRates_.empty()) {
+	aggregateBitrateBitsPerSecond_ -= found->second.bitrateBitsPerSecond;
+	participants_.erase(found);
+	if (participants_.empty()) {
 		availableTokens_ = static_cast<long double>(burstBudgetBytes_);
+		virtualTime_ = 0.0L;
 	}
-	cv_.notify_all();
+	notifyNextWaiterLocked();
 }
 
-bool RtpSharedPacerBudget::acquire(size_t packetBytes, const std::function<bool()> &cancelled, bool *waited)
+bool RtpSharedPacerBudget::acquire(uint64_t participantId, size_t packetBytes, bool priority,
+                                   const std::function<bool()> &cancelled, bool *waited)
 {
 	if (packetBytes == 0) {
 		if (waited) {
@@ -201,68 +257,103 @@ bool RtpSharedPacerBudget::acquire(size_t packetBytes, const std::function<bool(
 	}
 
 	std::unique_lock<std::mutex> lock(mutex_);
-	const uint64_t waiterId = nextWaiterId_++;
-	waiters_.push_back(waiterId);
+	const auto found = participants_.find(participantId);
+	if (found == participants_.end()) {
+		if (waited) {
+			*waited = false;
+		}
+		return false;
+	}
+	Participant &participant = found->second;
+	const auto requestedAt = std::chrono::steady_clock::now();
+	const long double previousFinishTag = participant.finishTag;
+	participant.finishTag = std::max(participant.finishTag, virtualTime_) +
+	                        static_cast<long double>(packetBytes) / static_cast<long double>(participant.weight);
+	participant.waiting = true;
+	participant.priority = priority;
+	participant.requestSequence = nextRequestSequence_++;
 	bool didWait = false;
-	auto removeWaiter = [&]() {
-		const auto found = std::find(waiters_.begin(), waiters_.end(), waiterId);
-		if (found != waiters_.end()) {
-			waiters_.erase(found);
+	auto finish = [&](bool granted) {
+		participant.waiting = false;
+		if (!granted) {
+			participant.finishTag = previousFinishTag;
+		}
+		// The next waiter may have been sleeping behind this request.
+		notifyNextWaiterLocked();
+		if (waited) {
+			*waited = didWait;
 		}
-		cv_.notify_all();
+		return granted;
 	};
 
 	while (true) {
 		if (cancelled && cancelled()) {
-			removeWaiter();
-			if (waited) {
-				*waited = didWait;
-			}
-			return false;
+			return finish(false);
 		}
 
 		const auto now = std::chrono::steady_clock::now();
 		updateTokensLocked(now);
 		if (aggregateBitrateBitsPerSecond_ == 0) {
-			removeWaiter();
-			if (waited) {
-				*waited = didWait;
-			}
-			return false;
+			return finish(false);
+		}
+
+		if (nextWaiterLocked() != participantId) {
+			// Whoever is granted before this participant hands it the turn.
+			didWait = true;
+			participant.cv.wait(lock);
+			continue;
 		}
 
-		const bool atFront = !waiters_.empty() && waiters_.front() == waiterId;
 		const long double requiredTokens = static_cast<long double>(std::min(packetBytes, burstBudgetBytes_));
-		if (atFront && availableTokens_ >= requiredTokens) {
+		if (availableTokens_ >= requiredTokens) {
 			// Subtract the full packet size, even when one packet is larger than
 			// the bucket. The negative balance repays that unavoidable packet
 			// burst before another packet is admitted.
 			availableTokens_ -= static_cast<long double>(packetBytes);
-			waiters_.pop_front();
-			cv_.notify_all();
-			if (waited) {
-				*waited = didWait;
+			if (!priority) {
+				virtualTime_ = std::max(virtualTime_, participant.finishTag);
 			}
-			return true;
-		}
-
-		if (!atFront) {
-			didWait = true;
-			cv_.wait_for(lock, std::chrono::milliseconds(5));
-			continue;
+			totalGrantedBytes_ += packetBytes;
+			participant.share.grantedBytes += packetBytes;
+			++participant.share.grantedPackets;
+			if (priority) {
+				++participant.share.priorityPackets;
+			}
+			participant.share.waitUs.record(elapsedMicroseconds(now, requestedAt));
+			return finish(true);
 		}
 
-		const auto waitDuration = tokenWaitDuration(requiredTokens - availableTokens_, aggregateBitrateBitsPerSecond_);
-		const auto cancellationPoll =
-		    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::milliseconds(5));
 		didWait = true;
-		cv_.wait_for(lock, std::min(waitDuration, cancellationPoll));
+		participant.cv.wait_for(lock,
+		                        tokenWaitDuration(requiredTokens - availableTokens_, aggregateBitrateBitsPerSecond_));
 	}
 }
 
-void RtpSharedPacerBudget::wake()
+void RtpSharedPacerBudget::wake(uint64_t participantId)
 {
-	cv_.notify_all();
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto found = participants_.find(participantId);
+	if (found != participants_.end()) {
+		found->second.cv.notify_one();
+	}
+}
+
+RtpSharedBudgetShare RtpSharedPacerBudget::takeParticipantShare(uint64_t participantId, bool resetInterval)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto found = participants_.find(participantId);
+	if (found == participants_.end()) {
+		return {};
+	}
+	Participant &participant = found->second;
+	RtpSharedBudgetShare share = participant.share;
+	share.totalGrantedBytes = totalGrantedBytes_ - participant.intervalStartTotalBytes;
+	if (resetInterval) {
+		participant.share = RtpSharedBudgetShare{};
+		participant.share.weight = participant.weight;
+		participant.intervalStartTotalBytes = totalGrantedBytes_;
+	}
+	return share;
 }
 
 uint64_t RtpSharedPacerBudget::bitrateBitsPerSecond() const
@@ -274,7 +365,7 @@ uint64_t RtpSharedPacerBudget::bitrateBitsPerSecond() const
 size_t RtpSharedPacerBudget::participantCount() const
 {
 	std::lock_guard<std::mutex> lock(mutex_);
-	return participantRates_.size();
+	return participants_.size();
 }
 
 void RtpSharedPacerBudget::updateTokensLocked(std::chrono::steady_clock::time_point now)
@@ -291,6 +382,41 @@ void RtpSharedPacerBudget::updateTokensLocked(std::chrono::steady_clock::time_po
 	lastTokenUpdate_ = now;
 }
 
+uint64_t RtpSharedPacerBudget::nextWaiterLocked() const
+{
+	uint64_t nextId = 0;
+	const Participant *next = nullptr;
+	for (const auto &entry : participants_) {
+		const Participant &candidate = entry.second;
+		if (!candidate.waiting) {
+			continue;
+		}
+		bool before = next == nullptr;
+		if (!before && candidate.priority != next->priority) {
+			before = candidate.priority;
+		} else if (!before && candidate.priority) {
+			// Priority requests go first come, first served.
+			before = candidate.requestSequence < next->requestSequence;
+		} else if (!before) {
+			before = candidate.finishTag < next->finishTag ||
+			         (candidate.finishTag == next->finishTag && candidate.requestSequence < next->requestSequence);
+		}
+		if (before) {
+			nextId = entry.first;
+			next = &candidate;
+		}
+	}
+	return nextId;
+}
+
+void RtpSharedPacerBudget::notifyNextWaiterLocked()
+{
+	const uint64_t nextId = nextWaiterLocked();
+	if (nextId != 0) {
+		participants_.find(nextId)->second.cv.notify_one();
+	}
+}
+
 RtpPacketPacer::RtpPacketPacer(uint64_t bitrateBitsPerSecond, std::chrono::milliseconds burstWindow,
                                SendCallback sendCallback, size_t maxQueueBytes,
                                std::shared_ptr<RtpSharedPacerBudget> sharedBudget,
@@ -553,6 +679,13 @@ void RtpPacketPacer::updateBitrate(uint64_t bitrateBitsPerSecond, uint64_t dupli
 	cv_.notify_all();
 }
 
+void RtpPacketPacer::setSharedBudgetWeight(uint32_t weight)
+{
+	if (sharedBudget_ && sharedParticipantId_ != 0) {
+		sharedBudget_->setParticipantWeight(sharedParticipantId_, weight);
+	}
+}
+
 void RtpPacketPacer::stop()
 {
 	std::lock_guard<std::mutex> stopLock(stopMutex_);
@@ -562,7 +695,7 @@ void RtpPacketPacer::stop()
 	}
 	cv_.notify_all();
 	if (sharedBudget_) {
-		sharedBudget_->wake();
+		sharedBudget_->wake(sharedParticipantId_);
 	}
 
 	if (worker_.joinable()) {
@@ -576,10 +709,15 @@ void RtpPacketPacer::stop()
 
 RtpPacerStats RtpPacketPacer::getStats(bool resetInterval)
 {
+	RtpSharedBudgetShare sharedBudgetShare;
+	if (sharedBudget_ && sharedParticipantId_ != 0) {
+		sharedBudgetShare = sharedBudget_->takeParticipantShare(sharedParticipantId_, resetInterval);
+	}
 	std::lock_guard<std::mutex> lock(mutex_);
 	stats_.queuedBytes = queuedBytes_;
 	stats_.queuedFrames = queue_.size();
-	const RtpPacerStats snapshot = stats_;
+	RtpPacerStats snapshot = stats_;
+	snapshot.sharedBudget = std::move(sharedBudgetShare);
 	if (resetInterval) {
 		stats_.maxQueuedBytes = queuedBytes_;
 		stats_.maxQueuedFrames = queue_.size();
@@ -604,12 +742,26 @@ RtpPacerStats RtpPacketPacer::getStats(bool resetInterval)
 		stats_.expiredDuplicates = 0;
 		stats_.failedDuplicates = 0;
 		stats_.sentDuplicateBytes = 0;
+		stats_.frameHoldUs = {};
+		stats_.sendCallUs = {};
 	}
 	return snapshot;
 }
 
+RtpPacerTotals RtpPacketPacer::totals() const noexcept
+{
+	RtpPacerTotals totals;
+	totals.sentPackets = totalSentPackets_.load(std::memory_order_relaxed);
+	totals.sentBytes = totalSentBytes_.load(std::memory_order_relaxed);
+	totals.sentRepairs = totalSentRepairs_.load(std::memory_order_relaxed);
+	totals.sentDuplicates = totalSentDuplicates_.load(std::memory_order_relaxed);
+	totals.lastFrameQueueDelayMs = lastFrameQueueDelayMs_.load(std::memory_order_relaxed);
+	return totals;
+}
+
 void RtpPacketPacer::run()
 {
+	setCurrentThreadName("vdo-pacer");
 	std::unique_lock<std::mutex> lock(mutex_);
 	long double availableTokens = static_cast<long double>(burstBudgetBytes_.load(std::memory_order_acquire));
 	auto lastTokenUpdate = std::chrono::steady_clock::now();
@@ -620,6 +772,7 @@ void RtpPacketPacer::run()
 	auto lastSendAt = std::chrono::steady_clock::time_point::min();
 	size_t currentBurstBytes = 0;
 	size_t consecutiveRepairPackets = 0;
+	bool sentFirstKeyframe = false;
 
 	while (!stopping_.load(std::memory_order_acquire)) {
 		auto now = std::chrono::steady_clock::now();
@@ -758,10 +911,15 @@ void RtpPacketPacer::run()
 		}
 
 		if (sharedBudget_) {
+			// Repairs and the keyframe a viewer starts on jump the shared queue;
+			// both unfreeze a picture, and repairs have their own rate cap.
+			const bool sharedPriority =
+			    sendRepair || (!sendDuplicate && queue_.front().info.keyframe && !sentFirstKeyframe);
 			lock.unlock();
 			bool sharedPacingWaited = false;
 			const bool acquired = sharedBudget_->acquire(
-			    packetBytes, [this]() { return stopping_.load(std::memory_order_acquire); }, &sharedPacingWaited);
+			    sharedParticipantId_, packetBytes, sharedPriority,
+			    [this]() { return stopping_.load(std::memory_order_acquire); }, &sharedPacingWaited);
 			lock.lock();
 			if (!acquired || stopping_.load(std::memory_order_acquire)) {
 				continue;
@@ -814,6 +972,9 @@ void RtpPacketPacer::run()
 			if (sent) {
 				++stats_.sentPackets;
 				++stats_.sentRepairs;
+				totalSentPackets_.fetch_add(1, std::memory_order_relaxed);
+				totalSentBytes_.fetch_add(packetBytes, std::memory_order_relaxed);
+				totalSentRepairs_.fetch_add(1, std::memory_order_relaxed);
 			} else {
 				++stats_.sendFailures;
 				++stats_.failedRepairs;
@@ -854,6 +1015,9 @@ void RtpPacketPacer::run()
 				++stats_.sentPackets;
 				++stats_.sentDuplicates;
 				stats_.sentDuplicateBytes += packetBytes;
+				totalSentPackets_.fetch_add(1, std::memory_order_relaxed);
+				totalSentBytes_.fetch_add(packetBytes, std::memory_order_relaxed);
+				totalSentDuplicates_.fetch_add(1, std::memory_order_relaxed);
 			} else {
 				++stats_.sendFailures;
 				++stats_.failedDuplicates;
@@ -866,6 +1030,8 @@ void RtpPacketPacer::run()
 		if (!frame.started) {
 			frame.started = true;
 			frame.firstSendAt = now;
+			stats_.frameHoldUs.record(elapsedMicroseconds(now, frame.queuedAt));
+			lastFrameQueueDelayMs_.store(elapsedMilliseconds(now, frame.queuedAt), std::memory_order_relaxed);
 		}
 
 		const uint64_t frameId = frame.id;
@@ -882,6 +1048,7 @@ void RtpPacketPacer::run()
 
 		lock.unlock();
 		bool sent = false;
+		const auto sendStartedAt = std::chrono::steady_clock::now();
 		try {
 			sent = sendCallback_(std::move(packet));
 		} catch (...) {
@@ -889,6 +1056,7 @@ void RtpPacketPacer::run()
 		}
 		const auto completedAt = std::chrono::steady_clock::now();
 		lock.lock();
+		stats_.sendCallUs.record(elapsedMicroseconds(completedAt, sendStartedAt));
 
 		if (queue_.empty() || queue_.front().id != frameId) {
 			continue;
@@ -898,6 +1066,8 @@ void RtpPacketPacer::run()
 		if (sent) {
 			++updatedFrame.sentPackets;
 			++stats_.sentPackets;
+			totalSentPackets_.fetch_add(1, std::memory_order_relaxed);
+			totalSentBytes_.fetch_add(packetBytes, std::memory_order_relaxed);
 			if (!duplicatePacket.empty()) {
 				queueDuplicateLocked(std::move(duplicatePacket), completedAt);
 			}
@@ -919,6 +1089,7 @@ void RtpPacketPacer::run()
 			++stats_.sentFrames;
 			if (updatedFrame.info.keyframe) {
 				++stats_.sentKeyframes;
+				sentFirstKeyframe = true;
 			}
 		}
 		stats_.queuedBytes = queuedBytes_;
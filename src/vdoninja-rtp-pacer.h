@@ -18,6 +18,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "vdoninja-latency-histogram.h"
 #include "vdoninja-loss-protection.h"
 
 namespace vdoninja
@@ -33,35 +34,82 @@ uint16_t rewindRtpSequenceNumber(uint16_t nextSequenceNumber, size_t unsentPacke
 uint64_t videoPacerBitrateForEncoderRate(int encoderBitrate) noexcept;
 uint64_t videoPacerBitrateForEncoderAndProtectionRate(int encoderBitrate, uint64_t protectionBitrate) noexcept;
 
-// A small aggregate token bucket shared by every viewer pacer. Per-peer pacers
-// still preserve frame ordering and fairness, while this budget prevents all
-// viewers from releasing their short burst allowance at the same instant.
+// Relative share of the aggregate viewer budget. Scene viewers usually feed
+// a production's program output, so they go first; the director's room view
+// comes next, and other guests share what remains.
+enum class ViewerPacerRole { Guest, Director, Scene };
+
+uint32_t pacerWeightForViewerRole(ViewerPacerRole role) noexcept;
+const char *viewerPacerRoleName(ViewerPacerRole role) noexcept;
+
+// One participant's use of the shared budget since its previous take.
+struct RtpSharedBudgetShare {
+	uint32_t weight = 0;
+	uint64_t grantedBytes = 0;
+	uint64_t grantedPackets = 0;
+	uint64_t priorityPackets = 0;
+	// Bytes granted to every participant over the same interval.
+	uint64_t totalGrantedBytes = 0;
+	// From asking for a packet's tokens to being granted them.
+	LatencyHistogramSnapshot waitUs;
+};
+
+// A small aggregate token bucket shared by every viewer pacer, so viewers
+// never release their short burst allowance at the same instant. Tokens are
+// handed out by self-clocked weighted fair queueing: each request is tagged
+// with a virtual finish time that advances by packetBytes / weight per
+// participant, and the earliest tag goes next. One viewer draining a large
+// keyframe therefore interleaves with everyone else's deltas instead of
+// holding them back. Priority requests (repairs and a viewer's first keyframe)
+// go ahead of the queue but are still charged to their participant. Only the
+// participant whose turn it is gets woken.
 class RtpSharedPacerBudget
 {
 public:
 	explicit RtpSharedPacerBudget(size_t burstBudgetBytes);
 
-	uint64_t addParticipant(uint64_t bitrateBitsPerSecond);
+	uint64_t addParticipant(uint64_t bitrateBitsPerSecond, uint32_t weight = 1);
 	void updateParticipant(uint64_t participantId, uint64_t bitrateBitsPerSecond);
+	void setParticipantWeight(uint64_t participantId, uint32_t weight);
+	// Must not race with an acquire() by the same participant.
 	void removeParticipant(uint64_t participantId);
-	bool acquire(size_t packetBytes, const std::function<bool()> &cancelled, bool *waited = nullptr);
-	void wake();
+	bool acquire(uint64_t participantId, size_t packetBytes, bool priority, const std::function<bool()> &cancelled,
+	             bool *waited = nullptr);
+	// Wakes the participant's pending acquire() so it rechecks cancellation.
+	void wake(uint64_t participantId);
+	RtpSharedBudgetShare takeParticipantShare(uint64_t participantId, bool resetInterval);
 
 	uint64_t bitrateBitsPerSecond() const;
 	size_t burstBudgetBytes() const noexcept { return burstBudgetBytes_; }
 	size_t participantCount() const;
 
 private:
+	struct Participant {
+		uint64_t bitrateBitsPerSecond = 0;
+		uint32_t weight = 1;
+		// Virtual finish time of this participant's latest request.
+		long double finishTag = 0.0L;
+		bool waiting = false;
+		bool priority = false;
+		uint64_t requestSequence = 0;
+		RtpSharedBudgetShare share;
+		uint64_t intervalStartTotalBytes = 0;
+		std::condition_variable cv;
+	};
+
 	void updateTokensLocked(std::chrono::steady_clock::time_point now);
+	// The waiting participant whose turn it is, or 0.
+	uint64_t nextWaiterLocked() const;
+	void notifyNextWaiterLocked();
 
 	const size_t burstBudgetBytes_;
 	mutable std::mutex mutex_;
-	std::condition_variable cv_;
-	std::unordered_map<uint64_t, uint64_t> participantRates_;
-	std::deque<uint64_t> waiters_;
+	std::unordered_map<uint64_t, Participant> participants_;
 	uint64_t aggregateBitrateBitsPerSecond_ = 0;
 	uint64_t nextParticipantId_ = 1;
-	uint64_t nextWaiterId_ = 1;
+	uint64_t nextRequestSequence_ = 1;
+	long double virtualTime_ = 0.0L;
+	uint64_t totalGrantedBytes_ = 0;
 	long double availableTokens_ = 0.0L;
 	std::chrono::steady_clock::time_point lastTokenUpdate_;
 };
@@ -94,6 +142,23 @@ struct RtpPacerStats {
 	uint64_t expiredDuplicates = 0;
 	uint64_t failedDuplicates = 0;
 	uint64_t sentDuplicateBytes = 0;
+	// Media frames only: enqueue to first packet handed to the transport, and
+	// the duration of each individual send callback.
+	LatencyHistogramSnapshot frameHoldUs;
+	LatencyHistogramSnapshot sendCallUs;
+	// This viewer's turn in the shared viewer budget; empty without one.
+	RtpSharedBudgetShare sharedBudget;
+};
+
+// Lifetime send counters, readable without the pacer lock so per-viewer stats
+// never contend with the send loop.
+struct RtpPacerTotals {
+	uint64_t sentPackets = 0;
+	uint64_t sentBytes = 0;
+	uint64_t sentRepairs = 0;
+	uint64_t sentDuplicates = 0;
+	// How long the most recently started frame waited in the queue.
+	uint64_t lastFrameQueueDelayMs = 0;
 };
 
 struct RtpPacerFrameInfo {
@@ -157,8 +222,11 @@ public:
 	// gaps.
 	size_t discardQueuedMediaFramesAfterCurrent(size_t *discardedPackets = nullptr);
 	void updateBitrate(uint64_t bitrateBitsPerSecond, uint64_t duplicateBitrateBitsPerSecond = 0);
+	// Weight in the shared viewer budget; ignored without one.
+	void setSharedBudgetWeight(uint32_t weight);
 	void stop();
 	RtpPacerStats getStats(bool resetInterval = false);
+	RtpPacerTotals totals() const noexcept;
 
 	size_t batchBudgetBytes() const noexcept { return burstBudgetBytes_.load(std::memory_order_acquire); }
 	size_t maxQueueBytes() const noexcept { return maxQueueBytes_; }
@@ -226,6 +294,11 @@ private:
 	uint64_t nextFrameId_ = 1;
 	std::atomic<bool> stopping_{false};
 	RtpPacerStats stats_;
+	std::atomic<uint64_t> totalSentPackets_{0};
+	std::atomic<uint64_t> totalSentBytes_{0};
+	std::atomic<uint64_t> totalSentRepairs_{0};
+	std::atomic<uint64_t> totalSentDuplicates_{0};
+	std::atomic<uint64_t> lastFrameQueueDelayMs_{0};
 	std::thread worker_;
 };
 
@@ -232,4 +232,122 @@ void RtpTimestampStepTracker::reset()
 	interval_ = {};
 }
 
+bool RtpFrameReorderBuffer::push(uint16_t sequence, uint32_t timestamp, bool marker, const uint8_t *payload,
+                                 size_t size, std::vector<RtpReorderedFrame> &completed)
+{
+	if (!payload || size == 0) {
+		return false;
+	}
+	if (haveReleased_) {
+		const auto ahead = static_cast<int16_t>(sequence - releasedSequence_);
+		if (ahead <= 0 && ahead > -static_cast<int16_t>(kMaxLatePackets)) {
+			return false;
+		}
+		if (ahead <= 0) {
+			haveReleased_ = false;
+		} else if (timestamp == releasedTimestamp_ && (!active_ || timestamp != timestamp_)) {
+			// A straggler from the released frame; the sequence it fills is not
+			// lost from the next one.
+			releasedSequence_ = sequence;
+			return false;
+		}
+	}
+
+	if (active_ && timestamp != timestamp_) {
+		complete(&sequence, completed);
+	}
+	if (active_) {
+		for (const auto &packet : packets_) {
+			if (packet.sequence == sequence) {
+				return false;
+			}
+		}
+	} else {
+		active_ = true;
+		timestamp_ = timestamp;
+	}
+
+	packets_.push_back({sequence, bytes_.size(), size});
+	bytes_.insert(bytes_.end(), payload, payload + size);
+	if (marker) {
+		haveMarker_ = true;
+		markerSequence_ = sequence;
+	}
+	if (haveMarker_ && wholeThroughMarker()) {
+		complete(nullptr, completed);
+	}
+	return true;
+}
+
+bool RtpFrameReorderBuffer::wholeThroughMarker() const
+{
+	// Packets are unique, so the frame is whole when as many arrived as the
+	// marker's span covers and none lie outside it.
+	uint16_t span = 0;
+	if (haveReleased_) {
+		span = static_cast<uint16_t>(markerSequence_ - releasedSequence_);
+	} else {
+		for (const auto &packet : packets_) {
+			span = std::max<uint16_t>(span, static_cast<uint16_t>(markerSequence_ - packet.sequence + 1U));
+		}
+	}
+	if (packets_.size() != span) {
+		return false;
+	}
+	return std::all_of(packets_.begin(), packets_.end(), [&](const RtpFramePacket &packet) {
+		return static_cast<uint16_t>(markerSequence_ - packet.sequence) < span;
+	});
+}
+
+void RtpFrameReorderBuffer::complete(const uint16_t *nextSequence, std::vector<RtpReorderedFrame> &completed)
+{
+	const uint16_t base = packets_.front().sequence;
+	std::sort(packets_.begin(), packets_.end(), [base](const RtpFramePacket &lhs, const RtpFramePacket &rhs) {
+		return static_cast<int16_t>(lhs.sequence - base) < static_cast<int16_t>(rhs.sequence - base);
+	});
+
+	RtpReorderedFrame frame;
+	frame.timestamp = timestamp_;
+	frame.intact = true;
+	uint16_t expected = packets_.front().sequence;
+	for (const auto &packet : packets_) {
+		frame.intact = frame.intact && packet.sequence == expected;
+		expected = static_cast<uint16_t>(packet.sequence + 1U);
+	}
+	const uint16_t last = packets_.back().sequence;
+	const bool tailArrived = haveMarker_ ? markerSequence_ == last
+	                                     : nextSequence && *nextSequence == static_cast<uint16_t>(last + 1U);
+	frame.intact = frame.intact && tailArrived;
+	const bool gapBefore =
+	    haveReleased_ && packets_.front().sequence != static_cast<uint16_t>(releasedSequence_ + 1U);
+	// After a frame that lost its tail, the gap was charged to that frame.
+	frame.followsLoss = gapBefore && releasedMarker_;
+	frame.bytes = std::move(bytes_);
+	frame.packets = packets_;
+	completed.push_back(std::move(frame));
+
+	haveReleased_ = true;
+	releasedTimestamp_ = timestamp_;
+	releasedSequence_ = last;
+	releasedMarker_ = haveMarker_;
+	active_ = false;
+	haveMarker_ = false;
+	bytes_.clear();
+	packets_.clear();
+}
+
+void RtpFrameReorderBuffer::reset()
+{
+	active_ = false;
+	timestamp_ = 0;
+	haveMarker_ = false;
+	markerSequence_ = 0;
+	bytes_.clear();
+	packets_.clear();
+	haveReleased_ = false;
+	releasedTimestamp_ = 0;
+	releasedSequence_ = 0;
+	releasedMarker_ = false;
+}
+
 } // namespace vdoninja
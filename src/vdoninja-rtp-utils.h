@@ -72,4 +72,63 @@ private:
 	RtpTimestampStepStats interval_;
 };
 
+struct RtpFramePacket {
+	uint16_t sequence = 0;
+	// Payload bytes within RtpReorderedFrame::bytes.
+	size_t offset = 0;
+	size_t size = 0;
+};
+
+struct RtpReorderedFrame {
+	uint32_t timestamp = 0;
+	// No packet is missing between the first one received and the marker, or
+	// the next frame's first packet when the marker never arrived.
+	bool intact = false;
+	// Sequence numbers were skipped between the previous frame's marker and
+	// this frame: whole frames, or this one's head, were lost.
+	bool followsLoss = false;
+	std::vector<uint8_t> bytes;
+	// In sequence order.
+	std::vector<RtpFramePacket> packets;
+};
+
+// Collects the RTP payloads of one video frame and releases them in sequence
+// order, so packets reordered within a frame are not mistaken for loss. A
+// frame completes on its marker once every packet up to it has arrived, or
+// else when the next frame's first packet arrives, with what it has by then.
+// Late and duplicate packets of frames already released are discarded. Not
+// synchronized.
+class RtpFrameReorderBuffer
+{
+public:
+	// A packet further behind the last released one than this is a sequence
+	// restart rather than a late arrival.
+	static constexpr uint16_t kMaxLatePackets = 512;
+
+	// Appends the frames this packet completed to completed. Returns false
+	// when the packet was discarded.
+	bool push(uint16_t sequence, uint32_t timestamp, bool marker, const uint8_t *payload, size_t size,
+	          std::vector<RtpReorderedFrame> &completed);
+	void reset();
+
+	bool active() const noexcept { return active_; }
+	uint32_t timestamp() const noexcept { return timestamp_; }
+
+private:
+	bool wholeThroughMarker() const;
+	void complete(const uint16_t *nextSequence, std::vector<RtpReorderedFrame> &completed);
+
+	bool active_ = false;
+	uint32_t timestamp_ = 0;
+	bool haveMarker_ = false;
+	uint16_t markerSequence_ = 0;
+	std::vector<uint8_t> bytes_;
+	std::vector<RtpFramePacket> packets_;
+	// The last frame released.
+	bool haveReleased_ = false;
+	uint32_t releasedTimestamp_ = 0;
+	uint16_t releasedSequence_ = 0;
+	bool releasedMarker_ = false;
+};
+
 } // namespace vdoninja
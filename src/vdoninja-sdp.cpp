@@ -0,0 +1,408 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Parsed session description model for offer and answer munging
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-sdp.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+bool startsWith(std::string_view value, std::string_view prefix)
+{
+	return value.size() >= prefix.size() && value.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool isSpace(char c)
+{
+	return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+std::string_view trimmed(std::string_view value)
+{
+	const size_t start = value.find_first_not_of(" \t\r\n");
+	if (start == std::string_view::npos) {
+		return {};
+	}
+	const size_t end = value.find_last_not_of(" \t\r\n");
+	return value.substr(start, end - start + 1);
+}
+
+std::string lowerCopy(std::string_view value)
+{
+	std::string lower(value);
+	for (char &c : lower) {
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+	return lower;
+}
+
+// std::stoi semantics without the allocation or the exception: leading
+// whitespace and a sign, then digits up to the first non-digit.
+int parseIntOrDefault(std::string_view value, int defaultValue = -1)
+{
+	size_t pos = 0;
+	while (pos < value.size() && isSpace(value[pos])) {
+		++pos;
+	}
+	bool negative = false;
+	if (pos < value.size() && (value[pos] == '+' || value[pos] == '-')) {
+		negative = value[pos] == '-';
+		++pos;
+	}
+	const size_t digitsStart = pos;
+	int64_t result = 0;
+	while (pos < value.size() && std::isdigit(static_cast<unsigned char>(value[pos]))) {
+		result = result * 10 + (value[pos] - '0');
+		if (result > static_cast<int64_t>(std::numeric_limits<int>::max()) + 1) {
+			return defaultValue;
+		}
+		++pos;
+	}
+	if (pos == digitsStart) {
+		return defaultValue;
+	}
+	result = negative ? -result : result;
+	if (result > std::numeric_limits<int>::max() || result < std::numeric_limits<int>::min()) {
+		return defaultValue;
+	}
+	return static_cast<int>(result);
+}
+
+// Next whitespace-separated token of rest, which is advanced past it.
+std::string_view nextToken(std::string_view &rest)
+{
+	size_t start = 0;
+	while (start < rest.size() && isSpace(rest[start])) {
+		++start;
+	}
+	size_t end = start;
+	while (end < rest.size() && !isSpace(rest[end])) {
+		++end;
+	}
+	const std::string_view token = rest.substr(start, end - start);
+	rest.remove_prefix(end);
+	return token;
+}
+
+bool containsPayloadType(const std::vector<int> &payloadTypes, int payloadType)
+{
+	return std::find(payloadTypes.begin(), payloadTypes.end(), payloadType) != payloadTypes.end();
+}
+
+SdpOfferedCodec &codecForPayloadType(std::vector<SdpOfferedCodec> &codecs, int payloadType)
+{
+	for (auto &codec : codecs) {
+		if (codec.payloadType == payloadType) {
+			return codec;
+		}
+	}
+	codecs.push_back({});
+	codecs.back().payloadType = payloadType;
+	return codecs.back();
+}
+
+// "a=rtpmap:<pt> name/clock/channels" and "a=fmtp:<pt> params": the payload
+// type when it is one the section offered, else -1.
+int attributePayloadType(std::string_view line, size_t prefixLength, const SdpOfferedMediaSection &section,
+                         std::string_view &value)
+{
+	const size_t separator = line.find(' ');
+	if (separator == std::string_view::npos) {
+		return -1;
+	}
+	const int payloadType = parseIntOrDefault(line.substr(prefixLength, separator - prefixLength));
+	if (payloadType < 0 || !containsPayloadType(section.payloadTypes, payloadType)) {
+		return -1;
+	}
+	value = line.substr(separator + 1);
+	return payloadType;
+}
+
+void applyRtpmap(std::string_view descriptor, SdpOfferedCodec &codec)
+{
+	// Splits on '/' the way std::getline does: a trailing empty field is
+	// dropped unless it is the only one.
+	std::string_view parts[3];
+	size_t partCount = 0;
+	size_t start = 0;
+	for (;;) {
+		const size_t slash = descriptor.find('/', start);
+		const std::string_view part =
+		    descriptor.substr(start, slash == std::string_view::npos ? std::string_view::npos : slash - start);
+		if (slash == std::string_view::npos) {
+			if (!part.empty() || partCount == 0) {
+				if (partCount < 3) {
+					parts[partCount] = part;
+				}
+				++partCount;
+			}
+			break;
+		}
+		if (partCount < 3) {
+			parts[partCount] = part;
+		}
+		++partCount;
+		start = slash + 1;
+	}
+
+	codec.codec = std::string(parts[0]);
+	if (partCount > 1) {
+		codec.clockRate = parseIntOrDefault(parts[1], 0);
+	}
+	if (partCount > 2) {
+		codec.channels = parseIntOrDefault(parts[2], 0);
+	}
+}
+
+void applyFmtp(std::string_view parameters, SdpOfferedCodec &codec)
+{
+	codec.formatParameters = std::string(trimmed(parameters));
+	const size_t aptPos = lowerCopy(codec.formatParameters).find("apt=");
+	if (aptPos == std::string::npos) {
+		return;
+	}
+	const size_t valueStart = aptPos + 4;
+	size_t valueEnd = valueStart;
+	while (valueEnd < codec.formatParameters.size() &&
+	       std::isdigit(static_cast<unsigned char>(codec.formatParameters[valueEnd]))) {
+		++valueEnd;
+	}
+	codec.associatedPayloadType =
+	    parseIntOrDefault(std::string_view(codec.formatParameters).substr(valueStart, valueEnd - valueStart));
+}
+
+std::string unescapeLineEndings(const std::string &sdp)
+{
+	std::string normalized;
+	normalized.reserve(sdp.size());
+	for (size_t i = 0; i < sdp.size(); ++i) {
+		if (sdp[i] != '\\' || i + 1 >= sdp.size()) {
+			normalized.push_back(sdp[i]);
+			continue;
+		}
+
+		switch (sdp[i + 1]) {
+		case 'r':
+			normalized.push_back('\r');
+			++i;
+			break;
+		case 'n':
+			normalized.push_back('\n');
+			++i;
+			break;
+		case '\\':
+			normalized.push_back('\\');
+			++i;
+			break;
+		default:
+			normalized.push_back(sdp[i]);
+			break;
+		}
+	}
+	return normalized;
+}
+
+} // namespace
+
+SdpDocument::SdpDocument(std::string sdp) : text_(std::move(sdp))
+{
+	hasLineBreaks_ = text_.find_first_of("\r\n") != std::string::npos;
+	if (!hasLineBreaks_ && (text_.find("\\n") != std::string::npos || text_.find("\\r") != std::string::npos)) {
+		receivedEscapedLineEndings_ = true;
+		text_ = unescapeLineEndings(text_);
+		hasLineBreaks_ = text_.find_first_of("\r\n") != std::string::npos;
+	}
+
+	size_t offset = 0;
+	while (offset < text_.size()) {
+		const size_t newline = text_.find('\n', offset);
+		const size_t end = newline == std::string::npos ? text_.size() : newline;
+		Line line;
+		line.offset = offset;
+		line.length = end - offset;
+		line.terminatorLength = newline == std::string::npos ? 0 : 1;
+		if (line.length > 0 && text_[end - 1] == '\r') {
+			--line.length;
+			++line.terminatorLength;
+		}
+		lines_.push_back(line);
+		offset = newline == std::string::npos ? text_.size() : newline + 1;
+	}
+}
+
+std::string_view SdpDocument::lineText(size_t index) const
+{
+	const Line &line = lines_[index];
+	if (line.inserted) {
+		return inserted_[line.offset];
+	}
+	return std::string_view(text_).substr(line.offset, line.length);
+}
+
+size_t SdpDocument::findMediaLine(std::string_view mediaType) const
+{
+	for (size_t index = 0; index < lines_.size(); ++index) {
+		if (lines_[index].removed) {
+			continue;
+		}
+		const std::string_view text = lineText(index);
+		if (startsWith(text, "m=") && startsWith(text.substr(2), mediaType) &&
+		    (text.size() == mediaType.size() + 2 || isSpace(text[mediaType.size() + 2]))) {
+			return index;
+		}
+	}
+	return lines_.size();
+}
+
+bool SdpDocument::insertAfterMediaLine(std::string_view mediaType, std::string line)
+{
+	const size_t mediaLine = findMediaLine(mediaType);
+	if (mediaLine == lines_.size()) {
+		return false;
+	}
+	Line added;
+	added.offset = inserted_.size();
+	added.length = line.size();
+	added.inserted = true;
+	inserted_.push_back(std::move(line));
+	lines_.insert(lines_.begin() + static_cast<std::ptrdiff_t>(mediaLine + 1), added);
+	edited_ = true;
+	return true;
+}
+
+std::string SdpDocument::mid(std::string_view mediaType) const
+{
+	for (size_t index = findMediaLine(mediaType) + 1; index < lines_.size(); ++index) {
+		if (lines_[index].removed) {
+			continue;
+		}
+		const std::string_view text = lineText(index);
+		if (startsWith(text, "m=")) {
+			break;
+		}
+		if (startsWith(text, "a=mid:")) {
+			return std::string(text.substr(6));
+		}
+	}
+	return {};
+}
+
+std::vector<SdpOfferedMediaSection> SdpDocument::offeredMediaSections() const
+{
+	std::vector<SdpOfferedMediaSection> sections;
+	SdpOfferedMediaSection *current = nullptr;
+
+	for (size_t index = 0; index < lines_.size(); ++index) {
+		if (lines_[index].removed) {
+			continue;
+		}
+		const std::string_view line = lineText(index);
+
+		if (startsWith(line, "m=")) {
+			current = nullptr;
+			std::string_view rest = line.substr(2);
+			const std::string mediaType = lowerCopy(nextToken(rest));
+			if (mediaType != "audio" && mediaType != "video") {
+				continue;
+			}
+
+			sections.push_back({});
+			current = &sections.back();
+			current->type = mediaType;
+			const std::string_view port = nextToken(rest);
+			if (!port.empty()) {
+				current->port = parseIntOrDefault(port, -1);
+			}
+			nextToken(rest); // protocol
+			for (std::string_view token = nextToken(rest); !token.empty(); token = nextToken(rest)) {
+				const int payloadType = parseIntOrDefault(token);
+				if (payloadType >= 0) {
+					current->payloadTypes.push_back(payloadType);
+				}
+			}
+			continue;
+		}
+
+		if (!current) {
+			continue;
+		}
+
+		if (startsWith(line, "a=mid:")) {
+			current->mid = std::string(trimmed(line.substr(6)));
+			continue;
+		}
+
+		if (line == "a=sendrecv" || line == "a=sendonly" || line == "a=recvonly" || line == "a=inactive") {
+			current->direction = std::string(line.substr(2));
+			continue;
+		}
+
+		std::string_view value;
+		if (startsWith(line, "a=rtpmap:")) {
+			const int payloadType = attributePayloadType(line, 9, *current, value);
+			if (payloadType >= 0) {
+				applyRtpmap(value, codecForPayloadType(current->codecs, payloadType));
+			}
+			continue;
+		}
+
+		if (startsWith(line, "a=fmtp:")) {
+			const int payloadType = attributePayloadType(line, 7, *current, value);
+			if (payloadType >= 0) {
+				applyFmtp(value, codecForPayloadType(current->codecs, payloadType));
+			}
+		}
+	}
+
+	return sections;
+}
+
+std::string SdpDocument::serialize() const
+{
+	if (!edited_) {
+		return text_;
+	}
+
+	std::string sdp;
+	sdp.reserve(text_.size() + 64);
+	bool terminated = true;
+	for (size_t index = 0; index < lines_.size(); ++index) {
+		const Line &line = lines_[index];
+		if (line.removed) {
+			continue;
+		}
+		if (!terminated) {
+			sdp += "\r\n";
+		}
+		if (line.inserted) {
+			sdp += inserted_[line.offset];
+			sdp += "\r\n";
+			terminated = true;
+		} else {
+			sdp.append(text_, line.offset, line.length + line.terminatorLength);
+			terminated = line.terminatorLength > 0;
+		}
+	}
+	return sdp;
+}
+
+bool stripUnsupportedTransportCcFeedback(SdpDocument &sdp)
+{
+	return sdp.removeLinesIf([](std::string_view line) {
+		       return line.find("transport-wide-cc-extensions-01") != std::string_view::npos ||
+		              (startsWith(line, "a=rtcp-fb:") && line.find("transport-cc") != std::string_view::npos);
+	       }) > 0;
+}
+
+} // namespace vdoninja
@@ -0,0 +1,102 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Parsed session description model for offer and answer munging
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vdoninja
+{
+
+struct SdpOfferedCodec {
+	int payloadType = -1;
+	std::string codec;
+	int clockRate = 0;
+	int channels = 0;
+	std::string formatParameters;
+	int associatedPayloadType = -1;
+};
+
+struct SdpOfferedMediaSection {
+	std::string type;
+	std::string mid;
+	int port = -1;
+	std::string direction = "sendrecv";
+	std::vector<int> payloadTypes;
+	std::vector<SdpOfferedCodec> codecs;
+};
+
+// One session description split into lines once. Munging rules edit the
+// model in place and serialize() writes it back out in a single pass, so a
+// join costs one scan of the SDP however many rules apply. Lines keep their
+// own terminators; an unedited document serializes to its input.
+class SdpDocument
+{
+public:
+	// A description that arrived double-escaped ("\r\n" as four characters and
+	// no real line breaks) is decoded first.
+	explicit SdpDocument(std::string sdp);
+
+	size_t size() const noexcept { return text_.size(); }
+	bool hasLineBreaks() const noexcept { return hasLineBreaks_; }
+	bool receivedEscapedLineEndings() const noexcept { return receivedEscapedLineEndings_; }
+	bool edited() const noexcept { return edited_; }
+
+	// Drops every line the predicate accepts; returns how many it dropped.
+	template <typename Predicate> size_t removeLinesIf(Predicate predicate)
+	{
+		size_t removed = 0;
+		for (size_t index = 0; index < lines_.size(); ++index) {
+			if (!lines_[index].removed && predicate(lineText(index))) {
+				lines_[index].removed = true;
+				++removed;
+			}
+		}
+		edited_ = edited_ || removed > 0;
+		return removed;
+	}
+	// Adds a line right after the first m= line of that media type. False when
+	// there is no such section.
+	bool insertAfterMediaLine(std::string_view mediaType, std::string line);
+
+	// a=mid of the first section of that media type, or empty.
+	std::string mid(std::string_view mediaType) const;
+	// Audio and video sections with their payload types, rtpmap, fmtp,
+	// direction and mid.
+	std::vector<SdpOfferedMediaSection> offeredMediaSections() const;
+
+	std::string serialize() const;
+
+private:
+	struct Line {
+		// Into text_, or into inserted_ for added lines.
+		size_t offset = 0;
+		size_t length = 0;
+		// Bytes of "\n" or "\r\n" after the line in text_.
+		size_t terminatorLength = 0;
+		bool inserted = false;
+		bool removed = false;
+	};
+
+	std::string_view lineText(size_t index) const;
+	size_t findMediaLine(std::string_view mediaType) const;
+
+	std::string text_;
+	std::vector<Line> lines_;
+	std::vector<std::string> inserted_;
+	bool hasLineBreaks_ = false;
+	bool receivedEscapedLineEndings_ = false;
+	bool edited_ = false;
+};
+
+// Transport-wide congestion control feedback and its header extension, which
+// the native receiver does not implement. True when anything was removed.
+bool stripUnsupportedTransportCcFeedback(SdpDocument &sdp);
+
+} // namespace vdoninja
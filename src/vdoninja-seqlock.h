@@ -0,0 +1,89 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Sequence-locked value for lock-free reads of small published snapshots
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace vdoninja
+{
+
+// Holds a small trivially copyable value that worker threads publish and the
+// UI thread reads without taking a lock. Writers bump the sequence to odd,
+// store the payload and bump it back to even; a reader retries when the
+// sequence was odd or moved while it copied. The payload lives in atomic
+// words, so a torn copy is discarded rather than being a data race.
+// Concurrent writers serialize on the sequence itself.
+template<typename T> class SeqlockValue
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SeqlockValue needs a trivially copyable payload");
+
+public:
+	SeqlockValue() noexcept { store(T{}); }
+
+	void publish(const T &value) noexcept
+	{
+		uint64_t seq = sequence_.load(std::memory_order_relaxed);
+		for (;;) {
+			if ((seq & 1) == 0 &&
+			    sequence_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+				break;
+			}
+			std::this_thread::yield();
+			seq = sequence_.load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		store(value);
+		sequence_.store(seq + 2, std::memory_order_release);
+	}
+
+	T load() const noexcept
+	{
+		for (;;) {
+			const uint64_t before = sequence_.load(std::memory_order_acquire);
+			if ((before & 1) != 0) {
+				std::this_thread::yield();
+				continue;
+			}
+			std::array<uint64_t, kWords> words;
+			for (size_t i = 0; i < kWords; ++i) {
+				words[i] = words_[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence_.load(std::memory_order_relaxed) == before) {
+				T value;
+				std::memcpy(&value, words.data(), sizeof(T));
+				return value;
+			}
+		}
+	}
+
+	// Completed publishes so far; lets readers skip work when nothing changed.
+	uint64_t version() const noexcept { return sequence_.load(std::memory_order_acquire) / 2; }
+
+private:
+	static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	void store(const T &value) noexcept
+	{
+		std::array<uint64_t, kWords> words{};
+		std::memcpy(words.data(), &value, sizeof(T));
+		for (size_t i = 0; i < kWords; ++i) {
+			words_[i].store(words[i], std::memory_order_relaxed);
+		}
+	}
+
+	std::atomic<uint64_t> sequence_{0};
+	std::array<std::atomic<uint64_t>, kWords> words_{};
+};
+
+} // namespace vdoninja
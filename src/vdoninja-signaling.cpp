@@ -49,6 +49,9 @@
 // clang-format on
 #endif
 
+#include "vdoninja-room-signaling.h"
+#include "vdoninja-thread-cpu.h"
+
 namespace vdoninja
 {
 
@@ -555,6 +558,11 @@ bool VDONinjaSignaling::connect(const std::string &wssHost)
 		logWarning("Already connected to signaling server");
 		return true;
 	}
+	if (auto room = roomConnection()) {
+		// The room connection owns the WebSocket, host failover and reconnect;
+		// this client only keeps its stream state and callbacks.
+		return room->attach(*this);
+	}
 	if (wsThread_.joinable() && !shouldRun_) {
 		if (hasSocketUserCallbacks()) {
 			logError("Cannot reconnect signaling while a socket callback is active");
@@ -602,6 +610,22 @@ bool VDONinjaSignaling::connect(const std::string &wssHost)
 
 void VDONinjaSignaling::disconnect()
 {
+	if (auto room = roomConnection()) {
+		room->detach(*this);
+		const bool wasConnected = connected_.exchange(false);
+		{
+			std::lock_guard<std::mutex> lock(stateMutex_);
+			currentRoom_ = RoomInfo{};
+			publishedStream_ = StreamInfo{};
+			viewingStreams_.clear();
+		}
+		logInfo("Detached from shared room signaling");
+		if (wasConnected) {
+			notifyDisconnected();
+		}
+		return;
+	}
+
 	shouldRun_ = false;
 	// Invalidate the active socket before close(). libdatachannel may invoke its
 	// callbacks synchronously from close; those callbacks belong to the retired
@@ -935,6 +959,14 @@ void VDONinjaSignaling::handleSocketMessage(uint64_t socketEpoch, const std::str
 		return;
 	}
 	epochLease.unlock();
+	OnRawMessageCallback rawCb;
+	{
+		std::lock_guard<std::mutex> lock(callbackMutex_);
+		rawCb = onRawMessage_;
+	}
+	if (rawCb) {
+		invokeUserCallback(socketEpoch, [&]() { rawCb(message); });
+	}
 	processMessage(message, socketEpoch, wsSequence);
 }
 
@@ -1014,6 +1046,7 @@ void VDONinjaSignaling::runBeforeSocketStateCommitForTesting()
 
 void VDONinjaSignaling::wsThreadFunc(uint64_t initialSocketEpoch)
 {
+	setCurrentThreadName("vdo-signaling");
 	auto reconnectAttempts = std::make_shared<std::atomic<int>>(0);
 	uint64_t latestSocketEpoch = 0;
 
@@ -1609,6 +1642,46 @@ void VDONinjaSignaling::processIncomingMessage(const std::string &message)
 	processMessage(message);
 }
 
+void VDONinjaSignaling::useRoomConnection(std::shared_ptr<VDONinjaRoomSignaling> room)
+{
+	std::lock_guard<std::mutex> lock(stateMutex_);
+	roomConnection_ = std::move(room);
+}
+
+std::shared_ptr<VDONinjaRoomSignaling> VDONinjaSignaling::roomConnection() const
+{
+	std::lock_guard<std::mutex> lock(stateMutex_);
+	return roomConnection_;
+}
+
+void VDONinjaSignaling::handleRoomConnectionOpened()
+{
+	if (connected_.exchange(true)) {
+		return;
+	}
+	disconnectNotified_ = false;
+	OnConnectedCallback cb;
+	{
+		std::lock_guard<std::mutex> lock(callbackMutex_);
+		cb = onConnected_;
+	}
+	if (cb) {
+		invokeUserCallback(0, [&]() { cb(); });
+	}
+}
+
+void VDONinjaSignaling::handleRoomConnectionClosed()
+{
+	if (connected_.exchange(false)) {
+		notifyDisconnected();
+	}
+}
+
+void VDONinjaSignaling::forwardMessage(const std::string &message)
+{
+	sendMessage(message);
+}
+
 void VDONinjaSignaling::applyServerAlertPolicy(const std::string &alert)
 {
 	const SignalingAlertPolicy policy = classifySignalingAlert(alert);
@@ -1665,6 +1738,10 @@ void VDONinjaSignaling::sendMessage(const std::string &message)
 		logWarning("Cannot send message - not connected");
 		return;
 	}
+	if (auto room = roomConnection()) {
+		room->send(*this, message);
+		return;
+	}
 
 	std::lock_guard<std::mutex> lock(sendMutex_);
 	sendQueue_.push(message);
@@ -2233,6 +2310,11 @@ void VDONinjaSignaling::setOnData(OnDataCallback callback)
 	std::lock_guard<std::mutex> lock(callbackMutex_);
 	onData_ = callback;
 }
+void VDONinjaSignaling::setOnRawMessage(OnRawMessageCallback callback)
+{
+	std::lock_guard<std::mutex> lock(callbackMutex_);
+	onRawMessage_ = callback;
+}
 
 void VDONinjaSignaling::setSalt(const std::string &salt)
 {
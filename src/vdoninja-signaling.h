@@ -30,6 +30,8 @@ class WebSocket;
 namespace vdoninja
 {
 
+class VDONinjaRoomSignaling;
+
 // Message types from VDO.Ninja signaling server
 enum class SignalMessageType {
 	Unknown,
@@ -110,6 +112,16 @@ public:
 	// Reuse signaling parsing for messages received over alternate transports
 	void processIncomingMessage(const std::string &message);
 
+	// Carry this client over a room connection shared with other receivers
+	// instead of opening its own WebSocket. Set before connect(); nullptr
+	// restores a private connection.
+	void useRoomConnection(std::shared_ptr<VDONinjaRoomSignaling> room);
+	// Called by the shared room connection as its WebSocket comes and goes.
+	void handleRoomConnectionOpened();
+	void handleRoomConnectionClosed();
+	// Sends an already-built message on this client's own WebSocket.
+	void forwardMessage(const std::string &message);
+
 	// Event callbacks may call disconnect(). A reconnect requested before the
 	// callback returns is rejected and must be retried by the owner afterward.
 	// Destroying this signaling instance from inside its own callback is not a
@@ -131,6 +143,10 @@ public:
 	// callbacks for the same consumer or cleanup would be applied twice.
 	void setOnLifecycleEvent(OnSignalingLifecycleEventCallback callback);
 	void setOnData(OnDataCallback callback);
+	// Observes every message received on this client's own WebSocket before
+	// it is parsed; messages injected through processIncomingMessage() are not
+	// reported.
+	void setOnRawMessage(OnRawMessageCallback callback);
 
 	// Configuration
 	void setSalt(const std::string &salt);
@@ -239,6 +255,7 @@ private:
 	// Message handlers
 	void handleRequest(const ParsedSignalMessage &message, uint64_t socketEpoch);
 	std::string getActiveSignalingPassword() const;
+	std::shared_ptr<VDONinjaRoomSignaling> roomConnection() const;
 
 	// Internal state
 	std::string wssHost_;
@@ -253,6 +270,7 @@ private:
 	RoomInfo currentRoom_;
 	StreamInfo publishedStream_;
 	std::map<std::string, StreamInfo> viewingStreams_;
+	std::shared_ptr<VDONinjaRoomSignaling> roomConnection_;
 
 	// Connection state
 	std::atomic<bool> connected_{false};
@@ -322,6 +340,7 @@ private:
 	OnPeerCleanupCallback onPeerCleanup_;
 	OnSignalingLifecycleEventCallback onLifecycleEvent_;
 	OnDataCallback onData_;
+	OnRawMessageCallback onRawMessage_;
 };
 
 } // namespace vdoninja
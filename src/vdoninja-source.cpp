@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
 #include <cstring>
 #include <limits>
 #include <set>
@@ -26,10 +27,14 @@ extern "C" {
 #include <libavutil/pixdesc.h>
 #include <libavutil/samplefmt.h>
 #include <libswresample/swresample.h>
-#include <libswscale/swscale.h>
 }
 
+#if defined(VDONINJA_HAVE_LIBOPUS)
+#include <opus.h>
+#endif
+
 #include "plugin-main.h"
+#include "vdoninja-room-signaling.h"
 #include "vdoninja-rtp-utils.h"
 #include "vdoninja-utils.h"
 
@@ -50,6 +55,9 @@ constexpr uint32_t kDefaultSourceWidth = 1920;
 constexpr uint32_t kMinSourceHeight = 240;
 constexpr uint32_t kMaxSourceHeight = 2160;
 constexpr uint32_t kDefaultSourceHeight = 1080;
+constexpr int kMaxDecodeLatencyMs = 10000;
+// Half an Opus frame, so clock-driven playout adds at most 10 ms of delay.
+constexpr auto kAudioPlayoutTick = std::chrono::milliseconds(10);
 
 std::string buildNativeViewerInfoJson(obs_source_t *source)
 {
@@ -128,6 +136,11 @@ obs_data_t *createNativeReceiverSourceSettings(const SourceSettings &sourceSetti
 	obs_data_set_bool(settings, "enable_data_channel", sourceSettings.enableDataChannel);
 	obs_data_set_bool(settings, "auto_reconnect", sourceSettings.autoReconnect);
 	obs_data_set_bool(settings, "force_turn", sourceSettings.forceTurn);
+	obs_data_set_int(settings, "max_decode_latency_ms", sourceSettings.maxDecodeLatencyMs);
+	obs_data_set_string(settings, "scale_quality", sourceSettings.scaleQuality.c_str());
+	obs_data_set_string(settings, "relay_stream_id", sourceSettings.relayStreamId.c_str());
+	obs_data_set_int(settings, "relay_max_viewers", sourceSettings.relayMaxViewers);
+	obs_data_set_bool(settings, "shared_room_signaling", sourceSettings.sharedRoomSignaling);
 	obs_data_set_int(settings, "width", width);
 	obs_data_set_int(settings, "height", height);
 	return settings;
@@ -187,7 +200,9 @@ bool sourceSettingsEqualForChild(const SourceSettings &left, const SourceSetting
 	       left.wssHost == right.wssHost && left.salt == right.salt &&
 	       left.customIceServersText == right.customIceServersText &&
 	       left.useNativeReceiver == right.useNativeReceiver && left.enableDataChannel == right.enableDataChannel &&
-	       left.autoReconnect == right.autoReconnect && left.forceTurn == right.forceTurn;
+	       left.autoReconnect == right.autoReconnect && left.forceTurn == right.forceTurn &&
+	       left.relayStreamId == right.relayStreamId && left.relayMaxViewers == right.relayMaxViewers &&
+	       left.sharedRoomSignaling == right.sharedRoomSignaling;
 }
 
 std::string toLowerCopy(std::string value)
@@ -286,6 +301,33 @@ bool configureVideoHardwareDecoder(AVCodecContext *decoderContext, const AVCodec
 	return false;
 }
 
+int64_t steadyTimeUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+int64_t wallClockTimeUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+	    .count();
+}
+
+std::string formatReceiveLatency(const char *label, const LatencyHistogramSnapshot &histogram)
+{
+	char line[160];
+	if (histogram.count == 0) {
+		std::snprintf(line, sizeof(line), "%s: -\n", label);
+	} else {
+		std::snprintf(line, sizeof(line), "%s: %.1f / %.1f / %.1f ms (max %.1f)\n", label,
+		              static_cast<double>(histogram.percentileUs(0.50)) / 1000.0,
+		              static_cast<double>(histogram.percentileUs(0.95)) / 1000.0,
+		              static_cast<double>(histogram.percentileUs(0.99)) / 1000.0,
+		              static_cast<double>(histogram.maxUs) / 1000.0);
+	}
+	return line;
+}
+
 struct RtpPayloadView {
 	size_t offset = 0;
 	size_t size = 0;
@@ -483,6 +525,38 @@ speaker_layout speakerLayoutForChannels(int channels)
 	return channels <= 1 ? SPEAKERS_MONO : SPEAKERS_STEREO;
 }
 
+DecodedAudioFormat decodedAudioFormatFor(int sampleFormat)
+{
+	switch (sampleFormat) {
+	case AV_SAMPLE_FMT_FLT:
+		return DecodedAudioFormat::Float;
+	case AV_SAMPLE_FMT_FLTP:
+		return DecodedAudioFormat::FloatPlanar;
+	case AV_SAMPLE_FMT_S16:
+		return DecodedAudioFormat::Int16;
+	case AV_SAMPLE_FMT_S16P:
+		return DecodedAudioFormat::Int16Planar;
+	default:
+		return DecodedAudioFormat::Other;
+	}
+}
+
+audio_format obsAudioFormatFor(DecodedAudioFormat format)
+{
+	switch (format) {
+	case DecodedAudioFormat::Float:
+		return AUDIO_FORMAT_FLOAT;
+	case DecodedAudioFormat::Int16:
+		return AUDIO_FORMAT_16BIT;
+	case DecodedAudioFormat::Int16Planar:
+		return AUDIO_FORMAT_16BIT_PLANAR;
+	case DecodedAudioFormat::FloatPlanar:
+	case DecodedAudioFormat::Other:
+		break;
+	}
+	return AUDIO_FORMAT_FLOAT_PLANAR;
+}
+
 void clearTrackCallbacks(const std::shared_ptr<rtc::Track> &track)
 {
 	if (!track) {
@@ -502,7 +576,9 @@ void clearTrackCallbacks(const std::shared_ptr<rtc::Track> &track)
 void setNativeOnlyPropertiesVisible(obs_properties_t *props, bool visible)
 {
 	const char *propertyNames[] = {"enable_data_channel", "auto_reconnect", "custom_ice_servers",
-	                               "custom_ice_servers_help", "force_turn"};
+	                               "custom_ice_servers_help", "force_turn", "max_decode_latency_ms",
+	                               "scale_quality", "relay_stream_id", "relay_max_viewers",
+	                               "native_receive_stats", "native_receive_stats_refresh"};
 	for (const char *propertyName : propertyNames) {
 		obs_property_t *property = obs_properties_get(props, propertyName);
 		if (property) {
@@ -730,8 +806,21 @@ static void vdoninja_source_enum_active_sources(void *data, obs_source_enum_proc
 	});
 }
 
-static obs_properties_t *vdoninja_source_properties(void *)
+static bool vdoninja_source_refresh_receive_stats(obs_properties_t *props, obs_property_t *property, void *data)
+{
+	UNUSED_PARAMETER(property);
+	auto *source = static_cast<VDONinjaSource *>(data);
+	obs_property_t *stats = obs_properties_get(props, "native_receive_stats");
+	if (!source || !stats) {
+		return false;
+	}
+	obs_property_set_description(stats, source->receivePipelineSummary().c_str());
+	return true;
+}
+
+static obs_properties_t *vdoninja_source_properties(void *data)
 {
+	auto *source = static_cast<VDONinjaSource *>(data);
 	obs_properties_t *props = obs_properties_create();
 
 	obs_property_t *note = obs_properties_add_text(
@@ -790,6 +879,43 @@ static obs_properties_t *vdoninja_source_properties(void *)
 	obs_property_text_set_info_type(iceHelp, OBS_TEXT_INFO_NORMAL);
 	obs_property_text_set_info_word_wrap(iceHelp, true);
 	obs_properties_add_bool(advanced, "force_turn", tr("ForceTURN", "Force TURN Relay"));
+	obs_property_t *decodeLatency = obs_properties_add_int(
+	    advanced, "max_decode_latency_ms", tr("VDONinjaSource.MaxDecodeLatency", "Max Decode Latency (ms)"), 0,
+	    kMaxDecodeLatencyMs, 50);
+	obs_property_set_long_description(
+	    decodeLatency, tr("VDONinjaSource.MaxDecodeLatency.Description",
+	                      "When native decode falls this far behind, drop non-reference frames and reduce decode "
+	                      "quality; at twice this lag, skip to the next keyframe. 0 disables frame skipping."));
+	obs_property_t *scaleQuality =
+	    obs_properties_add_list(advanced, "scale_quality", tr("VDONinjaSource.ScaleQuality", "Scaling Quality"),
+	                            OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(scaleQuality, tr("VDONinjaSource.ScaleQuality.Fast", "Fast"), "fast");
+	obs_property_list_add_string(scaleQuality, tr("VDONinjaSource.ScaleQuality.Bilinear", "Bilinear"), "bilinear");
+	obs_property_list_add_string(scaleQuality, tr("VDONinjaSource.ScaleQuality.Bicubic", "Bicubic"), "bicubic");
+	obs_property_list_add_string(scaleQuality, tr("VDONinjaSource.ScaleQuality.Lanczos", "Lanczos"), "lanczos");
+	obs_property_set_long_description(
+	    scaleQuality, tr("VDONinjaSource.ScaleQuality.Description",
+	                     "Filter used when the decoded video is resized to fit the source. Frames that already "
+	                     "match the source size only convert color and use the fastest path."));
+	obs_property_t *relayStreamId = obs_properties_add_text(
+	    advanced, "relay_stream_id", tr("VDONinjaSource.RelayStreamID", "Relay Stream ID"), OBS_TEXT_DEFAULT);
+	obs_property_set_long_description(
+	    relayStreamId, tr("VDONinjaSource.RelayStreamID.Description",
+	                      "Optional. Republishes the received H.264 stream under this stream ID without re-encoding, "
+	                      "so the publisher sends it once however many viewers watch the relay. Leave blank to "
+	                      "disable."));
+	obs_properties_add_int(advanced, "relay_max_viewers",
+	                       tr("VDONinjaSource.RelayMaxViewers", "Relay Max Viewers"), 1, 200, 1);
+	obs_property_t *receiveStats = obs_properties_add_text(
+	    advanced, "native_receive_stats",
+	    source ? source->receivePipelineSummary().c_str()
+	           : tr("VDONinjaSource.ReceiveStats.Inactive", "Native receiver is not running."),
+	    OBS_TEXT_INFO);
+	obs_property_text_set_info_type(receiveStats, OBS_TEXT_INFO_NORMAL);
+	obs_property_text_set_info_word_wrap(receiveStats, false);
+	obs_properties_add_button(advanced, "native_receive_stats_refresh",
+	                          tr("VDONinjaSource.ReceiveStats.Refresh", "Refresh Receive Stats"),
+	                          vdoninja_source_refresh_receive_stats);
 	obs_properties_add_group(props, "advanced", tr("AdvancedSettings", "Advanced Settings"), OBS_GROUP_NORMAL,
 	                         advanced);
 	setNativeOnlyPropertiesVisible(props, false);
@@ -819,6 +945,11 @@ static void vdoninja_source_defaults(obs_data_t *settings)
 	obs_data_set_default_bool(settings, "enable_data_channel", true);
 	obs_data_set_default_bool(settings, "auto_reconnect", true);
 	obs_data_set_default_bool(settings, "force_turn", false);
+	obs_data_set_default_int(settings, "max_decode_latency_ms", DEFAULT_MAX_DECODE_LATENCY_MS);
+	obs_data_set_default_string(settings, "scale_quality", kDefaultVideoScaleQuality);
+	obs_data_set_default_string(settings, "relay_stream_id", "");
+	obs_data_set_default_int(settings, "relay_max_viewers", DEFAULT_RELAY_MAX_VIEWERS);
+	obs_data_set_default_bool(settings, "shared_room_signaling", false);
 	obs_data_set_default_int(settings, "width", 1920);
 	obs_data_set_default_int(settings, "height", 1080);
 }
@@ -947,6 +1078,36 @@ void VDONinjaSource::feedNativeMediaTestVp9AccessUnit(bool alpha, const std::vec
 	feedNativeMediaTestVp9Packet(alpha, accessUnit, rtpTimestamp, true, true);
 }
 
+void VDONinjaSource::feedNativeMediaTestH264Packet(const std::vector<uint8_t> &payload, uint16_t sequence,
+                                                   uint32_t rtpTimestamp, bool marker)
+{
+	if (payload.empty()) {
+		return;
+	}
+
+	const uint64_t mediaEpoch = mediaEpochGate_.capture();
+	{
+		std::lock_guard<std::mutex> stateLock(nativeStateMutex_);
+		nativeVideoCodec_ = NativeVideoCodec::H264;
+	}
+
+	std::vector<uint8_t> packet(12 + payload.size(), 0);
+	packet[0] = 0x80;
+	packet[1] = static_cast<uint8_t>((marker ? 0x80 : 0x00) | 102);
+	packet[2] = static_cast<uint8_t>(sequence >> 8);
+	packet[3] = static_cast<uint8_t>(sequence);
+	packet[4] = static_cast<uint8_t>(rtpTimestamp >> 24);
+	packet[5] = static_cast<uint8_t>(rtpTimestamp >> 16);
+	packet[6] = static_cast<uint8_t>(rtpTimestamp >> 8);
+	packet[7] = static_cast<uint8_t>(rtpTimestamp);
+	packet[8] = 0x01;
+	packet[9] = 0x02;
+	packet[10] = 0x03;
+	packet[11] = 0x04;
+	std::copy(payload.begin(), payload.end(), packet.begin() + 12);
+	processVideoRtpPacket(packet.data(), packet.size(), mediaEpoch);
+}
+
 void VDONinjaSource::feedNativeMediaTestVp9Packet(bool alpha, const std::vector<uint8_t> &payload,
                                                   uint32_t rtpTimestamp, bool startOfFrame, bool endOfFrame)
 {
@@ -1114,6 +1275,12 @@ NativeMediaTestSnapshot VDONinjaSource::nativeMediaTestSnapshot()
 	snapshot.alphaActiveThreadType = alphaDecoder_ ? alphaDecoder_->active_thread_type : 0;
 	snapshot.videoOutputActive = videoOutputActive_.load(std::memory_order_relaxed);
 	snapshot.lastVideoTimeMs = lastVideoTime_.load(std::memory_order_relaxed);
+	snapshot.receivePipeline = receiveTracer_.snapshot();
+	snapshot.decodeBudget = videoDecodeBudget_.getStats();
+	{
+		std::lock_guard<std::mutex> audioDecodeLock(audioDecodeMutex_);
+		snapshot.audioJitter = audioJitterBuffer_.getStats();
+	}
 	const auto dimensions = outputDimensions();
 	snapshot.outputWidth = dimensions.width;
 	snapshot.outputHeight = dimensions.height;
@@ -1200,6 +1367,14 @@ uint64_t VDONinjaSource::nativeMediaTestEpoch() const
 {
 	return mediaEpochGate_.capture();
 }
+
+VDONinjaRelay &VDONinjaSource::startNativeMediaTestRelay(const std::string &relayStreamId, const std::string &wssHost)
+{
+	settings_.relayStreamId = relayStreamId;
+	settings_.wssHost = wssHost;
+	startRelay();
+	return relay_;
+}
 #endif
 
 VDONinjaSource::~VDONinjaSource()
@@ -1253,6 +1428,17 @@ void VDONinjaSource::loadSettings(obs_data_t *settings)
 	settings_.enableDataChannel = obs_data_get_bool(settings, "enable_data_channel");
 	settings_.autoReconnect = obs_data_get_bool(settings, "auto_reconnect");
 	settings_.forceTurn = obs_data_get_bool(settings, "force_turn");
+	settings_.maxDecodeLatencyMs = static_cast<int>(
+	    std::clamp<int64_t>(obs_data_get_int(settings, "max_decode_latency_ms"), 0, kMaxDecodeLatencyMs));
+	maxDecodeLatencyMs_.store(settings_.maxDecodeLatencyMs, std::memory_order_relaxed);
+	const VideoScaleQuality scaleQuality = parseVideoScaleQuality(obs_data_get_string(settings, "scale_quality"));
+	settings_.scaleQuality = videoScaleQualityName(scaleQuality);
+	videoScaleQuality_.store(static_cast<int>(scaleQuality), std::memory_order_relaxed);
+	settings_.relayStreamId = trim(obs_data_get_string(settings, "relay_stream_id"));
+	settings_.relayMaxViewers =
+	    static_cast<int>(std::clamp<int64_t>(obs_data_get_int(settings, "relay_max_viewers"), 1, 200));
+	// Set by auto-inbound, which creates one receiver per guest in the room.
+	settings_.sharedRoomSignaling = obs_data_get_bool(settings, "shared_room_signaling");
 
 	const int64_t rawWidth = obs_data_get_int(settings, "width");
 	const int64_t rawHeight = obs_data_get_int(settings, "height");
@@ -1413,6 +1599,28 @@ void VDONinjaSource::connect()
 	lastKeyframeRequestTime_.store(0, std::memory_order_relaxed);
 	logWarning("Use Native Receiver (Experimental) is enabled");
 	connectionThread_ = std::thread(&VDONinjaSource::connectionThread, this);
+	startAudioPlayoutClock();
+	startRelay();
+}
+
+void VDONinjaSource::startRelay()
+{
+	if (settings_.relayStreamId.empty()) {
+		return;
+	}
+	RelaySettings relaySettings;
+	relaySettings.streamId = settings_.relayStreamId;
+	relaySettings.password = settings_.password;
+	relaySettings.wssHost = settings_.wssHost;
+	relaySettings.salt = settings_.salt;
+	relaySettings.customIceServers = settings_.customIceServers;
+	relaySettings.forceTurn = settings_.forceTurn;
+	relaySettings.maxViewers = settings_.relayMaxViewers;
+	const auto callbackState = callbackState_;
+	relay_.start(relaySettings, [callbackState]() {
+		AsyncCallbackGuard<VDONinjaSource> guard(callbackState.get());
+		return guard && guard.owner()->requestRelayKeyframe();
+	});
 }
 
 void VDONinjaSource::disconnect()
@@ -1421,6 +1629,7 @@ void VDONinjaSource::disconnect()
 	connected_ = false;
 	setObsSourceAudioActive(false);
 	resetViewRetryState();
+	relay_.stop();
 
 	// Tell the publisher to retire this viewer while its data channel is still
 	// open. Closing signaling alone leaves the publisher's peer alive until ICE
@@ -1461,12 +1670,55 @@ void VDONinjaSource::disconnect()
 	if (connectionThread_.joinable()) {
 		connectionThread_.join();
 	}
+	stopAudioPlayoutClock();
 
 	resetNativeState();
 }
 
+void VDONinjaSource::startAudioPlayoutClock()
+{
+	stopAudioPlayoutClock();
+	{
+		std::lock_guard<std::mutex> lock(audioPlayoutMutex_);
+		audioPlayoutStop_ = false;
+	}
+	audioPlayoutThread_ = std::thread(&VDONinjaSource::audioPlayoutThread, this);
+}
+
+void VDONinjaSource::stopAudioPlayoutClock()
+{
+	{
+		std::lock_guard<std::mutex> lock(audioPlayoutMutex_);
+		audioPlayoutStop_ = true;
+	}
+	audioPlayoutCv_.notify_all();
+	if (audioPlayoutThread_.joinable()) {
+		audioPlayoutThread_.join();
+	}
+}
+
+void VDONinjaSource::audioPlayoutThread()
+{
+	setCurrentThreadName("vdo-rx-audio");
+	std::unique_lock<std::mutex> lock(audioPlayoutMutex_);
+	while (!audioPlayoutCv_.wait_for(lock, kAudioPlayoutTick, [this]() { return audioPlayoutStop_; })) {
+		lock.unlock();
+		{
+			std::lock_guard<std::mutex> decodeLock(audioDecodeMutex_);
+			// Packets are only buffered after the decoder opened, and a reset
+			// empties the buffer along with the decoder.
+			if (nativeRunning_.load(std::memory_order_relaxed) && audioJitterBuffer_.bufferedPackets() > 0) {
+				ThreadCpuCharge cpuCharge("audio-decode");
+				pullAudioPlayoutLocked(steadyTimeUs());
+			}
+		}
+		lock.lock();
+	}
+}
+
 void VDONinjaSource::connectionThread()
 {
+	setCurrentThreadName("vdo-rx-connect");
 	try {
 		logInfo("Connecting to VDO.Ninja stream: %s", settings_.streamId.c_str());
 		const auto callbackState = callbackState_;
@@ -1476,6 +1728,10 @@ void VDONinjaSource::connectionThread()
 		peerManager_->setIceServers(settings_.customIceServers);
 		peerManager_->setForceTurn(settings_.forceTurn);
 		signaling_->setSalt(settings_.salt);
+		signaling_->useRoomConnection(settings_.sharedRoomSignaling && !settings_.roomId.empty()
+		                                  ? VDONinjaRoomSignaling::acquire(settings_.wssHost, settings_.roomId,
+		                                                                   settings_.password, settings_.salt)
+		                                  : nullptr);
 
 		peerManager_->setOnTrack([callbackState](const TrackSlotEvent &event) {
 			AsyncCallbackGuard<VDONinjaSource> guard(callbackState.get());
@@ -1677,6 +1933,21 @@ void VDONinjaSource::requestNativeTargetBitrate(const char *reason)
 	}
 }
 
+bool VDONinjaSource::requestRelayKeyframe()
+{
+	std::shared_ptr<rtc::Track> currentVideoTrack;
+	{
+		std::lock_guard<std::mutex> stateLock(nativeStateMutex_);
+		currentVideoTrack = videoTrack_;
+	}
+
+	if (!safeRequestKeyframe(currentVideoTrack, "relay")) {
+		return false;
+	}
+	lastKeyframeRequestTime_.store(currentTimeMs(), std::memory_order_relaxed);
+	return true;
+}
+
 bool VDONinjaSource::acceptPeerEventIdentityLocked(const PeerEventIdentity &identity, bool terminalEvent,
                                                    PeerEventLane lane)
 {
@@ -2617,6 +2888,7 @@ void VDONinjaSource::handleAudioTrackRetired(const TrackSlotEvent &event)
 			audioTrack_.reset();
 			audioTrackPeerUuid_.clear();
 			audioTrackPeerGeneration_ = 0;
+			audioRedPayloadTypes_.clear();
 			resetAudioDecoder();
 			loggedFirstAudioPacket_.store(false, std::memory_order_relaxed);
 			loggedFirstDecodedAudioFrame_.store(false, std::memory_order_relaxed);
@@ -2645,6 +2917,10 @@ void VDONinjaSource::onVideoTrack(const PeerEventIdentity &identity, std::shared
 		return;
 	}
 	const NativeVideoCodec negotiatedCodec = hasVP9 ? NativeVideoCodec::VP9 : NativeVideoCodec::H264;
+	if (negotiatedCodec == NativeVideoCodec::VP9 && relay_.isRunning()) {
+		logWarning("Relay forwards H.264 only; viewers of %s will receive audio but no video from this VP9 publisher",
+		           settings_.relayStreamId.c_str());
+	}
 
 	std::string payloadSummary;
 	std::unordered_set<uint8_t> redPayloadTypes;
@@ -2733,6 +3009,11 @@ void VDONinjaSource::onVideoTrack(const PeerEventIdentity &identity, std::shared
 				    return;
 			    }
 			    VDONinjaSource *self = guard.owner();
+			    if (message && message->type == rtc::Message::Control) {
+				    self->receiveTracer_.observeRtcp(reinterpret_cast<const uint8_t *>(message->data()),
+				                                     message->size());
+				    return;
+			    }
 			    if (!message || message->type != rtc::Message::Binary || message->size() < sizeof(rtc::RtpHeader)) {
 				    return;
 			    }
@@ -3011,8 +3292,16 @@ void VDONinjaSource::onAudioTrack(const PeerEventIdentity &identity, std::shared
 		         describeMediaCodecs(description).c_str());
 		return;
 	}
-	logInfo("Attaching native audio receive callbacks (mid=%s, direction=%d, rate=%d, channels=%d)",
-	        track->mid().c_str(), static_cast<int>(description.direction()), sampleRate, channels);
+	std::unordered_set<uint8_t> redPayloadTypes;
+	for (const int payloadType : description.payloadTypes()) {
+		const auto *rtpMap = description.rtpMap(payloadType);
+		if (rtpMap && toLowerCopy(rtpMap->format) == "red") {
+			redPayloadTypes.insert(static_cast<uint8_t>(payloadType));
+		}
+	}
+	logInfo("Attaching native audio receive callbacks (mid=%s, direction=%d, rate=%d, channels=%d, red=%s)",
+	        track->mid().c_str(), static_cast<int>(description.direction()), sampleRate, channels,
+	        redPayloadTypes.empty() ? "no" : "yes");
 
 	const int normalizedSampleRate = normalizeOpusSampleRate(sampleRate);
 	const int normalizedChannels = normalizeOpusChannelCount(channels);
@@ -3050,6 +3339,7 @@ void VDONinjaSource::onAudioTrack(const PeerEventIdentity &identity, std::shared
 		audioTrack_ = track;
 		audioTrackPeerUuid_ = uuid;
 		audioTrackPeerGeneration_ = identity.generation;
+		audioRedPayloadTypes_ = redPayloadTypes;
 		if (replacedExistingTrack) {
 			logInfo("Replacing native audio track for peer %s; resetting decoder state", uuid.c_str());
 			resetAudioDecoder();
@@ -3181,15 +3471,19 @@ void VDONinjaSource::publishOutputDimensions(uint32_t width, uint32_t height)
 	outputDimensionsPacked_.store(packed, std::memory_order_release);
 }
 
-void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t rtpTimestamp, uint64_t mediaEpoch)
+void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t rtpTimestamp, uint64_t mediaEpoch,
+                                      const EncodedVideoFrameInfo *knownInfo)
 {
 	if (!nativeRunning_.load() || !data || size == 0 || !mediaEpochGate_.isCurrent(mediaEpoch)) {
 		return;
 	}
+	// Runs on a libdatachannel thread, so charge it explicitly.
+	ThreadCpuCharge cpuCharge("decode");
 
 	if (!loggedFirstVideoPacket_.exchange(true)) {
 		logInfo("Native receiver got first depacketized video payload (%zu bytes, rtp ts=%u)", size, rtpTimestamp);
 	}
+	receiveTracer_.noteAssembled(rtpTimestamp, steadyTimeUs());
 
 	std::shared_ptr<rtc::Track> currentVideoTrack;
 	NativeVideoCodec codec = NativeVideoCodec::H264;
@@ -3213,10 +3507,57 @@ void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t
 		if (!mediaEpochGate_.isCurrent(mediaEpoch)) {
 			return;
 		}
+		EncodedVideoFrameInfo frameInfo;
+		if (knownInfo) {
+			frameInfo = *knownInfo;
+		} else {
+			frameInfo =
+			    codec == NativeVideoCodec::VP9 ? inspectVP9Frame(data, size) : inspectH264AccessUnit(data, size);
+		}
+		const double measuredFps = videoFrameRateMeter_.noteFrame(rtpTimestamp, frameInfo.keyframe);
+		if (frameInfo.keyframe && videoDecoder_ && videoDecoderThreads_.active()) {
+			// Nothing after a keyframe refers back past it, so this is where a
+			// decoder can be reopened with the rebalanced thread count.
+			if (measuredFps > 0.0 && videoDecodedWidth_ > 0) {
+				videoDecoderThreads_.update({videoDecodedWidth_, videoDecodedHeight_, measuredFps});
+			}
+			if (videoDecoderThreads_.needsReopen()) {
+				logInfo("Reopening native %s decoder to rebalance decoder threads (was %d)", codecName,
+				        videoDecoderThreads_.openedThreads());
+				resetVideoDecoder();
+			}
+		}
 		if (!initializeVideoDecoder()) {
 			return;
 		}
 
+		videoDecodeBudget_.setBudgetUs(static_cast<int64_t>(maxDecodeLatencyMs_.load(std::memory_order_relaxed)) *
+		                               1000);
+		const DecodeAdmissionResult admission = videoDecodeBudget_.admit(rtpTimestamp, steadyTimeUs(), frameInfo);
+		if (admission.flushDecoder) {
+			logWarning("Native %s decode is %.0f ms behind real time (budget %lld ms); skipping to the next keyframe",
+			           codecName, static_cast<double>(admission.lagUs) / 1000.0,
+			           static_cast<long long>(videoDecodeBudget_.budgetUs() / 1000));
+			avcodec_flush_buffers(videoDecoder_);
+		}
+		if (admission.requestKeyframe && safeRequestKeyframe(currentVideoTrack, "decode-latency-budget")) {
+			lastKeyframeRequestTime_.store(currentTimeMs(), std::memory_order_relaxed);
+		}
+		if (admission.action == DecodeAdmission::DropNonReference ||
+		    admission.action == DecodeAdmission::SkipToKeyframe) {
+			return;
+		}
+		const bool degradeDecode = admission.action == DecodeAdmission::DecodeDegraded;
+		if (degradeDecode != videoDecodeDegraded_) {
+			// Decoder threads pick these up from the user context on the next packet.
+			videoDecoder_->skip_loop_filter = degradeDecode ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+			videoDecoder_->skip_frame = degradeDecode ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+			videoDecodeDegraded_ = degradeDecode;
+			logInfo("Native %s decode %s (lag %.0f ms)", codecName,
+			        degradeDecode ? "degraded to catch up" : "restored to full quality",
+			        static_cast<double>(admission.lagUs) / 1000.0);
+		}
+
 		av_packet_unref(videoPacket_);
 		const int allocResult = av_new_packet(videoPacket_, static_cast<int>(size));
 		if (allocResult < 0) {
@@ -3235,6 +3576,7 @@ void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t
 				}
 				if (receiveResult < 0) {
 					logWarning("Failed to decode %s frame: %s", codecName, ffmpegErrorString(receiveResult).c_str());
+					receiveTracer_.noteDrop(ReceiveDropReason::DecodeError);
 					if (safeRequestKeyframe(currentVideoTrack, "decode-failure")) {
 						lastKeyframeRequestTime_.store(currentTimeMs(), std::memory_order_relaxed);
 					}
@@ -3270,6 +3612,8 @@ void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t
 					frameToOutput = videoTransferFrame_;
 				}
 
+				videoDecodedWidth_ = frameToOutput->width;
+				videoDecodedHeight_ = frameToOutput->height;
 				const auto decodedTimestamp =
 				    resolveDecodedRtpTimestamp(frameToOutput->pts, frameToOutput->best_effort_timestamp);
 				if (!decodedTimestamp && alphaTrackActive_.load(std::memory_order_relaxed)) {
@@ -3277,6 +3621,7 @@ void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t
 					    "Dropping primary video frame without a decoder-preserved RTP timestamp while alpha is active");
 				} else {
 					const uint32_t decodedRtpTimestamp = decodedTimestamp.value_or(rtpTimestamp);
+					receiveTracer_.noteDecoded(decodedRtpTimestamp, steadyTimeUs());
 					auto retainedFrame = retainVideoFrame(frameToOutput);
 					if (retainedFrame) {
 						decodedFrames.emplace_back(std::move(retainedFrame), decodedRtpTimestamp);
@@ -3304,6 +3649,7 @@ void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t
 				logWarning("Failed to submit %s packet before a decodable keyframe arrived: %s", codecName,
 				           ffmpegErrorString(sendResult).c_str());
 			}
+			receiveTracer_.noteDrop(ReceiveDropReason::DecodeError);
 			const int64_t now = currentTimeMs();
 			const int64_t lastKeyframeRequestTime = lastKeyframeRequestTime_.load(std::memory_order_relaxed);
 			if ((lastKeyframeRequestTime == 0 || now - lastKeyframeRequestTime >= 1000) &&
@@ -3323,6 +3669,8 @@ void VDONinjaSource::processVideoData(const uint8_t *data, size_t size, uint32_t
 #endif
 		if (mediaEpochGate_.isCurrent(mediaEpoch)) {
 			outputDecodedVideoFrame(decodedFrame.first.get(), decodedFrame.second, mediaEpoch);
+		} else {
+			receiveTracer_.noteDrop(ReceiveDropReason::EpochGate);
 		}
 	}
 }
@@ -3342,6 +3690,11 @@ void VDONinjaSource::processVideoRtpPacket(const uint8_t *packetData, size_t pac
 
 	const uint8_t *payload = packetData + payloadView->offset;
 	size_t payloadSize = payloadView->size;
+	const uint32_t ssrc = rtpHeader->ssrc();
+	const bool ssrcChanged = videoRtpSsrc_.exchange(ssrc, std::memory_order_relaxed) != ssrc;
+	if (ssrcChanged) {
+		receiveTracer_.setMediaSsrc(ssrc);
+	}
 	std::vector<uint8_t> redPrimaryPayload;
 	NativeVideoCodec codec;
 	{
@@ -3371,82 +3724,149 @@ void VDONinjaSource::processVideoRtpPacket(const uint8_t *packetData, size_t pac
 		accessUnit.insert(accessUnit.end(), std::begin(kLongStartCode), std::end(kLongStartCode));
 	};
 
-	const auto appendPayload = [&](std::vector<uint8_t> &accessUnit) -> bool {
-		const uint8_t nalType = payload[0] & 0x1F;
+	// Runs under videoAssemblyMutex_.
+	const auto appendPayload = [&](std::vector<uint8_t> &accessUnit, const uint8_t *data, size_t size) -> bool {
+		const uint8_t nalType = data[0] & 0x1F;
+		if (nalType != 28 && videoAssemblyFragmentOpen_) {
+			videoAssemblyDamaged_ = true;
+			videoAssemblyFragmentOpen_ = false;
+		}
 		if (nalType > 0 && nalType < 24) {
 			appendSeparator(accessUnit);
-			accessUnit.insert(accessUnit.end(), payload, payload + payloadSize);
+			accessUnit.insert(accessUnit.end(), data, data + size);
 			return true;
 		}
 
 		if (nalType == 24) {
 			size_t offset = 1;
-			while (offset + sizeof(uint16_t) <= payloadSize) {
+			while (offset + sizeof(uint16_t) <= size) {
 				const size_t naluSize =
-				    (static_cast<size_t>(payload[offset]) << 8) | static_cast<size_t>(payload[offset + 1]);
+				    (static_cast<size_t>(data[offset]) << 8) | static_cast<size_t>(data[offset + 1]);
 				offset += sizeof(uint16_t);
-				if (offset + naluSize > payloadSize) {
+				if (offset + naluSize > size) {
 					return false;
 				}
 				appendSeparator(accessUnit);
-				accessUnit.insert(accessUnit.end(), payload + offset, payload + offset + naluSize);
+				accessUnit.insert(accessUnit.end(), data + offset, data + offset + naluSize);
 				offset += naluSize;
 			}
 			return true;
 		}
 
 		if (nalType == 28) {
-			if (payloadSize < 2) {
+			if (size < 2) {
 				return false;
 			}
-			const uint8_t fuIndicator = payload[0];
-			const uint8_t fuHeader = payload[1];
+			const uint8_t fuIndicator = data[0];
+			const uint8_t fuHeader = data[1];
 			const bool start = (fuHeader & 0x80) != 0;
+			const bool end = (fuHeader & 0x40) != 0;
+			// A fragment run that restarts or resumes mid-NAL lost a fragment.
+			if (start == videoAssemblyFragmentOpen_) {
+				videoAssemblyDamaged_ = true;
+			}
+			videoAssemblyFragmentOpen_ = !end;
 			const uint8_t reconstructedHeader = static_cast<uint8_t>((fuIndicator & 0xE0) | (fuHeader & 0x1F));
 			if (start || accessUnit.empty()) {
 				appendSeparator(accessUnit);
 				accessUnit.push_back(reconstructedHeader);
 			}
-			accessUnit.insert(accessUnit.end(), payload + 2, payload + payloadSize);
+			accessUnit.insert(accessUnit.end(), data + 2, data + size);
 			return true;
 		}
 
 		return false;
 	};
 
-	std::vector<std::pair<std::vector<uint8_t>, uint32_t>> completedFrames;
-	completedFrames.reserve(2);
+	struct AssembledFrame {
+		std::vector<uint8_t> accessUnit;
+		RtpReorderedFrame rtp;
+		bool intact = false;
+		bool decode = false;
+		EncodedVideoFrameInfo info;
+	};
+	std::vector<AssembledFrame> assembledFrames;
+	bool requestKeyframe = false;
 
 	{
 		std::lock_guard<std::mutex> lock(videoAssemblyMutex_);
 		if (!mediaEpochGate_.isCurrent(mediaEpoch)) {
 			return;
 		}
-		if (!videoAssemblyActive_) {
-			videoAssemblyActive_ = true;
-			videoAssemblyTimestamp_ = rtpHeader->timestamp();
-		} else if (videoAssemblyTimestamp_ != rtpHeader->timestamp()) {
-			if (!videoAssemblyBuffer_.empty()) {
-				completedFrames.emplace_back(std::move(videoAssemblyBuffer_), videoAssemblyTimestamp_);
-				videoAssemblyBuffer_.clear();
-			}
-			videoAssemblyTimestamp_ = rtpHeader->timestamp();
+		if (ssrcChanged) {
+			videoReorder_.reset();
 		}
-
-		if (!appendPayload(videoAssemblyBuffer_)) {
+		const uint32_t timestamp = rtpHeader->timestamp();
+		const bool startsFrame = !videoReorder_.active() || videoReorder_.timestamp() != timestamp;
+		std::vector<RtpReorderedFrame> reordered;
+		if (!videoReorder_.push(rtpHeader->seqNumber(), timestamp, rtpHeader->marker() != 0, payload, payloadSize,
+		                        reordered)) {
 			return;
 		}
+		if (startsFrame) {
+			receiveTracer_.noteFirstPacket(timestamp, steadyTimeUs());
+		}
 
-		if (rtpHeader->marker() && !videoAssemblyBuffer_.empty()) {
-			completedFrames.emplace_back(std::move(videoAssemblyBuffer_), videoAssemblyTimestamp_);
-			videoAssemblyBuffer_.clear();
-			videoAssemblyActive_ = false;
+		for (auto &rtpFrame : reordered) {
+			AssembledFrame frame;
+			frame.accessUnit.reserve(rtpFrame.bytes.size() + rtpFrame.packets.size() * 4);
+			videoAssemblyDamaged_ = !rtpFrame.intact;
+			videoAssemblyFragmentOpen_ = false;
+			for (const auto &packet : rtpFrame.packets) {
+				if (!appendPayload(frame.accessUnit, rtpFrame.bytes.data() + packet.offset, packet.size)) {
+					videoAssemblyDamaged_ = true;
+				}
+			}
+			frame.intact = !videoAssemblyDamaged_ && !videoAssemblyFragmentOpen_ && !frame.accessUnit.empty();
+			if (!frame.intact) {
+				receiveTracer_.noteDrop(ReceiveDropReason::IncompleteFrame);
+				videoAwaitingKeyframe_ = true;
+			} else {
+				if (rtpFrame.followsLoss) {
+					// Whole frames were lost ahead of this one.
+					receiveTracer_.noteDrop(ReceiveDropReason::IncompleteFrame);
+					videoAwaitingKeyframe_ = true;
+				}
+				frame.info = inspectH264AccessUnit(frame.accessUnit.data(), frame.accessUnit.size());
+				if (frame.info.keyframe || (frame.info.recoveryPoint && videoPassedKeyframe_)) {
+					videoAwaitingKeyframe_ = false;
+				}
+				videoPassedKeyframe_ = videoPassedKeyframe_ || frame.info.keyframe;
+				frame.decode = !videoAwaitingKeyframe_;
+			}
+			requestKeyframe = requestKeyframe || videoAwaitingKeyframe_;
+			frame.rtp = std::move(rtpFrame);
+			assembledFrames.push_back(std::move(frame));
 		}
+		videoAssemblyDamaged_ = false;
+		videoAssemblyFragmentOpen_ = false;
 	}
 
-	for (const auto &frame : completedFrames) {
-		if (!frame.first.empty()) {
-			processVideoData(frame.first.data(), frame.first.size(), frame.second, mediaEpoch);
+	for (const auto &frame : assembledFrames) {
+		// The relay judges each frame's continuity itself.
+		for (const auto &packet : frame.rtp.packets) {
+			relay_.noteVideoPacket(ssrc, packet.sequence, frame.rtp.timestamp, frame.intact);
+		}
+		if (!frame.accessUnit.empty()) {
+			relay_.forwardVideoFrame(frame.accessUnit.data(), frame.accessUnit.size(), frame.rtp.timestamp);
+		}
+		if (frame.decode) {
+			processVideoData(frame.accessUnit.data(), frame.accessUnit.size(), frame.rtp.timestamp, mediaEpoch,
+			                 &frame.info);
+		}
+	}
+
+	if (requestKeyframe) {
+		std::shared_ptr<rtc::Track> currentVideoTrack;
+		{
+			std::lock_guard<std::mutex> stateLock(nativeStateMutex_);
+			currentVideoTrack = videoTrack_;
+		}
+		const int64_t now = currentTimeMs();
+		const int64_t lastKeyframeRequestTime = lastKeyframeRequestTime_.load(std::memory_order_relaxed);
+		if ((lastKeyframeRequestTime == 0 || now - lastKeyframeRequestTime >= 1000) &&
+		    safeRequestKeyframe(currentVideoTrack, "frame-loss")) {
+			lastKeyframeRequestTime_.store(now, std::memory_order_relaxed);
 		}
 	}
 }
@@ -3488,14 +3908,19 @@ void VDONinjaSource::processVP9RtpPacket(const uint8_t *payload, size_t payloadS
 			if (videoAssemblyActive_ && !videoAssemblyBuffer_.empty()) {
 				logWarning("VP9 B=1 received before E=1 for previous frame; discarding %zu bytes",
 				           videoAssemblyBuffer_.size());
+				receiveTracer_.noteDrop(ReceiveDropReason::IncompleteFrame);
 			}
 			videoAssemblyBuffer_.clear();
 			videoAssemblyActive_ = true;
 			videoAssemblyTimestamp_ = rtpTimestamp;
+			receiveTracer_.noteFirstPacket(rtpTimestamp, steadyTimeUs());
 		}
 
 		if (!videoAssemblyActive_) {
 			// Mid-frame packet arrived before we saw a B=1 — skip until next keyframe.
+			if (desc.endOfFrame) {
+				receiveTracer_.noteDrop(ReceiveDropReason::IncompleteFrame);
+			}
 			return;
 		}
 
@@ -3603,6 +4028,7 @@ void VDONinjaSource::processAudioRtpPacket(const uint8_t *packetData, size_t pac
 	if (!nativeRunning_.load() || !packetData || packetSize < sizeof(rtc::RtpHeader)) {
 		return;
 	}
+	ThreadCpuCharge cpuCharge("audio-decode");
 
 	const auto payloadView = parseRtpPayloadView(packetData, packetSize);
 	if (!payloadView || payloadView->size == 0) {
@@ -3610,23 +4036,95 @@ void VDONinjaSource::processAudioRtpPacket(const uint8_t *packetData, size_t pac
 	}
 
 	const auto *rtpHeader = reinterpret_cast<const rtc::RtpHeader *>(packetData);
-	processAudioData(packetData + payloadView->offset, payloadView->size, rtpHeader->timestamp());
+	const uint8_t *payload = packetData + payloadView->offset;
+	if (!loggedFirstAudioPacket_.exchange(true)) {
+		logInfo("Native receiver got first depacketized audio payload (%zu bytes, rtp ts=%u)", payloadView->size,
+		        rtpHeader->timestamp());
+	}
+
+	std::lock_guard<std::mutex> lock(audioDecodeMutex_);
+	if (!initializeAudioDecoder(audioSampleRate_, audioChannels_)) {
+		return;
+	}
+
+	// Packets are released from the jitter buffer here and by the playout
+	// clock, so a missing packet is concealed once its deadline has passed.
+	const int64_t nowUs = steadyTimeUs();
+	const uint16_t sequence = rtpHeader->seqNumber();
+	const uint32_t rtpTimestamp = rtpHeader->timestamp();
+	const uint32_t ssrc = rtpHeader->ssrc();
+	if (audioRedPayloadTypes_.count(payloadView->payloadType) == 0) {
+		relay_.forwardAudioFrame(ssrc, payload, payloadView->size, rtpTimestamp);
+		audioJitterBuffer_.push(sequence, rtpTimestamp, payload, payloadView->size, nowUs);
+	} else {
+		if (!parseAudioRedPayload(payload, payloadView->size, audioRedBlocks_)) {
+			return;
+		}
+		const AudioRedBlock &primary = audioRedBlocks_.back();
+		relay_.forwardAudioFrame(ssrc, primary.data, primary.size, rtpTimestamp);
+		audioJitterBuffer_.push(sequence, rtpTimestamp, primary.data, primary.size, nowUs);
+		// Redundant blocks carry earlier frames of the same stream. Their
+		// sequence numbers follow from the timestamp offset in whole frames;
+		// the jitter buffer keeps only the ones that fill a slot still missing.
+		const int frameSamples = inspectOpusPacket(primary.data, primary.size).samples;
+		for (size_t i = 0; frameSamples > 0 && i + 1 < audioRedBlocks_.size(); ++i) {
+			const AudioRedBlock &block = audioRedBlocks_[i];
+			if (block.payloadType != primary.payloadType || block.size == 0 || block.timestampOffset == 0 ||
+			    block.timestampOffset % static_cast<uint32_t>(frameSamples) != 0) {
+				continue;
+			}
+			const uint32_t distance = block.timestampOffset / static_cast<uint32_t>(frameSamples);
+			audioJitterBuffer_.pushRedundant(static_cast<uint16_t>(sequence - distance),
+			                                 rtpTimestamp - block.timestampOffset, block.data, block.size, nowUs);
+		}
+	}
+	pullAudioPlayoutLocked(nowUs);
+
+	lastAudioTime_.store(currentTimeMs(), std::memory_order_relaxed);
+}
+
+void VDONinjaSource::pullAudioPlayoutLocked(int64_t nowUs)
+{
+	audioPlayoutItems_.clear();
+	audioJitterBuffer_.pull(nowUs, audioPlayoutItems_);
+	for (const auto &item : audioPlayoutItems_) {
+		playoutAudioItemLocked(item);
+	}
 }
 
-void VDONinjaSource::processAudioData(const uint8_t *data, size_t size, uint32_t rtpTimestamp)
+void VDONinjaSource::playoutAudioItemLocked(const AudioPlayoutItem &item)
 {
-	if (!nativeRunning_.load() || !data || size == 0) {
+	if (item.action == AudioPlayoutAction::Decode) {
+		decodeAudioPacketLocked(item.payload.data(), item.payload.size(), item.rtpTimestamp);
+		return;
+	}
+#if defined(VDONINJA_HAVE_LIBOPUS)
+	if (item.action == AudioPlayoutAction::DecodeFec && opusDecoder_ &&
+	    decodeOpusLocked(item.payload.data(), item.payload.size(), item.rtpTimestamp, item.samples)) {
 		return;
 	}
+#endif
 
-	if (!loggedFirstAudioPacket_.exchange(true)) {
-		logInfo("Native receiver got first depacketized audio payload (%zu bytes, rtp ts=%u)", size, rtpTimestamp);
+	// One zero-length frame per missing frame of the stream's configuration;
+	// the decoder conceals each from its own history.
+	const auto lostFrame = makeOpusLostFramePacket(item.toc);
+	const int frameSamples = std::max(1, inspectOpusPacket(lostFrame.data(), lostFrame.size()).samples);
+	for (int offset = 0; offset < item.samples; offset += frameSamples) {
+		decodeAudioPacketLocked(lostFrame.data(), lostFrame.size(), item.rtpTimestamp + static_cast<uint32_t>(offset));
 	}
+}
 
-	std::lock_guard<std::mutex> lock(audioDecodeMutex_);
-	if (!initializeAudioDecoder(audioSampleRate_, audioChannels_)) {
+void VDONinjaSource::decodeAudioPacketLocked(const uint8_t *data, size_t size, uint32_t rtpTimestamp)
+{
+	if (!data || size == 0) {
+		return;
+	}
+#if defined(VDONINJA_HAVE_LIBOPUS)
+	if (opusDecoder_) {
+		decodeOpusLocked(data, size, rtpTimestamp, 0);
 		return;
 	}
+#endif
 
 	av_packet_unref(audioPacket_);
 	const int allocResult = av_new_packet(audioPacket_, static_cast<int>(size));
@@ -3657,9 +4155,54 @@ void VDONinjaSource::processAudioData(const uint8_t *data, size_t size, uint32_t
 		outputDecodedAudioFrame(audioFrame_, mapAudioTimestamp(rtpTimestamp));
 		av_frame_unref(audioFrame_);
 	}
+}
 
-	lastAudioTime_.store(currentTimeMs(), std::memory_order_relaxed);
+#if defined(VDONINJA_HAVE_LIBOPUS)
+bool VDONinjaSource::decodeOpusLocked(const uint8_t *data, size_t size, uint32_t rtpTimestamp, int fecSamples)
+{
+	constexpr int kMaxOpusPacketMs = 120;
+	constexpr int kOpusRtpClockRate = 48000;
+	const bool fec = fecSamples > 0;
+	int frameSamples = audioSampleRate_ * kMaxOpusPacketMs / 1000;
+	if (fec) {
+		// FEC must be asked for exactly the lost duration, in 2.5 ms steps.
+		const int step = audioSampleRate_ / 400;
+		frameSamples = std::min(frameSamples, static_cast<int>(static_cast<int64_t>(fecSamples) *
+		                                                        audioSampleRate_ / kOpusRtpClockRate));
+		frameSamples -= frameSamples % step;
+		if (frameSamples <= 0) {
+			return false;
+		}
+	}
+
+	// Interleaved float goes into one reusable plane; the frame only borrows it
+	// for the hand-off to OBS, so decoding does not allocate per packet.
+	if (!audioOpusOutputBuffer_.reserve(1, frameSamples * audioChannels_, static_cast<int>(sizeof(float)))) {
+		return false;
+	}
+	av_frame_unref(audioFrame_);
+	audioFrame_->format = AV_SAMPLE_FMT_FLT;
+	audioFrame_->sample_rate = audioSampleRate_;
+	av_channel_layout_default(&audioFrame_->ch_layout, audioChannels_);
+	audioFrame_->data[0] = audioOpusOutputBuffer_.planes()[0];
+	audioFrame_->extended_data = audioFrame_->data;
+
+	const int decoded = opus_decode_float(opusDecoder_, data, static_cast<opus_int32>(size),
+	                                      reinterpret_cast<float *>(audioFrame_->data[0]), frameSamples, fec ? 1 : 0);
+	if (decoded <= 0) {
+		if (!loggedAudioDecodeSubmitFailure_.exchange(true, std::memory_order_relaxed)) {
+			logWarning("Failed to decode Opus packet: %s", opus_strerror(decoded));
+		}
+		av_frame_unref(audioFrame_);
+		return false;
+	}
+
+	audioFrame_->nb_samples = decoded;
+	outputDecodedAudioFrame(audioFrame_, mapAudioTimestamp(rtpTimestamp));
+	av_frame_unref(audioFrame_);
+	return true;
 }
+#endif
 
 void VDONinjaSource::videoTick(float seconds)
 {
@@ -3818,7 +4361,7 @@ bool VDONinjaSource::initializeVideoDecoder()
 		    configureVideoHardwareDecoder(videoDecoder_, codec, videoHwPixelFormat_, videoHwDeviceName_, isVP9);
 	}
 	if (!videoHwDecodeConfigured_) {
-		videoDecoder_->thread_count = 0;
+		videoDecoder_->thread_count = videoDecoderThreads_.acquire(videoDecoderThreads_.load());
 		videoDecoder_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 	}
 
@@ -3845,7 +4388,9 @@ bool VDONinjaSource::initializeVideoDecoder()
 		logInfo("Initialized native %s decoder with hardware acceleration backend %s", codecName,
 		        videoHwDeviceName_.c_str());
 	} else {
-		logInfo("Initialized native %s decoder in software mode", codecName);
+		const DecoderThreadBudget &budget = DecoderThreadBudget::shared();
+		logInfo("Initialized native %s decoder in software mode with %d threads (%zu decoders share %d)", codecName,
+		        videoDecoderThreads_.openedThreads(), budget.decoders(), budget.share());
 	}
 
 	return true;
@@ -3862,7 +4407,12 @@ bool VDONinjaSource::initializeAudioDecoder(int sampleRate, int channels)
 
 	resetAudioDecoder();
 
-	const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_OPUS);
+	// FFmpeg's libopus wrapper runs real concealment on the zero-length frames
+	// the jitter buffer emits for lost packets; the built-in decoder does not.
+	const AVCodec *codec = avcodec_find_decoder_by_name("libopus");
+	if (!codec) {
+		codec = avcodec_find_decoder(AV_CODEC_ID_OPUS);
+	}
 	if (!codec) {
 		logError("FFmpeg Opus decoder is unavailable");
 		return false;
@@ -3889,6 +4439,15 @@ bool VDONinjaSource::initializeAudioDecoder(int sampleRate, int channels)
 		return false;
 	}
 
+#if defined(VDONINJA_HAVE_LIBOPUS)
+	int opusError = OPUS_OK;
+	opusDecoder_ = opus_decoder_create(audioSampleRate_, audioChannels_, &opusError);
+	if (!opusDecoder_ || opusError != OPUS_OK) {
+		logWarning("libopus decoder unavailable (%s); Opus FEC recovery disabled", opus_strerror(opusError));
+		opusDecoder_ = nullptr;
+	}
+#endif
+
 	return true;
 }
 
@@ -3903,10 +4462,7 @@ void VDONinjaSource::resetVideoDecoder()
 
 void VDONinjaSource::resetVideoDecoderStorageLocked()
 {
-	if (videoScaleContext_) {
-		sws_freeContext(videoScaleContext_);
-		videoScaleContext_ = nullptr;
-	}
+	videoScaler_.reset();
 	if (videoPacket_) {
 		av_packet_free(&videoPacket_);
 	}
@@ -3919,6 +4475,7 @@ void VDONinjaSource::resetVideoDecoderStorageLocked()
 	if (videoDecoder_) {
 		avcodec_free_context(&videoDecoder_);
 	}
+	videoDecoderThreads_.release();
 
 	lastDecodedVideoWidth_ = 0;
 	lastDecodedVideoHeight_ = 0;
@@ -3927,6 +4484,7 @@ void VDONinjaSource::resetVideoDecoderStorageLocked()
 	videoHwStatusLogged_ = false;
 	videoHwPixelFormat_ = AV_PIX_FMT_NONE;
 	videoHwDeviceName_.clear();
+	videoDecodeDegraded_ = false;
 }
 
 void VDONinjaSource::resetAlphaDecoder()
@@ -3949,6 +4507,7 @@ void VDONinjaSource::resetAlphaDecoderStorageLocked()
 	if (alphaDecoder_) {
 		avcodec_free_context(&alphaDecoder_);
 	}
+	alphaDecoderThreads_.release();
 }
 
 void VDONinjaSource::resetMediaPipelineStateLocked()
@@ -3958,6 +4517,11 @@ void VDONinjaSource::resetMediaPipelineStateLocked()
 	videoAssemblyBuffer_.clear();
 	videoAssemblyTimestamp_ = 0;
 	videoAssemblyActive_ = false;
+	videoReorder_.reset();
+	videoAssemblyDamaged_ = false;
+	videoAssemblyFragmentOpen_ = false;
+	videoAwaitingKeyframe_ = false;
+	videoPassedKeyframe_ = false;
 	alphaAssemblyBuffer_.clear();
 	alphaAssemblyTimestamp_ = 0;
 	alphaAssemblyActive_ = false;
@@ -3965,6 +4529,14 @@ void VDONinjaSource::resetMediaPipelineStateLocked()
 	resetAlphaDecoderStorageLocked();
 	alphaFrameSynchronizer_.reset();
 	videoTimestampMapper_.reset();
+	receiveTracer_.clearInFlight();
+	videoDecodeBudget_.reset();
+	videoFrameRateMeter_.reset();
+	alphaFrameRateMeter_.reset();
+	videoDecodedWidth_ = 0;
+	videoDecodedHeight_ = 0;
+	alphaDecodedWidth_ = 0;
+	alphaDecodedHeight_ = 0;
 }
 
 void VDONinjaSource::completeMediaPipelineTransition(const char *reason, bool enableOutput)
@@ -3997,7 +4569,7 @@ bool VDONinjaSource::initializeAlphaDecoder()
 		return false;
 	}
 	alphaDecoder_->pkt_timebase = AVRational{1, 90000};
-	alphaDecoder_->thread_count = 0;
+	alphaDecoder_->thread_count = alphaDecoderThreads_.acquire(alphaDecoderThreads_.load());
 	alphaDecoder_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 #if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
 	nativeMediaTestAlphaRequestedThreadCount_ = alphaDecoder_->thread_count;
@@ -4011,7 +4583,7 @@ bool VDONinjaSource::initializeAlphaDecoder()
 		return false;
 	}
 
-	logInfo("VP9 alpha decoder initialized (software libvpx-vp9)");
+	logInfo("VP9 alpha decoder initialized (software libvpx-vp9, %d threads)", alphaDecoderThreads_.openedThreads());
 	return true;
 }
 
@@ -4030,6 +4602,12 @@ void VDONinjaSource::processAlphaVideoData(const uint8_t *data, size_t size, uin
 	if (!mediaEpochGate_.isCurrent(mediaEpoch)) {
 		return;
 	}
+	// The alpha decoder is paired frame by frame with the primary, so a new
+	// allotment waits until it is next opened; its load still counts now.
+	const double measuredFps = alphaFrameRateMeter_.noteFrame(rtpTimestamp, inspectVP9Frame(data, size).keyframe);
+	if (measuredFps > 0.0 && alphaDecodedWidth_ > 0) {
+		alphaDecoderThreads_.update({alphaDecodedWidth_, alphaDecodedHeight_, measuredFps});
+	}
 	if (!initializeAlphaDecoder()) {
 		return;
 	}
@@ -4060,6 +4638,8 @@ void VDONinjaSource::processAlphaVideoData(const uint8_t *data, size_t size, uin
 			const int w = alphaFrame_->width;
 			const int h = alphaFrame_->height;
 			const int linesize = alphaFrame_->linesize[0];
+			alphaDecodedWidth_ = w;
+			alphaDecodedHeight_ = h;
 			const auto decodedTimestamp =
 			    resolveDecodedRtpTimestamp(alphaFrame_->pts, alphaFrame_->best_effort_timestamp);
 			if (!decodedTimestamp) {
@@ -4136,6 +4716,9 @@ void VDONinjaSource::handleDecodedAlphaFrame(PendingAlphaFrame frame, uint64_t m
 		}
 		result = alphaFrameSynchronizer_.pushAlpha(std::move(frame));
 	}
+	if (result.droppedPrimaryFrames > 0) {
+		receiveTracer_.noteDrop(ReceiveDropReason::AlphaTimeout, result.droppedPrimaryFrames);
+	}
 
 	if ((result.rejectedIncomingFrame || result.droppedPrimaryFrames > 0 || result.droppedAlphaFrames > 0) &&
 	    !loggedAlphaTimestampMiss_.exchange(true, std::memory_order_relaxed)) {
@@ -4162,6 +4745,13 @@ void VDONinjaSource::resetAudioDecoder()
 	if (audioResampleContext_) {
 		swr_free(&audioResampleContext_);
 	}
+#if defined(VDONINJA_HAVE_LIBOPUS)
+	if (opusDecoder_) {
+		opus_decoder_destroy(opusDecoder_);
+		opusDecoder_ = nullptr;
+	}
+#endif
+	audioJitterBuffer_.reset();
 
 	audioResampleInputFormat_ = -1;
 	audioResampleInputRate_ = 0;
@@ -4214,6 +4804,10 @@ void VDONinjaSource::resetNativeState()
 		loggedFirstDecodedAlphaFrame_ = false;
 		loggedAlphaDecodeSubmitFailure_ = false;
 		loggedAlphaDecodeReceiveFailure_ = false;
+		receiveTracer_.reset();
+		videoDecodeBudget_.getStats(true);
+		audioJitterBuffer_.getStats(true);
+		videoRtpSsrc_.store(0, std::memory_order_relaxed);
 		alphaTrackActive_.store(false, std::memory_order_release);
 		preferSoftwareVp9DecodeForAlpha_.store(false, std::memory_order_release);
 		loggedAlphaSoftwareDecodeMode_.store(false, std::memory_order_relaxed);
@@ -4240,6 +4834,7 @@ void VDONinjaSource::resetNativeState()
 		alphaTrackEventPositions_.clear();
 		audioTrackEventPositions_.clear();
 		videoRedPayloadTypes_.clear();
+		audioRedPayloadTypes_.clear();
 		videoHwDecodeDisabled_ = false;
 		videoOutputActive_.store(false, std::memory_order_relaxed);
 		loggedVideoStallClear_.store(false, std::memory_order_relaxed);
@@ -4328,6 +4923,7 @@ void VDONinjaSource::handlePeerDisconnectedAccepted(const PeerEventIdentity &ide
 			audioTrack_.reset();
 			audioTrackPeerUuid_.clear();
 			audioTrackPeerGeneration_ = 0;
+			audioRedPayloadTypes_.clear();
 			resetAudioDecoder();
 			loggedAudioDecodeSubmitFailure_ = false;
 			audioRemoved = true;
@@ -4378,8 +4974,11 @@ void VDONinjaSource::handlePeerDisconnectedAccepted(const PeerEventIdentity &ide
 
 void VDONinjaSource::outputDecodedVideoFrame(const AVFrame *frame, uint32_t rtpTimestamp, uint64_t mediaEpoch)
 {
-	if (!frame || !hasNativeVideoOutputTarget() || !mediaEpochGate_.isCurrent(mediaEpoch) ||
-	    outputMediaEpoch_.load(std::memory_order_acquire) != mediaEpoch) {
+	if (!frame || !hasNativeVideoOutputTarget()) {
+		return;
+	}
+	if (!mediaEpochGate_.isCurrent(mediaEpoch) || outputMediaEpoch_.load(std::memory_order_acquire) != mediaEpoch) {
+		receiveTracer_.noteDrop(ReceiveDropReason::EpochGate);
 		return;
 	}
 	if (remoteVideoMuted_.load(std::memory_order_relaxed)) {
@@ -4420,6 +5019,10 @@ void VDONinjaSource::outputDecodedVideoFrame(const AVFrame *frame, uint32_t rtpT
 		}
 		result = alphaFrameSynchronizer_.pushPrimary(std::move(primaryFrame));
 	}
+	const size_t timedOutPrimaryFrames = result.droppedPrimaryFrames + (result.rejectedIncomingFrame ? 1 : 0);
+	if (timedOutPrimaryFrames > 0) {
+		receiveTracer_.noteDrop(ReceiveDropReason::AlphaTimeout, timedOutPrimaryFrames);
+	}
 	if (result.queued && !loggedAlphaTimestampSyncWait_.exchange(true, std::memory_order_relaxed)) {
 		logInfo("Buffering primary video until the exact VP9 alpha RTP timestamp arrives");
 	}
@@ -4439,6 +5042,7 @@ void VDONinjaSource::outputPairedVideoFrame(AlphaFramePair pair, bool completedB
 	if (!pair.primary.frame || !hasNativeVideoOutputTarget()) {
 		return;
 	}
+	receiveTracer_.notePaired(pair.primary.rtpTimestamp, steadyTimeUs());
 
 #if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
 	runNativeMediaTestStage(NativeMediaTestStage::PreOutput, completedByAlpha, pair.primary.rtpTimestamp,
@@ -4481,8 +5085,9 @@ void VDONinjaSource::outputDecodedVideoFrameLocked(const AVFrame *frame, uint32_
 		lastDecodedVideoHeight_ = frame->height;
 	}
 
-	std::vector<uint8_t> alphaYCopy;
-	std::vector<uint8_t> scaledAlphaY;
+	// Both planes are read in place: the pair outlives this call, and a
+	// rescaled plane lands in a buffer reused across frames.
+	const std::vector<uint8_t> *alphaY = nullptr;
 	int alphaYLinesize = 0;
 	bool hasAlpha = false;
 	int alphaWidth = 0;
@@ -4492,12 +5097,12 @@ void VDONinjaSource::outputDecodedVideoFrameLocked(const AVFrame *frame, uint32_
 		    alphaFrame->yLinesize >= alphaFrame->width &&
 		    alphaFrame->yData.size() >=
 		        static_cast<size_t>(alphaFrame->yLinesize) * static_cast<size_t>(alphaFrame->height)) {
-			alphaYCopy = alphaFrame->yData;
+			alphaY = &alphaFrame->yData;
 			alphaYLinesize = alphaFrame->yLinesize;
 			hasAlpha = true;
 		} else if (scaleAlphaPlaneNearest(alphaFrame->yData, alphaFrame->width, alphaFrame->height,
-		                                  alphaFrame->yLinesize, frame->width, frame->height, scaledAlphaY)) {
-			alphaYCopy = std::move(scaledAlphaY);
+		                                  alphaFrame->yLinesize, frame->width, frame->height, videoScaledAlphaY_)) {
+			alphaY = &videoScaledAlphaY_;
 			alphaYLinesize = frame->width;
 			hasAlpha = true;
 			alphaWidth = alphaFrame->width;
@@ -4526,34 +5131,47 @@ void VDONinjaSource::outputDecodedVideoFrameLocked(const AVFrame *frame, uint32_
 	}
 
 	const auto dimensions = outputDimensions();
-	const AVPixelFormat inputFormat = static_cast<AVPixelFormat>(frameToScale->format);
 	const AspectFitLayout layout =
 	    computeAspectFitLayout(static_cast<uint32_t>(frameToScale->width), static_cast<uint32_t>(frameToScale->height),
 	                           dimensions.width, dimensions.height);
-	videoScaleContext_ =
-	    sws_getCachedContext(videoScaleContext_, frameToScale->width, frameToScale->height, inputFormat,
-	                         static_cast<int>(layout.contentWidth), static_cast<int>(layout.contentHeight),
-	                         AV_PIX_FMT_BGRA, SWS_BILINEAR, nullptr, nullptr, nullptr);
-	if (!videoScaleContext_) {
-		logError("Failed to create video conversion context");
-		return;
-	}
 
 	const int outputStride = static_cast<int>(layout.outputWidth) * 4;
-	std::vector<uint8_t> output(static_cast<size_t>(outputStride) * static_cast<size_t>(layout.outputHeight), 0);
-	uint8_t *dstData[4] = {output.data() + (static_cast<size_t>(layout.offsetY) * static_cast<size_t>(outputStride)) +
-	                           (static_cast<size_t>(layout.offsetX) * 4),
-	                       nullptr, nullptr, nullptr};
-	int dstLinesize[4] = {outputStride, 0, 0, 0};
-
-	const int scaledHeight = sws_scale(videoScaleContext_, frameToScale->data, frameToScale->linesize, 0,
-	                                   frameToScale->height, dstData, dstLinesize);
-	if (scaledHeight <= 0 || static_cast<uint32_t>(scaledHeight) != layout.contentHeight) {
+	const size_t outputSize = static_cast<size_t>(outputStride) * static_cast<size_t>(layout.outputHeight);
+	// obs_source_output_video() copies the frame, so one buffer serves every
+	// frame. Each frame rewrites the content area; the letterbox bars only
+	// change with the layout or the alpha mode, so they are cleared then.
+	const AspectFitLayout &previousLayout = videoOutputLayout_;
+	if (videoOutputBuffer_.size() != outputSize || hasAlpha != videoOutputHasAlpha_ ||
+	    layout.outputWidth != previousLayout.outputWidth || layout.contentWidth != previousLayout.contentWidth ||
+	    layout.contentHeight != previousLayout.contentHeight || layout.offsetX != previousLayout.offsetX ||
+	    layout.offsetY != previousLayout.offsetY) {
+		videoOutputBuffer_.assign(outputSize, 0);
+		videoOutputLayout_ = layout;
+		videoOutputHasAlpha_ = hasAlpha;
+	}
+	std::vector<uint8_t> &output = videoOutputBuffer_;
+	uint8_t *contentOrigin = output.data() +
+	                         (static_cast<size_t>(layout.offsetY) * static_cast<size_t>(outputStride)) +
+	                         (static_cast<size_t>(layout.offsetX) * 4);
+
+	const auto scaleQuality = static_cast<VideoScaleQuality>(videoScaleQuality_.load(std::memory_order_relaxed));
+	const uint64_t previousScaleRebuilds = videoScaler_.rebuildCount();
+	const int64_t scaleStartedUs = steadyTimeUs();
+	const bool converted = videoScaler_.convert(frameToScale, contentOrigin, outputStride,
+	                                            static_cast<int>(layout.contentWidth),
+	                                            static_cast<int>(layout.contentHeight), AV_PIX_FMT_BGRA, scaleQuality);
+	receiveTracer_.noteScaleDuration(static_cast<uint64_t>(std::max<int64_t>(0, steadyTimeUs() - scaleStartedUs)));
+	if (!converted) {
 		logWarning("Failed to convert decoded video frame");
 		return;
 	}
-	if (hasAlpha && alphaYLinesize > 0 &&
-	    alphaYCopy.size() >= static_cast<size_t>(alphaYLinesize) * static_cast<size_t>(frame->height)) {
+	if (videoScaler_.rebuildCount() != previousScaleRebuilds) {
+		logInfo("Native receiver color conversion %dx%d -> %ux%u (%s quality, %d thread%s)", frameToScale->width,
+		        frameToScale->height, layout.contentWidth, layout.contentHeight, videoScaleQualityName(scaleQuality),
+		        videoScaler_.threadCount(), videoScaler_.threadCount() == 1 ? "" : "s");
+	}
+	if (hasAlpha && alphaY && alphaYLinesize > 0 &&
+	    alphaY->size() >= static_cast<size_t>(alphaYLinesize) * static_cast<size_t>(frame->height)) {
 		uint8_t minAppliedAlpha = 255;
 		uint8_t maxAppliedAlpha = 0;
 		uint64_t nonZeroAppliedAlpha = 0;
@@ -4563,7 +5181,7 @@ void VDONinjaSource::outputDecodedVideoFrameLocked(const AVFrame *frame, uint32_
 			    frame->height - 1, static_cast<int>((static_cast<uint64_t>(y) * static_cast<uint64_t>(frame->height)) /
 			                                        std::max<uint32_t>(1, layout.contentHeight)));
 			const uint8_t *alphaRow =
-			    alphaYCopy.data() + static_cast<size_t>(srcY) * static_cast<size_t>(alphaYLinesize);
+			    alphaY->data() + static_cast<size_t>(srcY) * static_cast<size_t>(alphaYLinesize);
 			uint8_t *dstRow = output.data() +
 			                  (static_cast<size_t>(layout.offsetY + y) * static_cast<size_t>(outputStride)) +
 			                  (static_cast<size_t>(layout.offsetX) * 4);
@@ -4606,8 +5224,11 @@ void VDONinjaSource::outputDecodedVideoFrameLocked(const AVFrame *frame, uint32_
 	runNativeMediaTestStage(NativeMediaTestStage::PreCommit, false, rtpTimestamp, mediaEpoch);
 #endif
 	std::unique_lock<std::mutex> commitStateLock(videoCommitStateMutex_);
-	if (remoteVideoSuppressedState_ || !mediaEpochGate_.isCurrent(mediaEpoch) ||
-	    outputMediaEpoch_.load(std::memory_order_acquire) != mediaEpoch) {
+	if (remoteVideoSuppressedState_) {
+		return;
+	}
+	if (!mediaEpochGate_.isCurrent(mediaEpoch) || outputMediaEpoch_.load(std::memory_order_acquire) != mediaEpoch) {
+		receiveTracer_.noteDrop(ReceiveDropReason::EpochGate);
 		return;
 	}
 #if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
@@ -4624,6 +5245,7 @@ void VDONinjaSource::outputDecodedVideoFrameLocked(const AVFrame *frame, uint32_
 	videoOutputActive_.store(true, std::memory_order_relaxed);
 	lastVideoTime_.store(currentTimeMs(), std::memory_order_relaxed);
 	loggedVideoStallClear_.store(false, std::memory_order_relaxed);
+	receiveTracer_.noteOutput(rtpTimestamp, steadyTimeUs(), wallClockTimeUs());
 #if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
 	if (nativeMediaTestOutputHook_) {
 		NativeMediaTestOutput testOutput;
@@ -4658,17 +5280,37 @@ void VDONinjaSource::outputDecodedAudioFrame(const AVFrame *frame, uint64_t time
 		return;
 	}
 
+	const int inputChannels =
+	    frame->ch_layout.nb_channels > 0 ? static_cast<int>(frame->ch_layout.nb_channels) : audioChannels_;
+	const DecodedAudioFormat decodedFormat = decodedAudioFormatFor(frame->format);
+	const bool passThrough = decodedAudioPassesThrough(decodedFormat, inputChannels);
 	if (!loggedFirstDecodedAudioFrame_.exchange(true)) {
-		logInfo("Native receiver decoded first audio frame (%d samples, format=%d, rate=%d)", frame->nb_samples,
-		        frame->format, frame->sample_rate);
+		logInfo("Native receiver decoded first audio frame (%d samples, format=%d, rate=%d, %s)", frame->nb_samples,
+		        frame->format, frame->sample_rate, passThrough ? "direct output" : "converted");
 	}
 
-	const int inputChannels =
-	    frame->ch_layout.nb_channels > 0 ? static_cast<int>(frame->ch_layout.nb_channels) : audioChannels_;
-	const int outputChannels = inputChannels <= 1 ? 1 : 2;
-	AVChannelLayout outputLayout;
-	av_channel_layout_default(&outputLayout, outputChannels);
+	obs_source_audio audio = {};
+	audio.samples_per_sec = static_cast<uint32_t>(frame->sample_rate);
+	audio.timestamp = timestampNs;
 
+	// Mono and stereo float or 16-bit output goes to OBS as decoded; OBS
+	// converts to its mix format anyway, so a copy here would be pure overhead.
+	if (passThrough) {
+		audio.frames = static_cast<uint32_t>(frame->nb_samples);
+		audio.speakers = speakerLayoutForChannels(inputChannels);
+		audio.format = obsAudioFormatFor(decodedFormat);
+		const bool planar =
+		    decodedFormat == DecodedAudioFormat::FloatPlanar || decodedFormat == DecodedAudioFormat::Int16Planar;
+		const int planes = planar ? inputChannels : 1;
+		for (int i = 0; i < planes && i < MAX_AV_PLANES; ++i) {
+			audio.data[i] = frame->extended_data[i];
+		}
+		setObsSourceAudioActive(true);
+		obs_source_output_audio(source_, &audio);
+		return;
+	}
+
+	const int outputChannels = inputChannels <= 1 ? 1 : 2;
 	const int inputFormat = frame->format;
 	if (!audioResampleContext_ || audioResampleInputFormat_ != inputFormat ||
 	    audioResampleInputRate_ != frame->sample_rate || audioResampleInputChannels_ != inputChannels) {
@@ -4676,6 +5318,8 @@ void VDONinjaSource::outputDecodedAudioFrame(const AVFrame *frame, uint64_t time
 			swr_free(&audioResampleContext_);
 		}
 
+		AVChannelLayout outputLayout;
+		av_channel_layout_default(&outputLayout, outputChannels);
 		AVChannelLayout inputLayout = frame->ch_layout;
 		if (inputLayout.nb_channels == 0) {
 			av_channel_layout_default(&inputLayout, inputChannels);
@@ -4684,9 +5328,9 @@ void VDONinjaSource::outputDecodedAudioFrame(const AVFrame *frame, uint64_t time
 		const int initResult =
 		    swr_alloc_set_opts2(&audioResampleContext_, &outputLayout, AV_SAMPLE_FMT_FLTP, frame->sample_rate,
 		                        &inputLayout, static_cast<AVSampleFormat>(inputFormat), frame->sample_rate, 0, nullptr);
+		av_channel_layout_uninit(&outputLayout);
 		if (initResult < 0 || !audioResampleContext_) {
 			logError("Failed to configure audio converter: %s", ffmpegErrorString(initResult).c_str());
-			av_channel_layout_uninit(&outputLayout);
 			return;
 		}
 
@@ -4694,7 +5338,6 @@ void VDONinjaSource::outputDecodedAudioFrame(const AVFrame *frame, uint64_t time
 		if (openResult < 0) {
 			logError("Failed to initialize audio converter: %s", ffmpegErrorString(openResult).c_str());
 			swr_free(&audioResampleContext_);
-			av_channel_layout_uninit(&outputLayout);
 			return;
 		}
 
@@ -4705,43 +5348,30 @@ void VDONinjaSource::outputDecodedAudioFrame(const AVFrame *frame, uint64_t time
 
 	const int outputSamples = swr_get_out_samples(audioResampleContext_, frame->nb_samples);
 	if (outputSamples <= 0) {
-		av_channel_layout_uninit(&outputLayout);
 		return;
 	}
-
-	uint8_t *dstData[MAX_AV_PLANES] = {};
-	int dstLinesize[MAX_AV_PLANES] = {};
-	const int bufferSize = av_samples_alloc(dstData, dstLinesize, outputChannels, outputSamples, AV_SAMPLE_FMT_FLTP, 0);
-	if (bufferSize < 0) {
-		logError("Failed to allocate converted audio buffer: %s", ffmpegErrorString(bufferSize).c_str());
-		av_channel_layout_uninit(&outputLayout);
+	if (!audioConvertBuffer_.reserve(outputChannels, outputSamples, static_cast<int>(sizeof(float)))) {
+		logError("Failed to size converted audio buffer for %d samples", outputSamples);
 		return;
 	}
 
+	uint8_t **dstData = audioConvertBuffer_.planes();
 	const int convertedSamples = swr_convert(audioResampleContext_, dstData, outputSamples,
 	                                         const_cast<const uint8_t **>(frame->extended_data), frame->nb_samples);
 	if (convertedSamples < 0) {
 		logError("Failed to convert decoded audio frame: %s", ffmpegErrorString(convertedSamples).c_str());
-		av_freep(&dstData[0]);
-		av_channel_layout_uninit(&outputLayout);
 		return;
 	}
 
-	obs_source_audio audio = {};
 	audio.frames = static_cast<uint32_t>(convertedSamples);
 	audio.speakers = speakerLayoutForChannels(outputChannels);
 	audio.format = AUDIO_FORMAT_FLOAT_PLANAR;
-	audio.samples_per_sec = static_cast<uint32_t>(frame->sample_rate);
-	audio.timestamp = timestampNs;
 	for (int i = 0; i < outputChannels && i < MAX_AV_PLANES; ++i) {
 		audio.data[i] = dstData[i];
 	}
 
 	setObsSourceAudioActive(true);
 	obs_source_output_audio(source_, &audio);
-
-	av_freep(&dstData[0]);
-	av_channel_layout_uninit(&outputLayout);
 }
 
 uint64_t VDONinjaSource::mapAudioTimestamp(uint32_t rtpTimestamp)
@@ -4880,8 +5510,13 @@ void VDONinjaSource::updateNativeReceiverSource()
 	}
 
 	const auto dimensions = outputDimensions();
+	// Decode budget and scaler quality are applied live by the child, so they
+	// are compared here rather than in sourceSettingsEqualForChild(), which
+	// also gates reconnects.
 	if (configApplied && configuredWidth == dimensions.width && configuredHeight == dimensions.height &&
-	    sourceSettingsEqualForChild(configuredSettings, settings_)) {
+	    sourceSettingsEqualForChild(configuredSettings, settings_) &&
+	    configuredSettings.maxDecodeLatencyMs == settings_.maxDecodeLatencyMs &&
+	    configuredSettings.scaleQuality == settings_.scaleQuality) {
 		syncChildLifecycleState(child);
 		obs_source_release(child);
 		return;
@@ -5157,6 +5792,118 @@ obs_source_t *VDONinjaSource::acquireActiveChildSource() const
 	return child;
 }
 
+ReceivePipelineSnapshot VDONinjaSource::receivePipelineSnapshot(bool resetInterval)
+{
+	return receiveTracer_.snapshot(resetInterval);
+}
+
+DecodeBudgetStats VDONinjaSource::decodeBudgetStats(bool resetInterval)
+{
+	std::lock_guard<std::mutex> lock(videoDecodeMutex_);
+	return videoDecodeBudget_.getStats(resetInterval);
+}
+
+AudioJitterStats VDONinjaSource::audioJitterStats(bool resetInterval)
+{
+	std::lock_guard<std::mutex> lock(audioDecodeMutex_);
+	return audioJitterBuffer_.getStats(resetInterval);
+}
+
+std::string VDONinjaSource::receivePipelineSummary()
+{
+	if (!isInternalNativeSource()) {
+		// The wrapper only forwards; the internal native child owns the pipeline.
+		obs_source_t *child = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(childSourceMutex_);
+			if (usingNativeReceiver() && nativeReceiverSource_) {
+				child = obs_source_get_ref(nativeReceiverSource_);
+			}
+		}
+		if (!child) {
+			return tr("VDONinjaSource.ReceiveStats.Inactive", "Native receiver is not running.");
+		}
+		auto *nativeSource = static_cast<VDONinjaSource *>(obs_obj_get_data(child));
+		std::string summary = nativeSource ? nativeSource->receivePipelineSummary() : std::string();
+		obs_source_release(child);
+		return summary;
+	}
+
+	const ReceivePipelineSnapshot stats = receivePipelineSnapshot();
+	const DecodeBudgetStats budget = decodeBudgetStats();
+	const AudioJitterStats audio = audioJitterStats();
+	std::string summary;
+	char line[512];
+	std::snprintf(line, sizeof(line), "%s: %llu\n%s: %s %llu, %s %llu, %s %llu, %s %llu\np50 / p95 / p99\n",
+	              tr("VDONinjaSource.ReceiveStats.FramesOutput", "Frames output"),
+	              static_cast<unsigned long long>(stats.outputFrames),
+	              tr("VDONinjaSource.ReceiveStats.Dropped", "Dropped"),
+	              tr("VDONinjaSource.ReceiveStats.Incomplete", "incomplete"),
+	              static_cast<unsigned long long>(stats.incompleteFrames),
+	              tr("VDONinjaSource.ReceiveStats.DecodeError", "decode error"),
+	              static_cast<unsigned long long>(stats.decodeErrors),
+	              tr("VDONinjaSource.ReceiveStats.AlphaTimeout", "alpha timeout"),
+	              static_cast<unsigned long long>(stats.alphaTimeouts),
+	              tr("VDONinjaSource.ReceiveStats.EpochGate", "epoch gate"),
+	              static_cast<unsigned long long>(stats.epochGateDrops));
+	summary += line;
+	summary += formatReceiveLatency(tr("VDONinjaSource.ReceiveStats.Assembly", "Assembly"), stats.assemblyUs);
+	summary += formatReceiveLatency(tr("VDONinjaSource.ReceiveStats.Decode", "Decode"), stats.decodeUs);
+	summary += formatReceiveLatency(tr("VDONinjaSource.ReceiveStats.AlphaWait", "Alpha wait"), stats.alphaWaitUs);
+	summary += formatReceiveLatency(tr("VDONinjaSource.ReceiveStats.Scale", "Scale"), stats.scaleUs);
+	summary += formatReceiveLatency(tr("VDONinjaSource.ReceiveStats.ArrivalToOutput", "RTP arrival -> output"),
+	                                stats.receiveToOutputUs);
+	std::snprintf(line, sizeof(line), "%s %.0f ms; %s %llu, %s %llu, %s %llu (%llu %s), %s %.0f ms\n",
+	              tr("VDONinjaSource.ReceiveStats.DecodeLagMax", "Decode lag max"),
+	              static_cast<double>(budget.maxLagUs) / 1000.0,
+	              tr("VDONinjaSource.ReceiveStats.Degraded", "degraded"),
+	              static_cast<unsigned long long>(budget.degradedFrames),
+	              tr("VDONinjaSource.ReceiveStats.DroppedNonReference", "dropped non-reference"),
+	              static_cast<unsigned long long>(budget.droppedNonReferenceFrames),
+	              tr("VDONinjaSource.ReceiveStats.KeyframeSkips", "keyframe skips"),
+	              static_cast<unsigned long long>(budget.keyframeSkips),
+	              static_cast<unsigned long long>(budget.skippedToKeyframeFrames),
+	              tr("VDONinjaSource.ReceiveStats.Frames", "frames"),
+	              tr("VDONinjaSource.ReceiveStats.Recovered", "recovered"),
+	              static_cast<double>(budget.recoveredLatencyUs) / 1000.0);
+	summary += line;
+	std::snprintf(line, sizeof(line), "%s %.1f ms, %s %d ms (%s %.0f ms); %s %llu, %s %llu, %s %llu, %s %llu\n",
+	              tr("VDONinjaSource.ReceiveStats.AudioJitter", "Audio jitter"), audio.jitterMs,
+	              tr("VDONinjaSource.ReceiveStats.AudioBuffer", "buffer"), audio.targetDelayMs,
+	              tr("VDONinjaSource.ReceiveStats.AudioMeanWait", "mean wait"), audio.meanPlayoutDelayMs,
+	              tr("VDONinjaSource.ReceiveStats.RedRecovered", "RED recovered"),
+	              static_cast<unsigned long long>(audio.redRecoveredPackets),
+	              tr("VDONinjaSource.ReceiveStats.FecRecovered", "FEC recovered"),
+	              static_cast<unsigned long long>(audio.fecRecoveredPackets),
+	              tr("VDONinjaSource.ReceiveStats.Concealed", "concealed"),
+	              static_cast<unsigned long long>(audio.concealedPackets),
+	              tr("VDONinjaSource.ReceiveStats.Late", "late"), static_cast<unsigned long long>(audio.latePackets));
+	summary += line;
+	// Process-wide: every output and receiver shares the plugin threads.
+	const std::vector<SubsystemCpuUsage> threadCpu = threadCpuSampler_.query();
+	summary += tr("VDONinjaSource.ReceiveStats.PluginThreadCpu", "Plugin thread CPU");
+	summary += ": ";
+	summary += threadCpu.empty() ? std::string(tr("VDONinjaSource.ReceiveStats.CpuSampling", "sampling, refresh again"))
+	                             : formatSubsystemCpuUsage(threadCpu);
+	summary += "\n";
+	if (stats.senderReports == 0) {
+		std::snprintf(line, sizeof(line), "%s: %s\n",
+		              tr("VDONinjaSource.ReceiveStats.SenderToOutput", "Sender -> output"),
+		              tr("VDONinjaSource.ReceiveStats.WaitingForSenderReport", "waiting for RTCP sender report"));
+		summary += line;
+	} else {
+		summary += formatReceiveLatency(
+		    tr("VDONinjaSource.ReceiveStats.SenderToOutputRtcp", "Sender -> output (RTCP SR)"), stats.senderToOutputUs);
+		if (stats.unsyncedClockFrames > 0) {
+			std::snprintf(line, sizeof(line), "%s: %llu\n",
+			              tr("VDONinjaSource.ReceiveStats.UnsyncedClockFrames", "Frames with sender clock out of sync"),
+			              static_cast<unsigned long long>(stats.unsyncedClockFrames));
+			summary += line;
+		}
+	}
+	return summary;
+}
+
 std::string VDONinjaSource::buildViewerUrl() const
 {
 	return buildViewerPageUrl("https://vdo.ninja", settings_.streamId, settings_.password, settings_.roomId,
@@ -8,27 +8,43 @@
 #include <obs-module.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <functional>
+#include <mutex>
 #include <thread>
 #include <unordered_set>
 
 #include "vdoninja-alpha-sync.h"
+#include "vdoninja-audio-jitter.h"
+#include "vdoninja-audio-output.h"
+#include "vdoninja-audio-red.h"
 #include "vdoninja-common.h"
 #include "vdoninja-data-channel.h"
+#include "vdoninja-decode-budget.h"
+#include "vdoninja-decoder-threads.h"
 #include "vdoninja-peer-manager.h"
+#include "vdoninja-receive-trace.h"
+#include "vdoninja-relay.h"
 #include "vdoninja-reliability.h"
+#include "vdoninja-rtp-utils.h"
 #include "vdoninja-signaling.h"
+#include "vdoninja-thread-cpu.h"
+#include "vdoninja-utils.h"
+#include "vdoninja-video-scaler.h"
 
 extern "C" {
 struct AVBufferRef;
 struct AVCodecContext;
 struct AVFrame;
 struct AVPacket;
-struct SwsContext;
 struct SwrContext;
 }
 
+#if defined(VDONINJA_HAVE_LIBOPUS)
+struct OpusDecoder;
+#endif
+
 namespace vdoninja
 {
 
@@ -99,6 +115,9 @@ struct NativeMediaTestSnapshot {
 	int ambiguousSessionlessCleanups = 0;
 	int targetedPeerByes = 0;
 	int legacyStreamRemovalActions = 0;
+	ReceivePipelineSnapshot receivePipeline;
+	DecodeBudgetStats decodeBudget;
+	AudioJitterStats audioJitter;
 };
 
 struct NativeMediaTestTag {
@@ -138,6 +157,10 @@ public:
 	std::string getStreamId() const;
 	obs_source_t *obsSourceHandle() const;
 	obs_source_t *acquireActiveChildSource() const;
+	ReceivePipelineSnapshot receivePipelineSnapshot(bool resetInterval = false);
+	DecodeBudgetStats decodeBudgetStats(bool resetInterval = false);
+	AudioJitterStats audioJitterStats(bool resetInterval = false);
+	std::string receivePipelineSummary();
 
 #if defined(VDONINJA_NATIVE_MEDIA_INTEGRATION_TEST)
 	using NativeMediaTestStageHook =
@@ -161,6 +184,9 @@ public:
 	void feedNativeMediaTestVp9AccessUnit(bool alpha, const std::vector<uint8_t> &accessUnit, uint32_t rtpTimestamp);
 	void feedNativeMediaTestVp9Packet(bool alpha, const std::vector<uint8_t> &payload, uint32_t rtpTimestamp,
 	                                  bool startOfFrame, bool endOfFrame);
+	// Switches the primary track to H.264 and feeds one RTP packet.
+	void feedNativeMediaTestH264Packet(const std::vector<uint8_t> &payload, uint16_t sequence, uint32_t rtpTimestamp,
+	                                   bool marker);
 	void transitionNativeMediaTestPipeline(bool alphaActive, bool enableOutput = true);
 	void applyNativeMediaTestVideoSuppression(bool suppressed);
 	void applyNativeMediaTestVideoSuppressionUpdate(const ReceiverVideoSuppressionUpdate &update);
@@ -184,6 +210,9 @@ public:
 	bool nativeMediaTestCanAcquireVideoCommitState();
 	int nativeMediaTestRejectedTrackEventCount() const;
 	uint64_t nativeMediaTestEpoch() const;
+	// Starts the relay as connect() does, with its upstream keyframe requests
+	// going to the bound manager's video track.
+	VDONinjaRelay &startNativeMediaTestRelay(const std::string &relayStreamId, const std::string &wssHost);
 #endif
 
 private:
@@ -193,6 +222,10 @@ private:
 	void connect();
 	void disconnect();
 	void connectionThread();
+	void startRelay();
+	void startAudioPlayoutClock();
+	void stopAudioPlayoutClock();
+	void audioPlayoutThread();
 	void requestViewStream(const char *reason, bool resetRetryCount = false);
 	void scheduleViewRetry(const char *reason, int delayMs, bool resetRetryCount = false);
 	void cancelViewRetry();
@@ -203,6 +236,7 @@ private:
 	void sendViewerPreferencesToPeer(const PeerEventIdentity &identity, const char *reason);
 	void handlePeerDataChannelOpen(const PeerEventIdentity &identity, const std::shared_ptr<rtc::DataChannel> &dc);
 	void requestNativeTargetBitrate(const char *reason);
+	bool requestRelayKeyframe();
 	void handlePeerDataChannelMessage(const PeerEventIdentity &identity, const std::string &message);
 	void handlePeerControlState(const PeerEventIdentity &identity, const MuteStateUpdate *muteUpdate,
 	                            const ReceiverVideoSuppressionUpdate *videoUpdate);
@@ -245,9 +279,16 @@ private:
 	void processAlphaVP9RtpPacket(const uint8_t *payload, size_t payloadSize, uint32_t rtpTimestamp,
 	                              uint64_t mediaEpoch);
 	void processAudioRtpPacket(const uint8_t *packetData, size_t packetSize);
-	void processVideoData(const uint8_t *data, size_t size, uint32_t rtpTimestamp, uint64_t mediaEpoch);
+	// knownInfo, when given, is what the assembler already read from data.
+	void processVideoData(const uint8_t *data, size_t size, uint32_t rtpTimestamp, uint64_t mediaEpoch,
+	                      const EncodedVideoFrameInfo *knownInfo = nullptr);
 	void processAlphaVideoData(const uint8_t *data, size_t size, uint32_t rtpTimestamp, uint64_t mediaEpoch);
-	void processAudioData(const uint8_t *data, size_t size, uint32_t rtpTimestamp);
+	void pullAudioPlayoutLocked(int64_t nowUs);
+	void playoutAudioItemLocked(const AudioPlayoutItem &item);
+	void decodeAudioPacketLocked(const uint8_t *data, size_t size, uint32_t rtpTimestamp);
+#if defined(VDONINJA_HAVE_LIBOPUS)
+	bool decodeOpusLocked(const uint8_t *data, size_t size, uint32_t rtpTimestamp, int fecSamples);
+#endif
 	bool initializeVideoDecoder();
 	bool initializeAlphaDecoder();
 	bool initializeAudioDecoder(int sampleRate, int channels);
@@ -331,12 +372,21 @@ private:
 	std::atomic<bool> loggedAlphaDecodeSubmitFailure_{false};
 	std::atomic<bool> loggedAlphaDecodeReceiveFailure_{false};
 	std::thread connectionThread_;
+	// Pulls the audio jitter buffer on a clock, so buffered frames still play
+	// when packets stop arriving (DTX silence, stream end).
+	std::thread audioPlayoutThread_;
+	std::mutex audioPlayoutMutex_;
+	std::condition_variable audioPlayoutCv_;
+	bool audioPlayoutStop_ = false; // Guarded by audioPlayoutMutex_.
 	mutable std::mutex childSourceMutex_;
 	obs_source_t *browserSource_ = nullptr;
 	obs_source_t *nativeReceiverSource_ = nullptr;
 	std::string browserSourceName_;
 	std::string nativeReceiverSourceName_;
 	std::shared_ptr<AsyncCallbackState<VDONinjaSource>> callbackState_;
+	// Lives as long as the source so RTP callbacks can always reach it; does
+	// nothing while stopped.
+	VDONinjaRelay relay_;
 	std::shared_ptr<rtc::Track> videoTrack_;
 	std::shared_ptr<rtc::Track> alphaVideoTrack_;
 	std::shared_ptr<rtc::Track> audioTrack_;
@@ -412,11 +462,44 @@ private:
 	std::vector<uint8_t> videoAssemblyBuffer_;
 	uint32_t videoAssemblyTimestamp_ = 0;
 	bool videoAssemblyActive_ = false;
+	// H.264 packet order and loss tracking. Guarded by videoAssemblyMutex_.
+	RtpFrameReorderBuffer videoReorder_;
+	bool videoAssemblyDamaged_ = false;
+	bool videoAssemblyFragmentOpen_ = false;
+	// Deltas after a dropped access unit lost their reference; they are held
+	// back until an IDR, or a recovery point once an IDR has passed. Guarded
+	// by videoAssemblyMutex_.
+	bool videoAwaitingKeyframe_ = false;
+	bool videoPassedKeyframe_ = false;
 	AVCodecContext *videoDecoder_ = nullptr;
 	AVFrame *videoFrame_ = nullptr;
 	AVFrame *videoTransferFrame_ = nullptr;
 	AVPacket *videoPacket_ = nullptr;
-	SwsContext *videoScaleContext_ = nullptr;
+	VideoScaler videoScaler_;
+	// Reused per decoded frame. Guarded by videoOutputMutex_.
+	std::vector<uint8_t> videoOutputBuffer_;
+	std::vector<uint8_t> videoScaledAlphaY_;
+	AspectFitLayout videoOutputLayout_;
+	bool videoOutputHasAlpha_ = false;
+	std::atomic<int> videoScaleQuality_{static_cast<int>(VideoScaleQuality::Bilinear)};
+	ReceivePipelineTracer receiveTracer_;
+	// Baseline for the plugin thread CPU line in the receive stats.
+	ThreadCpuSampler threadCpuSampler_;
+	DecodeLatencyBudget videoDecodeBudget_; // Guarded by videoDecodeMutex_.
+	bool videoDecodeDegraded_ = false;      // Guarded by videoDecodeMutex_.
+	// Software decoder threads come from the process-wide budget and are
+	// rebalanced at keyframes. Guarded by videoDecodeMutex_ and
+	// alphaDecodeMutex_ respectively, like the decoders they size.
+	DecoderThreadLease videoDecoderThreads_;
+	DecoderFrameRateMeter videoFrameRateMeter_;
+	int videoDecodedWidth_ = 0;
+	int videoDecodedHeight_ = 0;
+	DecoderThreadLease alphaDecoderThreads_;
+	DecoderFrameRateMeter alphaFrameRateMeter_;
+	int alphaDecodedWidth_ = 0;
+	int alphaDecodedHeight_ = 0;
+	std::atomic<int> maxDecodeLatencyMs_{DEFAULT_MAX_DECODE_LATENCY_MS};
+	std::atomic<uint32_t> videoRtpSsrc_{0};
 	// Alpha channel VP9 decode state
 	std::atomic<bool> loggedFirstAlphaRtpPacket_{false};
 	std::vector<uint8_t> alphaAssemblyBuffer_;
@@ -431,8 +514,18 @@ private:
 	AVFrame *audioFrame_ = nullptr;
 	AVPacket *audioPacket_ = nullptr;
 	SwrContext *audioResampleContext_ = nullptr;
+	AudioPlaneBuffer audioConvertBuffer_; // Guarded by audioDecodeMutex_.
 	int audioSampleRate_ = 48000;
 	int audioChannels_ = 2;
+	AudioJitterBuffer audioJitterBuffer_;             // Guarded by audioDecodeMutex_.
+	std::vector<AudioPlayoutItem> audioPlayoutItems_; // Guarded by audioDecodeMutex_.
+	std::unordered_set<uint8_t> audioRedPayloadTypes_; // Guarded by audioDecodeMutex_.
+	std::vector<AudioRedBlock> audioRedBlocks_;        // Guarded by audioDecodeMutex_.
+#if defined(VDONINJA_HAVE_LIBOPUS)
+	// Preferred over audioDecoder_ when available: libopus exposes in-band FEC.
+	OpusDecoder *opusDecoder_ = nullptr;
+	AudioPlaneBuffer audioOpusOutputBuffer_; // Guarded by audioDecodeMutex_.
+#endif
 	int audioResampleInputFormat_ = -1;
 	int audioResampleInputRate_ = 0;
 	int audioResampleInputChannels_ = 0;
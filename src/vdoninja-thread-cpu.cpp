@@ -0,0 +1,317 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Per-thread CPU accounting for plugin worker threads
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-thread-cpu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fstream>
+#include <unistd.h>
+#endif
+
+namespace vdoninja
+{
+
+namespace
+{
+
+// Linux rejects thread names longer than 15 bytes plus the terminator.
+constexpr size_t kMaxThreadNameLength = 15;
+
+int64_t steadyTimeUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+struct ChargedCpuTimes {
+	std::mutex mutex;
+	std::map<std::string, uint64_t> totals;
+};
+
+ChargedCpuTimes &chargedCpuTimes()
+{
+	static ChargedCpuTimes charged;
+	return charged;
+}
+
+} // namespace
+
+void setCurrentThreadName(const char *name)
+{
+	if (!name || !*name) {
+		return;
+	}
+	char truncated[kMaxThreadNameLength + 1] = {};
+	std::strncpy(truncated, name, kMaxThreadNameLength);
+#ifdef _WIN32
+	// SetThreadDescription only exists from Windows 10 1607, so resolve it at
+	// run time rather than failing to load on older systems.
+	using SetThreadDescriptionFn = HRESULT(WINAPI *)(HANDLE, PCWSTR);
+	static const auto setDescription = reinterpret_cast<SetThreadDescriptionFn>(
+	    reinterpret_cast<void *>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription")));
+	if (!setDescription) {
+		return;
+	}
+	wchar_t wide[kMaxThreadNameLength + 1] = {};
+	for (size_t i = 0; i < kMaxThreadNameLength && truncated[i]; ++i) {
+		wide[i] = static_cast<wchar_t>(static_cast<unsigned char>(truncated[i]));
+	}
+	setDescription(GetCurrentThread(), wide);
+#elif defined(__APPLE__)
+	pthread_setname_np(truncated);
+#else
+	pthread_setname_np(pthread_self(), truncated);
+#endif
+}
+
+std::optional<uint64_t> currentThreadCpuTimeUs()
+{
+#ifdef _WIN32
+	FILETIME creationTime = {};
+	FILETIME exitTime = {};
+	FILETIME kernelTime = {};
+	FILETIME userTime = {};
+	if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+		return std::nullopt;
+	}
+	auto toUint64 = [](const FILETIME &time) {
+		ULARGE_INTEGER value;
+		value.LowPart = time.dwLowDateTime;
+		value.HighPart = time.dwHighDateTime;
+		return value.QuadPart;
+	};
+	// FILETIME counts 100 ns units.
+	return (toUint64(kernelTime) + toUint64(userTime)) / 10;
+#else
+	timespec time = {};
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+		return std::nullopt;
+	}
+	return static_cast<uint64_t>(time.tv_sec) * 1000000ULL + static_cast<uint64_t>(time.tv_nsec) / 1000ULL;
+#endif
+}
+
+void chargeThreadCpuTime(const char *subsystem, uint64_t cpuUs)
+{
+	if (!subsystem || cpuUs == 0) {
+		return;
+	}
+	ChargedCpuTimes &charged = chargedCpuTimes();
+	std::lock_guard<std::mutex> lock(charged.mutex);
+	charged.totals[subsystem] += cpuUs;
+}
+
+std::map<std::string, uint64_t> chargedThreadCpuTimes()
+{
+	ChargedCpuTimes &charged = chargedCpuTimes();
+	std::lock_guard<std::mutex> lock(charged.mutex);
+	return charged.totals;
+}
+
+ThreadCpuCharge::ThreadCpuCharge(const char *subsystem) : subsystem_(subsystem), startUs_(currentThreadCpuTimeUs()) {}
+
+ThreadCpuCharge::~ThreadCpuCharge()
+{
+	if (!startUs_) {
+		return;
+	}
+	const std::optional<uint64_t> endUs = currentThreadCpuTimeUs();
+	if (endUs && *endUs > *startUs_) {
+		chargeThreadCpuTime(subsystem_, *endUs - *startUs_);
+	}
+}
+
+bool parseProcTaskStat(const std::string &line, std::string &name, uint64_t &userTicks, uint64_t &systemTicks)
+{
+	const size_t open = line.find('(');
+	const size_t close = line.rfind(')');
+	if (open == std::string::npos || close == std::string::npos || close < open) {
+		return false;
+	}
+
+	// Fields after the name start at field 3 (state); utime and stime are
+	// fields 14 and 15.
+	std::istringstream fields(line.substr(close + 1));
+	std::string field;
+	for (int index = 3; index < 14; ++index) {
+		if (!(fields >> field)) {
+			return false;
+		}
+	}
+	uint64_t user = 0;
+	uint64_t system = 0;
+	if (!(fields >> user >> system)) {
+		return false;
+	}
+
+	name = line.substr(open + 1, close - open - 1);
+	userTicks = user;
+	systemTicks = system;
+	return true;
+}
+
+std::vector<ThreadCpuTimes> readProcessThreadCpuTimes()
+{
+	std::vector<ThreadCpuTimes> threads;
+#if defined(__linux__)
+	const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+	if (ticksPerSecond <= 0) {
+		return threads;
+	}
+
+	DIR *tasks = opendir("/proc/self/task");
+	if (!tasks) {
+		return threads;
+	}
+	while (const dirent *entry = readdir(tasks)) {
+		char *end = nullptr;
+		const unsigned long long threadId = std::strtoull(entry->d_name, &end, 10);
+		if (!end || *end != '\0' || end == entry->d_name) {
+			continue;
+		}
+
+		std::ifstream stat(std::string("/proc/self/task/") + entry->d_name + "/stat");
+		std::string line;
+		std::string name;
+		uint64_t userTicks = 0;
+		uint64_t systemTicks = 0;
+		if (!std::getline(stat, line) || !parseProcTaskStat(line, name, userTicks, systemTicks)) {
+			// The thread exited between listing and reading.
+			continue;
+		}
+
+		ThreadCpuTimes times;
+		times.threadId = threadId;
+		times.name = std::move(name);
+		times.cpuUs = (userTicks + systemTicks) * 1000000ULL / static_cast<uint64_t>(ticksPerSecond);
+		threads.push_back(std::move(times));
+	}
+	closedir(tasks);
+#endif
+	return threads;
+}
+
+std::string threadCpuSubsystem(const std::string &threadName)
+{
+	const size_t prefixLength = std::strlen(kPluginThreadNamePrefix);
+	if (threadName.size() <= prefixLength || threadName.compare(0, prefixLength, kPluginThreadNamePrefix) != 0) {
+		return {};
+	}
+	return threadName.substr(prefixLength);
+}
+
+std::string formatSubsystemCpuUsage(const std::vector<SubsystemCpuUsage> &usage)
+{
+	std::string text;
+	char entry[96];
+	for (const SubsystemCpuUsage &subsystem : usage) {
+		if (subsystem.threads > 1) {
+			std::snprintf(entry, sizeof(entry), "%s %.1f%% (%d threads)", subsystem.subsystem.c_str(),
+			              subsystem.percent, subsystem.threads);
+		} else {
+			std::snprintf(entry, sizeof(entry), "%s %.1f%%", subsystem.subsystem.c_str(), subsystem.percent);
+		}
+		if (!text.empty()) {
+			text += ", ";
+		}
+		text += entry;
+	}
+	return text;
+}
+
+std::vector<SubsystemCpuUsage> ThreadCpuSampler::sample(int64_t nowUs, const std::vector<ThreadCpuTimes> &threads,
+                                                        const std::map<std::string, uint64_t> &charged)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::map<uint64_t, ThreadCpuTimes> currentThreads;
+	for (const ThreadCpuTimes &thread : threads) {
+		if (!threadCpuSubsystem(thread.name).empty()) {
+			currentThreads[thread.threadId] = thread;
+		}
+	}
+
+	std::vector<SubsystemCpuUsage> usage;
+	const int64_t elapsedUs = nowUs - previousUs_;
+	if (hasPrevious_ && elapsedUs > 0) {
+		std::map<std::string, SubsystemCpuUsage> bySubsystem;
+		for (const auto &entry : currentThreads) {
+			const auto previous = previousThreads_.find(entry.first);
+			// A reused thread id under a new name is a new thread.
+			if (previous == previousThreads_.end() || previous->second.name != entry.second.name ||
+			    entry.second.cpuUs < previous->second.cpuUs) {
+				continue;
+			}
+			const std::string subsystem = threadCpuSubsystem(entry.second.name);
+			SubsystemCpuUsage &total = bySubsystem[subsystem];
+			total.subsystem = subsystem;
+			total.percent += static_cast<double>(entry.second.cpuUs - previous->second.cpuUs);
+			total.threads++;
+		}
+		for (const auto &entry : charged) {
+			const auto previous = previousCharged_.find(entry.first);
+			const uint64_t before = previous != previousCharged_.end() ? previous->second : 0;
+			if (entry.second <= before) {
+				continue;
+			}
+			SubsystemCpuUsage &total = bySubsystem[entry.first];
+			total.subsystem = entry.first;
+			total.percent += static_cast<double>(entry.second - before);
+		}
+
+		for (auto &entry : bySubsystem) {
+			entry.second.percent = entry.second.percent * 100.0 / static_cast<double>(elapsedUs);
+			usage.push_back(std::move(entry.second));
+		}
+		std::sort(usage.begin(), usage.end(), [](const SubsystemCpuUsage &a, const SubsystemCpuUsage &b) {
+			return a.percent != b.percent ? a.percent > b.percent : a.subsystem < b.subsystem;
+		});
+	}
+
+	hasPrevious_ = true;
+	previousUs_ = nowUs;
+	previousThreads_ = std::move(currentThreads);
+	previousCharged_ = charged;
+	return usage;
+}
+
+std::vector<SubsystemCpuUsage> ThreadCpuSampler::query()
+{
+	return sample(steadyTimeUs(), readProcessThreadCpuTimes(), chargedThreadCpuTimes());
+}
+
+void ThreadCpuSampler::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	hasPrevious_ = false;
+	previousUs_ = 0;
+	previousThreads_.clear();
+	previousCharged_.clear();
+}
+
+} // namespace vdoninja
@@ -0,0 +1,99 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Per-thread CPU accounting for plugin worker threads
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vdoninja
+{
+
+// Every plugin-owned thread is named "vdo-<subsystem>" so the sampler can
+// attribute its CPU time. Linux truncates names to 15 characters.
+constexpr const char *kPluginThreadNamePrefix = "vdo-";
+
+// Names the calling thread. Best effort; a failure only loses attribution.
+void setCurrentThreadName(const char *name);
+
+// CPU time the calling thread has consumed so far.
+std::optional<uint64_t> currentThreadCpuTimeUs();
+
+// Work that runs on threads the plugin does not own (libdatachannel track
+// callbacks decode native video and audio) is charged by wrapping it in a
+// ThreadCpuCharge, which adds the calling thread's CPU time for the scope to
+// a process-wide total for the subsystem.
+void chargeThreadCpuTime(const char *subsystem, uint64_t cpuUs);
+std::map<std::string, uint64_t> chargedThreadCpuTimes();
+
+class ThreadCpuCharge
+{
+public:
+	explicit ThreadCpuCharge(const char *subsystem);
+	~ThreadCpuCharge();
+
+	ThreadCpuCharge(const ThreadCpuCharge &) = delete;
+	ThreadCpuCharge &operator=(const ThreadCpuCharge &) = delete;
+
+private:
+	const char *subsystem_;
+	std::optional<uint64_t> startUs_;
+};
+
+struct ThreadCpuTimes {
+	uint64_t threadId = 0;
+	std::string name;
+	uint64_t cpuUs = 0;
+};
+
+// Parses one /proc/<pid>/task/<tid>/stat line. The thread name sits in
+// parentheses and may itself contain spaces or parentheses.
+bool parseProcTaskStat(const std::string &line, std::string &name, uint64_t &userTicks, uint64_t &systemTicks);
+
+// Lifetime CPU times of every thread in this process. Empty where the
+// platform offers no per-thread listing (only Linux does today).
+std::vector<ThreadCpuTimes> readProcessThreadCpuTimes();
+
+// "vdo-pacer" -> "pacer"; empty for threads the plugin does not own.
+std::string threadCpuSubsystem(const std::string &threadName);
+
+struct SubsystemCpuUsage {
+	std::string subsystem;
+	// Share of one core over the sampled interval.
+	double percent = 0.0;
+	// Named threads seen in the interval; 0 for charged work.
+	int threads = 0;
+};
+
+// "pacer 12.5% (3 threads), send 4.0%, decode 20.1%"; empty for no usage.
+std::string formatSubsystemCpuUsage(const std::vector<SubsystemCpuUsage> &usage);
+
+// Turns successive thread and charge readings into per-subsystem CPU
+// shares. Threads first seen in an interval contribute from their next
+// reading, and threads that exit between readings drop out.
+class ThreadCpuSampler
+{
+public:
+	// Empty on the first call and whenever no wall time elapsed.
+	std::vector<SubsystemCpuUsage> sample(int64_t nowUs, const std::vector<ThreadCpuTimes> &threads,
+	                                      const std::map<std::string, uint64_t> &charged);
+	// Reads this process's threads and charges at the current time.
+	std::vector<SubsystemCpuUsage> query();
+	void reset();
+
+private:
+	std::mutex mutex_;
+	bool hasPrevious_ = false;
+	int64_t previousUs_ = 0;
+	std::map<uint64_t, ThreadCpuTimes> previousThreads_;
+	std::map<std::string, uint64_t> previousCharged_;
+};
+
+} // namespace vdoninja
@@ -183,41 +183,6 @@ std::string asciiLowerCopy(std::string value)
 	return value;
 }
 
-std::vector<std::string> splitWhitespace(const std::string &value)
-{
-	std::vector<std::string> tokens;
-	std::istringstream input(value);
-	std::string token;
-	while (input >> token) {
-		tokens.push_back(token);
-	}
-	return tokens;
-}
-
-int parseIntOrDefault(const std::string &value, int defaultValue = -1)
-{
-	try {
-		return std::stoi(value);
-	} catch (...) {
-		return defaultValue;
-	}
-}
-
-bool containsPayloadType(const std::vector<int> &payloadTypes, int payloadType)
-{
-	return std::find(payloadTypes.begin(), payloadTypes.end(), payloadType) != payloadTypes.end();
-}
-
-SdpOfferedCodec *findCodecByPayloadType(std::vector<SdpOfferedCodec> &codecs, int payloadType)
-{
-	for (auto &codec : codecs) {
-		if (codec.payloadType == payloadType) {
-			return &codec;
-		}
-	}
-	return nullptr;
-}
-
 bool containsInsensitive(const std::string &value, const char *needle)
 {
 	return asciiLowerCopy(value).find(asciiLowerCopy(needle)) != std::string::npos;
@@ -540,6 +505,15 @@ std::string buildInboundViewUrl(const std::string &baseUrl, const std::string &s
 	return buildViewerPageUrl(normalizedBaseUrl, normalizedStreamId, password, roomId, salt, wssHost);
 }
 
+std::string nativeInboundStreamId(const std::string &target)
+{
+	const std::string normalized = normalizeInboundPlaybackTarget(trim(target));
+	if (normalized.empty() || isDirectPlaybackUrl(normalized)) {
+		return "";
+	}
+	return normalized;
+}
+
 int chooseViewerTargetBitrateKbps(uint32_t width, uint32_t height)
 {
 	if (width >= 3840 || height >= 2160) {
@@ -1471,186 +1445,25 @@ std::string modifySdpForCodec(const std::string &sdp, VideoCodec codec)
 std::string modifySdpBitrate(const std::string &sdp, int bitrate)
 {
 	// Add b=AS line for bandwidth limiting
-	std::string result = sdp;
-	std::string bLine = "b=AS:" + std::to_string(bitrate / 1000) + "\r\n";
-
-	// Find m=video line and add bandwidth after it
-	size_t videoPos = result.find("m=video");
-	if (videoPos != std::string::npos) {
-		size_t lineEnd = result.find("\r\n", videoPos);
-		if (lineEnd != std::string::npos) {
-			result.insert(lineEnd + 2, bLine);
-		}
-	}
-
-	return result;
+	SdpDocument document(sdp);
+	document.insertAfterMediaLine("video", "b=AS:" + std::to_string(bitrate / 1000));
+	return document.serialize();
 }
 
 std::string extractMid(const std::string &sdp, const std::string &mediaType)
 {
-	std::string searchStr = "m=" + mediaType;
-	size_t pos = sdp.find(searchStr);
-	if (pos == std::string::npos)
-		return "";
-
-	// Find a=mid: line after this
-	pos = sdp.find("a=mid:", pos);
-	if (pos == std::string::npos)
-		return "";
-
-	pos += 6; // Skip "a=mid:"
-	size_t end = sdp.find_first_of("\r\n", pos);
-	if (end == std::string::npos)
-		return "";
-
-	return sdp.substr(pos, end - pos);
+	return SdpDocument(sdp).mid(mediaType);
 }
 
 std::string stripUnsupportedTransportCcFeedback(const std::string &sdp)
 {
-	std::stringstream input(sdp);
-	std::string line;
-	std::string filtered;
-	bool stripped = false;
-
-	while (std::getline(input, line)) {
-		if (!line.empty() && line.back() == '\r') {
-			line.pop_back();
-		}
-		if (line.find("transport-wide-cc-extensions-01") != std::string::npos) {
-			stripped = true;
-			continue;
-		}
-		if (line.rfind("a=rtcp-fb:", 0) == 0 && line.find("transport-cc") != std::string::npos) {
-			stripped = true;
-			continue;
-		}
-		filtered += line + "\r\n";
-	}
-
-	return stripped ? filtered : sdp;
+	SdpDocument document(sdp);
+	return stripUnsupportedTransportCcFeedback(document) ? document.serialize() : sdp;
 }
 
 std::vector<SdpOfferedMediaSection> parseOfferedMediaSections(const std::string &sdp)
 {
-	std::vector<SdpOfferedMediaSection> sections;
-	SdpOfferedMediaSection *current = nullptr;
-
-	std::stringstream input(sdp);
-	std::string line;
-	while (std::getline(input, line)) {
-		if (!line.empty() && line.back() == '\r') {
-			line.pop_back();
-		}
-
-		if (line.rfind("m=", 0) == 0) {
-			const auto tokens = splitWhitespace(line.substr(2));
-			if (tokens.empty()) {
-				current = nullptr;
-				continue;
-			}
-
-			const std::string mediaType = asciiLowerCopy(tokens[0]);
-			if (mediaType != "audio" && mediaType != "video") {
-				current = nullptr;
-				continue;
-			}
-
-			sections.push_back({});
-			current = &sections.back();
-			current->type = mediaType;
-			if (tokens.size() > 1) {
-				current->port = parseIntOrDefault(tokens[1], -1);
-			}
-			for (size_t i = 3; i < tokens.size(); ++i) {
-				const int payloadType = parseIntOrDefault(tokens[i]);
-				if (payloadType >= 0) {
-					current->payloadTypes.push_back(payloadType);
-				}
-			}
-			continue;
-		}
-
-		if (!current) {
-			continue;
-		}
-
-		if (line.rfind("a=mid:", 0) == 0) {
-			current->mid = trim(line.substr(6));
-			continue;
-		}
-
-		if (line == "a=sendrecv" || line == "a=sendonly" || line == "a=recvonly" || line == "a=inactive") {
-			current->direction = line.substr(2);
-			continue;
-		}
-
-		if (line.rfind("a=rtpmap:", 0) == 0) {
-			const size_t separator = line.find(' ');
-			if (separator == std::string::npos) {
-				continue;
-			}
-
-			const int payloadType = parseIntOrDefault(line.substr(9, separator - 9));
-			if (payloadType < 0 || !containsPayloadType(current->payloadTypes, payloadType)) {
-				continue;
-			}
-
-			SdpOfferedCodec *codec = findCodecByPayloadType(current->codecs, payloadType);
-			if (!codec) {
-				current->codecs.push_back({});
-				codec = &current->codecs.back();
-				codec->payloadType = payloadType;
-			}
-
-			const auto descriptorParts = split(line.substr(separator + 1), '/');
-			if (!descriptorParts.empty()) {
-				codec->codec = descriptorParts[0];
-			}
-			if (descriptorParts.size() > 1) {
-				codec->clockRate = parseIntOrDefault(descriptorParts[1], 0);
-			}
-			if (descriptorParts.size() > 2) {
-				codec->channels = parseIntOrDefault(descriptorParts[2], 0);
-			}
-			continue;
-		}
-
-		if (line.rfind("a=fmtp:", 0) == 0) {
-			const size_t separator = line.find(' ');
-			if (separator == std::string::npos) {
-				continue;
-			}
-
-			const int payloadType = parseIntOrDefault(line.substr(7, separator - 7));
-			if (payloadType < 0 || !containsPayloadType(current->payloadTypes, payloadType)) {
-				continue;
-			}
-
-			SdpOfferedCodec *codec = findCodecByPayloadType(current->codecs, payloadType);
-			if (!codec) {
-				current->codecs.push_back({});
-				codec = &current->codecs.back();
-				codec->payloadType = payloadType;
-			}
-
-			codec->formatParameters = trim(line.substr(separator + 1));
-			const std::string fmtpLower = asciiLowerCopy(codec->formatParameters);
-			const size_t aptPos = fmtpLower.find("apt=");
-			if (aptPos != std::string::npos) {
-				size_t valueStart = aptPos + 4;
-				size_t valueEnd = valueStart;
-				while (valueEnd < codec->formatParameters.size() &&
-				       std::isdigit(static_cast<unsigned char>(codec->formatParameters[valueEnd]))) {
-					++valueEnd;
-				}
-				codec->associatedPayloadType =
-				    parseIntOrDefault(codec->formatParameters.substr(valueStart, valueEnd - valueStart));
-			}
-		}
-	}
-
-	return sections;
+	return SdpDocument(sdp).offeredMediaSections();
 }
 
 bool offeredMediaSectionCanSend(const SdpOfferedMediaSection &section)
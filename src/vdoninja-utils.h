@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "vdoninja-common.h"
+#include "vdoninja-sdp.h"
 
 namespace vdoninja
 {
@@ -24,24 +25,6 @@ struct AspectFitLayout {
 	uint32_t offsetY = 0;
 };
 
-struct SdpOfferedCodec {
-	int payloadType = -1;
-	std::string codec;
-	int clockRate = 0;
-	int channels = 0;
-	std::string formatParameters;
-	int associatedPayloadType = -1;
-};
-
-struct SdpOfferedMediaSection {
-	std::string type;
-	std::string mid;
-	int port = -1;
-	std::string direction = "sendrecv";
-	std::vector<int> payloadTypes;
-	std::vector<SdpOfferedCodec> codecs;
-};
-
 // UUID generation
 std::string generateUUID();
 
@@ -58,6 +41,9 @@ std::string buildViewerPageUrl(const std::string &baseUrl, const std::string &st
                                const std::string &roomId, const std::string &salt, const std::string &wssHost = "");
 std::string buildInboundViewUrl(const std::string &baseUrl, const std::string &streamId, const std::string &password,
                                 const std::string &roomId, const std::string &salt, const std::string &wssHost = "");
+// Stream ID the native receiver should view for an auto-inbound target, or
+// empty when the target is a playback URL that only a browser source can play.
+std::string nativeInboundStreamId(const std::string &target);
 int chooseViewerTargetBitrateKbps(uint32_t width, uint32_t height);
 uint32_t normalizeSourceDimension(int64_t value, uint32_t fallback, uint32_t minValue, uint32_t maxValue);
 int normalizeOpusSampleRate(int sampleRate);
@@ -84,6 +70,8 @@ public:
 	JsonBuilder &add(const std::string &key, bool value);
 	JsonBuilder &addRaw(const std::string &key, const std::string &rawJson);
 	std::string build() const;
+	// Keys with their serialized values, in insertion order.
+	const std::vector<std::pair<std::string, std::string>> &entries() const { return entries_; }
 
 private:
 	std::vector<std::pair<std::string, std::string>> entries_;
@@ -156,7 +144,8 @@ std::vector<std::string> buildCaCertificateCandidatePaths(const std::string &ssl
 int64_t currentTimeMs();
 std::string formatTimestamp(int64_t ms);
 
-// SDP manipulation utilities
+// SDP manipulation utilities. Each parses the description once; callers
+// applying several rules should build one SdpDocument instead.
 std::string modifySdpForCodec(const std::string &sdp, VideoCodec codec);
 std::string modifySdpBitrate(const std::string &sdp, int bitrate);
 std::string extractMid(const std::string &sdp, const std::string &mediaType);
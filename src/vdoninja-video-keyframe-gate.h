@@ -36,6 +36,26 @@ public:
 		return keyframe || !awaitingKeyframe_ || pendingLiveKeyframes_ > 0;
 	}
 
+	// Whether a live frame can re-establish the prediction chain. Besides an
+	// IDR, that is a gradual intra refresh recovery point, which only a
+	// decoder that has already started on an IDR can resume from: after a
+	// completed keyframe, or behind a queued cached prime. A new decoder still
+	// needs its one IDR first.
+	bool isEntryPoint(bool keyframe, bool recoveryPoint) const noexcept
+	{
+		return keyframe || (recoveryPoint && awaitingKeyframe_ && pendingLiveKeyframes_ == 0 &&
+		                    (decoderStarted_ || pendingKeyframes_ > 0));
+	}
+
+	// A replay of the whole current GOP ends on the newest live frame, so its
+	// keyframe is queued as a live one and re-establishes the prediction chain.
+	// Like the cached startup keyframe, it is only offered before the peer
+	// first synchronizes.
+	bool canReplayCachedGop() const noexcept
+	{
+		return awaitingKeyframe_ && cachedPrimeAllowed_ && pendingKeyframes_ == 0;
+	}
+
 	KeyframeTicket onKeyframeQueued(bool cachedReplay = false) noexcept
 	{
 		cachedPrimeAllowed_ = false;
@@ -72,6 +92,7 @@ public:
 			return false;
 		}
 
+		decoderStarted_ = true;
 		if (cachedReplay) {
 			// The cached IDR predates the current live frame. It is useful for
 			// initial paint, but deltas must remain blocked until a live IDR
@@ -114,6 +135,7 @@ public:
 		advanceGeneration();
 		awaitingKeyframe_ = true;
 		cachedPrimeAllowed_ = true;
+		decoderStarted_ = false;
 	}
 
 	// allowPendingKeyframe is appropriate after a transport failure when a newer
@@ -147,6 +169,7 @@ private:
 
 	bool awaitingKeyframe_ = true;
 	bool cachedPrimeAllowed_ = true;
+	bool decoderStarted_ = false;
 	KeyframeTicket generation_ = 1;
 	KeyframeTicket pendingGeneration_ = 1;
 	size_t pendingKeyframes_ = 0;
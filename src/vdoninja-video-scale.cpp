@@ -0,0 +1,87 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Native receive color conversion policy: scaler quality and threading
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-video-scale.h"
+
+#include <algorithm>
+
+namespace vdoninja
+{
+
+namespace
+{
+
+constexpr int64_t kSingleThreadMaxPixels = 1280LL * 720LL;
+constexpr int64_t kTwoThreadMaxPixels = 1920LL * 1080LL;
+constexpr int kMaxScaleThreads = 4;
+
+} // namespace
+
+VideoScaleQuality parseVideoScaleQuality(const std::string &value)
+{
+	if (value == "fast") {
+		return VideoScaleQuality::Fast;
+	}
+	if (value == "bicubic") {
+		return VideoScaleQuality::Bicubic;
+	}
+	if (value == "lanczos") {
+		return VideoScaleQuality::Lanczos;
+	}
+	return VideoScaleQuality::Bilinear;
+}
+
+const char *videoScaleQualityName(VideoScaleQuality quality)
+{
+	switch (quality) {
+	case VideoScaleQuality::Fast:
+		return "fast";
+	case VideoScaleQuality::Bicubic:
+		return "bicubic";
+	case VideoScaleQuality::Lanczos:
+		return "lanczos";
+	case VideoScaleQuality::Bilinear:
+		break;
+	}
+	return "bilinear";
+}
+
+VideoScaleFilter selectVideoScaleFilter(VideoScaleQuality quality, int srcWidth, int srcHeight, int dstWidth,
+                                        int dstHeight)
+{
+	if (srcWidth == dstWidth && srcHeight == dstHeight) {
+		// No resampling of luma; the filter only shapes chroma upsampling.
+		return quality == VideoScaleQuality::Fast ? VideoScaleFilter::Point : VideoScaleFilter::FastBilinear;
+	}
+
+	switch (quality) {
+	case VideoScaleQuality::Fast:
+		return VideoScaleFilter::FastBilinear;
+	case VideoScaleQuality::Bicubic:
+		return VideoScaleFilter::Bicubic;
+	case VideoScaleQuality::Lanczos:
+		return VideoScaleFilter::Lanczos;
+	case VideoScaleQuality::Bilinear:
+		break;
+	}
+	return VideoScaleFilter::Bilinear;
+}
+
+int videoScaleThreadCount(int srcWidth, int srcHeight, int dstWidth, int dstHeight, unsigned hardwareThreads)
+{
+	const int64_t pixels = std::max(static_cast<int64_t>(std::max(srcWidth, 0)) * std::max(srcHeight, 0),
+	                                static_cast<int64_t>(std::max(dstWidth, 0)) * std::max(dstHeight, 0));
+	int threads = kMaxScaleThreads;
+	if (pixels <= kSingleThreadMaxPixels) {
+		threads = 1;
+	} else if (pixels <= kTwoThreadMaxPixels) {
+		threads = 2;
+	}
+	const int available = std::max(1, static_cast<int>(hardwareThreads / 2));
+	return std::min(threads, available);
+}
+
+} // namespace vdoninja
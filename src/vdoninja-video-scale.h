@@ -0,0 +1,67 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Native receive color conversion policy: scaler quality and threading
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vdoninja
+{
+
+// User-facing per-source scaler quality. Only matters when the decoded size
+// differs from the source canvas; same-size frames are a pure pixel format
+// conversion and always take the cheapest filter.
+enum class VideoScaleQuality {
+	Fast,
+	Bilinear,
+	Bicubic,
+	Lanczos,
+};
+
+enum class VideoScaleFilter {
+	Point,
+	FastBilinear,
+	Bilinear,
+	Bicubic,
+	Lanczos,
+};
+
+constexpr const char *kDefaultVideoScaleQuality = "bilinear";
+
+VideoScaleQuality parseVideoScaleQuality(const std::string &value);
+const char *videoScaleQualityName(VideoScaleQuality quality);
+
+VideoScaleFilter selectVideoScaleFilter(VideoScaleQuality quality, int srcWidth, int srcHeight, int dstWidth,
+                                        int dstHeight);
+
+// Worker threads for one conversion. Small frames stay single-threaded because
+// slice dispatch costs more than it saves; large frames use up to four bands
+// but never more than half the machine so decode and OBS keep their cores.
+int videoScaleThreadCount(int srcWidth, int srcHeight, int dstWidth, int dstHeight, unsigned hardwareThreads);
+
+// Everything a conversion context is built from. The context is only rebuilt
+// when one of these changes.
+struct VideoScaleKey {
+	int srcWidth = 0;
+	int srcHeight = 0;
+	int srcFormat = -1;
+	int dstWidth = 0;
+	int dstHeight = 0;
+	int dstFormat = -1;
+	VideoScaleFilter filter = VideoScaleFilter::Bilinear;
+	int threads = 1;
+
+	bool operator==(const VideoScaleKey &other) const
+	{
+		return srcWidth == other.srcWidth && srcHeight == other.srcHeight && srcFormat == other.srcFormat &&
+		       dstWidth == other.dstWidth && dstHeight == other.dstHeight && dstFormat == other.dstFormat &&
+		       filter == other.filter && threads == other.threads;
+	}
+	bool operator!=(const VideoScaleKey &other) const { return !(*this == other); }
+};
+
+} // namespace vdoninja
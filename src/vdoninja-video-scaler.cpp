@@ -0,0 +1,167 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Cached, slice-threaded swscale conversion for decoded native video
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-video-scaler.h"
+
+#include <thread>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+// Slice threading ("threads" option plus sws_scale_frame) arrived in FFmpeg 5.0.
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+#define VDONINJA_SWSCALE_SLICE_THREADS 1
+#else
+#define VDONINJA_SWSCALE_SLICE_THREADS 0
+#endif
+
+namespace vdoninja
+{
+
+namespace
+{
+
+int swsFlagsForFilter(VideoScaleFilter filter)
+{
+	switch (filter) {
+	case VideoScaleFilter::Point:
+		return SWS_POINT;
+	case VideoScaleFilter::FastBilinear:
+		return SWS_FAST_BILINEAR;
+	case VideoScaleFilter::Bicubic:
+		return SWS_BICUBIC;
+	case VideoScaleFilter::Lanczos:
+		return SWS_LANCZOS;
+	case VideoScaleFilter::Bilinear:
+		break;
+	}
+	return SWS_BILINEAR;
+}
+
+#if VDONINJA_SWSCALE_SLICE_THREADS
+void keepCallerBuffer(void *, uint8_t *) {}
+#endif
+
+} // namespace
+
+VideoScaler::~VideoScaler()
+{
+	reset();
+}
+
+void VideoScaler::reset()
+{
+	if (context_) {
+		sws_freeContext(context_);
+		context_ = nullptr;
+	}
+	if (dstFrame_) {
+		av_frame_free(&dstFrame_);
+	}
+	hasKey_ = false;
+}
+
+bool VideoScaler::ensureContext(const VideoScaleKey &key)
+{
+	if (context_ && hasKey_ && key_ == key) {
+		return true;
+	}
+	if (context_) {
+		sws_freeContext(context_);
+		context_ = nullptr;
+	}
+	hasKey_ = false;
+
+	SwsContext *context = sws_alloc_context();
+	if (!context) {
+		return false;
+	}
+	av_opt_set_int(context, "srcw", key.srcWidth, 0);
+	av_opt_set_int(context, "srch", key.srcHeight, 0);
+	av_opt_set_int(context, "src_format", key.srcFormat, 0);
+	av_opt_set_int(context, "dstw", key.dstWidth, 0);
+	av_opt_set_int(context, "dsth", key.dstHeight, 0);
+	av_opt_set_int(context, "dst_format", key.dstFormat, 0);
+	av_opt_set_int(context, "sws_flags", swsFlagsForFilter(key.filter), 0);
+#if VDONINJA_SWSCALE_SLICE_THREADS
+	av_opt_set_int(context, "threads", key.threads, 0);
+#endif
+	if (sws_init_context(context, nullptr, nullptr) < 0) {
+		sws_freeContext(context);
+		return false;
+	}
+
+	context_ = context;
+	key_ = key;
+	hasKey_ = true;
+	++rebuilds_;
+	return true;
+}
+
+bool VideoScaler::convert(const AVFrame *src, uint8_t *dst, int dstStride, int dstWidth, int dstHeight,
+                          int dstFormat, VideoScaleQuality quality)
+{
+	if (!src || !dst || src->width <= 0 || src->height <= 0 || dstWidth <= 0 || dstHeight <= 0 || dstStride <= 0) {
+		return false;
+	}
+
+	VideoScaleKey key;
+	key.srcWidth = src->width;
+	key.srcHeight = src->height;
+	key.srcFormat = src->format;
+	key.dstWidth = dstWidth;
+	key.dstHeight = dstHeight;
+	key.dstFormat = dstFormat;
+	key.filter = selectVideoScaleFilter(quality, src->width, src->height, dstWidth, dstHeight);
+#if VDONINJA_SWSCALE_SLICE_THREADS
+	key.threads = videoScaleThreadCount(src->width, src->height, dstWidth, dstHeight,
+	                                    std::thread::hardware_concurrency());
+	if (maxThreads_ > 0 && key.threads > maxThreads_) {
+		key.threads = maxThreads_;
+	}
+#endif
+	if (!ensureContext(key)) {
+		return false;
+	}
+
+#if VDONINJA_SWSCALE_SLICE_THREADS
+	if (key.threads > 1) {
+		if (!dstFrame_) {
+			dstFrame_ = av_frame_alloc();
+			if (!dstFrame_) {
+				return false;
+			}
+		}
+		// Wrap the caller's buffer so sws_scale_frame() writes in place
+		// instead of allocating its own destination.
+		AVBufferRef *buffer = av_buffer_create(dst, static_cast<size_t>(dstStride) * static_cast<size_t>(dstHeight),
+		                                       keepCallerBuffer, nullptr, 0);
+		if (!buffer) {
+			return false;
+		}
+		dstFrame_->buf[0] = buffer;
+		dstFrame_->data[0] = dst;
+		dstFrame_->linesize[0] = dstStride;
+		dstFrame_->width = dstWidth;
+		dstFrame_->height = dstHeight;
+		dstFrame_->format = dstFormat;
+		const int result = sws_scale_frame(context_, dstFrame_, src);
+		av_frame_unref(dstFrame_);
+		return result >= 0;
+	}
+#endif
+
+	uint8_t *dstData[4] = {dst, nullptr, nullptr, nullptr};
+	int dstLinesize[4] = {dstStride, 0, 0, 0};
+	const int rows = sws_scale(context_, src->data, src->linesize, 0, src->height, dstData, dstLinesize);
+	return rows == dstHeight;
+}
+
+} // namespace vdoninja
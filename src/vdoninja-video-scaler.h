@@ -0,0 +1,59 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Cached, slice-threaded swscale conversion for decoded native video
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "vdoninja-video-scale.h"
+
+extern "C" {
+struct AVFrame;
+struct SwsContext;
+}
+
+namespace vdoninja
+{
+
+// Owns one swscale context and rebuilds it only when the VideoScaleKey
+// changes. With FFmpeg 5.0+ the context is created with slice threads and
+// frames go through sws_scale_frame(), which splits the output into
+// horizontal bands across the context's worker pool. Older FFmpeg falls back
+// to single-threaded sws_scale(). Not thread-safe; callers serialize.
+class VideoScaler
+{
+public:
+	VideoScaler() = default;
+	~VideoScaler();
+	VideoScaler(const VideoScaler &) = delete;
+	VideoScaler &operator=(const VideoScaler &) = delete;
+
+	// Converts all of src into a dstWidth x dstHeight region starting at dst.
+	// dstFormat is an AVPixelFormat. Returns false if the context could not
+	// be built or the conversion did not produce every output row. Only packed
+	// (single-plane) destination formats such as BGRA are supported.
+	bool convert(const AVFrame *src, uint8_t *dst, int dstStride, int dstWidth, int dstHeight, int dstFormat,
+	             VideoScaleQuality quality);
+	void reset();
+
+	// Caps the automatic thread choice; 0 leaves it to videoScaleThreadCount().
+	void setMaxThreads(int maxThreads) { maxThreads_ = maxThreads; }
+
+	uint64_t rebuildCount() const { return rebuilds_; }
+	int threadCount() const { return hasKey_ ? key_.threads : 0; }
+
+private:
+	bool ensureContext(const VideoScaleKey &key);
+
+	SwsContext *context_ = nullptr;
+	AVFrame *dstFrame_ = nullptr;
+	VideoScaleKey key_;
+	bool hasKey_ = false;
+	int maxThreads_ = 0;
+	uint64_t rebuilds_ = 0;
+};
+
+} // namespace vdoninja
@@ -0,0 +1,141 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Per-viewer transport stats derived from pacer and RTCP feedback counters
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-viewer-stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "vdoninja-utils.h"
+
+namespace vdoninja
+{
+
+namespace
+{
+
+std::string rateJson(double value)
+{
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.4f", value);
+	return buffer;
+}
+
+bool countersAdvanced(const RtpPacerTotals &previous, const RtpPacerTotals &current)
+{
+	return current.sentPackets >= previous.sentPackets && current.sentBytes >= previous.sentBytes &&
+	       current.sentRepairs >= previous.sentRepairs && current.sentDuplicates >= previous.sentDuplicates;
+}
+
+} // namespace
+
+ViewerTransportStats deriveViewerTransportStats(const ViewerTransportSample *previous,
+                                                const ViewerTransportSample &current)
+{
+	ViewerTransportStats stats;
+	stats.uuid = current.uuid;
+	if (!current.candidateType.empty()) {
+		stats.candidateType = current.candidateType;
+	}
+	stats.pacerQueueDelayMs = current.pacer.lastFrameQueueDelayMs;
+	stats.lossRate = static_cast<double>(current.feedback.lastFractionLost) / 256.0;
+	stats.nackCount = current.feedback.nackMessages;
+	stats.pliCount = current.feedback.pliMessages;
+	stats.rttMs = current.feedback.lastRttMs;
+	stats.rembBitrateBps = current.feedback.lastRembBitrateBps;
+
+	if (!previous || current.sampledAtMs <= previous->sampledAtMs ||
+	    !countersAdvanced(previous->pacer, current.pacer)) {
+		return stats;
+	}
+
+	const int64_t elapsedMs = current.sampledAtMs - previous->sampledAtMs;
+	const uint64_t bytes = current.pacer.sentBytes - previous->pacer.sentBytes;
+	stats.sendBitrateBps = static_cast<int64_t>(bytes * 8000ULL / static_cast<uint64_t>(elapsedMs));
+
+	const uint64_t packets = current.pacer.sentPackets - previous->pacer.sentPackets;
+	if (packets > 0) {
+		stats.repairRate = static_cast<double>(current.pacer.sentRepairs - previous->pacer.sentRepairs) /
+		                   static_cast<double>(packets);
+		stats.duplicateRate = static_cast<double>(current.pacer.sentDuplicates - previous->pacer.sentDuplicates) /
+		                      static_cast<double>(packets);
+	}
+	return stats;
+}
+
+std::string viewerTransportStatsJson(const ViewerTransportStats &stats)
+{
+	JsonBuilder json;
+	json.add("candidateType", stats.candidateType);
+	json.add("sendBitrateBps", stats.sendBitrateBps);
+	json.add("pacerQueueDelayMs", static_cast<int64_t>(stats.pacerQueueDelayMs));
+	json.addRaw("lossRate", rateJson(stats.lossRate));
+	json.addRaw("repairRate", rateJson(stats.repairRate));
+	json.addRaw("duplicateRate", rateJson(stats.duplicateRate));
+	json.add("nackCount", static_cast<int64_t>(stats.nackCount));
+	json.add("pliCount", static_cast<int64_t>(stats.pliCount));
+	json.add("rttMs", static_cast<int64_t>(stats.rttMs));
+	json.add("rembBitrateBps", static_cast<int64_t>(stats.rembBitrateBps));
+	return json.build();
+}
+
+ViewerTransportTotals sumViewerTransportStats(const std::map<std::string, ViewerTransportStats> &stats)
+{
+	ViewerTransportTotals totals;
+	for (const auto &entry : stats) {
+		const ViewerTransportStats &viewer = entry.second;
+		if (viewer.sendBitrateBps >= 0) {
+			totals.sendBitrateBps = std::max<int64_t>(totals.sendBitrateBps, 0) + viewer.sendBitrateBps;
+		}
+		totals.maxPacerQueueDelayMs = std::max(totals.maxPacerQueueDelayMs, viewer.pacerQueueDelayMs);
+	}
+	return totals;
+}
+
+ViewerTransportStatsCache::ViewerTransportStatsCache(int64_t refreshIntervalMs)
+    : refreshIntervalMs_(refreshIntervalMs > 0 ? refreshIntervalMs : 0)
+{
+}
+
+std::map<std::string, ViewerTransportStats> ViewerTransportStatsCache::get(int64_t nowMs, const Collector &collect)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (lastRefreshMs_ != 0 && nowMs >= lastRefreshMs_ && nowMs - lastRefreshMs_ < refreshIntervalMs_) {
+		return stats_;
+	}
+
+	std::vector<ViewerTransportSample> collected;
+	if (collect) {
+		collected = collect();
+	}
+	std::map<std::string, ViewerTransportSample> samples;
+	std::map<std::string, ViewerTransportStats> stats;
+	for (auto &sample : collected) {
+		if (sample.uuid.empty()) {
+			continue;
+		}
+		const auto previous = samples_.find(sample.uuid);
+		stats[sample.uuid] =
+		    deriveViewerTransportStats(previous == samples_.end() ? nullptr : &previous->second, sample);
+		std::string uuid = sample.uuid;
+		samples.emplace(std::move(uuid), std::move(sample));
+	}
+	samples_ = std::move(samples);
+	stats_ = std::move(stats);
+	lastRefreshMs_ = nowMs;
+	return stats_;
+}
+
+void ViewerTransportStatsCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	lastRefreshMs_ = 0;
+	samples_.clear();
+	stats_.clear();
+}
+
+} // namespace vdoninja
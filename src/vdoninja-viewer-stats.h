@@ -0,0 +1,92 @@
+/*
+ * OBS VDO.Ninja Plugin
+ * Per-viewer transport stats derived from pacer and RTCP feedback counters
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "vdoninja-rtcp-feedback.h"
+#include "vdoninja-rtp-pacer.h"
+
+namespace vdoninja
+{
+
+// Raw lifetime counters for one viewer, gathered without any send-path lock.
+struct ViewerTransportSample {
+	std::string uuid;
+	int64_t sampledAtMs = 0;
+	RtpPacerTotals pacer;
+	RtcpFeedbackTotals feedback;
+	// ICE type of the selected candidate pair: host, srflx, prflx or relay.
+	std::string candidateType;
+};
+
+struct ViewerTransportStats {
+	std::string uuid;
+	std::string candidateType = "unknown";
+	// Paced video bytes on the wire since the previous sample, repair and
+	// duplicate packets included. -1 until two samples are available.
+	int64_t sendBitrateBps = -1;
+	uint64_t pacerQueueDelayMs = 0;
+	// Fraction lost from the viewer's latest receiver report, 0..1.
+	double lossRate = 0.0;
+	// Share of the interval's sent packets that were NACK repairs or
+	// protection duplicates.
+	double repairRate = 0.0;
+	double duplicateRate = 0.0;
+	uint64_t nackCount = 0;
+	uint64_t pliCount = 0;
+	uint64_t rttMs = 0;
+	uint64_t rembBitrateBps = 0;
+};
+
+// previous may be null for a viewer's first sample. A counter that went
+// backwards (the pacer was replaced) is treated as a first sample too.
+ViewerTransportStats deriveViewerTransportStats(const ViewerTransportSample *previous,
+                                                const ViewerTransportSample &current);
+
+std::string viewerTransportStatsJson(const ViewerTransportStats &stats);
+
+// Room-wide view of the per-viewer stats for compact displays.
+struct ViewerTransportTotals {
+	// Sum over viewers with a known bitrate; -1 when none is known yet.
+	int64_t sendBitrateBps = -1;
+	// Worst pacer queue delay across viewers.
+	uint64_t maxPacerQueueDelayMs = 0;
+};
+
+ViewerTransportTotals sumViewerTransportStats(const std::map<std::string, ViewerTransportStats> &stats);
+
+// Shares one collection per interval between every consumer, so connection
+// maps and remote stats for many directors cost one walk over the viewers per
+// second rather than one per request.
+class ViewerTransportStatsCache
+{
+public:
+	using Collector = std::function<std::vector<ViewerTransportSample>()>;
+
+	explicit ViewerTransportStatsCache(int64_t refreshIntervalMs = 1000);
+
+	// Stats keyed by viewer UUID. Calls collect only when the cached stats
+	// are older than the refresh interval. Viewers missing from a collection
+	// are forgotten.
+	std::map<std::string, ViewerTransportStats> get(int64_t nowMs, const Collector &collect);
+	void clear();
+
+private:
+	const int64_t refreshIntervalMs_;
+	std::mutex mutex_;
+	int64_t lastRefreshMs_ = 0;
+	std::map<std::string, ViewerTransportSample> samples_;
+	std::map<std::string, ViewerTransportStats> stats_;
+};
+
+} // namespace vdoninja
@@ -13,6 +13,7 @@
 #include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <stdexcept>
@@ -4820,6 +4821,52 @@ void testEveryEpochAdmissionStageDropsStale(const std::vector<std::vector<uint8_
 	}
 }
 
+void testH264AssemblyDropsAndCountsIncompleteFrames()
+{
+	VDONinjaSource source(NativeMediaTestTag{});
+	std::mutex decodedMutex;
+	std::vector<uint32_t> decodedTimestamps;
+	source.setNativeMediaTestStageHook([&](NativeMediaTestStage stage, bool alpha, uint32_t timestamp, uint64_t) {
+		if (stage == NativeMediaTestStage::PreDecode && !alpha) {
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			decodedTimestamps.push_back(timestamp);
+		}
+	});
+	source.setNativeMediaTestVideoDecoderHooks([](AVCodecContext *, const AVPacket *) { return 0; },
+	                                           [](AVCodecContext *, AVFrame *) { return AVERROR(EAGAIN); });
+
+	const std::vector<uint8_t> idr = {0x65, 0x88, 0x84, 0x00, 0x33};
+	const std::vector<uint8_t> delta = {0x41, 0x9A, 0x02, 0x04};
+	const auto fragment = [](bool start, bool end) {
+		return std::vector<uint8_t>{0x7C, static_cast<uint8_t>((start ? 0x80 : 0x00) | (end ? 0x40 : 0x00) | 0x05),
+		                            0x11, 0x22};
+	};
+
+	source.feedNativeMediaTestH264Packet(idr, 10, 3000, true);
+	// 6000 arrives reordered and is put back in sequence order.
+	source.feedNativeMediaTestH264Packet(fragment(false, true), 12, 6000, true);
+	source.feedNativeMediaTestH264Packet(fragment(true, false), 11, 6000, false);
+	// The middle fragment of 9000 is lost, so the deltas after it are held back.
+	source.feedNativeMediaTestH264Packet(fragment(true, false), 13, 9000, false);
+	source.feedNativeMediaTestH264Packet(fragment(false, true), 15, 9000, true);
+	source.feedNativeMediaTestH264Packet(delta, 16, 12000, true);
+	// 15000 resumes a fragment run whose start never arrived.
+	source.feedNativeMediaTestH264Packet(fragment(false, true), 17, 15000, true);
+	source.feedNativeMediaTestH264Packet(delta, 18, 18000, true);
+	// The next IDR resumes decoding.
+	source.feedNativeMediaTestH264Packet(idr, 19, 21000, true);
+	source.feedNativeMediaTestH264Packet(delta, 20, 24000, true);
+	source.setNativeMediaTestStageHook(nullptr);
+
+	{
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		require(decodedTimestamps == std::vector<uint32_t>({3000, 6000, 21000, 24000}),
+		        "H.264 assembly passed a damaged frame, or a delta after one, to the decoder");
+	}
+	require(source.receivePipelineSnapshot().incompleteFrames == 2,
+	        "H.264 assembly did not count its incomplete frames as drops");
+}
+
 void testSendPacketEagainDrainAndRetry(const std::vector<std::vector<uint8_t>> &primaryGop)
 {
 	VDONinjaSource source(NativeMediaTestTag{});
@@ -4997,17 +5044,26 @@ void testLinkedGateUsesShippedDecoderThreading(const std::vector<uint8_t> &prima
 	source.feedNativeMediaTestVp9AccessUnit(false, primaryAu, 9000);
 	source.feedNativeMediaTestVp9AccessUnit(true, alphaAu, 9000);
 
+	// Both decoders open before any size or rate is measured, so each asks for
+	// the budget's 1080p30 allotment: the primary alone, the alpha beside it.
+	const unsigned hardwareThreads = std::thread::hardware_concurrency();
+	const int primaryThreads = allocateDecoderThreads({DecoderLoad{}}, hardwareThreads)[0];
+	const int alphaThreads = allocateDecoderThreads({DecoderLoad{}, DecoderLoad{}}, hardwareThreads)[1];
+	require(DecoderThreadBudget::shared().decoders() == 2, "primary and alpha decoders did not join the thread budget");
+
 	const auto snapshot = source.nativeMediaTestSnapshot();
-	require(snapshot.primaryRequestedThreadCount == 0, "linked gate changed the shipped primary decoder thread count");
+	require(snapshot.primaryRequestedThreadCount == primaryThreads,
+	        "primary decoder did not open with its thread budget allotment");
 	require((snapshot.primaryRequestedThreadType & FF_THREAD_FRAME) != 0,
 	        "linked gate disabled shipped primary frame threading");
-	require(snapshot.alphaRequestedThreadCount == 0, "linked gate changed the shipped alpha decoder thread count");
+	require(snapshot.alphaRequestedThreadCount == alphaThreads,
+	        "alpha decoder did not open with its thread budget allotment");
 	require((snapshot.alphaRequestedThreadType & FF_THREAD_FRAME) != 0,
 	        "linked gate disabled shipped alpha frame threading");
-	require((snapshot.primaryActiveThreadType & FF_THREAD_FRAME) != 0,
-	        "primary decoder did not activate shipped frame threading");
-	require((snapshot.alphaActiveThreadType & FF_THREAD_FRAME) != 0,
-	        "alpha decoder did not activate shipped frame threading");
+	require(((snapshot.primaryActiveThreadType & FF_THREAD_FRAME) != 0) == (primaryThreads > 1),
+	        "primary decoder frame threading did not follow its thread allotment");
+	require(((snapshot.alphaActiveThreadType & FF_THREAD_FRAME) != 0) == (alphaThreads > 1),
+	        "alpha decoder frame threading did not follow its thread allotment");
 }
 
 void testFrameThreadedDecodePreservesRtpPts(const std::vector<std::vector<uint8_t>> &primaryGop)
@@ -5036,6 +5092,62 @@ void testFrameThreadedDecodePreservesRtpPts(const std::vector<std::vector<uint8_
 	}
 }
 
+void testConcurrentSourcesShareDecoderThreadBudget(const std::vector<std::vector<uint8_t>> &primaryGop)
+{
+	constexpr size_t kSources = 4;
+	constexpr size_t kRounds = 3;
+	std::vector<std::unique_ptr<VDONinjaSource>> sources;
+	std::vector<std::unique_ptr<OutputCollector>> outputs;
+	for (size_t index = 0; index < kSources; ++index) {
+		sources.push_back(std::make_unique<VDONinjaSource>(NativeMediaTestTag{}));
+		outputs.push_back(std::make_unique<OutputCollector>());
+		OutputCollector *output = outputs.back().get();
+		sources.back()->setNativeMediaTestOutputHook(
+		    [output](NativeMediaTestOutput frame) { output->add(std::move(frame)); });
+		sources.back()->transitionNativeMediaTestPipeline(false);
+	}
+
+	// Every round opens on the GOP's keyframe, so the second one measures the
+	// stream and rebalances each decoder to what a 16x16 stream needs.
+	const auto started = std::chrono::steady_clock::now();
+	std::vector<std::thread> feeders;
+	for (size_t index = 0; index < kSources; ++index) {
+		feeders.emplace_back([&primaryGop, source = sources[index].get()]() {
+			uint32_t timestamp = 30000;
+			for (size_t round = 0; round < kRounds; ++round) {
+				for (const auto &accessUnit : primaryGop) {
+					source->feedNativeMediaTestVp9AccessUnit(false, accessUnit, timestamp);
+					timestamp += 3000;
+				}
+			}
+		});
+	}
+	for (auto &feeder : feeders) {
+		feeder.join();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+	size_t decoded = 0;
+	int requestedThreads = 0;
+	std::string allotments;
+	for (size_t index = 0; index < kSources; ++index) {
+		const size_t frames = outputs[index]->size();
+		require(frames >= primaryGop.size(), "a source starved while sharing the decoder thread budget");
+		decoded += frames;
+		const int threads = sources[index]->nativeMediaTestSnapshot().primaryRequestedThreadCount;
+		require(threads >= 1, "a source decoder opened without a thread allotment");
+		requestedThreads += threads;
+		allotments += (allotments.empty() ? "" : ",") + std::to_string(threads);
+	}
+	const DecoderThreadBudget &budget = DecoderThreadBudget::shared();
+	require(budget.decoders() == kSources, "concurrent source decoders did not all join the thread budget");
+	require(requestedThreads <= std::max(budget.share(), static_cast<int>(kSources)),
+	        "concurrent source decoders opened more threads than the budget shares out");
+	std::cout << "[INFO] " << kSources << " sources decoded " << decoded << " frames at "
+	          << static_cast<int>(decoded / std::max(seconds, 1e-6)) << " frames/s with threads " << allotments
+	          << " of " << budget.share() << '\n';
+}
+
 void testSuppressionSerializesWithFinalCommit(const std::vector<std::vector<uint8_t>> &primaryGop)
 {
 	VDONinjaSource source(NativeMediaTestTag{});
@@ -5353,6 +5465,301 @@ void testSymmetricOwnershipAndDeferredAdoption()
 	        "retired peer A could re-enter adopted peer B media ownership");
 }
 
+std::vector<uint8_t> makeSyntheticH264AccessUnit(bool keyframe)
+{
+	std::vector<uint8_t> accessUnit;
+	const auto appendNal = [&](std::initializer_list<uint8_t> nal) {
+		accessUnit.insert(accessUnit.end(), {0x00, 0x00, 0x00, 0x01});
+		accessUnit.insert(accessUnit.end(), nal);
+	};
+	if (keyframe) {
+		appendNal({0x67, 0x42, 0xC0, 0x1F, 0xDA, 0x01, 0x40});
+		appendNal({0x68, 0xCE, 0x3C, 0x80});
+		appendNal({0x65, 0x88, 0x84, 0x00, 0x33, 0xFF});
+	} else {
+		appendNal({0x41, 0x9A, 0x02, 0x04, 0x11});
+	}
+	return accessUnit;
+}
+
+void testRelayForwardsOnlyIntactFramesAndAsksUpstream()
+{
+	VDONinjaRelay relay;
+	std::atomic<int> upstreamRequests{0};
+	RelaySettings settings;
+	settings.streamId = "relay-gate";
+	// Nothing listens here: the relay's signaling fails while its ingest and
+	// send worker run exactly as they do for connected viewers.
+	settings.wssHost = "ws://127.0.0.1:9";
+	require(relay.start(settings,
+	                    [&]() {
+		                    upstreamRequests.fetch_add(1, std::memory_order_relaxed);
+		                    return true;
+	                    }),
+	        "relay did not start");
+	require(relay.isRunning(), "relay did not report running");
+
+	const uint32_t ssrc = 0x2468;
+	uint16_t sequence = 40;
+	uint32_t timestamp = 90000;
+	const auto feedFrame = [&](bool keyframe, bool lose) {
+		const std::vector<uint8_t> accessUnit = makeSyntheticH264AccessUnit(keyframe);
+		for (int packet = 0; packet < 3; ++packet) {
+			if (lose && packet == 1) {
+				++sequence;
+				continue;
+			}
+			relay.noteVideoPacket(ssrc, sequence++, timestamp, true);
+		}
+		relay.forwardVideoFrame(accessUnit.data(), accessUnit.size(), timestamp);
+		timestamp += 3000;
+	};
+
+	relay.noteVideoPacket(ssrc, sequence++, timestamp - 3000, true);
+	feedFrame(true, false);
+	feedFrame(false, false);
+	feedFrame(false, true);
+	feedFrame(false, false);
+	feedFrame(true, false);
+	feedFrame(false, false);
+
+	const std::vector<uint8_t> opus = {0x78, 0x01, 0x02};
+	relay.forwardAudioFrame(0x1357, opus.data(), opus.size(), 48000);
+	relay.forwardAudioFrame(0x1357, opus.data(), opus.size(), 48960);
+
+	const RelayStats stats = relay.stats();
+	require(stats.video.forwardedFrames == 4, "relay did not forward exactly the intact anchored frames");
+	require(stats.video.droppedFrames == 2, "relay forwarded a damaged frame or a delta that depends on it");
+	require(upstreamRequests.load() == 1, "relay did not ask upstream for exactly one keyframe after loss");
+	require(stats.forwardedAudioPackets == 2, "relay did not forward audio frames");
+	require(stats.overflowedFrames == 0, "relay send worker overflowed on a short burst");
+
+	relay.stop();
+	require(!relay.isRunning(), "relay still running after stop");
+	relay.forwardVideoFrame(opus.data(), opus.size(), timestamp);
+	require(relay.stats().video.forwardedFrames == 4, "stopped relay accepted a frame");
+}
+
+// Drops a publisher's outgoing video packets for chosen RTP timestamps, as a
+// lossy uplink would.
+class RtpTimestampDropHandler final : public rtc::MediaHandler
+{
+public:
+	void drop(uint32_t timestamp)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		timestamps_.insert(timestamp);
+	}
+
+	size_t dropped() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return dropped_;
+	}
+
+	void outgoing(rtc::message_vector &messages, const rtc::message_callback &) override
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const auto lost = [this](const rtc::message_ptr &message) {
+			if (!message || message->type == rtc::Message::Control || message->size() < sizeof(rtc::RtpHeader)) {
+				return false;
+			}
+			const auto *header = reinterpret_cast<const rtc::RtpHeader *>(message->data());
+			if (timestamps_.count(header->timestamp()) == 0) {
+				return false;
+			}
+			++dropped_;
+			return true;
+		};
+		messages.erase(std::remove_if(messages.begin(), messages.end(), lost), messages.end());
+	}
+
+private:
+	mutable std::mutex mutex_;
+	std::set<uint32_t> timestamps_;
+	size_t dropped_ = 0;
+};
+
+struct ObservedRtpPacket {
+	uint32_t ssrc = 0;
+	uint16_t sequence = 0;
+	bool marker = false;
+};
+
+void testRelayLoopbackRewritesIntactFramesAndAsksThePublisher()
+{
+	struct State {
+		std::mutex mutex;
+		std::shared_ptr<rtc::Track> viewerVideo;
+		std::vector<ObservedRtpPacket> viewerPackets;
+		std::string error;
+	};
+	const auto state = std::make_shared<State>();
+	const auto recordError = [state](const std::string &error) {
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->error = error;
+	};
+	const auto viewerFrames = [state]() {
+		std::lock_guard<std::mutex> lock(state->mutex);
+		return std::count_if(state->viewerPackets.begin(), state->viewerPackets.end(),
+		                     [](const ObservedRtpPacket &packet) { return packet.marker; });
+	};
+
+	// Upstream: an OBS-style publisher and the native receiver relaying it.
+	std::atomic<int> publisherKeyframeRequests{0};
+	VDONinjaSource source(NativeMediaTestTag{});
+	VDONinjaPeerManager receiver;
+	VDONinjaPeerManager publisher;
+	source.bindNativeMediaTestPeerManager(receiver);
+	source.setNativeMediaTestVideoDecoderHooks([](AVCodecContext *, const AVPacket *) { return 0; },
+	                                           [](AVCodecContext *, AVFrame *) { return AVERROR(EAGAIN); });
+	publisher.setOnKeyframeRequest(
+	    [&](const std::string &) { publisherKeyframeRequests.fetch_add(1, std::memory_order_relaxed); });
+	require(publisher.startPublishing(1), "upstream publisher did not start publishing");
+
+	auto upstreamPeer = publisher.createNativeMediaTestPublisherPeer("relay-source", "session-upstream");
+	auto receiverPeer = receiver.createNativeMediaTestViewerPeer("relay-publisher", "session-upstream");
+	require(upstreamPeer && upstreamPeer->pc && receiverPeer && receiverPeer->pc,
+	        "linked RTC gate did not create the upstream PeerConnections");
+	std::shared_ptr<rtc::Track> upstreamVideo;
+	{
+		std::lock_guard<std::mutex> mediaLock(upstreamPeer->mediaMutex);
+		upstreamVideo = upstreamPeer->videoTrack;
+	}
+	require(upstreamVideo != nullptr, "upstream publisher peer has no video track");
+	const auto dropper = std::make_shared<RtpTimestampDropHandler>();
+	upstreamVideo->chainMediaHandler(dropper);
+	const auto upstreamSignaling = LocalRtcSignalingRelay::create(upstreamPeer->pc, receiverPeer->pc, recordError);
+	upstreamPeer->pc->setLocalDescription(rtc::Description::Type::Offer);
+	requireEventually(
+	    [&]() {
+		    return upstreamPeer->state.load() == ConnectionState::Connected &&
+		           source.nativeMediaTestTrackSnapshot().video != nullptr;
+	    },
+	    "upstream publisher and relaying receiver did not connect", 30s);
+
+	// Nothing listens on the relay's signaling host; its viewer connects
+	// directly to the relay's peer manager instead.
+	VDONinjaRelay &relay = source.startNativeMediaTestRelay("relay-loopback", "ws://127.0.0.1:9");
+	VDONinjaPeerManager *relayManager = relay.nativeMediaTestPeerManager();
+	require(relayManager && relayManager->startPublishing(1), "relay peer manager did not start publishing");
+	auto relayPeer = relayManager->createNativeMediaTestPublisherPeer("relay-viewer", "session-relay");
+	require(relayPeer && relayPeer->pc, "relay did not create its viewer PeerConnection");
+
+	auto viewer = std::make_shared<rtc::PeerConnection>(rtc::Configuration{});
+	viewer->onTrack([state](std::shared_ptr<rtc::Track> track) {
+		if (!track || track->description().type() != "video") {
+			return;
+		}
+		track->onMessage([state](rtc::message_variant message) {
+			if (!std::holds_alternative<rtc::binary>(message)) {
+				return;
+			}
+			const auto &packet = std::get<rtc::binary>(message);
+			if (packet.size() < sizeof(rtc::RtpHeader)) {
+				return;
+			}
+			// Sender reports share the track.
+			const auto packetType = std::to_integer<uint8_t>(packet[1]);
+			if (packetType >= 200 && packetType <= 206) {
+				return;
+			}
+			const auto *header = reinterpret_cast<const rtc::RtpHeader *>(packet.data());
+			std::lock_guard<std::mutex> lock(state->mutex);
+			state->viewerPackets.push_back({header->ssrc(), header->seqNumber(), header->marker() != 0});
+		});
+		std::lock_guard<std::mutex> lock(state->mutex);
+		state->viewerVideo = std::move(track);
+	});
+	const auto viewerSignaling = LocalRtcSignalingRelay::create(relayPeer->pc, viewer, recordError);
+	relayPeer->pc->setLocalDescription(rtc::Description::Type::Offer);
+	requireEventually(
+	    [&]() {
+		    std::lock_guard<std::mutex> lock(state->mutex);
+		    return relayPeer->state.load() == ConnectionState::Connected && state->viewerVideo &&
+		           state->viewerVideo->isOpen();
+	    },
+	    "relay viewer did not connect", 30s);
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		require(state->error.empty(), state->error);
+	}
+	// Connection-time keyframe requests from the receiver and the relay land
+	// before any media, so the publisher's keyframe gate starts clean.
+	std::this_thread::sleep_for(500ms);
+
+	uint32_t timestamp = 90000;
+	const auto sendFrame = [&](bool keyframe) {
+		const std::vector<uint8_t> accessUnit = makeSyntheticH264AccessUnit(keyframe);
+		publisher.sendVideoFrame(accessUnit.data(), accessUnit.size(), timestamp, keyframe);
+		timestamp += 3000;
+		std::this_thread::sleep_for(33ms);
+	};
+
+	sendFrame(true);
+	sendFrame(false);
+	sendFrame(false);
+	requireEventually([&]() { return viewerFrames() == 3; }, "relay viewer did not receive the intact frames", 10s);
+	require(relay.stats().video.keyframeRequests == 0, "relay asked upstream for a keyframe before any loss");
+	const int requestsBeforeLoss = publisherKeyframeRequests.load();
+
+	// The uplink loses a delta; the deltas behind it reference a frame the
+	// viewer never sees.
+	dropper->drop(timestamp);
+	sendFrame(false);
+	sendFrame(false);
+	sendFrame(false);
+	requireEventually([&]() { return relay.stats().video.keyframeRequests >= 1; },
+	                  "relay did not ask upstream for a keyframe after losing a frame");
+	requireEventually([&]() { return publisherKeyframeRequests.load() > requestsBeforeLoss; },
+	                  "relay keyframe request did not reach the upstream publisher");
+	require(dropper->dropped() >= 1, "loopback uplink did not lose the frame");
+	require(viewerFrames() == 3, "relay forwarded a delta whose reference was lost");
+
+	sendFrame(true);
+	sendFrame(false);
+	requireEventually([&]() { return viewerFrames() == 5; }, "relay viewer did not recover on the next keyframe",
+	                  10s);
+
+	const RelayStats stats = relay.stats();
+	require(stats.video.forwardedFrames == 5, "relay did not forward exactly the intact anchored frames");
+	require(stats.video.droppedFrames == 2, "relay forwarded a delta that depends on the lost frame");
+	const uint32_t upstreamSsrc = upstreamPeer->videoRtpConfig->ssrc;
+	const uint32_t relaySsrc = relayPeer->videoRtpConfig->ssrc;
+	require(upstreamSsrc != relaySsrc, "relay reused the upstream publisher's video SSRC");
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		require(!state->viewerPackets.empty(), "relay viewer received no video packets");
+		for (size_t i = 0; i < state->viewerPackets.size(); ++i) {
+			const ObservedRtpPacket &packet = state->viewerPackets[i];
+			require(packet.ssrc == relaySsrc, "relay viewer received a packet outside the relay's own SSRC");
+			if (i > 0) {
+				require(packet.sequence == static_cast<uint16_t>(state->viewerPackets[i - 1].sequence + 1),
+				        "relay viewer sequence numbers skipped across the upstream loss");
+			}
+		}
+	}
+
+	viewer->onTrack(nullptr);
+	viewer->close();
+
+	// Stats stay readable while a restart replaces the relay's peer manager.
+	std::atomic<bool> polling{true};
+	std::atomic<uint64_t> polls{0};
+	std::thread poller([&]() {
+		while (polling.load()) {
+			(void)relay.stats();
+			polls.fetch_add(1);
+		}
+	});
+	requireEventually([&]() { return polls.load() > 0; }, "relay stats poller did not start", 5s);
+	source.startNativeMediaTestRelay("relay-loopback-restart", "ws://127.0.0.1:9");
+	relay.stop();
+	polling = false;
+	poller.join();
+	require(!relay.stats().running && relay.stats().viewers == 0, "stopped relay still reports viewers");
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -5496,6 +5903,8 @@ int main(int argc, char **argv)
 		     [&]() { testLinkedGateUsesShippedDecoderThreading(primaryAu, alphaAu); }},
 		    {"frame-thread delayed decode preserves originating RTP PTS",
 		     [&]() { testFrameThreadedDecodePreservesRtpPts(primaryGop); }},
+		    {"concurrent sources share the decoder thread budget",
+		     [&]() { testConcurrentSourcesShareDecoderThreadBudget(primaryGop); }},
 		    {"real VP9 decode and alpha composition",
 		     [&]() { testRealDecodeAndAlphaComposition(primaryGop, alphaGop); }},
 		    {"RTP age eviction/reorder/drop/wrap/recovery",
@@ -5504,6 +5913,7 @@ int main(int argc, char **argv)
 		     [&]() { testTransitionFlushesBothPipelines(primaryGop, alphaGop); }},
 		    {"stale epoch rejection at 5 stages x 2 tracks (10 latches)",
 		     [&]() { testEveryEpochAdmissionStageDropsStale(primaryGop, alphaGop); }},
+		    {"H.264 assembly drops and counts incomplete frames", testH264AssemblyDropsAndCountsIncompleteFrames},
 		    {"FFmpeg send EAGAIN drain and retry", [&]() { testSendPacketEagainDrainAndRetry(primaryGop); }},
 		    {"alpha FFmpeg send EAGAIN drain, exact retry, and mate pairing",
 		     [&]() { testAlphaSendPacketEagainDrainAndRetry(primaryGop, alphaGop); }},
@@ -5520,6 +5930,9 @@ int main(int argc, char **argv)
 		    {"stall clear rechecks fresh commit", [&]() { testStallClearRechecksFreshCommit(primaryGop); }},
 		    {"coherent output dimension publication", [&]() { testDimensionPublicationIsCoherent(primaryGop); }},
 		    {"symmetric peer ownership and deferred adoption", testSymmetricOwnershipAndDeferredAdoption},
+		    {"shared-media relay forwards only intact frames", testRelayForwardsOnlyIntactFramesAndAsksUpstream},
+		    {"shared-media relay loopback rewrites intact frames and asks the publisher",
+		     testRelayLoopbackRewritesIntactFramesAndAsksThePublisher},
 		};
 
 		const std::string filter = argc > 1 ? argv[1] : "";
@@ -0,0 +1,372 @@
+/*
+ * Unit tests for the native receiver audio jitter buffer
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-audio-jitter.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace vdoninja;
+
+namespace
+{
+
+// SILK wideband 20 ms mono, code 0.
+constexpr uint8_t kSilk20msToc = 0x48;
+// CELT fullband 20 ms mono, code 0.
+constexpr uint8_t kCelt20msToc = 0xF8;
+constexpr uint32_t kFrameTicks = 960;
+constexpr int64_t kFrameUs = 20000;
+
+std::vector<uint8_t> silkPacket(bool lbrr, uint8_t marker = 0)
+{
+	return {kSilk20msToc, static_cast<uint8_t>(lbrr ? 0xC0 : 0x80), marker, 0x11, 0x22};
+}
+
+struct Harness {
+	AudioJitterBuffer buffer;
+	std::vector<AudioPlayoutItem> out;
+
+	bool push(uint16_t sequence, int64_t arrivalUs, bool lbrr = false)
+	{
+		const auto payload = silkPacket(lbrr, static_cast<uint8_t>(sequence));
+		const bool accepted =
+		    buffer.push(sequence, 1000 + sequence * kFrameTicks, payload.data(), payload.size(), arrivalUs);
+		buffer.pull(arrivalUs, out);
+		return accepted;
+	}
+};
+
+std::string describeActions(const std::vector<AudioPlayoutItem> &items)
+{
+	std::string actions;
+	for (const auto &item : items) {
+		switch (item.action) {
+		case AudioPlayoutAction::Decode:
+			actions += 'D';
+			break;
+		case AudioPlayoutAction::DecodeFec:
+			actions += 'F';
+			break;
+		case AudioPlayoutAction::Conceal:
+			actions += 'C';
+			break;
+		}
+	}
+	return actions;
+}
+
+} // namespace
+
+TEST(AudioJitterTest, InspectsOpusTocFrameCountsAndLbrr)
+{
+	auto info = inspectOpusPacket(silkPacket(true).data(), 5);
+	EXPECT_TRUE(info.valid);
+	EXPECT_EQ(info.samples, 960);
+	EXPECT_TRUE(info.hasLbrr);
+	EXPECT_FALSE(inspectOpusPacket(silkPacket(false).data(), 5).hasLbrr);
+
+	// SILK 60 ms holds three SILK frames: three VAD bits, then the LBRR flag.
+	const uint8_t silk60ms[] = {0x58, 0x10, 0x00};
+	info = inspectOpusPacket(silk60ms, sizeof(silk60ms));
+	EXPECT_EQ(info.samples, 2880);
+	EXPECT_TRUE(info.hasLbrr);
+
+	// Stereo: the side channel's LBRR flag follows the mid channel's flags.
+	const uint8_t stereoSideLbrr[] = {0x4C, 0x10, 0x00};
+	info = inspectOpusPacket(stereoSideLbrr, sizeof(stereoSideLbrr));
+	EXPECT_TRUE(info.stereo);
+	EXPECT_TRUE(info.hasLbrr);
+
+	// CELT-only packets carry no LBRR whatever the first byte holds.
+	const uint8_t celt[] = {kCelt20msToc, 0xFF, 0xFF};
+	EXPECT_FALSE(inspectOpusPacket(celt, sizeof(celt)).hasLbrr);
+
+	// Code 1: two equal CELT 10 ms frames.
+	const uint8_t twoFrames[] = {0xF1, 0x01, 0x02};
+	EXPECT_EQ(inspectOpusPacket(twoFrames, sizeof(twoFrames)).samples, 960);
+	const uint8_t oddTwoFrames[] = {0xF1, 0x01};
+	EXPECT_FALSE(inspectOpusPacket(oddTwoFrames, sizeof(oddTwoFrames)).valid);
+
+	// Code 3, CBR, three 20 ms frames.
+	const uint8_t threeFrames[] = {0xFB, 0x03, 0x01, 0x02, 0x03};
+	EXPECT_EQ(inspectOpusPacket(threeFrames, sizeof(threeFrames)).samples, 2880);
+	// Code 3 may not exceed 120 ms.
+	const uint8_t tooLong[] = {0xFB, 0x07, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+	EXPECT_FALSE(inspectOpusPacket(tooLong, sizeof(tooLong)).valid);
+
+	EXPECT_FALSE(inspectOpusPacket(nullptr, 0).valid);
+}
+
+TEST(AudioJitterTest, LostFramePacketKeepsConfiguration)
+{
+	const auto lost = makeOpusLostFramePacket(0x4B);
+	ASSERT_EQ(lost.size(), 1U);
+	EXPECT_EQ(lost[0], kSilk20msToc);
+	const auto info = inspectOpusPacket(lost.data(), lost.size());
+	EXPECT_TRUE(info.valid);
+	EXPECT_EQ(info.samples, 960);
+	EXPECT_FALSE(info.hasLbrr);
+}
+
+TEST(AudioJitterTest, SteadyStreamPlaysInOrderAfterOneFrame)
+{
+	Harness h;
+	for (uint16_t seq = 0; seq < 10; ++seq) {
+		EXPECT_TRUE(h.push(seq, seq * kFrameUs));
+	}
+	EXPECT_EQ(describeActions(h.out), "DDDDDDDDD");
+	for (size_t i = 0; i < h.out.size(); ++i) {
+		EXPECT_EQ(h.out[i].rtpTimestamp, 1000 + i * kFrameTicks);
+		EXPECT_EQ(h.out[i].samples, 960);
+		EXPECT_EQ(h.out[i].payload[2], static_cast<uint8_t>(i));
+	}
+	const auto stats = h.buffer.getStats();
+	EXPECT_EQ(stats.targetDelayMs, 20);
+	EXPECT_EQ(stats.maxPlayoutDelayMs, 20);
+	EXPECT_EQ(stats.concealedPackets, 0U);
+}
+
+TEST(AudioJitterTest, ReorderedPacketIsPlayedInSequence)
+{
+	Harness h;
+	h.push(0, 0);
+	h.push(2, 30000);
+	h.push(1, 35000);
+	h.push(3, 60000);
+	h.push(4, 80000);
+	ASSERT_EQ(describeActions(h.out), "DDDD");
+	for (size_t i = 0; i < h.out.size(); ++i) {
+		EXPECT_EQ(h.out[i].payload[2], static_cast<uint8_t>(i));
+	}
+	const auto stats = h.buffer.getStats();
+	EXPECT_EQ(stats.reorderedPackets, 1U);
+	EXPECT_EQ(stats.concealedPackets, 0U);
+}
+
+TEST(AudioJitterTest, SingleLossIsRebuiltFromFollowingLbrr)
+{
+	Harness h;
+	h.push(0, 0, true);
+	h.push(1, 20000, true);
+	h.push(3, 60000, true);
+	h.push(4, 80000, true);
+	h.push(5, 100000, true);
+	ASSERT_EQ(describeActions(h.out), "DDFDD");
+	EXPECT_EQ(h.out[2].rtpTimestamp, 1000 + 2 * kFrameTicks);
+	EXPECT_EQ(h.out[2].samples, 960);
+	ASSERT_GE(h.out[2].payload.size(), 3U);
+	EXPECT_EQ(h.out[2].payload[2], 3);
+	EXPECT_EQ(h.buffer.getStats().fecRecoveredPackets, 1U);
+}
+
+TEST(AudioJitterTest, BurstLossConcealsAndUsesFecForLastFrame)
+{
+	Harness h;
+	h.push(0, 0, false);
+	h.push(1, 20000, false);
+	h.push(5, 100000, true);
+	h.push(6, 120000, true);
+	h.push(7, 140000, true);
+	// 2 and 3 are concealed; 4 comes back from the LBRR carried by 5.
+	ASSERT_EQ(describeActions(h.out), "DDCCFDD");
+	for (size_t i = 0; i + 1 < h.out.size(); ++i) {
+		EXPECT_EQ(h.out[i + 1].rtpTimestamp, h.out[i].rtpTimestamp + static_cast<uint32_t>(h.out[i].samples));
+	}
+	EXPECT_EQ(h.out[2].toc, kSilk20msToc);
+	EXPECT_TRUE(h.out[2].payload.empty());
+
+	Harness noFec;
+	noFec.push(0, 0, false);
+	noFec.push(2, 40000, false);
+	noFec.push(3, 60000, false);
+	EXPECT_EQ(describeActions(noFec.out), "DCD");
+	const auto stats = noFec.buffer.getStats();
+	EXPECT_EQ(stats.concealedPackets, 1U);
+	EXPECT_EQ(stats.concealedSamples, 960U);
+}
+
+TEST(AudioJitterTest, PlayoutClockDrainsTheTailAfterPacketsStop)
+{
+	Harness h;
+	h.push(0, 0);
+	h.push(1, 20000);
+	// 2 is lost, 3 and 4 arrive together and then the sender goes quiet.
+	h.push(3, 41000);
+	h.push(4, 42000);
+	EXPECT_EQ(describeActions(h.out), "DDC");
+	EXPECT_EQ(h.buffer.bufferedPackets(), 2U);
+
+	// With no packets left to trigger a pull, the receiver's playout clock
+	// keeps pulling, so the frames already buffered still play.
+	for (int64_t nowUs = 50000; nowUs <= 200000; nowUs += 10000) {
+		h.buffer.pull(nowUs, h.out);
+	}
+	EXPECT_EQ(describeActions(h.out), "DDCDD");
+	EXPECT_EQ(h.out.back().rtpTimestamp, 1000 + 4 * kFrameTicks);
+	EXPECT_EQ(h.buffer.bufferedPackets(), 0U);
+
+	// Nothing is invented once the buffer is empty.
+	h.buffer.pull(1000000, h.out);
+	EXPECT_EQ(h.out.size(), 5U);
+}
+
+TEST(AudioJitterTest, RedundantBlocksFillMissingSlotsOnly)
+{
+	Harness h;
+	h.push(0, 0, false);
+	h.push(1, 20000, false);
+	// Packet 4 carried RED copies of 2 and 3; 1 has already played. The
+	// redundant blocks go in before the next pull, like the receive path does.
+	const auto primary = silkPacket(false, 4);
+	ASSERT_TRUE(h.buffer.push(4, 1000 + 4 * kFrameTicks, primary.data(), primary.size(), 80000));
+	for (const uint16_t seq : {1, 2, 3}) {
+		const auto payload = silkPacket(false, static_cast<uint8_t>(seq));
+		const bool kept =
+		    h.buffer.pushRedundant(seq, 1000 + seq * kFrameTicks, payload.data(), payload.size(), 80000);
+		EXPECT_EQ(kept, seq != 1) << seq;
+	}
+	const auto again = silkPacket(false, 3);
+	EXPECT_FALSE(h.buffer.pushRedundant(3, 1000 + 3 * kFrameTicks, again.data(), again.size(), 80000));
+	h.buffer.pull(80000, h.out);
+	h.push(5, 100000, false);
+	h.push(6, 120000, false);
+
+	ASSERT_EQ(describeActions(h.out), "DDDDDD");
+	for (size_t i = 0; i < h.out.size(); ++i) {
+		EXPECT_EQ(h.out[i].payload[2], static_cast<uint8_t>(i));
+	}
+	const auto stats = h.buffer.getStats();
+	EXPECT_EQ(stats.redRecoveredPackets, 2U);
+	EXPECT_EQ(stats.concealedPackets, 0U);
+	EXPECT_EQ(stats.duplicatePackets, 0U);
+	EXPECT_EQ(stats.latePackets, 0U);
+
+	AudioJitterBuffer empty;
+	const auto payload = silkPacket(false);
+	EXPECT_FALSE(empty.pushRedundant(0, 1000, payload.data(), payload.size(), 0));
+}
+
+TEST(AudioJitterTest, PacketArrivingAfterItsSlotIsLate)
+{
+	Harness h;
+	h.push(0, 0);
+	h.push(2, 40000);
+	h.push(3, 60000);
+	EXPECT_EQ(describeActions(h.out), "DCD");
+	EXPECT_FALSE(h.push(1, 65000));
+	EXPECT_FALSE(h.push(2, 66000));
+	EXPECT_FALSE(h.push(3, 67000));
+	const auto stats = h.buffer.getStats();
+	EXPECT_EQ(stats.latePackets, 2U);
+	EXPECT_EQ(stats.duplicatePackets, 1U);
+}
+
+TEST(AudioJitterTest, LongGapResynchronizesWithoutConcealment)
+{
+	Harness h;
+	h.push(0, 0);
+	h.push(1, 20000);
+	h.push(40, 800000);
+	h.push(41, 820000);
+	EXPECT_EQ(describeActions(h.out), "DDD");
+	const auto stats = h.buffer.getStats();
+	EXPECT_EQ(stats.concealedPackets, 0U);
+	EXPECT_EQ(stats.resyncs, 1U);
+}
+
+TEST(AudioJitterTest, TargetDelayFollowsJitterWithinBounds)
+{
+	Harness h;
+	for (uint16_t seq = 0; seq < 200; ++seq) {
+		const int64_t spread = (seq % 2) == 0 ? 0 : 30000;
+		h.push(seq, seq * kFrameUs + spread);
+	}
+	const int raised = h.buffer.targetDelayMs();
+	EXPECT_GT(raised, 60);
+	EXPECT_LE(raised, 200);
+
+	for (uint16_t seq = 200; seq < 400; ++seq) {
+		h.push(seq, seq * kFrameUs + 30000);
+	}
+	EXPECT_LT(h.buffer.targetDelayMs(), raised);
+
+	h.buffer.setDelayBoundsMs(40, 80);
+	EXPECT_GE(h.buffer.targetDelayMs(), 40);
+	EXPECT_LE(h.buffer.targetDelayMs(), 80);
+}
+
+TEST(AudioJitterTest, LossInjectionKeepsPlayoutContinuous)
+{
+	constexpr int kPackets = 3000;
+	uint32_t rng = 12345;
+	auto next = [&rng]() {
+		rng = rng * 1103515245U + 12345U;
+		return (rng >> 16) & 0x7FFF;
+	};
+
+	struct Arrival {
+		int index;
+		int64_t arrivalUs;
+	};
+	std::vector<Arrival> arrivals;
+	int dropped = 0;
+	for (int i = 0; i < kPackets; ++i) {
+		const bool burst = i >= 1500 && i < 1504;
+		if (burst || next() % 100 < 5) {
+			++dropped;
+			continue;
+		}
+		const int64_t jitterUs = static_cast<int64_t>(next() % 30) * 1000;
+		arrivals.push_back({i, i * kFrameUs + jitterUs});
+	}
+	std::stable_sort(arrivals.begin(), arrivals.end(),
+	                 [](const Arrival &a, const Arrival &b) { return a.arrivalUs < b.arrivalUs; });
+
+	AudioJitterBuffer buffer;
+	std::vector<AudioPlayoutItem> out;
+	for (const auto &arrival : arrivals) {
+		const auto payload = silkPacket(true);
+		// Starts just below both wrap points.
+		buffer.push(static_cast<uint16_t>(65000 + arrival.index),
+		            0xFFFF0000U + static_cast<uint32_t>(arrival.index) * kFrameTicks, payload.data(), payload.size(),
+		            arrival.arrivalUs);
+		buffer.pull(arrival.arrivalUs, out);
+	}
+	// Playout delay as seen while the stream was live, before the final drain.
+	const auto live = buffer.getStats();
+	buffer.pull(kPackets * kFrameUs + 1000000, out);
+
+	ASSERT_FALSE(out.empty());
+	for (size_t i = 0; i + 1 < out.size(); ++i) {
+		ASSERT_EQ(out[i + 1].rtpTimestamp, out[i].rtpTimestamp + static_cast<uint32_t>(out[i].samples))
+		    << "discontinuity after item " << i;
+	}
+
+	const auto stats = buffer.getStats();
+	RecordProperty("dropped_packets", dropped);
+	RecordProperty("fec_recovered", static_cast<int>(stats.fecRecoveredPackets));
+	RecordProperty("concealed", static_cast<int>(stats.concealedPackets));
+	RecordProperty("late", static_cast<int>(stats.latePackets));
+	RecordProperty("target_delay_ms", live.targetDelayMs);
+	RecordProperty("mean_playout_delay_ms", std::to_string(live.meanPlayoutDelayMs));
+	RecordProperty("max_playout_delay_ms", static_cast<int>(live.maxPlayoutDelayMs));
+
+	// Every sequence number is accounted for exactly once.
+	EXPECT_EQ(out.size(), static_cast<size_t>(kPackets));
+	EXPECT_EQ(stats.decodedPackets + stats.fecRecoveredPackets + stats.concealedPackets,
+	          static_cast<uint64_t>(kPackets));
+	EXPECT_EQ(stats.decodedPackets, static_cast<uint64_t>(kPackets - dropped) - stats.latePackets);
+	// With LBRR in every packet, most isolated losses come back through FEC.
+	EXPECT_GT(stats.fecRecoveredPackets, stats.concealedPackets);
+	EXPECT_LT(stats.latePackets, static_cast<uint64_t>(kPackets / 100));
+	EXPECT_GT(live.targetDelayMs, 20);
+	EXPECT_LE(live.maxPlayoutDelayMs, 200 + 20);
+	EXPECT_GT(live.meanPlayoutDelayMs, 0.0);
+	EXPECT_EQ(buffer.bufferedPackets(), 0U);
+}
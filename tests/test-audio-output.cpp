@@ -0,0 +1,76 @@
+/*
+ * Unit tests for decoded audio hand-off policy and conversion planes
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-audio-output.h"
+
+#include <cstring>
+
+using namespace vdoninja;
+
+TEST(AudioOutputTest, MonoAndStereoDecoderOutputPassesThrough)
+{
+	for (const auto format : {DecodedAudioFormat::Float, DecodedAudioFormat::FloatPlanar, DecodedAudioFormat::Int16,
+	                          DecodedAudioFormat::Int16Planar}) {
+		EXPECT_TRUE(decodedAudioPassesThrough(format, 1));
+		EXPECT_TRUE(decodedAudioPassesThrough(format, 2));
+		EXPECT_FALSE(decodedAudioPassesThrough(format, 6));
+		EXPECT_FALSE(decodedAudioPassesThrough(format, 0));
+	}
+	EXPECT_FALSE(decodedAudioPassesThrough(DecodedAudioFormat::Other, 2));
+}
+
+TEST(AudioOutputTest, PlaneBufferGrowsOnlyForLargerFrames)
+{
+	AudioPlaneBuffer buffer;
+	ASSERT_TRUE(buffer.reserve(2, 960, sizeof(float)));
+	EXPECT_EQ(buffer.allocations(), 1U);
+	EXPECT_GE(buffer.capacitySamples(), 5760);
+
+	for (int i = 0; i < 100; ++i) {
+		ASSERT_TRUE(buffer.reserve(2, 960, sizeof(float)));
+		ASSERT_TRUE(buffer.reserve(1, 480, sizeof(float)));
+		ASSERT_TRUE(buffer.reserve(2, 5760, sizeof(float)));
+	}
+	EXPECT_EQ(buffer.allocations(), 1U);
+
+	ASSERT_TRUE(buffer.reserve(2, 48000, sizeof(float)));
+	EXPECT_EQ(buffer.allocations(), 2U);
+	EXPECT_GE(buffer.capacitySamples(), 48000);
+	ASSERT_TRUE(buffer.reserve(2, 960, sizeof(float)));
+	EXPECT_EQ(buffer.allocations(), 2U);
+	EXPECT_GE(buffer.capacitySamples(), 48000);
+}
+
+TEST(AudioOutputTest, PlanesAreAlignedAndDisjoint)
+{
+	AudioPlaneBuffer buffer;
+	ASSERT_TRUE(buffer.reserve(2, 1000, sizeof(float)));
+	uint8_t **planes = buffer.planes();
+	ASSERT_NE(planes[0], nullptr);
+	ASSERT_NE(planes[1], nullptr);
+	EXPECT_EQ(planes[2], nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(planes[0]) % 64, 0U);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(planes[1]) % 64, 0U);
+
+	const size_t planeBytes = static_cast<size_t>(buffer.capacitySamples()) * sizeof(float);
+	EXPECT_GE(static_cast<size_t>(planes[1] - planes[0]), planeBytes);
+	std::memset(planes[0], 0x11, planeBytes);
+	std::memset(planes[1], 0x22, planeBytes);
+	EXPECT_EQ(planes[0][planeBytes - 1], 0x11);
+	EXPECT_EQ(planes[1][0], 0x22);
+}
+
+TEST(AudioOutputTest, PlaneBufferRejectsOutOfRangeRequests)
+{
+	AudioPlaneBuffer buffer;
+	EXPECT_FALSE(buffer.reserve(0, 960, sizeof(float)));
+	EXPECT_FALSE(buffer.reserve(AudioPlaneBuffer::kMaxPlanes + 1, 960, sizeof(float)));
+	EXPECT_FALSE(buffer.reserve(2, 0, sizeof(float)));
+	EXPECT_FALSE(buffer.reserve(2, 960, 0));
+	EXPECT_EQ(buffer.allocations(), 0U);
+	EXPECT_EQ(buffer.planes()[0], nullptr);
+}
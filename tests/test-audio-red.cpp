@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include "vdoninja-audio-red.h"
+#include "vdoninja-utils.h"
 
 using namespace vdoninja;
 
@@ -110,6 +111,75 @@ TEST(AudioRedTest, SelectsRedOnlyWhenAnswerPrefersAValidMapping)
 	                                   "a=rtpmap:111 opus/48000/2\r\n"));
 }
 
+TEST(AudioRedTest, ParsesRedundantAndPrimaryBlocksBuiltBySender)
+{
+	const std::vector<uint8_t> previous{0xAA, 0xBB, 0xCC};
+	const std::vector<uint8_t> current{0x11, 0x22};
+	const AudioRedPayload payload =
+	    buildAudioRedPayload(current.data(), current.size(), 1920, previous.data(), previous.size(), 960);
+
+	std::vector<AudioRedBlock> blocks;
+	ASSERT_TRUE(parseAudioRedPayload(payload.bytes.data(), payload.bytes.size(), blocks));
+	ASSERT_EQ(blocks.size(), 2U);
+	EXPECT_EQ(blocks[0].payloadType, kDefaultOpusPayloadType);
+	EXPECT_EQ(blocks[0].timestampOffset, 960U);
+	EXPECT_EQ(std::vector<uint8_t>(blocks[0].data, blocks[0].data + blocks[0].size), previous);
+	EXPECT_EQ(blocks[1].payloadType, kDefaultOpusPayloadType);
+	EXPECT_EQ(blocks[1].timestampOffset, 0U);
+	EXPECT_EQ(std::vector<uint8_t>(blocks[1].data, blocks[1].data + blocks[1].size), current);
+
+	const AudioRedPayload primaryOnly =
+	    buildAudioRedPayload(current.data(), current.size(), 960, nullptr, 0, 0, kDefaultOpusPayloadType);
+	ASSERT_TRUE(parseAudioRedPayload(primaryOnly.bytes.data(), primaryOnly.bytes.size(), blocks));
+	ASSERT_EQ(blocks.size(), 1U);
+	EXPECT_EQ(blocks[0].size, current.size());
+
+	// Two redundant blocks (offsets 1920 and 960) ahead of the primary.
+	const std::vector<uint8_t> twoRedundant{0xEF, 0x1E, 0x00, 0x01, 0xEF, 0x0F, 0x00, 0x01, 0x6F, 0xA1, 0xB2, 0xC3};
+	ASSERT_TRUE(parseAudioRedPayload(twoRedundant.data(), twoRedundant.size(), blocks));
+	ASSERT_EQ(blocks.size(), 3U);
+	EXPECT_EQ(blocks[0].timestampOffset, 1920U);
+	EXPECT_EQ(blocks[0].data[0], 0xA1);
+	EXPECT_EQ(blocks[1].timestampOffset, 960U);
+	EXPECT_EQ(blocks[1].data[0], 0xB2);
+	EXPECT_EQ(blocks[2].data[0], 0xC3);
+	EXPECT_EQ(blocks[2].size, 1U);
+}
+
+TEST(AudioRedTest, RejectsTruncatedRedPayloads)
+{
+	std::vector<AudioRedBlock> blocks;
+	EXPECT_FALSE(parseAudioRedPayload(nullptr, 0, blocks));
+
+	const std::vector<uint8_t> truncatedHeader{0xEF, 0x0F, 0x00};
+	EXPECT_FALSE(parseAudioRedPayload(truncatedHeader.data(), truncatedHeader.size(), blocks));
+	const std::vector<uint8_t> missingPrimaryHeader{0xEF, 0x0F, 0x00, 0x01};
+	EXPECT_FALSE(parseAudioRedPayload(missingPrimaryHeader.data(), missingPrimaryHeader.size(), blocks));
+	const std::vector<uint8_t> overrunningLength{0xEF, 0x0F, 0x00, 0x04, 0x6F, 0xAA, 0xBB};
+	EXPECT_FALSE(parseAudioRedPayload(overrunningLength.data(), overrunningLength.size(), blocks));
+	EXPECT_TRUE(blocks.empty());
+}
+
+TEST(AudioRedTest, FindsOfferedRedForTheChosenOpusPayloadType)
+{
+	const auto sections = parseOfferedMediaSections("v=0\r\n"
+	                                                "m=audio 9 UDP/TLS/RTP/SAVPF 111 63 110\r\n"
+	                                                "a=rtpmap:111 opus/48000/2\r\n"
+	                                                "a=rtpmap:63 red/48000/2\r\n"
+	                                                "a=fmtp:63 111/111\r\n"
+	                                                "a=rtpmap:110 opus/48000/2\r\n");
+	ASSERT_EQ(sections.size(), 1U);
+	EXPECT_EQ(findOfferedAudioRedPayloadType(sections[0], 111), 63);
+	EXPECT_EQ(findOfferedAudioRedPayloadType(sections[0], 110), -1);
+	EXPECT_EQ(findOfferedAudioRedPayloadType(sections[0], -1), -1);
+
+	const auto withoutRed = parseOfferedMediaSections("v=0\r\n"
+	                                                  "m=audio 9 UDP/TLS/RTP/SAVPF 111\r\n"
+	                                                  "a=rtpmap:111 opus/48000/2\r\n");
+	ASSERT_EQ(withoutRed.size(), 1U);
+	EXPECT_EQ(findOfferedAudioRedPayloadType(withoutRed[0], 111), -1);
+}
+
 TEST(AudioRedFuzzTest, RandomPayloadsPreservePrimaryAndBoundRedundancy)
 {
 	std::mt19937 rng(0x2198F00D);
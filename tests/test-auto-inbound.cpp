@@ -84,3 +84,56 @@ TEST(AutoInboundSceneAssignmentStateTest, ReaddingASourceReplacesItsPreviousScen
 
 	EXPECT_EQ(state.take("VDO_Cam_guest"), "scene-b-uuid");
 }
+
+TEST(AutoInboundUiBatchTest, CoalescesChurnIntoOneFlushAfterTheWindow)
+{
+	AutoInboundUiBatch<std::string> batch(100);
+	EXPECT_TRUE(batch.empty());
+	EXPECT_EQ(batch.flushDeadlineMs(), 0);
+
+	for (int i = 0; i < 15; ++i) {
+		const std::string name = "guest" + std::to_string(i);
+		batch.put(name, "add:" + name, 1000 + i);
+		batch.markLayoutDirty(1000 + i);
+	}
+	EXPECT_EQ(batch.flushDeadlineMs(), 1100);
+
+	const auto flush = batch.take();
+	EXPECT_EQ(flush.changes.size(), 15u);
+	EXPECT_EQ(flush.changes.front(), "add:guest0");
+	EXPECT_EQ(flush.changes.back(), "add:guest14");
+	EXPECT_TRUE(flush.layoutDirty);
+	EXPECT_TRUE(batch.empty());
+	EXPECT_EQ(batch.flushDeadlineMs(), 0);
+}
+
+TEST(AutoInboundUiBatchTest, KeepsOnlyTheLatestChangePerSource)
+{
+	AutoInboundUiBatch<std::string> batch(100);
+	batch.put("a", "add:a", 1000);
+	batch.put("b", "add:b", 1010);
+	batch.put("a", "remove:a", 1020);
+	batch.put("b", "remove:b", 1030);
+	batch.put("b", "add:b", 1040);
+
+	const auto flush = batch.take();
+	ASSERT_EQ(flush.changes.size(), 2u);
+	EXPECT_EQ(flush.changes[0], "remove:a");
+	EXPECT_EQ(flush.changes[1], "add:b");
+	EXPECT_FALSE(flush.layoutDirty);
+}
+
+TEST(AutoInboundUiBatchTest, WindowDoesNotSlideWithSteadyChurn)
+{
+	AutoInboundUiBatch<std::string> batch(100);
+	batch.put("a", "add:a", 1000);
+	batch.put("b", "add:b", 1090);
+	batch.markLayoutDirty(1099);
+	EXPECT_EQ(batch.flushDeadlineMs(), 1100);
+
+	batch.take();
+	batch.markLayoutDirty(2000);
+	EXPECT_FALSE(batch.empty());
+	EXPECT_EQ(batch.flushDeadlineMs(), 2100);
+	EXPECT_TRUE(batch.take().changes.empty());
+}
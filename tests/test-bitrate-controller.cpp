@@ -1,13 +1,16 @@
 /*
- * Unit tests for conservative REMB-driven bitrate adaptation
+ * Unit tests for conservative REMB- and loss-driven bitrate adaptation
  * SPDX-License-Identifier: AGPL-3.0-only
  */
 
 #include <chrono>
+#include <cstdint>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "vdoninja-bitrate-controller.h"
+#include "vdoninja-rtcp-feedback.h"
 
 using namespace std::chrono_literals;
 using namespace vdoninja;
@@ -26,6 +29,109 @@ BitrateControllerConfig controllerConfig()
 	return config;
 }
 
+constexpr uint32_t kMediaSsrc = 0x22222222;
+constexpr uint32_t kLastSenderReport = 0x10000000;
+constexpr auto kFreshFeedback = std::chrono::milliseconds(60000);
+
+void appendU32(std::vector<uint8_t> &packet, uint32_t value)
+{
+	packet.push_back(static_cast<uint8_t>(value >> 24));
+	packet.push_back(static_cast<uint8_t>(value >> 16));
+	packet.push_back(static_cast<uint8_t>(value >> 8));
+	packet.push_back(static_cast<uint8_t>(value));
+}
+
+void setRtcpLength(std::vector<uint8_t> &packet, size_t start)
+{
+	const uint16_t wordsMinusOne = static_cast<uint16_t>((packet.size() - start) / 4U - 1U);
+	packet[start + 2] = static_cast<uint8_t>(wordsMinusOne >> 8);
+	packet[start + 3] = static_cast<uint8_t>(wordsMinusOne);
+}
+
+void appendReceiverReport(std::vector<uint8_t> &packet, uint8_t fractionLost, uint32_t cumulativeLost)
+{
+	const size_t start = packet.size();
+	packet.insert(packet.end(), {0x81, 201, 0, 0});
+	appendU32(packet, 0x11111111);
+	appendU32(packet, kMediaSsrc);
+	packet.push_back(fractionLost);
+	packet.push_back(static_cast<uint8_t>(cumulativeLost >> 16));
+	packet.push_back(static_cast<uint8_t>(cumulativeLost >> 8));
+	packet.push_back(static_cast<uint8_t>(cumulativeLost));
+	appendU32(packet, 1234);
+	appendU32(packet, 90);
+	appendU32(packet, kLastSenderReport);
+	appendU32(packet, 0);
+	setRtcpLength(packet, start);
+}
+
+void appendRemb(std::vector<uint8_t> &packet, uint64_t bitsPerSecond)
+{
+	uint8_t exponent = 0;
+	while ((bitsPerSecond >> exponent) > 0x3FFFFU) {
+		++exponent;
+	}
+	const uint32_t mantissa = static_cast<uint32_t>(bitsPerSecond >> exponent);
+	const size_t start = packet.size();
+	packet.insert(packet.end(), {0x8F, 206, 0, 0});
+	appendU32(packet, 0x11111111);
+	appendU32(packet, 0);
+	packet.insert(packet.end(), {'R', 'E', 'M', 'B', 1});
+	packet.push_back(static_cast<uint8_t>((exponent << 2U) | ((mantissa >> 16U) & 0x03U)));
+	packet.push_back(static_cast<uint8_t>(mantissa >> 8U));
+	packet.push_back(static_cast<uint8_t>(mantissa));
+	appendU32(packet, kMediaSsrc);
+	setRtcpLength(packet, start);
+}
+
+// One compound RTCP packet as a browser viewer would send it. The compact NTP
+// arrival time is chosen so the LSR/DLSR round trip comes out at rttMs.
+struct RecordedRtcp {
+	uint8_t fractionLost = 0;
+	uint32_t cumulativeLost = 0;
+	uint32_t rttMs = 0;
+	uint64_t rembBitsPerSecond = 0;
+};
+
+// Replays a trace through the same parser the media path uses and returns
+// what the per-viewer estimator produced after each packet.
+class RtcpTraceReplay
+{
+public:
+	explicit RtcpTraceReplay(std::string viewerId) : tracker_(kMediaSsrc) { feedback_.viewerId = std::move(viewerId); }
+
+	const ViewerCongestionFeedback &play(const RecordedRtcp &entry)
+	{
+		std::vector<uint8_t> compound;
+		appendReceiverReport(compound, entry.fractionLost, entry.cumulativeLost);
+		if (entry.rembBitsPerSecond > 0) {
+			appendRemb(compound, entry.rembBitsPerSecond);
+		}
+		// Round up so the tracker's truncating conversion lands on rttMs.
+		const uint32_t roundTripUnits = static_cast<uint32_t>((entry.rttMs * 65536ULL + 999U) / 1000U);
+		tracker_.observe(compound.data(), compound.size(), kLastSenderReport + roundTripUnits);
+		return poll();
+	}
+
+	const ViewerCongestionFeedback &poll()
+	{
+		const auto remb = tracker_.latestRemb(kFreshFeedback);
+		feedback_.rembBitsPerSecond =
+		    remb ? std::optional<uint64_t>(remb->bitrateBitsPerSecond) : std::optional<uint64_t>();
+		const auto report = tracker_.latestReceiverReport(kFreshFeedback);
+		feedback_.reportSequence = report ? report->sequence : 0;
+		feedback_.fractionLost = report ? report->fractionLost : 0;
+		feedback_.rttMs = report ? report->rttMs : std::nullopt;
+		return feedback_;
+	}
+
+private:
+	RtcpFeedbackTracker tracker_;
+	ViewerCongestionFeedback feedback_;
+};
+
+constexpr uint64_t kSendingBps = 4000000;
+
 } // namespace
 
 TEST(BitrateControllerTest, MissingFeedbackNeverChangesBitrate)
@@ -118,3 +224,123 @@ TEST(BitrateControllerTest, MissingFeedbackBreaksDecreaseConfirmation)
 	EXPECT_FALSE(controller.observe(2000000, start + 2s).has_value());
 	EXPECT_EQ(controller.currentBitrateBitsPerSecond(), 8000000u);
 }
+
+TEST(BitrateControllerTraceTest, LossBacksOffAboveTenPercentAndHoldsInTheMiddleBand)
+{
+	RtcpTraceReplay replay("viewer");
+	ViewerCongestionEstimator estimator;
+
+	// A clean path grows the loss-based target 8% per report.
+	EXPECT_EQ(estimator.update(replay.play({0, 0, 40, 0}), kSendingBps), 4320000u);
+	EXPECT_EQ(estimator.update(replay.play({0, 0, 40, 0}), kSendingBps), 4665600u);
+	// 25% loss halves that rate off what is actually being sent, not off the
+	// headroom the target had grown into.
+	EXPECT_EQ(estimator.update(replay.play({64, 40, 40, 0}), kSendingBps), 3500000u);
+	EXPECT_EQ(estimator.update(replay.play({64, 80, 40, 0}), kSendingBps), 3062500u);
+	// About 5% loss neither backs off nor grows.
+	EXPECT_EQ(estimator.update(replay.play({13, 88, 40, 0}), kSendingBps), 3062500u);
+	// Polling again before the next report does not move the target twice.
+	EXPECT_EQ(estimator.update(replay.poll(), kSendingBps), 3062500u);
+	EXPECT_EQ(estimator.update(replay.play({0, 88, 40, 0}), kSendingBps), 3307500u);
+}
+
+TEST(BitrateControllerTraceTest, LossTargetNeverRunsFarAheadOfTheSendingRate)
+{
+	RtcpTraceReplay replay("viewer");
+	ViewerCongestionEstimator estimator;
+	for (int report = 0; report < 20; ++report) {
+		estimator.update(replay.play({0, 0, 40, 0}), kSendingBps);
+	}
+	EXPECT_EQ(estimator.lossBasedBitsPerSecond(), 6000000u);
+	// REMB still caps the viewer target.
+	EXPECT_EQ(estimator.update(replay.play({0, 0, 40, 2500000}), kSendingBps), 2500000u);
+}
+
+TEST(BitrateControllerTraceTest, RisingRttBacksOffBeforeLossAppears)
+{
+	RtcpTraceReplay replay("viewer");
+	ViewerCongestionEstimator estimator;
+	for (uint32_t rtt : {50U, 50U, 50U, 90U, 130U}) {
+		estimator.update(replay.play({0, 0, rtt, 0}), kSendingBps);
+		EXPECT_FALSE(estimator.rttRising()) << rtt;
+	}
+	ASSERT_GT(*estimator.lossBasedBitsPerSecond(), kSendingBps);
+
+	// The smoothed RTT is now 50 ms above the 50 ms floor and still climbing.
+	EXPECT_EQ(estimator.update(replay.play({0, 0, 170, 0}), kSendingBps), 3400000u);
+	EXPECT_TRUE(estimator.rttRising());
+	// A plateau at the inflated RTT is still a standing queue.
+	EXPECT_EQ(estimator.update(replay.play({0, 0, 100, 0}), kSendingBps), 2890000u);
+	// Once RTT falls the target may grow again.
+	EXPECT_EQ(estimator.update(replay.play({0, 0, 60, 0}), kSendingBps), 3121200u);
+	EXPECT_FALSE(estimator.rttRising());
+}
+
+TEST(BitrateControllerTraceTest, ReportsWithoutRoundTripDataOnlyUseLoss)
+{
+	RtcpFeedbackTracker tracker(kMediaSsrc);
+	std::vector<uint8_t> packet;
+	appendReceiverReport(packet, 0, 0);
+	// No compact NTP time, so no RTT can be derived.
+	tracker.observe(packet.data(), packet.size());
+	const auto report = tracker.latestReceiverReport(kFreshFeedback);
+	ASSERT_TRUE(report.has_value());
+	EXPECT_EQ(report->sequence, 1u);
+	EXPECT_FALSE(report->rttMs.has_value());
+
+	ViewerCongestionEstimator estimator;
+	ViewerCongestionFeedback feedback;
+	feedback.reportSequence = report->sequence;
+	EXPECT_EQ(estimator.update(feedback, kSendingBps), 4320000u);
+	EXPECT_FALSE(estimator.rttRising());
+}
+
+TEST(BitrateControllerTraceTest, BlendedEstimateWaitsForEveryViewerAndFollowsTheWorst)
+{
+	RtcpTraceReplay clean("clean");
+	RtcpTraceReplay lossy("lossy");
+	BlendedBitrateEstimator blended;
+	ViewerCongestionFeedback silent;
+	silent.viewerId = "silent";
+
+	EXPECT_FALSE(blended.estimate({clean.play({0, 0, 40, 5000000}), silent}, kSendingBps).has_value());
+	EXPECT_EQ(blended.viewerCount(), 2u);
+
+	// The lossy viewer's REMB looks fine; its loss reports are what limit it.
+	const auto estimate =
+	    blended.estimate({clean.play({0, 0, 40, 5000000}), lossy.play({77, 300, 40, 6000000})}, kSendingBps);
+	ASSERT_TRUE(estimate.has_value());
+	EXPECT_EQ(*estimate, 4000000u - 4000000u * 77u / 512u);
+	EXPECT_EQ(blended.limitingViewer(), "lossy");
+	EXPECT_EQ(blended.viewerCount(), 2u);
+
+	// A viewer that left is forgotten.
+	EXPECT_EQ(blended.estimate({clean.poll()}, kSendingBps), 4665600u);
+	EXPECT_EQ(blended.viewerCount(), 1u);
+	EXPECT_FALSE(blended.estimate({}, kSendingBps).has_value());
+}
+
+TEST(BitrateControllerTraceTest, SustainedLossDrivesTheStagedController)
+{
+	BitrateControllerConfig config = controllerConfig();
+	config.maximumBitrateBitsPerSecond = kSendingBps;
+	BitrateController controller(config);
+	BlendedBitrateEstimator blended;
+	RtcpTraceReplay replay("viewer");
+	const auto start = BitrateController::Clock::time_point{};
+
+	// REMB alone would keep the full rate; 25% loss at one report per second
+	// brings it down after the usual two confirming samples.
+	std::vector<std::optional<uint64_t>> changes;
+	for (int second = 0; second < 4; ++second) {
+		const auto estimate = blended.estimate({replay.play({64, 0, 40, 8000000})},
+		                                       controller.currentBitrateBitsPerSecond());
+		changes.push_back(controller.observe(estimate, start + std::chrono::seconds(second)));
+	}
+	EXPECT_FALSE(changes[0].has_value());
+	ASSERT_TRUE(changes[1].has_value());
+	EXPECT_LT(*changes[1], kSendingBps);
+	EXPECT_FALSE(changes[2].has_value());
+	ASSERT_TRUE(changes[3].has_value());
+	EXPECT_LT(*changes[3], *changes[1]);
+}
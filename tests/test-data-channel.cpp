@@ -942,6 +942,25 @@ TEST_F(DataChannelTest, ParsesOfficialRestartWhipControlMessage)
 	EXPECT_EQ(msg.data, raw);
 }
 
+TEST_F(DataChannelTest, ExtractsViewerRoleFromOfficialInfo)
+{
+	ViewerRoleUpdate scene = dataChannel.parseViewerRole(R"({"info":{"label":"Cam","scene":"1","director":false}})");
+	EXPECT_TRUE(scene.hasScene);
+	EXPECT_TRUE(scene.scene);
+	EXPECT_TRUE(scene.hasDirector);
+	EXPECT_FALSE(scene.director);
+
+	ViewerRoleUpdate director = dataChannel.parseViewerRole(R"({"info":{"scene":false,"director":true}})");
+	EXPECT_TRUE(director.hasScene);
+	EXPECT_FALSE(director.scene);
+	EXPECT_TRUE(director.director);
+
+	// A top-level scene is a remote scene switch, not the viewer's own role.
+	ViewerRoleUpdate none = dataChannel.parseViewerRole(R"({"remote":"x","scene":"Main"})");
+	EXPECT_FALSE(none.hasScene);
+	EXPECT_FALSE(none.hasDirector);
+}
+
 TEST_F(DataChannelTest, ExtractsOfficialRecoveryControl)
 {
 	RecoveryControlUpdate update = dataChannel.parseRecoveryControl(
@@ -1924,6 +1943,7 @@ TEST_F(DataChannelEdgeCaseTest, FuzzesOfficialMessageParserAndExtractors)
 		ReceiverVideoSuppressionUpdate suppression = dataChannel.parseReceiverVideoSuppression(message);
 		(void)dataChannel.parseDirectorAudioState(message);
 		(void)dataChannel.parseDirectorTransformState(message);
+		(void)dataChannel.parseViewerRole(message);
 		(void)dataChannel.parseRecoveryControl(message);
 		(void)dataChannel.parseMeshControl(message);
 		(void)dataChannel.recoveryControlRejectionName(message);
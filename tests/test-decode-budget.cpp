@@ -0,0 +1,178 @@
+/*
+ * Unit tests for latency-bounded native video decode admission
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "vdoninja-decode-budget.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+// 1 kHz RTP clock: one tick per millisecond keeps the arithmetic readable.
+constexpr uint32_t kClockRate = 1000;
+constexpr int64_t kBudgetUs = 200000;
+constexpr uint32_t kFrameTicks = 33;
+constexpr int64_t kFrameUs = 33000;
+
+const EncodedVideoFrameInfo kReferenceFrame{false, true};
+const EncodedVideoFrameInfo kNonReferenceFrame{false, false};
+const EncodedVideoFrameInfo kKeyframe{true, true};
+
+} // namespace
+
+TEST(DecodeFrameInspectionTest, ClassifiesH264AccessUnits)
+{
+	const std::vector<uint8_t> idr = {0, 0, 0, 1, 0x67, 0x42, 0, 0, 0, 1, 0x68, 0xCE, 0, 0, 1, 0x65, 0x88};
+	const auto idrInfo = inspectH264AccessUnit(idr.data(), idr.size());
+	EXPECT_TRUE(idrInfo.keyframe);
+	EXPECT_TRUE(idrInfo.reference);
+
+	const std::vector<uint8_t> referenceSlice = {0, 0, 0, 1, 0x41, 0x9A};
+	EXPECT_TRUE(inspectH264AccessUnit(referenceSlice.data(), referenceSlice.size()).reference);
+
+	const std::vector<uint8_t> disposableSlice = {0, 0, 0, 1, 0x06, 0x05, 0, 0, 0, 1, 0x01, 0x9E};
+	const auto disposable = inspectH264AccessUnit(disposableSlice.data(), disposableSlice.size());
+	EXPECT_FALSE(disposable.keyframe);
+	EXPECT_FALSE(disposable.reference);
+
+	EXPECT_TRUE(inspectH264AccessUnit(nullptr, 0).reference);
+}
+
+TEST(DecodeFrameInspectionTest, FindsRecoveryPointSeiBehindOtherMessages)
+{
+	// SEI: user data unregistered (type 5, 3 bytes holding an emulation
+	// prevention byte), then recovery_point (type 6), then trailing bits.
+	const std::vector<uint8_t> refresh = {0, 0, 0, 1, 0x06, 0x05, 0x03, 0, 0, 3, 1, 0x06, 0x01, 0x84, 0x80,
+	                                      0, 0, 0, 1, 0x41, 0x9A};
+	const auto refreshInfo = inspectH264AccessUnit(refresh.data(), refresh.size());
+	EXPECT_TRUE(refreshInfo.recoveryPoint);
+	EXPECT_FALSE(refreshInfo.keyframe);
+
+	// Only user data: the payload size must be read past the escape.
+	const std::vector<uint8_t> userData = {0, 0, 1, 0x06, 0x05, 0x03, 0, 0, 3, 6, 0x80, 0, 0, 1, 0x41, 0x9A};
+	EXPECT_FALSE(inspectH264AccessUnit(userData.data(), userData.size()).recoveryPoint);
+
+	// A truncated SEI is not a recovery point.
+	const std::vector<uint8_t> truncated = {0, 0, 1, 0x06, 0xFF};
+	EXPECT_FALSE(inspectH264AccessUnit(truncated.data(), truncated.size()).recoveryPoint);
+}
+
+TEST(DecodeFrameInspectionTest, ClassifiesVp9UncompressedHeaders)
+{
+	// frame_marker=2, profile 0, show_existing=0, frame_type=KEY, show=1.
+	const uint8_t keyframe[] = {0x82, 0x49, 0x83, 0x42};
+	EXPECT_TRUE(inspectVP9Frame(keyframe, sizeof(keyframe)).keyframe);
+
+	// Inter frame, reset_frame_context=0, refresh_frame_flags=0x01.
+	const uint8_t referenceInter[] = {0x86, 0x00, 0x40};
+	const auto reference = inspectVP9Frame(referenceInter, sizeof(referenceInter));
+	EXPECT_FALSE(reference.keyframe);
+	EXPECT_TRUE(reference.reference);
+
+	const uint8_t disposableInter[] = {0x86, 0x00, 0x00};
+	EXPECT_FALSE(inspectVP9Frame(disposableInter, sizeof(disposableInter)).reference);
+
+	const uint8_t showExisting[] = {0x88};
+	EXPECT_FALSE(inspectVP9Frame(showExisting, sizeof(showExisting)).reference);
+
+	const uint8_t truncated[] = {0x86};
+	EXPECT_TRUE(inspectVP9Frame(truncated, sizeof(truncated)).reference);
+}
+
+TEST(DecodeLatencyBudgetTest, RealTimeArrivalDecodesEveryFrame)
+{
+	DecodeLatencyBudget budget(kBudgetUs, kClockRate);
+	for (uint32_t i = 0; i < 100; ++i) {
+		const int64_t jitterUs = (i % 3) * 5000;
+		const auto result = budget.admit(i * kFrameTicks, i * kFrameUs + jitterUs, kNonReferenceFrame);
+		EXPECT_EQ(result.action, DecodeAdmission::Decode);
+	}
+
+	const auto stats = budget.getStats();
+	EXPECT_EQ(stats.decodedFrames, 100u);
+	EXPECT_EQ(stats.droppedNonReferenceFrames, 0u);
+	EXPECT_LE(stats.maxLagUs, 10000);
+}
+
+TEST(DecodeLatencyBudgetTest, DegradesThenDropsNonReferenceFrames)
+{
+	DecodeLatencyBudget budget(kBudgetUs, kClockRate);
+	budget.admit(0, 0, kKeyframe);
+
+	EXPECT_EQ(budget.admit(kFrameTicks, kFrameUs + 150000, kReferenceFrame).action, DecodeAdmission::DecodeDegraded);
+	EXPECT_EQ(budget.admit(2 * kFrameTicks, 2 * kFrameUs + 250000, kNonReferenceFrame).action,
+	          DecodeAdmission::DropNonReference);
+	EXPECT_EQ(budget.admit(3 * kFrameTicks, 3 * kFrameUs + 250000, kReferenceFrame).action,
+	          DecodeAdmission::DecodeDegraded);
+	// Hysteresis: still degraded until lag falls below a quarter of the budget.
+	EXPECT_EQ(budget.admit(4 * kFrameTicks, 4 * kFrameUs + 80000, kReferenceFrame).action,
+	          DecodeAdmission::DecodeDegraded);
+	EXPECT_EQ(budget.admit(5 * kFrameTicks, 5 * kFrameUs + 10000, kReferenceFrame).action, DecodeAdmission::Decode);
+
+	const auto stats = budget.getStats(true);
+	EXPECT_EQ(stats.droppedNonReferenceFrames, 1u);
+	EXPECT_EQ(stats.degradedFrames, 3u);
+	EXPECT_NEAR(static_cast<double>(stats.recoveredLatencyUs), 240000.0, 1000.0);
+	EXPECT_EQ(budget.getStats().droppedNonReferenceFrames, 0u);
+}
+
+TEST(DecodeLatencyBudgetTest, SkipsToKeyframeWhenFarBehind)
+{
+	DecodeLatencyBudget budget(kBudgetUs, kClockRate);
+	budget.admit(0, 0, kKeyframe);
+
+	const auto first = budget.admit(kFrameTicks, kFrameUs + 500000, kReferenceFrame);
+	EXPECT_EQ(first.action, DecodeAdmission::SkipToKeyframe);
+	EXPECT_TRUE(first.requestKeyframe);
+	EXPECT_TRUE(first.flushDecoder);
+
+	const auto second = budget.admit(2 * kFrameTicks, 2 * kFrameUs + 100000, kReferenceFrame);
+	EXPECT_EQ(second.action, DecodeAdmission::SkipToKeyframe);
+	EXPECT_FALSE(second.requestKeyframe);
+	EXPECT_FALSE(second.flushDecoder);
+
+	// Still skipping a second later, so the keyframe request is repeated.
+	const auto later = budget.admit(30 * kFrameTicks, 30 * kFrameUs + 1000000 + 20000, kReferenceFrame);
+	EXPECT_EQ(later.action, DecodeAdmission::SkipToKeyframe);
+	EXPECT_TRUE(later.requestKeyframe);
+
+	EXPECT_NE(budget.admit(31 * kFrameTicks, 31 * kFrameUs + 20000, kKeyframe).action,
+	          DecodeAdmission::SkipToKeyframe);
+	EXPECT_EQ(budget.admit(32 * kFrameTicks, 32 * kFrameUs + 10000, kReferenceFrame).action, DecodeAdmission::Decode);
+
+	const auto stats = budget.getStats();
+	EXPECT_EQ(stats.keyframeSkips, 1u);
+	EXPECT_EQ(stats.skippedToKeyframeFrames, 3u);
+	EXPECT_NEAR(static_cast<double>(stats.maxLagUs), 1020000.0, 2000.0);
+	EXPECT_NEAR(static_cast<double>(stats.recoveredLatencyUs), 1000000.0, 2000.0);
+}
+
+TEST(DecodeLatencyBudgetTest, ClockDriftIsNotMistakenForBacklog)
+{
+	DecodeLatencyBudget budget(kBudgetUs, kClockRate);
+	// Receiver clock runs 200 ppm fast for ten minutes: 120 ms of drift.
+	for (uint32_t i = 0; i < 18000; ++i) {
+		const int64_t mediaUs = static_cast<int64_t>(i) * kFrameUs;
+		const auto result = budget.admit(i * kFrameTicks, mediaUs + mediaUs / 5000, kReferenceFrame);
+		ASSERT_EQ(result.action, DecodeAdmission::Decode) << "frame " << i;
+	}
+}
+
+TEST(DecodeLatencyBudgetTest, DisabledBudgetOnlyCounts)
+{
+	DecodeLatencyBudget budget(0, kClockRate);
+	budget.admit(0, 0, kKeyframe);
+	EXPECT_EQ(budget.admit(kFrameTicks, kFrameUs + 5000000, kNonReferenceFrame).action, DecodeAdmission::Decode);
+	EXPECT_EQ(budget.getStats().decodedFrames, 2u);
+	EXPECT_GT(budget.getStats().maxLagUs, 4990000);
+
+	budget.setBudgetUs(kBudgetUs);
+	budget.reset();
+	EXPECT_EQ(budget.admit(0, 10000000, kReferenceFrame).action, DecodeAdmission::Decode);
+}
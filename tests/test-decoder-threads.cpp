@@ -0,0 +1,126 @@
+/*
+ * Unit tests for the process-wide decoder thread budget
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-decoder-threads.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+const DecoderLoad k1080p30{1920, 1080, 30.0};
+const DecoderLoad k720p30{1280, 720, 30.0};
+const DecoderLoad k2160p60{3840, 2160, 60.0};
+
+int sum(const std::vector<int> &threads)
+{
+	return std::accumulate(threads.begin(), threads.end(), 0);
+}
+
+} // namespace
+
+TEST(DecoderThreadsTest, LoneDecodersGetThreadsForTheirPixelRate)
+{
+	EXPECT_EQ(decoderThreadShare(16), 12);
+	EXPECT_EQ(decoderThreadShare(2), 2);
+	EXPECT_EQ(decoderThreadShare(0), 3);
+
+	EXPECT_EQ(allocateDecoderThreads({k1080p30}, 16), std::vector<int>({4}));
+	EXPECT_EQ(allocateDecoderThreads({k720p30}, 16), std::vector<int>({2}));
+	EXPECT_EQ(allocateDecoderThreads({k2160p60}, 64), std::vector<int>({8}));
+	EXPECT_EQ(allocateDecoderThreads({{16, 16, 30.0}}, 16), std::vector<int>({1}));
+	// Unknown sizes and rates are treated as 1080p30.
+	EXPECT_EQ(allocateDecoderThreads({{0, 0, 0.0}}, 16), std::vector<int>({4}));
+	// Small machines still frame-thread a lone decoder.
+	EXPECT_EQ(allocateDecoderThreads({k1080p30}, 2), std::vector<int>({2}));
+}
+
+TEST(DecoderThreadsTest, ManySourcesShareTheMachineInProportionToLoad)
+{
+	const std::vector<DecoderLoad> tenSources(10, k1080p30);
+	const std::vector<int> threads = allocateDecoderThreads(tenSources, 16);
+	EXPECT_EQ(sum(threads), 12);
+	for (const int count : threads) {
+		EXPECT_GE(count, 1);
+		EXPECT_LE(count, 2);
+	}
+
+	// The 4K stream wants the cap and the 720p stream two; six threads are
+	// split in proportion to what each asked for.
+	EXPECT_EQ(allocateDecoderThreads({k2160p60, k720p30}, 8), std::vector<int>({5, 1}));
+
+	// Past one thread each, every decoder still gets one.
+	const std::vector<DecoderLoad> twentySources(20, k720p30);
+	EXPECT_EQ(sum(allocateDecoderThreads(twentySources, 8)), 20);
+}
+
+TEST(DecoderThreadsTest, ReopensOnlyForMaterialChanges)
+{
+	EXPECT_FALSE(decoderThreadsNeedReopen(4, 4));
+	EXPECT_FALSE(decoderThreadsNeedReopen(4, 3));
+	EXPECT_TRUE(decoderThreadsNeedReopen(4, 2));
+	EXPECT_TRUE(decoderThreadsNeedReopen(2, 1));
+	EXPECT_TRUE(decoderThreadsNeedReopen(1, 2));
+	EXPECT_FALSE(decoderThreadsNeedReopen(0, 4));
+}
+
+TEST(DecoderThreadsTest, BudgetRebalancesAsDecodersComeAndGo)
+{
+	DecoderThreadBudget budget(8);
+	ASSERT_EQ(budget.share(), 6);
+
+	DecoderThreadLease first(budget);
+	EXPECT_EQ(first.acquire(k1080p30), 4);
+	EXPECT_FALSE(first.needsReopen());
+
+	{
+		DecoderThreadLease second(budget);
+		DecoderThreadLease third(budget);
+		EXPECT_EQ(second.acquire(k1080p30), 3);
+		EXPECT_EQ(third.acquire(k1080p30), 2);
+		EXPECT_EQ(budget.decoders(), 3u);
+		EXPECT_EQ(budget.allottedThreads(), 6);
+		// The first decoder was opened with four and now has two.
+		EXPECT_TRUE(first.needsReopen());
+		EXPECT_EQ(first.acquire(first.load()), 2);
+	}
+
+	EXPECT_EQ(budget.decoders(), 1u);
+	EXPECT_TRUE(first.needsReopen());
+
+	// A measured frame rate close to the last one changes nothing; a new
+	// resolution does.
+	EXPECT_EQ(first.acquire(first.load()), 4);
+	first.update({1920, 1080, 29.97});
+	EXPECT_FALSE(first.needsReopen());
+	first.update({640, 360, 30.0});
+	EXPECT_TRUE(first.needsReopen());
+
+	first.release();
+	EXPECT_EQ(budget.decoders(), 0u);
+	EXPECT_FALSE(first.needsReopen());
+}
+
+TEST(DecoderThreadsTest, FrameRateIsMeasuredBetweenKeyframes)
+{
+	DecoderFrameRateMeter meter;
+	EXPECT_EQ(meter.noteFrame(1000, false), 0.0);
+	EXPECT_EQ(meter.noteFrame(4000, true), 0.0);
+	uint32_t timestamp = 4000;
+	for (int i = 0; i < 59; ++i) {
+		timestamp += 1500;
+		EXPECT_EQ(meter.noteFrame(timestamp, false), 0.0);
+	}
+	timestamp += 1500;
+	EXPECT_DOUBLE_EQ(meter.noteFrame(timestamp, true), 60.0);
+
+	// A timestamp jump is a restart, not a one-frame-per-minute stream.
+	EXPECT_EQ(meter.noteFrame(timestamp + 90000u * 120u, true), 0.0);
+}
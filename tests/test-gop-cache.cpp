@@ -0,0 +1,122 @@
+/*
+ * Unit tests for the current-GOP fast start cache
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-gop-cache.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+std::shared_ptr<const std::vector<uint8_t>> payload(size_t size, uint8_t fill = 1)
+{
+	return std::make_shared<const std::vector<uint8_t>>(size, fill);
+}
+
+constexpr uint64_t kEncoderBps = 4000000;
+constexpr uint64_t kPacerBps = 8000000;
+
+} // namespace
+
+TEST(GopCacheTest, CatchUpTimeAccountsForLiveVideoArrivingMeanwhile)
+{
+	// 100 KB at 8 Mbps against 4 Mbps of live video: 800 kbit / 4 Mbps spare.
+	EXPECT_EQ(gopCatchUpMs(100000, kPacerBps, kEncoderBps), 200);
+	EXPECT_EQ(gopCatchUpMs(0, kPacerBps, kEncoderBps), 0);
+	EXPECT_EQ(gopCatchUpMs(1000, kEncoderBps, kEncoderBps), -1);
+}
+
+TEST(GopCacheTest, ReplaysTheChainFromTheLatestKeyframe)
+{
+	GopCache cache;
+	EXPECT_TRUE(cache.replayFrames(kPacerBps, kEncoderBps).empty());
+
+	// Deltas before the first keyframe cannot be decoded and are not kept.
+	cache.append(payload(100), 1000, false);
+	EXPECT_FALSE(cache.complete());
+
+	cache.append(payload(4000, 7), 3000, true);
+	cache.append(payload(1000), 6000, false);
+	cache.append(payload(4000, 9), 9000, true);
+	cache.append(payload(1000), 12000, false);
+	cache.append(payload(1000), 15000, false);
+	ASSERT_TRUE(cache.complete());
+	EXPECT_EQ(cache.byteCount(), 6000u);
+
+	const std::vector<GopCacheFrame> frames = cache.replayFrames(kPacerBps, kEncoderBps);
+	ASSERT_EQ(frames.size(), 3u);
+	EXPECT_TRUE(frames[0].keyframe);
+	EXPECT_EQ(frames[0].timestamp, 9000u);
+	EXPECT_EQ((*frames[0].payload)[0], 9);
+	EXPECT_FALSE(frames[2].keyframe);
+	EXPECT_EQ(frames[2].timestamp, 15000u);
+}
+
+TEST(GopCacheTest, ReplaysShareFramePayloads)
+{
+	GopCache cache;
+	const auto keyframe = payload(4000);
+	cache.append(keyframe, 3000, true);
+
+	const std::vector<GopCacheFrame> frames = cache.replayFrames(kPacerBps, kEncoderBps);
+	ASSERT_EQ(frames.size(), 1u);
+	EXPECT_EQ(frames[0].payload.get(), keyframe.get());
+}
+
+TEST(GopCacheTest, LostLiveFrameBreaksTheChainUntilTheNextKeyframe)
+{
+	GopCache cache;
+	cache.append(payload(4000), 3000, true);
+	cache.append(payload(1000), 6000, false);
+	cache.invalidate();
+	cache.append(payload(1000), 12000, false);
+	EXPECT_FALSE(cache.complete());
+	EXPECT_TRUE(cache.replayFrames(kPacerBps, kEncoderBps).empty());
+
+	cache.append(payload(4000), 15000, true);
+	EXPECT_EQ(cache.replayFrames(kPacerBps, kEncoderBps).size(), 1u);
+}
+
+TEST(GopCacheTest, OversizedGopIsDroppedRatherThanReplayedPartially)
+{
+	GopCacheConfig config;
+	config.maxBytes = 6000;
+	GopCache cache(config);
+	cache.append(payload(4000), 3000, true);
+	cache.append(payload(1500), 6000, false);
+	cache.append(payload(1500), 9000, false);
+	EXPECT_FALSE(cache.complete());
+	EXPECT_EQ(cache.byteCount(), 0u);
+	EXPECT_EQ(cache.overflows(), 1u);
+
+	// Later deltas of the same GOP stay out; the next keyframe starts over.
+	cache.append(payload(100), 12000, false);
+	EXPECT_EQ(cache.frameCount(), 0u);
+	cache.append(payload(4000), 15000, true);
+	EXPECT_TRUE(cache.complete());
+	EXPECT_EQ(cache.overflows(), 1u);
+}
+
+TEST(GopCacheTest, LeavesLateJoinersToTheNextKeyframeWhenCatchUpIsTooSlow)
+{
+	GopCacheConfig config;
+	config.maxCatchUpMs = 1000;
+	GopCache cache(config);
+	cache.append(payload(100000), 3000, true);
+	// 800 kbit over 4 Mbps of spare pacer rate.
+	EXPECT_FALSE(cache.replayFrames(kPacerBps, kEncoderBps).empty());
+
+	for (int frame = 1; frame <= 45; ++frame) {
+		cache.append(payload(10000), 3000 + frame * 3000, false);
+	}
+	// 550 KB would hold the viewer more than a second behind live.
+	EXPECT_TRUE(cache.complete());
+	EXPECT_TRUE(cache.replayFrames(kPacerBps, kEncoderBps).empty());
+	// A pacer without headroom can never catch up.
+	cache.append(payload(100000), 200000, true);
+	EXPECT_TRUE(cache.replayFrames(kEncoderBps, kEncoderBps).empty());
+}
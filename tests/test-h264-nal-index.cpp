@@ -0,0 +1,123 @@
+/*
+ * Unit tests for the single-pass H.264 NAL index
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-h264-nal-index.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+// The byte-by-byte scan the index replaced.
+size_t naiveStartCode(const std::vector<uint8_t> &data, size_t from, size_t &length)
+{
+	for (size_t i = from; i + 3 <= data.size(); ++i) {
+		if (i + 4 <= data.size() && data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 0 && data[i + 3] == 1) {
+			length = 4;
+			return i;
+		}
+		if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+			length = 3;
+			return i;
+		}
+	}
+	length = 0;
+	return data.size();
+}
+
+} // namespace
+
+TEST(H264NalIndexTest, IndexesAnnexBUnitsWithShortAndLongStartCodes)
+{
+	const std::vector<uint8_t> data = {0, 0, 0, 1, 0x67, 0x42, 0xe0, 0x1f, 0, 0, 1, 0x68, 0xce,
+	                                   0, 0, 0, 1, 0x06, 0x05, 0x80, 0, 0, 1, 0x65, 0x88, 0x84};
+
+	H264NalIndex index;
+	ASSERT_TRUE(index.build(data.data(), data.size()));
+	EXPECT_EQ(index.format(), H264NalFormat::AnnexB);
+	ASSERT_EQ(index.units().size(), 4u);
+
+	EXPECT_EQ(index.units()[0].offset, 4u);
+	EXPECT_EQ(index.units()[0].size, 4u);
+	EXPECT_EQ(index.units()[0].type, kH264NalTypeSps);
+	EXPECT_EQ(index.units()[0].refIdc, 3u);
+	EXPECT_EQ(index.units()[1].offset, 11u);
+	EXPECT_EQ(index.units()[1].size, 2u);
+	// The zero before the long start code is that start code, not slice data.
+	EXPECT_EQ(index.units()[2].offset, 17u);
+	EXPECT_EQ(index.units()[2].size, 3u);
+	EXPECT_EQ(index.units()[2].type, kH264NalTypeSei);
+	EXPECT_EQ(index.units()[2].refIdc, 0u);
+	EXPECT_EQ(index.units()[3].type, kH264NalTypeIdrSlice);
+	EXPECT_EQ(index.units()[3].size, 3u);
+
+	ASSERT_NE(index.find(kH264NalTypeIdrSlice), nullptr);
+	EXPECT_EQ(index.find(kH264NalTypeIdrSlice)->offset, 23u);
+	EXPECT_EQ(index.find(kH264NalTypeNonIdrSlice), nullptr);
+}
+
+TEST(H264NalIndexTest, TrimsAlignmentZerosAndSkipsEmptyUnits)
+{
+	const std::vector<uint8_t> data = {0, 0, 1, 0x41, 0x9a, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0x01, 0x02, 0};
+
+	H264NalIndex index;
+	ASSERT_TRUE(index.build(data.data(), data.size()));
+	ASSERT_EQ(index.units().size(), 2u);
+	EXPECT_EQ(index.units()[0].size, 2u);
+	EXPECT_EQ(index.units()[0].type, kH264NalTypeNonIdrSlice);
+	EXPECT_EQ(index.units()[0].refIdc, 2u);
+	EXPECT_EQ(index.units()[1].offset, 15u);
+	EXPECT_EQ(index.units()[1].size, 2u);
+}
+
+TEST(H264NalIndexTest, FallsBackToAvccThenToOneUnit)
+{
+	const std::vector<uint8_t> avcc = {0, 0, 0, 2, 0x67, 0x42, 0, 0, 0, 0, 0, 0, 0, 3, 0x65, 0x88, 0x84};
+	H264NalIndex index;
+	ASSERT_TRUE(index.build(avcc.data(), avcc.size()));
+	EXPECT_EQ(index.format(), H264NalFormat::Avcc);
+	ASSERT_EQ(index.units().size(), 2u);
+	EXPECT_EQ(index.units()[1].offset, 14u);
+	EXPECT_EQ(index.units()[1].type, kH264NalTypeIdrSlice);
+
+	// A length running past the end is not AVCC.
+	const std::vector<uint8_t> single = {0x65, 0x88, 0x84, 0x21, 0x00};
+	ASSERT_TRUE(index.build(single.data(), single.size()));
+	EXPECT_EQ(index.format(), H264NalFormat::SingleNal);
+	ASSERT_EQ(index.units().size(), 1u);
+	EXPECT_EQ(index.units()[0].size, single.size());
+
+	EXPECT_FALSE(index.build(nullptr, 0));
+	EXPECT_TRUE(index.empty());
+	EXPECT_EQ(index.format(), H264NalFormat::None);
+}
+
+TEST(H264NalIndexTest, StartCodeSearchMatchesByteByteScanOnRandomData)
+{
+	std::mt19937 rng(47);
+	// Mostly zeros and ones so start codes and near misses are common.
+	std::discrete_distribution<int> byteClass({6, 3, 1});
+	for (int round = 0; round < 200; ++round) {
+		std::vector<uint8_t> data(static_cast<size_t>(rng() % 64));
+		for (uint8_t &byte : data) {
+			const int choice = byteClass(rng);
+			byte = choice == 0 ? 0 : (choice == 1 ? 1 : static_cast<uint8_t>(rng()));
+		}
+		for (size_t from = 0; from <= data.size(); ++from) {
+			size_t expectedLength = 0;
+			size_t actualLength = 0;
+			const size_t expected = naiveStartCode(data, from, expectedLength);
+			const size_t actual = findH264StartCode(data.data(), data.size(), from, actualLength);
+			ASSERT_EQ(actual, expected) << "round " << round << " from " << from;
+			ASSERT_EQ(actualLength, expectedLength) << "round " << round << " from " << from;
+		}
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ * Unit tests for the viewer keyframe request arbiter
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-keyframe-arbiter.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+KeyframeArbiterConfig testConfig()
+{
+	KeyframeArbiterConfig config;
+	config.minForcedIntervalMs = 1000;
+	config.scheduledKeyframeMarginMs = 200;
+	config.refreshGraceMs = 500;
+	return config;
+}
+
+} // namespace
+
+TEST(KeyframeArbiterTest, CoalescesAStormIntoOneForcedKeyframePerInterval)
+{
+	KeyframeRequestArbiter arbiter(testConfig());
+	for (int viewer = 0; viewer < 20; ++viewer) {
+		arbiter.noteRequest("viewer-" + std::to_string(viewer), true, 100 + viewer);
+	}
+
+	const KeyframeArbiterDecision first = arbiter.poll(120);
+	ASSERT_TRUE(first.force);
+	EXPECT_EQ(first.viewers.size(), 20u);
+	arbiter.noteForceResult(true);
+
+	// Repeated PLIs inside the interval fold into the keyframe already asked for.
+	arbiter.noteRequest("viewer-0", true, 400);
+	EXPECT_FALSE(arbiter.poll(400).force);
+	EXPECT_FALSE(arbiter.poll(1119).force);
+	EXPECT_TRUE(arbiter.poll(1120).force);
+	arbiter.noteForceResult(true);
+
+	const KeyframeArbiterStats stats = arbiter.takeStats();
+	EXPECT_EQ(stats.requests, 21u);
+	EXPECT_EQ(stats.coalescedRequests, 20u);
+	EXPECT_EQ(stats.forcedKeyframes, 2u);
+}
+
+TEST(KeyframeArbiterTest, ServesGatedViewersFirstAndLetsRefreshesWait)
+{
+	KeyframeRequestArbiter arbiter(testConfig());
+	arbiter.noteRequest("refresh", false, 0);
+	EXPECT_FALSE(arbiter.poll(100).force);
+
+	// A viewer whose gate is holding back live video does not wait for the
+	// refresh grace period and is listed first.
+	arbiter.noteRequest("frozen", true, 200);
+	const KeyframeArbiterDecision decision = arbiter.poll(200);
+	ASSERT_TRUE(decision.force);
+	ASSERT_EQ(decision.viewers.size(), 2u);
+	EXPECT_EQ(decision.viewers[0], "frozen");
+	EXPECT_EQ(decision.viewers[1], "refresh");
+}
+
+TEST(KeyframeArbiterTest, ForcesARefreshOnlyAfterTheGracePeriod)
+{
+	KeyframeRequestArbiter arbiter(testConfig());
+	arbiter.noteRequest("refresh", false, 1000);
+	EXPECT_FALSE(arbiter.poll(1499).force);
+	EXPECT_TRUE(arbiter.poll(1500).force);
+}
+
+TEST(KeyframeArbiterTest, LeavesRequestsToAnImminentScheduledKeyframe)
+{
+	KeyframeRequestArbiter arbiter(testConfig());
+	// The encoder's own cadence is two seconds.
+	arbiter.noteKeyframe(10000);
+	arbiter.noteKeyframe(12000);
+
+	arbiter.noteRequest("frozen", true, 13850);
+	EXPECT_FALSE(arbiter.poll(13850).force);
+	arbiter.noteKeyframe(14000);
+	EXPECT_EQ(arbiter.pendingViewers(), 0u);
+
+	// Early in the GOP the scheduled keyframe is too far away to wait for.
+	arbiter.noteRequest("frozen", true, 14300);
+	EXPECT_TRUE(arbiter.poll(14300).force);
+}
+
+TEST(KeyframeArbiterTest, ForcedKeyframesDoNotSkewTheScheduledCadence)
+{
+	KeyframeRequestArbiter arbiter(testConfig());
+	arbiter.noteKeyframe(10000);
+	arbiter.noteKeyframe(12000);
+
+	arbiter.noteRequest("frozen", true, 12500);
+	ASSERT_TRUE(arbiter.poll(12500).force);
+	arbiter.noteForceResult(true);
+	arbiter.noteKeyframe(12540);
+
+	// Still predicted two seconds after the forced keyframe, not 540 ms.
+	arbiter.noteRequest("frozen", true, 14400);
+	EXPECT_FALSE(arbiter.poll(14400).force);
+}
+
+TEST(KeyframeArbiterTest, RecordsRequestToKeyframeLatencyPerViewer)
+{
+	KeyframeRequestArbiter arbiter(testConfig());
+	arbiter.noteRequest("a", true, 1000);
+	arbiter.noteRequest("a", true, 1500);
+	arbiter.noteRequest("b", false, 1200);
+	arbiter.noteRequest("gone", true, 1100);
+	arbiter.removeViewer("gone");
+	ASSERT_TRUE(arbiter.poll(1200).force);
+	// The force could not be issued; the scheduled keyframe answers instead.
+	arbiter.noteForceResult(false);
+	arbiter.noteKeyframe(3000);
+
+	const KeyframeArbiterStats stats = arbiter.takeStats();
+	EXPECT_EQ(stats.forcedKeyframes, 0u);
+	ASSERT_EQ(stats.requestToKeyframeUs.count, 2u);
+	EXPECT_EQ(stats.requestToKeyframeUs.maxUs, 2000000u);
+	EXPECT_EQ(stats.requestToKeyframeUs.totalUs, 2000000u + 1800000u);
+	EXPECT_EQ(arbiter.takeStats().requests, 0u);
+}
@@ -0,0 +1,121 @@
+/*
+ * Unit tests for lock-free publish pipeline latency histograms
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "vdoninja-latency-histogram.h"
+
+using namespace vdoninja;
+
+TEST(LatencyHistogramTest, SmallValuesHaveExactBuckets)
+{
+	for (uint64_t value = 0; value < 8; ++value) {
+		EXPECT_EQ(latencyHistogramBucketIndex(value), value);
+		EXPECT_EQ(latencyHistogramBucketUpperBoundUs(value), value);
+	}
+	EXPECT_EQ(latencyHistogramBucketIndex(8), 8u);
+	EXPECT_EQ(latencyHistogramBucketIndex(15), 15u);
+	EXPECT_EQ(latencyHistogramBucketIndex(16), 16u);
+	EXPECT_EQ(latencyHistogramBucketIndex(17), 16u);
+	EXPECT_EQ(latencyHistogramBucketUpperBoundUs(16), 17u);
+}
+
+TEST(LatencyHistogramTest, BucketsAreContiguousAndBoundRelativeError)
+{
+	for (uint64_t value = 1; value < 5000000; value = value * 9 / 8 + 1) {
+		const size_t index = latencyHistogramBucketIndex(value);
+		const uint64_t upper = latencyHistogramBucketUpperBoundUs(index);
+		ASSERT_GE(upper, value);
+		ASSERT_LE(static_cast<double>(upper - value), static_cast<double>(value) * 0.125);
+		ASSERT_EQ(latencyHistogramBucketIndex(upper), index);
+		ASSERT_EQ(latencyHistogramBucketIndex(upper + 1), index + 1);
+	}
+}
+
+TEST(LatencyHistogramTest, HugeValuesClampToLastBucket)
+{
+	EXPECT_EQ(latencyHistogramBucketIndex(UINT64_MAX), kLatencyHistogramBucketCount - 1);
+
+	LatencyHistogramSnapshot snapshot;
+	snapshot.record(3600ULL * 1000000ULL);
+	EXPECT_EQ(snapshot.percentileUs(0.99), 3600ULL * 1000000ULL);
+}
+
+TEST(LatencyHistogramTest, PercentilesTrackDistribution)
+{
+	LatencyHistogramSnapshot snapshot;
+	for (uint64_t i = 1; i <= 100; ++i) {
+		snapshot.record(i * 100);
+	}
+
+	EXPECT_EQ(snapshot.count, 100u);
+	EXPECT_EQ(snapshot.maxUs, 10000u);
+	EXPECT_EQ(snapshot.meanUs(), 5050u);
+	EXPECT_NEAR(static_cast<double>(snapshot.percentileUs(0.50)), 5000.0, 5000.0 * 0.125);
+	EXPECT_NEAR(static_cast<double>(snapshot.percentileUs(0.95)), 9500.0, 9500.0 * 0.125);
+	EXPECT_NEAR(static_cast<double>(snapshot.percentileUs(0.99)), 9900.0, 9900.0 * 0.125);
+	EXPECT_EQ(snapshot.percentileUs(1.0), 10000u);
+	EXPECT_EQ(LatencyHistogramSnapshot{}.percentileUs(0.5), 0u);
+}
+
+TEST(LatencyHistogramTest, MergeCombinesSnapshots)
+{
+	LatencyHistogramSnapshot first;
+	LatencyHistogramSnapshot second;
+	first.record(100);
+	second.record(200);
+	second.record(4000);
+
+	first.merge(second);
+	EXPECT_EQ(first.count, 3u);
+	EXPECT_EQ(first.totalUs, 4300u);
+	EXPECT_EQ(first.maxUs, 4000u);
+	EXPECT_EQ(first.percentileUs(1.0), 4000u);
+}
+
+TEST(LatencyHistogramTest, SnapshotResetDrainsInterval)
+{
+	LatencyHistogram histogram;
+	histogram.record(250);
+	histogram.record(750);
+
+	const auto peek = histogram.snapshot(false);
+	EXPECT_EQ(peek.count, 2u);
+
+	const auto drained = histogram.snapshot(true);
+	EXPECT_EQ(drained.count, 2u);
+	EXPECT_EQ(drained.totalUs, 1000u);
+	EXPECT_EQ(drained.maxUs, 750u);
+
+	const auto empty = histogram.snapshot(true);
+	EXPECT_EQ(empty.count, 0u);
+	EXPECT_EQ(empty.maxUs, 0u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentWritersAreNotLost)
+{
+	LatencyHistogram histogram;
+	constexpr int kThreads = 4;
+	constexpr int kSamplesPerThread = 10000;
+
+	std::vector<std::thread> writers;
+	for (int t = 0; t < kThreads; ++t) {
+		writers.emplace_back([&histogram, t]() {
+			for (int i = 0; i < kSamplesPerThread; ++i) {
+				histogram.record(static_cast<uint64_t>(t * 1000 + i % 1000));
+			}
+		});
+	}
+	for (auto &writer : writers) {
+		writer.join();
+	}
+
+	const auto snapshot = histogram.snapshot(true);
+	EXPECT_EQ(snapshot.count, static_cast<uint64_t>(kThreads * kSamplesPerThread));
+	EXPECT_EQ(snapshot.maxUs, 3999u);
+}
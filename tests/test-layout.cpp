@@ -54,3 +54,40 @@ TEST(LayoutTest, FiveItemsCreateThreeColumnGrid)
 	EXPECT_FLOAT_EQ(layout[4].x, 640.0f);
 	EXPECT_FLOAT_EQ(layout[4].y, 540.0f);
 }
+
+TEST(LayoutTest, PlacementStretchesSourceOverRect)
+{
+	const LayoutRect rect{960.0f, 540.0f, 960.0f, 540.0f};
+	const auto placement = placementForRect(rect, 1280, 720);
+	EXPECT_FLOAT_EQ(placement.x, 960.0f);
+	EXPECT_FLOAT_EQ(placement.y, 540.0f);
+	EXPECT_FLOAT_EQ(placement.scaleX, 0.75f);
+	EXPECT_FLOAT_EQ(placement.scaleY, 0.75f);
+
+	const auto unsized = placementForRect(rect, 0, 0);
+	EXPECT_FLOAT_EQ(unsized.scaleX, 1.0f);
+	EXPECT_FLOAT_EQ(unsized.scaleY, 1.0f);
+}
+
+TEST(LayoutTest, GrowingTheGridOnlyMovesItemsWhoseCellsChanged)
+{
+	// A fourth guest fills the empty cell of the 2x2 grid; a fifth needs three
+	// columns and moves everyone.
+	const auto three = buildGridLayout(3, 1920, 1080);
+	const auto four = buildGridLayout(4, 1920, 1080);
+	for (size_t i = 0; i < three.size(); ++i) {
+		EXPECT_FALSE(layoutPlacementChanged(placementForRect(three[i], 1920, 1080),
+		                                    placementForRect(four[i], 1920, 1080)));
+	}
+
+	const auto five = buildGridLayout(5, 1920, 1080);
+	EXPECT_TRUE(layoutPlacementChanged(placementForRect(four[1], 1920, 1080), placementForRect(five[1], 1920, 1080)));
+}
+
+TEST(LayoutTest, PlacementComparisonIgnoresSubPixelDrift)
+{
+	const LayoutPlacement current{640.0f, 360.0f, 0.5f, 0.5f};
+	EXPECT_FALSE(layoutPlacementChanged(current, {640.2f, 359.9f, 0.5001f, 0.4999f}));
+	EXPECT_TRUE(layoutPlacementChanged(current, {641.0f, 360.0f, 0.5f, 0.5f}));
+	EXPECT_TRUE(layoutPlacementChanged(current, {640.0f, 360.0f, 0.51f, 0.5f}));
+}
@@ -111,6 +111,57 @@ TEST(VideoKeyframeGateTest, CachedPrimeCannotAuthorizeDependentLiveDeltas)
 	EXPECT_TRUE(gate.canQueueFrame(false, false));
 }
 
+TEST(VideoKeyframeGateTest, CachedGopReplayIsLiveButOnlyBeforeFirstSync)
+{
+	VideoKeyframeGate gate;
+	EXPECT_TRUE(gate.canReplayCachedGop());
+
+	// The replayed keyframe is queued as live, so the rest of the GOP and the
+	// live deltas after it can follow immediately.
+	const auto ticket = gate.onKeyframeQueued(false);
+	EXPECT_FALSE(gate.canReplayCachedGop());
+	EXPECT_TRUE(gate.canQueueFrame(false, false));
+	EXPECT_TRUE(gate.onKeyframeSendCompleted(ticket, true, false));
+	EXPECT_FALSE(gate.canReplayCachedGop());
+
+	VideoKeyframeGate stillPrimed;
+	stillPrimed.onKeyframeQueued(true);
+	EXPECT_FALSE(stillPrimed.canReplayCachedGop());
+
+	VideoKeyframeGate recovering;
+	recovering.requireLiveKeyframe();
+	EXPECT_FALSE(recovering.canReplayCachedGop());
+}
+
+TEST(VideoKeyframeGateTest, RecoveryPointResumesOnlyADecoderStartedOnAnIdr)
+{
+	VideoKeyframeGate gate;
+	// A brand-new decoder cannot start on a recovery point.
+	EXPECT_FALSE(gate.isEntryPoint(false, true));
+
+	// Queued behind the cached prime, the recovery point starts the live chain.
+	const auto cachedTicket = gate.onKeyframeQueued(true);
+	ASSERT_TRUE(gate.isEntryPoint(false, true));
+	const auto recoveryTicket = gate.onKeyframeQueued();
+	EXPECT_TRUE(gate.canQueueFrame(false, false));
+	// Further recovery points behind it are ordinary deltas.
+	EXPECT_FALSE(gate.isEntryPoint(false, true));
+	EXPECT_FALSE(gate.onKeyframeSendCompleted(cachedTicket, true, true));
+	EXPECT_TRUE(gate.onKeyframeSendCompleted(recoveryTicket, true));
+	EXPECT_FALSE(gate.isEntryPoint(false, true));
+
+	// After local loss the started decoder resumes on the next recovery point.
+	gate.requireLiveKeyframe();
+	EXPECT_FALSE(gate.canQueueFrame(false, false));
+	EXPECT_TRUE(gate.isEntryPoint(false, true));
+	EXPECT_FALSE(gate.isEntryPoint(false, false));
+
+	// A renegotiated track is a new decoder again.
+	gate.resetForCachedPrime();
+	EXPECT_FALSE(gate.isEntryPoint(false, true));
+	EXPECT_TRUE(gate.isEntryPoint(true, false));
+}
+
 TEST(VideoKeyframeGateTest, InitialDecoderRequestStillAllowsCachedPrime)
 {
 	VideoKeyframeGate gate;
@@ -0,0 +1,164 @@
+/*
+ * Unit tests for pre-warmed publisher pool sizing and join latency tracking
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-peer-warmup.h"
+
+using namespace vdoninja;
+
+TEST(PublisherWarmPoolSizerTest, DisabledPoolNeverRequestsConnections)
+{
+	PublisherWarmPoolSizer sizer(0, 60000);
+	sizer.noteJoin(1000);
+	sizer.noteJoin(1001);
+
+	EXPECT_EQ(sizer.targetSize(1002), 0u);
+}
+
+TEST(PublisherWarmPoolSizerTest, KeepsOneConnectionReadyWithoutRecentJoins)
+{
+	PublisherWarmPoolSizer sizer(4, 60000);
+
+	EXPECT_EQ(sizer.targetSize(1000), 1u);
+}
+
+TEST(PublisherWarmPoolSizerTest, GrowsWithJoinBurstUpToLimit)
+{
+	PublisherWarmPoolSizer sizer(4, 60000);
+	sizer.noteJoin(1000);
+	sizer.noteJoin(1100);
+	EXPECT_EQ(sizer.targetSize(1200), 3u);
+
+	for (int i = 0; i < 10; ++i) {
+		sizer.noteJoin(1300 + i);
+	}
+	EXPECT_EQ(sizer.targetSize(1400), 4u);
+	EXPECT_EQ(sizer.recentJoins(1400), 4u);
+}
+
+TEST(PublisherWarmPoolSizerTest, ShrinksAfterJoinsLeaveTheWindow)
+{
+	PublisherWarmPoolSizer sizer(8, 10000);
+	sizer.noteJoin(1000);
+	sizer.noteJoin(2000);
+	sizer.noteJoin(9000);
+	EXPECT_EQ(sizer.targetSize(9500), 4u);
+
+	EXPECT_EQ(sizer.targetSize(11500), 3u);
+	EXPECT_EQ(sizer.targetSize(19000), 1u);
+}
+
+TEST(PublisherWarmPoolSizerTest, LoweringLimitCapsTarget)
+{
+	PublisherWarmPoolSizer sizer(6, 60000);
+	for (int i = 0; i < 5; ++i) {
+		sizer.noteJoin(1000 + i);
+	}
+	sizer.setMaxPoolSize(2);
+
+	EXPECT_EQ(sizer.maxPoolSize(), 2u);
+	EXPECT_EQ(sizer.targetSize(2000), 2u);
+}
+
+TEST(JoinLatencyTrackerTest, ReportsEachStageOfCompletedJoin)
+{
+	JoinLatencyTracker tracker;
+	tracker.begin(7, 1000, false);
+	tracker.mark(7, JoinLatencyStage::OfferSent, 1040);
+	tracker.mark(7, JoinLatencyStage::AnswerReceived, 1240);
+	tracker.mark(7, JoinLatencyStage::Connected, 1540);
+	tracker.mark(7, JoinLatencyStage::FirstKeyframe, 1600);
+
+	const auto stats = tracker.take();
+	EXPECT_EQ(stats.completedJoins, 1u);
+	EXPECT_EQ(stats.warmJoins, 0u);
+	EXPECT_EQ(stats.abandonedJoins, 0u);
+	EXPECT_EQ(stats.requestToOffer.maxMs, 40u);
+	EXPECT_EQ(stats.offerToAnswer.maxMs, 200u);
+	EXPECT_EQ(stats.answerToConnected.maxMs, 300u);
+	EXPECT_EQ(stats.connectedToFirstKeyframe.maxMs, 60u);
+	EXPECT_EQ(stats.requestToFirstKeyframe.maxMs, 600u);
+	EXPECT_EQ(tracker.pendingJoins(), 0u);
+}
+
+TEST(JoinLatencyTrackerTest, RepeatedMilestonesKeepFirstObservation)
+{
+	JoinLatencyTracker tracker;
+	tracker.begin(3, 1000, true);
+	tracker.mark(3, JoinLatencyStage::OfferSent, 1010);
+	tracker.mark(3, JoinLatencyStage::OfferSent, 1900);
+	tracker.mark(3, JoinLatencyStage::AnswerReceived, 1100);
+	tracker.mark(3, JoinLatencyStage::Connected, 1200);
+	tracker.mark(3, JoinLatencyStage::FirstKeyframe, 1300);
+
+	const auto stats = tracker.take();
+	EXPECT_EQ(stats.warmJoins, 1u);
+	EXPECT_EQ(stats.requestToOffer.maxMs, 10u);
+	EXPECT_EQ(stats.offerToAnswer.maxMs, 90u);
+}
+
+TEST(JoinLatencyTrackerTest, AveragesAcrossJoinsAndResetsOnTake)
+{
+	JoinLatencyTracker tracker;
+	tracker.begin(1, 1000, false);
+	tracker.begin(2, 1000, false);
+	tracker.mark(1, JoinLatencyStage::FirstKeyframe, 1100);
+	tracker.mark(2, JoinLatencyStage::FirstKeyframe, 1300);
+
+	const auto stats = tracker.take();
+	EXPECT_EQ(stats.completedJoins, 2u);
+	EXPECT_EQ(stats.requestToFirstKeyframe.count, 2u);
+	EXPECT_EQ(stats.requestToFirstKeyframe.averageMs(), 200u);
+	EXPECT_EQ(stats.requestToFirstKeyframe.maxMs, 300u);
+	EXPECT_EQ(stats.requestToOffer.count, 0u);
+
+	const auto empty = tracker.take();
+	EXPECT_EQ(empty.completedJoins, 0u);
+	EXPECT_EQ(empty.requestToFirstKeyframe.count, 0u);
+}
+
+TEST(JoinLatencyTrackerTest, AbandonedAndTimedOutJoinsAreCounted)
+{
+	JoinLatencyTracker tracker(8, 5000);
+	tracker.begin(1, 1000, false);
+	tracker.begin(2, 1000, false);
+	tracker.abandon(1);
+	tracker.abandon(1);
+	tracker.begin(3, 7000, false);
+	tracker.mark(2, JoinLatencyStage::FirstKeyframe, 7100);
+
+	const auto stats = tracker.take();
+	EXPECT_EQ(stats.abandonedJoins, 2u);
+	EXPECT_EQ(stats.completedJoins, 0u);
+	EXPECT_EQ(tracker.pendingJoins(), 1u);
+}
+
+TEST(JoinLatencyTrackerTest, BoundsPendingJoinsByEvictingOldest)
+{
+	JoinLatencyTracker tracker(2, 60000);
+	tracker.begin(1, 1000, false);
+	tracker.begin(2, 1100, false);
+	tracker.begin(3, 1200, false);
+	tracker.mark(1, JoinLatencyStage::FirstKeyframe, 1300);
+	tracker.mark(3, JoinLatencyStage::FirstKeyframe, 1300);
+
+	const auto stats = tracker.take();
+	EXPECT_EQ(tracker.pendingJoins(), 1u);
+	EXPECT_EQ(stats.abandonedJoins, 1u);
+	EXPECT_EQ(stats.completedJoins, 1u);
+}
+
+TEST(JoinLatencyTrackerTest, IgnoresMilestonesForUnknownGenerations)
+{
+	JoinLatencyTracker tracker;
+	tracker.mark(9, JoinLatencyStage::Connected, 1000);
+	tracker.mark(9, JoinLatencyStage::FirstKeyframe, 1100);
+	tracker.begin(0, 1000, false);
+
+	const auto stats = tracker.take();
+	EXPECT_EQ(stats.completedJoins, 0u);
+	EXPECT_EQ(tracker.pendingJoins(), 0u);
+}
@@ -0,0 +1,141 @@
+/*
+ * Unit tests for the adaptive resolution and frame-rate ladder
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-quality-ladder.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+QualityLadderConfig ladderConfig()
+{
+	QualityLadderConfig config;
+	config.rungs = *parseQualityLadder("1500:720p30, 700:540p30");
+	config.upHysteresisPercent = 20;
+	config.minimumUpDwellMs = 10000;
+	return config;
+}
+
+} // namespace
+
+TEST(QualityLadderTest, ParsesRungsAndRejectsMalformedSpecs)
+{
+	const auto rungs = parseQualityLadder(" 1500:720p30 ,700:540P, 300:360p15");
+	ASSERT_TRUE(rungs.has_value());
+	ASSERT_EQ(rungs->size(), 3u);
+	EXPECT_EQ((*rungs)[0].maximumBitrateBitsPerSecond, 1500000u);
+	EXPECT_EQ((*rungs)[0].height, 720u);
+	EXPECT_EQ((*rungs)[0].fps, 30u);
+	EXPECT_EQ((*rungs)[1].fps, 0u);
+	EXPECT_EQ(qualityRungName((*rungs)[1]), "540p");
+	EXPECT_EQ(qualityRungName((*rungs)[2]), "360p15");
+	EXPECT_TRUE(parseQualityLadder("")->empty());
+
+	std::string error;
+	EXPECT_FALSE(parseQualityLadder("700:540p30,1500:720p30", &error).has_value());
+	EXPECT_NE(error.find("decrease"), std::string::npos);
+	EXPECT_FALSE(parseQualityLadder("1500:720", &error).has_value());
+	EXPECT_FALSE(parseQualityLadder("1500:720p30,", &error).has_value());
+	EXPECT_FALSE(parseQualityLadder("1500:720p30x", &error).has_value());
+	EXPECT_FALSE(parseQualityLadder("1500:40p30", &error).has_value());
+	EXPECT_FALSE(parseQualityLadder("99999999999999999999:720p30", &error).has_value());
+	EXPECT_FALSE(parseQualityLadder("4000:1080p,3000:720p,2000:540p,1000:360p", &error).has_value());
+}
+
+TEST(QualityLadderTest, ScalesToTheRungKeepingAspectAndEvenSizes)
+{
+	QualityRung rung;
+	rung.height = 720;
+	rung.fps = 30;
+	const QualityRungGeometry hd = qualityRungGeometry(rung, 1920, 1080, 60000, 1001);
+	EXPECT_EQ(hd.width, 1280u);
+	EXPECT_EQ(hd.height, 720u);
+	EXPECT_EQ(hd.frameRateDivisor, 2u);
+
+	// An odd aspect rounds to even dimensions.
+	rung.height = 361;
+	const QualityRungGeometry odd = qualityRungGeometry(rung, 1366, 768, 30, 1);
+	EXPECT_EQ(odd.height, 360u);
+	EXPECT_EQ(odd.width, 640u);
+	EXPECT_EQ(odd.frameRateDivisor, 1u);
+
+	// Never upscales, and a native frame rate keeps every frame.
+	rung.height = 1080;
+	rung.fps = 0;
+	const QualityRungGeometry native = qualityRungGeometry(rung, 1280, 720, 60, 1);
+	EXPECT_EQ(native.width, 1280u);
+	EXPECT_EQ(native.height, 720u);
+	EXPECT_EQ(native.frameRateDivisor, 1u);
+}
+
+TEST(QualityLadderTest, StepsDownImmediatelyAndSkipsRungsOnACollapse)
+{
+	QualityLadder ladder(ladderConfig());
+	EXPECT_FALSE(ladder.observe(4000000, 0).has_value());
+	EXPECT_EQ(ladder.observe(1400000, 1000), 1u);
+	EXPECT_FALSE(ladder.observe(1450000, 2000).has_value());
+	EXPECT_EQ(ladder.observe(500000, 2500), 2u);
+	EXPECT_EQ(ladder.levels(), 3u);
+}
+
+TEST(QualityLadderTest, StepsUpOneRungAtATimeWithHeadroomAndDwell)
+{
+	QualityLadder ladder(ladderConfig());
+	ASSERT_EQ(ladder.observe(500000, 0), 2u);
+
+	// Just over the 700 kbps ceiling is not enough headroom.
+	EXPECT_FALSE(ladder.observe(800000, 20000).has_value());
+	// Enough headroom, but straight to the top is one rung at a time.
+	EXPECT_EQ(ladder.observe(4000000, 20000), 1u);
+	// The dwell restarts at every rung.
+	EXPECT_FALSE(ladder.observe(4000000, 29999).has_value());
+	EXPECT_EQ(ladder.observe(4000000, 30000), 0u);
+}
+
+TEST(QualityLadderTest, HoveringAtACeilingDoesNotFlap)
+{
+	QualityLadder ladder(ladderConfig());
+	int changes = 0;
+	for (int second = 0; second < 120; ++second) {
+		const uint64_t bitrate = second % 2 == 0 ? 1450000 : 1650000;
+		if (ladder.observe(bitrate, second * 1000)) {
+			++changes;
+		}
+	}
+	EXPECT_EQ(changes, 1);
+	EXPECT_EQ(ladder.level(), 1u);
+}
+
+TEST(QualityLadderTest, SwitchesTrackOnlyOnTheTargetTracksKeyframe)
+{
+	QualityTrackSelector selector;
+	EXPECT_TRUE(selector.accept(0, true, 0));
+	EXPECT_FALSE(selector.accept(1, true, 0));
+
+	selector.requestTrack(1, 1000);
+	// The old track keeps flowing until the new one can start on an IDR.
+	EXPECT_TRUE(selector.accept(0, false, 1100));
+	EXPECT_FALSE(selector.accept(1, false, 1100));
+	EXPECT_TRUE(selector.accept(1, true, 1800));
+	EXPECT_EQ(selector.activeTrack(), 1u);
+	EXPECT_FALSE(selector.accept(0, true, 1900));
+	EXPECT_TRUE(selector.accept(1, false, 1900));
+
+	// A request withdrawn before the keyframe never switches.
+	selector.requestTrack(0, 2000);
+	selector.requestTrack(1, 2100);
+	EXPECT_FALSE(selector.accept(0, true, 2200));
+
+	const QualityLadderStats stats = selector.takeStats();
+	EXPECT_EQ(stats.switchesDown, 1u);
+	EXPECT_EQ(stats.switchesUp, 0u);
+	EXPECT_EQ(stats.maxSwitchWaitMs, 800);
+	EXPECT_EQ(stats.standbyFrames, 4u);
+	EXPECT_EQ(stats.activeTrack, 1u);
+	EXPECT_EQ(selector.takeStats().standbyFrames, 0u);
+}
@@ -0,0 +1,192 @@
+/*
+ * Unit tests for native receive pipeline tracing and RTCP SR latency
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "vdoninja-receive-trace.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+constexpr int64_t kNtpEpochOffsetSeconds = 2208988800LL;
+
+void appendU32(std::vector<uint8_t> &out, uint32_t value)
+{
+	out.push_back(static_cast<uint8_t>(value >> 24));
+	out.push_back(static_cast<uint8_t>(value >> 16));
+	out.push_back(static_cast<uint8_t>(value >> 8));
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+std::vector<uint8_t> senderReport(uint32_t ssrc, int64_t unixUs, uint32_t rtpTimestamp)
+{
+	const uint64_t ntpSeconds = static_cast<uint64_t>(unixUs / 1000000 + kNtpEpochOffsetSeconds);
+	const uint64_t ntpFraction = (static_cast<uint64_t>(unixUs % 1000000) << 32) / 1000000ULL;
+	std::vector<uint8_t> packet = {0x80, 200, 0x00, 0x06};
+	appendU32(packet, ssrc);
+	appendU32(packet, static_cast<uint32_t>(ntpSeconds));
+	appendU32(packet, static_cast<uint32_t>(ntpFraction));
+	appendU32(packet, rtpTimestamp);
+	appendU32(packet, 100);   // sender packet count
+	appendU32(packet, 50000); // sender octet count
+	return packet;
+}
+
+std::vector<uint8_t> receiverReport(uint32_t ssrc)
+{
+	std::vector<uint8_t> packet = {0x80, 201, 0x00, 0x01};
+	appendU32(packet, ssrc);
+	return packet;
+}
+
+} // namespace
+
+TEST(RtcpSenderReportClockTest, MapsRtpTimestampsOntoSenderWallClock)
+{
+	RtcpSenderReportClock clock(90000, 0x1234);
+	EXPECT_FALSE(clock.senderWallClockUs(1000).has_value());
+
+	const int64_t reportUs = 1700000000LL * 1000000LL + 250000;
+	ASSERT_TRUE(clock.observe(senderReport(0x1234, reportUs, 90000).data(), 28));
+
+	EXPECT_NEAR(static_cast<double>(*clock.senderWallClockUs(90000)), static_cast<double>(reportUs), 1.0);
+	EXPECT_NEAR(static_cast<double>(*clock.senderWallClockUs(90000 + 9000)), static_cast<double>(reportUs + 100000),
+	            1.0);
+	EXPECT_NEAR(static_cast<double>(*clock.senderWallClockUs(90000 - 4500)), static_cast<double>(reportUs - 50000),
+	            1.0);
+}
+
+TEST(RtcpSenderReportClockTest, HandlesRtpWrapAroundTheReport)
+{
+	RtcpSenderReportClock clock(90000);
+	const int64_t reportUs = 1700000000LL * 1000000LL;
+	ASSERT_TRUE(clock.observe(senderReport(7, reportUs, 0xFFFFFF00u).data(), 28));
+
+	EXPECT_NEAR(static_cast<double>(*clock.senderWallClockUs(0x00000100u)), static_cast<double>(reportUs + 5688),
+	            1.0);
+}
+
+TEST(RtcpSenderReportClockTest, FindsReportInsideCompoundPacketAndFiltersSsrc)
+{
+	RtcpSenderReportClock clock(90000, 42);
+	std::vector<uint8_t> compound = receiverReport(9);
+	const auto audioReport = senderReport(43, 1700000000LL * 1000000LL, 48000);
+	compound.insert(compound.end(), audioReport.begin(), audioReport.end());
+	EXPECT_FALSE(clock.observe(compound.data(), compound.size()));
+
+	const auto videoReport = senderReport(42, 1700000000LL * 1000000LL, 90000);
+	compound.insert(compound.end(), videoReport.begin(), videoReport.end());
+	EXPECT_TRUE(clock.observe(compound.data(), compound.size()));
+
+	clock.setMediaSsrc(43);
+	EXPECT_FALSE(clock.senderWallClockUs(90000).has_value());
+}
+
+TEST(RtcpSenderReportClockTest, RejectsTruncatedPackets)
+{
+	RtcpSenderReportClock clock;
+	const auto report = senderReport(1, 1700000000LL * 1000000LL, 0);
+	EXPECT_FALSE(clock.observe(report.data(), 20));
+	EXPECT_FALSE(clock.observe(nullptr, 28));
+	EXPECT_FALSE(clock.senderWallClockUs(0).has_value());
+}
+
+TEST(ReceivePipelineTracerTest, RecordsEachStageOfAFrame)
+{
+	ReceivePipelineTracer tracer;
+	tracer.noteFirstPacket(3000, 1000);
+	tracer.noteAssembled(3000, 1400);
+	tracer.noteDecoded(3000, 6400);
+	tracer.notePaired(3000, 7400);
+	tracer.noteScaleDuration(900);
+	tracer.noteOutput(3000, 9000, 0);
+
+	const auto stats = tracer.snapshot(true);
+	EXPECT_EQ(stats.outputFrames, 1u);
+	EXPECT_EQ(stats.assemblyUs.maxUs, 400u);
+	EXPECT_EQ(stats.decodeUs.maxUs, 5000u);
+	EXPECT_EQ(stats.alphaWaitUs.maxUs, 1000u);
+	EXPECT_EQ(stats.scaleUs.maxUs, 900u);
+	EXPECT_EQ(stats.receiveToOutputUs.maxUs, 8000u);
+	EXPECT_EQ(stats.senderToOutputUs.count, 0u);
+
+	EXPECT_EQ(tracer.snapshot().outputFrames, 0u);
+}
+
+TEST(ReceivePipelineTracerTest, DecoderReorderingMatchesFramesByTimestamp)
+{
+	ReceivePipelineTracer tracer;
+	tracer.noteFirstPacket(1000, 100);
+	tracer.noteAssembled(1000, 200);
+	tracer.noteFirstPacket(4000, 300);
+	tracer.noteAssembled(4000, 400);
+	tracer.noteDecoded(4000, 1400);
+	tracer.noteDecoded(1000, 2200);
+
+	const auto stats = tracer.snapshot();
+	EXPECT_EQ(stats.decodeUs.count, 2u);
+	EXPECT_EQ(stats.decodeUs.maxUs, 2000u);
+}
+
+TEST(ReceivePipelineTracerTest, EstimatesSenderToOutputAndFlagsClockSkew)
+{
+	ReceivePipelineTracer tracer(64, 10000000);
+	const int64_t reportUs = 1700000000LL * 1000000LL;
+	tracer.setMediaSsrc(5);
+	const auto report = senderReport(5, reportUs, 90000);
+	tracer.observeRtcp(report.data(), report.size());
+
+	tracer.noteOutput(90000 + 900, 1, reportUs + 10000 + 85000);
+	tracer.noteOutput(90000 + 1800, 2, reportUs - 5000000);
+	tracer.noteOutput(90000 + 2700, 3, reportUs + 60000000);
+
+	const auto stats = tracer.snapshot();
+	EXPECT_EQ(stats.senderReports, 1u);
+	EXPECT_EQ(stats.senderToOutputUs.count, 1u);
+	EXPECT_NEAR(static_cast<double>(stats.senderToOutputUs.maxUs), 85000.0, 1.0);
+	EXPECT_EQ(stats.unsyncedClockFrames, 2u);
+}
+
+TEST(ReceivePipelineTracerTest, CountsDropsByReason)
+{
+	ReceivePipelineTracer tracer;
+	tracer.noteDrop(ReceiveDropReason::IncompleteFrame);
+	tracer.noteDrop(ReceiveDropReason::DecodeError, 2);
+	tracer.noteDrop(ReceiveDropReason::AlphaTimeout, 3);
+	tracer.noteDrop(ReceiveDropReason::EpochGate, 4);
+
+	const auto stats = tracer.snapshot(true);
+	EXPECT_EQ(stats.incompleteFrames, 1u);
+	EXPECT_EQ(stats.decodeErrors, 2u);
+	EXPECT_EQ(stats.alphaTimeouts, 3u);
+	EXPECT_EQ(stats.epochGateDrops, 4u);
+	EXPECT_EQ(tracer.snapshot().decodeErrors, 0u);
+}
+
+TEST(ReceivePipelineTracerTest, BoundsInFlightFramesAndClearsOnTransition)
+{
+	ReceivePipelineTracer tracer(2);
+	tracer.noteFirstPacket(1, 100);
+	tracer.noteFirstPacket(2, 200);
+	tracer.noteFirstPacket(3, 300);
+	tracer.noteOutput(1, 1000, 0);
+	tracer.noteOutput(3, 1000, 0);
+	EXPECT_EQ(tracer.snapshot().receiveToOutputUs.count, 1u);
+
+	tracer.noteFirstPacket(4, 400);
+	const auto report = senderReport(0, 1700000000LL * 1000000LL, 0);
+	tracer.observeRtcp(report.data(), report.size());
+	tracer.clearInFlight();
+	tracer.noteOutput(4, 1000, 1700000000LL * 1000000LL);
+
+	const auto stats = tracer.snapshot();
+	EXPECT_EQ(stats.receiveToOutputUs.count, 1u);
+	EXPECT_EQ(stats.senderToOutputUs.count, 0u);
+	EXPECT_EQ(stats.outputFrames, 3u);
+}
@@ -0,0 +1,194 @@
+/*
+ * Unit tests for the shared-media relay's upstream frame continuity
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-relay-feed.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+constexpr uint32_t kSsrc = 0x1234;
+constexpr uint32_t kFrameTicks = 3000;
+
+// Feeds one frame of packetCount packets starting at sequence.
+void feedFrame(RelayVideoFeed &feed, uint16_t &sequence, uint32_t timestamp, int packetCount = 2,
+               uint32_t ssrc = kSsrc)
+{
+	for (int i = 0; i < packetCount; ++i) {
+		feed.notePacket(ssrc, sequence++, timestamp);
+	}
+}
+
+} // namespace
+
+TEST(RelayTimestampRebaserTest, ContinuesTheTimelineAcrossUpstreamRestarts)
+{
+	RelayTimestampRebaser rebaser(90000, kFrameTicks);
+	bool restarted = true;
+	EXPECT_EQ(rebaser.map(kSsrc, 1000, &restarted), 1000u);
+	EXPECT_FALSE(restarted);
+	EXPECT_EQ(rebaser.map(kSsrc, 4000, &restarted), 4000u);
+	EXPECT_FALSE(restarted);
+
+	// A new publisher SSRC resumes one frame after the last mapped timestamp.
+	EXPECT_EQ(rebaser.map(0x5678, 777777, &restarted), 7000u);
+	EXPECT_TRUE(restarted);
+	EXPECT_EQ(rebaser.map(0x5678, 780777, &restarted), 10000u);
+	EXPECT_FALSE(restarted);
+
+	// A clock jump beyond ten seconds in either direction is a restart too;
+	// an ordinary gap and the 32-bit wrap are not.
+	EXPECT_EQ(rebaser.map(0x5678, 780777 + 90000 * 11, &restarted), 13000u);
+	EXPECT_TRUE(restarted);
+	rebaser.reset();
+	EXPECT_EQ(rebaser.map(kSsrc, 0xFFFFF000u, &restarted), 0xFFFFF000u);
+	EXPECT_EQ(rebaser.map(kSsrc, 0x00000BB8u, &restarted), 0x00000BB8u);
+	EXPECT_FALSE(restarted);
+}
+
+TEST(RelayVideoFeedTest, HoldsDeltasAfterLossUntilAnIntactKeyframe)
+{
+	RelayVideoFeed feed;
+	uint16_t sequence = 100;
+	uint32_t timestamp = 9000;
+
+	// Nothing is forwarded before the first keyframe.
+	feedFrame(feed, sequence, timestamp);
+	RelayVideoDecision decision = feed.onFrame(timestamp, false, 0);
+	EXPECT_FALSE(decision.forward);
+	EXPECT_TRUE(decision.requestKeyframe);
+
+	// The very first packet has no predecessor, so the first complete frame
+	// is the one after it.
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	decision = feed.onFrame(timestamp, true, 10);
+	EXPECT_TRUE(decision.forward);
+	EXPECT_EQ(decision.timestamp, timestamp);
+
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	EXPECT_TRUE(feed.onFrame(timestamp, false, 20).forward);
+
+	// One packet of the next frame is lost: it and every delta after it are
+	// held back until a keyframe arrives whole.
+	timestamp += kFrameTicks;
+	feed.notePacket(kSsrc, sequence++, timestamp);
+	++sequence;
+	feed.notePacket(kSsrc, sequence++, timestamp);
+	decision = feed.onFrame(timestamp, false, 30);
+	EXPECT_FALSE(decision.forward);
+	EXPECT_TRUE(decision.requestKeyframe);
+
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	EXPECT_FALSE(feed.onFrame(timestamp, false, 40).forward);
+
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp, 4);
+	EXPECT_TRUE(feed.onFrame(timestamp, true, 50).forward);
+
+	const RelayVideoFeedStats stats = feed.stats();
+	EXPECT_EQ(stats.forwardedFrames, 3u);
+	EXPECT_EQ(stats.droppedFrames, 3u);
+}
+
+TEST(RelayVideoFeedTest, RateLimitsUpstreamKeyframeRequests)
+{
+	RelayVideoFeed feed;
+	uint16_t sequence = 0;
+	uint32_t timestamp = 0;
+	feed.notePacket(kSsrc, sequence++, timestamp);
+
+	int requests = 0;
+	for (int64_t nowMs = 0; nowMs < 2500; nowMs += 100) {
+		timestamp += kFrameTicks;
+		feedFrame(feed, sequence, timestamp);
+		if (feed.onFrame(timestamp, false, nowMs).requestKeyframe) {
+			++requests;
+		}
+	}
+	EXPECT_EQ(requests, 3);
+	EXPECT_EQ(feed.stats().keyframeRequests, 3u);
+}
+
+TEST(RelayVideoFeedTest, JudgesAFrameWhoseMarkerWasLostByItsOwnPackets)
+{
+	RelayVideoFeed feed;
+	uint16_t sequence = 10;
+	feed.notePacket(kSsrc, sequence++, 0);
+
+	feedFrame(feed, sequence, 3000);
+	ASSERT_TRUE(feed.onFrame(3000, true, 0).forward);
+
+	// The marker packet of 6000 is lost, so the receiver completes it only
+	// when 9000's first packet arrives; the missing tail still breaks it.
+	feed.notePacket(kSsrc, sequence++, 6000);
+	++sequence;
+	feed.notePacket(kSsrc, sequence++, 9000);
+	EXPECT_FALSE(feed.onFrame(6000, false, 10).forward);
+
+	// A clean frame after it still depends on the damaged one.
+	feed.notePacket(kSsrc, sequence++, 9000);
+	EXPECT_FALSE(feed.onFrame(9000, false, 20).forward);
+
+	// A payload the receiver could not depacketize damages its frame too.
+	feedFrame(feed, sequence, 12000);
+	feed.notePacket(kSsrc, sequence++, 12000, false);
+	EXPECT_FALSE(feed.onFrame(12000, true, 30).forward);
+}
+
+TEST(RelayVideoFeedTest, RecoveryPointsResumeOnlyAfterAForwardedKeyframe)
+{
+	RelayVideoFeed feed;
+	uint16_t sequence = 0;
+	uint32_t timestamp = 0;
+	feed.notePacket(kSsrc, sequence++, timestamp);
+
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	EXPECT_FALSE(feed.onFrame(timestamp, false, 0, true).forward);
+
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	EXPECT_TRUE(feed.onFrame(timestamp, true, 10).forward);
+
+	// A forwarded frame that never reached the viewers breaks the chain just
+	// as packet loss does; the next recovery point heals it.
+	feed.breakChain();
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	EXPECT_FALSE(feed.onFrame(timestamp, false, 20).forward);
+
+	timestamp += kFrameTicks;
+	feedFrame(feed, sequence, timestamp);
+	EXPECT_TRUE(feed.onFrame(timestamp, false, 30, true).forward);
+}
+
+TEST(RelayVideoFeedTest, NewUpstreamSsrcWaitsForItsKeyframeOnAContinuousTimeline)
+{
+	RelayVideoFeed feed;
+	uint16_t sequence = 500;
+	feed.notePacket(kSsrc, sequence++, 0);
+	feedFrame(feed, sequence, 3000);
+	ASSERT_TRUE(feed.onFrame(3000, true, 0).forward);
+
+	// The publisher restarted with a new SSRC, sequence and clock.
+	uint16_t restartedSequence = 9;
+	const uint32_t restartedSsrc = 0xABCD;
+	feedFrame(feed, restartedSequence, 5000000, 1, restartedSsrc);
+	EXPECT_FALSE(feed.onFrame(5000000, true, 10).forward);
+
+	feedFrame(feed, restartedSequence, 5003000, 2, restartedSsrc);
+	const RelayVideoDecision decision = feed.onFrame(5003000, true, 20);
+	ASSERT_TRUE(decision.forward);
+	EXPECT_EQ(decision.timestamp, 6000u);
+	EXPECT_EQ(feed.stats().upstreamRestarts, 1u);
+}
@@ -0,0 +1,169 @@
+/*
+ * Unit tests for shared remote stats documents and delta delivery
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-remote-stats.h"
+#include "vdoninja-utils.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+// Each peer gets a single field "v" with the given raw value.
+RemoteStatsDocument documentWith(std::initializer_list<std::pair<std::string, std::string>> peers,
+                                 const std::string &pipeline = "{}")
+{
+	RemoteStatsDocument document;
+	for (const auto &peer : peers) {
+		document.peers[peer.first] = makeRemoteStatsEntry({{"v", peer.second}});
+	}
+	document.pipelineJson = pipeline;
+	return document;
+}
+
+RemoteStatsPublisher::Limits testLimits()
+{
+	RemoteStatsPublisher::Limits limits;
+	limits.intervalMs = 1000;
+	limits.fullSnapshotIntervalMs = 10000;
+	limits.bytesPerSecond = 0;
+	limits.oneShotIntervalMs = 1000;
+	return limits;
+}
+
+} // namespace
+
+TEST(RemoteStatsTest, FullMessageLeavesOutTheRecipient)
+{
+	const auto document = documentWith({{"a", R"("connected")"}, {"director", R"("x")"}});
+	const std::string message = remoteStatsFullMessage(document, "director");
+	EXPECT_EQ(message, R"({"remoteStats":{"a":{"v":"connected"}},"publishLatencyUs":{}})");
+}
+
+TEST(RemoteStatsTest, FirstPushIsFullThenOnlyChangedEntries)
+{
+	RemoteStatsPublisher publisher(testLimits());
+	publisher.addSubscriber("director", 1000);
+	EXPECT_EQ(publisher.nextDueMs(), 1000);
+
+	auto document = documentWith({{"a", "1"}, {"b", "1"}});
+	const std::string full = publisher.pushFor("director", document, 1000);
+	EXPECT_EQ(full, R"({"remoteStats":{"a":{"v":1},"b":{"v":1}},"publishLatencyUs":{}})");
+	EXPECT_EQ(publisher.nextDueMs(), 2000);
+	EXPECT_TRUE(publisher.dueSubscribers(1999).empty());
+
+	EXPECT_EQ(publisher.pushFor("director", document, 2000), "");
+
+	document.peers["b"] = makeRemoteStatsEntry({{"v", "2"}});
+	document.peers["c"] = makeRemoteStatsEntry({{"v", "1"}});
+	EXPECT_EQ(publisher.pushFor("director", document, 3000), R"({"remoteStatsDelta":{"b":{"v":2},"c":{"v":1}}})");
+
+	document.peers.erase("a");
+	document.pipelineJson = R"({"p":1})";
+	EXPECT_EQ(publisher.pushFor("director", document, 4000),
+	          R"({"remoteStatsDelta":{},"remoteStatsRemoved":["a"],"publishLatencyUs":{"p":1}})");
+}
+
+TEST(RemoteStatsTest, ReportAgeAloneDoesNotTriggerDeltas)
+{
+	RemoteStatsPublisher publisher(testLimits());
+	publisher.addSubscriber("director", 0);
+	RemoteStatsDocument document;
+	document.peers["a"] = makeRemoteStatsEntry({{"reported", "{}"}, {"v", "1"}}, 10);
+	EXPECT_EQ(document.peers["a"].json, R"({"lastStatsAgeMs":10,"reported":{},"v":1})");
+	publisher.pushFor("director", document, 0);
+
+	document.peers["a"] = makeRemoteStatsEntry({{"reported", "{}"}, {"v", "1"}}, 1010);
+	EXPECT_EQ(publisher.pushFor("director", document, 1000), "");
+}
+
+TEST(RemoteStatsTest, DeltasCarryOnlyTheFieldsThatMoved)
+{
+	RemoteStatsPublisher publisher(testLimits());
+	publisher.addSubscriber("director", 0);
+	const auto viewer = [](const std::string &transport, const std::string &latency, const std::string &reported,
+	                       int64_t ageMs) {
+		std::map<std::string, std::string> fields = {
+		    {"role", R"("viewer")"},
+		    {"state", R"("connected")"},
+		    {"hasDataChannel", "true"},
+		    {"streamID", R"("camera_one")"},
+		    {"reported", reported},
+		    {"transport", transport},
+		    {"publishLatencyUs", latency},
+		};
+		if (transport.empty()) {
+			fields.erase("transport");
+		}
+		return makeRemoteStatsEntry(std::move(fields), ageMs);
+	};
+	const std::string report = R"({"video":{"resolution":"1920x1080","fps":30,"codec":"vp9"}})";
+	RemoteStatsDocument document;
+	document.peers["a"] = viewer(R"({"bitrateKbps":2500,"queueDelayMs":3})",
+	                             R"({"pacerHold":{"p50":100,"p95":400}})", report, 100);
+	const std::string full = publisher.pushFor("director", document, 0);
+
+	// Transport and latency move on every build; the rest of the entry does not.
+	document.peers["a"] = viewer(R"({"bitrateKbps":2400,"queueDelayMs":5})",
+	                             R"({"pacerHold":{"p50":110,"p95":420}})", report, 1100);
+	const std::string delta = publisher.pushFor("director", document, 1000);
+	EXPECT_EQ(delta, R"({"remoteStatsDelta":{"a":{"publishLatencyUs":{"pacerHold":{"p50":110,"p95":420}},)"
+	                 R"("transport":{"bitrateKbps":2400,"queueDelayMs":5}}}})");
+	EXPECT_LT(delta.size() * 2, full.size());
+
+	// A new report brings its age; a field that went away is sent as null.
+	document.peers["a"] = viewer("", R"({"pacerHold":{"p50":110,"p95":420}})", R"({"video":{"fps":29}})", 50);
+	EXPECT_EQ(publisher.pushFor("director", document, 2000),
+	          R"({"remoteStatsDelta":{"a":{"lastStatsAgeMs":50,"reported":{"video":{"fps":29}},"transport":null}}})");
+}
+
+TEST(RemoteStatsTest, ResendsAFullSnapshotPeriodically)
+{
+	RemoteStatsPublisher publisher(testLimits());
+	publisher.addSubscriber("director", 0);
+	const auto document = documentWith({{"a", "1"}});
+	publisher.pushFor("director", document, 0);
+	for (int64_t now = 1000; now < 10000; now += 1000) {
+		EXPECT_EQ(publisher.pushFor("director", document, now), "");
+	}
+	EXPECT_EQ(publisher.pushFor("director", document, 10000), remoteStatsFullMessage(document, "director"));
+}
+
+TEST(RemoteStatsTest, LargePushesBackOffToTheByteBudget)
+{
+	auto limits = testLimits();
+	limits.bytesPerSecond = 100;
+	RemoteStatsPublisher publisher(limits);
+	publisher.addSubscriber("director", 0);
+	const auto document = documentWith({{"a", "\"" + std::string(480, 'x') + "\""}});
+
+	const std::string message = publisher.pushFor("director", document, 0);
+	ASSERT_GT(message.size(), 500u);
+	EXPECT_EQ(publisher.nextDueMs(), static_cast<int64_t>(message.size() * 10));
+}
+
+TEST(RemoteStatsTest, OneShotRequestsAreRateLimitedAndResetTheBaseline)
+{
+	RemoteStatsPublisher publisher(testLimits());
+	auto document = documentWith({{"a", "1"}});
+	EXPECT_FALSE(publisher.answerRequest("viewer", document, 5000).empty());
+	EXPECT_TRUE(publisher.answerRequest("viewer", document, 5500).empty());
+	EXPECT_FALSE(publisher.answerRequest("viewer", document, 6000).empty());
+
+	publisher.addSubscriber("director", 6000);
+	EXPECT_FALSE(publisher.answerRequest("director", document, 6000).empty());
+	EXPECT_EQ(publisher.nextDueMs(), 7000);
+	EXPECT_EQ(publisher.pushFor("director", document, 7000), "");
+
+	publisher.removeSubscriber("director");
+	EXPECT_TRUE(publisher.empty());
+	EXPECT_EQ(publisher.nextDueMs(), 0);
+}
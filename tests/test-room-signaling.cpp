@@ -0,0 +1,226 @@
+/*
+ * Unit tests for the room signaling connection shared by native receivers
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "vdoninja-room-signaling.h"
+#include "vdoninja-signaling.h"
+#include "vdoninja-utils.h"
+
+using namespace vdoninja;
+
+using ::testing::ElementsAre;
+
+namespace
+{
+
+struct RoomFixture {
+	std::shared_ptr<VDONinjaRoomSignaling> room =
+	    std::make_shared<VDONinjaRoomSignaling>("wss://room.test", "studio", "", "");
+	std::vector<std::string> sent;
+
+	RoomFixture()
+	{
+		room->useTransportForTesting([this](const std::string &message) { sent.push_back(message); });
+	}
+
+	// Attaches a receiver and returns the hashed stream ID its play request named.
+	std::string view(VDONinjaSignaling &client, const std::string &streamId)
+	{
+		client.useRoomConnection(room);
+		EXPECT_TRUE(client.connect());
+		EXPECT_TRUE(client.joinRoom("studio"));
+		EXPECT_TRUE(client.viewStream(streamId));
+		EXPECT_FALSE(sent.empty());
+		return sent.empty() ? std::string() : JsonParser(sent.back()).getString("streamID");
+	}
+};
+
+std::string offerFrom(const std::string &uuid, const std::string &streamId)
+{
+	JsonBuilder description;
+	description.add("type", "offer");
+	description.add("sdp", "v=0 " + uuid);
+	JsonBuilder msg;
+	msg.add("UUID", uuid);
+	msg.add("session", "s-" + uuid);
+	if (!streamId.empty()) {
+		msg.add("streamID", streamId);
+	}
+	msg.addRaw("description", description.build());
+	return msg.build();
+}
+
+} // namespace
+
+TEST(RoomSignalingTest, OffersReachTheReceiverWhoseStreamTheyName)
+{
+	RoomFixture fixture;
+	VDONinjaSignaling alice;
+	VDONinjaSignaling bob;
+	std::vector<std::string> aliceOffers;
+	std::vector<std::string> bobOffers;
+	std::vector<std::string> bobCandidates;
+	alice.setOnOffer([&](const std::string &uuid, const std::string &, const std::string &) {
+		aliceOffers.push_back(uuid);
+	});
+	bob.setOnOffer([&](const std::string &uuid, const std::string &, const std::string &) {
+		bobOffers.push_back(uuid);
+	});
+	bob.setOnIceCandidate([&](const std::string &uuid, const std::string &candidate, const std::string &,
+	                          const std::string &) { bobCandidates.push_back(uuid + " " + candidate); });
+
+	const std::string aliceStream = fixture.view(alice, "alice");
+	const std::string bobStream = fixture.view(bob, "bob");
+	ASSERT_NE(aliceStream, bobStream);
+	EXPECT_EQ(fixture.room->subscribers(), 2u);
+
+	// Bob's publisher answers first; naming the stream routes past Alice's older play.
+	fixture.room->deliver(offerFrom("pub-bob", bobStream));
+	fixture.room->deliver(offerFrom("pub-alice", aliceStream));
+	fixture.room->deliver(R"({"UUID":"pub-bob","session":"s-pub-bob","candidate":"candidate:1","mid":"0"})");
+
+	EXPECT_THAT(aliceOffers, ElementsAre("pub-alice"));
+	EXPECT_THAT(bobOffers, ElementsAre("pub-bob"));
+	EXPECT_THAT(bobCandidates, ElementsAre("pub-bob candidate:1"));
+
+	alice.disconnect();
+	bob.disconnect();
+	EXPECT_EQ(fixture.room->subscribers(), 0u);
+}
+
+TEST(RoomSignalingTest, UnnamedOffersAnswerTheOldestPlay)
+{
+	RoomFixture fixture;
+	VDONinjaSignaling alice;
+	VDONinjaSignaling bob;
+	std::vector<std::string> aliceOffers;
+	std::vector<std::string> bobOffers;
+	alice.setOnOffer([&](const std::string &uuid, const std::string &, const std::string &) {
+		aliceOffers.push_back(uuid);
+	});
+	bob.setOnOffer([&](const std::string &uuid, const std::string &, const std::string &) {
+		bobOffers.push_back(uuid);
+	});
+
+	fixture.view(alice, "alice");
+	fixture.view(bob, "bob");
+	fixture.room->deliver(offerFrom("pub-1", ""));
+	fixture.room->deliver(offerFrom("pub-2", ""));
+	// Unrelated peers and requests for someone else's stream are not delivered.
+	fixture.room->deliver(offerFrom("pub-3", ""));
+	fixture.room->deliver(R"({"UUID":"viewer-9","request":"offerSDP"})");
+
+	EXPECT_THAT(aliceOffers, ElementsAre("pub-1"));
+	EXPECT_THAT(bobOffers, ElementsAre("pub-2"));
+}
+
+TEST(RoomSignalingTest, RoomEventsReachEveryReceiverAndJoinsStayLocal)
+{
+	RoomFixture fixture;
+	VDONinjaSignaling alice;
+	VDONinjaSignaling bob;
+	std::vector<std::string> aliceAdded;
+	std::vector<std::string> bobAdded;
+	alice.setOnStreamAdded([&](const std::string &streamId, const std::string &) { aliceAdded.push_back(streamId); });
+	bob.setOnStreamAdded([&](const std::string &streamId, const std::string &) { bobAdded.push_back(streamId); });
+
+	fixture.view(alice, "alice");
+	fixture.room->deliver(R"({"request":"listing","list":[{"UUID":"pub-1","streamID":"cam_1"}]})");
+	EXPECT_TRUE(alice.isInRoom());
+
+	// A receiver that joins later is answered with the room's listing; the
+	// server never sees a second join.
+	fixture.view(bob, "bob");
+	EXPECT_TRUE(bob.isInRoom());
+	EXPECT_THAT(bob.getCurrentRoomMembers(), ElementsAre("cam_1"));
+	for (const auto &message : fixture.sent) {
+		EXPECT_EQ(JsonParser(message).getString("request"), "play");
+	}
+
+	fixture.room->deliver(R"({"request":"someonejoined","UUID":"pub-2","streamID":"cam_2"})");
+	EXPECT_THAT(aliceAdded, ElementsAre("cam_2"));
+	EXPECT_THAT(bobAdded, ElementsAre("cam_2"));
+}
+
+TEST(RoomSignalingTest, DetachedReceiversStopReceiving)
+{
+	RoomFixture fixture;
+	VDONinjaSignaling bob;
+	int offers = 0;
+	int disconnects = 0;
+	bob.setOnOffer([&](const std::string &, const std::string &, const std::string &) { ++offers; });
+	bob.setOnDisconnected([&]() { ++disconnects; });
+
+	const std::string bobStream = fixture.view(bob, "bob");
+	fixture.room->deliver(offerFrom("pub-bob", bobStream));
+	bob.disconnect();
+	EXPECT_FALSE(bob.isConnected());
+	EXPECT_EQ(disconnects, 1);
+
+	fixture.room->deliver(offerFrom("pub-bob", bobStream));
+	fixture.room->deliver(R"({"request":"someonejoined","UUID":"pub-2","streamID":"cam_2"})");
+	EXPECT_EQ(offers, 1);
+	EXPECT_EQ(fixture.room->subscribers(), 0u);
+}
+
+TEST(RoomSignalingTest, AcquireSharesOneConnectionPerRoom)
+{
+	auto first = VDONinjaRoomSignaling::acquire("wss://room.test", "studio", "pw", "vdo.ninja");
+	auto second = VDONinjaRoomSignaling::acquire("wss://room.test", "studio", "pw", "vdo.ninja");
+	auto otherRoom = VDONinjaRoomSignaling::acquire("wss://room.test", "lobby", "pw", "vdo.ninja");
+	EXPECT_EQ(first, second);
+	EXPECT_NE(first, otherRoom);
+
+	first.reset();
+	second.reset();
+	auto reopened = VDONinjaRoomSignaling::acquire("wss://room.test", "studio", "pw", "vdo.ninja");
+	EXPECT_EQ(reopened->subscribers(), 0u);
+}
+
+TEST(RoomSignalingTest, DetachedReceiversReleaseTheirPlaysAndPublishers)
+{
+	RoomFixture fixture;
+	VDONinjaSignaling alice;
+	VDONinjaSignaling bob;
+	VDONinjaSignaling carol;
+	std::vector<std::string> bobOffers;
+	std::vector<std::string> carolOffers;
+	bob.setOnOffer([&](const std::string &uuid, const std::string &, const std::string &) {
+		bobOffers.push_back(uuid);
+	});
+	carol.setOnOffer([&](const std::string &uuid, const std::string &, const std::string &) {
+		carolOffers.push_back(uuid);
+	});
+
+	// Alice's publisher is bound to her, then she leaves with a second play
+	// still unanswered.
+	const std::string aliceStream = fixture.view(alice, "alice");
+	fixture.room->deliver(offerFrom("pub-alice", aliceStream));
+	EXPECT_TRUE(alice.viewStream("alice-screen"));
+	const std::string aliceScreen = JsonParser(fixture.sent.back()).getString("streamID");
+	fixture.view(bob, "bob");
+	alice.disconnect();
+
+	// The server answers her play, and her publisher offers again; neither
+	// reaches Bob's pending play.
+	fixture.room->deliver(offerFrom("pub-alice-screen", aliceScreen));
+	fixture.room->deliver(offerFrom("pub-alice", ""));
+	EXPECT_TRUE(bobOffers.empty());
+
+	fixture.room->deliver(offerFrom("pub-bob", ""));
+	EXPECT_THAT(bobOffers, ElementsAre("pub-bob"));
+
+	// A new receiver of the released stream gets its offers again.
+	const std::string carolStream = fixture.view(carol, "alice-screen");
+	ASSERT_EQ(carolStream, aliceScreen);
+	fixture.room->deliver(offerFrom("pub-alice-screen", aliceScreen));
+	EXPECT_THAT(carolOffers, ElementsAre("pub-alice-screen"));
+}
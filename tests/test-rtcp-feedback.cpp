@@ -3,6 +3,7 @@
  * SPDX-License-Identifier: AGPL-3.0-only
  */
 
+#include <chrono>
 #include <cstdint>
 #include <random>
 #include <vector>
@@ -220,6 +221,70 @@ TEST(RtcpFeedbackTrackerTest, TakeReturnsAndResetsInterval)
 	EXPECT_EQ(tracker.snapshot().compoundPackets, 0u);
 }
 
+TEST(RtcpFeedbackTrackerTest, TotalsSurviveTakeAndKeepLatestReport)
+{
+	constexpr uint32_t mediaSsrc = 0x22222222;
+	constexpr uint32_t lastSenderReport = 0x10000000;
+	RtcpFeedbackTracker tracker(mediaSsrc);
+	const auto nack = makeNack(mediaSsrc, 100, 0x0003);
+	const auto pli = makePli(mediaSsrc);
+	tracker.observe(nack.data(), nack.size());
+	tracker.observe(pli.data(), pli.size());
+	const auto firstReport = makeReceiverReport(mediaSsrc, 64, 7, 900, lastSenderReport, 0);
+	tracker.observe(firstReport.data(), firstReport.size(), lastSenderReport + 8192);
+	tracker.take();
+
+	const auto secondReport = makeReceiverReport(mediaSsrc, 13, 9, 900, 0, 0);
+	tracker.observe(secondReport.data(), secondReport.size());
+	tracker.observe(pli.data(), pli.size());
+
+	const RtcpFeedbackTotals totals = tracker.totals();
+	EXPECT_EQ(totals.nackMessages, 1u);
+	EXPECT_EQ(totals.nackRequestedPackets, 3u);
+	EXPECT_EQ(totals.pliMessages, 2u);
+	EXPECT_EQ(totals.reportBlocks, 2u);
+	EXPECT_EQ(totals.lastFractionLost, 13u);
+	// The second report carried no sender report reference, so the RTT stays.
+	EXPECT_EQ(totals.lastRttMs, 125u);
+	EXPECT_EQ(tracker.snapshot().pliMessages, 1u);
+
+	tracker.reset();
+	EXPECT_EQ(tracker.totals().pliMessages, 0u);
+}
+
+TEST(RtcpFeedbackTrackerTest, LatestReceiverReportAdvancesOnlyOnMatchingReports)
+{
+	constexpr uint32_t mediaSsrc = 0x22222222;
+	constexpr uint32_t lastSenderReport = 0x10000000;
+	RtcpFeedbackTracker tracker(mediaSsrc);
+	EXPECT_FALSE(tracker.latestReceiverReport(std::chrono::seconds(60)).has_value());
+
+	const auto report = makeReceiverReport(mediaSsrc, 64, 7, 900, lastSenderReport, 0);
+	tracker.observe(report.data(), report.size(), lastSenderReport + 8192);
+	const auto pli = makePli(mediaSsrc);
+	tracker.observe(pli.data(), pli.size());
+	const auto otherReport = makeReceiverReport(0x33333333, 128, 50, 900, 0, 0);
+	tracker.observe(otherReport.data(), otherReport.size());
+
+	auto latest = tracker.latestReceiverReport(std::chrono::seconds(60));
+	ASSERT_TRUE(latest.has_value());
+	EXPECT_EQ(latest->sequence, 1u);
+	EXPECT_EQ(latest->fractionLost, 64u);
+	EXPECT_EQ(latest->cumulativeLost, 7);
+	EXPECT_EQ(latest->jitterTicks, 900u);
+	EXPECT_EQ(latest->rttMs, 125u);
+
+	const auto noReference = makeReceiverReport(mediaSsrc, 0, 7, 300, 0, 0);
+	tracker.observe(noReference.data(), noReference.size());
+	latest = tracker.latestReceiverReport(std::chrono::seconds(60));
+	ASSERT_TRUE(latest.has_value());
+	EXPECT_EQ(latest->sequence, 2u);
+	EXPECT_FALSE(latest->rttMs.has_value());
+
+	tracker.reset();
+	EXPECT_FALSE(tracker.latestReceiverReport(std::chrono::seconds(60)).has_value());
+}
+
 TEST(RtcpFeedbackTrackerTest, SeparatesExpiredAndFailedRetransmissions)
 {
 	RtcpFeedbackTracker tracker;
@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -280,6 +281,79 @@ TEST(RtpPacketPacerTest, SharedBudgetWaitEndsEachReportedBurst)
 	EXPECT_LE(second.getStats().maxBatchBytes, 100u);
 }
 
+TEST(RtpPacketPacerTest, SharedBudgetSplitsBacklogByParticipantWeight)
+{
+	// 1000 bytes per millisecond in aggregate, one packet's worth of burst.
+	RtpSharedPacerBudget budget(1000);
+	const uint64_t guest = budget.addParticipant(4000000, pacerWeightForViewerRole(ViewerPacerRole::Guest));
+	const uint64_t scene = budget.addParticipant(4000000, pacerWeightForViewerRole(ViewerPacerRole::Scene));
+
+	std::atomic<bool> stopping{false};
+	std::atomic<int> grants{0};
+	auto drain = [&](uint64_t participant) {
+		while (!stopping.load()) {
+			if (budget.acquire(participant, 1000, false, [&]() { return stopping.load(); })) {
+				if (grants.fetch_add(1) + 1 >= 200) {
+					stopping.store(true);
+				}
+			}
+		}
+		budget.wake(guest);
+		budget.wake(scene);
+	};
+	std::thread guestThread(drain, guest);
+	std::thread sceneThread(drain, scene);
+	guestThread.join();
+	sceneThread.join();
+
+	const RtpSharedBudgetShare guestShare = budget.takeParticipantShare(guest, true);
+	const RtpSharedBudgetShare sceneShare = budget.takeParticipantShare(scene, false);
+	EXPECT_EQ(guestShare.weight, 1u);
+	EXPECT_EQ(sceneShare.weight, 4u);
+	EXPECT_EQ(guestShare.totalGrantedBytes, guestShare.grantedBytes + sceneShare.grantedBytes);
+	EXPECT_EQ(sceneShare.waitUs.count, sceneShare.grantedPackets);
+	// Strict FIFO would split a shared backlog evenly.
+	EXPECT_GE(sceneShare.grantedPackets, guestShare.grantedPackets * 3);
+	EXPECT_LE(sceneShare.grantedPackets, guestShare.grantedPackets * 5 + 5);
+	EXPECT_EQ(budget.takeParticipantShare(guest, false).grantedPackets, 0u);
+}
+
+TEST(RtpPacketPacerTest, SharedBudgetServesPriorityRequestsAheadOfTheBacklog)
+{
+	// 1000 bytes every 30 ms or so, so every participant is left waiting.
+	RtpSharedPacerBudget budget(1000);
+	const uint64_t first = budget.addParticipant(80000);
+	const uint64_t second = budget.addParticipant(80000);
+	const uint64_t joining = budget.addParticipant(80000);
+
+	std::atomic<bool> stopping{false};
+	std::atomic<int> grants{0};
+	auto drain = [&](uint64_t participant) {
+		while (!stopping.load()) {
+			if (budget.acquire(participant, 1000, false, [&]() { return stopping.load(); })) {
+				grants.fetch_add(1);
+			}
+		}
+	};
+	std::thread firstThread(drain, first);
+	std::thread secondThread(drain, second);
+	std::this_thread::sleep_for(100ms);
+
+	const int grantsBefore = grants.load();
+	ASSERT_TRUE(budget.acquire(joining, 1000, true, {}));
+	const int grantsMeanwhile = grants.load() - grantsBefore;
+	stopping.store(true);
+	budget.wake(first);
+	budget.wake(second);
+	firstThread.join();
+	secondThread.join();
+
+	// Without priority the request would queue behind both backlogged
+	// participants; at most the grant already in flight goes first.
+	EXPECT_LE(grantsMeanwhile, 1);
+	EXPECT_EQ(budget.takeParticipantShare(joining, false).priorityPackets, 1u);
+}
+
 TEST(RtpPacketPacerTest, RuntimeBitrateUpdateChangesLocalAndAggregateRates)
 {
 	auto sharedBudget = std::make_shared<RtpSharedPacerBudget>(4096);
@@ -536,6 +610,50 @@ TEST(RtpPacketPacerTest, CompletesAFrameOnlyAfterItsLastPacketIsSent)
 	EXPECT_EQ(pacer.getStats().sentKeyframes, 1u);
 }
 
+TEST(RtpPacketPacerTest, RecordsFrameHoldAndSendCallHistograms)
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t completedFrames = 0;
+	RtpPacketPacer pacer(
+	    80000, 20ms,
+	    [](RtpPacketPacer::Packet &&) {
+		    std::this_thread::sleep_for(2ms);
+		    return true;
+	    },
+	    4096);
+
+	for (uint8_t value = 1; value <= 2; ++value) {
+		std::vector<RtpPacketPacer::Packet> frame;
+		frame.push_back(packetWithValue(100, value));
+		frame.push_back(packetWithValue(100, value));
+		ASSERT_TRUE(pacer.enqueueFrame(std::move(frame), {}, [&](const RtpPacerFrameResult &) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				++completedFrames;
+			}
+			cv.notify_one();
+		}));
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		ASSERT_TRUE(cv.wait_for(lock, 2s, [&completedFrames]() { return completedFrames == 2; }));
+	}
+	pacer.stop();
+
+	const RtpPacerStats stats = pacer.getStats(true);
+	EXPECT_EQ(stats.frameHoldUs.count, 2u);
+	EXPECT_EQ(stats.sendCallUs.count, 4u);
+	EXPECT_GE(stats.sendCallUs.percentileUs(0.5), 1500u);
+	// The second frame waits behind the first frame's sends and pacing.
+	EXPECT_GE(stats.frameHoldUs.maxUs, 4000u);
+
+	const RtpPacerStats drained = pacer.getStats();
+	EXPECT_EQ(drained.frameHoldUs.count, 0u);
+	EXPECT_EQ(drained.sendCallUs.count, 0u);
+}
+
 TEST(RtpPacketPacerTest, StopsSendingTheRestOfAFrameAfterTransportFailure)
 {
 	std::mutex mutex;
@@ -644,6 +762,59 @@ TEST(RtpPacketPacerTest, InterleavesRepairPacketsWithoutStarvingLiveFrame)
 	EXPECT_EQ(stats.sentFrames, 1u);
 }
 
+TEST(RtpPacketPacerTest, TotalsKeepCountingAcrossIntervalResets)
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t completedFrames = 0;
+	size_t repairsSent = 0;
+	RtpPacketPacer pacer(
+	    8000000, 2ms, [](RtpPacketPacer::Packet &&) { return true; }, 4096);
+
+	const auto onFrame = [&](const RtpPacerFrameResult &) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			++completedFrames;
+		}
+		cv.notify_all();
+	};
+	std::vector<RtpPacketPacer::Packet> frame;
+	for (uint8_t value = 0; value < 3; ++value) {
+		frame.push_back(packetWithValue(100, value));
+	}
+	ASSERT_TRUE(pacer.enqueueFrame(std::move(frame), {}, onFrame));
+	ASSERT_TRUE(pacer.enqueueRepair(
+	    packetWithValue(50, 9), [](RtpPacketPacer::Packet &&) { return true; },
+	    [&](RtpPacerRepairOutcome) {
+		    {
+			    std::lock_guard<std::mutex> lock(mutex);
+			    ++repairsSent;
+		    }
+		    cv.notify_all();
+	    }));
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		ASSERT_TRUE(cv.wait_for(lock, 1s, [&]() { return completedFrames == 1 && repairsSent == 1; }));
+	}
+	EXPECT_EQ(pacer.getStats(true).sentPackets, 4u);
+	EXPECT_EQ(pacer.getStats().sentPackets, 0u);
+
+	std::vector<RtpPacketPacer::Packet> second;
+	second.push_back(packetWithValue(100, 7));
+	ASSERT_TRUE(pacer.enqueueFrame(std::move(second), {}, onFrame));
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		ASSERT_TRUE(cv.wait_for(lock, 1s, [&]() { return completedFrames == 2; }));
+	}
+	pacer.stop();
+
+	const RtpPacerTotals totals = pacer.totals();
+	EXPECT_EQ(totals.sentPackets, 5u);
+	EXPECT_EQ(totals.sentBytes, 450u);
+	EXPECT_EQ(totals.sentRepairs, 1u);
+	EXPECT_EQ(totals.sentDuplicates, 0u);
+}
+
 TEST(RtpPacketPacerTest, RepairBudgetExpiresStaleNackWorkInsteadOfStarvingLiveMedia)
 {
 	std::mutex mutex;
@@ -0,0 +1,111 @@
+/*
+ * Unit tests for the parsed session description model
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-sdp.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+const std::string kOffer = "v=0\r\n"
+                           "m=audio 9 UDP/TLS/RTP/SAVPF 111\r\n"
+                           "a=mid:0\r\n"
+                           "a=rtpmap:111 opus/48000/2\r\n"
+                           "m=video 9 UDP/TLS/RTP/SAVPF 96 97\r\n"
+                           "a=mid:1\r\n"
+                           "a=extmap:4 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+                           "a=rtcp-fb:96 transport-cc\r\n"
+                           "a=rtcp-fb:96 nack\r\n"
+                           "a=rtpmap:96 H264/90000\r\n"
+                           "a=rtpmap:97 rtx/90000\r\n"
+                           "a=fmtp:97 apt=96\r\n";
+
+} // namespace
+
+TEST(SdpDocumentTest, UneditedDocumentSerializesToItsInput)
+{
+	const std::string mixed = "v=0\nm=video 9 UDP/TLS/RTP/SAVPF 96\r\n\r\na=mid:1";
+	const SdpDocument document(mixed);
+	EXPECT_FALSE(document.edited());
+	EXPECT_TRUE(document.hasLineBreaks());
+	EXPECT_EQ(document.serialize(), mixed);
+}
+
+TEST(SdpDocumentTest, RulesEditTheModelAndSerializeOnce)
+{
+	SdpDocument document(kOffer);
+	ASSERT_TRUE(stripUnsupportedTransportCcFeedback(document));
+	ASSERT_TRUE(document.insertAfterMediaLine("video", "b=AS:4000"));
+	EXPECT_FALSE(document.insertAfterMediaLine("application", "b=AS:1"));
+
+	const std::string expected = "v=0\r\n"
+	                             "m=audio 9 UDP/TLS/RTP/SAVPF 111\r\n"
+	                             "a=mid:0\r\n"
+	                             "a=rtpmap:111 opus/48000/2\r\n"
+	                             "m=video 9 UDP/TLS/RTP/SAVPF 96 97\r\n"
+	                             "b=AS:4000\r\n"
+	                             "a=mid:1\r\n"
+	                             "a=rtcp-fb:96 nack\r\n"
+	                             "a=rtpmap:96 H264/90000\r\n"
+	                             "a=rtpmap:97 rtx/90000\r\n"
+	                             "a=fmtp:97 apt=96\r\n";
+	EXPECT_EQ(document.serialize(), expected);
+	EXPECT_FALSE(stripUnsupportedTransportCcFeedback(document));
+
+	const auto sections = document.offeredMediaSections();
+	ASSERT_EQ(sections.size(), 2u);
+	ASSERT_EQ(sections[1].codecs.size(), 2u);
+	EXPECT_EQ(sections[1].codecs[1].associatedPayloadType, 96);
+}
+
+TEST(SdpDocumentTest, InsertedLineFollowsAnUnterminatedLastLine)
+{
+	SdpDocument document("v=0\r\nm=video 9 UDP/TLS/RTP/SAVPF 96");
+	ASSERT_TRUE(document.insertAfterMediaLine("video", "b=AS:500"));
+	EXPECT_EQ(document.serialize(), "v=0\r\nm=video 9 UDP/TLS/RTP/SAVPF 96\r\nb=AS:500\r\n");
+}
+
+TEST(SdpDocumentTest, MatchesWholeMediaTypesAndScopesMidToItsSection)
+{
+	SdpDocument document("v=0\r\n"
+	                     "m=videox 9 UDP/TLS/RTP/SAVPF 96\r\n"
+	                     "a=mid:x\r\n"
+	                     "m=audio 9 UDP/TLS/RTP/SAVPF 111\r\n"
+	                     "m=video 9 UDP/TLS/RTP/SAVPF 96\r\n"
+	                     "a=mid:1\r\n");
+	EXPECT_EQ(document.mid("video"), "1");
+	EXPECT_EQ(document.mid("audio"), "");
+	EXPECT_EQ(document.mid("application"), "");
+}
+
+TEST(SdpDocumentTest, DecodesEscapedLineEndingsBeforeApplyingRules)
+{
+	std::string escaped;
+	for (const char c : kOffer) {
+		if (c == '\r') {
+			escaped += "\\r";
+		} else if (c == '\n') {
+			escaped += "\\n";
+		} else {
+			escaped += c;
+		}
+	}
+
+	// Stripping first would have treated the whole offer as one transport-cc
+	// line and dropped it.
+	SdpDocument document(escaped);
+	EXPECT_TRUE(document.receivedEscapedLineEndings());
+	EXPECT_TRUE(document.hasLineBreaks());
+	ASSERT_TRUE(stripUnsupportedTransportCcFeedback(document));
+	const std::string serialized = document.serialize();
+	EXPECT_EQ(serialized.find("transport-cc"), std::string::npos);
+	EXPECT_NE(serialized.find("a=rtcp-fb:96 nack\r\n"), std::string::npos);
+	EXPECT_EQ(document.offeredMediaSections().size(), 2u);
+}
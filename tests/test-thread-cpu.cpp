@@ -0,0 +1,123 @@
+/*
+ * Unit tests for per-thread CPU accounting
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-thread-cpu.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace vdoninja;
+
+TEST(ThreadCpuTest, ParsesTaskStatWithSpacesAndParensInName)
+{
+	const std::string line = "4242 (vdo-pacer (2)) S 1 4242 4242 0 -1 4194368 12 0 0 0 150 35 0 0 20 0 9 0 100";
+	std::string name;
+	uint64_t user = 0;
+	uint64_t system = 0;
+	ASSERT_TRUE(parseProcTaskStat(line, name, user, system));
+	EXPECT_EQ(name, "vdo-pacer (2)");
+	EXPECT_EQ(user, 150u);
+	EXPECT_EQ(system, 35u);
+
+	EXPECT_FALSE(parseProcTaskStat("4242 vdo-pacer S 1", name, user, system));
+	EXPECT_FALSE(parseProcTaskStat("4242 (vdo-pacer) S 1 2 3", name, user, system));
+}
+
+TEST(ThreadCpuTest, MapsOnlyPluginThreadNamesToSubsystems)
+{
+	EXPECT_EQ(threadCpuSubsystem("vdo-pacer"), "pacer");
+	EXPECT_EQ(threadCpuSubsystem("vdo-rx-connect"), "rx-connect");
+	EXPECT_EQ(threadCpuSubsystem("vdo-"), "");
+	EXPECT_EQ(threadCpuSubsystem("obs-video"), "");
+}
+
+TEST(ThreadCpuTest, AttributesIntervalCpuToSubsystems)
+{
+	ThreadCpuSampler sampler;
+	EXPECT_TRUE(sampler.sample(0, {{1, "vdo-pacer", 1000}, {2, "vdo-pacer", 0}, {3, "obs-graphics", 0}},
+	                           {{"decode", 500}})
+	                .empty());
+
+	// One second later: two pacer threads used 300 ms together, decode was
+	// charged 200 ms, a new send thread has no baseline yet and the OBS
+	// thread is ignored.
+	const auto usage = sampler.sample(1000000,
+	                                  {{1, "vdo-pacer", 201000},
+	                                   {2, "vdo-pacer", 100000},
+	                                   {3, "obs-graphics", 900000},
+	                                   {4, "vdo-send", 50000}},
+	                                  {{"decode", 200500}});
+	ASSERT_EQ(usage.size(), 2u);
+	EXPECT_EQ(usage[0].subsystem, "pacer");
+	EXPECT_DOUBLE_EQ(usage[0].percent, 30.0);
+	EXPECT_EQ(usage[0].threads, 2);
+	EXPECT_EQ(usage[1].subsystem, "decode");
+	EXPECT_DOUBLE_EQ(usage[1].percent, 20.0);
+	EXPECT_EQ(usage[1].threads, 0);
+	EXPECT_EQ(formatSubsystemCpuUsage(usage), "pacer 30.0% (2 threads), decode 20.0%");
+}
+
+TEST(ThreadCpuTest, TreatsRenamedThreadIdAsNewThread)
+{
+	ThreadCpuSampler sampler;
+	sampler.sample(0, {{7, "vdo-stats", 1000}}, {});
+	EXPECT_TRUE(sampler.sample(1000000, {{7, "vdo-summary", 900000}}, {}).empty());
+	const auto usage = sampler.sample(2000000, {{7, "vdo-summary", 1000000}}, {});
+	ASSERT_EQ(usage.size(), 1u);
+	EXPECT_EQ(usage[0].subsystem, "summary");
+	EXPECT_DOUBLE_EQ(usage[0].percent, 10.0);
+}
+
+TEST(ThreadCpuTest, ChargesScopedCpuTimeOnTheCallingThread)
+{
+	const auto before = chargedThreadCpuTimes();
+	const uint64_t previous = before.count("test-busy") ? before.at("test-busy") : 0;
+	{
+		ThreadCpuCharge charge("test-busy");
+		const auto start = std::chrono::steady_clock::now();
+		std::atomic<uint64_t> spin{0};
+		while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {
+			spin.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	if (!currentThreadCpuTimeUs()) {
+		GTEST_SKIP() << "thread CPU clock unavailable";
+	}
+	const auto after = chargedThreadCpuTimes();
+	ASSERT_TRUE(after.count("test-busy"));
+	EXPECT_GT(after.at("test-busy"), previous);
+}
+
+#if defined(__linux__)
+TEST(ThreadCpuTest, ReadsNamedThreadsFromProc)
+{
+	std::atomic<bool> named{false};
+	std::atomic<bool> stop{false};
+	std::thread worker([&]() {
+		setCurrentThreadName("vdo-test-worker-name");
+		named.store(true);
+		while (!stop.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+	while (!named.load()) {
+		std::this_thread::yield();
+	}
+
+	bool found = false;
+	for (const ThreadCpuTimes &thread : readProcessThreadCpuTimes()) {
+		// Names are truncated to 15 characters.
+		if (thread.name == "vdo-test-worker") {
+			found = true;
+		}
+	}
+	stop.store(true);
+	worker.join();
+	EXPECT_TRUE(found);
+}
+#endif
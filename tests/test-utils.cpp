@@ -328,6 +328,16 @@ TEST_F(BuildInboundViewUrlTest, DoesNotTreatWhepPrefixedStreamIdAsDirectUrl)
 	          "https://vdo.ninja/?view=cam_2");
 }
 
+TEST_F(BuildInboundViewUrlTest, NativeInboundTargetsArePlainStreamIdsOnly)
+{
+	EXPECT_EQ(nativeInboundStreamId(" cam_1 "), "cam_1");
+	EXPECT_EQ(nativeInboundStreamId("whep:cam_2"), "cam_2");
+	EXPECT_EQ(nativeInboundStreamId("https://example.com/whep/stream"), "");
+	EXPECT_EQ(nativeInboundStreamId("whep:https://example.com/whep/stream"), "");
+	EXPECT_EQ(nativeInboundStreamId("https://vdo.ninja/?view=cam_2&room=greenroom"), "");
+	EXPECT_EQ(nativeInboundStreamId(""), "");
+}
+
 TEST_F(BuildInboundViewUrlTest, PreservesDirectVdoNinjaViewerPageUrl)
 {
 	EXPECT_EQ(buildInboundViewUrl("https://vdo.ninja", "https://vdo.ninja/?view=cam_2&room=greenroom&solo", "", "",
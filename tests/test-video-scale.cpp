@@ -0,0 +1,80 @@
+/*
+ * Unit tests for native receive color conversion policy
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-video-scale.h"
+
+using namespace vdoninja;
+
+TEST(VideoScaleTest, ParsesQualityNamesWithBilinearFallback)
+{
+	EXPECT_EQ(parseVideoScaleQuality("fast"), VideoScaleQuality::Fast);
+	EXPECT_EQ(parseVideoScaleQuality("bilinear"), VideoScaleQuality::Bilinear);
+	EXPECT_EQ(parseVideoScaleQuality("bicubic"), VideoScaleQuality::Bicubic);
+	EXPECT_EQ(parseVideoScaleQuality("lanczos"), VideoScaleQuality::Lanczos);
+	EXPECT_EQ(parseVideoScaleQuality(""), VideoScaleQuality::Bilinear);
+	EXPECT_EQ(parseVideoScaleQuality("spline"), VideoScaleQuality::Bilinear);
+
+	for (const auto quality : {VideoScaleQuality::Fast, VideoScaleQuality::Bilinear, VideoScaleQuality::Bicubic,
+	                           VideoScaleQuality::Lanczos}) {
+		EXPECT_EQ(parseVideoScaleQuality(videoScaleQualityName(quality)), quality);
+	}
+	EXPECT_EQ(parseVideoScaleQuality(kDefaultVideoScaleQuality), VideoScaleQuality::Bilinear);
+}
+
+TEST(VideoScaleTest, SameSizeConversionUsesCheapestFilter)
+{
+	EXPECT_EQ(selectVideoScaleFilter(VideoScaleQuality::Fast, 1920, 1080, 1920, 1080), VideoScaleFilter::Point);
+	EXPECT_EQ(selectVideoScaleFilter(VideoScaleQuality::Lanczos, 1920, 1080, 1920, 1080),
+	          VideoScaleFilter::FastBilinear);
+
+	EXPECT_EQ(selectVideoScaleFilter(VideoScaleQuality::Fast, 3840, 2160, 1920, 1080), VideoScaleFilter::FastBilinear);
+	EXPECT_EQ(selectVideoScaleFilter(VideoScaleQuality::Bilinear, 3840, 2160, 1920, 1080), VideoScaleFilter::Bilinear);
+	EXPECT_EQ(selectVideoScaleFilter(VideoScaleQuality::Bicubic, 1280, 720, 1920, 1080), VideoScaleFilter::Bicubic);
+	EXPECT_EQ(selectVideoScaleFilter(VideoScaleQuality::Lanczos, 1920, 1080, 1920, 1079), VideoScaleFilter::Lanczos);
+}
+
+TEST(VideoScaleTest, ThreadCountGrowsWithFrameSizeAndRespectsMachine)
+{
+	EXPECT_EQ(videoScaleThreadCount(1280, 720, 1280, 720, 16), 1);
+	EXPECT_EQ(videoScaleThreadCount(1920, 1080, 1920, 1080, 16), 2);
+	EXPECT_EQ(videoScaleThreadCount(3840, 2160, 1920, 1080, 16), 4);
+	EXPECT_EQ(videoScaleThreadCount(1280, 720, 3840, 2160, 16), 4);
+
+	EXPECT_EQ(videoScaleThreadCount(3840, 2160, 3840, 2160, 4), 2);
+	EXPECT_EQ(videoScaleThreadCount(3840, 2160, 3840, 2160, 1), 1);
+	EXPECT_EQ(videoScaleThreadCount(3840, 2160, 3840, 2160, 0), 1);
+	EXPECT_EQ(videoScaleThreadCount(-1, -1, 0, 0, 16), 1);
+}
+
+TEST(VideoScaleTest, KeyChangesOnAnyGeometryOrFormatChange)
+{
+	VideoScaleKey base;
+	base.srcWidth = 1920;
+	base.srcHeight = 1080;
+	base.srcFormat = 0;
+	base.dstWidth = 1280;
+	base.dstHeight = 720;
+	base.dstFormat = 28;
+	base.filter = VideoScaleFilter::Bilinear;
+	base.threads = 2;
+
+	VideoScaleKey same = base;
+	EXPECT_EQ(base, same);
+
+	VideoScaleKey changed = base;
+	changed.srcFormat = 23;
+	EXPECT_NE(base, changed);
+	changed = base;
+	changed.dstHeight = 719;
+	EXPECT_NE(base, changed);
+	changed = base;
+	changed.filter = VideoScaleFilter::Bicubic;
+	EXPECT_NE(base, changed);
+	changed = base;
+	changed.threads = 1;
+	EXPECT_NE(base, changed);
+}
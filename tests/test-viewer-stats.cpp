@@ -0,0 +1,129 @@
+/*
+ * Unit tests for per-viewer transport stats
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include <gtest/gtest.h>
+
+#include "vdoninja-viewer-stats.h"
+#include "vdoninja-utils.h"
+
+using namespace vdoninja;
+
+namespace
+{
+
+ViewerTransportSample sampleAt(const std::string &uuid, int64_t atMs, uint64_t packets, uint64_t bytes,
+                               uint64_t repairs = 0, uint64_t duplicates = 0)
+{
+	ViewerTransportSample sample;
+	sample.uuid = uuid;
+	sample.sampledAtMs = atMs;
+	sample.pacer.sentPackets = packets;
+	sample.pacer.sentBytes = bytes;
+	sample.pacer.sentRepairs = repairs;
+	sample.pacer.sentDuplicates = duplicates;
+	return sample;
+}
+
+} // namespace
+
+TEST(ViewerTransportStatsTest, FirstSampleReportsCountersButNoRate)
+{
+	ViewerTransportSample sample = sampleAt("viewer", 1000, 100, 120000);
+	sample.candidateType = "relay";
+	sample.pacer.lastFrameQueueDelayMs = 12;
+	sample.feedback.nackMessages = 4;
+	sample.feedback.pliMessages = 2;
+	sample.feedback.lastFractionLost = 64;
+	sample.feedback.lastRttMs = 80;
+
+	const ViewerTransportStats stats = deriveViewerTransportStats(nullptr, sample);
+	EXPECT_EQ(stats.uuid, "viewer");
+	EXPECT_EQ(stats.candidateType, "relay");
+	EXPECT_EQ(stats.sendBitrateBps, -1);
+	EXPECT_EQ(stats.pacerQueueDelayMs, 12u);
+	EXPECT_DOUBLE_EQ(stats.lossRate, 0.25);
+	EXPECT_EQ(stats.nackCount, 4u);
+	EXPECT_EQ(stats.pliCount, 2u);
+	EXPECT_EQ(stats.rttMs, 80u);
+}
+
+TEST(ViewerTransportStatsTest, DerivesBitrateAndRepairSharesFromCounterDeltas)
+{
+	const auto previous = sampleAt("viewer", 1000, 100, 100000, 2, 1);
+	const auto current = sampleAt("viewer", 2000, 300, 350000, 12, 21);
+
+	const ViewerTransportStats stats = deriveViewerTransportStats(&previous, current);
+	EXPECT_EQ(stats.sendBitrateBps, 2000000);
+	EXPECT_DOUBLE_EQ(stats.repairRate, 0.05);
+	EXPECT_DOUBLE_EQ(stats.duplicateRate, 0.1);
+	EXPECT_EQ(stats.candidateType, "unknown");
+}
+
+TEST(ViewerTransportStatsTest, ReplacedPacerRestartsTheRate)
+{
+	const auto previous = sampleAt("viewer", 1000, 5000, 6000000);
+	const auto current = sampleAt("viewer", 2000, 10, 12000);
+	EXPECT_EQ(deriveViewerTransportStats(&previous, current).sendBitrateBps, -1);
+}
+
+TEST(ViewerTransportStatsTest, CacheCollectsAtMostOncePerInterval)
+{
+	ViewerTransportStatsCache cache(1000);
+	int collections = 0;
+	uint64_t bytes = 0;
+	const auto collect = [&]() {
+		++collections;
+		bytes += 125000;
+		return std::vector<ViewerTransportSample>{sampleAt("a", 1000 * collections, bytes / 1000, bytes),
+		                                          sampleAt("", 0, 0, 0)};
+	};
+
+	auto stats = cache.get(1000, collect);
+	ASSERT_EQ(stats.size(), 1u);
+	EXPECT_EQ(stats["a"].sendBitrateBps, -1);
+	for (int64_t now = 1001; now < 2000; now += 100) {
+		cache.get(now, collect);
+	}
+	EXPECT_EQ(collections, 1);
+
+	stats = cache.get(2000, collect);
+	EXPECT_EQ(collections, 2);
+	EXPECT_EQ(stats["a"].sendBitrateBps, 1000000);
+
+	stats = cache.get(3000, []() { return std::vector<ViewerTransportSample>{}; });
+	EXPECT_TRUE(stats.empty());
+}
+
+TEST(ViewerTransportStatsTest, SerializesRatesAsJsonNumbers)
+{
+	ViewerTransportStats stats;
+	stats.candidateType = "host";
+	stats.sendBitrateBps = 2500000;
+	stats.lossRate = 0.125;
+	stats.repairRate = 0.01;
+
+	JsonParser parser(viewerTransportStatsJson(stats));
+	EXPECT_EQ(parser.getString("candidateType"), "host");
+	EXPECT_EQ(parser.getInt("sendBitrateBps"), 2500000);
+	EXPECT_EQ(parser.getRaw("lossRate"), "0.1250");
+	EXPECT_EQ(parser.getRaw("repairRate"), "0.0100");
+}
+
+TEST(ViewerTransportStatsTest, SumsKnownBitratesAndKeepsWorstQueueDelay)
+{
+	std::map<std::string, ViewerTransportStats> stats;
+	EXPECT_EQ(sumViewerTransportStats(stats).sendBitrateBps, -1);
+
+	stats["a"].sendBitrateBps = -1;
+	stats["a"].pacerQueueDelayMs = 40;
+	EXPECT_EQ(sumViewerTransportStats(stats).sendBitrateBps, -1);
+
+	stats["b"].sendBitrateBps = 1500000;
+	stats["b"].pacerQueueDelayMs = 12;
+	stats["c"].sendBitrateBps = 500000;
+	const ViewerTransportTotals totals = sumViewerTransportStats(stats);
+	EXPECT_EQ(totals.sendBitrateBps, 2000000);
+	EXPECT_EQ(totals.maxPacerQueueDelayMs, 40u);
+}
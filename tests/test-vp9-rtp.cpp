@@ -618,3 +618,117 @@ TEST(Vp9DescriptorFuzzTest, ScalabilityStructureLengthsAreBounded)
 		}
 	}
 }
+
+namespace
+{
+
+struct ReorderFeed {
+	RtpFrameReorderBuffer buffer;
+	std::vector<RtpReorderedFrame> frames;
+
+	bool push(uint16_t sequence, uint32_t timestamp, bool marker)
+	{
+		const uint8_t payload = static_cast<uint8_t>(sequence);
+		return buffer.push(sequence, timestamp, marker, &payload, 1, frames);
+	}
+};
+
+std::vector<uint16_t> sequencesOf(const RtpReorderedFrame &frame)
+{
+	std::vector<uint16_t> sequences;
+	for (const auto &packet : frame.packets) {
+		sequences.push_back(packet.sequence);
+		EXPECT_EQ(frame.bytes[packet.offset], static_cast<uint8_t>(packet.sequence));
+	}
+	return sequences;
+}
+
+} // namespace
+
+TEST(RtpFrameReorderBufferTest, ReleasesReorderedFramesIntactAndInOrder)
+{
+	ReorderFeed feed;
+	feed.push(65534, 3000, false);
+	feed.push(0, 3000, true);
+	EXPECT_TRUE(feed.frames.empty()) << "the marker arrived ahead of a packet";
+	feed.push(65535, 3000, false);
+	ASSERT_EQ(feed.frames.size(), 1u);
+	EXPECT_TRUE(feed.frames[0].intact);
+	EXPECT_EQ(sequencesOf(feed.frames[0]), std::vector<uint16_t>({65534, 65535, 0}));
+
+	// Late and duplicate packets of a released frame are discarded.
+	EXPECT_FALSE(feed.push(65535, 3000, false));
+	EXPECT_FALSE(feed.push(0, 3000, true));
+	feed.push(2, 6000, true);
+	feed.push(1, 6000, false);
+	ASSERT_EQ(feed.frames.size(), 2u);
+	EXPECT_TRUE(feed.frames[1].intact);
+	EXPECT_FALSE(feed.frames[1].followsLoss);
+	EXPECT_EQ(sequencesOf(feed.frames[1]), std::vector<uint16_t>({1, 2}));
+}
+
+TEST(RtpFrameReorderBufferTest, HolesAndLostTailsDamageTheirFrame)
+{
+	ReorderFeed feed;
+	feed.push(10, 3000, true);
+	// 12 is lost; the frame waits for it until the next one starts.
+	feed.push(11, 6000, false);
+	feed.push(13, 6000, true);
+	ASSERT_EQ(feed.frames.size(), 1u);
+	// 15, the marker of 9000, is lost: the gap is charged to it alone.
+	feed.push(14, 9000, false);
+	feed.push(16, 12000, true);
+	ASSERT_EQ(feed.frames.size(), 3u);
+	EXPECT_FALSE(feed.frames[1].intact);
+	EXPECT_FALSE(feed.frames[2].intact);
+	// 12000 waits for the gap before it until 15000 starts, and is intact.
+	feed.push(17, 15000, true);
+	ASSERT_EQ(feed.frames.size(), 5u);
+	EXPECT_TRUE(feed.frames[3].intact);
+	EXPECT_FALSE(feed.frames[3].followsLoss);
+	EXPECT_TRUE(feed.frames[4].intact);
+}
+
+TEST(RtpFrameReorderBufferTest, FlagsFramesAfterWholeFramesWereLost)
+{
+	ReorderFeed feed;
+	feed.push(10, 3000, true);
+	// 6000, packets 11 and 12, never arrives.
+	feed.push(13, 9000, true);
+	EXPECT_EQ(feed.frames.size(), 1u);
+	feed.push(14, 12000, true);
+	ASSERT_EQ(feed.frames.size(), 3u);
+	EXPECT_TRUE(feed.frames[1].intact);
+	EXPECT_TRUE(feed.frames[1].followsLoss);
+	EXPECT_FALSE(feed.frames[2].followsLoss);
+}
+
+TEST(RtpFrameReorderBufferTest, StragglersCloseTheGapBeforeTheNextFrame)
+{
+	ReorderFeed feed;
+	feed.push(10, 3000, false);
+	// 11, the marker of 3000, is overtaken by the next frame.
+	feed.push(12, 6000, true);
+	ASSERT_EQ(feed.frames.size(), 1u);
+	EXPECT_FALSE(feed.frames[0].intact);
+	EXPECT_FALSE(feed.push(11, 3000, true));
+	feed.push(13, 9000, true);
+	ASSERT_EQ(feed.frames.size(), 3u);
+	EXPECT_TRUE(feed.frames[1].intact);
+	EXPECT_TRUE(feed.frames[2].intact);
+	EXPECT_FALSE(feed.frames[2].followsLoss);
+}
+
+TEST(RtpFrameReorderBufferTest, TreatsALargeBackwardStepAsARestart)
+{
+	ReorderFeed feed;
+	feed.push(5000, 3000, true);
+	EXPECT_TRUE(feed.push(100, 90000, true));
+	ASSERT_EQ(feed.frames.size(), 2u);
+	EXPECT_TRUE(feed.frames[1].intact);
+	EXPECT_FALSE(feed.frames[1].followsLoss);
+
+	feed.buffer.reset();
+	EXPECT_TRUE(feed.push(100, 90000, true));
+	EXPECT_EQ(feed.frames.size(), 3u);
+}
@@ -0,0 +1,187 @@
+/*
+ * Native Receive Audio Conversion Benchmark
+ *
+ * Measures the cost per 20 ms Opus frame of handing decoded audio to OBS the
+ * way the native receiver used to (channel layout setup plus a fresh
+ * av_samples_alloc/av_freep around every swr_convert), with the pooled
+ * AudioPlaneBuffer, and with the direct pass-through used when the decoder
+ * output already matches. Input is 48 kHz stereo, both interleaved float
+ * (libopus) and planar float (FFmpeg's native Opus decoder).
+ *
+ * Usage:
+ *   audio-convert-bench [--frames 50000]
+ *
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-audio-output.h"
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace vdoninja;
+
+namespace
+{
+
+constexpr int kSampleRate = 48000;
+constexpr int kChannels = 2;
+constexpr int kFrameSamples = 960;
+
+struct Input {
+	AVSampleFormat format;
+	const char *name;
+	std::vector<float> samples;
+	const uint8_t *planes[kChannels] = {};
+};
+
+void fillInput(Input &input)
+{
+	input.samples.resize(static_cast<size_t>(kFrameSamples) * kChannels);
+	const bool planar = input.format == AV_SAMPLE_FMT_FLTP;
+	for (int i = 0; i < kFrameSamples; ++i) {
+		const float left = std::sin(static_cast<float>(i) * 0.05f) * 0.5f;
+		const float right = std::sin(static_cast<float>(i) * 0.07f) * 0.5f;
+		if (planar) {
+			input.samples[static_cast<size_t>(i)] = left;
+			input.samples[static_cast<size_t>(kFrameSamples + i)] = right;
+		} else {
+			input.samples[static_cast<size_t>(i) * 2] = left;
+			input.samples[static_cast<size_t>(i) * 2 + 1] = right;
+		}
+	}
+	const uint8_t *base = reinterpret_cast<const uint8_t *>(input.samples.data());
+	input.planes[0] = base;
+	input.planes[1] = planar ? base + kFrameSamples * sizeof(float) : nullptr;
+}
+
+SwrContext *makeConverter(AVSampleFormat inputFormat)
+{
+	AVChannelLayout layout;
+	av_channel_layout_default(&layout, kChannels);
+	SwrContext *context = nullptr;
+	const int result = swr_alloc_set_opts2(&context, &layout, AV_SAMPLE_FMT_FLTP, kSampleRate, &layout, inputFormat,
+	                                       kSampleRate, 0, nullptr);
+	av_channel_layout_uninit(&layout);
+	if (result < 0 || !context || swr_init(context) < 0) {
+		swr_free(&context);
+		return nullptr;
+	}
+	return context;
+}
+
+// Keeps the compiler from discarding the converted samples.
+volatile float gSink = 0.0f;
+
+void report(const char *input, const char *mode, int frames, std::clock_t cpuStart,
+            std::chrono::steady_clock::time_point wallStart, uint64_t allocations)
+{
+	const double cpuUs = 1000000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	const double wallUs =
+	    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wallStart).count();
+	std::printf("%-5s %-10s cpu %7.3f us/frame  wall %7.3f us/frame  allocations=%llu\n", input, mode,
+	            cpuUs / frames, wallUs / frames, static_cast<unsigned long long>(allocations));
+}
+
+void runAllocatePerFrame(const Input &input, int frames)
+{
+	SwrContext *context = makeConverter(input.format);
+	if (!context) {
+		std::printf("%-5s converter setup failed\n", input.name);
+		return;
+	}
+	const std::clock_t cpuStart = std::clock();
+	const auto wallStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; ++i) {
+		AVChannelLayout layout;
+		av_channel_layout_default(&layout, kChannels);
+		const int outputSamples = swr_get_out_samples(context, kFrameSamples);
+		uint8_t *dst[kChannels] = {};
+		int linesize = 0;
+		if (av_samples_alloc(dst, &linesize, kChannels, outputSamples, AV_SAMPLE_FMT_FLTP, 0) < 0) {
+			av_channel_layout_uninit(&layout);
+			break;
+		}
+		swr_convert(context, dst, outputSamples, input.planes, kFrameSamples);
+		gSink = gSink + reinterpret_cast<const float *>(dst[1])[0];
+		av_freep(&dst[0]);
+		av_channel_layout_uninit(&layout);
+	}
+	report(input.name, "alloc", frames, cpuStart, wallStart, static_cast<uint64_t>(frames));
+	swr_free(&context);
+}
+
+void runPooled(const Input &input, int frames)
+{
+	SwrContext *context = makeConverter(input.format);
+	if (!context) {
+		std::printf("%-5s converter setup failed\n", input.name);
+		return;
+	}
+	AudioPlaneBuffer buffer;
+	const std::clock_t cpuStart = std::clock();
+	const auto wallStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; ++i) {
+		const int outputSamples = swr_get_out_samples(context, kFrameSamples);
+		if (!buffer.reserve(kChannels, outputSamples, static_cast<int>(sizeof(float)))) {
+			break;
+		}
+		swr_convert(context, buffer.planes(), outputSamples, input.planes, kFrameSamples);
+		gSink = gSink + reinterpret_cast<const float *>(buffer.planes()[1])[0];
+	}
+	report(input.name, "pooled", frames, cpuStart, wallStart, buffer.allocations());
+	swr_free(&context);
+}
+
+void runDirect(const Input &input, int frames)
+{
+	const DecodedAudioFormat format =
+	    input.format == AV_SAMPLE_FMT_FLTP ? DecodedAudioFormat::FloatPlanar : DecodedAudioFormat::Float;
+	const std::clock_t cpuStart = std::clock();
+	const auto wallStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; ++i) {
+		if (!decodedAudioPassesThrough(format, kChannels)) {
+			break;
+		}
+		// What the receiver hands to obs_source_output_audio(): the decoder's own planes.
+		const uint8_t *data[kChannels] = {input.planes[0], input.planes[1]};
+		gSink = gSink + reinterpret_cast<const float *>(data[0])[i % kFrameSamples];
+	}
+	report(input.name, "direct", frames, cpuStart, wallStart, 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	int frames = 50000;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = std::max(1, std::atoi(argv[++i]));
+		}
+	}
+
+	Input inputs[] = {{AV_SAMPLE_FMT_FLT, "flt", {}}, {AV_SAMPLE_FMT_FLTP, "fltp", {}}};
+	std::printf("audio-convert-bench: %d frames of %d samples, %d channels at %d Hz\n", frames, kFrameSamples,
+	            kChannels, kSampleRate);
+	for (Input &input : inputs) {
+		fillInput(input);
+		runAllocatePerFrame(input, frames);
+		runPooled(input, frames);
+		runDirect(input, frames);
+	}
+	return 0;
+}
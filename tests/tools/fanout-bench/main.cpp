@@ -0,0 +1,983 @@
+/*
+ * Publisher Fan-out Benchmark
+ *
+ * Drives the production VDONinjaPeerManager publish path with a synthetic
+ * H.264 Annex B stream and fans it out to N in-process libdatachannel viewers
+ * over loopback, sweeping the viewer count and the encoder bitrate. Offers and
+ * candidates are relayed in process, so no signaling server, STUN server or
+ * network access is needed.
+ *
+ * For each configuration the measured window (after warm-up) reports:
+ *   - process CPU and the plugin's share of it (the sending thread plus the
+ *     vdo-* worker threads), overall and per viewer
+ *   - C++ heap allocations on the send path (sending thread and pacers) and
+ *     everywhere else (libdatachannel transport and the loopback viewers)
+ *   - pacer queue delay (enqueue to first packet on the wire) and the wait
+ *     for each packet's turn in the budget shared by all viewers
+ *   - send-to-receipt latency, from handing a frame to the peer manager to its
+ *     last RTP packet arriving at a viewer
+ *
+ * The loopback viewers share the process, so process CPU includes the
+ * receive side; the plugin figures do not.
+ *
+ * After the measured window, late viewers join one at a time at spread-out
+ * points in the GOP and are primed the way the output primes a new viewer.
+ * From the moment each is connected and primed, the run reports:
+ *   - time to the first video frame, still or moving
+ *   - time to the first moving frame: a delta frame continuing an unbroken
+ *     chain from a keyframe, so the picture actually changes
+ *   - time until its frames arrive as promptly as the live viewers' again
+ * --no-gop-cache primes with the cached keyframe only, for comparison.
+ *
+ * Usage:
+ *   fanout-bench [--viewers 1,2,4,8] [--bitrates 2500,6000] [--fps 30]
+ *                [--seconds 10] [--warmup 2] [--late-joins 4] [--no-gop-cache]
+ *                [--verbose]
+ *
+ * One JSON object per configuration is written to stdout; a readable summary
+ * and any plugin logging (--verbose) go to stderr.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-latency-histogram.h"
+#include "vdoninja-peer-manager.h"
+#include "vdoninja-thread-cpu.h"
+
+#include <rtc/rtc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace vdoninja;
+
+namespace testing_utils
+{
+void enableLogging(bool enable);
+}
+
+// ---------------------------------------------------------------------------
+// Allocation counting
+// ---------------------------------------------------------------------------
+
+namespace
+{
+
+// Each thread claims a fixed slot on its first allocation so counting never
+// allocates or locks. Threads beyond the last slot are pooled together.
+constexpr size_t kAllocationSlots = 4096;
+
+struct AllocationSlot {
+	std::atomic<uint64_t> threadId{0};
+	std::atomic<uint64_t> count{0};
+	std::atomic<uint64_t> bytes{0};
+};
+
+AllocationSlot gAllocationSlots[kAllocationSlots];
+std::atomic<size_t> gNextAllocationSlot{0};
+AllocationSlot gOverflowAllocations;
+
+uint64_t currentThreadId()
+{
+#if defined(__linux__)
+	return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+	return 0;
+#endif
+}
+
+void countAllocation(size_t size)
+{
+	thread_local AllocationSlot *slot = nullptr;
+	thread_local bool claimed = false;
+	if (!claimed) {
+		claimed = true;
+		const size_t index = gNextAllocationSlot.fetch_add(1, std::memory_order_relaxed);
+		if (index < kAllocationSlots) {
+			slot = &gAllocationSlots[index];
+			slot->threadId.store(currentThreadId(), std::memory_order_relaxed);
+		}
+	}
+	AllocationSlot &target = slot ? *slot : gOverflowAllocations;
+	target.count.fetch_add(1, std::memory_order_relaxed);
+	target.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void *countedAllocate(size_t size)
+{
+	countAllocation(size);
+	if (void *memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(size_t size)
+{
+	return countedAllocate(size);
+}
+
+void *operator new[](size_t size)
+{
+	return countedAllocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+namespace
+{
+
+struct AllocationCounts {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+// Per-slot counters; index kAllocationSlots holds the overflow pool.
+std::vector<AllocationCounts> snapshotAllocations()
+{
+	std::vector<AllocationCounts> counts(kAllocationSlots + 1);
+	for (size_t i = 0; i < kAllocationSlots; ++i) {
+		counts[i].count = gAllocationSlots[i].count.load(std::memory_order_relaxed);
+		counts[i].bytes = gAllocationSlots[i].bytes.load(std::memory_order_relaxed);
+	}
+	counts[kAllocationSlots].count = gOverflowAllocations.count.load(std::memory_order_relaxed);
+	counts[kAllocationSlots].bytes = gOverflowAllocations.bytes.load(std::memory_order_relaxed);
+	return counts;
+}
+
+struct AllocationBreakdown {
+	AllocationCounts send;
+	AllocationCounts pacer;
+	AllocationCounts other;
+};
+
+// Splits the allocations made between two snapshots by the thread that made
+// them: the benchmark's sending thread, the vdo-pacer threads, or anything
+// else. Thread names are read at the end of the window, while every pacer of
+// the configuration is still running.
+AllocationBreakdown allocationsBetween(const std::vector<AllocationCounts> &before,
+                                       const std::vector<AllocationCounts> &after, uint64_t sendThreadId)
+{
+	std::map<uint64_t, std::string> names;
+	for (const ThreadCpuTimes &thread : readProcessThreadCpuTimes()) {
+		names[thread.threadId] = thread.name;
+	}
+
+	AllocationBreakdown breakdown;
+	for (size_t i = 0; i < after.size(); ++i) {
+		const uint64_t count = after[i].count - before[i].count;
+		const uint64_t bytes = after[i].bytes - before[i].bytes;
+		if (count == 0) {
+			continue;
+		}
+		AllocationCounts *bucket = &breakdown.other;
+		if (i < kAllocationSlots) {
+			const uint64_t threadId = gAllocationSlots[i].threadId.load(std::memory_order_relaxed);
+			const auto name = names.find(threadId);
+			if (threadId == sendThreadId) {
+				bucket = &breakdown.send;
+			} else if (name != names.end() && threadCpuSubsystem(name->second) == "pacer") {
+				bucket = &breakdown.pacer;
+			}
+		}
+		bucket->count += count;
+		bucket->bytes += bytes;
+	}
+	return breakdown;
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic H.264 stream
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t kVideoClockRate = 90000;
+constexpr uint32_t kFirstTimestamp = 3000;
+constexpr int kGopSeconds = 2;
+// Keyframes are sized at this multiple of the average frame, as a typical
+// x264 CBR stream at 30 fps produces.
+constexpr int kKeyframeSizeFactor = 4;
+
+// Constrained Baseline 3.1, 1280x720.
+const uint8_t kSps[] = {0x67, 0x42, 0xE0, 0x1F, 0xDA, 0x01, 0x40, 0x16, 0xEC, 0x04, 0x40, 0x00, 0x00, 0x03, 0x00, 0x40,
+                        0x00, 0x00, 0x0F, 0x03, 0xC6, 0x0C, 0xA8};
+const uint8_t kPps[] = {0x68, 0xCE, 0x3C, 0x80};
+
+void appendNal(std::vector<uint8_t> &frame, const uint8_t *nal, size_t size)
+{
+	static const uint8_t startCode[] = {0x00, 0x00, 0x00, 0x01};
+	frame.insert(frame.end(), startCode, startCode + sizeof(startCode));
+	frame.insert(frame.end(), nal, nal + size);
+}
+
+// Slice payload bytes stay in 1..255 so no start code or emulation
+// prevention sequence appears inside a NAL unit.
+void appendSlice(std::vector<uint8_t> &frame, uint8_t header, size_t payloadSize)
+{
+	std::vector<uint8_t> nal(payloadSize + 1);
+	nal[0] = header;
+	uint32_t state = 0x9E3779B9u ^ static_cast<uint32_t>(payloadSize);
+	for (size_t i = 1; i < nal.size(); ++i) {
+		state = state * 1664525u + 1013904223u;
+		nal[i] = static_cast<uint8_t>(1 + (state >> 24) % 255);
+	}
+	appendNal(frame, nal.data(), nal.size());
+}
+
+struct SyntheticStream {
+	std::vector<uint8_t> keyframe;
+	std::vector<uint8_t> deltaFrame;
+	int gopFrames = 0;
+};
+
+SyntheticStream buildStream(int bitrateKbps, int fps)
+{
+	SyntheticStream stream;
+	stream.gopFrames = std::max(1, fps * kGopSeconds);
+	const size_t averageBytes = std::max<size_t>(64, static_cast<size_t>(bitrateKbps) * 1000 / 8 / fps);
+	const size_t keyframeBytes = averageBytes * kKeyframeSizeFactor;
+	const size_t gopBytes = averageBytes * static_cast<size_t>(stream.gopFrames);
+	const size_t deltaBytes =
+	    stream.gopFrames > 1 ? std::max<size_t>(32, (gopBytes - std::min(gopBytes, keyframeBytes)) /
+	                                                    static_cast<size_t>(stream.gopFrames - 1))
+	                         : averageBytes;
+
+	appendNal(stream.keyframe, kSps, sizeof(kSps));
+	appendNal(stream.keyframe, kPps, sizeof(kPps));
+	appendSlice(stream.keyframe, 0x65, keyframeBytes);
+	appendSlice(stream.deltaFrame, 0x41, deltaBytes);
+	return stream;
+}
+
+// ---------------------------------------------------------------------------
+// Loopback viewers
+// ---------------------------------------------------------------------------
+
+int64_t steadyNowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+// Shared between the sending loop and every viewer's track callbacks.
+struct FrameClock {
+	uint32_t timestampStep = 0;
+	size_t measuredFrom = 0;
+	size_t measuredUntil = 0;
+	std::vector<std::atomic<int64_t>> sentAtUs;
+	LatencyHistogram latency;
+
+	explicit FrameClock(size_t frames) : sentAtUs(frames) {}
+};
+
+struct LoopbackViewer {
+	std::shared_ptr<rtc::PeerConnection> pc;
+	std::mutex tracksMutex;
+	std::vector<std::shared_ptr<rtc::Track>> tracks;
+	// Only touched from the track's callback thread.
+	int64_t lastFrame = -1;
+	std::atomic<uint64_t> measuredFrames{0};
+	std::atomic<uint64_t> receivedBytes{0};
+};
+
+// The frame index carried by an RTP packet that ends a frame, or -1.
+int64_t markerFrameIndex(const FrameClock &clock, const uint8_t *packet)
+{
+	if ((packet[1] & 0x80) == 0) {
+		return -1;
+	}
+	const uint32_t timestamp = (static_cast<uint32_t>(packet[4]) << 24) | (static_cast<uint32_t>(packet[5]) << 16) |
+	                           (static_cast<uint32_t>(packet[6]) << 8) | packet[7];
+	const uint32_t offset = timestamp - kFirstTimestamp;
+	if (offset % clock.timestampStep != 0 || offset / clock.timestampStep >= clock.sentAtUs.size()) {
+		return -1;
+	}
+	return static_cast<int64_t>(offset / clock.timestampStep);
+}
+
+void receiveRtp(LoopbackViewer &viewer, FrameClock &clock, const rtc::binary &message)
+{
+	if (message.size() < 12) {
+		return;
+	}
+	const auto *packet = reinterpret_cast<const uint8_t *>(message.data());
+	const uint8_t payloadType = packet[1] & 0x7F;
+	// RTCP shares the port under rtcp-mux (RFC 5761).
+	if (payloadType >= 72 && payloadType <= 76) {
+		return;
+	}
+	viewer.receivedBytes.fetch_add(message.size(), std::memory_order_relaxed);
+	const int64_t frame = markerFrameIndex(clock, packet);
+	// Repairs and duplicates repeat the marker packet of a frame already seen.
+	if (frame < 0 || frame <= viewer.lastFrame) {
+		return;
+	}
+	viewer.lastFrame = frame;
+	if (static_cast<size_t>(frame) < clock.measuredFrom || static_cast<size_t>(frame) >= clock.measuredUntil) {
+		return;
+	}
+	viewer.measuredFrames.fetch_add(1, std::memory_order_relaxed);
+	const int64_t sentAtUs = clock.sentAtUs[frame].load(std::memory_order_acquire);
+	if (sentAtUs > 0) {
+		clock.latency.record(static_cast<uint64_t>(std::max<int64_t>(0, steadyNowUs() - sentAtUs)));
+	}
+}
+
+// A viewer that joins mid-stream. Times are steady-clock microseconds, 0 until
+// the event has happened.
+struct JoinProbe {
+	std::shared_ptr<rtc::PeerConnection> pc;
+	std::mutex tracksMutex;
+	std::vector<std::shared_ptr<rtc::Track>> tracks;
+	size_t gopFrames = 1;
+	// A delta frame has caught up once it arrives within this long of being
+	// handed to the peer manager.
+	int64_t caughtUpLatencyUs = 0;
+	// Only touched from the track's callback thread.
+	int64_t lastFrame = -1;
+	bool chained = false;
+	std::atomic<int64_t> primedAtUs{0};
+	std::atomic<int64_t> firstFrameAtUs{0};
+	std::atomic<int64_t> firstMovingFrameAtUs{0};
+	std::atomic<int64_t> caughtUpAtUs{0};
+};
+
+void receiveJoinProbeRtp(JoinProbe &probe, const FrameClock &clock, const rtc::binary &message)
+{
+	if (message.size() < 12) {
+		return;
+	}
+	const auto *packet = reinterpret_cast<const uint8_t *>(message.data());
+	const uint8_t payloadType = packet[1] & 0x7F;
+	if (payloadType >= 72 && payloadType <= 76) {
+		return;
+	}
+	const int64_t frame = markerFrameIndex(clock, packet);
+	if (frame < 0 || frame <= probe.lastFrame) {
+		return;
+	}
+	const int64_t nowUs = steadyNowUs();
+	const bool keyframe = static_cast<size_t>(frame) % probe.gopFrames == 0;
+	// Lossless loopback delivers whole frames, so a delta is decodable exactly
+	// when it directly follows a decodable frame.
+	const bool moving = !keyframe && probe.chained && frame == probe.lastFrame + 1;
+	probe.chained = keyframe || moving;
+	probe.lastFrame = frame;
+
+	int64_t unset = 0;
+	probe.firstFrameAtUs.compare_exchange_strong(unset, nowUs);
+	if (!moving) {
+		return;
+	}
+	unset = 0;
+	probe.firstMovingFrameAtUs.compare_exchange_strong(unset, nowUs);
+	const int64_t sentAtUs = clock.sentAtUs[frame].load(std::memory_order_acquire);
+	if (sentAtUs > 0 && nowUs - sentAtUs <= probe.caughtUpLatencyUs) {
+		unset = 0;
+		probe.caughtUpAtUs.compare_exchange_strong(unset, nowUs);
+	}
+}
+
+// Relays one side's description and candidates to the other, holding
+// candidates back until the remote description has been applied.
+class LoopbackSignaling : public std::enable_shared_from_this<LoopbackSignaling>
+{
+public:
+	static std::shared_ptr<LoopbackSignaling> connect(const std::shared_ptr<rtc::PeerConnection> &publisher,
+	                                                  const std::shared_ptr<rtc::PeerConnection> &viewer)
+	{
+		auto signaling = std::shared_ptr<LoopbackSignaling>(new LoopbackSignaling());
+		signaling->directions_[0].target = viewer;
+		signaling->directions_[1].target = publisher;
+		signaling->install(publisher, 0);
+		signaling->install(viewer, 1);
+		return signaling;
+	}
+
+private:
+	struct Direction {
+		std::weak_ptr<rtc::PeerConnection> target;
+		bool descriptionApplied = false;
+		std::vector<rtc::Candidate> candidates;
+	};
+
+	LoopbackSignaling() = default;
+
+	void install(const std::shared_ptr<rtc::PeerConnection> &source, int direction)
+	{
+		const std::weak_ptr<LoopbackSignaling> weakSelf = shared_from_this();
+		source->onLocalDescription([weakSelf, direction](rtc::Description description) {
+			if (const auto self = weakSelf.lock()) {
+				self->applyDescription(direction, description);
+			}
+		});
+		source->onLocalCandidate([weakSelf, direction](rtc::Candidate candidate) {
+			if (const auto self = weakSelf.lock()) {
+				self->addCandidate(direction, std::move(candidate));
+			}
+		});
+	}
+
+	void applyDescription(int direction, const rtc::Description &description)
+	{
+		const auto target = directions_[direction].target.lock();
+		if (!target) {
+			return;
+		}
+		try {
+			target->setRemoteDescription(description);
+		} catch (const std::exception &error) {
+			std::fprintf(stderr, "loopback signaling: %s\n", error.what());
+			return;
+		}
+		std::vector<rtc::Candidate> candidates;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			directions_[direction].descriptionApplied = true;
+			candidates.swap(directions_[direction].candidates);
+		}
+		for (const auto &candidate : candidates) {
+			addRemoteCandidate(target, candidate);
+		}
+	}
+
+	void addCandidate(int direction, rtc::Candidate candidate)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!directions_[direction].descriptionApplied) {
+				directions_[direction].candidates.push_back(std::move(candidate));
+				return;
+			}
+		}
+		if (const auto target = directions_[direction].target.lock()) {
+			addRemoteCandidate(target, candidate);
+		}
+	}
+
+	static void addRemoteCandidate(const std::shared_ptr<rtc::PeerConnection> &target, const rtc::Candidate &candidate)
+	{
+		try {
+			target->addRemoteCandidate(candidate);
+		} catch (const std::exception &error) {
+			std::fprintf(stderr, "loopback signaling: %s\n", error.what());
+		}
+	}
+
+	std::mutex mutex_;
+	Direction directions_[2];
+};
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+struct Options {
+	std::vector<int> viewers = {1, 2, 4, 8};
+	std::vector<int> bitratesKbps = {2500, 6000};
+	int fps = 30;
+	int seconds = 10;
+	int warmupSeconds = 2;
+	int lateJoins = 4;
+	bool gopCache = true;
+	bool verbose = false;
+};
+
+struct JoinResult {
+	int attempted = 0;
+	int connected = 0;
+	int primedWithGop = 0;
+	// From priming to each milestone, per joined viewer.
+	LatencyHistogramSnapshot firstFrameUs;
+	LatencyHistogramSnapshot firstMovingFrameUs;
+	LatencyHistogramSnapshot caughtUpUs;
+};
+
+struct Result {
+	int viewers = 0;
+	int bitrateKbps = 0;
+	bool connected = false;
+	int64_t connectMs = 0;
+	double windowSeconds = 0.0;
+	uint64_t framesSent = 0;
+	uint64_t framesReceivedMin = 0;
+	double framesReceivedAvg = 0.0;
+	double receivedKbpsPerViewer = 0.0;
+	double processCpuPercent = 0.0;
+	double pluginCpuPercent = 0.0;
+	std::vector<SubsystemCpuUsage> threadCpu;
+	AllocationBreakdown allocations;
+	RtpPacerStats pacer;
+	LatencyHistogramSnapshot latency;
+	JoinResult joins;
+};
+
+double processCpuSeconds()
+{
+	return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+std::vector<int> parseList(const char *text)
+{
+	std::vector<int> values;
+	const char *cursor = text;
+	while (*cursor) {
+		char *end = nullptr;
+		const long value = std::strtol(cursor, &end, 10);
+		if (end == cursor) {
+			break;
+		}
+		if (value > 0) {
+			values.push_back(static_cast<int>(value));
+		}
+		cursor = *end == ',' ? end + 1 : end;
+	}
+	return values;
+}
+
+bool waitForConnections(VDONinjaPeerManager &manager, const std::vector<std::string> &uuids, int timeoutMs)
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	while (std::chrono::steady_clock::now() < deadline) {
+		const bool allConnected = std::all_of(uuids.begin(), uuids.end(), [&](const std::string &uuid) {
+			return manager.getPeerState(uuid) == ConnectionState::Connected;
+		});
+		if (allConnected) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+// Connects one late viewer per entry of joinFrames, each once the sending
+// loop has reached that frame, and primes it the way the output primes a new
+// viewer: with the current GOP when the cache allows, otherwise with the latest
+// keyframe as a still image.
+void runLateJoins(VDONinjaPeerManager &manager, const Options &options, const SyntheticStream &stream,
+                  FrameClock &clock, const std::vector<size_t> &joinFrames, const std::atomic<size_t> &framesSent,
+                  std::vector<std::shared_ptr<JoinProbe>> &probes,
+                  std::vector<std::shared_ptr<LoopbackSignaling>> &relays, JoinResult &result)
+{
+	for (size_t join = 0; join < joinFrames.size(); ++join) {
+		while (framesSent.load(std::memory_order_acquire) < joinFrames[join]) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		const std::string uuid = "bench-late-viewer-" + std::to_string(join);
+		auto probe = std::make_shared<JoinProbe>();
+		probe->gopFrames = static_cast<size_t>(stream.gopFrames);
+		probe->caughtUpLatencyUs = 1000000 / options.fps;
+		probe->pc = std::make_shared<rtc::PeerConnection>(rtc::Configuration{});
+		JoinProbe *rawProbe = probe.get();
+		probe->pc->onTrack([rawProbe, &clock](std::shared_ptr<rtc::Track> track) {
+			track->onMessage(
+			    [rawProbe, &clock](rtc::binary message) { receiveJoinProbeRtp(*rawProbe, clock, message); }, nullptr);
+			std::lock_guard<std::mutex> lock(rawProbe->tracksMutex);
+			rawProbe->tracks.push_back(std::move(track));
+		});
+		probes.push_back(probe);
+		result.attempted++;
+
+		auto peer = manager.createNativeMediaTestPublisherPeer(uuid, "bench-late-session-" + std::to_string(join));
+		relays.push_back(LoopbackSignaling::connect(peer->pc, probe->pc));
+		peer->pc->setLocalDescription();
+		if (!waitForConnections(manager, {uuid}, 5000)) {
+			continue;
+		}
+		result.connected++;
+
+		probe->primedAtUs.store(steadyNowUs(), std::memory_order_release);
+		if (options.gopCache && manager.primePeerWithCachedGop(uuid)) {
+			result.primedWithGop++;
+			continue;
+		}
+		const size_t sent = framesSent.load(std::memory_order_acquire);
+		const size_t keyframe = sent == 0 ? 0 : (sent - 1) / probe->gopFrames * probe->gopFrames;
+		manager.sendVideoFrameToPeer(uuid, stream.keyframe.data(), stream.keyframe.size(),
+		                             kFirstTimestamp + static_cast<uint32_t>(keyframe) * clock.timestampStep, true,
+		                             true);
+	}
+}
+
+Result runConfiguration(const Options &options, int viewerCount, int bitrateKbps)
+{
+	Result result;
+	result.viewers = viewerCount;
+	result.bitrateKbps = bitrateKbps;
+
+	const SyntheticStream stream = buildStream(bitrateKbps, options.fps);
+	const size_t gopFrames = static_cast<size_t>(stream.gopFrames);
+	const size_t warmupFrames = static_cast<size_t>(options.fps) * static_cast<size_t>(options.warmupSeconds);
+	const size_t totalFrames = warmupFrames + static_cast<size_t>(options.fps) * static_cast<size_t>(options.seconds);
+	// Late joins follow the measured window, one per GOP at evenly spread
+	// points within it, with one more GOP for the last joiner to get moving.
+	const size_t lateJoins = static_cast<size_t>(options.lateJoins);
+	std::vector<size_t> joinFrames;
+	for (size_t join = 0; join < lateJoins; ++join) {
+		joinFrames.push_back(totalFrames + join * gopFrames + (2 * join + 1) * gopFrames / (2 * lateJoins));
+	}
+	const size_t allFrames = totalFrames + (lateJoins ? (lateJoins + 1) * gopFrames : 0);
+	FrameClock clock(allFrames);
+	clock.timestampStep = kVideoClockRate / static_cast<uint32_t>(options.fps);
+	clock.measuredFrom = warmupFrames;
+	clock.measuredUntil = totalFrames;
+
+	auto manager = std::make_unique<VDONinjaPeerManager>();
+	// A loopback STUN address keeps gathering offline; host candidates connect.
+	manager->setIceServers({IceServer{"stun:127.0.0.1:3478", "", ""}});
+	manager->setEnableDataChannel(false);
+	manager->setBitrate(bitrateKbps * 1000);
+	manager->setGopFastStartEnabled(options.gopCache);
+	manager->startPublishing(viewerCount + options.lateJoins);
+
+	std::vector<std::string> uuids;
+	std::vector<std::shared_ptr<LoopbackViewer>> viewers;
+	std::vector<std::shared_ptr<JoinProbe>> probes;
+	std::vector<std::shared_ptr<LoopbackSignaling>> relays;
+	const int64_t connectStartUs = steadyNowUs();
+	for (int i = 0; i < viewerCount; ++i) {
+		const std::string uuid = "bench-viewer-" + std::to_string(i);
+		auto viewer = std::make_shared<LoopbackViewer>();
+		viewer->pc = std::make_shared<rtc::PeerConnection>(rtc::Configuration{});
+		LoopbackViewer *rawViewer = viewer.get();
+		viewer->pc->onTrack([rawViewer, &clock](std::shared_ptr<rtc::Track> track) {
+			track->onMessage([rawViewer, &clock](rtc::binary message) { receiveRtp(*rawViewer, clock, message); },
+			                 nullptr);
+			std::lock_guard<std::mutex> lock(rawViewer->tracksMutex);
+			rawViewer->tracks.push_back(std::move(track));
+		});
+
+		auto peer = manager->createNativeMediaTestPublisherPeer(uuid, "bench-session-" + std::to_string(i));
+		relays.push_back(LoopbackSignaling::connect(peer->pc, viewer->pc));
+		peer->pc->setLocalDescription();
+		uuids.push_back(uuid);
+		viewers.push_back(std::move(viewer));
+	}
+
+	result.connected = waitForConnections(*manager, uuids, 10000 + viewerCount * 500);
+	result.connectMs = (steadyNowUs() - connectStartUs) / 1000;
+
+	if (result.connected) {
+		const uint64_t sendThreadId = currentThreadId();
+		ThreadCpuSampler sampler;
+		std::vector<AllocationCounts> allocationsBefore;
+		double cpuBefore = 0.0;
+		uint64_t sendThreadCpuBefore = 0;
+		int64_t windowStartUs = 0;
+
+		const auto frameInterval = std::chrono::microseconds(1000000 / options.fps);
+		auto nextFrame = std::chrono::steady_clock::now();
+		std::atomic<size_t> framesSent{0};
+		const auto sendFrame = [&](size_t frame) {
+			std::this_thread::sleep_until(nextFrame);
+			nextFrame += frameInterval;
+
+			const bool keyframe = frame % gopFrames == 0;
+			const std::vector<uint8_t> &data = keyframe ? stream.keyframe : stream.deltaFrame;
+			const uint32_t timestamp = kFirstTimestamp + static_cast<uint32_t>(frame) * clock.timestampStep;
+			clock.sentAtUs[frame].store(steadyNowUs(), std::memory_order_release);
+			manager->sendVideoFrame(data.data(), data.size(), timestamp, keyframe);
+			framesSent.store(frame + 1, std::memory_order_release);
+		};
+
+		for (size_t frame = 0; frame < totalFrames; ++frame) {
+			if (frame == warmupFrames) {
+				manager->takeVideoPacerStats();
+				sampler.query();
+				sendThreadCpuBefore = currentThreadCpuTimeUs().value_or(0);
+				cpuBefore = processCpuSeconds();
+				allocationsBefore = snapshotAllocations();
+				windowStartUs = steadyNowUs();
+			}
+			sendFrame(frame);
+		}
+		// Let the pacers drain the last frames before closing the window.
+		std::this_thread::sleep_until(nextFrame);
+
+		const int64_t windowUs = std::max<int64_t>(1, steadyNowUs() - windowStartUs);
+		const std::vector<AllocationCounts> allocationsAfter = snapshotAllocations();
+		const double cpuAfter = processCpuSeconds();
+		const uint64_t sendThreadCpuAfter = currentThreadCpuTimeUs().value_or(0);
+		result.threadCpu = sampler.query();
+		result.pacer = manager->takeVideoPacerStats();
+		result.allocations = allocationsBetween(allocationsBefore, allocationsAfter, sendThreadId);
+
+		result.windowSeconds = static_cast<double>(windowUs) / 1e6;
+		result.framesSent = totalFrames - warmupFrames;
+		result.processCpuPercent = (cpuAfter - cpuBefore) * 100.0 / result.windowSeconds;
+		double pluginPercent = static_cast<double>(sendThreadCpuAfter - sendThreadCpuBefore) * 100.0 /
+		                       static_cast<double>(windowUs);
+		for (const SubsystemCpuUsage &usage : result.threadCpu) {
+			pluginPercent += usage.percent;
+		}
+		result.pluginCpuPercent = pluginPercent;
+
+		// The join phase keeps the stream going past the measured window, so
+		// the live viewers' late packets still count toward the latency tail.
+		std::thread joiner;
+		if (lateJoins) {
+			joiner = std::thread(runLateJoins, std::ref(*manager), std::cref(options), std::cref(stream),
+			                     std::ref(clock), std::cref(joinFrames), std::cref(framesSent), std::ref(probes),
+			                     std::ref(relays), std::ref(result.joins));
+			for (size_t frame = totalFrames; frame < allFrames; ++frame) {
+				sendFrame(frame);
+			}
+			joiner.join();
+		}
+
+		// Late packets only affect the latency tail; give them a moment.
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		uint64_t minFrames = UINT64_MAX;
+		uint64_t totalReceived = 0;
+		uint64_t totalBytes = 0;
+		for (const auto &viewer : viewers) {
+			const uint64_t frames = viewer->measuredFrames.load();
+			minFrames = std::min(minFrames, frames);
+			totalReceived += frames;
+			totalBytes += viewer->receivedBytes.load();
+		}
+		result.framesReceivedMin = minFrames == UINT64_MAX ? 0 : minFrames;
+		result.framesReceivedAvg = static_cast<double>(totalReceived) / viewerCount;
+		// Includes warm-up and join-phase traffic, so normalize over the whole run.
+		const double runSeconds = static_cast<double>(allFrames) / options.fps;
+		result.receivedKbpsPerViewer = static_cast<double>(totalBytes) * 8.0 / 1000.0 / runSeconds / viewerCount;
+		result.latency = clock.latency.snapshot();
+
+		LatencyHistogram firstFrameUs;
+		LatencyHistogram firstMovingFrameUs;
+		LatencyHistogram caughtUpUs;
+		const auto recordSincePrimed = [](LatencyHistogram &histogram, int64_t primedAtUs, int64_t atUs) {
+			if (primedAtUs > 0 && atUs > 0) {
+				histogram.record(static_cast<uint64_t>(std::max<int64_t>(0, atUs - primedAtUs)));
+			}
+		};
+		for (const auto &probe : probes) {
+			const int64_t primedAtUs = probe->primedAtUs.load(std::memory_order_acquire);
+			recordSincePrimed(firstFrameUs, primedAtUs, probe->firstFrameAtUs.load());
+			recordSincePrimed(firstMovingFrameUs, primedAtUs, probe->firstMovingFrameAtUs.load());
+			recordSincePrimed(caughtUpUs, primedAtUs, probe->caughtUpAtUs.load());
+		}
+		result.joins.firstFrameUs = firstFrameUs.snapshot();
+		result.joins.firstMovingFrameUs = firstMovingFrameUs.snapshot();
+		result.joins.caughtUpUs = caughtUpUs.snapshot();
+	}
+
+	// Viewer callbacks point at this frame's clock, so detach them before
+	// it goes out of scope.
+	manager->stopPublishing();
+	for (const auto &viewer : viewers) {
+		viewer->pc->resetCallbacks();
+		std::lock_guard<std::mutex> lock(viewer->tracksMutex);
+		for (const auto &track : viewer->tracks) {
+			track->resetCallbacks();
+		}
+	}
+	for (const auto &probe : probes) {
+		probe->pc->resetCallbacks();
+		std::lock_guard<std::mutex> lock(probe->tracksMutex);
+		for (const auto &track : probe->tracks) {
+			track->resetCallbacks();
+		}
+	}
+	for (const auto &viewer : viewers) {
+		viewer->pc->close();
+	}
+	for (const auto &probe : probes) {
+		probe->pc->close();
+	}
+	manager.reset();
+	relays.clear();
+	viewers.clear();
+	probes.clear();
+	return result;
+}
+
+double msFromUs(uint64_t valueUs)
+{
+	return static_cast<double>(valueUs) / 1000.0;
+}
+
+void printJson(const Options &options, const Result &result)
+{
+	const double perViewer = result.viewers > 0 ? 1.0 / result.viewers : 0.0;
+	const double viewerFrames = static_cast<double>(result.framesSent) * result.viewers;
+	const double sendPathAllocations =
+	    static_cast<double>(result.allocations.send.count + result.allocations.pacer.count);
+
+	std::string threadCpu;
+	char entry[128];
+	for (const SubsystemCpuUsage &usage : result.threadCpu) {
+		std::snprintf(entry, sizeof(entry), "%s\"%s\":%.2f", threadCpu.empty() ? "" : ",", usage.subsystem.c_str(),
+		              usage.percent);
+		threadCpu += entry;
+	}
+
+	std::printf("{\"viewers\":%d,\"bitrateKbps\":%d,\"fps\":%d,\"seconds\":%d,\"connected\":%s,\"connectMs\":%lld,"
+	            "\"windowSeconds\":%.3f,\"framesSent\":%llu,\"framesReceivedMin\":%llu,\"framesReceivedAvg\":%.1f,"
+	            "\"receivedKbpsPerViewer\":%.1f,",
+	            result.viewers, result.bitrateKbps, options.fps, options.seconds, result.connected ? "true" : "false",
+	            static_cast<long long>(result.connectMs), result.windowSeconds,
+	            static_cast<unsigned long long>(result.framesSent),
+	            static_cast<unsigned long long>(result.framesReceivedMin), result.framesReceivedAvg,
+	            result.receivedKbpsPerViewer);
+	std::printf("\"cpu\":{\"processPercent\":%.2f,\"processPercentPerViewer\":%.2f,\"pluginPercent\":%.2f,"
+	            "\"pluginPercentPerViewer\":%.2f,\"threads\":{%s}},",
+	            result.processCpuPercent, result.processCpuPercent * perViewer, result.pluginCpuPercent,
+	            result.pluginCpuPercent * perViewer, threadCpu.c_str());
+	std::printf("\"allocations\":{\"send\":%llu,\"sendBytes\":%llu,\"pacer\":%llu,\"pacerBytes\":%llu,"
+	            "\"other\":%llu,\"otherBytes\":%llu,\"sendPathPerViewerFrame\":%.2f},",
+	            static_cast<unsigned long long>(result.allocations.send.count),
+	            static_cast<unsigned long long>(result.allocations.send.bytes),
+	            static_cast<unsigned long long>(result.allocations.pacer.count),
+	            static_cast<unsigned long long>(result.allocations.pacer.bytes),
+	            static_cast<unsigned long long>(result.allocations.other.count),
+	            static_cast<unsigned long long>(result.allocations.other.bytes),
+	            viewerFrames > 0 ? sendPathAllocations / viewerFrames : 0.0);
+	std::printf("\"pacerQueueDelayMs\":{\"p50\":%.2f,\"p95\":%.2f,\"p99\":%.2f,\"max\":%.2f,\"maxPacket\":%llu},"
+	            "\"pacerDroppedFrames\":%llu,",
+	            msFromUs(result.pacer.frameHoldUs.percentileUs(0.50)),
+	            msFromUs(result.pacer.frameHoldUs.percentileUs(0.95)),
+	            msFromUs(result.pacer.frameHoldUs.percentileUs(0.99)), msFromUs(result.pacer.frameHoldUs.maxUs),
+	            static_cast<unsigned long long>(result.pacer.maxPacketDelayMs),
+	            static_cast<unsigned long long>(result.pacer.droppedFrames));
+	const LatencyHistogramSnapshot &budgetWait = result.pacer.sharedBudget.waitUs;
+	std::printf("\"sharedBudgetWaitMs\":{\"p50\":%.2f,\"p95\":%.2f,\"p99\":%.2f,\"max\":%.2f},",
+	            msFromUs(budgetWait.percentileUs(0.50)), msFromUs(budgetWait.percentileUs(0.95)),
+	            msFromUs(budgetWait.percentileUs(0.99)), msFromUs(budgetWait.maxUs));
+	std::printf("\"latencyMs\":{\"count\":%llu,\"mean\":%.2f,\"p50\":%.2f,\"p95\":%.2f,\"p99\":%.2f,\"max\":%.2f},",
+	            static_cast<unsigned long long>(result.latency.count), msFromUs(result.latency.meanUs()),
+	            msFromUs(result.latency.percentileUs(0.50)), msFromUs(result.latency.percentileUs(0.95)),
+	            msFromUs(result.latency.percentileUs(0.99)), msFromUs(result.latency.maxUs));
+	const JoinResult &joins = result.joins;
+	std::printf("\"lateJoins\":{\"count\":%d,\"connected\":%d,\"gopCache\":%s,\"primedWithGop\":%d,"
+	            "\"firstFrameMs\":{\"p50\":%.2f,\"max\":%.2f},\"firstMovingFrameMs\":{\"count\":%llu,"
+	            "\"p50\":%.2f,\"max\":%.2f},\"caughtUpMs\":{\"count\":%llu,\"p50\":%.2f,\"max\":%.2f}}}\n",
+	            joins.attempted, joins.connected, options.gopCache ? "true" : "false", joins.primedWithGop,
+	            msFromUs(joins.firstFrameUs.percentileUs(0.50)), msFromUs(joins.firstFrameUs.maxUs),
+	            static_cast<unsigned long long>(joins.firstMovingFrameUs.count),
+	            msFromUs(joins.firstMovingFrameUs.percentileUs(0.50)), msFromUs(joins.firstMovingFrameUs.maxUs),
+	            static_cast<unsigned long long>(joins.caughtUpUs.count), msFromUs(joins.caughtUpUs.percentileUs(0.50)),
+	            msFromUs(joins.caughtUpUs.maxUs));
+	std::fflush(stdout);
+}
+
+void printSummary(const Result &result)
+{
+	if (!result.connected) {
+		std::fprintf(stderr, "%2d viewers @ %5d kbps: viewers did not connect within %lld ms\n", result.viewers,
+		             result.bitrateKbps, static_cast<long long>(result.connectMs));
+		return;
+	}
+	std::fprintf(stderr,
+	             "%2d viewers @ %5d kbps: cpu %6.1f%% (plugin %5.1f%%, %5.2f%%/viewer)  "
+	             "pacer p95 %6.2f ms  latency p50 %6.2f / p99 %6.2f ms  frames %llu/%llu\n",
+	             result.viewers, result.bitrateKbps, result.processCpuPercent, result.pluginCpuPercent,
+	             result.pluginCpuPercent / result.viewers, msFromUs(result.pacer.frameHoldUs.percentileUs(0.95)),
+	             msFromUs(result.latency.percentileUs(0.50)), msFromUs(result.latency.percentileUs(0.99)),
+	             static_cast<unsigned long long>(result.framesReceivedMin),
+	             static_cast<unsigned long long>(result.framesSent));
+	if (!result.threadCpu.empty()) {
+		std::fprintf(stderr, "    threads: %s\n", formatSubsystemCpuUsage(result.threadCpu).c_str());
+	}
+	const JoinResult &joins = result.joins;
+	if (joins.attempted > 0) {
+		std::fprintf(stderr,
+		             "    late joins: %d/%d connected, %d primed with the GOP  first frame p50 %6.2f ms  "
+		             "moving p50 %6.2f / max %6.2f ms  caught up p50 %6.2f ms\n",
+		             joins.connected, joins.attempted, joins.primedWithGop,
+		             msFromUs(joins.firstFrameUs.percentileUs(0.50)),
+		             msFromUs(joins.firstMovingFrameUs.percentileUs(0.50)), msFromUs(joins.firstMovingFrameUs.maxUs),
+		             msFromUs(joins.caughtUpUs.percentileUs(0.50)));
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--viewers") && hasValue) {
+			options.viewers = parseList(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--bitrates") && hasValue) {
+			options.bitratesKbps = parseList(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--fps") && hasValue) {
+			options.fps = std::atoi(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+			options.seconds = std::atoi(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--warmup") && hasValue) {
+			options.warmupSeconds = std::atoi(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--late-joins") && hasValue) {
+			options.lateJoins = std::atoi(argv[++i]);
+		} else if (!std::strcmp(argv[i], "--no-gop-cache")) {
+			options.gopCache = false;
+		} else if (!std::strcmp(argv[i], "--verbose")) {
+			options.verbose = true;
+		} else {
+			std::fprintf(stderr,
+			             "Usage: %s [--viewers 1,2,4,8] [--bitrates 2500,6000] [--fps 30] [--seconds 10] "
+			             "[--warmup 2] [--late-joins 4] [--no-gop-cache] [--verbose]\n",
+			             argv[0]);
+			return 2;
+		}
+	}
+	if (options.viewers.empty() || options.bitratesKbps.empty() || options.fps <= 0 || options.seconds <= 0 ||
+	    options.warmupSeconds < 0 || options.lateJoins < 0) {
+		std::fprintf(stderr, "fanout-bench: viewer counts, bitrates, fps and seconds must be positive\n");
+		return 2;
+	}
+	testing_utils::enableLogging(options.verbose);
+
+	std::fprintf(stderr, "Publisher fan-out: %d fps, %d s measured after %d s warm-up, %d s GOP\n", options.fps,
+	             options.seconds, options.warmupSeconds, kGopSeconds);
+	bool allConnected = true;
+	for (const int bitrateKbps : options.bitratesKbps) {
+		for (const int viewers : options.viewers) {
+			const Result result = runConfiguration(options, viewers, bitrateKbps);
+			printJson(options, result);
+			printSummary(result);
+			allConnected = allConnected && result.connected;
+		}
+	}
+	return allConnected ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/*
+ * H.264 NAL Index Benchmark
+ *
+ * Measures how fast an Annex B access unit is split into NAL units by the
+ * byte-by-byte start-code scan the packetizer used to run for every viewer,
+ * against the memchr-based H264NalIndex that is now built once per frame.
+ * Access units are synthetic: random slice data with emulation prevention
+ * applied, sized like a 20 Mbps 2160p30 stream with a larger IDR every
+ * second. The fan-out rows compare rescanning once per viewer with one
+ * shared index.
+ *
+ * Usage:
+ *   nal-index-bench [--frames 600] [--viewers 1,4,16]
+ *
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-h264-nal-index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace vdoninja;
+
+namespace
+{
+
+constexpr size_t kDeltaFrameBytes = 83000;
+constexpr size_t kIdrFrameBytes = 330000;
+constexpr size_t kSlicesPerFrame = 4;
+constexpr int kFramesPerGop = 30;
+
+struct NalUnitView {
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+};
+
+// The parser the packetizer used before the index: tests every byte position
+// for a start code.
+bool legacyStartCodeAt(const uint8_t *data, size_t size, size_t pos, size_t &length)
+{
+	length = 0;
+	if (pos + 3 <= size && data[pos] == 0x00 && data[pos + 1] == 0x00 && data[pos + 2] == 0x01) {
+		length = 3;
+		return true;
+	}
+	if (pos + 4 <= size && data[pos] == 0x00 && data[pos + 1] == 0x00 && data[pos + 2] == 0x00 &&
+	    data[pos + 3] == 0x01) {
+		length = 4;
+		return true;
+	}
+	return false;
+}
+
+size_t legacyFindStartCode(const uint8_t *data, size_t size, size_t from, size_t &length)
+{
+	for (size_t pos = from; pos < size; ++pos) {
+		if (legacyStartCodeAt(data, size, pos, length)) {
+			return pos;
+		}
+	}
+	length = 0;
+	return size;
+}
+
+bool legacyParseAnnexB(const uint8_t *data, size_t size, std::vector<NalUnitView> &nalUnits)
+{
+	nalUnits.clear();
+	size_t startCodeLength = 0;
+	size_t start = legacyFindStartCode(data, size, 0, startCodeLength);
+	while (start < size) {
+		const size_t nalStart = start + startCodeLength;
+		size_t nextStartCodeLength = 0;
+		const size_t nextStart = legacyFindStartCode(data, size, nalStart, nextStartCodeLength);
+		size_t nalEnd = nextStart;
+		while (nalEnd > nalStart && data[nalEnd - 1] == 0x00) {
+			--nalEnd;
+		}
+		if (nalEnd > nalStart) {
+			nalUnits.push_back({data + nalStart, nalEnd - nalStart});
+		}
+		start = nextStart;
+		startCodeLength = nextStartCodeLength;
+	}
+	return !nalUnits.empty();
+}
+
+void appendNal(std::vector<uint8_t> &accessUnit, uint8_t header, size_t payloadBytes, std::mt19937 &rng)
+{
+	static const uint8_t kStartCode[] = {0x00, 0x00, 0x00, 0x01};
+	accessUnit.insert(accessUnit.end(), std::begin(kStartCode), std::end(kStartCode));
+	accessUnit.push_back(header);
+	size_t zeros = 0;
+	for (size_t i = 0; i < payloadBytes; ++i) {
+		// Entropy-coded slices are zero-heavy; bias toward zeros so the
+		// emulation prevention path is exercised as in real streams.
+		uint8_t byte = (rng() % 8U) == 0 ? 0x00 : static_cast<uint8_t>(rng());
+		if (zeros >= 2 && byte <= 0x03) {
+			accessUnit.push_back(0x03);
+			zeros = 0;
+		}
+		accessUnit.push_back(byte);
+		zeros = byte == 0x00 ? zeros + 1 : 0;
+	}
+	if (accessUnit.back() == 0x00) {
+		accessUnit.push_back(0x80);
+	}
+}
+
+std::vector<uint8_t> makeAccessUnit(bool idr, std::mt19937 &rng)
+{
+	std::vector<uint8_t> accessUnit;
+	const size_t bytes = idr ? kIdrFrameBytes : kDeltaFrameBytes;
+	accessUnit.reserve(bytes + bytes / 64U);
+	appendNal(accessUnit, 0x09, 1, rng);
+	if (idr) {
+		appendNal(accessUnit, 0x67, 12, rng);
+		appendNal(accessUnit, 0x68, 4, rng);
+	}
+	appendNal(accessUnit, 0x06, 24, rng);
+	for (size_t slice = 0; slice < kSlicesPerFrame; ++slice) {
+		appendNal(accessUnit, idr ? 0x65 : 0x41, bytes / kSlicesPerFrame, rng);
+	}
+	return accessUnit;
+}
+
+std::vector<int> parseViewerCounts(const char *text)
+{
+	std::vector<int> counts;
+	const std::string list(text);
+	size_t start = 0;
+	while (start < list.size()) {
+		const size_t comma = list.find(',', start);
+		const int count = std::atoi(list.substr(start, comma - start).c_str());
+		if (count > 0) {
+			counts.push_back(count);
+		}
+		if (comma == std::string::npos) {
+			break;
+		}
+		start = comma + 1;
+	}
+	return counts;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	int frames = 600;
+	std::vector<int> viewerCounts = {1, 4, 16};
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--viewers") == 0 && i + 1 < argc) {
+			viewerCounts = parseViewerCounts(argv[++i]);
+		}
+	}
+
+	std::mt19937 rng(2160);
+	std::vector<std::vector<uint8_t>> accessUnits;
+	accessUnits.reserve(kFramesPerGop);
+	size_t totalBytes = 0;
+	for (int frame = 0; frame < kFramesPerGop; ++frame) {
+		accessUnits.push_back(makeAccessUnit(frame == 0, rng));
+		totalBytes += accessUnits.back().size();
+	}
+
+	// Both parsers must agree before either is timed.
+	std::vector<NalUnitView> legacyUnits;
+	H264NalIndex index;
+	size_t unitsPerGop = 0;
+	for (const auto &accessUnit : accessUnits) {
+		legacyParseAnnexB(accessUnit.data(), accessUnit.size(), legacyUnits);
+		index.build(accessUnit.data(), accessUnit.size());
+		bool same = legacyUnits.size() == index.units().size();
+		for (size_t i = 0; same && i < legacyUnits.size(); ++i) {
+			same = legacyUnits[i].data == accessUnit.data() + index.units()[i].offset &&
+			       legacyUnits[i].size == index.units()[i].size;
+		}
+		if (!same) {
+			std::fprintf(stderr, "legacy parser and NAL index disagree\n");
+			return 1;
+		}
+		unitsPerGop += index.units().size();
+	}
+
+	const double megabytes = static_cast<double>(totalBytes) * frames / kFramesPerGop / 1e6;
+	std::printf("nal-index-bench: %d frames, %.1f KB average access unit, %zu NAL units per GOP\n", frames,
+	            static_cast<double>(totalBytes) / kFramesPerGop / 1000.0, unitsPerGop);
+
+	size_t checksum = 0;
+	auto started = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame) {
+		const auto &accessUnit = accessUnits[static_cast<size_t>(frame % kFramesPerGop)];
+		legacyParseAnnexB(accessUnit.data(), accessUnit.size(), legacyUnits);
+		checksum += legacyUnits.size();
+	}
+	const double legacyMs = elapsedMs(started);
+
+	started = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame) {
+		const auto &accessUnit = accessUnits[static_cast<size_t>(frame % kFramesPerGop)];
+		index.build(accessUnit.data(), accessUnit.size());
+		checksum += index.units().size();
+	}
+	const double indexMs = elapsedMs(started);
+
+	std::printf("\n[parse]\n");
+	std::printf("byte scan   %8.1f MB/s  %7.2f us/frame\n", megabytes / (legacyMs / 1000.0),
+	            legacyMs * 1000.0 / frames);
+	std::printf("nal index   %8.1f MB/s  %7.2f us/frame  %.1fx\n", megabytes / (indexMs / 1000.0),
+	            indexMs * 1000.0 / frames, legacyMs / indexMs);
+
+	// Before the index every viewer's packetizer split the frame again.
+	std::printf("\n[fan-out]\n");
+	for (const int viewers : viewerCounts) {
+		started = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame) {
+			const auto &accessUnit = accessUnits[static_cast<size_t>(frame % kFramesPerGop)];
+			for (int viewer = 0; viewer < viewers; ++viewer) {
+				legacyParseAnnexB(accessUnit.data(), accessUnit.size(), legacyUnits);
+				checksum += legacyUnits.size();
+			}
+		}
+		const double rescanMs = elapsedMs(started);
+
+		started = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame) {
+			const auto &accessUnit = accessUnits[static_cast<size_t>(frame % kFramesPerGop)];
+			index.build(accessUnit.data(), accessUnit.size());
+			for (int viewer = 0; viewer < viewers; ++viewer) {
+				checksum += index.units().size();
+			}
+		}
+		const double sharedMs = elapsedMs(started);
+
+		std::printf("%3d viewers  rescan %8.2f us/frame  shared index %7.2f us/frame  %.1fx\n", viewers,
+		            rescanMs * 1000.0 / frames, sharedMs * 1000.0 / frames, rescanMs / sharedMs);
+	}
+
+	// Keeps the loops from being optimized away.
+	std::printf("\nchecksum %zu\n", checksum);
+	return 0;
+}
@@ -0,0 +1,447 @@
+/*
+ * SDP Join Pipeline Benchmark
+ *
+ * Measures the signaling-thread cost of taking a viewer offer at join time:
+ * the transport-cc strip, escaped line-ending repair, media section parse
+ * and final SDP string. The old chain of whole-document string passes is
+ * compared with one SdpDocument parse, edit and serialize. Offers are a
+ * Chrome-like description repeated to 1, 4 and 16 video sections so the
+ * per-KB rows show whether either grows faster than the SDP. The last column
+ * is one core's share at 50 joins per second.
+ *
+ * Usage:
+ *   sdp-bench [--joins 2000]
+ *
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-sdp.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace vdoninja;
+
+namespace
+{
+
+constexpr double kJoinsPerSecond = 50.0;
+
+// The pipeline before SdpDocument, copied from the tree it replaced.
+namespace legacy
+{
+
+std::string asciiLowerCopy(std::string value)
+{
+	for (char &c : value) {
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+	return value;
+}
+
+std::vector<std::string> splitWhitespace(const std::string &value)
+{
+	std::vector<std::string> tokens;
+	std::istringstream input(value);
+	std::string token;
+	while (input >> token) {
+		tokens.push_back(token);
+	}
+	return tokens;
+}
+
+int parseIntOrDefault(const std::string &value, int defaultValue = -1)
+{
+	try {
+		return std::stoi(value);
+	} catch (...) {
+		return defaultValue;
+	}
+}
+
+bool containsPayloadType(const std::vector<int> &payloadTypes, int payloadType)
+{
+	return std::find(payloadTypes.begin(), payloadTypes.end(), payloadType) != payloadTypes.end();
+}
+
+SdpOfferedCodec *findCodecByPayloadType(std::vector<SdpOfferedCodec> &codecs, int payloadType)
+{
+	for (auto &codec : codecs) {
+		if (codec.payloadType == payloadType) {
+			return &codec;
+		}
+	}
+	return nullptr;
+}
+
+std::string trim(const std::string &str)
+{
+	size_t start = str.find_first_not_of(" \t\r\n");
+	if (start == std::string::npos)
+		return "";
+	size_t end = str.find_last_not_of(" \t\r\n");
+	return str.substr(start, end - start + 1);
+}
+
+std::vector<std::string> split(const std::string &str, char delimiter)
+{
+	std::vector<std::string> result;
+	if (str.empty()) {
+		result.push_back("");
+		return result;
+	}
+	std::stringstream ss(str);
+	std::string item;
+	while (std::getline(ss, item, delimiter)) {
+		result.push_back(item);
+	}
+	return result;
+}
+
+std::string legacyStripTransportCc(const std::string &sdp)
+{
+	std::stringstream input(sdp);
+	std::string line;
+	std::string filtered;
+	bool stripped = false;
+
+	while (std::getline(input, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.find("transport-wide-cc-extensions-01") != std::string::npos) {
+			stripped = true;
+			continue;
+		}
+		if (line.rfind("a=rtcp-fb:", 0) == 0 && line.find("transport-cc") != std::string::npos) {
+			stripped = true;
+			continue;
+		}
+		filtered += line + "\r\n";
+	}
+
+	return stripped ? filtered : sdp;
+}
+
+std::string legacyNormalizeEscapedLineEndings(const std::string &sdp)
+{
+	const bool hasActualLineBreaks = sdp.find('\n') != std::string::npos || sdp.find('\r') != std::string::npos;
+	const bool hasEscapedLineBreaks = sdp.find("\\r\\n") != std::string::npos || sdp.find("\\n") != std::string::npos ||
+	                                  sdp.find("\\r") != std::string::npos;
+	if (hasActualLineBreaks || !hasEscapedLineBreaks) {
+		return sdp;
+	}
+
+	std::string normalized;
+	normalized.reserve(sdp.size());
+	for (size_t i = 0; i < sdp.size(); ++i) {
+		if (sdp[i] != '\\' || i + 1 >= sdp.size()) {
+			normalized.push_back(sdp[i]);
+			continue;
+		}
+
+		const char next = sdp[i + 1];
+		switch (next) {
+		case 'r':
+			normalized.push_back('\r');
+			++i;
+			break;
+		case 'n':
+			normalized.push_back('\n');
+			++i;
+			break;
+		case '\\':
+			normalized.push_back('\\');
+			++i;
+			break;
+		default:
+			normalized.push_back(sdp[i]);
+			break;
+		}
+	}
+
+	return normalized;
+}
+
+std::vector<SdpOfferedMediaSection> legacyParseOfferedMediaSections(const std::string &sdp)
+{
+	std::vector<SdpOfferedMediaSection> sections;
+	SdpOfferedMediaSection *current = nullptr;
+
+	std::stringstream input(sdp);
+	std::string line;
+	while (std::getline(input, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		if (line.rfind("m=", 0) == 0) {
+			const auto tokens = splitWhitespace(line.substr(2));
+			if (tokens.empty()) {
+				current = nullptr;
+				continue;
+			}
+
+			const std::string mediaType = asciiLowerCopy(tokens[0]);
+			if (mediaType != "audio" && mediaType != "video") {
+				current = nullptr;
+				continue;
+			}
+
+			sections.push_back({});
+			current = &sections.back();
+			current->type = mediaType;
+			if (tokens.size() > 1) {
+				current->port = parseIntOrDefault(tokens[1], -1);
+			}
+			for (size_t i = 3; i < tokens.size(); ++i) {
+				const int payloadType = parseIntOrDefault(tokens[i]);
+				if (payloadType >= 0) {
+					current->payloadTypes.push_back(payloadType);
+				}
+			}
+			continue;
+		}
+
+		if (!current) {
+			continue;
+		}
+
+		if (line.rfind("a=mid:", 0) == 0) {
+			current->mid = trim(line.substr(6));
+			continue;
+		}
+
+		if (line == "a=sendrecv" || line == "a=sendonly" || line == "a=recvonly" || line == "a=inactive") {
+			current->direction = line.substr(2);
+			continue;
+		}
+
+		if (line.rfind("a=rtpmap:", 0) == 0) {
+			const size_t separator = line.find(' ');
+			if (separator == std::string::npos) {
+				continue;
+			}
+
+			const int payloadType = parseIntOrDefault(line.substr(9, separator - 9));
+			if (payloadType < 0 || !containsPayloadType(current->payloadTypes, payloadType)) {
+				continue;
+			}
+
+			SdpOfferedCodec *codec = findCodecByPayloadType(current->codecs, payloadType);
+			if (!codec) {
+				current->codecs.push_back({});
+				codec = &current->codecs.back();
+				codec->payloadType = payloadType;
+			}
+
+			const auto descriptorParts = split(line.substr(separator + 1), '/');
+			if (!descriptorParts.empty()) {
+				codec->codec = descriptorParts[0];
+			}
+			if (descriptorParts.size() > 1) {
+				codec->clockRate = parseIntOrDefault(descriptorParts[1], 0);
+			}
+			if (descriptorParts.size() > 2) {
+				codec->channels = parseIntOrDefault(descriptorParts[2], 0);
+			}
+			continue;
+		}
+
+		if (line.rfind("a=fmtp:", 0) == 0) {
+			const size_t separator = line.find(' ');
+			if (separator == std::string::npos) {
+				continue;
+			}
+
+			const int payloadType = parseIntOrDefault(line.substr(7, separator - 7));
+			if (payloadType < 0 || !containsPayloadType(current->payloadTypes, payloadType)) {
+				continue;
+			}
+
+			SdpOfferedCodec *codec = findCodecByPayloadType(current->codecs, payloadType);
+			if (!codec) {
+				current->codecs.push_back({});
+				codec = &current->codecs.back();
+				codec->payloadType = payloadType;
+			}
+
+			codec->formatParameters = trim(line.substr(separator + 1));
+			const std::string fmtpLower = asciiLowerCopy(codec->formatParameters);
+			const size_t aptPos = fmtpLower.find("apt=");
+			if (aptPos != std::string::npos) {
+				size_t valueStart = aptPos + 4;
+				size_t valueEnd = valueStart;
+				while (valueEnd < codec->formatParameters.size() &&
+				       std::isdigit(static_cast<unsigned char>(codec->formatParameters[valueEnd]))) {
+					++valueEnd;
+				}
+				codec->associatedPayloadType =
+				    parseIntOrDefault(codec->formatParameters.substr(valueStart, valueEnd - valueStart));
+			}
+		}
+	}
+
+	return sections;
+}
+
+std::vector<SdpOfferedMediaSection> join(const std::string &sdp, std::string &applied)
+{
+	std::string filtered = legacyStripTransportCc(sdp);
+	const bool stripped = filtered != sdp;
+	applied = legacyNormalizeEscapedLineEndings(filtered);
+	const bool hasActualLineBreaks =
+	    applied.find('\n') != std::string::npos || applied.find('\r') != std::string::npos;
+	const bool hasEscapedLineBreaks = applied.find("\\r\\n") != std::string::npos ||
+	                                  applied.find("\\n") != std::string::npos ||
+	                                  applied.find("\\r") != std::string::npos;
+	(void)stripped;
+	(void)hasActualLineBreaks;
+	(void)hasEscapedLineBreaks;
+	return legacyParseOfferedMediaSections(applied);
+}
+
+} // namespace legacy
+
+std::vector<SdpOfferedMediaSection> modelJoin(const std::string &sdp, std::string &applied)
+{
+	SdpDocument offer(sdp);
+	stripUnsupportedTransportCcFeedback(offer);
+	applied = offer.serialize();
+	return offer.offeredMediaSections();
+}
+
+std::string videoSection(int index)
+{
+	std::string section = "m=video 9 UDP/TLS/RTP/SAVPF 96 97 98 99 100 101 102 103 104 105 106 107 108 109 127 "
+	                      "125 39 40 45 46 98 99 112 113 114 115 116\r\n"
+	                      "c=IN IP4 0.0.0.0\r\n"
+	                      "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+	                      "a=ice-ufrag:abcd\r\n"
+	                      "a=ice-pwd:abcdefghijklmnopqrstuvwx\r\n"
+	                      "a=ice-options:trickle\r\n"
+	                      "a=fingerprint:sha-256 "
+	                      "00:11:22:33:44:55:66:77:88:99:AA:BB:CC:DD:EE:FF:00:11:22:33:44:55:66:77:88:99:AA:BB:CC:"
+	                      "DD:EE:FF\r\n"
+	                      "a=setup:actpass\r\n";
+	section += "a=mid:" + std::to_string(index) + "\r\n";
+	section += "a=extmap:1 urn:ietf:params:rtp-hdrext:toffset\r\n"
+	           "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+	           "a=extmap:3 urn:3gpp:video-orientation\r\n"
+	           "a=extmap:4 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+	           "a=extmap:5 http://www.webrtc.org/experiments/rtp-hdrext/playout-delay\r\n"
+	           "a=recvonly\r\n"
+	           "a=rtcp-mux\r\n"
+	           "a=rtcp-rsize\r\n";
+	const char *codecs[] = {"VP8", "VP9", "H264", "AV1", "H264", "VP9", "H264", "H264"};
+	for (int i = 0; i < 8; ++i) {
+		const int pt = 96 + i * 2;
+		const std::string p = std::to_string(pt);
+		const std::string rtx = std::to_string(pt + 1);
+		section += "a=rtpmap:" + p + " " + codecs[i] + "/90000\r\n";
+		section += "a=rtcp-fb:" + p + " goog-remb\r\n";
+		section += "a=rtcp-fb:" + p + " transport-cc\r\n";
+		section += "a=rtcp-fb:" + p + " ccm fir\r\n";
+		section += "a=rtcp-fb:" + p + " nack\r\n";
+		section += "a=rtcp-fb:" + p + " nack pli\r\n";
+		if (std::strcmp(codecs[i], "H264") == 0) {
+			section += "a=fmtp:" + p + " level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n";
+		}
+		section += "a=rtpmap:" + rtx + " rtx/90000\r\n";
+		section += "a=fmtp:" + rtx + " apt=" + p + "\r\n";
+	}
+	return section;
+}
+
+std::string makeOffer(int videoSections)
+{
+	std::string offer = "v=0\r\n"
+	                    "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n"
+	                    "s=-\r\n"
+	                    "t=0 0\r\n"
+	                    "a=group:BUNDLE 0 1\r\n"
+	                    "a=msid-semantic: WMS\r\n"
+	                    "m=audio 9 UDP/TLS/RTP/SAVPF 111 63 9 0 8 13 110 126\r\n"
+	                    "c=IN IP4 0.0.0.0\r\n"
+	                    "a=mid:a0\r\n"
+	                    "a=extmap:4 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+	                    "a=recvonly\r\n"
+	                    "a=rtcp-mux\r\n"
+	                    "a=rtpmap:111 opus/48000/2\r\n"
+	                    "a=rtcp-fb:111 transport-cc\r\n"
+	                    "a=fmtp:111 minptime=10;useinbandfec=1\r\n"
+	                    "a=rtpmap:63 red/48000/2\r\n"
+	                    "a=fmtp:63 111/111\r\n"
+	                    "a=rtpmap:9 G722/8000\r\n"
+	                    "a=rtpmap:0 PCMU/8000\r\n"
+	                    "a=rtpmap:8 PCMA/8000\r\n"
+	                    "a=rtpmap:13 CN/8000\r\n"
+	                    "a=rtpmap:110 telephone-event/48000\r\n"
+	                    "a=rtpmap:126 telephone-event/8000\r\n";
+	for (int i = 0; i < videoSections; ++i) {
+		offer += videoSection(i + 1);
+	}
+	offer += "m=application 9 UDP/DTLS/SCTP webrtc-datachannel\r\n"
+	         "c=IN IP4 0.0.0.0\r\n"
+	         "a=mid:d0\r\n"
+	         "a=sctp-port:5000\r\n"
+	         "a=max-message-size:262144\r\n";
+	return offer;
+}
+
+template <typename Join> double microsecondsPerJoin(const std::string &offer, int joins, Join join, size_t &checksum)
+{
+	std::string applied;
+	const auto started = std::chrono::steady_clock::now();
+	for (int i = 0; i < joins; ++i) {
+		checksum += join(offer, applied).size() + applied.size();
+	}
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count() / joins;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	int joins = 2000;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--joins") == 0 && i + 1 < argc) {
+			joins = std::max(1, std::atoi(argv[++i]));
+		}
+	}
+
+	std::printf("sdp-bench: %d joins per case, cpu share at %.0f joins/s\n", joins, kJoinsPerSecond);
+	size_t checksum = 0;
+	for (const int videoSections : {1, 4, 16}) {
+		const std::string offer = makeOffer(videoSections);
+		std::string legacyApplied;
+		std::string modelApplied;
+		const auto legacySections = legacy::join(offer, legacyApplied);
+		const auto modelSections = modelJoin(offer, modelApplied);
+		if (legacyApplied != modelApplied || legacySections.size() != modelSections.size()) {
+			std::fprintf(stderr, "legacy and SdpDocument pipelines disagree on the %d-section offer\n",
+			             videoSections);
+			return 1;
+		}
+
+		const double kb = static_cast<double>(offer.size()) / 1024.0;
+		const double legacyUs = microsecondsPerJoin(offer, joins, legacy::join, checksum);
+		const double modelUs = microsecondsPerJoin(offer, joins, modelJoin, checksum);
+		std::printf("\n[%d video sections, %.1f KB]\n", videoSections, kb);
+		std::printf("string passes  %8.2f us/join  %6.2f us/KB  %6.3f%% cpu\n", legacyUs, legacyUs / kb,
+		            legacyUs * kJoinsPerSecond / 1e4);
+		std::printf("sdp document   %8.2f us/join  %6.2f us/KB  %6.3f%% cpu  %.1fx\n", modelUs, modelUs / kb,
+		            modelUs * kJoinsPerSecond / 1e4, legacyUs / modelUs);
+	}
+
+	// Keeps the loops from being optimized away.
+	std::printf("\nchecksum %zu\n", checksum);
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Native Receive Color Conversion Benchmark
+ *
+ * Measures CPU and wall time per frame for the VideoScaler used by the
+ * native receiver, across source sizes, scaler qualities and threading.
+ * Each case converts a synthetic yuv420p frame to BGRA, either at the same
+ * size (the common path) or resized to 1920x1080, first with one thread and
+ * then with the automatic slice-thread count.
+ *
+ * Usage:
+ *   video-scale-bench [--frames 120]
+ *
+ * SPDX-License-Identifier: AGPL-3.0-only
+ */
+
+#include "vdoninja-video-scaler.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+using namespace vdoninja;
+
+namespace
+{
+
+struct FrameSize {
+	const char *name;
+	int width;
+	int height;
+};
+
+AVFrame *makeSourceFrame(int width, int height)
+{
+	AVFrame *frame = av_frame_alloc();
+	if (!frame) {
+		return nullptr;
+	}
+	frame->format = AV_PIX_FMT_YUV420P;
+	frame->width = width;
+	frame->height = height;
+	if (av_frame_get_buffer(frame, 32) < 0) {
+		av_frame_free(&frame);
+		return nullptr;
+	}
+	// Gradient content so the filters do real work instead of a flat fill.
+	for (int y = 0; y < height; ++y) {
+		uint8_t *row = frame->data[0] + static_cast<size_t>(y) * frame->linesize[0];
+		for (int x = 0; x < width; ++x) {
+			row[x] = static_cast<uint8_t>((x + y) & 0xFF);
+		}
+	}
+	for (int plane = 1; plane < 3; ++plane) {
+		for (int y = 0; y < height / 2; ++y) {
+			std::memset(frame->data[plane] + static_cast<size_t>(y) * frame->linesize[plane],
+			            plane == 1 ? 96 : 160, static_cast<size_t>(width / 2));
+		}
+	}
+	return frame;
+}
+
+void runCase(const AVFrame *src, int dstWidth, int dstHeight, VideoScaleQuality quality, int maxThreads, int frames)
+{
+	const int stride = dstWidth * 4;
+	std::vector<uint8_t> dst(static_cast<size_t>(stride) * static_cast<size_t>(dstHeight));
+
+	VideoScaler scaler;
+	scaler.setMaxThreads(maxThreads);
+	// Warm up outside the timed region so context creation is not counted.
+	if (!scaler.convert(src, dst.data(), stride, dstWidth, dstHeight, AV_PIX_FMT_BGRA, quality)) {
+		std::printf("%4dx%-4d -> %4dx%-4d %-8s conversion failed\n", src->width, src->height, dstWidth, dstHeight,
+		            videoScaleQualityName(quality));
+		return;
+	}
+	const int threads = scaler.threadCount();
+
+	const std::clock_t cpuStart = std::clock();
+	const auto wallStart = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; ++i) {
+		scaler.convert(src, dst.data(), stride, dstWidth, dstHeight, AV_PIX_FMT_BGRA, quality);
+	}
+	const double cpuMs = 1000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	const double wallMs =
+	    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+	std::printf("%4dx%-4d -> %4dx%-4d %-8s threads=%d  cpu %7.3f ms/frame  wall %7.3f ms/frame  rebuilds=%llu\n",
+	            src->width, src->height, dstWidth, dstHeight, videoScaleQualityName(quality), threads,
+	            cpuMs / frames, wallMs / frames, static_cast<unsigned long long>(scaler.rebuildCount()));
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	int frames = 120;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = std::max(1, std::atoi(argv[++i]));
+		}
+	}
+
+	const FrameSize sizes[] = {
+	    {"720p", 1280, 720},
+	    {"1080p", 1920, 1080},
+	    {"1440p", 2560, 1440},
+	    {"2160p", 3840, 2160},
+	};
+	const VideoScaleQuality qualities[] = {VideoScaleQuality::Fast, VideoScaleQuality::Bilinear,
+	                                       VideoScaleQuality::Bicubic, VideoScaleQuality::Lanczos};
+
+	std::printf("video-scale-bench: %d frames per case, yuv420p -> bgra\n", frames);
+	for (const FrameSize &size : sizes) {
+		AVFrame *src = makeSourceFrame(size.width, size.height);
+		if (!src) {
+			std::fprintf(stderr, "failed to allocate %s source frame\n", size.name);
+			return 1;
+		}
+		std::printf("\n[%s]\n", size.name);
+		for (const VideoScaleQuality quality : qualities) {
+			// Single-threaded baseline first, then the automatic thread choice.
+			for (const int maxThreads : {1, 0}) {
+				runCase(src, size.width, size.height, quality, maxThreads, frames);
+				if (size.width != 1920 || size.height != 1080) {
+					runCase(src, 1920, 1080, quality, maxThreads, frames);
+				}
+			}
+		}
+		av_frame_free(&src);
+	}
+	return 0;
+}